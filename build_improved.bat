@@ -1,3 +1,16 @@
 @echo off
+rem For the OpenXR pose source (pose_source.type "openxr") add /DLOOKOUT_WITH_OPENXR,
+rem /I"<OpenXR-SDK>\include" and "<OpenXR-SDK>\lib\openxr_loader.lib" to the cl line.
+rem Add /DLOOKOUT_MIN_LOG_LEVEL=1 to compile out every [DEBUG] line.
+rem Debug builds (_DEBUG), or /DLOOKOUT_COUNT_ALLOCATIONS=1, add heap allocations per tick to the [TIMING] summaries.
+rem sfml-audio-3.dll is delay-loaded (/DELAYLOAD): lookout.exe maps it at the first flight start, not at launch.
 call "C:\Program Files (x86)\Microsoft Visual Studio\2019\Community\VC\Auxiliary\Build\vcvarsall.bat" x64
-cl /EHsc /Zi /MD /std:c++17 /Fe:lookout.exe lookout.cpp /I. /I"SFML-3.0.0/include" /I"C:\OculusSDK\LibOVR\Include" /link /SUBSYSTEM:WINDOWS /ENTRY:mainCRTStartup "C:\OculusSDK\LibOVR\Lib\Windows\x64\Release\VS2017\LibOVR.lib" "SFML-3.0.0/lib/sfml-audio.lib" "SFML-3.0.0/lib/sfml-system.lib" kernel32.lib user32.lib gdi32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib odbc32.lib odbccp32.lib
\ No newline at end of file
+cl /EHsc /Zi /MD /std:c++17 /Fe:lookout.exe lookout.cpp /I. /I"SFML-3.0.0/include" /I"C:\OculusSDK\LibOVR\Include" /link /SUBSYSTEM:WINDOWS /ENTRY:mainCRTStartup "C:\OculusSDK\LibOVR\Lib\Windows\x64\Release\VS2017\LibOVR.lib" "SFML-3.0.0/lib/sfml-audio.lib" "SFML-3.0.0/lib/sfml-network.lib" "SFML-3.0.0/lib/sfml-system.lib" kernel32.lib user32.lib gdi32.lib opengl32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib wbemuuid.lib hid.lib avrt.lib odbc32.lib odbccp32.lib delayimp.lib /DELAYLOAD:sfml-audio-3.dll
+rem Headless trace replay: the engine only, no OVR, SFML or Win32
+cl /EHsc /O2 /MD /std:c++17 /Fe:lookout_replay.exe lookout_replay.cpp /I.
+rem Flight history queries (flight_history.qlfh), standard library only
+cl /EHsc /O2 /MD /std:c++17 /Fe:lookout_history.exe lookout_history.cpp /I.
+rem Instructor hub: collects the udp_stream of every station, SFML network only
+cl /EHsc /O2 /MD /std:c++17 /Fe:lookout_hub.exe lookout_hub.cpp /I. /I"SFML-3.0.0/include" /link /SUBSYSTEM:CONSOLE "SFML-3.0.0/lib/sfml-network.lib" "SFML-3.0.0/lib/sfml-system.lib" ws2_32.lib
+rem Microbenchmarks of the hot paths: lookout.cpp in a console program
+cl /EHsc /O2 /MD /std:c++17 /Fe:lookout_bench.exe lookout_bench.cpp /I. /I"SFML-3.0.0/include" /I"C:\OculusSDK\LibOVR\Include" /link /SUBSYSTEM:CONSOLE "C:\OculusSDK\LibOVR\Lib\Windows\x64\Release\VS2017\LibOVR.lib" "SFML-3.0.0/lib/sfml-audio.lib" "SFML-3.0.0/lib/sfml-network.lib" "SFML-3.0.0/lib/sfml-system.lib" kernel32.lib user32.lib gdi32.lib opengl32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib wbemuuid.lib hid.lib avrt.lib odbc32.lib odbccp32.lib
@@ -10,6 +10,15 @@
 #include <sys/stat.h>
 #include <OVR_CAPI.h>
 #include <OVR_CAPI_GL.h>
+#include <windows.h>
+#include <GL/gl.h>     // Scan overlay texture uploads
+#ifdef LOOKOUT_WITH_OPENXR
+#include <windows.h>
+#define XR_USE_PLATFORM_WIN32
+#include <openxr/openxr.h>
+#include <openxr/openxr_platform.h>
+#include <cstring>
+#endif
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -17,81 +26,492 @@
 
 #define POLL_INTERVAL 0.05 
 #define LOG_CHECK_INTERVAL 1.0 // Check Condor log file every 1 second
+#define HMD_IDLE_POLL_INTERVAL 0.5 // Session-status-only poll while the HMD is off-head
+#define TRAY_TIP_INTERVAL 1.0 // At most one tray tooltip update a second
 #include <fstream>
 #include "json.hpp" 
+#include "lookout_engine.hpp"
+#include "lookout_plugin.h"
+#include "lookout_telemetry.hpp"
+#include "lookout_trace.hpp"
+#include "lookout_synthetic.hpp"
+#include "lookout_history.hpp"
 #include <SFML/Audio.hpp>
 #include <windows.h>
 #include <winuser.h>   // For VK_ constants and hotkey functions
 #include <shellapi.h> // For Shell_NotifyIcon
+#include <commdlg.h>  // Audio file picker in the settings window
 #include <tlhelp32.h>  // For process enumeration
+#include <hidusage.h>  // Raw Input HID button bindings
+#include <hidpi.h>
+#include <wbemidl.h>   // WMI process start/stop traces
+#include <taskschd.h>  // Startup task ("startup": {"mode": "task"})
+#include <mmdeviceapi.h> // Default audio endpoint change notifications
+#include <avrt.h>        // MMCSS registration of the sampling thread
+#include <psapi.h>       // Working set size for the memory footprint report
+#include <winmeta.h>
+#include <TraceLoggingProvider.h> // ETW events for WPA/xperf
 #include <thread>       // For std::thread
 #include <cstdio>       // For _wfreopen_s, FILE 
 #include <SFML/System/Time.hpp>
 #include <SFML/System/FileInputStream.hpp>
+#include <SFML/Network/UdpSocket.hpp>
+#include <SFML/Network/IpAddress.hpp>
 
 #include <unordered_map>
+#include <set>
+#include <optional>
 #include <memory>
+#include <new>
 #include <vector>
+#include <array>
 // #include <deque> // No longer needed for yaw_window, pitch_window
 #include <algorithm>
 #include <iomanip>
+#include <sstream>
+#include <string>
 #include <cctype> 
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>     // strstr/strcmp window matching, memcpy
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <future>
+#include <iterator>
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#include <immintrin.h>  // SSE/AVX2 batch pose conversion
+#ifdef _MSC_VER
+#include <intrin.h>     // __cpuid, _xgetbv
+#endif
+#endif
+
+// Heap allocation counting for debug builds (on by default with _DEBUG, or build with
+// /DLOOKOUT_COUNT_ALLOCATIONS=1): every operator new bumps a per-thread counter, and the
+// tick watchdogs report the allocations of each tick with their [TIMING] summaries, so
+// an allocation creeping into the steady-state loop shows up the first time it runs.
+// Only this executable's allocations are seen (not those inside the SFML and LibOVR
+// DLLs), and over-aligned ones aren't counted.
+#ifndef LOOKOUT_COUNT_ALLOCATIONS
+#ifdef _DEBUG
+#define LOOKOUT_COUNT_ALLOCATIONS 1
+#else
+#define LOOKOUT_COUNT_ALLOCATIONS 0
+#endif
+#endif
+#if LOOKOUT_COUNT_ALLOCATIONS
+thread_local uint64_t t_heap_allocations = 0;
+
+void* operator new(std::size_t size) {
+    ++t_heap_allocations;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    ++t_heap_allocations;
+    return std::malloc(size ? size : 1);
+}
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+#endif
+
+// Heap allocations made by the calling thread so far; always 0 without the counter
+inline uint64_t thread_heap_allocations() {
+#if LOOKOUT_COUNT_ALLOCATIONS
+    return t_heap_allocations;
+#else
+    return 0;
+#endif
+}
 
 // Forward declarations for startup management
 bool is_startup_enabled_in_registry();
 bool enable_startup_in_registry();
 bool disable_startup_in_registry();
-void sync_startup_setting_from_json();
+struct StartupConfig;
+void sync_startup_setting(bool json_startup_setting, const StartupConfig& cfg, bool replace = false);
 
 // Hotkey message ID
 #define WM_HOTKEY_RECENTER 1004
 
 // Forward declarations for hotkey management  
 bool parse_hotkey(const std::string& hotkey_str, UINT& modifiers, UINT& vk_code);
-bool register_recenter_hotkey(HWND hwnd);
-void unregister_recenter_hotkey(HWND hwnd);
-void load_hotkey_from_settings();
-bool is_condor_simulation_window_active();
+bool register_hotkeys(HWND hwnd);
+void unregister_hotkeys(HWND hwnd);
 LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam);
 
+// Hotkey commands, each with its own binding ("hotkeys" in settings.json)
+enum HotkeyCommand : uint8_t {
+    HOTKEY_NONE,
+    HOTKEY_RECENTER,        // Hardware + software recenter
+    HOTKEY_BASELINE_RESET,  // Capture the current head pose as forward
+    HOTKEY_SNOOZE,          // Silence every alarm for g_snooze_seconds
+    HOTKEY_TOGGLE_DEBUG,    // [DEBUG] lines on/off
+    HOTKEY_NEXT_PROFILE,    // Switch to the next alarm profile
+    HOTKEY_COMMAND_COUNT
+};
+const char* const HOTKEY_COMMAND_NAMES[HOTKEY_COMMAND_COUNT] = { "", "recenter", "baseline_reset", "snooze", "toggle_debug", "next_profile" };
+
 // Hotkey globals (declared early for function access)
 std::string g_recenter_hotkey = "Num5";
+std::array<std::string, HOTKEY_COMMAND_COUNT> g_hotkey_bindings; // Binding text per command; recenter uses g_recenter_hotkey
+double g_snooze_seconds = 120.0;
 bool g_hotkey_registered = false;
 HHOOK g_keyboard_hook = nullptr;
-UINT g_target_vk_code = 0;
-UINT g_target_modifiers = 0;
+// Parsed bindings: command by [vk code][modifier mask], filled when the hook is installed.
+// MOD_ALT/MOD_CONTROL/MOD_SHIFT are bits 0-2, so the mask indexes 8 slots directly and a
+// key-down resolves to its command with two array reads, however many bindings exist.
+std::array<std::array<uint8_t, 8>, 256> g_hotkey_table{};
+std::array<bool, 256> g_hotkey_key_bound{}; // Any binding on this vk: skips the modifier reads for other keys
+std::atomic<bool> g_debug_logging{true};
+
+// Log levels. LOOKOUT_MIN_LOG_LEVEL is the compile-time floor: a LOOKOUT_LOG or
+// LOOKOUT_STREAM below it is a discarded statement, leaving no formatting or stream calls
+// in the binary (build with /DLOOKOUT_MIN_LOG_LEVEL=1 to drop every [DEBUG] line). Above
+// it, logging.level sets the runtime floor and the toggle_debug hotkey switches [DEBUG].
+// With no sink attached (status window hidden, so stdout is NUL, and no session log)
+// lines written in place stop before any formatting; LOOKOUT_LOG lines are still queued
+// unformatted for the async log's backlog, which formats them only if the window opens.
+enum LogLevel : int { LEVEL_DEBUG, LEVEL_INFO, LEVEL_WARNING, LEVEL_ERROR };
+#ifndef LOOKOUT_MIN_LOG_LEVEL
+#define LOOKOUT_MIN_LOG_LEVEL 0
+#endif
+constexpr int kMinLogLevel = LOOKOUT_MIN_LOG_LEVEL;
+std::atomic<int> g_log_level{LEVEL_DEBUG};
+
+enum LogSink : uint32_t { LOG_SINK_CONSOLE = 1u << 0, LOG_SINK_SESSION_FILE = 1u << 1, LOG_SINK_BACKLOG = 1u << 2 };
+std::atomic<uint32_t> g_log_sinks{0}; // LogSink bits of the sinks attached now
+
+inline bool log_level_passes(int level) {
+    if (level < g_log_level.load(std::memory_order_relaxed)) return false;
+    return level != LEVEL_DEBUG || g_debug_logging.load(std::memory_order_relaxed);
+}
+
+// A line formatted now would be read (console or session log)
+inline bool log_level_enabled(int level) {
+    if ((g_log_sinks.load(std::memory_order_relaxed) & (LOG_SINK_CONSOLE | LOG_SINK_SESSION_FILE)) == 0) return false;
+    return log_level_passes(level);
+}
+
+// A line queued unformatted may be read, now or from the backlog
+inline bool log_queue_enabled(int level) {
+    return g_log_sinks.load(std::memory_order_relaxed) != 0 && log_level_passes(level);
+}
+
+// Queue a line on an AsyncLog: LOOKOUT_LOG(async_log, LEVEL_INFO, "[INFO] Alarm {} ...", id)
+#define LOOKOUT_LOG(log, level, ...) \
+    do { if constexpr ((level) >= kMinLogLevel) { if (log_queue_enabled(level)) (log).write(__VA_ARGS__); } } while (0)
+// Write a line straight to std::cout: LOOKOUT_STREAM(LEVEL_DEBUG, "[DEBUG] x: " << x)
+#define LOOKOUT_STREAM(level, ...) \
+    do { if constexpr ((level) >= kMinLogLevel) { if (log_level_enabled(level)) std::cout << __VA_ARGS__ << std::endl; } } while (0)
+DWORD g_input_thread_id = 0; // Owns the keyboard hook
+// Condor sim window present, kept current by the window detector. The keyboard hook reads
+// only this: a low-level hook must return fast or it delays every keystroke system-wide.
+std::atomic<bool> g_condor_sim_active{false};
+
+// Auto-reset event that wakes the core thread out of an idle wait early
+// (shutdown, hotkey commands, flight-start signals)
+HANDLE g_core_wake_event = nullptr;
+// Auto-reset event that wakes the pose sampler thread out of its idle waits
+HANDLE g_sampler_wake_event = nullptr;
+
+void wake_core_thread() {
+    if (g_core_wake_event) SetEvent(g_core_wake_event);
+    if (g_sampler_wake_event) SetEvent(g_sampler_wake_event);
+}
+
+// Shutdown, for every worker thread: the stop token their loops check and a manual-reset
+// event every HighResolutionTimer wait also waits on. Unlike the auto-reset wake events it
+// stays signaled, so no wait started after Exit (a retry backoff, a reconnect delay, an
+// idle wait) can sleep out its timeout.
+HANDLE g_shutdown_event = nullptr;
+std::atomic<bool> g_shutdown_requested{false};
+
+void request_shutdown() {
+    g_shutdown_requested.store(true);
+    if (g_shutdown_event) SetEvent(g_shutdown_event);
+    wake_core_thread();
+}
+
+inline bool shutdown_requested() { return g_shutdown_requested.load(std::memory_order_relaxed); }
+
+// Lock-free bounded multi-producer/single-consumer queue (Vyukov's bounded queue, one
+// consumer). Every slot carries a sequence number: a producer claims the next slot with
+// one compare-exchange and publishes it by bumping the sequence, and the consumer takes
+// slots strictly in claim order. Capacity must be a power of two; a full queue rejects
+// the push.
+template <typename T, size_t Capacity>
+class MpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "MpscQueue capacity must be a power of two");
+
+public:
+    MpscQueue() {
+        for (size_t i = 0; i < Capacity; ++i) slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    bool try_push(const T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots_[head & (Capacity - 1)];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence == head) {
+                if (head_.compare_exchange_weak(head, head + 1, std::memory_order_relaxed)) {
+                    slot.item = item;
+                    slot.sequence.store(head + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (static_cast<ptrdiff_t>(sequence - head) < 0) {
+                return false; // Still holds an item the consumer hasn't taken
+            } else {
+                head = head_.load(std::memory_order_relaxed); // Another producer got there first
+            }
+        }
+    }
+
+    // Consumer only. A slot claimed but not yet written stops the pop there, so items
+    // still come out in claim order.
+    bool try_pop(T& out) {
+        Slot& slot = slots_[tail_ & (Capacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != tail_ + 1) return false;
+        out = slot.item;
+        slot.sequence.store(tail_ + Capacity, std::memory_order_release);
+        ++tail_;
+        return true;
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        T item{};
+    };
+    std::array<Slot, Capacity> slots_;
+    alignas(64) std::atomic<size_t> head_{0}; // Next slot to claim, shared by the producers
+    alignas(64) size_t tail_ = 0;             // Consumer only
+};
+
+// Typed engine and flight events for in-process consumers, which before had only the
+// log text to go on
+struct BusEvent {
+    enum Type : uint8_t {
+        DIRECTION_REGISTERED, // value: the LookoutDirection
+        LOOKOUT_SUCCESS,      // value: L/R time difference (us)
+        WARNING_STARTED,      // value: us past the alarm's deadline
+        WARNING_REPEAT,       // value: ms into the warning
+        CENTER_RESET,
+        FLIGHT_START,
+        FLIGHT_END,
+        PLUGIN,               // Reported by a plugin; alarm: its rule code
+        TYPE_COUNT
+    };
+    static const char* name(Type type) {
+        static const char* const kNames[] = {
+            "direction_registered", "lookout_success", "warning_started", "warning_repeat", "center_reset", "flight_start", "flight_end",
+            "plugin"
+        };
+        return type < TYPE_COUNT ? kNames[type] : "?";
+    }
+
+    Type type = CENTER_RESET;
+    uint32_t alarm = 0;     // Alarm id; 0 for events not tied to an alarm
+    int64_t value = 0;
+    int64_t engine_us = 0;  // Engine time of the event
+    int64_t t_us = 0;       // Core clock (monotonic_now_us() - clock epoch)
+};
+
+// Fan-out of BusEvents to subscribers. Each subscription is its own bounded queue with
+// a wake event: publishing pushes into every queue and signals it, so consumers block
+// on their event instead of polling and the publisher never waits on a consumer. A
+// full queue drops the event for that subscriber alone and counts it. Subscriptions
+// live as long as the bus; publish() may run on any thread.
+class EventBus {
+public:
+    static constexpr size_t kMaxSubscribers = 8;
+    static constexpr size_t kQueueCapacity = 256;
+
+    class Subscription {
+    public:
+        explicit Subscription(std::string name) : name_(std::move(name)), wake_(CreateEventA(nullptr, FALSE, FALSE, nullptr)) {}
+        ~Subscription() { if (wake_) CloseHandle(wake_); }
+
+        bool pop(BusEvent& out) { return queue_.try_pop(out); } // Subscriber thread only
+        HANDLE wake_event() const { return wake_; }             // Signaled after each push
+        uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+        const std::string& name() const { return name_; }
+
+    private:
+        friend class EventBus;
+        std::string name_;
+        HANDLE wake_;
+        MpscQueue<BusEvent, kQueueCapacity> queue_;
+        std::atomic<uint64_t> dropped_{0};
+    };
+
+    // nullptr once kMaxSubscribers are subscribed
+    Subscription* subscribe(const std::string& name) {
+        size_t slot = count_.load(std::memory_order_relaxed);
+        if (slot >= kMaxSubscribers) return nullptr;
+        subscriptions_[slot] = std::make_unique<Subscription>(name);
+        count_.store(slot + 1, std::memory_order_release);
+        return subscriptions_[slot].get();
+    }
+
+    void publish(const BusEvent& event) {
+        const size_t count = count_.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; ++i) {
+            Subscription& s = *subscriptions_[i];
+            if (s.queue_.try_push(event)) {
+                SetEvent(s.wake_);
+            } else if (s.dropped_.fetch_add(1, std::memory_order_relaxed) == 0) {
+                std::cerr << "[WARNING] Event subscriber \"" << s.name_ << "\" is falling behind; dropping its events" << std::endl;
+            }
+        }
+    }
+
+    bool has_subscribers() const { return count_.load(std::memory_order_acquire) > 0; }
+
+private:
+    std::array<std::unique_ptr<Subscription>, kMaxSubscribers> subscriptions_;
+    std::atomic<size_t> count_{0}; // Subscribed only from the core thread
+};
+
+// Commands for the core thread, from the keyboard hook, HID buttons and tray menu. The
+// core drains the queue at the start of every tick and carries them out in the order
+// they were posted.
+struct CoreCommand {
+    enum Type : uint8_t { RECENTER, BASELINE_RESET, RELOAD_SETTINGS, PAUSE, RESUME, SNOOZE, NEXT_PROFILE, DUMP_POSE_HISTORY,
+                          SHOW_STATUS, DUMP_HEATMAP, EXIT, TYPE_COUNT };
+    Type type = RECENTER;
+};
+// Names on the command line (--reset-baseline) and the pipe ({"command": "reset_baseline"})
+const char* const CORE_COMMAND_NAMES[CoreCommand::TYPE_COUNT] = {
+    "recenter", "reset_baseline", "reload", "pause", "resume", "snooze", "next_profile", "dump_history", "show_status",
+    "dump_heatmap", "exit"
+};
+
+bool parse_core_command(const std::string& name, CoreCommand::Type& type) {
+    for (int k = 0; k < CoreCommand::TYPE_COUNT; ++k) {
+        if (name == CORE_COMMAND_NAMES[k]) {
+            type = static_cast<CoreCommand::Type>(k);
+            return true;
+        }
+    }
+    return false;
+}
+MpscQueue<CoreCommand, 64> g_core_commands;
+std::atomic<bool> g_alarms_paused{false}; // Paused by a PAUSE command, published by the core for the tray menu
+
+// Any thread: queue a command and wake the core; false when the queue is full
+bool post_core_command(CoreCommand::Type type) {
+    if (!g_core_commands.try_push(CoreCommand{ type })) {
+        std::cerr << "[WARNING] Core command queue full; command dropped" << std::endl;
+        return false;
+    }
+    wake_core_thread();
+    return true;
+}
 
-// Oculus session global (for hotkey access)
-ovrSession g_ovr_session = nullptr;
+// Recenters the core has handed to whichever thread samples the headset: it owns the
+// reference transform and applies them to its next tracked pose
+enum RecenterRequest : uint32_t {
+    RECENTER_BASELINE_RESET = 1u << 0, // Capture the current head pose as forward
+    RECENTER_SOFTWARE = 1u << 1,       // Counter the current yaw with the manual offset
+    RECENTER_HARDWARE = 1u << 2,       // ovr_RecenterTrackingOrigin, before the software recenter
+};
+std::atomic<uint32_t> g_pending_recenter{0};
 
-// Software recenter flag and offset
-bool g_request_software_recenter = false;
-bool g_request_baseline_reset = false; // Reset baseline reference to current head position
+// Software recenter offset and baseline. Sampling thread only, through apply_pending_recenter().
 ovrQuatf g_recenter_offset = {0, 0, 0, 1}; // Identity quaternion
 ovrQuatf g_baseline_reference = {0, 0, 0, 1}; // Baseline reference orientation
 bool g_has_manual_recenter_offset = false; // Track if user has manually set offset
 bool g_has_baseline_reference = false; // Track if we have a custom baseline
+double g_drift_correction_deg = 0.0; // Slow yaw correction from YawDriftCorrector, added to the offset
+ovrVector3f g_baseline_position = {0, 0, 0}; // Head position at the last recenter, for lean detection
+ovrQuatf g_baseline_position_orientation = {0, 0, 0, 1}; // Head orientation at that moment (sets "left")
+bool g_has_baseline_position = false;
+
+// Baseline and manual recenter offset folded into one cached transform. Rebuilt by
+// rebuild_reference_transform() whenever either changes, so the per-sample path reads
+// no flags and always runs the same math (identity when nothing is set).
+struct ReferenceTransform {
+    ovrQuatf baseline_inverse = {0, 0, 0, 1};
+    double offset_cos = 1.0, offset_sin = 0.0; // Manual recenter offset (a pure yaw rotation)
+    // Lean frame: baseline position, and the horizontal unit vector pointing to the
+    // pilot's left at the baseline heading. Vertical lean is along tracking-space +Y.
+    bool has_position = false;
+    double position_x = 0.0, position_y = 0.0, position_z = 0.0;
+    double left_x = -1.0, left_z = 0.0;
+};
+ReferenceTransform g_reference_transform;
 
-struct LookoutAlarmConfig {
-    double min_horizontal_angle = 120.0; 
-    double min_vertical_angle_up = 20.0;   
-    double min_vertical_angle_down = 5.0; 
-    int max_time_ms = 60000;             
-    std::string audio_file;             
-    int start_volume = 5;              
-    int end_volume = 100;               
-    int volume_ramp_time_ms = 30000;     
-    int repeat_interval_ms = 5000;      
-    int min_lookout_time_ms = 2000;     
-    int silence_after_look_ms = 5000;   
+// Monotonic engine time base: int64 microseconds read from QueryPerformanceCounter.
+// All alarm timers are measured against this instead of assuming a fixed tick.
+int64_t monotonic_now_us() {
+    static const int64_t qpc_frequency = [] {
+        LARGE_INTEGER freq;
+        QueryPerformanceFrequency(&freq);
+        return static_cast<int64_t>(freq.QuadPart);
+    }();
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    // Split into whole seconds + remainder so the multiply can't overflow on long uptimes
+    int64_t ticks = counter.QuadPart;
+    return (ticks / qpc_frequency) * 1000000 + (ticks % qpc_frequency) * 1000000 / qpc_frequency;
+}
 
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(LookoutAlarmConfig,
-        min_horizontal_angle, min_vertical_angle_up, min_vertical_angle_down, max_time_ms, audio_file,
-        start_volume, end_volume, volume_ramp_time_ms, repeat_interval_ms, min_lookout_time_ms,
-        silence_after_look_ms)
+// Where startup time goes. Each phase records how long it took, from whichever thread
+// runs it; the first record of a phase wins, so a reconnect later doesn't replace it.
+// The core prints the breakdown as one [TIMING] line and as startup.* metrics gauges
+// at the first tracked sample.
+enum StartupPhase {
+    STARTUP_WINDOW, STARTUP_TRAY, STARTUP_SETTINGS, STARTUP_HOTKEYS, STARTUP_REGISTRY,
+    STARTUP_RUNTIME_INIT, STARTUP_SESSION_CREATE,
+    STARTUP_ARMED,        // From launch: every startup task joined, monitoring starts
+    STARTUP_FIRST_SAMPLE, // From launch
+    STARTUP_PHASE_COUNT
 };
+const char* const STARTUP_PHASE_NAMES[STARTUP_PHASE_COUNT] = {
+    "window", "tray", "settings", "hotkeys", "registry", "runtime_init", "session_create", "armed", "first_sample"
+};
+int64_t g_launch_us = 0; // Set first thing in WinMain
+std::atomic<int64_t> g_startup_phase_us[STARTUP_PHASE_COUNT]; // 0 until recorded
+
+// Records the phase as having run from start_us until now; returns now
+int64_t record_startup_phase(StartupPhase phase, int64_t start_us) {
+    const int64_t now_us = monotonic_now_us();
+    int64_t unset = 0;
+    g_startup_phase_us[phase].compare_exchange_strong(unset, (std::max<int64_t>)(1, now_us - start_us));
+    return now_us;
+}
+
+// "window 2 ms, tray 4 ms, ..., first_sample 1830 ms after launch", skipping phases
+// that didn't run (a lazily opened headset, a replay source)
+std::string startup_breakdown() {
+    std::string text;
+    for (int phase = 0; phase < STARTUP_PHASE_COUNT; ++phase) {
+        const int64_t us = g_startup_phase_us[phase].load();
+        if (us == 0) continue;
+        if (!text.empty()) text += ", ";
+        text += std::string(STARTUP_PHASE_NAMES[phase]) + " " + std::to_string(us / 1000) + " ms";
+    }
+    return text + " after launch";
+}
 
-inline double rad2deg(double rad) { return rad * 180.0 / M_PI; }
+// ETW TraceLogging provider "QuestLookout", so a WPA/xperf recording shows the loop
+// phases, detector sweeps, alarm events and audio commands on the same timeline as the
+// sim and the Oculus runtime (enable it by GUID, e.g. xperf -start lookout -on
+// 6a1f1c52-3b7e-4d0a-9c61-2e8b5f47d319). With no session listening a TraceLoggingWrite
+// is one enabled check; call sites that time something test trace_enabled() before
+// reading the clock.
+TRACELOGGING_DEFINE_PROVIDER(g_trace_provider, "QuestLookout",
+    (0x6a1f1c52, 0x3b7e, 0x4d0a, 0x9c, 0x61, 0x2e, 0x8b, 0x5f, 0x47, 0xd3, 0x19));
+
+inline bool trace_enabled() { return TraceLoggingProviderEnabled(g_trace_provider, 0, 0); }
 
 // Quaternion multiplication for applying software recenter offset
 ovrQuatf quat_multiply(const ovrQuatf& q1, const ovrQuatf& q2) {
@@ -103,68 +523,494 @@ ovrQuatf quat_multiply(const ovrQuatf& q1, const ovrQuatf& q2) {
     return result;
 }
 
-// Clear software recenter offset (reset to identity)  
-void clear_software_recenter() {
-    g_recenter_offset = {0, 0, 0, 1}; // Identity quaternion
-    g_has_manual_recenter_offset = false;
-    std::cout << "[INFO] Software recenter offset cleared" << std::endl;
-}
-
-// Reset baseline reference to current head position
-void reset_baseline_reference() {
-    g_baseline_reference = {0, 0, 0, 1}; // Will be set in main loop
-    g_has_baseline_reference = false; // Will be set to true when captured
-    g_request_baseline_reset = true;
-    clear_software_recenter(); // Also clear any manual offset
-    std::cout << "[INFO] Baseline reference reset requested" << std::endl;
-}
-
 // Quaternion conjugate (inverse rotation)
 ovrQuatf quat_conjugate(const ovrQuatf& q) {
     return {-q.x, -q.y, -q.z, q.w};
 }
 
-void quat_to_yaw_pitch(const ovrQuatf& q, double& yaw_deg, double& pitch_deg) {
-    ovrQuatf working_q = q;
-    
-    // Apply baseline reference transformation (if we have one)
+// Refresh g_reference_transform after the baseline or manual offset changes
+void rebuild_reference_transform() {
+    ReferenceTransform t;
     if (g_has_baseline_reference) {
-        // Transform relative to baseline: q_relative = q_baseline_inverse * q_current
-        working_q = quat_multiply(quat_conjugate(g_baseline_reference), q);
+        t.baseline_inverse = quat_conjugate(g_baseline_reference);
     }
-    
-    // Apply manual recenter offset (only if user has manually set one)
     if (g_has_manual_recenter_offset) {
-        working_q = quat_multiply(working_q, g_recenter_offset);
+        // The offset is built as a rotation about +Y by alpha: (0, sin(alpha/2), 0, cos(alpha/2))
+        const ovrQuatf& o = g_recenter_offset;
+        t.offset_cos = o.w * o.w - o.y * o.y;
+        t.offset_sin = 2.0 * o.w * o.y;
     }
-    
-    double ys = 2.0 * (working_q.w * working_q.y + working_q.x * working_q.z);
-    double yc = 1.0 - 2.0 * (working_q.y * working_q.y + working_q.z * working_q.z);
-    double ps = 2.0 * (working_q.w * working_q.x - working_q.z * working_q.y);
-    ps = (std::max)((-1.0), (std::min)(1.0, ps)); 
-    yaw_deg = rad2deg(std::atan2(ys, yc)); // Output is [-180, 180]
-    pitch_deg = rad2deg(std::asin(ps));   // Output is [-90, 90]
+    if (g_drift_correction_deg != 0.0) {
+        // Both are yaw rotations, so they compose by adding angles
+        const double c = std::cos(deg2rad(g_drift_correction_deg)), s = std::sin(deg2rad(g_drift_correction_deg));
+        const double offset_cos = t.offset_cos, offset_sin = t.offset_sin;
+        t.offset_cos = offset_cos * c - offset_sin * s;
+        t.offset_sin = offset_sin * c + offset_cos * s;
+    }
+    if (g_has_baseline_position) {
+        t.has_position = true;
+        t.position_x = g_baseline_position.x;
+        t.position_y = g_baseline_position.y;
+        t.position_z = g_baseline_position.z;
+        // Head -X axis (left) at the baseline orientation, flattened onto the horizontal plane
+        const ovrQuatf& b = g_baseline_position_orientation;
+        double lx = -(1.0 - 2.0 * (b.y * b.y + b.z * b.z));
+        double lz = -(2.0 * (b.x * b.z - b.w * b.y));
+        double length = std::sqrt(lx * lx + lz * lz);
+        if (length > 1e-6) {
+            t.left_x = lx / length;
+            t.left_z = lz / length;
+        }
+    }
+    g_reference_transform = t;
 }
 
-std::vector<LookoutAlarmConfig> load_configs(const std::string& filename) {
-    std::vector<LookoutAlarmConfig> cfgs;
-    std::ifstream f(filename);
-    if (f) {
-        try {
-            nlohmann::json j;
-            f >> j;
-            if (j.contains("alarms")) {
-                for (const auto& item : j["alarms"]) {
-                    cfgs.push_back(item.get<LookoutAlarmConfig>());
-                }
+LookVector quat_to_look_vector(const ovrQuatf& q) {
+    const ReferenceTransform& ref = g_reference_transform;
+
+    // Relative to baseline: q_relative = q_baseline_inverse * q_current
+    ovrQuatf working_q = quat_multiply(ref.baseline_inverse, q);
+
+    // Rotation-matrix terms used by the decomposition (m00, m02, m10, m12)
+    double m00 = 1.0 - 2.0 * (working_q.y * working_q.y + working_q.z * working_q.z);
+    double m02 = 2.0 * (working_q.w * working_q.y + working_q.x * working_q.z);
+    double m10 = 2.0 * (working_q.x * working_q.y + working_q.w * working_q.z);
+    double m12 = 2.0 * (working_q.y * working_q.z - working_q.w * working_q.x);
+
+    // Post-multiplying by the yaw offset Ry(alpha) mixes matrix columns 0 and 2
+    LookVector v;
+    v.yaw_sin = ref.offset_sin * m00 + ref.offset_cos * m02;
+    v.yaw_cos = ref.offset_cos * m00 - ref.offset_sin * m02;
+    v.pitch_sin = (std::max)((-1.0), (std::min)(1.0, -(ref.offset_sin * m10 + ref.offset_cos * m12)));
+    return v;
+}
+
+LeanOffset position_to_lean(const ovrVector3f& p) {
+    const ReferenceTransform& ref = g_reference_transform;
+    LeanOffset lean;
+    if (!ref.has_position) return lean;
+    double dx = p.x - ref.position_x, dz = p.z - ref.position_z;
+    lean.lateral_m = dx * ref.left_x + dz * ref.left_z;
+    lean.vertical_m = p.y - ref.position_y;
+    lean.valid = true;
+    return lean;
+}
+
+// Batch quaternion -> yaw/pitch (degrees) over structure-of-arrays input, using the same
+// reference transform as quat_to_look_vector(). For replay and other bulk conversions.
+// The SIMD paths use a polynomial atan (asin is evaluated as atan2(s, sqrt(1 - s^2)))
+// and match the scalar std::atan2/std::asin path to within BATCH_YAW_PITCH_TOLERANCE_DEG
+// for |pitch| < 85 deg. Closer to the poles both paths are limited by float rounding of
+// the quaternion: yaw is ill-conditioned there and pitch drifts by up to ~0.006 deg.
+#define BATCH_YAW_PITCH_TOLERANCE_DEG 0.001
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#define LOOKOUT_HAS_X86_SIMD 1
+#if defined(__GNUC__) || defined(__clang__)
+#define LOOKOUT_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define LOOKOUT_TARGET_AVX2
+#endif
+#endif
+
+struct QuatArrays {
+    const float* x;
+    const float* y;
+    const float* z;
+    const float* w;
+};
+
+static void batch_quat_to_yaw_pitch_scalar(const QuatArrays& q, size_t begin, size_t end, float* yaw_deg, float* pitch_deg) {
+    for (size_t n = begin; n < end; ++n) {
+        ovrQuatf quat = { q.x[n], q.y[n], q.z[n], q.w[n] };
+        double yaw = 0.0, pitch = 0.0;
+        look_vector_to_yaw_pitch(quat_to_look_vector(quat), yaw, pitch);
+        yaw_deg[n] = static_cast<float>(yaw);
+        pitch_deg[n] = static_cast<float>(pitch);
+    }
+}
+
+#ifdef LOOKOUT_HAS_X86_SIMD
+// atan(a) for a in [0, 1], max error ~1e-7 rad
+#define LOOKOUT_ATAN_C1 0.99997726f
+#define LOOKOUT_ATAN_C3 -0.33262347f
+#define LOOKOUT_ATAN_C5 0.19354346f
+#define LOOKOUT_ATAN_C7 -0.11643287f
+#define LOOKOUT_ATAN_C9 0.05265332f
+#define LOOKOUT_ATAN_C11 -0.01172120f
+
+static inline __m128 atan2_ps_sse(__m128 y, __m128 x) {
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+    __m128 ax = _mm_andnot_ps(sign_mask, x);
+    __m128 ay = _mm_andnot_ps(sign_mask, y);
+    __m128 hi = _mm_max_ps(ax, ay);
+    __m128 lo = _mm_min_ps(ax, ay);
+    __m128 hi_nonzero = _mm_cmpgt_ps(hi, _mm_setzero_ps());
+    __m128 a = _mm_and_ps(_mm_div_ps(lo, _mm_or_ps(hi, _mm_andnot_ps(hi_nonzero, _mm_set1_ps(1.0f)))), hi_nonzero);
+    __m128 a2 = _mm_mul_ps(a, a);
+    __m128 p = _mm_set1_ps(LOOKOUT_ATAN_C11);
+    p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(LOOKOUT_ATAN_C9));
+    p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(LOOKOUT_ATAN_C7));
+    p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(LOOKOUT_ATAN_C5));
+    p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(LOOKOUT_ATAN_C3));
+    p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(LOOKOUT_ATAN_C1));
+    __m128 r = _mm_mul_ps(p, a);
+    // Undo the octant folding: |y| > |x| -> pi/2 - r; x < 0 -> pi - r; then y's sign
+    __m128 swap = _mm_cmpgt_ps(ay, ax);
+    r = _mm_or_ps(_mm_and_ps(swap, _mm_sub_ps(_mm_set1_ps(1.57079632679f), r)), _mm_andnot_ps(swap, r));
+    __m128 x_negative = _mm_cmplt_ps(x, _mm_setzero_ps());
+    r = _mm_or_ps(_mm_and_ps(x_negative, _mm_sub_ps(_mm_set1_ps(3.14159265359f), r)), _mm_andnot_ps(x_negative, r));
+    return _mm_or_ps(r, _mm_and_ps(y, sign_mask));
+}
+
+static void batch_quat_to_yaw_pitch_sse(const QuatArrays& q, size_t count, float* yaw_deg, float* pitch_deg) {
+    const ReferenceTransform& ref = g_reference_transform;
+    const __m128 bx = _mm_set1_ps(ref.baseline_inverse.x), by = _mm_set1_ps(ref.baseline_inverse.y);
+    const __m128 bz = _mm_set1_ps(ref.baseline_inverse.z), bw = _mm_set1_ps(ref.baseline_inverse.w);
+    const __m128 oc = _mm_set1_ps(static_cast<float>(ref.offset_cos)), os = _mm_set1_ps(static_cast<float>(ref.offset_sin));
+    const __m128 one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f), to_deg = _mm_set1_ps(57.2957795131f);
+    size_t n = 0;
+    for (; n + 4 <= count; n += 4) {
+        __m128 qx = _mm_loadu_ps(q.x + n), qy = _mm_loadu_ps(q.y + n), qz = _mm_loadu_ps(q.z + n), qw = _mm_loadu_ps(q.w + n);
+        // working = baseline_inverse * q
+        __m128 w = _mm_sub_ps(_mm_sub_ps(_mm_mul_ps(bw, qw), _mm_mul_ps(bx, qx)), _mm_add_ps(_mm_mul_ps(by, qy), _mm_mul_ps(bz, qz)));
+        __m128 x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(bw, qx), _mm_mul_ps(bx, qw)), _mm_sub_ps(_mm_mul_ps(by, qz), _mm_mul_ps(bz, qy)));
+        __m128 y = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(bw, qy), _mm_mul_ps(bx, qz)), _mm_add_ps(_mm_mul_ps(by, qw), _mm_mul_ps(bz, qx)));
+        __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(bw, qz), _mm_mul_ps(bx, qy)), _mm_sub_ps(_mm_mul_ps(bz, qw), _mm_mul_ps(by, qx)));
+        __m128 m00 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(_mm_mul_ps(y, y), _mm_mul_ps(z, z))));
+        __m128 m02 = _mm_mul_ps(two, _mm_add_ps(_mm_mul_ps(w, y), _mm_mul_ps(x, z)));
+        __m128 m10 = _mm_mul_ps(two, _mm_add_ps(_mm_mul_ps(x, y), _mm_mul_ps(w, z)));
+        __m128 m12 = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(y, z), _mm_mul_ps(w, x)));
+        __m128 ys = _mm_add_ps(_mm_mul_ps(os, m00), _mm_mul_ps(oc, m02));
+        __m128 yc = _mm_sub_ps(_mm_mul_ps(oc, m00), _mm_mul_ps(os, m02));
+        __m128 ps = _mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(_mm_mul_ps(os, m10), _mm_mul_ps(oc, m12)));
+        ps = _mm_max_ps(_mm_set1_ps(-1.0f), _mm_min_ps(one, ps));
+        __m128 pc = _mm_sqrt_ps(_mm_max_ps(_mm_setzero_ps(), _mm_sub_ps(one, _mm_mul_ps(ps, ps))));
+        _mm_storeu_ps(yaw_deg + n, _mm_mul_ps(atan2_ps_sse(ys, yc), to_deg));
+        _mm_storeu_ps(pitch_deg + n, _mm_mul_ps(atan2_ps_sse(ps, pc), to_deg));
+    }
+    batch_quat_to_yaw_pitch_scalar(q, n, count, yaw_deg, pitch_deg);
+}
+
+LOOKOUT_TARGET_AVX2 static inline __m256 atan2_ps_avx2(__m256 y, __m256 x) {
+    const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+    __m256 ax = _mm256_andnot_ps(sign_mask, x);
+    __m256 ay = _mm256_andnot_ps(sign_mask, y);
+    __m256 hi = _mm256_max_ps(ax, ay);
+    __m256 lo = _mm256_min_ps(ax, ay);
+    __m256 hi_nonzero = _mm256_cmp_ps(hi, _mm256_setzero_ps(), _CMP_GT_OQ);
+    __m256 a = _mm256_and_ps(_mm256_div_ps(lo, _mm256_blendv_ps(_mm256_set1_ps(1.0f), hi, hi_nonzero)), hi_nonzero);
+    __m256 a2 = _mm256_mul_ps(a, a);
+    __m256 p = _mm256_set1_ps(LOOKOUT_ATAN_C11);
+    p = _mm256_fmadd_ps(p, a2, _mm256_set1_ps(LOOKOUT_ATAN_C9));
+    p = _mm256_fmadd_ps(p, a2, _mm256_set1_ps(LOOKOUT_ATAN_C7));
+    p = _mm256_fmadd_ps(p, a2, _mm256_set1_ps(LOOKOUT_ATAN_C5));
+    p = _mm256_fmadd_ps(p, a2, _mm256_set1_ps(LOOKOUT_ATAN_C3));
+    p = _mm256_fmadd_ps(p, a2, _mm256_set1_ps(LOOKOUT_ATAN_C1));
+    __m256 r = _mm256_mul_ps(p, a);
+    r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(1.57079632679f), r), _mm256_cmp_ps(ay, ax, _CMP_GT_OQ));
+    r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(3.14159265359f), r), _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LT_OQ));
+    return _mm256_or_ps(r, _mm256_and_ps(y, sign_mask));
+}
+
+LOOKOUT_TARGET_AVX2 static void batch_quat_to_yaw_pitch_avx2(const QuatArrays& q, size_t count, float* yaw_deg, float* pitch_deg) {
+    const ReferenceTransform& ref = g_reference_transform;
+    const __m256 bx = _mm256_set1_ps(ref.baseline_inverse.x), by = _mm256_set1_ps(ref.baseline_inverse.y);
+    const __m256 bz = _mm256_set1_ps(ref.baseline_inverse.z), bw = _mm256_set1_ps(ref.baseline_inverse.w);
+    const __m256 oc = _mm256_set1_ps(static_cast<float>(ref.offset_cos)), os = _mm256_set1_ps(static_cast<float>(ref.offset_sin));
+    const __m256 one = _mm256_set1_ps(1.0f), two = _mm256_set1_ps(2.0f), to_deg = _mm256_set1_ps(57.2957795131f);
+    size_t n = 0;
+    for (; n + 8 <= count; n += 8) {
+        __m256 qx = _mm256_loadu_ps(q.x + n), qy = _mm256_loadu_ps(q.y + n), qz = _mm256_loadu_ps(q.z + n), qw = _mm256_loadu_ps(q.w + n);
+        // working = baseline_inverse * q
+        __m256 w = _mm256_fmsub_ps(bw, qw, _mm256_fmadd_ps(bx, qx, _mm256_fmadd_ps(by, qy, _mm256_mul_ps(bz, qz))));
+        __m256 x = _mm256_fmadd_ps(bw, qx, _mm256_fmadd_ps(bx, qw, _mm256_fmsub_ps(by, qz, _mm256_mul_ps(bz, qy))));
+        __m256 y = _mm256_fmsub_ps(bw, qy, _mm256_fmsub_ps(bx, qz, _mm256_fmadd_ps(by, qw, _mm256_mul_ps(bz, qx))));
+        __m256 z = _mm256_fmadd_ps(bw, qz, _mm256_fmadd_ps(bx, qy, _mm256_fmsub_ps(bz, qw, _mm256_mul_ps(by, qx))));
+        __m256 m00 = _mm256_fnmadd_ps(two, _mm256_fmadd_ps(y, y, _mm256_mul_ps(z, z)), one);
+        __m256 m02 = _mm256_mul_ps(two, _mm256_fmadd_ps(w, y, _mm256_mul_ps(x, z)));
+        __m256 m10 = _mm256_mul_ps(two, _mm256_fmadd_ps(x, y, _mm256_mul_ps(w, z)));
+        __m256 m12 = _mm256_mul_ps(two, _mm256_fmsub_ps(y, z, _mm256_mul_ps(w, x)));
+        __m256 ys = _mm256_fmadd_ps(os, m00, _mm256_mul_ps(oc, m02));
+        __m256 yc = _mm256_fmsub_ps(oc, m00, _mm256_mul_ps(os, m02));
+        __m256 ps = _mm256_fnmadd_ps(os, m10, _mm256_fnmadd_ps(oc, m12, _mm256_setzero_ps()));
+        ps = _mm256_max_ps(_mm256_set1_ps(-1.0f), _mm256_min_ps(one, ps));
+        __m256 pc = _mm256_sqrt_ps(_mm256_max_ps(_mm256_setzero_ps(), _mm256_fnmadd_ps(ps, ps, one)));
+        _mm256_storeu_ps(yaw_deg + n, _mm256_mul_ps(atan2_ps_avx2(ys, yc), to_deg));
+        _mm256_storeu_ps(pitch_deg + n, _mm256_mul_ps(atan2_ps_avx2(ps, pc), to_deg));
+    }
+    batch_quat_to_yaw_pitch_scalar(q, n, count, yaw_deg, pitch_deg);
+}
+
+static bool cpu_supports_avx2_fma() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0, avx = (info[2] & (1 << 28)) != 0, fma = (info[2] & (1 << 12)) != 0;
+    if (!(osxsave && avx && fma)) return false;
+    if ((_xgetbv(0) & 0x6) != 0x6) return false; // OS saves YMM state
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+#endif // LOOKOUT_HAS_X86_SIMD
+
+void batch_quat_to_yaw_pitch(const QuatArrays& q, size_t count, float* yaw_deg, float* pitch_deg) {
+#ifdef LOOKOUT_HAS_X86_SIMD
+    static const bool use_avx2 = cpu_supports_avx2_fma();
+    if (use_avx2) {
+        batch_quat_to_yaw_pitch_avx2(q, count, yaw_deg, pitch_deg);
+    } else {
+        batch_quat_to_yaw_pitch_sse(q, count, yaw_deg, pitch_deg);
+    }
+#else
+    batch_quat_to_yaw_pitch_scalar(q, 0, count, yaw_deg, pitch_deg);
+#endif
+}
+
+// Compile the alarms listed in `ids` (indices into `configs`, i.e. one alarm profile)
+AlarmTable compile_alarm_table(const std::vector<LookoutAlarmConfig>& configs, const std::vector<uint32_t>& ids) {
+    AlarmTable table;
+    for (uint32_t i : ids) {
+        const LookoutAlarmConfig& config = configs[i];
+        if (!config.enabled()) {
+            std::cout << "[INFO] Alarm " << i << " is disabled (min_horizontal_angle <= 0 or both min_vertical_angle_up/down <= 0)." << std::endl;
+            continue;
+        }
+        CompiledAlarm alarm = compile_alarm(config, i);
+        std::cout << "[INFO] Alarm " << i << ": HAngle=" << config.min_horizontal_angle
+                  << ", VAngleUp=" << config.min_vertical_angle_up
+                  << ", VAngleDown=" << config.min_vertical_angle_down
+                  << ", MaxTime=" << alarm.max_time_us / 1e6 << "s"
+                  << ", Repeat=" << alarm.repeat_interval_us / 1e6 << "s"
+                  << ", MinLookout=" << alarm.min_lookout_us / 1e6 << "s (Min L/R diff)"
+                  << ", SilenceAfterLook=" << alarm.silence_after_look_us / 1e6 << "s"
+                  << (alarm.coverage_needed > 0 ? ", Coverage=" + std::to_string(alarm.coverage_needed) + " bins" : std::string())
+                  << (alarm.min_dwell_us > 0 ? ", MinDwell=" + std::to_string(config.min_dwell_ms) + "ms" : std::string())
+                  << std::endl;
+        table.alarms.push_back(alarm);
+    }
+
+    if (table.alarms.empty()) {
+        std::cerr << "[WARNING] No valid (enabled) alarms configured." << std::endl;
+        return table;
+    }
+    order_alarm_table(table);
+    return table;
+}
+
+// Estimate the turning point of a head movement between two samples whose angular rates
+// have opposite signs, assuming constant angular acceleration in between. Returns false
+// when there was no reversal to interpolate.
+bool interpolate_turning_point(double angle0, double rate0, double angle1, double rate1, double dt_s, double& peak) {
+    if (!(rate0 * rate1 < 0.0) || dt_s <= 0.0) return false;
+    if (std::abs(angle1 - angle0) > 180.0) return false; // Wrapped through +/-180 deg
+    double t_peak = dt_s * rate0 / (rate0 - rate1);
+    double from_start = angle0 + 0.5 * rate0 * t_peak;
+    double from_end = angle1 - 0.5 * rate1 * (dt_s - t_peak);
+    peak = 0.5 * (from_start + from_end);
+    // The turning point can't be less extreme than the samples on either side of it
+    peak = rate0 > 0.0 ? (std::max)(peak, (std::max)(angle0, angle1)) : (std::min)(peak, (std::min)(angle0, angle1));
+    return true;
+}
+
+// One-euro filter (Casiez et al.): a first-order low-pass whose cutoff rises with the
+// signal's speed, so a still head is smoothed heavily while a scan passes with little lag.
+class OneEuroFilter {
+public:
+    OneEuroFilter(double min_cutoff_hz, double beta, double derivative_cutoff_hz)
+        : min_cutoff_hz_(min_cutoff_hz), beta_(beta), derivative_cutoff_hz_(derivative_cutoff_hz) {}
+
+    double filter(double value, double dt_s) {
+        if (!initialized_ || dt_s <= 0.0) {
+            if (!initialized_) {
+                value_ = value;
+                derivative_ = 0.0;
+                initialized_ = true;
             }
-        } catch (const nlohmann::json::parse_error& e) {
-            std::cerr << "[ERROR] Failed to parse settings.json: " << e.what() << std::endl;
-        } catch (const nlohmann::json::type_error& e) {
-            std::cerr << "[ERROR] JSON type error in settings.json: " << e.what() << std::endl;
+            return value_;
+        }
+        double derivative = (value - value_) / dt_s;
+        derivative_ += smoothing(derivative_cutoff_hz_, dt_s) * (derivative - derivative_);
+        double cutoff_hz = min_cutoff_hz_ + beta_ * std::abs(derivative_);
+        value_ += smoothing(cutoff_hz, dt_s) * (value - value_);
+        return value_;
+    }
+
+    void reset() { initialized_ = false; }
+
+private:
+    static double smoothing(double cutoff_hz, double dt_s) {
+        double tau = 1.0 / (2.0 * M_PI * cutoff_hz);
+        return 1.0 / (1.0 + tau / dt_s);
+    }
+
+    double min_cutoff_hz_, beta_, derivative_cutoff_hz_;
+    double value_ = 0.0, derivative_ = 0.0;
+    bool initialized_ = false;
+};
+
+// Top-level settings.json keys some loader reads; everything else is skipped unparsed
+const char* const SETTINGS_KEYS[] = {
+    "alarms", "center_reset", "start_with_windows", "recenter_hotkey", "hotkeys", "recenter_buttons",
+    "sampling", "filter", "watchdog", "pose_source", "condor_log", "audio", "sim_profiles",
+    "alarm_profiles", "active_profile", "condor_udp", "pose_history", "logging", "memory", "metrics", "telemetry", "udp_stream",
+    "pose_trace", "threads", "fleet", "flight_history", "scan_heatmap", "scan_overlay", "flight_inference", "plugins",
+    "startup", "resume", "cpu_budget", "select_profile", "command" // Settings pipe requests, never in the file
+};
+
+// SAX handler for settings.json. Most of the file is the _instructions documentation
+// tree, which nothing reads: it and any other unknown top-level key are skipped as
+// they stream past, without building anything for them. The blocks the loaders read
+// are assembled into a small document.
+class SettingsSaxHandler : public nlohmann::json_sax<nlohmann::json> {
+public:
+    explicit SettingsSaxHandler(nlohmann::json& root) : root_(root) {}
+
+    bool null() override { return value(nullptr); }
+    bool boolean(bool val) override { return value(val); }
+    bool number_integer(number_integer_t val) override { return value(val); }
+    bool number_unsigned(number_unsigned_t val) override { return value(val); }
+    bool number_float(number_float_t val, const string_t&) override { return value(val); }
+    bool string(string_t& val) override { return value(std::move(val)); }
+    bool binary(binary_t& val) override { return value(nlohmann::json::binary(std::move(val))); }
+    bool start_object(std::size_t) override { return open(nlohmann::json::object()); }
+    bool start_array(std::size_t) override { return open(nlohmann::json::array()); }
+    bool end_object() override { return close(); }
+    bool end_array() override { return close(); }
+
+    bool key(string_t& val) override {
+        if (skip_depth_ > 0) return true;
+        if (stack_.size() == 1) {
+            skip_next_ = std::none_of(std::begin(SETTINGS_KEYS), std::end(SETTINGS_KEYS),
+                                      [&](const char* known) { return val == known; });
+            if (skip_next_) return true;
+        }
+        key_ = std::move(val);
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex) override {
+        error_ = ex.what();
+        return false;
+    }
+
+    const std::string& error() const { return error_; }
+
+private:
+    template <typename Value>
+    bool value(Value&& val) {
+        if (skip_depth_ > 0) return true;
+        if (skip_next_) {
+            skip_next_ = false;
+            return true;
+        }
+        insert(nlohmann::json(std::forward<Value>(val)));
+        return true;
+    }
+
+    bool open(nlohmann::json&& container) {
+        if (skip_depth_ > 0 || skip_next_) {
+            skip_next_ = false;
+            ++skip_depth_;
+            return true;
+        }
+        stack_.push_back(insert(std::move(container)));
+        return true;
+    }
+
+    bool close() {
+        if (skip_depth_ > 0) --skip_depth_;
+        else stack_.pop_back();
+        return true;
+    }
+
+    nlohmann::json* insert(nlohmann::json&& val) {
+        if (stack_.empty()) {
+            root_ = std::move(val);
+            return &root_;
         }
+        nlohmann::json& parent = *stack_.back();
+        if (parent.is_object()) return &(parent[key_] = std::move(val));
+        parent.push_back(std::move(val));
+        return &parent.back();
+    }
+
+    nlohmann::json& root_;
+    std::vector<nlohmann::json*> stack_; // Open containers being filled
+    std::string key_;
+    int skip_depth_ = 0;     // Nesting inside a skipped subtree
+    bool skip_next_ = false; // The value after a skipped key
+    std::string error_;
+};
+
+// Parse a settings document (the file, or a payload pushed over the settings pipe) into
+// `j`. On failure `error` says why and `j` is left as an empty object.
+bool parse_settings_document(std::istream& in, nlohmann::json& j, std::string& error) {
+    SettingsSaxHandler handler(j);
+    if (!nlohmann::json::sax_parse(in, &handler)) {
+        error = handler.error();
+    } else if (!j.is_object()) {
+        error = "not a JSON object";
     } else {
-        std::cerr << "[ERROR] Could not open settings.json" << std::endl;
+        return true;
+    }
+    j = nlohmann::json::object();
+    return false;
+}
+
+// The whole settings file as one document, parsed once per load. Every settings block
+// below reads from it; a missing or broken file yields an empty object, so each block
+// falls back to its defaults. `ok` tells the two cases apart.
+nlohmann::json read_settings_json(const std::string& filename, bool* ok = nullptr) {
+    if (ok) *ok = false;
+    std::ifstream f(filename, std::ios::binary);
+    if (!f) {
+        std::cerr << "[ERROR] Could not open " << filename << std::endl;
+        return nlohmann::json::object();
+    }
+    int64_t start_us = monotonic_now_us();
+    nlohmann::json j;
+    std::string error;
+    if (!parse_settings_document(f, j, error)) {
+        std::cerr << "[ERROR] Failed to parse " << filename << ": " << error << std::endl;
+        return j;
+    }
+    LOOKOUT_STREAM(LEVEL_DEBUG, "[DEBUG] Parsed " << filename << " in " << (monotonic_now_us() - start_us) << " us");
+    if (ok) *ok = true;
+    return j;
+}
+
+// A named set of alarms for one phase of flight (aerotow, thermalling, final glide...).
+// Every profile's alarms live in the one Settings::alarms list, so audio and latency
+// stats cover them all and an alarm's id is the same whichever profile is active;
+// alarm_ids picks out this profile's.
+struct AlarmProfile {
+    std::string name;
+    std::string sim;                 // Selected when a flight starts in this sim profile; empty for manual only
+    double above_height_m = -1.0;    // Selected by Condor telemetry above this height AGL; < 0 for none
+    std::vector<uint32_t> alarm_ids; // Indices into Settings::alarms
+
+    bool operator==(const AlarmProfile& other) const {
+        return name == other.name && sim == other.sim && above_height_m == other.above_height_m && alarm_ids == other.alarm_ids;
+    }
+    bool operator!=(const AlarmProfile& other) const { return !(*this == other); }
+};
+
+std::vector<LookoutAlarmConfig> load_alarm_settings(const nlohmann::json& j) {
+    std::vector<LookoutAlarmConfig> cfgs;
+    try {
+        if (j.contains("alarms")) {
+            for (const auto& item : j["alarms"]) {
+                cfgs.push_back(item.get<LookoutAlarmConfig>());
+            }
+        }
+    } catch (const nlohmann::json::type_error& e) {
+        std::cerr << "[ERROR] JSON type error in settings.json: " << e.what() << std::endl;
     }
     return cfgs;
 }
@@ -224,131 +1070,336 @@ bool disable_startup_in_registry() {
     return (result == ERROR_SUCCESS || result == ERROR_FILE_NOT_FOUND);
 }
 
-void sync_startup_setting_from_json() {
-    std::ifstream f("settings.json");
-    if (!f) {
-        std::cout << "[INFO] No settings.json found for startup sync." << std::endl;
-        return;
+// How start_with_windows launches lookout ("startup" in settings.json). The Run key
+// starts it with everything else at logon, where its headset retries compete with the
+// Oculus service starting up; "task" registers a Task Scheduler logon task instead,
+// started after a delay at background priority (below normal CPU, low I/O), and
+// optionally only once the PC has gone idle.
+struct StartupConfig {
+    std::string mode = "run_key";  // "run_key" or "task"
+    int delay_seconds = 30;        // Task: after logon
+    int idle_minutes = 0;          // Task: idle this long first; 0 for no idle condition
+    int idle_wait_minutes = 10;    // Task: how long to wait for that idle; the launch is skipped after it
+
+    bool operator==(const StartupConfig& other) const {
+        return mode == other.mode && delay_seconds == other.delay_seconds && idle_minutes == other.idle_minutes &&
+               idle_wait_minutes == other.idle_wait_minutes;
     }
-    
+    bool operator!=(const StartupConfig& other) const { return !(*this == other); }
+};
+
+StartupConfig load_startup_settings(const nlohmann::json& j) {
+    StartupConfig cfg;
     try {
-        nlohmann::json j;
-        f >> j;
-        
-        bool json_startup_setting = j.value("start_with_windows", false);
-        bool registry_startup_enabled = is_startup_enabled_in_registry();
-        
-        // If JSON and registry are out of sync, make registry match JSON
-        if (json_startup_setting != registry_startup_enabled) {
-            if (json_startup_setting) {
-                if (enable_startup_in_registry()) {
-                    std::cout << "[INFO] Enabled Windows startup to match settings.json" << std::endl;
-                } else {
-                    std::cout << "[WARNING] Failed to enable Windows startup" << std::endl;
-                }
-            } else {
-                if (disable_startup_in_registry()) {
-                    std::cout << "[INFO] Disabled Windows startup to match settings.json" << std::endl;
-                } else {
-                    std::cout << "[WARNING] Failed to disable Windows startup" << std::endl;
-                }
+        if (j.contains("startup") && j["startup"].is_object()) {
+            const nlohmann::json& s = j["startup"];
+            cfg.mode = s.value("mode", cfg.mode);
+            if (cfg.mode != "run_key" && cfg.mode != "task") {
+                std::cerr << "[WARNING] Unknown startup mode \"" << cfg.mode << "\"; using the Run key" << std::endl;
+                cfg.mode = "run_key";
             }
+            cfg.delay_seconds = (std::max)(0, s.value("delay_seconds", cfg.delay_seconds));
+            cfg.idle_minutes = (std::max)(0, s.value("idle_minutes", cfg.idle_minutes));
+            cfg.idle_wait_minutes = (std::max)(1, s.value("idle_wait_minutes", cfg.idle_wait_minutes));
         }
     } catch (const std::exception& e) {
-        std::cout << "[WARNING] Could not parse startup setting from settings.json: " << e.what() << std::endl;
+        std::cerr << "[WARNING] Could not parse startup from settings.json: " << e.what() << std::endl;
     }
+    return cfg;
 }
 
-// Hotkey management functions
-bool parse_hotkey(const std::string& hotkey_str, UINT& modifiers, UINT& vk_code) {
-    modifiers = 0;
-    vk_code = 0;
-    
-    std::string key_str = hotkey_str;
-    std::transform(key_str.begin(), key_str.end(), key_str.begin(), ::tolower);
-    
-    // Parse modifiers
-    if (key_str.find("ctrl+") != std::string::npos) {
-        modifiers |= MOD_CONTROL;
-        key_str.erase(key_str.find("ctrl+"), 5);
-    }
-    if (key_str.find("shift+") != std::string::npos) {
-        modifiers |= MOD_SHIFT;
-        key_str.erase(key_str.find("shift+"), 6);
+const wchar_t* const STARTUP_TASK_NAME = L"Quest Lookout";
+const char* const STARTUP_TASK_ARGUMENT = "--startup-task"; // Tells lookout it was started by the task
+bool g_started_by_task = false; // --startup-task: launched by the startup task, at background priority
+
+std::wstring xml_escape(const std::wstring& text) {
+    std::wstring escaped;
+    for (wchar_t c : text) {
+        if (c == L'&') escaped += L"&amp;";
+        else if (c == L'<') escaped += L"&lt;";
+        else if (c == L'>') escaped += L"&gt;";
+        else escaped += c;
     }
-    if (key_str.find("alt+") != std::string::npos) {
-        modifiers |= MOD_ALT;
-        key_str.erase(key_str.find("alt+"), 4);
+    return escaped;
+}
+
+// The root folder of the Task Scheduler, for `use`; false if the service isn't reachable
+template <typename Use>
+bool with_task_folder(Use use) {
+    const HRESULT com = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    ITaskService* service = nullptr;
+    ITaskFolder* folder = nullptr;
+    HRESULT hr = CoCreateInstance(CLSID_TaskScheduler, nullptr, CLSCTX_INPROC_SERVER, IID_ITaskService,
+                                  reinterpret_cast<void**>(&service));
+    if (SUCCEEDED(hr)) {
+        VARIANT none;
+        VariantInit(&none);
+        hr = service->Connect(none, none, none, none);
     }
-    
-    // Parse key codes
-    if (key_str == "num5") vk_code = 0x65;      // VK_NUMPAD5
-    else if (key_str == "num0") vk_code = 0x60; // VK_NUMPAD0
-    else if (key_str == "num1") vk_code = 0x61; // VK_NUMPAD1
-    else if (key_str == "num2") vk_code = 0x62; // VK_NUMPAD2
-    else if (key_str == "num3") vk_code = 0x63; // VK_NUMPAD3
-    else if (key_str == "num4") vk_code = 0x64; // VK_NUMPAD4
-    else if (key_str == "num6") vk_code = 0x66; // VK_NUMPAD6
-    else if (key_str == "num7") vk_code = 0x67; // VK_NUMPAD7
-    else if (key_str == "num8") vk_code = 0x68; // VK_NUMPAD8
-    else if (key_str == "num9") vk_code = 0x69; // VK_NUMPAD9
-    else if (key_str == "f1") vk_code = 0x70;   // VK_F1
-    else if (key_str == "f2") vk_code = 0x71;   // VK_F2
-    else if (key_str == "f3") vk_code = 0x72;   // VK_F3
-    else if (key_str == "f4") vk_code = 0x73;   // VK_F4
-    else if (key_str == "f5") vk_code = 0x74;   // VK_F5
-    else if (key_str == "f6") vk_code = 0x75;   // VK_F6
-    else if (key_str == "f7") vk_code = 0x76;   // VK_F7
-    else if (key_str == "f8") vk_code = 0x77;   // VK_F8
-    else if (key_str == "f9") vk_code = 0x78;   // VK_F9
-    else if (key_str == "f10") vk_code = 0x79;  // VK_F10
-    else if (key_str == "f11") vk_code = 0x7A;  // VK_F11
-    else if (key_str == "f12") vk_code = 0x7B;  // VK_F12
-    else if (key_str.length() == 1) {
-        char c = key_str[0];
-        if (c >= 'a' && c <= 'z') vk_code = 0x41 + (c - 'a');  // VK_A = 0x41
-        else if (c >= '0' && c <= '9') vk_code = 0x30 + (c - '0');  // VK_0 = 0x30
-        else return false;
-    } else {
-        return false;
+    if (SUCCEEDED(hr)) {
+        BSTR root = SysAllocString(L"\\");
+        hr = service->GetFolder(root, &folder);
+        SysFreeString(root);
     }
-    
-    return vk_code != 0;
+    if (SUCCEEDED(hr)) hr = use(folder);
+    if (folder) folder->Release();
+    if (service) service->Release();
+    if (SUCCEEDED(com)) CoUninitialize();
+    return SUCCEEDED(hr);
 }
 
-// Low-level keyboard hook procedure
-LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam) {
-    if (nCode >= 0 && (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN)) {
-        KBDLLHOOKSTRUCT* pKeyboard = (KBDLLHOOKSTRUCT*)lParam;
-        
-        // Check if this is our target key
-        if (pKeyboard->vkCode == g_target_vk_code) {
-            // Check modifiers
-            bool ctrl_pressed = (GetAsyncKeyState(VK_CONTROL) & 0x8000) != 0;
-            bool shift_pressed = (GetAsyncKeyState(VK_SHIFT) & 0x8000) != 0;
-            bool alt_pressed = (GetAsyncKeyState(VK_MENU) & 0x8000) != 0;
-            
-            UINT current_modifiers = 0;
-            if (ctrl_pressed) current_modifiers |= MOD_CONTROL;
-            if (shift_pressed) current_modifiers |= MOD_SHIFT;
-            if (alt_pressed) current_modifiers |= MOD_ALT;
-            
-            // Only trigger if modifiers match AND Condor simulation is active
-            if (current_modifiers == g_target_modifiers && is_condor_simulation_window_active()) {
-                std::cout << "[INFO] Recenter hotkey pressed (non-blocking)" << std::endl;
-                if (g_ovr_session) {
-                    // Try hardware recenter first
-                    ovrResult result = ovr_RecenterTrackingOrigin(g_ovr_session);
-                    if (OVR_SUCCESS(result)) {
-                        std::cout << "[INFO] Hardware recenter attempted" << std::endl;
-                    }
-                    
-                    // Also reset Quest Lookout's internal tracking reference
-                    g_request_software_recenter = true;
-                    std::cout << "[INFO] Quest Lookout tracking reference reset requested" << std::endl;
-                } else {
-                    std::cout << "[WARNING] Cannot recenter: Oculus session not available" << std::endl;
+bool is_startup_task_registered() {
+    return with_task_folder([](ITaskFolder* folder) {
+        IRegisteredTask* task = nullptr;
+        BSTR name = SysAllocString(STARTUP_TASK_NAME);
+        HRESULT hr = folder->GetTask(name, &task);
+        SysFreeString(name);
+        if (task) task->Release();
+        return hr;
+    });
+}
+
+// Registered (or replaced) for the current user's logon, running as that user
+bool register_startup_task(const StartupConfig& cfg) {
+    wchar_t exe_path[MAX_PATH];
+    GetModuleFileNameW(nullptr, exe_path, MAX_PATH);
+    std::wstring directory = exe_path;
+    directory.erase((std::min)(directory.size(), directory.find_last_of(L'\\')));
+    wchar_t user[256] = L"", domain[256] = L"";
+    GetEnvironmentVariableW(L"USERNAME", user, 256);
+    GetEnvironmentVariableW(L"USERDOMAIN", domain, 256);
+    const std::string argument = STARTUP_TASK_ARGUMENT;
+
+    std::wstring xml =
+        L"<?xml version=\"1.0\" encoding=\"UTF-16\"?>"
+        L"<Task version=\"1.2\" xmlns=\"http://schemas.microsoft.com/windows/2004/02/mit/task\">"
+        L"<RegistrationInfo><Description>Starts Quest Lookout after logon (start_with_windows)</Description></RegistrationInfo>"
+        L"<Triggers><LogonTrigger><Enabled>true</Enabled><UserId>" + xml_escape(std::wstring(domain) + L"\\" + user) + L"</UserId>"
+        L"<Delay>PT" + std::to_wstring(cfg.delay_seconds) + L"S</Delay></LogonTrigger></Triggers>"
+        L"<Principals><Principal id=\"Author\"><LogonType>InteractiveToken</LogonType><RunLevel>LeastPrivilege</RunLevel></Principal></Principals>"
+        L"<Settings>"
+        L"<MultipleInstancesPolicy>IgnoreNew</MultipleInstancesPolicy>"
+        L"<DisallowStartIfOnBatteries>false</DisallowStartIfOnBatteries><StopIfGoingOnBatteries>false</StopIfGoingOnBatteries>"
+        L"<ExecutionTimeLimit>PT0S</ExecutionTimeLimit>"
+        L"<Priority>7</Priority>" // Below normal CPU, low I/O
+        L"<RunOnlyIfIdle>" + std::wstring(cfg.idle_minutes > 0 ? L"true" : L"false") + L"</RunOnlyIfIdle>"
+        L"<IdleSettings><Duration>PT" + std::to_wstring((std::max)(1, cfg.idle_minutes)) + L"M</Duration>"
+        L"<WaitTimeout>PT" + std::to_wstring(cfg.idle_wait_minutes) + L"M</WaitTimeout>"
+        L"<StopOnIdleEnd>false</StopOnIdleEnd><RestartOnIdle>false</RestartOnIdle></IdleSettings>"
+        L"</Settings>"
+        L"<Actions Context=\"Author\"><Exec><Command>\"" + xml_escape(exe_path) + L"\"</Command>"
+        L"<Arguments>" + std::wstring(argument.begin(), argument.end()) + L"</Arguments>"
+        L"<WorkingDirectory>" + xml_escape(directory) + L"</WorkingDirectory></Exec></Actions>"
+        L"</Task>";
+
+    return with_task_folder([&](ITaskFolder* folder) {
+        IRegisteredTask* task = nullptr;
+        BSTR name = SysAllocString(STARTUP_TASK_NAME);
+        BSTR definition = SysAllocString(xml.c_str());
+        VARIANT none;
+        VariantInit(&none);
+        HRESULT hr = folder->RegisterTask(name, definition, TASK_CREATE_OR_UPDATE, none, none, TASK_LOGON_INTERACTIVE_TOKEN,
+                                          none, &task);
+        SysFreeString(definition);
+        SysFreeString(name);
+        if (task) task->Release();
+        if (FAILED(hr)) std::cerr << "[WARNING] Task Scheduler rejected the startup task (hr=0x" << std::hex << hr << std::dec << ")" << std::endl;
+        return hr;
+    });
+}
+
+bool delete_startup_task() {
+    return with_task_folder([](ITaskFolder* folder) {
+        BSTR name = SysAllocString(STARTUP_TASK_NAME);
+        HRESULT hr = folder->DeleteTask(name, 0);
+        SysFreeString(name);
+        return hr == HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND) ? S_OK : hr;
+    });
+}
+
+// Makes the Run key and the startup task match settings.json: at most one of them, per
+// cfg.mode, while json_startup_setting is on. `replace` re-registers an existing task,
+// for a changed "startup" block.
+void sync_startup_setting(bool json_startup_setting, const StartupConfig& cfg, bool replace) {
+    const bool want_run_key = json_startup_setting && cfg.mode == "run_key";
+    const bool want_task = json_startup_setting && cfg.mode == "task";
+    // The Task Scheduler is a COM round trip, so it's only asked when a task may be
+    // wanted or left over: task mode, a changed "startup" block, or a launch by the
+    // task (task mode was switched off while lookout wasn't running)
+    const bool check_task = want_task || replace || g_started_by_task;
+
+    if (want_run_key != is_startup_enabled_in_registry()) {
+        if (want_run_key) {
+            if (enable_startup_in_registry()) {
+                std::cout << "[INFO] Enabled Windows startup to match settings.json" << std::endl;
+            } else {
+                std::cout << "[WARNING] Failed to enable Windows startup" << std::endl;
+            }
+        } else {
+            if (disable_startup_in_registry()) {
+                std::cout << "[INFO] Disabled Windows startup (Run key) to match settings.json" << std::endl;
+            } else {
+                std::cout << "[WARNING] Failed to disable Windows startup" << std::endl;
+            }
+        }
+    }
+
+    if (!check_task) return;
+    const bool task_registered = is_startup_task_registered();
+    if (want_task && (replace || !task_registered)) {
+        if (register_startup_task(cfg)) {
+            std::cout << "[INFO] Registered the startup task: " << cfg.delay_seconds << " s after logon, background priority"
+                      << (cfg.idle_minutes > 0 ? ", once idle for " + std::to_string(cfg.idle_minutes) + " min" : std::string()) << std::endl;
+        } else {
+            std::cout << "[WARNING] Failed to register the startup task" << std::endl;
+        }
+    } else if (!want_task && task_registered) {
+        if (delete_startup_task()) {
+            std::cout << "[INFO] Removed the startup task to match settings.json" << std::endl;
+        } else {
+            std::cout << "[WARNING] Failed to remove the startup task" << std::endl;
+        }
+    }
+}
+
+std::string to_lower_ascii(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+    return text;
+}
+
+// The top-level "alarms" array is the "default" profile and keeps ids 0..n-1;
+// "alarm_profiles" entries ({ "name", "sim", "alarms": [...] }) append theirs to `alarms`
+std::vector<AlarmProfile> load_alarm_profiles(const nlohmann::json& j, std::vector<LookoutAlarmConfig>& alarms) {
+    std::vector<AlarmProfile> profiles(1);
+    profiles[0].name = "default";
+    for (size_t i = 0; i < alarms.size(); ++i) profiles[0].alarm_ids.push_back(static_cast<uint32_t>(i));
+    try {
+        if (j.contains("alarm_profiles") && j["alarm_profiles"].is_array()) {
+            for (const auto& p : j["alarm_profiles"]) {
+                AlarmProfile profile;
+                profile.name = p.value("name", std::string());
+                profile.sim = p.value("sim", std::string());
+                profile.above_height_m = p.value("above_height_m", profile.above_height_m);
+                bool duplicate = std::any_of(profiles.begin(), profiles.end(), [&](const AlarmProfile& other) {
+                    return to_lower_ascii(other.name) == to_lower_ascii(profile.name);
+                });
+                if (profile.name.empty() || duplicate) {
+                    std::cerr << "[WARNING] Skipping alarm profile with a missing or repeated name: \"" << profile.name << "\"" << std::endl;
+                    continue;
+                }
+                for (const auto& item : p.value("alarms", nlohmann::json::array())) {
+                    profile.alarm_ids.push_back(static_cast<uint32_t>(alarms.size()));
+                    alarms.push_back(item.get<LookoutAlarmConfig>());
                 }
+                profiles.push_back(std::move(profile));
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Could not parse alarm_profiles from settings.json: " << e.what() << std::endl;
+    }
+    return profiles;
+}
+
+// Position of the named profile (case-insensitive), or -1
+int find_alarm_profile(const std::vector<AlarmProfile>& profiles, const std::string& name) {
+    for (size_t k = 0; k < profiles.size(); ++k) {
+        if (to_lower_ascii(profiles[k].name) == to_lower_ascii(name)) return static_cast<int>(k);
+    }
+    return -1;
+}
+
+// Hotkey management functions
+bool parse_hotkey(const std::string& hotkey_str, UINT& modifiers, UINT& vk_code) {
+    modifiers = 0;
+    vk_code = 0;
+    
+    std::string key_str = hotkey_str;
+    std::transform(key_str.begin(), key_str.end(), key_str.begin(), ::tolower);
+    
+    // Parse modifiers
+    if (key_str.find("ctrl+") != std::string::npos) {
+        modifiers |= MOD_CONTROL;
+        key_str.erase(key_str.find("ctrl+"), 5);
+    }
+    if (key_str.find("shift+") != std::string::npos) {
+        modifiers |= MOD_SHIFT;
+        key_str.erase(key_str.find("shift+"), 6);
+    }
+    if (key_str.find("alt+") != std::string::npos) {
+        modifiers |= MOD_ALT;
+        key_str.erase(key_str.find("alt+"), 4);
+    }
+    
+    // Parse key codes: numpad digits, function keys, letters and digits
+    if (key_str.size() == 4 && key_str.compare(0, 3, "num") == 0 && key_str[3] >= '0' && key_str[3] <= '9') {
+        vk_code = 0x60 + (key_str[3] - '0');  // VK_NUMPAD0..9
+    } else if (key_str.size() >= 2 && key_str.size() <= 3 && key_str[0] == 'f' &&
+               std::all_of(key_str.begin() + 1, key_str.end(), ::isdigit)) {
+        int n = std::stoi(key_str.substr(1));
+        if (n < 1 || n > 24) return false;
+        vk_code = 0x70 + (n - 1);               // VK_F1..F24
+    } else if (key_str.length() == 1) {
+        char c = key_str[0];
+        if (c >= 'a' && c <= 'z') vk_code = 0x41 + (c - 'a');  // VK_A = 0x41
+        else if (c >= '0' && c <= '9') vk_code = 0x30 + (c - '0');  // VK_0 = 0x30
+        else return false;
+    } else {
+        return false;
+    }
+    
+    return vk_code != 0;
+}
+
+// Recenter from the hotkey or a bound HID button (input thread). Only queued: the
+// runtime call is made by the thread that owns the Oculus session.
+void request_recenter(const char* trigger) {
+    std::cout << "[INFO] Recenter " << trigger << " pressed" << std::endl;
+    post_core_command(CoreCommand::RECENTER);
+}
+
+// Run a hotkey command (input thread). Anything touching alarm state is only flagged
+// here and done by the core thread.
+void dispatch_hotkey(uint8_t command) {
+    switch (command) {
+    case HOTKEY_RECENTER:
+        request_recenter("hotkey");
+        break;
+    case HOTKEY_BASELINE_RESET:
+        post_core_command(CoreCommand::BASELINE_RESET);
+        std::cout << "[INFO] Baseline reset hotkey pressed - capturing current head position as forward" << std::endl;
+        break;
+    case HOTKEY_SNOOZE:
+        post_core_command(CoreCommand::SNOOZE);
+        std::cout << "[INFO] Snooze hotkey pressed" << std::endl;
+        break;
+    case HOTKEY_TOGGLE_DEBUG:
+        g_debug_logging = !g_debug_logging;
+        std::cout << "[INFO] Debug output " << (g_debug_logging ? "on" : "off") << std::endl;
+        break;
+    case HOTKEY_NEXT_PROFILE:
+        post_core_command(CoreCommand::NEXT_PROFILE);
+        break;
+    }
+}
+
+// Low-level keyboard hook procedure
+LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam) {
+    if (nCode >= 0 && (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN)) {
+        KBDLLHOOKSTRUCT* pKeyboard = (KBDLLHOOKSTRUCT*)lParam;
+        DWORD vk = pKeyboard->vkCode;
+        
+        // Check if any binding uses this key
+        if (vk < g_hotkey_key_bound.size() && g_hotkey_key_bound[vk]) {
+            // Check modifiers
+            UINT current_modifiers = 0;
+            if (GetAsyncKeyState(VK_CONTROL) & 0x8000) current_modifiers |= MOD_CONTROL;
+            if (GetAsyncKeyState(VK_SHIFT) & 0x8000) current_modifiers |= MOD_SHIFT;
+            if (GetAsyncKeyState(VK_MENU) & 0x8000) current_modifiers |= MOD_ALT;
+            
+            // Only trigger if modifiers match AND Condor simulation is active
+            uint8_t command = g_hotkey_table[vk][current_modifiers & 7];
+            if (command != HOTKEY_NONE && g_condor_sim_active.load(std::memory_order_relaxed)) {
+                dispatch_hotkey(command);
                 // Don't block the key - let it pass through to other applications
             }
         }
@@ -358,31 +1409,54 @@ LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam) {
     return CallNextHookEx(g_keyboard_hook, nCode, wParam, lParam);
 }
 
-bool register_recenter_hotkey(HWND hwnd) {
+bool register_hotkeys(HWND hwnd) {
     if (g_hotkey_registered) {
-        unregister_recenter_hotkey(hwnd);
+        unregister_hotkeys(hwnd);
     }
     
-    if (!parse_hotkey(g_recenter_hotkey, g_target_modifiers, g_target_vk_code)) {
-        std::cerr << "[WARNING] Invalid hotkey format: " << g_recenter_hotkey << std::endl;
-        return false;
+    // Build the dispatch table before the hook can see a key
+    g_hotkey_table = {};
+    g_hotkey_key_bound = {};
+    g_hotkey_bindings[HOTKEY_RECENTER] = g_recenter_hotkey;
+    int bound = 0;
+    for (int command = HOTKEY_RECENTER; command < HOTKEY_COMMAND_COUNT; ++command) {
+        const std::string& binding = g_hotkey_bindings[command];
+        if (binding.empty()) continue;
+        UINT modifiers = 0, vk_code = 0;
+        if (!parse_hotkey(binding, modifiers, vk_code) || vk_code >= g_hotkey_table.size()) {
+            std::cerr << "[WARNING] Invalid hotkey format for " << HOTKEY_COMMAND_NAMES[command] << ": " << binding << std::endl;
+            continue;
+        }
+        uint8_t& slot = g_hotkey_table[vk_code][modifiers & 7];
+        if (slot != HOTKEY_NONE) {
+            std::cerr << "[WARNING] Hotkey " << binding << " is already bound to " << HOTKEY_COMMAND_NAMES[slot]
+                      << "; ignoring it for " << HOTKEY_COMMAND_NAMES[command] << std::endl;
+            continue;
+        }
+        slot = static_cast<uint8_t>(command);
+        g_hotkey_key_bound[vk_code] = true;
+        ++bound;
     }
+    if (bound == 0) return false;
     
     // Install low-level keyboard hook (non-blocking)
     g_keyboard_hook = SetWindowsHookEx(WH_KEYBOARD_LL, LowLevelKeyboardProc, GetModuleHandle(NULL), 0);
     if (g_keyboard_hook) {
         g_hotkey_registered = true;
-        std::cout << "[INFO] Registered non-blocking recenter hotkey: " << g_recenter_hotkey << std::endl;
+        for (int command = HOTKEY_RECENTER; command < HOTKEY_COMMAND_COUNT; ++command) {
+            if (g_hotkey_bindings[command].empty()) continue;
+            std::cout << "[INFO] Registered non-blocking " << HOTKEY_COMMAND_NAMES[command] << " hotkey: "
+                      << g_hotkey_bindings[command] << std::endl;
+        }
         return true;
     } else {
         DWORD error = GetLastError();
-        std::cerr << "[WARNING] Failed to install keyboard hook for hotkey: " << g_recenter_hotkey 
-                  << " (error=" << error << ")" << std::endl;
+        std::cerr << "[WARNING] Failed to install keyboard hook for hotkeys (error=" << error << ")" << std::endl;
         return false;
     }
 }
 
-void unregister_recenter_hotkey(HWND hwnd) {
+void unregister_hotkeys(HWND hwnd) {
     if (g_hotkey_registered) {
         if (g_keyboard_hook) {
             UnhookWindowsHookEx(g_keyboard_hook);
@@ -392,495 +1466,9206 @@ void unregister_recenter_hotkey(HWND hwnd) {
     }
 }
 
-void load_hotkey_from_settings() {
-    std::ifstream f("settings.json");
-    if (!f) return;
-    
-    try {
-        nlohmann::json j;
-        f >> j;
-        
-        if (j.contains("recenter_hotkey") && j["recenter_hotkey"].is_string()) {
-            g_recenter_hotkey = j["recenter_hotkey"].get<std::string>();
-            std::cout << "[INFO] Loaded recenter hotkey: " << g_recenter_hotkey << std::endl;
+// Joystick / button box buttons that recenter ("recenter_buttons" in settings.json).
+// device is matched against the Raw Input device name (e.g. "VID_044F&PID_B10A",
+// case-insensitive); empty matches any game controller. Buttons are HID usage numbers,
+// 1-based, as shown by Windows' game controller panel.
+struct HidButtonBinding {
+    std::string device;
+    USAGE button = 0;
+};
+std::vector<HidButtonBinding> g_recenter_buttons; // Loaded before the input thread starts
+
+// Raw Input state of one HID device, created on its first report (input thread only)
+struct HidDeviceState {
+    bool bound = false;                 // Some binding applies to this device
+    std::vector<USAGE> buttons;         // Bound button usages on this device
+    std::vector<char> preparsed;        // HIDP_PREPARSED_DATA for HidP_GetUsages
+    std::vector<bool> was_down;         // Per entry of buttons; fire on the press edge only
+};
+std::unordered_map<HANDLE, HidDeviceState> g_hid_devices;
+HWND g_input_hwnd = nullptr; // Message-only window receiving WM_INPUT
+
+HidDeviceState& hid_device_state(HANDLE device) {
+    auto it = g_hid_devices.find(device);
+    if (it != g_hid_devices.end()) return it->second;
+    HidDeviceState& state = g_hid_devices[device];
+
+    char name[512] = "";
+    UINT name_size = sizeof(name);
+    if (GetRawInputDeviceInfoA(device, RIDI_DEVICENAME, name, &name_size) == static_cast<UINT>(-1)) return state;
+    std::string device_name = to_lower_ascii(name);
+    for (const auto& binding : g_recenter_buttons) {
+        if (binding.device.empty() || device_name.find(binding.device) != std::string::npos) {
+            state.buttons.push_back(binding.button);
         }
-    } catch (const std::exception& e) {
-        std::cerr << "[WARNING] Could not parse recenter_hotkey from settings.json: " << e.what() << std::endl;
     }
-}
+    if (state.buttons.empty()) return state;
 
-bool is_condor_process_running() {
-    HANDLE hProcessSnap = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-    if (hProcessSnap == INVALID_HANDLE_VALUE) {
-        return false;
-    }
-    
-    PROCESSENTRY32 pe32;
-    pe32.dwSize = sizeof(PROCESSENTRY32);
-    
-    if (!Process32First(hProcessSnap, &pe32)) {
-        CloseHandle(hProcessSnap);
-        return false;
+    UINT preparsed_size = 0;
+    GetRawInputDeviceInfoA(device, RIDI_PREPARSEDDATA, nullptr, &preparsed_size);
+    state.preparsed.resize(preparsed_size);
+    if (preparsed_size == 0 ||
+        GetRawInputDeviceInfoA(device, RIDI_PREPARSEDDATA, state.preparsed.data(), &preparsed_size) == static_cast<UINT>(-1)) {
+        return state;
     }
-    
-    bool condor_found = false;
-    do {
-        // Check for Condor.exe (case insensitive)
-        std::string processName = pe32.szExeFile;
-        std::transform(processName.begin(), processName.end(), processName.begin(), ::tolower);
-        
-        if (processName == "condor.exe" || processName == "condor3.exe") {
-            condor_found = true;
-            break;
-        }
-    } while (Process32Next(hProcessSnap, &pe32));
-    
-    CloseHandle(hProcessSnap);
-    return condor_found;
+    state.was_down.assign(state.buttons.size(), false);
+    state.bound = true;
+    std::cout << "[INFO] Recenter button binding active on " << name << std::endl;
+    return state;
 }
 
-// Structure to pass data to window enumeration callback
-struct WindowEnumData {
-    DWORD processId;
-    bool hasSimWindow;
-    std::string simWindowTitle;
-};
+void handle_raw_input(HRAWINPUT input) {
+    alignas(8) static char buffer[1024]; // Input thread only; HID reports are small
+    UINT size = sizeof(buffer);
+    if (GetRawInputData(input, RID_INPUT, buffer, &size, sizeof(RAWINPUTHEADER)) == static_cast<UINT>(-1)) return;
+    const RAWINPUT* raw = reinterpret_cast<const RAWINPUT*>(buffer);
+    if (raw->header.dwType != RIM_TYPEHID) return;
 
-// Callback function for EnumWindows
-BOOL CALLBACK EnumWindowsProc(HWND hwnd, LPARAM lParam) {
-    WindowEnumData* data = reinterpret_cast<WindowEnumData*>(lParam);
-    
-    DWORD windowProcessId;
-    GetWindowThreadProcessId(hwnd, &windowProcessId);
-    
-    // Only check windows from the Condor process
-    if (windowProcessId != data->processId) {
-        return TRUE; // Continue enumeration
-    }
-    
-    // Skip if window is not visible
-    if (!IsWindowVisible(hwnd)) {
-        return TRUE;
-    }
-    
-    // Get window title
-    char windowTitle[256];
-    if (GetWindowTextA(hwnd, windowTitle, sizeof(windowTitle)) == 0) {
-        return TRUE; // Continue if no title
-    }
-    
-    std::string title = windowTitle;
-    std::transform(title.begin(), title.end(), title.begin(), ::tolower);
-    
-    // Look for simulation window characteristics:
-    // - Contains "condor" and version info (like "condor version 3.0.8")
-    // - Has substantial size (simulation windows are typically large)
-    // - Exclude obvious setup/menu windows
-    if (title.find("condor") != std::string::npos && 
-        title.find("version") != std::string::npos) {
-        
-        // Check window size to distinguish sim window from small dialogs
-        RECT rect;
-        if (GetWindowRect(hwnd, &rect)) {
-            int width = rect.right - rect.left;
-            int height = rect.bottom - rect.top;
-            
-            // Simulation windows are typically large (>= 800x600)
-            if (width >= 800 && height >= 600) {
-                data->hasSimWindow = true;
-                data->simWindowTitle = windowTitle;
-                return FALSE; // Stop enumeration, found what we need
+    HidDeviceState& device = hid_device_state(raw->header.hDevice);
+    if (!device.bound) return;
+    auto preparsed = reinterpret_cast<PHIDP_PREPARSED_DATA>(device.preparsed.data());
+    for (DWORD r = 0; r < raw->data.hid.dwCount; ++r) {
+        char* report = const_cast<char*>(reinterpret_cast<const char*>(raw->data.hid.bRawData)) + r * raw->data.hid.dwSizeHid;
+        USAGE pressed[128];
+        ULONG pressed_count = 128;
+        if (HidP_GetUsages(HidP_Input, HID_USAGE_PAGE_BUTTON, 0, pressed, &pressed_count, preparsed, report,
+                           raw->data.hid.dwSizeHid) != HIDP_STATUS_SUCCESS) {
+            continue; // Report without buttons (e.g. axes only)
+        }
+        for (size_t b = 0; b < device.buttons.size(); ++b) {
+            bool down = std::find(pressed, pressed + pressed_count, device.buttons[b]) != pressed + pressed_count;
+            if (down && !device.was_down[b] && g_condor_sim_active.load(std::memory_order_relaxed)) {
+                request_recenter("button");
             }
+            device.was_down[b] = down;
         }
     }
-    
-    return TRUE; // Continue enumeration
 }
 
-// Debug callback to log all Condor-related windows
-BOOL CALLBACK FindCondorWindowProc(HWND hwnd, LPARAM lParam) {
-    char windowTitle[256];
-    char className[256];
-    wchar_t displayName[256];
-    
-    // Get window title and class name
-    GetWindowTextA(hwnd, windowTitle, sizeof(windowTitle));
-    GetClassNameA(hwnd, className, sizeof(className));
-    
-    // Try to get the display name (what taskbar shows)
-    std::string display_title;
-    if (GetWindowTextW(hwnd, displayName, sizeof(displayName)/sizeof(wchar_t))) {
-        // Convert wide string to regular string
-        int size = WideCharToMultiByte(CP_UTF8, 0, displayName, -1, nullptr, 0, nullptr, nullptr);
-        if (size > 0) {
-            std::vector<char> buffer(size);
-            WideCharToMultiByte(CP_UTF8, 0, displayName, -1, buffer.data(), size, nullptr, nullptr);
-            display_title = buffer.data();
-        }
+LRESULT CALLBACK InputWindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
+    if (uMsg == WM_INPUT) {
+        handle_raw_input(reinterpret_cast<HRAWINPUT>(lParam));
+    } else if (uMsg == WM_INPUT_DEVICE_CHANGE && wParam == GIDC_REMOVAL) {
+        g_hid_devices.erase(reinterpret_cast<HANDLE>(lParam)); // Handles can be reused for another device
     }
-    
-    std::string title = windowTitle;
-    std::string class_name = className;
-    std::string title_lower = title;
-    std::transform(title_lower.begin(), title_lower.end(), title_lower.begin(), ::tolower);
-    
-    // Log any window that contains "condor" for debugging (even empty titles if class matches)
-    bool isCondorRelated = (title_lower.find("condor") != std::string::npos) || 
-                          (class_name.find("Condor") != std::string::npos);
-    
-    if (isCondorRelated && IsWindowVisible(hwnd)) {
-        RECT rect;
-        if (GetWindowRect(hwnd, &rect)) {
-            int width = rect.right - rect.left;
-            int height = rect.bottom - rect.top;
-            
-            // Look for simulation window - use class name for reliable detection
-            if (title_lower.find("condor") != std::string::npos && 
-                title_lower.find("version") != std::string::npos) {
-                // Simulation window has main window class (not TGUIForm or TApplication)
-                if (class_name != "TGUIForm" && class_name != "TApplication" && width > 100 && height > 100) {
-                    *reinterpret_cast<bool*>(lParam) = true;
-                    return FALSE; // Stop enumeration
-                }
-            }
-        }
+    return DefWindowProc(hwnd, uMsg, wParam, lParam); // Also releases WM_INPUT data
+}
+
+// Register for game controller reports on a message-only window. INPUTSINK delivers
+// them while Condor has the focus; the OS pushes each report, nothing is polled.
+bool register_recenter_buttons() {
+    if (g_recenter_buttons.empty()) return false;
+    WNDCLASSEX wc = {0};
+    wc.cbSize = sizeof(WNDCLASSEX);
+    wc.lpfnWndProc = InputWindowProc;
+    wc.hInstance = GetModuleHandle(NULL);
+    wc.lpszClassName = "QuestLookoutInputWindow";
+    RegisterClassEx(&wc);
+    g_input_hwnd = CreateWindowEx(0, wc.lpszClassName, "", 0, 0, 0, 0, 0, HWND_MESSAGE, NULL, wc.hInstance, NULL);
+    if (!g_input_hwnd) {
+        std::cerr << "[WARNING] Could not create input window for recenter buttons (error=" << GetLastError() << ")" << std::endl;
+        return false;
     }
-    return TRUE; // Continue enumeration
+    RAWINPUTDEVICE devices[3] = {
+        { HID_USAGE_PAGE_GENERIC, HID_USAGE_GENERIC_JOYSTICK, RIDEV_INPUTSINK | RIDEV_DEVNOTIFY, g_input_hwnd },
+        { HID_USAGE_PAGE_GENERIC, HID_USAGE_GENERIC_GAMEPAD, RIDEV_INPUTSINK | RIDEV_DEVNOTIFY, g_input_hwnd },
+        { HID_USAGE_PAGE_GENERIC, HID_USAGE_GENERIC_MULTI_AXIS_CONTROLLER, RIDEV_INPUTSINK | RIDEV_DEVNOTIFY, g_input_hwnd },
+    };
+    if (!RegisterRawInputDevices(devices, 3, sizeof(RAWINPUTDEVICE))) {
+        std::cerr << "[WARNING] Could not register for joystick input (error=" << GetLastError() << ")" << std::endl;
+        DestroyWindow(g_input_hwnd);
+        g_input_hwnd = nullptr;
+        return false;
+    }
+    std::cout << "[INFO] Listening for " << g_recenter_buttons.size() << " recenter button binding(s)" << std::endl;
+    return true;
 }
 
-bool is_condor_simulation_window_active() {
-    bool found = false;
-    EnumWindows(FindCondorWindowProc, reinterpret_cast<LPARAM>(&found));
-    return found;
+void unregister_recenter_buttons() {
+    if (!g_input_hwnd) return;
+    RAWINPUTDEVICE devices[3] = {
+        { HID_USAGE_PAGE_GENERIC, HID_USAGE_GENERIC_JOYSTICK, RIDEV_REMOVE, nullptr },
+        { HID_USAGE_PAGE_GENERIC, HID_USAGE_GENERIC_GAMEPAD, RIDEV_REMOVE, nullptr },
+        { HID_USAGE_PAGE_GENERIC, HID_USAGE_GENERIC_MULTI_AXIS_CONTROLLER, RIDEV_REMOVE, nullptr },
+    };
+    RegisterRawInputDevices(devices, 3, sizeof(RAWINPUTDEVICE));
+    DestroyWindow(g_input_hwnd);
+    g_input_hwnd = nullptr;
+    g_hid_devices.clear();
 }
 
-sf::Music* get_or_create_sound_player(const std::string& audio_file) {
-    std::string file_to_play = audio_file.empty() ? "beep.wav" : audio_file;
-    
-    // Try to create the music object with proper error handling
-    auto music = std::make_unique<sf::Music>();
-    
+// Input thread: owns the low-level keyboard hook and does nothing but pump messages.
+// Hook callbacks run on the installing thread's message loop, so on the GUI thread an
+// open tray menu or a blocking ShellExecute would stall every keystroke on the PC.
+// Recenter requests are handed to the core thread through its wake event. Joystick
+// button bindings arrive here too, as Raw Input on a message-only window.
+void input_thread_main(HANDLE ready_event) {
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+    MSG msg;
+    PeekMessage(&msg, NULL, WM_USER, WM_USER, PM_NOREMOVE); // Create the queue before anyone posts to it
+    g_input_thread_id = GetCurrentThreadId();
+    const int64_t hooks_start_us = monotonic_now_us();
+    register_hotkeys(nullptr);
+    register_recenter_buttons();
+    record_startup_phase(STARTUP_HOTKEYS, hooks_start_us);
+    SetEvent(ready_event);
+
+    while (GetMessage(&msg, NULL, 0, 0) > 0) {
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+    }
+    unregister_recenter_buttons();
+    unregister_hotkeys(nullptr);
+}
+
+// Hotkeys and recenter buttons ("recenter_hotkey", "hotkeys", "recenter_buttons")
+struct HotkeySettings {
+    std::string recenter_hotkey = "Num5";
+    std::array<std::string, HOTKEY_COMMAND_COUNT> bindings;
+    double snooze_seconds = 120.0;
+    std::vector<HidButtonBinding> recenter_buttons;
+};
+
+HotkeySettings load_hotkey_settings(const nlohmann::json& j) {
+    HotkeySettings cfg;
     try {
-        // First try the specified file
-        if (!music->openFromFile(file_to_play)) {
-            std::cerr << "[ERROR] Could not load music file: " << file_to_play << std::endl;
-            
-            // If not the default, try beep.wav as fallback
-            if (file_to_play != "beep.wav") {
-                std::cerr << "[INFO] Attempting to load default beep.wav" << std::endl;
-                if (!music->openFromFile("beep.wav")) {
-                    std::cerr << "[ERROR] Could not load default music file: beep.wav" << std::endl;
-                    return nullptr;
-                }
-            } else {
-                return nullptr;
+        if (j.contains("recenter_hotkey") && j["recenter_hotkey"].is_string()) {
+            cfg.recenter_hotkey = j["recenter_hotkey"].get<std::string>();
+            std::cout << "[INFO] Loaded recenter hotkey: " << cfg.recenter_hotkey << std::endl;
+        }
+        if (j.contains("hotkeys") && j["hotkeys"].is_object()) {
+            const nlohmann::json& h = j["hotkeys"];
+            for (int command = HOTKEY_RECENTER; command < HOTKEY_COMMAND_COUNT; ++command) {
+                if (!h.contains(HOTKEY_COMMAND_NAMES[command]) || !h[HOTKEY_COMMAND_NAMES[command]].is_string()) continue;
+                cfg.bindings[command] = h[HOTKEY_COMMAND_NAMES[command]].get<std::string>();
+            }
+            // recenter_hotkey stays the recenter binding; hotkeys.recenter overrides it
+            if (!cfg.bindings[HOTKEY_RECENTER].empty()) cfg.recenter_hotkey = cfg.bindings[HOTKEY_RECENTER];
+            cfg.snooze_seconds = (std::max)(1.0, h.value("snooze_seconds", cfg.snooze_seconds));
+        }
+        if (j.contains("recenter_buttons") && j["recenter_buttons"].is_array()) {
+            for (const auto& b : j["recenter_buttons"]) {
+                HidButtonBinding binding;
+                binding.device = to_lower_ascii(b.value("device", std::string()));
+                int button = b.value("button", 0);
+                if (button < 1 || button > 0xFFFF) continue;
+                binding.button = static_cast<USAGE>(button);
+                cfg.recenter_buttons.push_back(binding);
             }
         }
-        
-        // Test if we can actually play the audio (this will catch driver issues)
-        music->setVolume(0); // Silent test
-        music->play();
-        music->stop();
-        
-        std::cout << "[INFO] Successfully loaded and tested audio file: " << file_to_play << std::endl;
-        
     } catch (const std::exception& e) {
-        std::cerr << "[ERROR] Exception in audio system: " << e.what() << std::endl;
-        return nullptr;
-    } catch (...) {
-        std::cerr << "[ERROR] Unknown exception in audio system" << std::endl;
-        return nullptr;
+        std::cerr << "[WARNING] Could not parse recenter_hotkey from settings.json: " << e.what() << std::endl;
     }
-    
-    // Return properly managed resource - no intentional leak
-    return music.release();
+    return cfg;
 }
 
-// Defines for tray icon
-#define WM_APP_TRAYMSG (WM_APP + 1)
-#define ID_TRAY_APP_ICON 1001
-#define ID_TRAY_EXIT_CONTEXT_MENU_ITEM 1002
-#define ID_TRAY_TOGGLE_CONSOLE_ITEM 1003
-#define ID_TRAY_SETTINGS_ITEM 1004
+// Hand the bindings to the hotkey globals; before the input thread starts
+void apply_hotkey_settings(const HotkeySettings& cfg) {
+    g_recenter_hotkey = cfg.recenter_hotkey;
+    g_hotkey_bindings = cfg.bindings;
+    g_snooze_seconds = cfg.snooze_seconds;
+    g_recenter_buttons = cfg.recenter_buttons;
+}
 
-const char* const WINDOW_CLASS_NAME = "QuestLookoutWindowClass";
-HWND g_hwnd;
-NOTIFYICONDATA nidApp;
-bool g_is_console_visible = false;
+// Still-head poll rate the CPU governor (CpuGovernor) holds the samplers to on its last
+// step; 0 while it isn't
+std::atomic<double> g_sampling_floor_hz{0.0};
 
-// Forward declaration for our core application logic
-int app_core_logic(); 
+// Adaptive sampling: the tracking poll rate follows head angular velocity,
+// from min_rate_hz while the head is still up to max_rate_hz during fast scans.
+struct SamplingConfig {
+    bool adaptive = false;
+    double min_rate_hz = 5.0;
+    double max_rate_hz = 200.0;
+    double still_velocity_deg_s = 10.0;  // At or below this speed we poll at min_rate_hz
+    double fast_velocity_deg_s = 120.0;  // At or above this speed we poll at max_rate_hz
+    bool deadline_scheduling = false;    // Wake for the earliest alarm deadline instead of ticking every alarm
+    bool measured_pose = false;          // Latest measured pose, stamped with its sensor time, instead of a prediction
+    bool interpolate_peaks = false;      // Use angular velocity to estimate turning points between samples
+    bool burst = false;                  // Sample at burst_rate_hz during fast head flicks
+    double burst_rate_hz = 500.0;
+    double burst_trigger_yaw_deg_s = 90.0; // Yaw speed that starts a burst
+    double burst_hold_ms = 300.0;          // Stay in burst this long after the yaw speed drops
+    double fixed_step_ms = 0.0;            // > 0: engine time in whole steps from sample timestamps only
+    std::string mmcss_task;                // MMCSS task for the sampling thread ("Games", "Pro Audio"); empty: none
+    AVRT_PRIORITY mmcss_priority = AVRT_PRIORITY_NORMAL;
+    double session_status_hz = 4.0;        // ovr_GetSessionStatus polls; tracking ticks in between reuse the last one
+    bool drift_correction = false;         // Follow the pilot's neutral forward yaw (YawDriftCorrector)
+    double drift_window_deg = 30.0;        // Only samples this close to forward are taken as neutral
+    double drift_estimate_s = 120.0;       // Each median covers this long
+    double drift_max_rate_deg_per_min = 1.0;
+    double drift_max_deg = 15.0;           // Largest total correction
+    double perf_stats_hz = 1.0;            // ovr_GetPerfStats polls (RenderPerf); 0: never
 
-// Console Management Functions
-void ShowConsoleWindow()
-{
-    if (!g_is_console_visible)
-    {
-        if (AllocConsole())
-        {
-            FILE* fp_stdout, *fp_stderr, *fp_stdin;
-            if (_wfreopen_s(&fp_stdout, L"CONOUT$", L"w", stdout) != 0 ||
-                _wfreopen_s(&fp_stderr, L"CONOUT$", L"w", stderr) != 0 ||
-                _wfreopen_s(&fp_stdin, L"CONIN$", L"r", stdin) != 0)
-            {
-                FreeConsole(); 
-                return;
-            }
-            std::cout.clear();
-            std::cerr.clear();
-            std::cin.clear(); 
-            SetConsoleTitleA("Quest Lookout Status"); 
-            g_is_console_visible = true;
-            std::cout << "[INFO] Status window opened." << std::endl; 
+    // Fastest rate the sampler polls at: bursts, the adaptive maximum, or POLL_INTERVAL
+    double peak_rate_hz() const {
+        return (std::max)(burst ? burst_rate_hz : 0.0, adaptive ? max_rate_hz : 1.0 / POLL_INTERVAL);
+    }
+
+    // Poll period (seconds) for the given head angular speed
+    double period_for_velocity(double speed_deg_s) const {
+        double t = 0.0;
+        if (fast_velocity_deg_s > still_velocity_deg_s) {
+            t = (speed_deg_s - still_velocity_deg_s) / (fast_velocity_deg_s - still_velocity_deg_s);
+        } else if (speed_deg_s > still_velocity_deg_s) {
+            t = 1.0;
         }
+        t = (std::max)(0.0, (std::min)(1.0, t));
+        return 1.0 / (min_rate_hz + t * (max_rate_hz - min_rate_hz));
     }
-}
 
-void HideConsoleWindow()
-{
-    if (g_is_console_visible)
-    {
-        std::cin.clear();
-        
-        FILE* fp_nul_stdout, *fp_nul_stderr, *fp_nul_stdin;
-        _wfreopen_s(&fp_nul_stdout, L"NUL", L"w", stdout);
-        _wfreopen_s(&fp_nul_stderr, L"NUL", L"w", stderr);
-        _wfreopen_s(&fp_nul_stdin, L"NUL", L"r", stdin);
+    // Sampler poll period: adaptive or POLL_INTERVAL, stretched to g_sampling_floor_hz
+    // while the head is still. Burst sampling still shortens it on top.
+    double poll_period(double speed_deg_s) const {
+        double period = adaptive ? period_for_velocity(speed_deg_s) : POLL_INTERVAL;
+        const double floor_hz = g_sampling_floor_hz.load(std::memory_order_relaxed);
+        if (floor_hz > 0.0 && speed_deg_s <= still_velocity_deg_s) period = (std::max)(period, 1.0 / floor_hz);
+        return period;
+    }
+};
 
-        if (FreeConsole())
-        {
-            g_is_console_visible = false;
+SamplingConfig load_sampling_settings(const nlohmann::json& j) {
+    SamplingConfig cfg;
+    try {
+        if (j.contains("sampling") && j["sampling"].is_object()) {
+            const nlohmann::json& s = j["sampling"];
+            cfg.adaptive = s.value("adaptive", cfg.adaptive);
+            cfg.min_rate_hz = s.value("min_rate_hz", cfg.min_rate_hz);
+            cfg.max_rate_hz = s.value("max_rate_hz", cfg.max_rate_hz);
+            cfg.still_velocity_deg_s = s.value("still_velocity_deg_s", cfg.still_velocity_deg_s);
+            cfg.fast_velocity_deg_s = s.value("fast_velocity_deg_s", cfg.fast_velocity_deg_s);
+            cfg.deadline_scheduling = s.value("deadline_scheduling", cfg.deadline_scheduling);
+            cfg.measured_pose = s.value("measured_pose", cfg.measured_pose);
+            cfg.interpolate_peaks = s.value("interpolate_peaks", cfg.interpolate_peaks);
+            cfg.burst = s.value("burst", cfg.burst);
+            cfg.burst_rate_hz = s.value("burst_rate_hz", cfg.burst_rate_hz);
+            cfg.burst_trigger_yaw_deg_s = s.value("burst_trigger_yaw_deg_s", cfg.burst_trigger_yaw_deg_s);
+            cfg.burst_hold_ms = s.value("burst_hold_ms", cfg.burst_hold_ms);
+            cfg.fixed_step_ms = (std::max)(0.0, s.value("fixed_step_ms", cfg.fixed_step_ms));
+            cfg.mmcss_task = s.value("mmcss_task", cfg.mmcss_task);
+            cfg.session_status_hz = s.value("session_status_hz", cfg.session_status_hz);
+            cfg.drift_correction = s.value("drift_correction", cfg.drift_correction);
+            cfg.drift_window_deg = s.value("drift_window_deg", cfg.drift_window_deg);
+            cfg.drift_estimate_s = s.value("drift_estimate_s", cfg.drift_estimate_s);
+            cfg.drift_max_rate_deg_per_min = s.value("drift_max_rate_deg_per_min", cfg.drift_max_rate_deg_per_min);
+            cfg.drift_max_deg = s.value("drift_max_deg", cfg.drift_max_deg);
+            cfg.perf_stats_hz = s.value("perf_stats_hz", cfg.perf_stats_hz);
+            const std::string priority = to_lower_ascii(s.value("mmcss_priority", std::string("normal")));
+            if (priority == "low") cfg.mmcss_priority = AVRT_PRIORITY_LOW;
+            else if (priority == "high") cfg.mmcss_priority = AVRT_PRIORITY_HIGH;
+            else if (priority != "normal") std::cerr << "[WARNING] Unknown sampling.mmcss_priority \"" << priority << "\"; using normal" << std::endl;
         }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Could not parse sampling from settings.json: " << e.what() << std::endl;
+    }
+
+    if (cfg.min_rate_hz < 1.0) cfg.min_rate_hz = 1.0;
+    if (cfg.max_rate_hz < cfg.min_rate_hz) cfg.max_rate_hz = cfg.min_rate_hz;
+    if (cfg.adaptive) {
+        std::cout << "[INFO] Adaptive sampling: " << cfg.min_rate_hz << "-" << cfg.max_rate_hz << " Hz ("
+                  << cfg.still_velocity_deg_s << "-" << cfg.fast_velocity_deg_s << " deg/s)" << std::endl;
     }
+    if (cfg.fixed_step_ms > 0.0) {
+        std::cout << "[INFO] Fixed-step engine: " << cfg.fixed_step_ms << " ms steps from sample timestamps" << std::endl;
+    }
+    if (cfg.measured_pose) {
+        std::cout << "[INFO] Using measured head pose with sensor timestamps (no display-time prediction)" << std::endl;
+    }
+    if (cfg.interpolate_peaks) {
+        std::cout << "[INFO] Interpolating lookout peaks from head angular velocity" << std::endl;
+    }
+    if (cfg.session_status_hz < 1.0) cfg.session_status_hz = 1.0;
+    cfg.drift_window_deg = (std::max)(1.0, (std::min)(90.0, cfg.drift_window_deg));
+    cfg.drift_estimate_s = (std::max)(10.0, cfg.drift_estimate_s);
+    cfg.drift_max_rate_deg_per_min = (std::max)(0.0, cfg.drift_max_rate_deg_per_min);
+    cfg.drift_max_deg = (std::max)(0.0, (std::min)(45.0, cfg.drift_max_deg));
+    cfg.perf_stats_hz = (std::max)(0.0, (std::min)(10.0, cfg.perf_stats_hz));
+    if (cfg.drift_correction) {
+        std::cout << "[INFO] Yaw drift correction: neutral forward from the median yaw within " << cfg.drift_window_deg
+                  << " deg, up to " << cfg.drift_max_rate_deg_per_min << " deg/min and " << cfg.drift_max_deg << " deg in total"
+                  << std::endl;
+    }
+    if (cfg.burst_rate_hz > 1000.0) cfg.burst_rate_hz = 1000.0;
+    if (cfg.burst_rate_hz < cfg.max_rate_hz) cfg.burst_rate_hz = cfg.max_rate_hz;
+    if (cfg.burst) {
+        std::cout << "[INFO] Burst sampling: " << cfg.burst_rate_hz << " Hz above " << cfg.burst_trigger_yaw_deg_s
+                  << " deg/s yaw, hold " << cfg.burst_hold_ms << " ms" << std::endl;
+    }
+    if (cfg.deadline_scheduling) {
+        std::cout << "[INFO] Deadline scheduling enabled: alarm timers wake the loop only when due" << std::endl;
+    }
+    return cfg;
 }
 
-// Window Procedure
-LRESULT CALLBACK WndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
+// Registers the calling thread with the Multimedia Class Scheduler Service for its
+// lifetime (sampling.mmcss_task). MMCSS runs the thread in the task's realtime band for
+// most of each scheduling period, so the sampler still wakes on time when the sim and
+// the compositor load every core; it is one short-running thread, so the sim loses
+// next to nothing. Only the sampling thread registers, never the whole process.
+class MmcssRegistration {
+public:
+    MmcssRegistration(const std::string& task, AVRT_PRIORITY priority) {
+        if (task.empty()) return;
+        DWORD task_index = 0;
+        handle_ = AvSetMmThreadCharacteristicsA(task.c_str(), &task_index);
+        if (!handle_) {
+            std::cerr << "[WARNING] Could not register the sampling thread with MMCSS task \"" << task
+                      << "\" (error " << GetLastError() << ")" << std::endl;
+            return;
+        }
+        if (!AvSetMmThreadPriority(handle_, priority)) {
+            std::cerr << "[WARNING] Could not set the MMCSS priority (error " << GetLastError() << ")" << std::endl;
+        }
+        std::cout << "[INFO] Sampling thread registered with MMCSS task \"" << task << "\"" << std::endl;
+    }
+
+    ~MmcssRegistration() {
+        if (handle_) AvRevertMmThreadCharacteristics(handle_);
+    }
+
+    MmcssRegistration(const MmcssRegistration&) = delete;
+    MmcssRegistration& operator=(const MmcssRegistration&) = delete;
+
+private:
+    HANDLE handle_ = nullptr;
+};
+
+// Optional smoothing of head yaw/pitch before the alarm thresholds, so tracking jitter
+// at the edge of a threshold doesn't flip lookout flags on and off.
+struct FilterConfig {
+    bool enabled = false;
+    double min_cutoff_hz = 1.0;        // Cutoff while the head is still; lower is smoother
+    double beta = 0.05;                // Cutoff increase per deg/s of head speed; higher lags less
+    double derivative_cutoff_hz = 1.0; // Smoothing of the speed estimate itself
+};
+
+FilterConfig load_filter_settings(const nlohmann::json& j) {
+    FilterConfig cfg;
+    try {
+        if (j.contains("filter") && j["filter"].is_object()) {
+            const nlohmann::json& s = j["filter"];
+            cfg.enabled = s.value("enabled", cfg.enabled);
+            cfg.min_cutoff_hz = s.value("min_cutoff_hz", cfg.min_cutoff_hz);
+            cfg.beta = s.value("beta", cfg.beta);
+            cfg.derivative_cutoff_hz = s.value("derivative_cutoff_hz", cfg.derivative_cutoff_hz);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Could not parse filter from settings.json: " << e.what() << std::endl;
+    }
+
+    if (cfg.min_cutoff_hz < 0.01) cfg.min_cutoff_hz = 0.01;
+    if (cfg.derivative_cutoff_hz < 0.01) cfg.derivative_cutoff_hz = 0.01;
+    if (cfg.beta < 0.0) cfg.beta = 0.0;
+    if (cfg.enabled) {
+        std::cout << "[INFO] Yaw/pitch filter: one-euro, min cutoff " << cfg.min_cutoff_hz << " Hz, beta "
+                  << cfg.beta << ", derivative cutoff " << cfg.derivative_cutoff_hz << " Hz" << std::endl;
+    }
+    return cfg;
+}
+
+struct WatchdogConfig {
+    bool enabled = true;
+    double overrun_factor = 2.0;      // Warn when a tick's work or period exceeds this multiple of the poll period
+    double report_interval_s = 60.0;  // How often the timing summary is printed to the status window
+};
+
+WatchdogConfig load_watchdog_settings(const nlohmann::json& j) {
+    WatchdogConfig cfg;
+    try {
+        if (j.contains("watchdog") && j["watchdog"].is_object()) {
+            const nlohmann::json& w = j["watchdog"];
+            cfg.enabled = w.value("enabled", cfg.enabled);
+            cfg.overrun_factor = w.value("overrun_factor", cfg.overrun_factor);
+            cfg.report_interval_s = w.value("report_interval_s", cfg.report_interval_s);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Could not parse watchdog from settings.json: " << e.what() << std::endl;
+    }
+
+    if (cfg.overrun_factor < 1.0) cfg.overrun_factor = 1.0;
+    if (cfg.report_interval_s < 1.0) cfg.report_interval_s = 1.0;
+    return cfg;
+}
+
+// Alarm state kept across a headset disconnect, and optionally a restart ("resume"),
+// so a Link cable hiccup or a lookout restart mid-flight doesn't hand the pilot a fresh
+// no-look period
+struct ResumeConfig {
+    double reconnect_grace_s = 120.0; // Session back within this: every alarm carries on where it was; 0 to start over
+    bool persist = false;             // Also keep the state in `file` while flying, for the next lookout.exe
+    double restart_grace_s = 300.0;   // A saved state older than this isn't restored
+    std::string file = "engine_state.qles";
+};
+
+ResumeConfig load_resume_settings(const nlohmann::json& j) {
+    ResumeConfig cfg;
+    try {
+        if (j.contains("resume") && j["resume"].is_object()) {
+            const nlohmann::json& r = j["resume"];
+            cfg.reconnect_grace_s = (std::max)(0.0, r.value("reconnect_grace_s", cfg.reconnect_grace_s));
+            cfg.persist = r.value("persist", cfg.persist);
+            cfg.restart_grace_s = (std::max)(0.0, r.value("restart_grace_s", cfg.restart_grace_s));
+            cfg.file = r.value("file", cfg.file);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Could not parse resume from settings.json: " << e.what() << std::endl;
+    }
+    return cfg;
+}
+
+// Where head poses come from: the live headset (LibOVR or OpenXR), a recorded CSV file, or a generated scan
+// pattern. Replay and synthetic sources run the alarm engine at full speed with no
+// headset attached.
+enum PoseSourceType { POSE_SOURCE_LIVE, POSE_SOURCE_OPENXR, POSE_SOURCE_REPLAY, POSE_SOURCE_SYNTHETIC };
+
+struct PoseSourceConfig {
+    PoseSourceType type = POSE_SOURCE_LIVE;
+    std::string replay_file = "pose_replay.csv";
+    SyntheticMotionConfig synthetic;        // The synthetic_* keys
+    bool lazy_init = false;                 // Connect to the headset runtime only once a flight starts
+    double release_after_flight_s = 300.0;  // With lazy_init, disconnect this long after a flight ends
+    std::string events_file;                // Every engine event written here as CSV, to diff against a golden run
+    bool eye_gaze = false;                  // OpenXR: look direction = head x eye gaze where the runtime tracks the eyes
+};
+
+PoseSourceConfig load_pose_source_settings(const nlohmann::json& j) {
+    PoseSourceConfig cfg;
+    try {
+        if (j.contains("pose_source") && j["pose_source"].is_object()) {
+            const nlohmann::json& p = j["pose_source"];
+            std::string type = p.value("type", std::string("live"));
+            if (type == "openxr") {
+                cfg.type = POSE_SOURCE_OPENXR;
+            } else if (type == "replay") {
+                cfg.type = POSE_SOURCE_REPLAY;
+            } else if (type == "synthetic") {
+                cfg.type = POSE_SOURCE_SYNTHETIC;
+            } else if (type != "live") {
+                std::cerr << "[WARNING] Unknown pose_source type '" << type << "', using live headset" << std::endl;
+            }
+            cfg.replay_file = p.value("replay_file", cfg.replay_file);
+            SyntheticMotionConfig& s = cfg.synthetic;
+            std::string pattern = p.value("synthetic_pattern", std::string(synthetic_pattern_name(s.pattern)));
+            if (!parse_synthetic_pattern(pattern, s.pattern)) {
+                std::cerr << "[WARNING] Unknown synthetic_pattern '" << pattern << "', using sweep" << std::endl;
+            }
+            s.rate_hz = p.value("synthetic_rate_hz", s.rate_hz);
+            s.duration_s = p.value("synthetic_duration_s", s.duration_s);
+            s.scan_period_s = p.value("synthetic_scan_period_s", s.scan_period_s);
+            s.yaw_amplitude_deg = p.value("synthetic_yaw_amplitude_deg", s.yaw_amplitude_deg);
+            s.pitch_amplitude_deg = p.value("synthetic_pitch_amplitude_deg", s.pitch_amplitude_deg);
+            s.flick_s = p.value("synthetic_flick_s", s.flick_s);
+            s.noise_deg = p.value("synthetic_noise_deg", s.noise_deg);
+            s.drift_deg_per_min = p.value("synthetic_drift_deg_per_min", s.drift_deg_per_min);
+            s.dropouts_per_hour = p.value("synthetic_dropouts_per_hour", s.dropouts_per_hour);
+            s.dropout_s = p.value("synthetic_dropout_s", s.dropout_s);
+            s.unmounts_per_hour = p.value("synthetic_unmounts_per_hour", s.unmounts_per_hour);
+            s.unmount_s = p.value("synthetic_unmount_s", s.unmount_s);
+            s.seed = p.value("synthetic_seed", s.seed);
+            cfg.lazy_init = p.value("lazy_init", cfg.lazy_init);
+            cfg.release_after_flight_s = p.value("release_after_flight_s", cfg.release_after_flight_s);
+            cfg.events_file = p.value("events_file", cfg.events_file);
+            cfg.eye_gaze = p.value("eye_gaze", cfg.eye_gaze);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Could not parse pose_source from settings.json: " << e.what() << std::endl;
+    }
+
+    clamp_synthetic_motion_config(cfg.synthetic);
+    if (cfg.release_after_flight_s < 0.0) cfg.release_after_flight_s = 0.0;
+    if (cfg.lazy_init) {
+        std::cout << "[INFO] Lazy headset init: connecting only during Condor flights, releasing "
+                  << cfg.release_after_flight_s << " s after a flight ends" << std::endl;
+    }
+    return cfg;
+}
+
+// "scan_overlay" in settings.json: a small quad in the headset showing the directions
+// the most urgent alarm is still waiting for. Needs the live (LibOVR) pose source,
+// whose session then becomes a visible one.
+struct ScanOverlayConfig {
+    bool enabled = false;
+    bool head_locked = true;         // false: fixed in the cockpit, ahead of the tracking origin
+    double distance_m = 1.0;
+    double size_m = 0.12;            // Width and height of the quad
+    double offset_x_m = 0.0;         // Right of the view center
+    double offset_y_m = -0.3;        // Above the view center; below by default, clear of the horizon
+    double opacity = 0.8;
+};
+
+ScanOverlayConfig load_scan_overlay_settings(const nlohmann::json& j) {
+    ScanOverlayConfig cfg;
+    try {
+        if (j.contains("scan_overlay") && j["scan_overlay"].is_object()) {
+            const nlohmann::json& o = j["scan_overlay"];
+            cfg.enabled = o.value("enabled", cfg.enabled);
+            cfg.head_locked = o.value("head_locked", cfg.head_locked);
+            cfg.distance_m = (std::max)(0.2, (std::min)(10.0, o.value("distance_m", cfg.distance_m)));
+            cfg.size_m = (std::max)(0.01, (std::min)(2.0, o.value("size_m", cfg.size_m)));
+            cfg.offset_x_m = o.value("offset_x_m", cfg.offset_x_m);
+            cfg.offset_y_m = o.value("offset_y_m", cfg.offset_y_m);
+            cfg.opacity = (std::max)(0.0, (std::min)(1.0, o.value("opacity", cfg.opacity)));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Could not parse scan_overlay from settings.json: " << e.what() << std::endl;
+    }
+    return cfg;
+}
+
+// Flight detection profile for one simulator. A top-level window is that sim's flight
+// window when it's visible, at least min_width x min_height, its title contains every
+// title_contains entry, its class isn't in class_excludes and (with require_process) it
+// belongs to one of process_names. Process names also gate detection as a whole (see
+// CondorProcessMonitor). All patterns are kept lower-case.
+struct SimProfile {
+    std::string name;
+    std::vector<std::string> process_names;
+    std::vector<std::string> title_contains;
+    std::vector<std::string> class_excludes;
+    int min_width = 100;
+    int min_height = 100;
+    bool require_process = false;
+};
+
+std::vector<SimProfile> builtin_sim_profiles() {
+    return {
+        // Menus and setup forms share the title but are TGUIForm/TApplication windows
+        { "Condor", { "condor.exe", "condor3.exe" }, { "condor", "version" }, { "tguiform", "tapplication" }, 100, 100, false },
+        // Short or generic titles: only trusted when the window belongs to the sim's process
+        { "MSFS", { "flightsimulator.exe", "flightsimulator2024.exe" }, { "microsoft flight simulator" }, {}, 800, 600, true },
+        { "DCS", { "dcs.exe" }, { "dcs" }, {}, 800, 600, true },
+    };
+}
+
+// Set once in WinMain from the settings, before the detector threads start; read-only afterwards
+std::vector<SimProfile> g_sim_profiles = builtin_sim_profiles();
+
+// "sim_profiles" in settings.json: an entry named like a built-in profile overrides the
+// fields it lists ("enabled": false drops it), any other name adds a profile
+std::vector<SimProfile> load_sim_profiles(const nlohmann::json& j) {
+    std::vector<SimProfile> profiles = builtin_sim_profiles();
+    try {
+        if (j.contains("sim_profiles") && j["sim_profiles"].is_array()) {
+            for (const auto& p : j["sim_profiles"]) {
+                std::string name = p.value("name", std::string());
+                if (name.empty()) continue;
+                auto it = std::find_if(profiles.begin(), profiles.end(), [&](const SimProfile& existing) {
+                    return to_lower_ascii(existing.name) == to_lower_ascii(name);
+                });
+                if (!p.value("enabled", true)) {
+                    if (it != profiles.end()) profiles.erase(it);
+                    continue;
+                }
+                if (it == profiles.end()) {
+                    profiles.push_back(SimProfile{});
+                    it = profiles.end() - 1;
+                    it->name = name;
+                }
+                it->process_names = p.value("process_names", it->process_names);
+                it->title_contains = p.value("title_contains", it->title_contains);
+                it->class_excludes = p.value("class_excludes", it->class_excludes);
+                it->min_width = p.value("min_width", it->min_width);
+                it->min_height = p.value("min_height", it->min_height);
+                it->require_process = p.value("require_process", it->require_process);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Could not parse sim_profiles from settings.json: " << e.what() << std::endl;
+    }
+
+    std::string names;
+    for (auto& profile : profiles) {
+        for (auto* patterns : { &profile.process_names, &profile.title_contains, &profile.class_excludes }) {
+            for (auto& pattern : *patterns) pattern = to_lower_ascii(pattern);
+        }
+        // Names go into a WQL string literal
+        profile.process_names.erase(std::remove_if(profile.process_names.begin(), profile.process_names.end(),
+            [](const std::string& n) { return n.empty() || n.find_first_of("'\\") != std::string::npos; }),
+            profile.process_names.end());
+        names += (names.empty() ? "" : ", ") + profile.name;
+    }
+    std::cout << "[INFO] Flight detection profiles: " << (names.empty() ? "none" : names) << std::endl;
+    return profiles;
+}
+
+bool is_sim_process_name(const char* lower_exe_name) {
+    for (const auto& profile : g_sim_profiles) {
+        for (const auto& process_name : profile.process_names) {
+            if (process_name == lower_exe_name) return true;
+        }
+    }
+    return false;
+}
+
+// Calls on_sim_process(pid) for each running sim process from the profiles (Toolhelp
+// snapshot) until it returns false. Names are lower-cased in place, so the walk itself
+// never allocates.
+template <typename OnSimProcess>
+void for_each_sim_process(OnSimProcess&& on_sim_process) {
+    HANDLE hProcessSnap = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+    if (hProcessSnap == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    
+    PROCESSENTRY32 pe32;
+    pe32.dwSize = sizeof(PROCESSENTRY32);
+    
+    if (!Process32First(hProcessSnap, &pe32)) {
+        CloseHandle(hProcessSnap);
+        return;
+    }
+    
+    do {
+        // Process names compare case insensitive
+        for (char* c = pe32.szExeFile; *c; ++c) *c = static_cast<char>(std::tolower(static_cast<unsigned char>(*c)));
+        if (is_sim_process_name(pe32.szExeFile) && !on_sim_process(pe32.th32ProcessID)) break;
+    } while (Process32Next(hProcessSnap, &pe32));
+    
+    CloseHandle(hProcessSnap);
+}
+
+// PIDs of all running sim processes
+std::vector<DWORD> find_sim_process_ids() {
+    std::vector<DWORD> pids;
+    for_each_sim_process([&](DWORD pid) { pids.push_back(pid); return true; });
+    return pids;
+}
+
+// Stops at the first one found; no allocation, so it can run from the core loop
+bool is_sim_process_running() {
+    bool found = false;
+    for_each_sim_process([&](DWORD) { found = true; return false; });
+    return found;
+}
+
+// Lower-cased executable name (no path) of the process owning a window
+bool get_window_process_name(HWND hwnd, char* name, DWORD size) {
+    DWORD pid = 0;
+    GetWindowThreadProcessId(hwnd, &pid);
+    HANDLE process = pid ? OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid) : nullptr;
+    if (!process) return false;
+    char path[MAX_PATH];
+    DWORD length = MAX_PATH;
+    bool ok = QueryFullProcessImageNameA(process, 0, path, &length) != 0;
+    CloseHandle(process);
+    if (!ok) return false;
+    const char* base = std::strrchr(path, '\\');
+    strncpy_s(name, size, base ? base + 1 : path, _TRUNCATE);
+    for (char* c = name; *c; ++c) *c = static_cast<char>(std::tolower(static_cast<unsigned char>(*c)));
+    return true;
+}
+
+// Index into g_sim_profiles of the sim whose flight window this is, or -1. Runs for
+// every top-level window on a sweep, so the title and class are read once into stack
+// buffers and every profile is checked in the same pass; the owning process is only
+// looked up for a candidate that needs it.
+int match_sim_window(HWND hwnd) {
+    if (!IsWindowVisible(hwnd)) return -1;
+
+    RECT rect;
+    if (!GetWindowRect(hwnd, &rect)) return -1;
+    int width = rect.right - rect.left;
+    int height = rect.bottom - rect.top;
+
+    char windowTitle[256];
+    if (GetWindowTextA(hwnd, windowTitle, sizeof(windowTitle)) == 0) return -1;
+    for (char* c = windowTitle; *c; ++c) *c = static_cast<char>(std::tolower(static_cast<unsigned char>(*c)));
+
+    char className[256] = "";
+    bool have_class = false;
+    char processName[MAX_PATH] = "";
+    int process_lookup = 0; // 0 = not yet, 1 = ok, -1 = failed
+
+    for (size_t p = 0; p < g_sim_profiles.size(); ++p) {
+        const SimProfile& profile = g_sim_profiles[p];
+        if (width < profile.min_width || height < profile.min_height) continue;
+        bool title_matches = true;
+        for (const auto& pattern : profile.title_contains) {
+            if (!std::strstr(windowTitle, pattern.c_str())) { title_matches = false; break; }
+        }
+        if (!title_matches) continue;
+
+        if (!profile.class_excludes.empty()) {
+            if (!have_class) {
+                if (GetClassNameA(hwnd, className, sizeof(className)) == 0) return -1;
+                for (char* c = className; *c; ++c) *c = static_cast<char>(std::tolower(static_cast<unsigned char>(*c)));
+                have_class = true;
+            }
+            if (std::find(profile.class_excludes.begin(), profile.class_excludes.end(), className) !=
+                profile.class_excludes.end()) continue;
+        }
+
+        if (profile.require_process) {
+            if (process_lookup == 0) {
+                process_lookup = get_window_process_name(hwnd, processName, sizeof(processName)) ? 1 : -1;
+            }
+            if (process_lookup < 0 || std::find(profile.process_names.begin(), profile.process_names.end(),
+                                                processName) == profile.process_names.end()) continue;
+        }
+        return static_cast<int>(p);
+    }
+    return -1;
+}
+
+struct SimWindowMatch {
+    HWND hwnd = nullptr;
+    int profile = -1;
+};
+
+BOOL CALLBACK FindSimWindowProc(HWND hwnd, LPARAM lParam) {
+    int profile = match_sim_window(hwnd);
+    if (profile >= 0) {
+        *reinterpret_cast<SimWindowMatch*>(lParam) = SimWindowMatch{ hwnd, profile };
+        return FALSE; // Stop enumeration
+    }
+    return TRUE; // Continue enumeration
+}
+
+// Full sweep of the desktop for a sim flight window (hwnd nullptr if none)
+SimWindowMatch find_sim_window() {
+    const int64_t start_us = trace_enabled() ? monotonic_now_us() : 0;
+    SimWindowMatch found;
+    EnumWindows(FindSimWindowProc, reinterpret_cast<LPARAM>(&found));
+    if (start_us) {
+        TraceLoggingWrite(g_trace_provider, "DetectorSweep", TraceLoggingInt64(monotonic_now_us() - start_us, "DurationUs"),
+                          TraceLoggingBool(found.hwnd != nullptr, "Found"));
+    }
+    return found;
+}
+
+// Event-driven flight detection. WinEvent hooks on the GUI thread (which pumps the
+// out-of-context callbacks) look at each top-level window as it's created, shown,
+// hidden, renamed or destroyed, and keep the sim window handle current; the core
+// thread is woken on every change and only reads the flag. A slow full sweep
+// (CONDOR_WINDOW_RECONCILE_INTERVAL) backs this up in case an event is missed.
+#define CONDOR_WINDOW_RECONCILE_INTERVAL 30.0
+std::atomic<HWND> g_condor_sim_hwnd{nullptr};
+std::atomic<DWORD> g_condor_sim_pid{0}; // Owner of g_condor_sim_hwnd, to catch a recycled handle
+std::atomic<int> g_sim_profile_index{-1}; // g_sim_profiles entry that matched g_condor_sim_hwnd
+std::atomic<bool> g_condor_window_hooks_installed{false};
+// Cleared by CondorProcessMonitor while no Condor process runs; window events are ignored then
+std::atomic<bool> g_condor_process_alive{true};
+HWINEVENTHOOK g_window_lifecycle_hook = nullptr; // Create/destroy/show/hide
+HWINEVENTHOOK g_window_name_hook = nullptr;      // Title changes
+
+void set_condor_sim_window(HWND hwnd, int profile = -1) {
+    DWORD pid = 0;
+    if (hwnd) GetWindowThreadProcessId(hwnd, &pid);
+    g_condor_sim_pid = pid;
+    g_sim_profile_index = hwnd ? profile : -1;
+    HWND previous = g_condor_sim_hwnd.exchange(hwnd);
+    g_condor_sim_active = hwnd != nullptr;
+    if ((previous != nullptr) != (hwnd != nullptr)) {
+        wake_core_thread(); // Flight started or ended
+    }
+}
+
+// Full sweep; also resyncs the event-driven state
+bool reconcile_condor_sim_window() {
+    SimWindowMatch found = find_sim_window();
+    set_condor_sim_window(found.hwnd, found.profile);
+    return found.hwnd != nullptr;
+}
+
+// Is the last detected sim window still alive, still owned by the same process and
+// still the sim window? A handful of calls on one handle instead of walking the desktop.
+bool cached_condor_sim_window_valid() {
+    HWND hwnd = g_condor_sim_hwnd.load();
+    if (!hwnd || !IsWindow(hwnd)) return false;
+    DWORD pid = 0;
+    GetWindowThreadProcessId(hwnd, &pid);
+    return pid != 0 && pid == g_condor_sim_pid.load() && match_sim_window(hwnd) >= 0;
+}
+
+// Validate the cached handle; enumerate the desktop only once it has gone
+bool is_condor_simulation_window_active() {
+    if (cached_condor_sim_window_valid()) return true;
+    return reconcile_condor_sim_window();
+}
+
+void CALLBACK CondorWinEventProc(HWINEVENTHOOK, DWORD event, HWND hwnd, LONG idObject, LONG idChild, DWORD, DWORD) {
+    if (!hwnd || idObject != OBJID_WINDOW || idChild != CHILDID_SELF) return; // Not a window itself
+    if (!g_condor_process_alive.load(std::memory_order_relaxed)) return;
+    HWND current = g_condor_sim_hwnd.load();
+    if (event == EVENT_OBJECT_DESTROY) {
+        if (hwnd == current) reconcile_condor_sim_window(); // Another sim window may remain
+        return;
+    }
+    if (GetAncestor(hwnd, GA_ROOT) != hwnd) return; // Child controls
+    int profile = match_sim_window(hwnd);
+    bool matches = profile >= 0;
+    if (matches && current == nullptr) {
+        set_condor_sim_window(hwnd, profile);
+    } else if (!matches && hwnd == current) {
+        reconcile_condor_sim_window();
+    }
+}
+
+// Must run on a thread with a message loop
+void install_condor_window_hooks() {
+    g_window_lifecycle_hook = SetWinEventHook(EVENT_OBJECT_CREATE, EVENT_OBJECT_HIDE, nullptr, CondorWinEventProc,
+                                              0, 0, WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+    g_window_name_hook = SetWinEventHook(EVENT_OBJECT_NAMECHANGE, EVENT_OBJECT_NAMECHANGE, nullptr, CondorWinEventProc,
+                                         0, 0, WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+    if (g_window_lifecycle_hook && g_window_name_hook) {
+        reconcile_condor_sim_window();
+        g_condor_window_hooks_installed = true;
+        std::cout << "[INFO] Watching window events for Condor flight detection" << std::endl;
+    } else {
+        std::cerr << "[WARNING] Could not install window event hooks (error=" << GetLastError()
+                  << "); polling for the Condor window instead" << std::endl;
+    }
+}
+
+void uninstall_condor_window_hooks() {
+    g_condor_window_hooks_installed = false;
+    if (g_window_lifecycle_hook) UnhookWinEvent(g_window_lifecycle_hook);
+    if (g_window_name_hook) UnhookWinEvent(g_window_name_hook);
+    g_window_lifecycle_hook = g_window_name_hook = nullptr;
+}
+
+// "threads" in settings.json: where the background threads run (logging, metrics output,
+// pose history, settings and process watchers). The sampler, core and audio threads are
+// never touched.
+struct ThreadPlacementConfig {
+    bool eco_qos = true;                // EcoQoS (execution-speed throttling) for background threads
+    uint64_t background_affinity = 0;   // CPU mask for them; 0 leaves them on every CPU
+};
+
+ThreadPlacementConfig load_thread_settings(const nlohmann::json& j) {
+    ThreadPlacementConfig cfg;
+    try {
+        if (j.contains("threads") && j["threads"].is_object()) {
+            const nlohmann::json& t = j["threads"];
+            cfg.eco_qos = t.value("eco_qos", cfg.eco_qos);
+            if (t.contains("background_affinity_mask")) {
+                const nlohmann::json& mask = t["background_affinity_mask"];
+                // A number, or a string such as "0xF0" that shows the CPUs
+                cfg.background_affinity = mask.is_string() ? std::stoull(mask.get<std::string>(), nullptr, 0)
+                                                           : mask.get<uint64_t>();
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Could not parse threads from settings.json: " << e.what() << std::endl;
+    }
+    return cfg;
+}
+
+ThreadPlacementConfig g_thread_placement; // Set from settings.json before any background thread starts
+
+// First call of every background thread. With EcoQoS, Windows runs the thread at an
+// efficient clock and, on hybrid CPUs, keeps it on the efficiency cores, away from
+// the sim's render thread; none of these threads has a deadline the pilot would notice.
+void place_background_thread() {
+    const ThreadPlacementConfig& cfg = g_thread_placement;
+    if (cfg.eco_qos) {
+        THREAD_POWER_THROTTLING_STATE state = {};
+        state.Version = THREAD_POWER_THROTTLING_CURRENT_VERSION;
+        state.ControlMask = THREAD_POWER_THROTTLING_EXECUTION_SPEED;
+        state.StateMask = THREAD_POWER_THROTTLING_EXECUTION_SPEED;
+        SetThreadInformation(GetCurrentThread(), ThreadPowerThrottling, &state, sizeof(state)); // No-op before Windows 10 1709
+    }
+    if (cfg.background_affinity != 0 && !SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(cfg.background_affinity))) {
+        static std::atomic<bool> warned{false};
+        if (!warned.exchange(true)) {
+            std::cerr << "[WARNING] threads.background_affinity_mask 0x" << std::hex << cfg.background_affinity << std::dec
+                      << " names no CPU of this PC (error " << GetLastError() << "); background threads run anywhere" << std::endl;
+        }
+    }
+}
+
+// Thread CPU time by subsystem, so a cost regression can be pinned on one of them. Each
+// thread enrolls itself for as long as it runs (ThreadCpuScope); the core reads their
+// QueryThreadCycleTime counters once a second and reports cycles per core tick as the
+// cpu.<subsystem>.cycles_per_tick gauges. The cycles are the CPU's own, so they don't
+// depend on the clock the scheduler ran the thread at. Each read is one
+// QueryThreadCycleTime call per enrolled thread, and it doesn't interrupt the thread.
+enum CpuSubsystem {
+    CPU_CORE, CPU_SAMPLER, CPU_AUDIO, CPU_DETECTORS, CPU_CONTROL, CPU_RECORDING, CPU_PLUGINS, CPU_OVERLAY,
+    CPU_SUBSYSTEM_COUNT
+};
+const char* const CPU_SUBSYSTEM_NAMES[CPU_SUBSYSTEM_COUNT] = {
+    "core", "sampler", "audio", "detectors", "control", "recording", "plugins", "overlay"
+};
+
+class CpuAccounting {
+public:
+    static constexpr size_t kMaxThreads = 32;
+
+    // The calling thread, until retire(); null when every slot is taken
+    void* enroll(CpuSubsystem subsystem) {
+        for (Slot& slot : slots_) {
+            int expected = FREE;
+            if (!slot.state.compare_exchange_strong(expected, CLAIMED, std::memory_order_acquire)) continue;
+            slot.subsystem = subsystem;
+            slot.thread = nullptr;
+            DuplicateHandle(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(), &slot.thread,
+                            THREAD_QUERY_LIMITED_INFORMATION, FALSE, 0);
+            ULONG64 cycles = 0;
+            if (slot.thread) QueryThreadCycleTime(slot.thread, &cycles);
+            slot.reported = cycles;
+            slot.state.store(slot.thread ? LIVE : RETIRED, std::memory_order_release);
+            return &slot;
+        }
+        static std::atomic<bool> warned{false};
+        if (!warned.exchange(true)) std::cerr << "[WARNING] More than " << kMaxThreads << " threads; some CPU time goes unaccounted" << std::endl;
+        return nullptr;
+    }
+
+    // The enrolled thread, as it finishes; its last cycles are still counted
+    void retire(void* slot) {
+        if (slot) static_cast<Slot*>(slot)->state.store(RETIRED, std::memory_order_release);
+    }
+
+    // Core thread: cycles per subsystem since the last call, added to `cycles`
+    void collect(uint64_t (&cycles)[CPU_SUBSYSTEM_COUNT]) {
+        for (Slot& slot : slots_) {
+            const int state = slot.state.load(std::memory_order_acquire);
+            if (state != LIVE && state != RETIRED) continue;
+            ULONG64 now = slot.reported;
+            if (slot.thread) QueryThreadCycleTime(slot.thread, &now); // An exited thread keeps its final count
+            cycles[slot.subsystem] += now - slot.reported;
+            slot.reported = now;
+            if (state == RETIRED) {
+                if (slot.thread) CloseHandle(slot.thread);
+                slot.thread = nullptr;
+                slot.state.store(FREE, std::memory_order_release);
+            }
+        }
+    }
+
+private:
+    enum { FREE, CLAIMED, LIVE, RETIRED };
+    struct Slot {
+        std::atomic<int> state{FREE};
+        CpuSubsystem subsystem = CPU_CORE;
+        HANDLE thread = nullptr;
+        uint64_t reported = 0; // The enrolling thread's until LIVE, then the core's
+    };
+    std::array<Slot, kMaxThreads> slots_;
+};
+CpuAccounting g_cpu_accounting;
+
+// Counts the enclosing thread's CPU time under `subsystem` while in scope
+class ThreadCpuScope {
+public:
+    explicit ThreadCpuScope(CpuSubsystem subsystem) : slot_(g_cpu_accounting.enroll(subsystem)) {}
+    ~ThreadCpuScope() { g_cpu_accounting.retire(slot_); }
+    ThreadCpuScope(const ThreadCpuScope&) = delete;
+    ThreadCpuScope& operator=(const ThreadCpuScope&) = delete;
+
+private:
+    void* slot_;
+};
+
+// "cpu_budget" in settings.json: the most CPU the monitor's own threads may take
+struct CpuBudgetConfig {
+    bool enabled = false;
+    double percent = 0.5;            // Of one core
+    double burst_s = 10.0;           // Bucket depth: this many seconds' budget can be spent at once
+    double relax_s = 30.0;           // Back under budget this long before a step is undone
+    double telemetry_hz = 10.0;      // Scan state publish rate from step 2
+    double sampling_floor_hz = 2.0;  // Still-head poll rate on step 3
+};
+
+CpuBudgetConfig load_cpu_budget_settings(const nlohmann::json& j) {
+    CpuBudgetConfig cfg;
+    try {
+        if (j.contains("cpu_budget") && j["cpu_budget"].is_object()) {
+            const nlohmann::json& c = j["cpu_budget"];
+            cfg.enabled = c.value("enabled", cfg.enabled);
+            cfg.percent = (std::max)(0.01, (std::min)(100.0, c.value("percent", cfg.percent)));
+            cfg.burst_s = (std::max)(1.0, (std::min)(600.0, c.value("burst_s", cfg.burst_s)));
+            cfg.relax_s = (std::max)(1.0, c.value("relax_s", cfg.relax_s));
+            cfg.telemetry_hz = (std::max)(1.0, (std::min)(100.0, c.value("telemetry_hz", cfg.telemetry_hz)));
+            cfg.sampling_floor_hz = (std::max)(0.5, (std::min)(20.0, c.value("sampling_floor_hz", cfg.sampling_floor_hz)));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Could not parse cpu_budget from settings.json: " << e.what() << std::endl;
+    }
+    return cfg;
+}
+
+// Token bucket over the cycles CpuAccounting measures, so the monitor stays inside
+// cpu_budget.percent of one core however the sim's load moves the cost of its threads.
+// The bucket fills at the budget and holds burst_s of it; each second's cycles, in
+// seconds at the TSC rate (what QueryThreadCycleTime counts in), are taken out. Empty,
+// the governor takes one step down; full for relax_s, it undoes the last one:
+//   1  [DEBUG] logging off
+//   2  scan state (shared memory, UDP, control pipe) published at telemetry_hz
+//   3  tracking polled at sampling_floor_hz while the head is still; burst sampling,
+//      and so the peak of every look, is untouched
+// Alarm evaluation itself is never degraded.
+class CpuGovernor {
+public:
+    static constexpr int kSteps = 3;
+
+    explicit CpuGovernor(const CpuBudgetConfig& config)
+        : config_(config), tokens_s_(capacity_s()), start_tsc_(__rdtsc()) {
+        QueryPerformanceCounter(&start_qpc_);
+        QueryPerformanceFrequency(&qpc_frequency_);
+        if (config_.enabled) std::cout << "[INFO] CPU budget: " << config_.percent << "% of one core" << std::endl;
+    }
+
+    bool enabled() const { return config_.enabled; }
+    int level() const { return level_; }
+    double used_percent() const { return used_percent_; }
+    double tokens_s() const { return tokens_s_; }
+
+    // Core thread, once a second: `cycles` spent by every thread over `elapsed_s`. The
+    // new level if it changed, -1 if not.
+    int update(uint64_t cycles, double elapsed_s) {
+        if (!config_.enabled || elapsed_s <= 0.0) return -1;
+        const double hz = tsc_hz();
+        if (hz <= 0.0) return -1;
+        const double spent_s = cycles / hz;
+        used_percent_ = 100.0 * spent_s / elapsed_s;
+        const double budget = config_.percent / 100.0;
+        tokens_s_ = (std::min)(capacity_s(), tokens_s_ + budget * elapsed_s) - spent_s;
+        tokens_s_ = (std::max)(tokens_s_, -capacity_s()); // A long overrun isn't owed back for ever
+        if (tokens_s_ < 0.0) {
+            full_s_ = 0.0;
+            if (level_ < kSteps) return ++level_;
+            return -1;
+        }
+        full_s_ = tokens_s_ >= capacity_s() ? full_s_ + elapsed_s : 0.0;
+        if (level_ > 0 && full_s_ >= config_.relax_s) {
+            full_s_ = 0.0;
+            return --level_;
+        }
+        return -1;
+    }
+
+private:
+    double capacity_s() const { return config_.percent / 100.0 * config_.burst_s; }
+
+    // Measured against QPC since startup, so it only gets better
+    double tsc_hz() const {
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        const double seconds = static_cast<double>(now.QuadPart - start_qpc_.QuadPart) / qpc_frequency_.QuadPart;
+        return seconds > 0.1 ? static_cast<double>(__rdtsc() - start_tsc_) / seconds : 0.0;
+    }
+
+    const CpuBudgetConfig config_;
+    int level_ = 0;
+    double tokens_s_;
+    double full_s_ = 0.0;
+    double used_percent_ = 0.0;
+    const uint64_t start_tsc_;
+    LARGE_INTEGER start_qpc_ = {};
+    LARGE_INTEGER qpc_frequency_ = {};
+};
+const char* const CPU_GOVERNOR_STEP_NAMES[CpuGovernor::kSteps] = {
+    "debug_logging_off", "telemetry_reduced", "sampling_floor_lowered"
+};
+
+#define CONDOR_PROCESS_POLL_INTERVAL 5.0 // Toolhelp fallback when WMI process traces are unavailable
+
+// Tracks whether a Condor process is alive so window detection can stay off the rest
+// of the day. A watcher thread subscribes to WMI Win32_ProcessTrace (start and stop
+// traces) for the process names in g_sim_profiles and wakes the core on every change. Those traces
+// need administrator rights; until (or unless) the subscription is up, running() falls
+// back to a Toolhelp snapshot every CONDOR_PROCESS_POLL_INTERVAL seconds.
+class CondorProcessMonitor {
+public:
+    ~CondorProcessMonitor() { stop(); }
+
+    void start() {
+        publish(is_sim_process_running());
+        last_poll_us_ = monotonic_now_us();
+        stop_ = false;
+        thread_ = std::thread(&CondorProcessMonitor::watch, this);
+    }
+
+    void stop() {
+        stop_ = true;
+        if (thread_.joinable()) thread_.join();
+        g_condor_process_alive = true; // Ungated without a monitor
+    }
+
+    // Process notifications arrive on their own; no polling needed
+    bool event_driven() const { return event_driven_.load(); }
+
+    bool running() {
+        if (!event_driven_) {
+            int64_t now_us = monotonic_now_us();
+            if (now_us - last_poll_us_ >= seconds_to_us(CONDOR_PROCESS_POLL_INTERVAL)) {
+                last_poll_us_ = now_us;
+                publish(is_sim_process_running());
+            }
+        }
+        return g_condor_process_alive.load();
+    }
+
+private:
+    void publish(bool alive) {
+        if (g_condor_process_alive.exchange(alive) != alive) {
+            std::cout << "[INFO] Condor process " << (alive ? "started" : "exited") << std::endl;
+            wake_core_thread();
+        }
+    }
+
+    void watch() {
+        place_background_thread();
+        ThreadCpuScope cpu_scope(CPU_DETECTORS);
+        HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        if (FAILED(hr)) return;
+        IWbemLocator* locator = nullptr;
+        IWbemServices* services = nullptr;
+        IEnumWbemClassObject* events = nullptr;
+        bool no_names = true;
+        for (const auto& profile : g_sim_profiles) no_names &= profile.process_names.empty();
+
+        // With no process names the WHERE clause would be empty, which isn't valid WQL
+        hr = no_names ? E_INVALIDARG : S_OK;
+        if (SUCCEEDED(hr)) {
+            hr = CoCreateInstance(CLSID_WbemLocator, nullptr, CLSCTX_INPROC_SERVER, IID_IWbemLocator,
+                                  reinterpret_cast<void**>(&locator));
+        }
+        if (SUCCEEDED(hr)) {
+            BSTR wmi_namespace = SysAllocString(L"ROOT\\CIMV2");
+            hr = locator->ConnectServer(wmi_namespace, nullptr, nullptr, nullptr, 0, nullptr, nullptr, &services);
+            SysFreeString(wmi_namespace);
+        }
+        if (SUCCEEDED(hr)) {
+            hr = CoSetProxyBlanket(services, RPC_C_AUTHN_WINNT, RPC_C_AUTHZ_NONE, nullptr, RPC_C_AUTHN_LEVEL_CALL,
+                                   RPC_C_IMP_LEVEL_IMPERSONATE, nullptr, EOAC_NONE);
+        }
+        if (SUCCEEDED(hr)) {
+            // Win32_ProcessTrace is the parent of the start and stop trace classes: one query
+            // gets both. WQL string comparisons ignore case.
+            BSTR language = SysAllocString(L"WQL");
+            std::wstring wql = L"SELECT * FROM Win32_ProcessTrace WHERE ";
+            bool first = true;
+            for (const auto& profile : g_sim_profiles) {
+                for (const auto& process_name : profile.process_names) {
+                    wql += (first ? L"ProcessName = '" : L" OR ProcessName = '") +
+                           std::wstring(process_name.begin(), process_name.end()) + L"'";
+                    first = false;
+                }
+            }
+            BSTR query = SysAllocString(wql.c_str());
+            hr = services->ExecNotificationQuery(language, query, WBEM_FLAG_RETURN_IMMEDIATELY | WBEM_FLAG_FORWARD_ONLY,
+                                                 nullptr, &events);
+            SysFreeString(query);
+            SysFreeString(language);
+        }
+
+        if (SUCCEEDED(hr)) {
+            // Snapshot after subscribing so no start/stop falls between the two
+            std::vector<DWORD> pids = find_sim_process_ids();
+            publish(!pids.empty());
+            event_driven_ = true;
+            std::cout << "[INFO] Watching Condor process start/stop events (WMI)" << std::endl;
+            while (!stop_) {
+                IWbemClassObject* event = nullptr;
+                ULONG returned = 0;
+                hr = events->Next(500, 1, &event, &returned); // Timeout so stop() is noticed
+                if (hr == WBEM_S_TIMEDOUT || (SUCCEEDED(hr) && returned == 0)) continue;
+                if (FAILED(hr)) break;
+
+                VARIANT event_class, process_id;
+                VariantInit(&event_class);
+                VariantInit(&process_id);
+                event->Get(L"__CLASS", 0, &event_class, nullptr, nullptr);
+                event->Get(L"ProcessID", 0, &process_id, nullptr, nullptr);
+                DWORD pid = (process_id.vt == VT_I4 || process_id.vt == VT_UI4) ? static_cast<DWORD>(process_id.lVal) : 0;
+                bool stopped = event_class.vt == VT_BSTR && wcscmp(event_class.bstrVal, L"Win32_ProcessStopTrace") == 0;
+                VariantClear(&event_class);
+                VariantClear(&process_id);
+                event->Release();
+
+                auto it = std::find(pids.begin(), pids.end(), pid);
+                if (stopped && it != pids.end()) pids.erase(it);
+                else if (!stopped && it == pids.end()) pids.push_back(pid);
+                publish(!pids.empty());
+            }
+            event_driven_ = false;
+            if (!stop_) {
+                std::cerr << "[WARNING] WMI process events stopped (hr=0x" << std::hex << hr << std::dec
+                          << "); checking for Condor every " << CONDOR_PROCESS_POLL_INTERVAL << " s" << std::endl;
+            }
+        } else if (no_names) {
+            std::cout << "[INFO] No sim profile lists a process name; checking for Condor every "
+                      << CONDOR_PROCESS_POLL_INTERVAL << " s" << std::endl;
+        } else {
+            std::cout << "[INFO] WMI process events unavailable (hr=0x" << std::hex << hr << std::dec
+                      << ", needs administrator rights); checking for Condor every "
+                      << CONDOR_PROCESS_POLL_INTERVAL << " s" << std::endl;
+        }
+
+        if (events) events->Release();
+        if (services) services->Release();
+        if (locator) locator->Release();
+        CoUninitialize();
+    }
+
+    std::thread thread_;
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> event_driven_{false};
+    int64_t last_poll_us_ = 0; // Core thread only
+};
+
+// Condor log file watching ("condor_log" in settings.json). Markers are substrings that
+// identify a log line's event (case-insensitive).
+struct CondorLogConfig {
+    bool enabled = false;
+    std::string path = "%USERPROFILE%\\Documents\\Condor3\\Logs\\Logfile.txt";
+    std::vector<std::string> start_markers = { "flight started" };
+    std::vector<std::string> end_markers = { "flight ended", "exit flight" };
+    std::vector<std::string> pause_markers = { "paused" };
+    std::vector<std::string> resume_markers = { "resumed", "unpaused" };
+    std::vector<std::string> replay_markers = { "replay" };
+};
+
+CondorLogConfig load_condor_log_settings(const nlohmann::json& j) {
+    CondorLogConfig cfg;
+    try {
+        if (j.contains("condor_log") && j["condor_log"].is_object()) {
+            const nlohmann::json& l = j["condor_log"];
+            cfg.enabled = l.value("enabled", cfg.enabled);
+            cfg.path = l.value("path", cfg.path);
+            cfg.start_markers = l.value("start_markers", cfg.start_markers);
+            cfg.end_markers = l.value("end_markers", cfg.end_markers);
+            cfg.pause_markers = l.value("pause_markers", cfg.pause_markers);
+            cfg.resume_markers = l.value("resume_markers", cfg.resume_markers);
+            cfg.replay_markers = l.value("replay_markers", cfg.replay_markers);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Could not parse condor_log from settings.json: " << e.what() << std::endl;
+    }
+
+    char expanded[MAX_PATH];
+    if (ExpandEnvironmentStringsA(cfg.path.c_str(), expanded, MAX_PATH) > 0) cfg.path = expanded;
+    for (auto* markers : { &cfg.start_markers, &cfg.end_markers, &cfg.pause_markers, &cfg.resume_markers, &cfg.replay_markers }) {
+        for (auto& marker : *markers) marker = to_lower_ascii(marker);
+    }
+    return cfg;
+}
+
+// "flight_inference" in settings.json: flying told from head motion, for when the
+// window heuristics stop recognizing the sim (a new Condor title or window class)
+struct FlightInferenceConfig {
+    bool enabled = true;
+    bool fallback = false;           // Run the alarms on an inferred flight; false only warns
+    double activity_s = 60.0;        // Motion that looks like flying for this long
+    double min_speed_deg_s = 0.5;    // Mean head speed over a 10 s window: moving...
+    double max_speed_deg_s = 40.0;   // ...but not being put on or handled
+};
+
+FlightInferenceConfig load_flight_inference_settings(const nlohmann::json& j) {
+    FlightInferenceConfig cfg;
+    try {
+        if (j.contains("flight_inference") && j["flight_inference"].is_object()) {
+            const nlohmann::json& f = j["flight_inference"];
+            cfg.enabled = f.value("enabled", cfg.enabled);
+            cfg.fallback = f.value("fallback", cfg.fallback);
+            cfg.activity_s = (std::max)(10.0, (std::min)(3600.0, f.value("activity_s", cfg.activity_s)));
+            cfg.min_speed_deg_s = (std::max)(0.0, f.value("min_speed_deg_s", cfg.min_speed_deg_s));
+            cfg.max_speed_deg_s = (std::max)(cfg.min_speed_deg_s, f.value("max_speed_deg_s", cfg.max_speed_deg_s));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Could not parse flight_inference from settings.json: " << e.what() << std::endl;
+    }
+    return cfg;
+}
+
+// Follows Condor's log file for exact flight start/end/pause/replay events, which the
+// window heuristics can't tell apart. A watcher thread waits on ReadDirectoryChangesW
+// for the log's directory; on each change it reads only the bytes appended since the
+// last read (a shrunk file is a new log, read from the start) and matches whole lines
+// against the configured markers. Lines from before launch are skipped, so the state
+// starts out unknown and the windows decide until the log says otherwise.
+class CondorLogWatcher {
+public:
+    enum State { STATE_UNKNOWN, STATE_FLYING, STATE_PAUSED, STATE_REPLAY, STATE_ENDED };
+
+    explicit CondorLogWatcher(CondorLogConfig config) : config_(std::move(config)) {}
+    ~CondorLogWatcher() { stop(); }
+    CondorLogWatcher(const CondorLogWatcher&) = delete;
+    CondorLogWatcher& operator=(const CondorLogWatcher&) = delete;
+
+    bool enabled() const { return config_.enabled; }
+
+    void start() {
+        if (!config_.enabled) return;
+        size_t slash = config_.path.find_last_of("\\/");
+        directory_ = slash == std::string::npos ? std::string(".") : config_.path.substr(0, slash);
+        stop_event_ = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        thread_ = std::thread(&CondorLogWatcher::watch, this);
+    }
+
+    void stop() {
+        if (stop_event_) SetEvent(stop_event_);
+        if (thread_.joinable()) thread_.join();
+        if (stop_event_) CloseHandle(stop_event_);
+        stop_event_ = nullptr;
+    }
+
+    State state() const { return static_cast<State>(state_.load()); }
+
+    // The sim window went away: whatever the log said last belongs to that session
+    void reset_state() { state_ = STATE_UNKNOWN; }
+
+private:
+    void watch() {
+        place_background_thread();
+        ThreadCpuScope cpu_scope(CPU_DETECTORS);
+        HANDLE directory = CreateFileA(directory_.c_str(), FILE_LIST_DIRECTORY,
+                                       FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                       FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+        if (directory == INVALID_HANDLE_VALUE) {
+            std::cerr << "[WARNING] Cannot watch Condor log directory " << directory_ << " (error=" << GetLastError()
+                      << "); using window detection only" << std::endl;
+            return;
+        }
+        std::cout << "[INFO] Following Condor log " << config_.path << std::endl;
+
+        // History from before launch says nothing about now: start at the current end
+        HANDLE file = open_log();
+        if (file != INVALID_HANDLE_VALUE) {
+            LARGE_INTEGER size;
+            if (GetFileSizeEx(file, &size)) offset_ = size.QuadPart;
+            file_id_ = log_file_id(file);
+            CloseHandle(file);
+        }
+
+        HANDLE change_event = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        alignas(DWORD) char notifications[4096];
+        while (true) {
+            OVERLAPPED overlapped = {};
+            overlapped.hEvent = change_event;
+            ResetEvent(change_event);
+            if (!ReadDirectoryChangesW(directory, notifications, sizeof(notifications), FALSE,
+                                       FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE,
+                                       nullptr, &overlapped, nullptr)) {
+                std::cerr << "[WARNING] Condor log watch failed (error=" << GetLastError() << ")" << std::endl;
+                break;
+            }
+            HANDLE handles[2] = { change_event, stop_event_ };
+            DWORD signaled = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+            DWORD bytes = 0;
+            if (signaled != WAIT_OBJECT_0) {
+                CancelIoEx(directory, &overlapped);
+                GetOverlappedResult(directory, &overlapped, &bytes, TRUE); // Buffer must outlive the I/O
+                break;
+            }
+            GetOverlappedResult(directory, &overlapped, &bytes, FALSE);
+            // Which entry changed doesn't matter (and an overflowed buffer reports none):
+            // one size check on the log tells whether there's anything new
+            read_appended();
+        }
+        CloseHandle(change_event);
+        CloseHandle(directory);
+    }
+
+    HANDLE open_log() const {
+        return CreateFileA(config_.path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                           nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    }
+
+    // Volume and file index: tells a replaced log from the one read so far, even when
+    // the new one has grown past the old offset by the time it's opened
+    static uint64_t log_file_id(HANDLE file) {
+        BY_HANDLE_FILE_INFORMATION info;
+        if (!GetFileInformationByHandle(file, &info)) return 0;
+        return (static_cast<uint64_t>(info.nFileIndexHigh) << 32 | info.nFileIndexLow) ^
+               static_cast<uint64_t>(info.dwVolumeSerialNumber) << 16;
+    }
+
+    void read_appended() {
+        HANDLE file = open_log();
+        if (file == INVALID_HANDLE_VALUE) return;
+        LARGE_INTEGER size;
+        if (GetFileSizeEx(file, &size)) {
+            const uint64_t id = log_file_id(file);
+            if (size.QuadPart < offset_ || id != file_id_) {
+                // Truncated or replaced: a new log, and a new Condor session whose state
+                // the old log's last line doesn't describe
+                offset_ = 0;
+                line_.clear();
+                file_id_ = id;
+                if (state_.exchange(STATE_UNKNOWN) != STATE_UNKNOWN) wake_core_thread();
+            }
+            LARGE_INTEGER position;
+            position.QuadPart = offset_;
+            if (size.QuadPart > offset_ && SetFilePointerEx(file, position, nullptr, FILE_BEGIN)) {
+                char chunk[4096];
+                DWORD read = 0;
+                while (ReadFile(file, chunk, sizeof(chunk), &read, nullptr) && read > 0) {
+                    offset_ += read;
+                    for (DWORD i = 0; i < read; ++i) {
+                        char c = chunk[i];
+                        if (c == '\n') {
+                            handle_line();
+                            line_.clear();
+                        } else if (c != '\r' && line_.size() < 1024) {
+                            line_.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+                        }
+                    }
+                }
+            }
+        }
+        CloseHandle(file);
+    }
+
+    static bool has_marker(const std::string& line, const std::vector<std::string>& markers) {
+        for (const auto& marker : markers) {
+            if (!marker.empty() && line.find(marker) != std::string::npos) return true;
+        }
+        return false;
+    }
+
+    void handle_line() {
+        // Resume before pause: "unpaused" contains "paused"
+        State next;
+        if (has_marker(line_, config_.end_markers)) next = STATE_ENDED;
+        else if (has_marker(line_, config_.replay_markers)) next = STATE_REPLAY;
+        else if (has_marker(line_, config_.resume_markers)) next = STATE_FLYING;
+        else if (has_marker(line_, config_.pause_markers)) next = STATE_PAUSED;
+        else if (has_marker(line_, config_.start_markers)) next = STATE_FLYING;
+        else return;
+        if (state_.exchange(next) != next) wake_core_thread();
+    }
+
+    CondorLogConfig config_;
+    std::string directory_;
+    std::thread thread_;
+    HANDLE stop_event_ = nullptr;
+    std::atomic<int> state_{STATE_UNKNOWN};
+    int64_t offset_ = 0;   // Watcher thread only
+    uint64_t file_id_ = 0; // log_file_id() of the log offset_ is into; watcher thread only
+    std::string line_;     // Partial line carried between reads
+};
+
+// Single-writer seqlock: the writer never waits for readers, and a reader that
+// overlapped a write retries. The value goes through relaxed atomic words, so a read
+// racing a write is caught by the sequence check rather than being a data race.
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock values are copied bytewise");
+    static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+public:
+    void store(const T& value) {
+        uint64_t words[kWords] = {};
+        std::memcpy(words, &value, sizeof(T));
+        uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed); // Odd: write in progress
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t k = 0; k < kWords; ++k) words_[k].store(words[k], std::memory_order_relaxed);
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    T load() const {
+        uint64_t words[kWords];
+        uint32_t before, after;
+        do {
+            before = sequence_.load(std::memory_order_acquire);
+            for (size_t k = 0; k < kWords; ++k) words[k] = words_[k].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence_.load(std::memory_order_relaxed);
+        } while ((before & 1) != 0 || before != after);
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+private:
+    std::atomic<uint32_t> sequence_{0};
+    std::array<std::atomic<uint64_t>, kWords> words_{};
+};
+
+// Single-writer, single-reader triple buffer for "the latest state". The writer fills
+// its back slot and swaps it into the middle; the reader swaps the middle for its front
+// slot when the middle holds something newer. Neither side ever waits or retries (unlike
+// SeqLock, whose reader spins out a concurrent write), and the reader always sees one
+// whole published value: the newest at the time it looked.
+template <typename T>
+class TripleBuffer {
+    static constexpr uint8_t kIndex = 0x3, kFresh = 0x4;
+
+public:
+    // Writer thread only
+    void store(const T& value) {
+        slots_[back_] = value;
+        back_ = middle_.exchange(static_cast<uint8_t>(back_ | kFresh), std::memory_order_acq_rel) & kIndex;
+    }
+
+    // Reader thread only: the newest value, valid until the next load()
+    const T& load() {
+        if (middle_.load(std::memory_order_relaxed) & kFresh) {
+            front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndex;
+        }
+        return slots_[front_];
+    }
+
+private:
+    std::array<T, 3> slots_{};
+    uint8_t back_ = 0;                 // Writer's
+    std::atomic<uint8_t> middle_{1};   // Slot index, | kFresh once the writer has stored into it
+    uint8_t front_ = 2;                // Reader's
+};
+
+// Condor's UDP flight data output ("condor_udp" in settings.json). Condor sends it
+// when UDP output is enabled in its UDP.ini, to port 55278 by default.
+struct CondorUdpConfig {
+    bool enabled = false;
+    int port = 55278;
+    bool suspend_on_ground = true;   // No alarms while the glider sits on the ground
+    double on_ground_height_m = 3.0; // On the ground: below this height AGL...
+    double on_ground_speed_ms = 8.0; // ...and slower than this airspeed
+    double stale_after_s = 2.0;      // Telemetry older than this is ignored
+};
+
+CondorUdpConfig load_condor_udp_settings(const nlohmann::json& j) {
+    CondorUdpConfig cfg;
+    try {
+        if (j.contains("condor_udp") && j["condor_udp"].is_object()) {
+            const nlohmann::json& u = j["condor_udp"];
+            cfg.enabled = u.value("enabled", cfg.enabled);
+            cfg.port = (std::max)(1, (std::min)(65535, u.value("port", cfg.port)));
+            cfg.suspend_on_ground = u.value("suspend_on_ground", cfg.suspend_on_ground);
+            cfg.on_ground_height_m = u.value("on_ground_height_m", cfg.on_ground_height_m);
+            cfg.on_ground_speed_ms = u.value("on_ground_speed_ms", cfg.on_ground_speed_ms);
+            cfg.stale_after_s = (std::max)(0.1, u.value("stale_after_s", cfg.stale_after_s));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Could not parse condor_udp from settings.json: " << e.what() << std::endl;
+    }
+    return cfg;
+}
+
+// "pose_history" in settings.json: the last few minutes of head motion, kept in memory
+// for incident review and saved on request or when a warning starts
+// Deletes the oldest files matching `pattern` in `directory`, by last write time, until
+// the rest fit in budget_bytes along with reserved_bytes already spoken for (a file
+// still being written). Name order isn't age order once a sequence number or reason
+// is in the name.
+void trim_directory(const std::string& directory, const char* pattern, uint64_t budget_bytes, uint64_t reserved_bytes = 0) {
+    struct Found {
+        uint64_t written;
+        uint64_t size;
+        std::string name;
+    };
+    std::vector<Found> files;
+    WIN32_FIND_DATAA found;
+    HANDLE search = FindFirstFileA((directory + "\\" + pattern).c_str(), &found);
+    if (search == INVALID_HANDLE_VALUE) return;
+    do {
+        if (found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+        files.push_back({ (static_cast<uint64_t>(found.ftLastWriteTime.dwHighDateTime) << 32) | found.ftLastWriteTime.dwLowDateTime,
+                          (static_cast<uint64_t>(found.nFileSizeHigh) << 32) | found.nFileSizeLow, found.cFileName });
+    } while (FindNextFileA(search, &found));
+    FindClose(search);
+    std::sort(files.begin(), files.end(), [](const Found& a, const Found& b) {
+        return a.written != b.written ? a.written < b.written : a.name < b.name;
+    });
+    uint64_t total = reserved_bytes;
+    for (const Found& file : files) total += file.size;
+    for (const Found& file : files) {
+        if (total <= budget_bytes) break;
+        if (DeleteFileA((directory + "\\" + file.name).c_str())) total -= file.size;
+    }
+}
+
+struct PoseHistoryConfig {
+    bool enabled = true;
+    double seconds = 600.0;          // How far back the history reaches
+    double rate_hz = 50.0;           // Samples kept per second, at most
+    bool dump_on_warning = true;     // Save the history each time a warning starts
+    std::string directory = "pose_history";
+    int budget_mb = 100;             // Oldest saves are deleted past this
+};
+
+PoseHistoryConfig load_pose_history_settings(const nlohmann::json& j) {
+    PoseHistoryConfig cfg;
+    try {
+        if (j.contains("pose_history") && j["pose_history"].is_object()) {
+            const nlohmann::json& h = j["pose_history"];
+            cfg.enabled = h.value("enabled", cfg.enabled);
+            cfg.seconds = (std::max)(10.0, (std::min)(3600.0, h.value("seconds", cfg.seconds)));
+            cfg.rate_hz = (std::max)(1.0, (std::min)(200.0, h.value("rate_hz", cfg.rate_hz)));
+            cfg.dump_on_warning = h.value("dump_on_warning", cfg.dump_on_warning);
+            cfg.directory = h.value("directory", cfg.directory);
+            cfg.budget_mb = (std::max)(1, h.value("budget_mb", cfg.budget_mb));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Could not parse pose_history from settings.json: " << e.what() << std::endl;
+    }
+    return cfg;
+}
+
+// "logging" in settings.json: where the asynchronous log sink writes besides the console
+struct LoggingConfig {
+    int level = LEVEL_DEBUG;         // Lowest LogLevel written
+    // Session log files, written whether or not the console is open; need a restart
+    std::string directory;           // Empty (default) for none
+    int segment_kb = 1024;           // Size of one file
+    double rotate_minutes = 60.0;    // Start a new file after this long even if not full
+    int budget_mb = 50;              // Oldest files are deleted past this
+    int backlog_lines = 500;         // Recent lines shown when the status window opens; needs a restart
+};
+
+LoggingConfig load_logging_settings(const nlohmann::json& j) {
+    LoggingConfig cfg;
+    try {
+        if (j.contains("logging") && j["logging"].is_object()) {
+            const nlohmann::json& l = j["logging"];
+            static const char* const kLevelNames[] = {"debug", "info", "warning", "error"};
+            std::string level = l.value("level", std::string(kLevelNames[cfg.level]));
+            for (int n = LEVEL_DEBUG; n <= LEVEL_ERROR; ++n) {
+                if (level == kLevelNames[n]) cfg.level = n;
+            }
+            cfg.directory = l.value("directory", cfg.directory);
+            cfg.segment_kb = (std::max)(64, (std::min)(65536, l.value("segment_kb", cfg.segment_kb)));
+            cfg.rotate_minutes = (std::max)(1.0, l.value("rotate_minutes", cfg.rotate_minutes));
+            cfg.budget_mb = (std::max)(1, l.value("budget_mb", cfg.budget_mb));
+            cfg.backlog_lines = (std::max)(0, (std::min)(100000, l.value("backlog_lines", cfg.backlog_lines)));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Could not parse logging from settings.json: " << e.what() << std::endl;
+    }
+    return cfg;
+}
+
+// "memory" in settings.json. In budget mode the decoded alarm clips are dropped between
+// flights (decoded again at flight start) and the working set is trimmed once a flight
+// ends, for a tray process that idles in a few MB.
+struct MemoryConfig {
+    bool budget_mode = false;
+};
+
+MemoryConfig load_memory_settings(const nlohmann::json& j) {
+    MemoryConfig cfg;
+    try {
+        if (j.contains("memory") && j["memory"].is_object()) {
+            cfg.budget_mode = j["memory"].value("budget_mode", cfg.budget_mode);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Could not parse memory from settings.json: " << e.what() << std::endl;
+    }
+    return cfg;
+}
+
+// Give the process's pages back to Windows; the ones still in use fault back in as needed
+void trim_working_set() {
+    SetProcessWorkingSetSizeEx(GetCurrentProcess(), static_cast<SIZE_T>(-1), static_cast<SIZE_T>(-1), 0);
+}
+
+// [INFO] line with the working set and private bytes
+void report_memory_footprint(const char* when) {
+    PROCESS_MEMORY_COUNTERS_EX counters = {};
+    counters.cb = sizeof(counters);
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters), sizeof(counters))) return;
+    std::cout << "[INFO] Memory " << when << ": working set " << std::fixed << std::setprecision(1)
+              << counters.WorkingSetSize / 1048576.0 << " MB, private " << counters.PrivateUsage / 1048576.0 << " MB"
+              << std::defaultfloat << std::endl;
+}
+
+// "metrics" in settings.json: how often and where the metrics registry is written
+struct MetricsConfig {
+    int interval_ms = 5000;
+    bool console = true;   // [METRICS] lines in the status window
+    std::string file;      // JSON lines appended when set
+};
+
+MetricsConfig load_metrics_settings(const nlohmann::json& j) {
+    MetricsConfig cfg;
+    try {
+        if (j.contains("metrics") && j["metrics"].is_object()) {
+            const nlohmann::json& m = j["metrics"];
+            cfg.interval_ms = (std::max)(100, (std::min)(600000, m.value("interval_ms", cfg.interval_ms)));
+            cfg.console = m.value("console", cfg.console);
+            cfg.file = m.value("file", cfg.file);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Could not parse metrics from settings.json: " << e.what() << std::endl;
+    }
+    return cfg;
+}
+
+// "telemetry" in settings.json: the shared-memory scan state block for overlays
+struct TelemetryConfig {
+    bool shared_memory = true;
+    std::string name = "Local\\QuestLookoutTelemetry"; // File mapping name
+};
+
+TelemetryConfig load_telemetry_settings(const nlohmann::json& j) {
+    TelemetryConfig cfg;
+    try {
+        if (j.contains("telemetry") && j["telemetry"].is_object()) {
+            const nlohmann::json& t = j["telemetry"];
+            cfg.shared_memory = t.value("shared_memory", cfg.shared_memory);
+            cfg.name = t.value("name", cfg.name);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Could not parse telemetry from settings.json: " << e.what() << std::endl;
+    }
+    return cfg;
+}
+
+// "udp_stream" in settings.json: pose and alarm state sent to another PC
+struct UdpStreamConfig {
+    bool enabled = false;
+    std::string host = "127.0.0.1"; // Name or address; 255.255.255.255 broadcasts on the LAN
+    int port = 55301;
+    double rate_hz = 30.0;           // Samples sent per second
+    int samples_per_datagram = 3;
+};
+
+UdpStreamConfig load_udp_stream_settings(const nlohmann::json& j) {
+    UdpStreamConfig cfg;
+    try {
+        if (j.contains("udp_stream") && j["udp_stream"].is_object()) {
+            const nlohmann::json& u = j["udp_stream"];
+            cfg.enabled = u.value("enabled", cfg.enabled);
+            cfg.host = u.value("host", cfg.host);
+            cfg.port = (std::max)(1, (std::min)(65535, u.value("port", cfg.port)));
+            cfg.rate_hz = (std::max)(1.0, (std::min)(500.0, u.value("rate_hz", cfg.rate_hz)));
+            cfg.samples_per_datagram = (std::max)(1, (std::min)(32, u.value("samples_per_datagram", cfg.samples_per_datagram)));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Could not parse udp_stream from settings.json: " << e.what() << std::endl;
+    }
+    return cfg;
+}
+
+// "fleet" in settings.json: reporting to a lookout_hub found on the LAN
+struct FleetConfig {
+    bool enabled = false;
+    std::string name;                // Station name shown on the hub; empty for the computer name
+    int discovery_port = LOOKOUT_FLEET_DISCOVERY_PORT;
+    double pose_rate_hz = 1.0;       // Poses sent per second; 0 for none
+    double batch_s = 5.0;            // Alarm events are sent this often
+    bool accept_settings = false;    // Let a hub's --push replace settings.json
+};
+
+FleetConfig load_fleet_settings(const nlohmann::json& j) {
+    FleetConfig cfg;
+    try {
+        if (j.contains("fleet") && j["fleet"].is_object()) {
+            const nlohmann::json& f = j["fleet"];
+            cfg.enabled = f.value("enabled", cfg.enabled);
+            cfg.name = f.value("name", cfg.name).substr(0, sizeof(LookoutFleetHello::name) - 1);
+            cfg.discovery_port = (std::max)(1, (std::min)(65535, f.value("discovery_port", cfg.discovery_port)));
+            cfg.pose_rate_hz = (std::max)(0.0, (std::min)(10.0, f.value("pose_rate_hz", cfg.pose_rate_hz)));
+            cfg.batch_s = (std::max)(1.0, (std::min)(60.0, f.value("batch_s", cfg.batch_s)));
+            cfg.accept_settings = f.value("accept_settings", cfg.accept_settings);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Could not parse fleet from settings.json: " << e.what() << std::endl;
+    }
+    return cfg;
+}
+
+// "flight_history" in settings.json: a summary and the alarm events of every flight,
+// appended to an indexed file (lookout_history.hpp) for following a pilot's progress.
+// The pilot is read at each flight start, so changing it needs no restart.
+struct FlightHistoryConfig {
+    bool enabled = true;
+    std::string file = "flight_history.qlfh";
+    std::string pilot;               // Empty for the Windows user name
+    int max_events = 20000;          // Per flight; later ones are counted but not kept
+};
+
+FlightHistoryConfig load_flight_history_settings(const nlohmann::json& j) {
+    FlightHistoryConfig cfg;
+    try {
+        if (j.contains("flight_history") && j["flight_history"].is_object()) {
+            const nlohmann::json& h = j["flight_history"];
+            cfg.enabled = h.value("enabled", cfg.enabled);
+            cfg.file = h.value("file", cfg.file);
+            cfg.pilot = h.value("pilot", cfg.pilot);
+            cfg.max_events = (std::max)(100, (std::min)(1000000, h.value("max_events", cfg.max_events)));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Could not parse flight_history from settings.json: " << e.what() << std::endl;
+    }
+    if (cfg.pilot.empty()) {
+        const char* user = std::getenv("USERNAME");
+        cfg.pilot = user ? user : "pilot";
+    }
+    return cfg;
+}
+
+// "scan_heatmap" in settings.json: where the pilot looked over each flight, as dwell
+// time in yaw x pitch bins, saved when the flight ends
+struct ScanHeatmapConfig {
+    bool enabled = true;
+    double bin_deg = 5.0;            // Bin size; rounded so the bins tile 360 x 180 degrees
+    std::string directory = "scan_heatmaps";
+    bool csv = true;                 // Seconds per bin, rows by pitch and columns by yaw
+    bool image = true;               // The same grid as a BMP, brighter for longer dwell
+    int budget_mb = 100;             // Oldest saves are deleted past this
+};
+
+ScanHeatmapConfig load_scan_heatmap_settings(const nlohmann::json& j) {
+    ScanHeatmapConfig cfg;
+    try {
+        if (j.contains("scan_heatmap") && j["scan_heatmap"].is_object()) {
+            const nlohmann::json& h = j["scan_heatmap"];
+            cfg.enabled = h.value("enabled", cfg.enabled);
+            cfg.bin_deg = (std::max)(1.0, (std::min)(30.0, h.value("bin_deg", cfg.bin_deg)));
+            cfg.directory = h.value("directory", cfg.directory);
+            cfg.csv = h.value("csv", cfg.csv);
+            cfg.image = h.value("image", cfg.image);
+            cfg.budget_mb = (std::max)(1, h.value("budget_mb", cfg.budget_mb));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Could not parse scan_heatmap from settings.json: " << e.what() << std::endl;
+    }
+    if (!cfg.csv && !cfg.image) cfg.enabled = false;
+    return cfg;
+}
+
+// "plugins" in settings.json: scan-rule DLLs (lookout_plugin.h) loaded from a folder
+struct PluginsConfig {
+    bool enabled = false;
+    std::string directory = "plugins";
+    double budget_ms = 2.0;          // Longest a plugin callback should take
+};
+
+PluginsConfig load_plugins_settings(const nlohmann::json& j) {
+    PluginsConfig cfg;
+    try {
+        if (j.contains("plugins") && j["plugins"].is_object()) {
+            const nlohmann::json& p = j["plugins"];
+            cfg.enabled = p.value("enabled", cfg.enabled);
+            cfg.directory = p.value("directory", cfg.directory);
+            cfg.budget_ms = (std::max)(0.1, p.value("budget_ms", cfg.budget_ms));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Could not parse plugins from settings.json: " << e.what() << std::endl;
+    }
+    return cfg;
+}
+
+// "pose_trace" in settings.json: every headset sample recorded to a binary file
+struct PoseTraceConfig {
+    bool enabled = false;
+    std::string directory = "pose_traces";
+    int chunk_mb = 4;                // The file grows by this much at a time
+    bool archive = true;             // Compress to a .qlpz when the session ends, replacing the raw trace
+};
+
+PoseTraceConfig load_pose_trace_settings(const nlohmann::json& j) {
+    PoseTraceConfig cfg;
+    try {
+        if (j.contains("pose_trace") && j["pose_trace"].is_object()) {
+            const nlohmann::json& t = j["pose_trace"];
+            cfg.enabled = t.value("enabled", cfg.enabled);
+            cfg.directory = t.value("directory", cfg.directory);
+            cfg.chunk_mb = (std::max)(1, (std::min)(256, t.value("chunk_mb", cfg.chunk_mb)));
+            cfg.archive = t.value("archive", cfg.archive);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Could not parse pose_trace from settings.json: " << e.what() << std::endl;
+    }
+    return cfg;
+}
+
+// The latest Condor flight data. Fields Condor didn't send stay NaN.
+struct CondorTelemetry {
+    int64_t received_us = 0; // Engine clock of the newest datagram; 0 before the first
+    uint64_t datagrams = 0;
+    double altitude_m = NAN;   // MSL
+    double height_m = NAN;     // AGL
+    double airspeed_ms = NAN;
+    double vario_ms = NAN;
+
+    bool fresh(int64_t now_us, const CondorUdpConfig& config) const {
+        return received_us != 0 && now_us - received_us <= seconds_to_us(config.stale_after_s);
+    }
+    bool on_ground(const CondorUdpConfig& config) const {
+        return height_m < config.on_ground_height_m && airspeed_ms < config.on_ground_speed_ms;
+    }
+};
+
+// Non-blocking listener for Condor's UDP output. There is no thread of its own: the
+// core drains the socket once per tick, parses each datagram in place, and publishes
+// the newest values through a seqlock so any other thread can read them without
+// locking. A datagram is "key=value" lines; unknown keys are skipped.
+class CondorUdpListener {
+public:
+    explicit CondorUdpListener(CondorUdpConfig config) : config_(config) {}
+
+    bool start() {
+        if (!config_.enabled) return false;
+        socket_.setBlocking(false);
+        if (socket_.bind(static_cast<unsigned short>(config_.port)) != sf::Socket::Status::Done) {
+            std::cerr << "[WARNING] Cannot listen for Condor UDP telemetry on port " << config_.port << std::endl;
+            return false;
+        }
+        listening_ = true;
+        std::cout << "[INFO] Listening for Condor UDP telemetry on port " << config_.port << std::endl;
+        return true;
+    }
+
+    bool listening() const { return listening_; }
+    const CondorUdpConfig& config() const { return config_; }
+
+    // Core thread, once per tick: take every queued datagram; the newest values win
+    void poll(int64_t now_us) {
+        if (!listening_) return;
+        bool received_any = false;
+        while (true) {
+            std::size_t received = 0;
+            std::optional<sf::IpAddress> sender;
+            unsigned short sender_port = 0;
+            if (socket_.receive(buffer_.data(), buffer_.size() - 1, received, sender, sender_port) != sf::Socket::Status::Done) break;
+            parse(buffer_.data(), received);
+            received_any = true;
+        }
+        if (!received_any) return;
+        current_.received_us = now_us;
+        telemetry_.store(current_);
+        if (current_.datagrams == 1) std::cout << "[INFO] Receiving Condor UDP telemetry" << std::endl;
+    }
+
+    CondorTelemetry latest() const { return telemetry_.load(); }
+
+private:
+    struct Field {
+        const char* key;
+        size_t length;
+        double CondorTelemetry::*value;
+    };
+
+    void parse(char* data, size_t size) {
+        static const Field fields[] = {
+            { "altitude", 8, &CondorTelemetry::altitude_m },
+            { "height", 6, &CondorTelemetry::height_m },
+            { "airspeed", 8, &CondorTelemetry::airspeed_ms },
+            { "vario", 5, &CondorTelemetry::vario_ms },
+        };
+        data[size] = '\0'; // Room was left for it; lets strtod stop at the end
+        char* line = data;
+        char* end = data + size;
+        while (line < end) {
+            char* line_end = static_cast<char*>(std::memchr(line, '\n', end - line));
+            if (!line_end) line_end = end;
+            *line_end = '\0';
+            if (char* equals = static_cast<char*>(std::memchr(line, '=', line_end - line))) {
+                size_t key_length = equals - line;
+                for (const Field& field : fields) {
+                    if (field.length != key_length || _strnicmp(line, field.key, key_length) != 0) continue;
+                    char* parsed = nullptr;
+                    double value = std::strtod(equals + 1, &parsed);
+                    if (parsed != equals + 1) current_.*field.value = value;
+                    break;
+                }
+            }
+            line = line_end + 1;
+        }
+        ++current_.datagrams;
+    }
+
+    CondorUdpConfig config_;
+    sf::UdpSocket socket_;
+    bool listening_ = false;
+    std::array<char, 2048> buffer_{};   // Condor's datagrams are a few hundred bytes
+    CondorTelemetry current_;           // Core thread only
+    SeqLock<CondorTelemetry> telemetry_;
+};
+
+// Read-only memory-mapped file as an SFML input stream. Decoders read straight out of
+// the page cache instead of through a buffered file read, and a long clip costs address
+// space rather than committed heap. The mapping lives as long as the stream.
+class MappedFileStream : public sf::InputStream {
+public:
+    MappedFileStream() = default;
+    ~MappedFileStream() override { close(); }
+    MappedFileStream(const MappedFileStream&) = delete;
+    MappedFileStream& operator=(const MappedFileStream&) = delete;
+
+    bool open(const std::string& path) {
+        close();
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size{};
+        if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping) {
+                data_ = static_cast<const std::uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                CloseHandle(mapping); // The view keeps the mapping alive
+            }
+            if (data_) size_ = static_cast<std::size_t>(size.QuadPart);
+        }
+        CloseHandle(file);
+        position_ = 0;
+        return data_ != nullptr;
+    }
+
+    void close() {
+        if (data_) UnmapViewOfFile(data_);
+        data_ = nullptr;
+        size_ = position_ = 0;
+    }
+
+    std::optional<std::size_t> read(void* data, std::size_t size) override {
+        if (!data_) return std::nullopt;
+        std::size_t count = (std::min)(size, size_ - position_);
+        std::memcpy(data, data_ + position_, count);
+        position_ += count;
+        return count;
+    }
+
+    std::optional<std::size_t> seek(std::size_t position) override {
+        if (!data_) return std::nullopt;
+        position_ = (std::min)(position, size_);
+        return position_;
+    }
+
+    std::optional<std::size_t> tell() override { return data_ ? std::optional<std::size_t>(position_) : std::nullopt; }
+    std::optional<std::size_t> getSize() override { return data_ ? std::optional<std::size_t>(size_) : std::nullopt; }
+
+private:
+    const std::uint8_t* data_ = nullptr;
+    std::size_t size_ = 0;
+    std::size_t position_ = 0;
+};
+
+// Alarm audio settings ("audio" in settings.json)
+struct AudioConfig {
+    double stream_above_seconds = 30.0; // Longer clips stream from disk instead of being decoded
+    int duck_volume = 40;               // Narrower alarms' volume (%) while a wider one sounds
+};
+
+AudioConfig load_audio_settings(const nlohmann::json& j) {
+    AudioConfig cfg;
+    try {
+        if (j.contains("audio") && j["audio"].is_object()) {
+            const nlohmann::json& a = j["audio"];
+            cfg.stream_above_seconds = (std::max)(0.0, a.value("stream_above_seconds", cfg.stream_above_seconds));
+            cfg.duck_volume = (std::max)(0, (std::min)(100, a.value("duck_volume", cfg.duck_volume)));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Could not parse audio from settings.json: " << e.what() << std::endl;
+    }
+    return cfg;
+}
+
+struct CenterResetConfig {
+    double window_degrees = 20.0;
+    double hold_time_seconds = 3.0;
+};
+
+CenterResetConfig load_center_reset_settings(const nlohmann::json& j) {
+    CenterResetConfig cfg;
+    try {
+        if (j.contains("center_reset")) {
+            if (j["center_reset"].contains("window_degrees") && j["center_reset"]["window_degrees"].is_number())
+                cfg.window_degrees = j["center_reset"]["window_degrees"].get<double>();
+            if (j["center_reset"].contains("hold_time_seconds") && j["center_reset"]["hold_time_seconds"].is_number())
+                cfg.hold_time_seconds = j["center_reset"]["hold_time_seconds"].get<double>();
+        }
+    } catch (const nlohmann::json::type_error& e) {
+        std::cerr << "[WARNING] Type error for center_reset in settings.json: " << e.what() << std::endl;
+    }
+    return cfg;
+}
+
+// Blocks the running threads are built from at startup (sampler, watchdog, pose source,
+// Condor log watcher, detector, input hook); a reload reports changes to them as
+// needing a restart instead of applying them
+const char* const RESTART_ONLY_SETTINGS[] = {
+    "sampling", "watchdog", "pose_source", "condor_log", "condor_udp", "pose_history", "metrics", "telemetry", "udp_stream", "pose_trace", "sim_profiles", "threads",
+    "fleet", "scan_heatmap", "scan_overlay", "flight_inference", "plugins", "recenter_hotkey", "hotkeys", "recenter_buttons", "resume", "cpu_budget"
+};
+
+// Blocks a lookout_hub push may not change besides the restart-only ones (which include
+// the plugins, traces and resume file): those naming the startup task or files written.
+// A push must carry all of them as the station's settings.json has them.
+const char* const FLEET_LOCAL_SETTINGS[] = { "start_with_windows", "startup", "logging", "flight_history" };
+
+// Everything settings.json configures, parsed once and never modified afterwards. The
+// same snapshot is handed to every consumer instead of each re-reading the file.
+struct Settings {
+    std::vector<LookoutAlarmConfig> alarms;  // Every profile's alarms
+    std::vector<AlarmProfile> profiles;      // [0] is "default", the top-level "alarms"
+    std::string active_profile = "default";  // Profile selected at startup
+    CenterResetConfig center_reset;
+    HotkeySettings hotkeys;
+    bool start_with_windows = false;
+    StartupConfig startup;
+    SamplingConfig sampling;
+    ThreadPlacementConfig threads;
+    CpuBudgetConfig cpu_budget;
+    FilterConfig filter;
+    WatchdogConfig watchdog;
+    ResumeConfig resume;
+    PoseSourceConfig pose_source;
+    ScanOverlayConfig scan_overlay;
+    CondorLogConfig condor_log;
+    FlightInferenceConfig flight_inference;
+    CondorUdpConfig condor_udp;
+    PoseHistoryConfig pose_history;
+    LoggingConfig logging;
+    MemoryConfig memory;
+    MetricsConfig metrics;
+    TelemetryConfig telemetry;
+    UdpStreamConfig udp_stream;
+    FleetConfig fleet;
+    FlightHistoryConfig flight_history;
+    ScanHeatmapConfig scan_heatmap;
+    PluginsConfig plugins;
+    PoseTraceConfig pose_trace;
+    AudioConfig audio;
+    std::vector<SimProfile> sim_profiles;
+    // Fingerprints of the document instead of the parsed DOM, which is freed once loaded:
+    // each RESTART_ONLY_SETTINGS block as written, to spot edits, and the whole document,
+    // to skip reapplying the same settings
+    std::array<uint64_t, sizeof(RESTART_ONLY_SETTINGS) / sizeof(RESTART_ONLY_SETTINGS[0])> restart_only{};
+    uint64_t document = 0;
+    bool loaded = true; // From a document that parsed; false for the defaults after a missing or broken file
+};
+
+// FNV-1a of a JSON value's serialization
+uint64_t json_fingerprint(const nlohmann::json& value) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : value.dump()) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Problems in a settings document that the loaders would otherwise paper over with
+// defaults: wrong types for a block, or an alarm that doesn't convert. Empty when the
+// document is fine. Used for pushed settings, which are rejected rather than applied
+// half-right.
+std::vector<std::string> validate_settings_document(const nlohmann::json& j) {
+    std::vector<std::string> errors;
+    static const char* const object_blocks[] = {
+        "center_reset", "hotkeys", "sampling", "filter", "watchdog", "pose_source", "condor_log", "condor_udp", "pose_history", "logging", "memory", "metrics", "telemetry", "udp_stream", "pose_trace", "audio", "threads", "fleet", "flight_history", "scan_heatmap", "scan_overlay", "flight_inference", "plugins", "startup", "resume", "cpu_budget"
+    };
+    for (const char* key : object_blocks) {
+        if (j.contains(key) && !j[key].is_object()) errors.push_back(std::string("\"") + key + "\" must be an object");
+    }
+    if (j.contains("start_with_windows") && !j["start_with_windows"].is_boolean()) {
+        errors.push_back("\"start_with_windows\" must be true or false");
+    }
+    if (j.contains("sim_profiles") && !j["sim_profiles"].is_array()) errors.push_back("\"sim_profiles\" must be a list");
+    // Count of enabled alarms in one alarm list, reporting its problems under `name`
+    auto check_alarms = [&](const nlohmann::json& list, const std::string& name) -> size_t {
+        size_t enabled = 0;
+        for (size_t i = 0; i < list.size(); ++i) {
+            std::string where = name + "[" + std::to_string(i) + "]: ";
+            try {
+                LookoutAlarmConfig alarm = list[i].get<LookoutAlarmConfig>();
+                if (!alarm.enabled()) continue;
+                ++enabled;
+                if (alarm.max_time_ms <= 0) errors.push_back(where + "max_time_ms must be positive");
+                if (alarm.min_dwell_ms < 0) errors.push_back(where + "min_dwell_ms can't be negative");
+                if (alarm.hysteresis_deg < 0 || alarm.hysteresis_cm < 0) errors.push_back(where + "hysteresis can't be negative");
+                if (alarm.min_coverage_percent < 0 || alarm.min_coverage_percent > 100) {
+                    errors.push_back(where + "min_coverage_percent must be between 0 and 100");
+                }
+                if (alarm.start_volume < 0 || alarm.start_volume > 100 || alarm.end_volume < 0 || alarm.end_volume > 100) {
+                    errors.push_back(where + "volumes must be between 0 and 100");
+                }
+                if (!alarm.audio_file.empty() && GetFileAttributesA(alarm.audio_file.c_str()) == INVALID_FILE_ATTRIBUTES) {
+                    errors.push_back(where + "audio file not found: " + alarm.audio_file);
+                }
+            } catch (const nlohmann::json::exception& e) {
+                errors.push_back(where + e.what());
+            }
+        }
+        return enabled;
+    };
+    if (!j.contains("alarms") || !j["alarms"].is_array()) {
+        errors.push_back("\"alarms\" must be a list");
+        return errors;
+    }
+    if (check_alarms(j["alarms"], "alarms") == 0) errors.push_back("no enabled alarms");
+
+    std::set<std::string> profile_names = { "default" };
+    if (j.contains("alarm_profiles")) {
+        if (!j["alarm_profiles"].is_array()) {
+            errors.push_back("\"alarm_profiles\" must be a list");
+        } else {
+            for (size_t k = 0; k < j["alarm_profiles"].size(); ++k) {
+                const nlohmann::json& p = j["alarm_profiles"][k];
+                std::string where = "alarm_profiles[" + std::to_string(k) + "]";
+                if (!p.is_object() || !p.contains("name") || !p["name"].is_string() || p["name"].get<std::string>().empty()) {
+                    errors.push_back(where + ": needs a \"name\"");
+                    continue;
+                }
+                std::string name = p["name"].get<std::string>();
+                if (!profile_names.insert(to_lower_ascii(name)).second) errors.push_back(where + ": profile \"" + name + "\" is defined twice");
+                if (p.contains("sim") && !p["sim"].is_string()) errors.push_back(where + ": \"sim\" must be text");
+                if (p.contains("above_height_m") && !p["above_height_m"].is_number()) {
+                    errors.push_back(where + ": \"above_height_m\" must be a number");
+                }
+                if (!p.contains("alarms") || !p["alarms"].is_array()) {
+                    errors.push_back(where + ": \"alarms\" must be a list");
+                } else if (check_alarms(p["alarms"], name) == 0) {
+                    errors.push_back(where + ": no enabled alarms");
+                }
+            }
+        }
+    }
+    if (j.contains("active_profile") &&
+        (!j["active_profile"].is_string() || profile_names.count(to_lower_ascii(j["active_profile"].get<std::string>())) == 0)) {
+        errors.push_back("\"active_profile\" must name \"default\" or one of alarm_profiles");
+    }
+    return errors;
+}
+
+std::shared_ptr<const Settings> settings_from_document(const nlohmann::json& j, bool loaded = true) {
+    auto settings = std::make_shared<Settings>();
+    settings->loaded = loaded;
+    settings->alarms = load_alarm_settings(j);
+    settings->profiles = load_alarm_profiles(j, settings->alarms);
+    settings->center_reset = load_center_reset_settings(j);
+    settings->hotkeys = load_hotkey_settings(j);
+    try {
+        settings->start_with_windows = j.value("start_with_windows", false);
+    } catch (const std::exception& e) {
+        std::cout << "[WARNING] Could not parse startup setting from settings.json: " << e.what() << std::endl;
+    }
+    settings->startup = load_startup_settings(j);
+    try {
+        settings->active_profile = j.value("active_profile", settings->active_profile);
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Could not parse active_profile from settings.json: " << e.what() << std::endl;
+    }
+    settings->sampling = load_sampling_settings(j);
+    settings->threads = load_thread_settings(j);
+    settings->cpu_budget = load_cpu_budget_settings(j);
+    settings->filter = load_filter_settings(j);
+    settings->watchdog = load_watchdog_settings(j);
+    settings->resume = load_resume_settings(j);
+    settings->pose_source = load_pose_source_settings(j);
+    settings->scan_overlay = load_scan_overlay_settings(j);
+    settings->condor_log = load_condor_log_settings(j);
+    settings->flight_inference = load_flight_inference_settings(j);
+    settings->condor_udp = load_condor_udp_settings(j);
+    settings->pose_history = load_pose_history_settings(j);
+    settings->logging = load_logging_settings(j);
+    settings->memory = load_memory_settings(j);
+    settings->metrics = load_metrics_settings(j);
+    settings->telemetry = load_telemetry_settings(j);
+    settings->udp_stream = load_udp_stream_settings(j);
+    settings->fleet = load_fleet_settings(j);
+    settings->flight_history = load_flight_history_settings(j);
+    settings->scan_heatmap = load_scan_heatmap_settings(j);
+    settings->plugins = load_plugins_settings(j);
+    settings->pose_trace = load_pose_trace_settings(j);
+    settings->audio = load_audio_settings(j);
+    settings->sim_profiles = load_sim_profiles(j);
+    for (size_t k = 0; k < settings->restart_only.size(); ++k) {
+        settings->restart_only[k] = json_fingerprint(j.value(RESTART_ONLY_SETTINGS[k], nlohmann::json()));
+    }
+    settings->document = json_fingerprint(j);
+    return settings;
+}
+
+std::shared_ptr<const Settings> load_settings(const std::string& filename, bool* ok = nullptr) {
+    bool read = false;
+    const nlohmann::json j = read_settings_json(filename, &read);
+    if (ok) *ok = read;
+    return settings_from_document(j, read);
+}
+
+// Last write time and size, to tell whether a file changed since it was last read; 0
+// when it can't be read
+uint64_t file_write_stamp(const std::string& path) {
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &data)) return 0;
+    uint64_t time = (static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+    return time ^ (static_cast<uint64_t>(data.nFileSizeHigh) << 32 | data.nFileSizeLow);
+}
+
+// Picks up settings saved while running (settings_gui.exe) without a restart. A thread
+// waits on ReadDirectoryChangesW for the settings file's directory; when the file
+// changes it waits for the writer to finish, parses it off the core thread and
+// publishes the new snapshot with an atomic pointer exchange. The core takes it
+// between ticks. A file that doesn't parse (caught mid-write) is left for the next
+// change and the running settings stay in place.
+class SettingsWatcher {
+public:
+    static constexpr DWORD kSettleMs = 200; // Editors save in several writes
+
+    explicit SettingsWatcher(std::string path) : path_(std::move(path)) {}
+    ~SettingsWatcher() { stop(); }
+    SettingsWatcher(const SettingsWatcher&) = delete;
+    SettingsWatcher& operator=(const SettingsWatcher&) = delete;
+
+    void start() {
+        size_t slash = path_.find_last_of("\\/");
+        directory_ = slash == std::string::npos ? std::string(".") : path_.substr(0, slash);
+        std::string name = slash == std::string::npos ? path_ : path_.substr(slash + 1);
+        file_name_.assign(name.begin(), name.end());
+        stamp_ = file_write_stamp(path_);
+        stop_event_ = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        thread_ = std::thread(&SettingsWatcher::watch, this);
+    }
+
+    void stop() {
+        if (stop_event_) SetEvent(stop_event_);
+        if (thread_.joinable()) thread_.join();
+        if (stop_event_) CloseHandle(stop_event_);
+        stop_event_ = nullptr;
+    }
+
+    // Core thread, at a tick boundary: the newest snapshot since the last call, if any
+    std::shared_ptr<const Settings> take() {
+        return std::atomic_exchange(&pending_, std::shared_ptr<const Settings>());
+    }
+
+private:
+    void watch() {
+        place_background_thread();
+        ThreadCpuScope cpu_scope(CPU_CONTROL);
+        HANDLE directory = CreateFileA(directory_.c_str(), FILE_LIST_DIRECTORY,
+                                       FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                       FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+        if (directory == INVALID_HANDLE_VALUE) {
+            std::cerr << "[WARNING] Cannot watch " << path_ << " for changes (error=" << GetLastError()
+                      << "); settings apply on restart only" << std::endl;
+            return;
+        }
+
+        HANDLE change_event = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        alignas(DWORD) char notifications[4096];
+        while (true) {
+            OVERLAPPED overlapped = {};
+            overlapped.hEvent = change_event;
+            ResetEvent(change_event);
+            if (!ReadDirectoryChangesW(directory, notifications, sizeof(notifications), FALSE,
+                                       FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE,
+                                       nullptr, &overlapped, nullptr)) {
+                std::cerr << "[WARNING] Settings watch failed (error=" << GetLastError() << ")" << std::endl;
+                break;
+            }
+            HANDLE handles[2] = { change_event, stop_event_ };
+            DWORD signaled = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+            DWORD bytes = 0;
+            if (signaled != WAIT_OBJECT_0) {
+                CancelIoEx(directory, &overlapped);
+                GetOverlappedResult(directory, &overlapped, &bytes, TRUE); // Buffer must outlive the I/O
+                break;
+            }
+            GetOverlappedResult(directory, &overlapped, &bytes, FALSE);
+            // An overflowed buffer (bytes == 0) names nothing, so check the file anyway
+            if (bytes != 0 && !names_settings_file(notifications, bytes)) continue;
+            if (WaitForSingleObject(stop_event_, kSettleMs) == WAIT_OBJECT_0) break;
+            reload();
+        }
+        CloseHandle(change_event);
+        CloseHandle(directory);
+    }
+
+    bool names_settings_file(const char* notifications, DWORD bytes) const {
+        for (DWORD offset = 0; offset < bytes;) {
+            const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(notifications + offset);
+            size_t length = info->FileNameLength / sizeof(WCHAR);
+            if (length == file_name_.size() && _wcsnicmp(info->FileName, file_name_.c_str(), length) == 0) return true;
+            if (info->NextEntryOffset == 0) break;
+            offset += info->NextEntryOffset;
+        }
+        return false;
+    }
+
+    void reload() {
+        uint64_t stamp = file_write_stamp(path_);
+        if (stamp == 0 || stamp == stamp_) return; // Gone for a moment, or touched but not rewritten
+        bool ok = false;
+        std::shared_ptr<const Settings> settings = load_settings(path_, &ok);
+        if (!ok) {
+            std::cerr << "[WARNING] " << path_ << " changed but could not be read; keeping the current settings" << std::endl;
+            return;
+        }
+        stamp_ = stamp;
+        std::atomic_store(&pending_, settings);
+        wake_core_thread();
+    }
+
+    std::string path_, directory_;
+    std::wstring file_name_;
+    uint64_t stamp_ = 0;
+    std::shared_ptr<const Settings> pending_; // Only through std::atomic_load/store/exchange
+    HANDLE stop_event_ = nullptr;
+    std::thread thread_;
+};
+
+// Named pipe settings_gui pushes settings to, so an edit applies at the next tick
+// instead of after the file watch settles, and the GUI hears back at once whether the
+// settings were accepted. Each connection sends one message (a complete settings
+// document, {"select_profile": "<alarm profile>"} to switch profiles, or {"command":
+// "<CORE_COMMAND_NAMES entry>"}, as a second lookout.exe forwards them) and gets one
+// reply:
+//   {"ok": true}  or  {"ok": false, "errors": ["...", ...]}
+// A payload is parsed and validated on the pipe thread; only an accepted one is
+// published, the same way SettingsWatcher publishes a reloaded file. Local clients
+// only, one at a time.
+class SettingsPipeServer {
+public:
+    static constexpr const char* kPipeName = "\\\\.\\pipe\\QuestLookout.settings";
+    static constexpr DWORD kMaxMessageBytes = 1 << 20;
+    static constexpr DWORD kClientTimeoutMs = 2000; // A client that connects and stalls
+
+    SettingsPipeServer() = default;
+    ~SettingsPipeServer() { stop(); }
+    SettingsPipeServer(const SettingsPipeServer&) = delete;
+    SettingsPipeServer& operator=(const SettingsPipeServer&) = delete;
+
+    void start() {
+        stop_event_ = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        thread_ = std::thread(&SettingsPipeServer::serve, this);
+    }
+
+    void stop() {
+        if (stop_event_) SetEvent(stop_event_);
+        if (thread_.joinable()) thread_.join();
+        if (stop_event_) CloseHandle(stop_event_);
+        stop_event_ = nullptr;
+    }
+
+    // Core thread, at a tick boundary: the newest accepted push since the last call, if any
+    std::shared_ptr<const Settings> take() {
+        return std::atomic_exchange(&pending_, std::shared_ptr<const Settings>());
+    }
+
+    // Core thread: the newest requested alarm profile name since the last call, if any
+    std::shared_ptr<const std::string> take_profile() {
+        return std::atomic_exchange(&pending_profile_, std::shared_ptr<const std::string>());
+    }
+
+    // Core thread: the settings in force, to check profile names against
+    void set_active(std::shared_ptr<const Settings> settings) {
+        std::atomic_store(&active_, std::move(settings));
+    }
+
+private:
+    void serve() {
+        place_background_thread();
+        ThreadCpuScope cpu_scope(CPU_CONTROL);
+        HANDLE pipe = CreateNamedPipeA(kPipeName, PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+                                       PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                                       1, kMaxMessageBytes, kMaxMessageBytes, 0, nullptr);
+        if (pipe == INVALID_HANDLE_VALUE) {
+            std::cerr << "[WARNING] Cannot create settings pipe (error=" << GetLastError()
+                      << "); settings_gui changes apply through settings.json only" << std::endl;
+            return;
+        }
+        io_event_ = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        std::cout << "[INFO] Accepting settings pushes on " << kPipeName << std::endl;
+        std::vector<char> buffer(64 * 1024);
+        while (true) {
+            OVERLAPPED overlapped = {};
+            overlapped.hEvent = io_event_;
+            ResetEvent(io_event_);
+            DWORD bytes = 0;
+            bool connected = ConnectNamedPipe(pipe, &overlapped) != FALSE || GetLastError() == ERROR_PIPE_CONNECTED;
+            if (!connected && GetLastError() == ERROR_IO_PENDING) {
+                if (wait(pipe, overlapped, bytes, INFINITE) == IoResult::stopped) break;
+                connected = true;
+            }
+            if (!connected) {
+                std::cerr << "[WARNING] Settings pipe connect failed (error=" << GetLastError() << ")" << std::endl;
+                if (WaitForSingleObject(stop_event_, 1000) == WAIT_OBJECT_0) break;
+                continue;
+            }
+
+            bool stopping = false;
+            std::string request;
+            if (read_message(pipe, buffer, request, stopping)) {
+                std::string reply = handle(request).dump();
+                OVERLAPPED write = {};
+                write.hEvent = io_event_;
+                ResetEvent(io_event_);
+                if (WriteFile(pipe, reply.data(), static_cast<DWORD>(reply.size()), nullptr, &write) || GetLastError() == ERROR_IO_PENDING) {
+                    stopping = wait(pipe, write, bytes, kClientTimeoutMs) == IoResult::stopped;
+                }
+                // Disconnecting discards an unread reply, so let the client hang up first
+                if (!stopping) {
+                    std::string ignored;
+                    read_message(pipe, buffer, ignored, stopping);
+                }
+            }
+            DisconnectNamedPipe(pipe);
+            if (stopping) break;
+        }
+        CloseHandle(io_event_);
+        io_event_ = nullptr;
+        CloseHandle(pipe);
+    }
+
+    enum class IoResult { done, failed, stopped };
+
+    // Wait for one overlapped operation; a stop or timeout cancels it
+    IoResult wait(HANDLE pipe, OVERLAPPED& overlapped, DWORD& bytes, DWORD timeout_ms) {
+        HANDLE handles[2] = { overlapped.hEvent, stop_event_ };
+        DWORD signaled = WaitForMultipleObjects(2, handles, FALSE, timeout_ms);
+        if (signaled != WAIT_OBJECT_0) {
+            CancelIoEx(pipe, &overlapped);
+            GetOverlappedResult(pipe, &overlapped, &bytes, TRUE); // Buffer must outlive the I/O
+            return signaled == WAIT_OBJECT_0 + 1 ? IoResult::stopped : IoResult::failed;
+        }
+        if (GetOverlappedResult(pipe, &overlapped, &bytes, FALSE)) return IoResult::done;
+        return GetLastError() == ERROR_MORE_DATA ? IoResult::done : IoResult::failed;
+    }
+
+    // One whole pipe message, however many reads it takes. False when the client went
+    // away, stalled or sent too much.
+    bool read_message(HANDLE pipe, std::vector<char>& buffer, std::string& message, bool& stopping) {
+        message.clear();
+        while (true) {
+            OVERLAPPED overlapped = {};
+            overlapped.hEvent = io_event_;
+            ResetEvent(io_event_);
+            DWORD bytes = 0;
+            BOOL finished = ReadFile(pipe, buffer.data(), static_cast<DWORD>(buffer.size()), nullptr, &overlapped);
+            DWORD error = finished ? ERROR_SUCCESS : GetLastError();
+            if (!finished && error != ERROR_IO_PENDING && error != ERROR_MORE_DATA) return false;
+            IoResult result = wait(pipe, overlapped, bytes, kClientTimeoutMs);
+            if (result == IoResult::stopped) stopping = true;
+            if (result != IoResult::done) return false;
+            bool more = !GetOverlappedResult(pipe, &overlapped, &bytes, FALSE) && GetLastError() == ERROR_MORE_DATA;
+            message.append(buffer.data(), bytes);
+            if (message.size() > kMaxMessageBytes) return false;
+            if (!more) return true;
+        }
+    }
+
+    nlohmann::json handle(const std::string& request) {
+        nlohmann::json reply = { { "ok", false }, { "errors", nlohmann::json::array() } };
+        nlohmann::json document;
+        std::string error;
+        std::istringstream in(request);
+        if (!parse_settings_document(in, document, error)) {
+            std::cerr << "[WARNING] Rejected pushed settings: " << error << std::endl;
+            reply["errors"].push_back("Could not parse settings: " + error);
+            return reply;
+        }
+        if (document.contains("command")) {
+            CoreCommand::Type type;
+            if (!document["command"].is_string() || !parse_core_command(document["command"].get<std::string>(), type)) {
+                reply["errors"].push_back("Unknown command: " + document["command"].dump());
+                return reply;
+            }
+            if (!post_core_command(type)) {
+                reply["errors"].push_back("Command queue full");
+                return reply;
+            }
+            reply["ok"] = true;
+            reply.erase("errors");
+            return reply;
+        }
+        if (document.contains("select_profile")) {
+            std::shared_ptr<const Settings> active = std::atomic_load(&active_);
+            if (!document["select_profile"].is_string() || !active ||
+                find_alarm_profile(active->profiles, document["select_profile"].get<std::string>()) < 0) {
+                reply["errors"].push_back("Unknown alarm profile: " + document["select_profile"].dump());
+                return reply;
+            }
+            std::atomic_store(&pending_profile_, std::make_shared<const std::string>(document["select_profile"].get<std::string>()));
+            wake_core_thread();
+            reply["ok"] = true;
+            reply.erase("errors");
+            return reply;
+        }
+        std::vector<std::string> errors = validate_settings_document(document);
+        if (!errors.empty()) {
+            std::cerr << "[WARNING] Rejected pushed settings (" << errors.size() << " problem(s)): " << errors.front() << std::endl;
+            for (const std::string& e : errors) reply["errors"].push_back(e);
+            return reply;
+        }
+        std::atomic_store(&pending_, settings_from_document(document));
+        wake_core_thread();
+        reply["ok"] = true;
+        reply.erase("errors");
+        return reply;
+    }
+
+    std::shared_ptr<const Settings> pending_; // Only through std::atomic_load/store/exchange
+    std::shared_ptr<const std::string> pending_profile_; // Likewise
+    std::shared_ptr<const Settings> active_;  // Likewise
+    HANDLE stop_event_ = nullptr;
+    HANDLE io_event_ = nullptr;
+    std::thread thread_;
+};
+
+// Second lookout.exe: send each --<command> on the command line (--recenter, --reload,
+// --show-status, ...) to the running instance; just --show-status without any. True if
+// every command was accepted.
+bool forward_to_running_instance(const char* command_line) {
+    std::vector<std::string> commands;
+    std::istringstream words(command_line ? command_line : "");
+    for (std::string word; words >> word;) {
+        if (word.size() < 3 || word.compare(0, 2, "--") != 0 || word == "--headless") continue;
+        std::string name = word.substr(2);
+        std::replace(name.begin(), name.end(), '-', '_');
+        commands.push_back(name);
+    }
+    if (commands.empty()) commands.push_back("show_status");
+    bool ok = true;
+    for (const std::string& name : commands) {
+        const std::string request = nlohmann::json{ { "command", name } }.dump();
+        char reply[4096];
+        DWORD reply_bytes = 0;
+        // Every pipe instance busy with other clients: wait for one to free up and try
+        // again, within the one client timeout
+        const int64_t deadline_us = monotonic_now_us() + SettingsPipeServer::kClientTimeoutMs * 1000LL;
+        bool answered = false;
+        for (;;) {
+            answered = CallNamedPipeA(SettingsPipeServer::kPipeName, const_cast<char*>(request.data()),
+                                      static_cast<DWORD>(request.size()), reply, sizeof(reply), &reply_bytes,
+                                      SettingsPipeServer::kClientTimeoutMs);
+            const int64_t left_ms = (deadline_us - monotonic_now_us()) / 1000;
+            if (answered || GetLastError() != ERROR_PIPE_BUSY || left_ms <= 0) break;
+            if (!WaitNamedPipeA(SettingsPipeServer::kPipeName, static_cast<DWORD>(left_ms)) &&
+                GetLastError() != ERROR_PIPE_BUSY) {
+                break;
+            }
+        }
+        if (!answered) return false; // Running instance not answering (still starting, or hung)
+        ok = ok && nlohmann::json::parse(reply, reply + reply_bytes, nullptr, false).value("ok", false);
+    }
+    return ok;
+}
+
+// Named pipe for controllers (Stream Deck plugins, scripts) that stay connected: one
+// JSON object per line each way. A request is {"command": "<name>"} or just the name
+// on its own line, dashes or underscores alike; "status" is answered from the latest
+// scan state, anything else is a CORE_COMMAND_NAMES entry (pause, resume, recenter,
+// reset_baseline, dump_history, ...) and is acknowledged as soon as it's queued for
+// the core:
+//   {"ok": true}  or  {"ok": true, "status": {...}}  or  {"ok": false, "error": "..."}
+// Several clients at once, all served by one thread with overlapped I/O, so a status
+// round trip is a memory copy and two pipe writes. Local clients only.
+class ControlPipeServer {
+public:
+    static constexpr const char* kPipeName = "\\\\.\\pipe\\QuestLookout.control";
+    static constexpr size_t kInstances = 4;
+    static constexpr size_t kMaxLineBytes = 4096;
+    static constexpr DWORD kWriteTimeoutMs = 1000; // A client that stops reading its replies
+
+    ControlPipeServer() = default;
+    ~ControlPipeServer() { stop(); }
+    ControlPipeServer(const ControlPipeServer&) = delete;
+    ControlPipeServer& operator=(const ControlPipeServer&) = delete;
+
+    void start() {
+        stop_event_ = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        thread_ = std::thread(&ControlPipeServer::serve, this);
+    }
+
+    void stop() {
+        if (stop_event_) SetEvent(stop_event_);
+        if (thread_.joinable()) thread_.join();
+        if (stop_event_) CloseHandle(stop_event_);
+        stop_event_ = nullptr;
+    }
+
+    // Core thread, once per tick: the scan state is only copied here while a controller
+    // is connected
+    bool has_clients() const { return clients_.load(std::memory_order_relaxed) > 0; }
+    void set_status(const LookoutTelemetry& telemetry) { status_.store({ telemetry, monotonic_now_us() }); }
+    void set_flight(bool flying) { flight_.store(flying, std::memory_order_relaxed); }
+
+private:
+    enum class State { connecting, reading, idle };
+
+    struct Status {
+        LookoutTelemetry scan;
+        int64_t t_us; // When the core stored it; 0 before the first
+    };
+
+    struct Instance {
+        HANDLE pipe = INVALID_HANDLE_VALUE;
+        OVERLAPPED overlapped = {};
+        State state = State::idle;
+        bool client = false;
+        char buffer[512];
+        std::string line;
+    };
+
+    void serve() {
+        place_background_thread();
+        ThreadCpuScope cpu_scope(CPU_CONTROL);
+        std::array<Instance, kInstances> instances;
+        HANDLE waits[kInstances + 1];
+        for (size_t k = 0; k < kInstances; ++k) {
+            Instance& instance = instances[k];
+            instance.pipe = CreateNamedPipeA(kPipeName, PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | (k == 0 ? FILE_FLAG_FIRST_PIPE_INSTANCE : 0),
+                                             PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                                             static_cast<DWORD>(kInstances), 64 * 1024, 4096, 0, nullptr);
+            if (instance.pipe == INVALID_HANDLE_VALUE) {
+                std::cerr << "[WARNING] Cannot create control pipe (error=" << GetLastError() << ")" << std::endl;
+                for (size_t j = 0; j < k; ++j) {
+                    CloseHandle(instances[j].pipe);
+                    CloseHandle(instances[j].overlapped.hEvent);
+                }
+                return;
+            }
+            instance.overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+            waits[k] = instance.overlapped.hEvent;
+            listen(instance);
+        }
+        waits[kInstances] = stop_event_;
+        std::cout << "[INFO] Accepting control commands on " << kPipeName << std::endl;
+
+        while (true) {
+            DWORD signaled = WaitForMultipleObjects(static_cast<DWORD>(kInstances + 1), waits, FALSE, INFINITE);
+            if (signaled >= WAIT_OBJECT_0 + kInstances) break; // Stop, or a wait failure
+            Instance& instance = instances[signaled - WAIT_OBJECT_0];
+            DWORD bytes = 0;
+            const bool done = GetOverlappedResult(instance.pipe, &instance.overlapped, &bytes, FALSE) != FALSE;
+            if (instance.state == State::connecting) {
+                if (done) {
+                    instance.client = true;
+                    clients_.fetch_add(1, std::memory_order_relaxed);
+                    if (!read(instance)) hang_up(instance);
+                } else {
+                    DisconnectNamedPipe(instance.pipe);
+                    listen(instance);
+                }
+                continue;
+            }
+            if (!done || !serve_bytes(instance, bytes) || !read(instance)) hang_up(instance);
+        }
+        for (Instance& instance : instances) {
+            CancelIoEx(instance.pipe, nullptr);
+            DWORD bytes = 0;
+            GetOverlappedResult(instance.pipe, &instance.overlapped, &bytes, TRUE); // The buffer must outlive the I/O
+            CloseHandle(instance.pipe);
+            CloseHandle(instance.overlapped.hEvent);
+        }
+    }
+
+    // Wait (overlapped) for the next client on this instance
+    void listen(Instance& instance) {
+        ResetEvent(instance.overlapped.hEvent);
+        instance.state = State::connecting;
+        instance.line.clear();
+        if (ConnectNamedPipe(instance.pipe, &instance.overlapped)) return;
+        const DWORD error = GetLastError();
+        if (error == ERROR_PIPE_CONNECTED) {
+            SetEvent(instance.overlapped.hEvent); // Connected before we asked: no completion is queued
+        } else if (error != ERROR_IO_PENDING) {
+            std::cerr << "[WARNING] Control pipe connect failed (error=" << error << ")" << std::endl;
+            instance.state = State::idle; // Stays signaled-free; this instance is out of service
+        }
+    }
+
+    // Completes through the instance's event, even when the data is already there;
+    // false when the client is gone
+    bool read(Instance& instance) {
+        ResetEvent(instance.overlapped.hEvent);
+        instance.state = State::reading;
+        return ReadFile(instance.pipe, instance.buffer, sizeof(instance.buffer), nullptr, &instance.overlapped) ||
+               GetLastError() == ERROR_IO_PENDING;
+    }
+
+    void hang_up(Instance& instance) {
+        if (instance.client) clients_.fetch_sub(1, std::memory_order_relaxed);
+        instance.client = false;
+        DisconnectNamedPipe(instance.pipe);
+        listen(instance);
+    }
+
+    // Answer every complete line in what was read; false to drop the client
+    bool serve_bytes(Instance& instance, DWORD bytes) {
+        instance.line.append(instance.buffer, bytes);
+        size_t start = 0, end;
+        while ((end = instance.line.find('\n', start)) != std::string::npos) {
+            std::string request = instance.line.substr(start, end - start);
+            start = end + 1;
+            if (!request.empty() && request.back() == '\r') request.pop_back();
+            if (request.empty()) continue;
+            if (!write_line(instance, handle(request).dump())) return false;
+        }
+        instance.line.erase(0, start);
+        return instance.line.size() <= kMaxLineBytes;
+    }
+
+    // Replies are small next to the pipe's buffer, so this normally completes at once
+    bool write_line(Instance& instance, std::string reply) {
+        reply += '\n';
+        OVERLAPPED write = {};
+        write.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        DWORD bytes = 0;
+        bool ok = WriteFile(instance.pipe, reply.data(), static_cast<DWORD>(reply.size()), nullptr, &write) != FALSE;
+        if (!ok && GetLastError() == ERROR_IO_PENDING) {
+            if (WaitForSingleObject(write.hEvent, kWriteTimeoutMs) != WAIT_OBJECT_0) CancelIoEx(instance.pipe, &write);
+            ok = GetOverlappedResult(instance.pipe, &write, &bytes, TRUE) != FALSE;
+        }
+        CloseHandle(write.hEvent);
+        return ok;
+    }
+
+    nlohmann::json handle(const std::string& request) {
+        std::string name = request;
+        if (request.front() == '{') {
+            nlohmann::json document = nlohmann::json::parse(request, nullptr, false);
+            if (!document.is_object() || !document.contains("command") || !document["command"].is_string()) {
+                return { { "ok", false }, { "error", "Expected {\"command\": \"<name>\"}" } };
+            }
+            name = document["command"].get<std::string>();
+        }
+        std::replace(name.begin(), name.end(), '-', '_');
+        if (name == "status") return { { "ok", true }, { "status", status_json() } };
+        CoreCommand::Type type;
+        if (!parse_core_command(name, type)) return { { "ok", false }, { "error", "Unknown command: " + name } };
+        if (!post_core_command(type)) return { { "ok", false }, { "error", "Command queue full" } };
+        return { { "ok", true } };
+    }
+
+    nlohmann::json status_json() {
+        const Status& latest = status_.load();
+        nlohmann::json status = { { "flight", flight_.load(std::memory_order_relaxed) }, { "paused", g_alarms_paused.load() } };
+        if (latest.t_us == 0) return status; // Nothing evaluated since the first controller connected
+        const LookoutTelemetry& t = latest.scan;
+        status["hmd_ok"] = (t.flags & TELEMETRY_HMD_OK) != 0;
+        status["age_ms"] = (monotonic_now_us() - latest.t_us) / 1000;
+        status["engine_s"] = t.engine_us / 1e6;
+        status["yaw_deg"] = t.yaw_deg;
+        status["pitch_deg"] = t.pitch_deg;
+        status["profile"] = t.active_profile;
+        nlohmann::json alarms = nlohmann::json::array();
+        for (uint32_t i = 0; i < t.alarm_count && i < LOOKOUT_TELEMETRY_MAX_ALARMS; ++i) {
+            const LookoutTelemetryAlarm& a = t.alarms[i];
+            alarms.push_back({ { "id", a.id }, { "warning", a.warning != 0 }, { "silenced", a.silenced != 0 },
+                               { "no_look_s", a.no_look_s }, { "until_due_s", a.until_due_s }, { "seen", a.seen },
+                               { "required", a.required } });
+        }
+        status["alarms"] = std::move(alarms);
+        return status;
+    }
+
+    TripleBuffer<Status> status_;         // Core writes, this thread reads
+    std::atomic<bool> flight_{false};
+    std::atomic<int> clients_{0};
+    HANDLE stop_event_ = nullptr;
+    std::thread thread_;
+};
+
+// Decoded alarm clips keyed by file path. Every alarm's file is decoded once when the
+// settings are loaded, so a warning only starts playback from memory and an alarm
+// firing never touches the disk. A file that can't be loaded maps to beep.wav.
+// Clips longer than stream_above_seconds aren't decoded; they are only recorded as
+// streamed, and the mixer reads them from disk as they play.
+class AudioBufferCache {
+public:
+    void preload(const std::vector<LookoutAlarmConfig>& alarms, const AudioConfig& config) {
+        for (const auto& alarm : alarms) {
+            if (!alarm.enabled()) continue;
+            if (!probe_streamed(alarm.audio_file, config.stream_above_seconds)) load(alarm.audio_file);
+        }
+    }
+
+    bool is_streamed(const std::string& audio_file) const {
+        return streamed_.count(audio_file.empty() ? "beep.wav" : audio_file) > 0;
+    }
+
+    // Settings reload (audio worker): files rewritten since they were read are dropped so
+    // the next preload reads them again; files that didn't change keep their decoded
+    // buffers. The mixer's current voices may still play a dropped buffer, so it's held
+    // until release_retired(), once the reloaded voices have replaced them.
+    void forget_changed() {
+        for (auto it = buffers_.begin(); it != buffers_.end();) {
+            if (file_write_stamp(it->first) != stamps_[it->first]) {
+                std::cout << "[INFO] Audio file changed, decoding again: " << it->first << std::endl;
+                retired_.push_back(std::move(it->second));
+                it = buffers_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        for (auto it = streamed_.begin(); it != streamed_.end();) {
+            if (file_write_stamp(*it) != stamps_[*it]) it = streamed_.erase(it);
+            else ++it;
+        }
+    }
+
+    // Memory budget (audio worker): drop every decoded clip, held like forget_changed()'s
+    void unload_all() {
+        for (auto& entry : buffers_) retired_.push_back(std::move(entry.second));
+        buffers_.clear();
+        streamed_.clear();
+    }
+
+    // Audio worker, once no voice can refer to a retired buffer any more
+    void release_retired() { retired_.clear(); }
+
+    // Decoded buffer for an alarm's audio file, decoding it first if needed
+    const sf::SoundBuffer* load(const std::string& audio_file) {
+        std::string file_to_play = audio_file.empty() ? "beep.wav" : audio_file;
+        if (const sf::SoundBuffer* cached = find(file_to_play)) return cached;
+
+        auto buffer = std::make_unique<sf::SoundBuffer>();
+        try {
+            MappedFileStream stream;
+            stamps_[file_to_play] = file_write_stamp(file_to_play);
+            if (stream.open(file_to_play) && buffer->loadFromStream(stream)) {
+                std::cout << "[INFO] Decoded audio file: " << file_to_play << " (" << buffer->getDuration().asSeconds()
+                          << " s)" << std::endl;
+                return (buffers_[file_to_play] = std::move(buffer)).get();
+            }
+            std::cerr << "[ERROR] Could not load audio file: " << file_to_play << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "[ERROR] Exception decoding " << file_to_play << ": " << e.what() << std::endl;
+        }
+
+        // If not the default, fall back to beep.wav
+        if (file_to_play == "beep.wav") return nullptr;
+        std::cerr << "[INFO] Attempting to load default beep.wav" << std::endl;
+        const sf::SoundBuffer* fallback = load("beep.wav");
+        if (!fallback) {
+            std::cerr << "[ERROR] Could not load default audio file: beep.wav" << std::endl;
+            return nullptr;
+        }
+        return fallback; // Not cached under file_to_play, so a fixed file is picked up on the next load
+    }
+
+    // Play every decoded clip once at volume 0: wakes the audio device and proves each
+    // file plays, so problems are reported at the first flight start rather than when a
+    // warning is due
+    bool warm_up() const {
+        bool ok = true;
+        for (const auto& path : streamed_) {
+            try {
+                // Decode the first block the way the mixer will read it
+                MappedFileStream stream;
+                sf::InputSoundFile file;
+                std::array<std::int16_t, 4096> samples;
+                if (!stream.open(path) || !file.openFromStream(stream) || file.read(samples.data(), samples.size()) == 0) {
+                    std::cerr << "[ERROR] Could not open streamed audio file: " << path << std::endl;
+                    ok = false;
+                    continue;
+                }
+                std::cout << "[INFO] Successfully opened and tested streamed audio file: " << path << std::endl;
+            } catch (const std::exception& e) {
+                std::cerr << "[ERROR] Audio test failed for " << path << ": " << e.what() << std::endl;
+                ok = false;
+            }
+        }
+        for (const auto& [path, buffer] : buffers_) {
+            try {
+                sf::Sound sound(*buffer);
+                sound.setVolume(0);
+                sound.play();
+                sound.stop();
+                std::cout << "[INFO] Successfully loaded and tested audio file: " << path << std::endl;
+            } catch (const std::exception& e) {
+                std::cerr << "[ERROR] Audio test failed for " << path << ": " << e.what() << std::endl;
+                ok = false;
+            }
+        }
+        return ok;
+    }
+
+    // Already decoded buffer only; never reads the disk
+    const sf::SoundBuffer* find(const std::string& audio_file) const {
+        auto it = buffers_.find(audio_file.empty() ? "beep.wav" : audio_file);
+        if (it != buffers_.end()) return it->second.get();
+        if (audio_file == "beep.wav") return nullptr;
+        auto beep = buffers_.find("beep.wav");
+        return beep != buffers_.end() ? beep->second.get() : nullptr;
+    }
+
+private:
+    // Reads only the file header; true if the clip is long enough to stream
+    bool probe_streamed(const std::string& audio_file, double stream_above_seconds) {
+        std::string path = audio_file.empty() ? "beep.wav" : audio_file;
+        if (streamed_.count(path)) return true;
+        if (buffers_.count(path)) return false;
+        try {
+            MappedFileStream stream;
+            sf::InputSoundFile file;
+            stamps_[path] = file_write_stamp(path);
+            if (!stream.open(path) || !file.openFromStream(stream)) return false; // load() reports it and falls back to beep.wav
+            float seconds = file.getDuration().asSeconds();
+            if (seconds <= stream_above_seconds) return false;
+            std::cout << "[INFO] Streaming audio file: " << path << " (" << seconds << " s)" << std::endl;
+            streamed_.insert(path);
+            return true;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    std::unordered_map<std::string, std::unique_ptr<sf::SoundBuffer>> buffers_;
+    std::set<std::string> streamed_;
+    std::unordered_map<std::string, uint64_t> stamps_; // file_write_stamp() when last read
+    std::vector<std::unique_ptr<sf::SoundBuffer>> retired_;
+};
+
+AudioBufferCache g_audio_cache; // Filled by the warm-up task, then audio worker only
+std::future<void> g_audio_warmup;
+
+// Decode and test all alarm audio in the background (first flight start). The tracking
+// thread keeps running meanwhile; the audio worker waits for it before building the
+// mixer.
+void start_audio_warmup(const std::vector<LookoutAlarmConfig>& alarms, const AudioConfig& config) {
+    g_audio_warmup = std::async(std::launch::async, [alarms, config]() {
+        auto start_us = monotonic_now_us();
+        g_audio_cache.preload(alarms, config);
+        bool ok = g_audio_cache.warm_up();
+        std::cout << "[TIMING] Audio warm-up " << (ok ? "finished" : "finished with errors") << " in "
+                  << (monotonic_now_us() - start_us) / 1000 << " ms" << std::endl;
+    });
+}
+
+// Call before the audio worker touches g_audio_cache. Commands queued meanwhile wait in
+// the audio queue; the tracking thread never waits here.
+void wait_for_audio_warmup() {
+    if (!g_audio_warmup.valid()) return;
+    g_audio_warmup.get();
+}
+
+// Defines for tray icon
+#define WM_APP_TRAYMSG (WM_APP + 1)
+#define WM_APP_SHOW_STATUS (WM_APP + 2) // Core -> GUI thread: open the status window
+#define WM_APP_TRAY_TIP (WM_APP + 3)    // Core -> GUI thread: g_tray_tip changed
+#define ID_TRAY_APP_ICON 1001
+#define ID_TRAY_EXIT_CONTEXT_MENU_ITEM 1002
+#define ID_TRAY_TOGGLE_CONSOLE_ITEM 1003
+#define ID_TRAY_SETTINGS_ITEM 1004
+#define ID_TRAY_SAVE_POSE_HISTORY_ITEM 1005
+#define ID_TRAY_PAUSE_ITEM 1006
+#define ID_TRAY_RELOAD_SETTINGS_ITEM 1007
+#define ID_TRAY_SAVE_HEATMAP_ITEM 1008
+
+const char* const WINDOW_CLASS_NAME = "QuestLookoutWindowClass";
+HWND g_hwnd;
+// --headless: no window, tray icon, console or hotkeys; the pipes are the only controls
+bool g_headless = false;
+NOTIFYICONDATA nidApp;
+std::atomic<bool> g_is_console_visible{false}; // Also read by the async log sink
+std::shared_ptr<const std::string> g_tray_tip; // Status line for the tray tooltip, atomic_load/store only
+std::shared_ptr<const Settings> g_active_settings; // Core -> settings window: the running snapshot, atomic_load/store only
+
+// Core thread: hand a new tooltip to the GUI thread, which owns the tray icon
+void set_tray_tip(const std::string& tip) {
+    std::atomic_store(&g_tray_tip, std::make_shared<const std::string>(tip));
+    if (g_hwnd) PostMessage(g_hwnd, WM_APP_TRAY_TIP, 0, 0);
+}
+
+// Forward declaration for our core application logic
+int app_core_logic(std::shared_ptr<const Settings> settings);
+int run_perf_selftest();
+
+// Routes std::cout and std::cerr through ConsoleCapture for as long as it lives (defined
+// with it). WinMain holds one from before its first thread starts until after the last
+// is joined.
+struct ConsoleCaptureScope {
+    ConsoleCaptureScope();
+    ~ConsoleCaptureScope();
+    ConsoleCaptureScope(const ConsoleCaptureScope&) = delete;
+    ConsoleCaptureScope& operator=(const ConsoleCaptureScope&) = delete;
+};
+
+// --headless: WinMain without the window class, the tray icon or the input thread. The
+// window event hooks still need a message loop on the thread that installed them, so
+// this one pumps messages until Exit or until the core returns by itself.
+int run_headless(std::shared_ptr<const Settings> settings) {
+    TraceLoggingRegister(g_trace_provider);
+    g_sim_profiles = settings->sim_profiles;
+    g_thread_placement = settings->threads;
+    g_shutdown_event = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    install_condor_window_hooks();
+
+    g_core_wake_event = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+    g_sampler_wake_event = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+    int result = 0;
+    std::thread core_logic_thread([&]() {
+        result = app_core_logic(settings);
+        request_shutdown(); // Nobody left to click Exit
+    });
+    std::cout << "[INFO] Running headless; controlled through " << ControlPipeServer::kPipeName << std::endl;
+
+    while (MsgWaitForMultipleObjects(1, &g_shutdown_event, FALSE, INFINITE, QS_ALLINPUT) == WAIT_OBJECT_0 + 1) {
+        MSG msg;
+        while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) DispatchMessage(&msg);
+    }
+    uninstall_condor_window_hooks();
+    core_logic_thread.join();
+
+    CloseHandle(g_core_wake_event);
+    g_core_wake_event = nullptr;
+    CloseHandle(g_sampler_wake_event);
+    g_sampler_wake_event = nullptr;
+    CloseHandle(g_shutdown_event);
+    g_shutdown_event = nullptr;
+    TraceLoggingUnregister(g_trace_provider);
+    return result;
+}
+
+// Console Management Functions
+void ShowConsoleWindow()
+{
+    if (!g_is_console_visible)
+    {
+        if (AllocConsole())
+        {
+            FILE* fp_stdout, *fp_stderr, *fp_stdin;
+            if (_wfreopen_s(&fp_stdout, L"CONOUT$", L"w", stdout) != 0 ||
+                _wfreopen_s(&fp_stderr, L"CONOUT$", L"w", stderr) != 0 ||
+                _wfreopen_s(&fp_stdin, L"CONIN$", L"r", stdin) != 0)
+            {
+                FreeConsole(); 
+                return;
+            }
+            std::cout.clear();
+            std::cerr.clear();
+            std::cin.clear(); 
+            SetConsoleTitleA("Quest Lookout Status"); 
+            g_is_console_visible = true;
+            g_log_sinks.fetch_or(LOG_SINK_CONSOLE);
+            std::cout << "[INFO] Status window opened." << std::endl; 
+        }
+    }
+}
+
+void HideConsoleWindow()
+{
+    if (g_is_console_visible)
+    {
+        std::cin.clear();
+        
+        FILE* fp_nul_stdout, *fp_nul_stderr, *fp_nul_stdin;
+        _wfreopen_s(&fp_nul_stdout, L"NUL", L"w", stdout);
+        _wfreopen_s(&fp_nul_stderr, L"NUL", L"w", stderr);
+        _wfreopen_s(&fp_nul_stdin, L"NUL", L"r", stdin);
+
+        if (FreeConsole())
+        {
+            g_is_console_visible = false;
+            g_log_sinks.fetch_and(~static_cast<uint32_t>(LOG_SINK_CONSOLE));
+        }
+    }
+}
+
+// Window Procedure
+// Tray "Settings": the fields settings_gui.exe edits, in a window of lookout.exe's own,
+// so it opens at once instead of unpacking a second Python runtime next to the sim. It
+// shows the running snapshot (the "default" profile's alarms, center reset, recenter
+// hotkey, startup) and Apply saves into settings.json, keeping every key it doesn't
+// show; the file watch then applies the save as a hot reload. GUI thread only.
+class SettingsWindow {
+public:
+    void show() {
+        if (hwnd_) {
+            ShowWindow(hwnd_, SW_RESTORE);
+            SetForegroundWindow(hwnd_);
+            return;
+        }
+        std::shared_ptr<const Settings> settings = std::atomic_load(&g_active_settings);
+        if (!settings) return; // The core hasn't loaded them yet
+        WNDCLASSEX wc = {0};
+        wc.cbSize = sizeof(WNDCLASSEX);
+        wc.lpfnWndProc = window_proc;
+        wc.hInstance = GetModuleHandle(NULL);
+        wc.lpszClassName = "QuestLookoutSettingsWindow";
+        wc.hIcon = LoadIcon(NULL, IDI_APPLICATION);
+        wc.hCursor = LoadCursor(NULL, IDC_ARROW);
+        wc.hbrBackground = reinterpret_cast<HBRUSH>(static_cast<INT_PTR>(COLOR_BTNFACE + 1));
+        RegisterClassEx(&wc); // Fails harmlessly after the first open
+        const DWORD style = WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU | WS_MINIMIZEBOX;
+        RECT frame = {0, 0, kClientWidth, kClientHeight};
+        AdjustWindowRectEx(&frame, style, FALSE, WS_EX_CONTROLPARENT);
+        hwnd_ = CreateWindowEx(WS_EX_CONTROLPARENT, wc.lpszClassName, "Quest Lookout Settings", style, CW_USEDEFAULT, CW_USEDEFAULT,
+                               frame.right - frame.left, frame.bottom - frame.top, NULL, NULL, wc.hInstance, this);
+        if (!hwnd_) {
+            std::cerr << "[ERROR] Could not open the settings window (error=" << GetLastError() << ")" << std::endl;
+            return;
+        }
+        create_controls();
+        load(settings);
+        ShowWindow(hwnd_, SW_SHOWNORMAL);
+        SetForegroundWindow(hwnd_);
+    }
+
+    // Message loop: Tab between the fields, Enter applies, Esc closes
+    bool dispatch(MSG& msg) { return hwnd_ && IsDialogMessage(hwnd_, &msg); }
+
+private:
+    static constexpr int kClientWidth = 600;
+    static constexpr int kClientHeight = 425;
+
+    struct AlarmField {
+        const char* key;              // LookoutAlarmConfig's JSON name; its default gives the type
+        const char* label;
+    };
+    static constexpr AlarmField ALARM_FIELDS[] = {
+        {"min_horizontal_angle", "Horizontal angle (degrees)"},
+        {"min_vertical_angle_up", "Vertical up angle (degrees)"},
+        {"min_vertical_angle_down", "Vertical down angle (degrees)"},
+        {"max_time_ms", "Max time (ms)"},
+        {"min_lookout_time_ms", "Min lookout time (ms)"},
+        {"audio_file", "Audio file"},
+        {"start_volume", "Start volume (0-100)"},
+        {"end_volume", "End volume (0-100)"},
+        {"volume_ramp_time_ms", "Volume ramp time (ms)"},
+        {"repeat_interval_ms", "Repeat interval (ms)"},
+        {"silence_after_look_ms", "Silence after look (ms)"},
+    };
+    static constexpr size_t kFieldCount = sizeof(ALARM_FIELDS) / sizeof(ALARM_FIELDS[0]);
+    static constexpr size_t kAudioField = 5;
+    enum : int { ID_ALARM_LIST = 100, ID_ADD, ID_DUPLICATE, ID_REMOVE, ID_BROWSE, ID_RESET_WINDOW, ID_RESET_HOLD, ID_HOTKEY, ID_STARTUP,
+                 ID_ALARM_FIELD = 200 };
+
+    struct Alarm {
+        nlohmann::ordered_json fields; // ALARM_FIELDS keys only
+        int base = -1;                 // Entry of the file's "alarms" whose other keys it keeps; -1 for none
+    };
+
+    static const nlohmann::ordered_json& alarm_defaults() {
+        static const nlohmann::ordered_json defaults = LookoutAlarmConfig();
+        return defaults;
+    }
+
+    static nlohmann::ordered_json alarm_fields(const LookoutAlarmConfig& alarm) {
+        const nlohmann::ordered_json all = alarm;
+        nlohmann::ordered_json fields = nlohmann::ordered_json::object();
+        for (const AlarmField& f : ALARM_FIELDS) fields[f.key] = all[f.key];
+        return fields;
+    }
+
+    // `text` as a value of the same type as `like`, or null when it isn't one
+    static nlohmann::ordered_json parse_value(const std::string& text, const nlohmann::ordered_json& like) {
+        if (like.is_string()) return text;
+        const char* begin = text.c_str();
+        char* end = nullptr;
+        nlohmann::ordered_json value;
+        if (like.is_number_integer()) value = std::strtol(begin, &end, 10);
+        else value = std::strtod(begin, &end);
+        while (*end == ' ') ++end;
+        return end == begin || *end ? nlohmann::ordered_json() : value;
+    }
+
+    static std::string value_text(const nlohmann::ordered_json& value) {
+        return value.is_string() ? value.get<std::string>() : value.dump();
+    }
+
+    static std::string control_text(HWND control) {
+        std::string text(static_cast<size_t>(GetWindowTextLengthA(control)) + 1, '\0');
+        text.resize(static_cast<size_t>((std::max)(0, GetWindowTextA(control, &text[0], static_cast<int>(text.size())))));
+        return text;
+    }
+
+    // The list line, as settings_gui showed it: thresholds, deadline, sound
+    static std::string alarm_label(const Alarm& alarm) {
+        const nlohmann::ordered_json& f = alarm.fields;
+        std::ostringstream label;
+        label << f["min_horizontal_angle"].get<double>() << " H, " << f["min_vertical_angle_up"].get<double>() << " up, "
+              << f["min_vertical_angle_down"].get<double>() << " down, " << f["max_time_ms"].get<int>() / 1000 << " s, "
+              << f["audio_file"].get<std::string>();
+        return label.str();
+    }
+
+    static LRESULT CALLBACK window_proc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam) {
+        if (msg == WM_NCCREATE) {
+            SetWindowLongPtr(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(reinterpret_cast<CREATESTRUCT*>(lparam)->lpCreateParams));
+        }
+        SettingsWindow* self = reinterpret_cast<SettingsWindow*>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
+        if (self && msg == WM_COMMAND) {
+            self->command(LOWORD(wparam), HIWORD(wparam));
+            return 0;
+        }
+        if (self && msg == WM_NCDESTROY) {
+            self->hwnd_ = nullptr;
+            self->alarms_.clear();
+        }
+        return DefWindowProc(hwnd, msg, wparam, lparam);
+    }
+
+    HWND add_control(const char* cls, const char* text, DWORD style, int x, int y, int w, int h, int id, DWORD ex_style = 0) {
+        HWND control = CreateWindowEx(ex_style, cls, text, WS_CHILD | WS_VISIBLE | style, x, y, w, h, hwnd_,
+                                      reinterpret_cast<HMENU>(static_cast<INT_PTR>(id)), GetModuleHandle(NULL), NULL);
+        SendMessage(control, WM_SETFONT, reinterpret_cast<WPARAM>(GetStockObject(DEFAULT_GUI_FONT)), TRUE);
+        return control;
+    }
+
+    HWND add_edit(int x, int y, int w, int id) {
+        return add_control("EDIT", "", WS_TABSTOP | ES_AUTOHSCROLL, x, y, w, 20, id, WS_EX_CLIENTEDGE);
+    }
+
+    void create_controls() {
+        add_control("STATIC", "Alarms (default profile)", 0, 10, 10, 260, 16, -1);
+        list_ = add_control("LISTBOX", "", WS_TABSTOP | WS_VSCROLL | WS_BORDER | LBS_NOTIFY, 10, 30, 260, 250, ID_ALARM_LIST);
+        add_control("BUTTON", "Add", WS_TABSTOP | BS_PUSHBUTTON, 10, 288, 80, 24, ID_ADD);
+        duplicate_ = add_control("BUTTON", "Duplicate", WS_TABSTOP | BS_PUSHBUTTON, 100, 288, 80, 24, ID_DUPLICATE);
+        remove_ = add_control("BUTTON", "Remove", WS_TABSTOP | BS_PUSHBUTTON, 190, 288, 80, 24, ID_REMOVE);
+        for (size_t k = 0; k < kFieldCount; ++k) {
+            const int y = 30 + static_cast<int>(k) * 24;
+            add_control("STATIC", ALARM_FIELDS[k].label, 0, 290, y + 3, 170, 16, -1);
+            fields_[k] = add_edit(465, y, k == kAudioField ? 95 : 125, ID_ALARM_FIELD + static_cast<int>(k));
+        }
+        browse_ = add_control("BUTTON", "...", WS_TABSTOP | BS_PUSHBUTTON, 562, 30 + static_cast<int>(kAudioField) * 24, 28, 20, ID_BROWSE);
+
+        add_control("STATIC", "Center reset window (degrees)", 0, 10, 333, 170, 16, -1);
+        reset_window_ = add_edit(185, 330, 85, ID_RESET_WINDOW);
+        add_control("STATIC", "Center reset hold time (seconds)", 0, 290, 333, 170, 16, -1);
+        reset_hold_ = add_edit(465, 330, 125, ID_RESET_HOLD);
+        add_control("STATIC", "Recenter hotkey (at restart)", 0, 10, 359, 170, 16, -1);
+        hotkey_ = add_edit(185, 356, 85, ID_HOTKEY);
+        startup_ = add_control("BUTTON", "Start with Windows", WS_TABSTOP | BS_AUTOCHECKBOX, 290, 356, 200, 20, ID_STARTUP);
+        add_control("BUTTON", "Apply", WS_TABSTOP | BS_DEFPUSHBUTTON, 410, 391, 85, 24, IDOK);
+        add_control("BUTTON", "Close", WS_TABSTOP | BS_PUSHBUTTON, 505, 391, 85, 24, IDCANCEL);
+    }
+
+    void load(const std::shared_ptr<const Settings>& settings) {
+        file_stamp_ = file_write_stamp("settings.json");
+        alarms_.clear();
+        for (uint32_t id : settings->profiles[0].alarm_ids) {
+            alarms_.push_back({alarm_fields(settings->alarms[id]), static_cast<int>(id)});
+        }
+        SetWindowTextA(reset_window_, value_text(settings->center_reset.window_degrees).c_str());
+        SetWindowTextA(reset_hold_, value_text(settings->center_reset.hold_time_seconds).c_str());
+        SetWindowTextA(hotkey_, settings->hotkeys.recenter_hotkey.c_str());
+        SendMessage(startup_, BM_SETCHECK, settings->start_with_windows ? BST_CHECKED : BST_UNCHECKED, 0);
+        select(alarms_.empty() ? -1 : 0);
+    }
+
+    void command(int id, int code) {
+        switch (id) {
+        case ID_ALARM_LIST:
+            if (code == LBN_SELCHANGE) {
+                const int next = static_cast<int>(SendMessage(list_, LB_GETCURSEL, 0, 0));
+                if (store_selected()) select(next);
+                else SendMessage(list_, LB_SETCURSEL, static_cast<WPARAM>(selected_), 0);
+            }
+            break;
+        case ID_ADD:
+            if (store_selected()) {
+                Alarm alarm{alarm_fields(LookoutAlarmConfig()), -1};
+                alarm.fields["audio_file"] = "lookout.ogg"; // The sound shipped next to lookout.exe
+                alarms_.push_back(std::move(alarm));
+                select(static_cast<int>(alarms_.size()) - 1);
+            }
+            break;
+        case ID_DUPLICATE:
+            if (selected_ >= 0 && store_selected()) {
+                alarms_.push_back(alarms_[static_cast<size_t>(selected_)]);
+                select(static_cast<int>(alarms_.size()) - 1);
+            }
+            break;
+        case ID_REMOVE:
+            if (selected_ >= 0) {
+                alarms_.erase(alarms_.begin() + selected_);
+                select((std::min)(selected_, static_cast<int>(alarms_.size()) - 1));
+            }
+            break;
+        case ID_BROWSE:
+            browse_audio();
+            break;
+        case IDOK:
+            apply();
+            break;
+        case IDCANCEL:
+            DestroyWindow(hwnd_);
+            break;
+        }
+    }
+
+    // Shows alarm `index` (-1 for none) in the fields and the list
+    void select(int index) {
+        selected_ = index;
+        SendMessage(list_, LB_RESETCONTENT, 0, 0);
+        for (const Alarm& alarm : alarms_) SendMessage(list_, LB_ADDSTRING, 0, reinterpret_cast<LPARAM>(alarm_label(alarm).c_str()));
+        SendMessage(list_, LB_SETCURSEL, static_cast<WPARAM>(index), 0);
+        for (size_t k = 0; k < kFieldCount; ++k) {
+            const std::string text = index >= 0 ? value_text(alarms_[static_cast<size_t>(index)].fields[ALARM_FIELDS[k].key]) : "";
+            SetWindowTextA(fields_[k], text.c_str());
+            EnableWindow(fields_[k], index >= 0);
+        }
+        EnableWindow(browse_, index >= 0);
+        EnableWindow(duplicate_, index >= 0);
+        EnableWindow(remove_, index >= 0);
+    }
+
+    // Fields into the selected alarm; false, with the field focused, when one doesn't read
+    bool store_selected() {
+        if (selected_ < 0) return true;
+        Alarm& alarm = alarms_[static_cast<size_t>(selected_)];
+        for (size_t k = 0; k < kFieldCount; ++k) {
+            nlohmann::ordered_json value = parse_value(control_text(fields_[k]), alarm_defaults()[ALARM_FIELDS[k].key]);
+            if (value.is_null()) return reject(fields_[k], std::string(ALARM_FIELDS[k].label) + ": enter a number");
+            alarm.fields[ALARM_FIELDS[k].key] = std::move(value);
+        }
+        return true;
+    }
+
+    bool reject(HWND field, const std::string& message) {
+        MessageBox(hwnd_, message.c_str(), "Quest Lookout Settings", MB_OK | MB_ICONWARNING);
+        if (field) SetFocus(field);
+        return false;
+    }
+
+    // Relative to the lookout folder when the sound is in it, as settings.json has them
+    void browse_audio() {
+        char path[MAX_PATH] = "";
+        OPENFILENAMEA ofn = {};
+        ofn.lStructSize = sizeof(ofn);
+        ofn.hwndOwner = hwnd_;
+        ofn.lpstrFilter = "Audio files\0*.ogg;*.wav;*.flac;*.mp3\0All files\0*.*\0";
+        ofn.lpstrFile = path;
+        ofn.nMaxFile = MAX_PATH;
+        ofn.lpstrTitle = "Select Audio File";
+        ofn.Flags = OFN_FILEMUSTEXIST | OFN_PATHMUSTEXIST | OFN_NOCHANGEDIR; // The cwd is where settings.json lives
+        if (!GetOpenFileNameA(&ofn)) return;
+        char cwd[MAX_PATH] = "";
+        const DWORD cwd_length = GetCurrentDirectoryA(MAX_PATH, cwd);
+        std::string file = path;
+        if (cwd_length > 0 && _strnicmp(file.c_str(), cwd, cwd_length) == 0 && file.size() > cwd_length && file[cwd_length] == '\\') {
+            file.erase(0, cwd_length + 1);
+        }
+        SetWindowTextA(fields_[kAudioField], file.c_str());
+    }
+
+    // Edits merged into the file as it is now, checked like a settings_gui push, then
+    // swapped in with one rename so the file watch never sees it half written
+    bool apply() {
+        if (!store_selected()) return false;
+        const nlohmann::ordered_json window_degrees = parse_value(control_text(reset_window_), 0.0);
+        const nlohmann::ordered_json hold_time_seconds = parse_value(control_text(reset_hold_), 0.0);
+        if (window_degrees.is_null()) return reject(reset_window_, "Center reset window: enter a number");
+        if (hold_time_seconds.is_null()) return reject(reset_hold_, "Center reset hold time: enter a number");
+        if (file_write_stamp("settings.json") != file_stamp_ &&
+            MessageBox(hwnd_, "settings.json was changed since this window opened. Save over those changes?", "Quest Lookout Settings",
+                       MB_YESNO | MB_ICONQUESTION) != IDYES) {
+            return false;
+        }
+
+        nlohmann::ordered_json document = nlohmann::ordered_json::object();
+        if (std::ifstream in{"settings.json", std::ios::binary}) {
+            document = nlohmann::ordered_json::parse(in, nullptr, false);
+            if (document.is_discarded() || !document.is_object()) {
+                return reject(NULL, "settings.json doesn't parse, so it can't be updated. Fix it or copy settings_default.json over it.");
+            }
+        }
+        const nlohmann::ordered_json previous = document.value("alarms", nlohmann::ordered_json::array());
+        nlohmann::ordered_json alarms = nlohmann::ordered_json::array();
+        for (const Alarm& alarm : alarms_) {
+            const bool has_base = alarm.base >= 0 && previous.is_array() && static_cast<size_t>(alarm.base) < previous.size() &&
+                                  previous[static_cast<size_t>(alarm.base)].is_object();
+            nlohmann::ordered_json entry = has_base ? previous[static_cast<size_t>(alarm.base)] : nlohmann::ordered_json::object();
+            for (const auto& field : alarm.fields.items()) entry[field.key()] = field.value();
+            alarms.push_back(std::move(entry));
+        }
+        document["alarms"] = std::move(alarms);
+        if (!document.contains("center_reset") || !document["center_reset"].is_object()) document["center_reset"] = nlohmann::ordered_json::object();
+        document["center_reset"]["window_degrees"] = window_degrees;
+        document["center_reset"]["hold_time_seconds"] = hold_time_seconds;
+        // Into whichever key is in effect: a non-empty hotkeys.recenter overrides recenter_hotkey
+        const char* const recenter = HOTKEY_COMMAND_NAMES[HOTKEY_RECENTER];
+        if (document.contains("hotkeys") && document["hotkeys"].is_object() && document["hotkeys"].contains(recenter) &&
+            document["hotkeys"][recenter].is_string() && !document["hotkeys"][recenter].get<std::string>().empty()) {
+            document["hotkeys"][recenter] = control_text(hotkey_);
+        } else {
+            document["recenter_hotkey"] = control_text(hotkey_);
+        }
+        document["start_with_windows"] = SendMessage(startup_, BM_GETCHECK, 0, 0) == BST_CHECKED;
+
+        std::vector<std::string> errors = validate_settings_document(nlohmann::json(document));
+        if (!errors.empty()) {
+            std::string message = "Not saved, " + std::to_string(errors.size()) + " problem(s):";
+            for (size_t k = 0; k < errors.size() && k < 5; ++k) message += "\n" + errors[k];
+            return reject(NULL, message);
+        }
+        const std::string bytes = document.dump(2) + "\n";
+        {
+            std::ofstream out("settings.json.tmp", std::ios::binary | std::ios::trunc);
+            out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            if (!out) return reject(NULL, "Could not write settings.json.tmp");
+        }
+        if (!MoveFileExA("settings.json.tmp", "settings.json", MOVEFILE_REPLACE_EXISTING)) {
+            return reject(NULL, "Could not replace settings.json (error " + std::to_string(GetLastError()) + ")");
+        }
+        std::cout << "[INFO] Settings window saved settings.json with " << alarms_.size() << " alarm(s)" << std::endl;
+        file_stamp_ = file_write_stamp("settings.json");
+        return true;
+    }
+
+    HWND hwnd_ = nullptr;
+    HWND list_ = nullptr, duplicate_ = nullptr, remove_ = nullptr, browse_ = nullptr;
+    HWND fields_[kFieldCount] = {};
+    HWND reset_window_ = nullptr, reset_hold_ = nullptr, hotkey_ = nullptr, startup_ = nullptr;
+    std::vector<Alarm> alarms_;
+    int selected_ = -1;
+    uint64_t file_stamp_ = 0; // settings.json as the fields were filled in, to notice other edits
+};
+
+SettingsWindow g_settings_window;
+
+LRESULT CALLBACK WndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 {
     switch (uMsg)
     {
-        case WM_APP_TRAYMSG:
-            switch (lParam) 
+        case WM_APP_SHOW_STATUS:
+            ShowConsoleWindow();
+            return 0;
+
+        case WM_APP_TRAY_TIP:
+            if (std::shared_ptr<const std::string> tip = std::atomic_load(&g_tray_tip)) {
+                strncpy_s(nidApp.szTip, tip->c_str(), _TRUNCATE);
+                NOTIFYICONDATA modify = nidApp;
+                modify.uFlags = NIF_TIP;
+                Shell_NotifyIcon(NIM_MODIFY, &modify);
+            }
+            return 0;
+
+        case WM_APP_TRAYMSG:
+            switch (lParam) 
+            {
+                case WM_RBUTTONUP: 
+                {
+                    POINT curPoint;
+                    GetCursorPos(&curPoint);
+                    HMENU hPopupMenu = CreatePopupMenu();
+                    InsertMenu(hPopupMenu, 0xFFFFFFFF, MF_BYPOSITION | MF_STRING, ID_TRAY_SETTINGS_ITEM, "Settings");
+                    InsertMenu(hPopupMenu, 0xFFFFFFFF, MF_BYPOSITION | MF_STRING, ID_TRAY_RELOAD_SETTINGS_ITEM, "Reload Settings");
+                    InsertMenu(hPopupMenu, 0xFFFFFFFF, MF_BYPOSITION | MF_STRING | (g_alarms_paused ? MF_CHECKED : 0),
+                               ID_TRAY_PAUSE_ITEM, "Pause Alarms");
+                    InsertMenu(hPopupMenu, 0xFFFFFFFF, MF_BYPOSITION | MF_STRING, ID_TRAY_SAVE_POSE_HISTORY_ITEM, "Save Head Motion History");
+                    InsertMenu(hPopupMenu, 0xFFFFFFFF, MF_BYPOSITION | MF_STRING, ID_TRAY_SAVE_HEATMAP_ITEM, "Save Scan Heatmap");
+                    InsertMenu(hPopupMenu, 0xFFFFFFFF, MF_SEPARATOR, 0, NULL); 
+                    InsertMenu(hPopupMenu, 0xFFFFFFFF, MF_BYPOSITION | MF_STRING, 
+                               ID_TRAY_TOGGLE_CONSOLE_ITEM, 
+                               g_is_console_visible ? "Hide Status Window" : "Show Status Window"); 
+                    InsertMenu(hPopupMenu, 0xFFFFFFFF, MF_SEPARATOR, 0, NULL); 
+                    InsertMenu(hPopupMenu, 0xFFFFFFFF, MF_BYPOSITION | MF_STRING, ID_TRAY_EXIT_CONTEXT_MENU_ITEM, "Exit");
+                    
+                    SetForegroundWindow(hwnd); 
+
+                    TrackPopupMenu(hPopupMenu, TPM_RIGHTALIGN | TPM_BOTTOMALIGN | TPM_LEFTBUTTON, curPoint.x, curPoint.y, 0, hwnd, NULL);
+                    DestroyMenu(hPopupMenu);
+
+                    PostMessage(hwnd, WM_NULL, 0, 0); 
+                }
+                return 0;
+            }
+            break;
+
+        case WM_COMMAND: 
+            switch (LOWORD(wParam))
+            {
+                case ID_TRAY_EXIT_CONTEXT_MENU_ITEM:
+                    std::cout << "[INFO] Exit requested from tray menu. Shutting down." << std::endl;
+                    DestroyWindow(hwnd); 
+                    break;
+                case ID_TRAY_SETTINGS_ITEM:
+                    std::cout << "[INFO] Opening settings from tray menu." << std::endl;
+                    g_settings_window.show();
+                    break;
+                case ID_TRAY_SAVE_POSE_HISTORY_ITEM:
+                    post_core_command(CoreCommand::DUMP_POSE_HISTORY);
+                    break;
+                case ID_TRAY_SAVE_HEATMAP_ITEM:
+                    post_core_command(CoreCommand::DUMP_HEATMAP);
+                    break;
+                case ID_TRAY_RELOAD_SETTINGS_ITEM:
+                    post_core_command(CoreCommand::RELOAD_SETTINGS);
+                    break;
+                case ID_TRAY_PAUSE_ITEM:
+                    post_core_command(g_alarms_paused ? CoreCommand::RESUME : CoreCommand::PAUSE);
+                    break;
+                case ID_TRAY_TOGGLE_CONSOLE_ITEM:
+                    if (g_is_console_visible)
+                    {
+                        HideConsoleWindow();
+                    }
+                    else
+                    {
+                        ShowConsoleWindow();
+                    }
+                    break;
+            }
+            break;
+
+
+        case WM_DESTROY:
+            if (g_is_console_visible) HideConsoleWindow(); 
+            if (g_input_thread_id) PostThreadMessage(g_input_thread_id, WM_QUIT, 0, 0);
+            uninstall_condor_window_hooks();
+            Shell_NotifyIcon(NIM_DELETE, &nidApp); 
+            PostQuitMessage(0); 
+            request_shutdown(); // Ends every worker wait now, not at its timeout
+            break;
+
+        default:
+            return DefWindowProc(hwnd, uMsg, wParam, lParam);
+    }
+    return 0;
+}
+
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow)
+{
+    UNREFERENCED_PARAMETER(hPrevInstance); 
+    UNREFERENCED_PARAMETER(nCmdShow);
+    g_launch_us = monotonic_now_us();
+
+    if (lpCmdLine && std::strstr(lpCmdLine, "--perf-selftest")) {
+        // Report into the console we were started from (start /wait lookout.exe --perf-selftest),
+        // else a new one kept open until Enter
+        bool own_console = !AttachConsole(ATTACH_PARENT_PROCESS);
+        if (own_console) AllocConsole();
+        FILE* fp_stdout, *fp_stderr, *fp_stdin;
+        _wfreopen_s(&fp_stdout, L"CONOUT$", L"w", stdout);
+        _wfreopen_s(&fp_stderr, L"CONOUT$", L"w", stderr);
+        _wfreopen_s(&fp_stdin, L"CONIN$", L"r", stdin);
+        std::cout.clear();
+        std::cerr.clear();
+        std::cin.clear();
+        g_log_sinks.fetch_or(LOG_SINK_CONSOLE);
+        int result = run_perf_selftest();
+        if (own_console) {
+            std::cout << "Press Enter to close." << std::endl;
+            std::cin.get();
+        }
+        return result;
+    }
+
+    // One monitor per session. Held until the process exits; a second launch (Run key
+    // plus the shortcut, say) hands its commands to this one and leaves. The startup task
+    // finding one already running (started by hand during the delay) just leaves.
+    g_started_by_task = lpCmdLine && std::strstr(lpCmdLine, STARTUP_TASK_ARGUMENT);
+    HANDLE instance_mutex = CreateMutexA(nullptr, FALSE, "Local\\QuestLookout.instance");
+    if (instance_mutex && GetLastError() == ERROR_ALREADY_EXISTS) {
+        bool forwarded = g_started_by_task || forward_to_running_instance(lpCmdLine);
+        CloseHandle(instance_mutex);
+        return forwarded ? 0 : 1;
+    }
+
+    // Kiosk rigs: only the core, the flight detectors and the audio, driven through the
+    // pipes (--exit, or "exit" on the control pipe, ends it)
+    g_headless = lpCmdLine && std::strstr(lpCmdLine, "--headless");
+
+    // Ahead of the first thread, and declared first so it's restored after every join
+    ConsoleCaptureScope console_capture;
+
+    // One parse of settings.json for every consumer, on a startup task while the window
+    // and the tray icon are created
+    std::future<std::shared_ptr<const Settings>> settings_parse = std::async(std::launch::async, []() {
+        const int64_t start_us = monotonic_now_us();
+        std::shared_ptr<const Settings> parsed = load_settings("settings.json");
+        record_startup_phase(STARTUP_SETTINGS, start_us);
+        return parsed;
+    });
+
+    int64_t phase_start_us = monotonic_now_us();
+    if (g_headless) return run_headless(settings_parse.get());
+    WNDCLASSEX wc = {0};
+    wc.cbSize        = sizeof(WNDCLASSEX);
+    wc.lpfnWndProc   = WndProc;
+    wc.hInstance     = hInstance;
+    wc.lpszClassName = WINDOW_CLASS_NAME;
+    wc.hIcon         = LoadIcon(NULL, IDI_APPLICATION); 
+    wc.hCursor       = LoadCursor(NULL, IDC_ARROW);
+
+    if (!RegisterClassEx(&wc))
+    {
+        MessageBox(NULL, "Window Registration Failed!", "Error!", MB_ICONEXCLAMATION | MB_OK);
+        return 0;
+    }
+
+    g_hwnd = CreateWindowEx(
+        0,                              
+        WINDOW_CLASS_NAME,              
+        "Quest Lookout Hidden Window",  
+        0,                              
+        CW_USEDEFAULT, CW_USEDEFAULT, CW_USEDEFAULT, CW_USEDEFAULT, 
+        NULL,       
+        NULL,       
+        hInstance,  
+        NULL        
+    );
+
+    if (g_hwnd == NULL)
+    {
+        MessageBox(NULL, "Window Creation Failed!", "Error!", MB_ICONEXCLAMATION | MB_OK);
+        return 0;
+    }
+    phase_start_us = record_startup_phase(STARTUP_WINDOW, phase_start_us);
+
+    nidApp.cbSize = sizeof(NOTIFYICONDATA);
+    nidApp.hWnd = g_hwnd;
+    nidApp.uID = ID_TRAY_APP_ICON;
+    nidApp.uFlags = NIF_ICON | NIF_MESSAGE | NIF_TIP;
+    nidApp.uCallbackMessage = WM_APP_TRAYMSG;
+    nidApp.hIcon = LoadIcon(NULL, IDI_APPLICATION); 
+    strncpy_s(nidApp.szTip, "Quest Lookout", _TRUNCATE); 
+
+
+    if (!Shell_NotifyIcon(NIM_ADD, &nidApp)) {
+        MessageBox(NULL, "Failed to add tray icon!", "Error!", MB_ICONEXCLAMATION | MB_OK);
+    }
+    record_startup_phase(STARTUP_TRAY, phase_start_us);
+    
+    // The hotkeys go to the input thread, which installs the hook; the sim profiles must
+    // be set before any detector thread runs
+    TraceLoggingRegister(g_trace_provider);
+    std::shared_ptr<const Settings> settings = settings_parse.get();
+    apply_hotkey_settings(settings->hotkeys);
+    g_sim_profiles = settings->sim_profiles;
+    g_thread_placement = settings->threads;
+    g_shutdown_event = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    HANDLE input_ready_event = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    std::thread input_thread(input_thread_main, input_ready_event);
+    WaitForSingleObject(input_ready_event, 2000); // The thread may still set it after a timeout, so it's closed once joined
+    install_condor_window_hooks(); // Callbacks are pumped by the message loop below
+    
+    g_core_wake_event = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+    g_sampler_wake_event = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+    std::thread core_logic_thread(app_core_logic, settings);
+    
+    MSG msg;
+    while (GetMessage(&msg, NULL, 0, 0) > 0) 
+    {
+        if (g_settings_window.dispatch(msg)) continue;
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+    }
+
+    if (core_logic_thread.joinable()) {
+        core_logic_thread.join(); 
+    }
+    if (input_thread.joinable()) {
+        if (g_input_thread_id) PostThreadMessage(g_input_thread_id, WM_QUIT, 0, 0); // In case WM_DESTROY never ran
+        input_thread.join();
+    }
+    CloseHandle(input_ready_event);
+    if (g_core_wake_event) {
+        CloseHandle(g_core_wake_event);
+        g_core_wake_event = nullptr;
+    }
+    if (g_sampler_wake_event) {
+        CloseHandle(g_sampler_wake_event);
+        g_sampler_wake_event = nullptr;
+    }
+    if (g_shutdown_event) {
+        CloseHandle(g_shutdown_event);
+        g_shutdown_event = nullptr;
+    }
+    TraceLoggingUnregister(g_trace_provider);
+
+    return (int)msg.wParam;
+}
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002 // Windows 10 1803+
+#endif
+
+// Waitable-timer sleep backend. With CREATE_WAITABLE_TIMER_HIGH_RESOLUTION the wait
+// is precise to well under a millisecond without raising the global timer
+// resolution (timeBeginPeriod) for the whole machine. Older builds reject the
+// flag, in which case we fall back to std::this_thread sleeps.
+class HighResolutionTimer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    HighResolutionTimer() {
+        timer_ = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        if (timer_) {
+            std::cout << "[INFO] Using high-resolution waitable timer for polling" << std::endl;
+        } else {
+            std::cout << "[INFO] High-resolution waitable timer unavailable (error=" << GetLastError()
+                      << "), using standard sleep" << std::endl;
+        }
+    }
+    ~HighResolutionTimer() {
+        if (timer_) CloseHandle(timer_);
+    }
+    HighResolutionTimer(const HighResolutionTimer&) = delete;
+    HighResolutionTimer& operator=(const HighResolutionTimer&) = delete;
+
+    bool is_high_resolution() const { return timer_ != nullptr; }
+
+    void sleep_until(Clock::time_point deadline) {
+        Clock::duration remaining = deadline - Clock::now();
+        if (remaining <= Clock::duration::zero()) return;
+        if (!timer_) {
+            std::this_thread::sleep_until(deadline);
+            return;
+        }
+        // Negative due time = relative, in 100 ns units
+        LARGE_INTEGER due_time;
+        due_time.QuadPart = -static_cast<LONGLONG>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count() / 100);
+        if (due_time.QuadPart == 0) return;
+        if (!SetWaitableTimer(timer_, &due_time, 0, nullptr, nullptr, FALSE) ||
+            WaitForSingleObject(timer_, INFINITE) != WAIT_OBJECT_0) {
+            std::this_thread::sleep_until(deadline);
+        }
+    }
+
+    void sleep_for(std::chrono::milliseconds duration) { sleep_until(Clock::now() + duration); }
+
+    // Block until `deadline` or until `wake_event` (or g_shutdown_event) is signaled.
+    // Returns true if woken by an event.
+    bool wait_until(Clock::time_point deadline, HANDLE wake_event) {
+        HANDLE handles[3];
+        DWORD events = 0;
+        if (wake_event) handles[events++] = wake_event;
+        if (g_shutdown_event) handles[events++] = g_shutdown_event;
+        if (events == 0) {
+            sleep_until(deadline);
+            return false;
+        }
+        Clock::duration remaining = deadline - Clock::now();
+        if (remaining <= Clock::duration::zero()) return false;
+        if (timer_) {
+            LARGE_INTEGER due_time;
+            due_time.QuadPart = -static_cast<LONGLONG>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count() / 100);
+            if (due_time.QuadPart != 0 && SetWaitableTimer(timer_, &due_time, 0, nullptr, nullptr, FALSE)) {
+                handles[events] = timer_;
+                DWORD result = WaitForMultipleObjects(events + 1, handles, FALSE, INFINITE);
+                if (result < WAIT_OBJECT_0 + events) {
+                    CancelWaitableTimer(timer_);
+                    return true;
+                }
+                return false;
+            }
+        }
+        DWORD timeout_ms = static_cast<DWORD>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(remaining).count());
+        return WaitForMultipleObjects(events, handles, FALSE, timeout_ms) < WAIT_OBJECT_0 + events;
+    }
+
+private:
+    HANDLE timer_ = nullptr;
+};
+
+// Fixed-bucket latency histogram (microseconds): 8 log-spaced buckets per power of two,
+// so percentiles are within ~6% and recording never allocates.
+class LatencyHistogram {
+public:
+    void record(int64_t value_us) {
+        if (value_us < 0) value_us = 0;
+        ++buckets_[bucket_for(value_us)];
+        ++count_;
+        max_us_ = (std::max)(max_us_, value_us);
+    }
+
+    // Approximate value (bucket midpoint) at or below which `fraction` of samples fall
+    int64_t percentile(double fraction) const {
+        if (count_ == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(fraction * (count_ - 1)) + 1;
+        uint64_t seen = 0;
+        for (int b = 0; b < kBuckets; ++b) {
+            seen += buckets_[b];
+            if (seen >= rank) {
+                return (std::min)((bucket_lower(b) + bucket_lower(b + 1)) / 2, max_us_);
+            }
+        }
+        return max_us_;
+    }
+
+    int64_t max_us() const { return max_us_; }
+    uint64_t count() const { return count_; }
+
+    void reset() {
+        buckets_.fill(0);
+        count_ = 0;
+        max_us_ = 0;
+    }
+
+private:
+    static constexpr int kSubBits = 3;
+    static constexpr int kSub = 1 << kSubBits;
+    static constexpr int kMaxExponent = 32;  // Values past ~71 minutes share the last bucket
+    static constexpr int kBuckets = (kMaxExponent - kSubBits + 2) * kSub;
+
+    static int bucket_for(int64_t v) {
+        if (v < kSub) return static_cast<int>(v);
+        int exponent = 0;
+        for (uint64_t x = static_cast<uint64_t>(v); x > 1; x >>= 1) ++exponent;
+        if (exponent > kMaxExponent) return kBuckets - 1;
+        int sub = static_cast<int>((v >> (exponent - kSubBits)) & (kSub - 1));
+        return (exponent - kSubBits + 1) * kSub + sub;
+    }
+
+    static int64_t bucket_lower(int b) {
+        if (b < kSub) return b;
+        int exponent = b / kSub - 1 + kSubBits;
+        return static_cast<int64_t>(kSub + b % kSub) << (exponent - kSubBits);
+    }
+
+    std::array<uint64_t, kBuckets> buckets_{};
+    uint64_t count_ = 0;
+    int64_t max_us_ = 0;
+};
+
+// Records the real period and the work time of each evaluated loop iteration and warns
+// when a tick overruns its budget, naming the phase that used the time. A late period
+// with little work means the thread wasn't scheduled (e.g. starved by the sim), not
+// that the lookout logic was slow.
+class TickWatchdog {
+public:
+    enum Phase { PHASE_FLIGHT_CHECK, PHASE_TRACKING, PHASE_ALARMS, PHASE_COUNT };
+
+    // With track_period off only work time is recorded (for loops woken by events
+    // rather than a fixed tick)
+    TickWatchdog(const char* name, const WatchdogConfig& config, bool track_period = true)
+        : name_(name), config_(config), track_period_(track_period) {}
+
+    void begin_tick(int64_t now_us) {
+        if (last_tick_start_us_ >= 0 && previous_tick_completed_) {
+            pending_period_us_ = now_us - last_tick_start_us_;
+        } else {
+            pending_period_us_ = -1; // Previous iteration was idle or paused
+        }
+        previous_tick_completed_ = false;
+        last_tick_start_us_ = now_us;
+        phase_start_us_ = now_us;
+        phase_us_.fill(0);
+        tick_allocations_start_ = thread_heap_allocations();
+    }
+
+    // End the current phase and attribute its time to `phase`
+    void end_phase(Phase phase, int64_t now_us) {
+        phase_us_[phase] += now_us - phase_start_us_;
+        phase_start_us_ = now_us;
+    }
+
+    void end_tick(int64_t now_us, double budget_seconds) {
+        if (!config_.enabled) return;
+        const uint64_t allocations = thread_heap_allocations() - tick_allocations_start_; // Before the warnings allocate
+        allocations_ += allocations;
+        max_tick_allocations_ = (std::max)(max_tick_allocations_, allocations);
+        if (allocations > 0) ++allocating_ticks_;
+        previous_tick_completed_ = true;
+        int64_t budget_us = static_cast<int64_t>(budget_seconds * 1e6);
+        int64_t limit_us = static_cast<int64_t>(budget_us * config_.overrun_factor);
+        int64_t work_us = now_us - last_tick_start_us_;
+        work_.record(work_us);
+
+        if (track_period_ && pending_period_us_ >= 0) {
+            period_.record(pending_period_us_);
+            jitter_.record(std::llabs(pending_period_us_ - budget_us));
+            if (pending_period_us_ > limit_us && work_us <= budget_us) {
+                ++late_count_;
+                warn(now_us, "Tick late: period " + format_ms(pending_period_us_) + " vs budget " + format_ms(budget_us) +
+                             " (phase: scheduling/wait)");
+            }
+        }
+        if (work_us > limit_us) {
+            ++overrun_count_;
+            int worst = 0;
+            for (int p = 1; p < PHASE_COUNT; ++p) {
+                if (phase_us_[p] > phase_us_[worst]) worst = p;
+            }
+            warn(now_us, "Tick overrun: work " + format_ms(work_us) + " vs budget " + format_ms(budget_us) +
+                         " (phase: " + phase_name(static_cast<Phase>(worst)) + " " + format_ms(phase_us_[worst]) + ")");
+        }
+    }
+
+    // Periodically print and reset the timing summary
+    void report_if_due(int64_t now_us) {
+        if (!config_.enabled) return;
+        if (last_report_us_ < 0) last_report_us_ = now_us;
+        if (now_us - last_report_us_ < static_cast<int64_t>(config_.report_interval_s * 1e6)) return;
+        last_report_us_ = now_us;
+        if (work_.count() == 0) return;
+
+        if (log_level_enabled(LEVEL_INFO)) {
+            std::cout << "[TIMING] " << name_;
+            if (track_period_) {
+                std::cout << " period p50/p99/max " << format_ms(period_.percentile(0.5)) << "/"
+                          << format_ms(period_.percentile(0.99)) << "/" << format_ms(period_.max_us())
+                          << " | jitter p99 " << format_ms(jitter_.percentile(0.99)) << " |";
+            }
+            std::cout << " work p50/p99/max " << format_ms(work_.percentile(0.5)) << "/"
+                      << format_ms(work_.percentile(0.99)) << "/" << format_ms(work_.max_us())
+                      << " | ticks " << work_.count() << ", overruns " << overrun_count_ << ", late " << late_count_;
+            if (LOOKOUT_COUNT_ALLOCATIONS) {
+                std::cout << " | heap allocations/tick avg " << std::fixed << std::setprecision(2)
+                          << static_cast<double>(allocations_) / work_.count() << std::defaultfloat << ", max "
+                          << max_tick_allocations_;
+            }
+            std::cout << std::endl;
+        }
+        if (allocating_ticks_ > 0) {
+            std::cerr << "[WARNING] " << name_ << ": " << allocating_ticks_ << " of " << work_.count()
+                      << " ticks allocated on the heap (" << allocations_ << " allocations)" << std::endl;
+        }
+        period_.reset();
+        jitter_.reset();
+        work_.reset();
+        overrun_count_ = 0;
+        late_count_ = 0;
+        allocations_ = max_tick_allocations_ = allocating_ticks_ = 0;
+    }
+
+private:
+    static const char* phase_name(Phase phase) {
+        switch (phase) {
+            case PHASE_FLIGHT_CHECK: return "flight check";
+            case PHASE_TRACKING: return "tracking";
+            case PHASE_ALARMS: return "alarms/audio";
+            default: return "unknown";
+        }
+    }
+
+    static std::string format_ms(int64_t us) {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(2) << us / 1000.0 << "ms";
+        return out.str();
+    }
+
+    // At most one warning per second; the rest are counted in the periodic summary
+    void warn(int64_t now_us, const std::string& message) {
+        if (last_warning_us_ >= 0 && now_us - last_warning_us_ < 1000000) return;
+        last_warning_us_ = now_us;
+        std::cerr << "[WARNING] " << name_ << ": " << message << std::endl;
+    }
+
+    const char* name_;
+    WatchdogConfig config_;
+    bool track_period_;
+    LatencyHistogram period_, jitter_, work_;
+    std::array<int64_t, PHASE_COUNT> phase_us_{};
+    int64_t last_tick_start_us_ = -1;
+    int64_t pending_period_us_ = -1;
+    int64_t phase_start_us_ = 0;
+    int64_t last_report_us_ = -1;
+    int64_t last_warning_us_ = -1;
+    bool previous_tick_completed_ = false;
+    uint64_t overrun_count_ = 0, late_count_ = 0;
+    uint64_t tick_allocations_start_ = 0;  // thread_heap_allocations() at begin_tick
+    uint64_t allocations_ = 0, max_tick_allocations_ = 0, allocating_ticks_ = 0;
+};
+
+// Deadline-driven tick scheduler for the core loop. Deadlines advance by a fixed
+// period on a steady clock, so work time and timer rounding don't stretch ticks;
+// we only sleep for whatever is left of the current period.
+class TickScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    TickScheduler(HighResolutionTimer& timer, double period_seconds)
+        : timer_(timer), period_(to_duration(period_seconds)), next_deadline_(Clock::now() + period_) {}
+
+    // Sleep until the next deadline, one period after the previous one.
+    void wait_next_tick() { wait_after(period_); }
+
+    // Sleep until `interval` after the previous deadline (idle paths use a longer fixed interval).
+    void wait_after_seconds(double interval_seconds) { wait_after(to_duration(interval_seconds)); }
+
+    void set_period(double period_seconds) { period_ = to_duration(period_seconds); }
+    double period_seconds() const { return std::chrono::duration<double>(period_).count(); }
+
+    // Idle wait: block for up to `timeout_seconds` or until `wake_event` fires, then
+    // restart the deadline sequence. Returns true if woken by the event.
+    bool idle_wait(double timeout_seconds, HANDLE wake_event) {
+        bool woken = timer_.wait_until(Clock::now() + to_duration(timeout_seconds), wake_event);
+        resync();
+        return woken;
+    }
+
+    // Restart the deadline sequence from now (after a long blocking wait).
+    void resync() { next_deadline_ = Clock::now(); }
+
+private:
+    void wait_after(Clock::duration interval) {
+        next_deadline_ += interval;
+        Clock::time_point now = Clock::now();
+        if (next_deadline_ <= now) {
+            // Fell behind by more than the remaining budget (e.g. a blocking stall).
+            // Resync instead of firing a burst of back-to-back catch-up ticks.
+            if (now - next_deadline_ > interval) {
+                next_deadline_ = now;
+            }
+            return;
+        }
+        timer_.sleep_until(next_deadline_);
+    }
+
+    static Clock::duration to_duration(double seconds) {
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    }
+
+    HighResolutionTimer& timer_;
+    Clock::duration period_;
+    Clock::time_point next_deadline_;
+};
+
+// Exponential retry delays with jitter, for reconnecting to the headset runtime: starts
+// at `initial`, doubles per failure up to `cap`, and each delay is drawn from
+// [delay/2, delay] so several stations coming back together don't retry in lockstep.
+class RetryBackoff {
+public:
+    RetryBackoff(int64_t initial_us, int64_t cap_us)
+        : initial_us_(initial_us), cap_us_(cap_us), current_us_(initial_us), rng_(static_cast<uint32_t>(monotonic_now_us())) {}
+
+    int64_t next_delay_us() {
+        int64_t delay = current_us_;
+        current_us_ = (std::min)(cap_us_, current_us_ * 2);
+        ++attempts_;
+        std::uniform_int_distribution<int64_t> jitter(delay / 2, delay);
+        return jitter(rng_);
+    }
+
+    void reset() {
+        current_us_ = initial_us_;
+        attempts_ = 0;
+    }
+
+    int attempts() const { return attempts_; }
+
+private:
+    int64_t initial_us_, cap_us_, current_us_;
+    int attempts_ = 0;
+    std::mt19937 rng_;
+};
+
+// Lock-free single-producer/single-consumer ring. Capacity must be a power of two;
+// a full ring rejects the push rather than overwrite samples the consumer hasn't seen.
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert((Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+    bool try_push(const T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == Capacity) return false;
+        items_[head & (Capacity - 1)] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Pop up to `max_items` into `out`; returns the number popped
+    size_t pop_batch(T* out, size_t max_items) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t available = head_.load(std::memory_order_acquire) - tail;
+        size_t count = (std::min)(available, max_items);
+        for (size_t n = 0; n < count; ++n) {
+            out[n] = items_[(tail + n) & (Capacity - 1)];
+        }
+        tail_.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+private:
+    std::array<T, Capacity> items_{};
+    alignas(64) std::atomic<size_t> head_{0}; // Written by the producer only
+    alignas(64) std::atomic<size_t> tail_{0}; // Written by the consumer only
+};
+
+// Tracking thread -> audio command, the unit of the audio queue
+struct AudioCommand {
+    enum Type : uint8_t { PLAY, MUTE, UNMUTE, STOP, STOP_ALL, RELOAD };
+    Type type = STOP_ALL;
+    uint16_t alarm = 0;
+    float from = 0.0f, to = 0.0f; // PLAY ramp gains (0..1)
+    int32_t ramp_ms = 0, elapsed_ms = 0;
+    int64_t decided_us = 0;       // PLAY of a new warning or MUTE after a look: monotonic time of the decision, for latency stats
+    uint32_t generation = 0;      // RELOAD: the reloaded voice set later commands refer to
+};
+
+// Mixer -> tracking thread: how long a new warning (or a timed mute) took to reach the
+// audio device
+struct AudioLatencySample {
+    uint16_t alarm = 0;
+    bool mute = false;     // A MUTE with a decision time rather than a new warning
+    int64_t mixer_us = 0;  // Decision to the mixer starting the clip, or the fade out (queue, stream start)
+    int64_t output_us = 0; // Decision to the first block with it handed to the device
+};
+
+// Gain curve of one alarm voice: the warning ramp times the silence-after-look mute.
+// Evaluated by the mixer at both ends of every block and interpolated across it, so the
+// ramp and the mute are smooth per-sample curves rather than setVolume() steps. Times
+// are mixer time (microseconds of audio rendered).
+class GainEnvelope {
+public:
+    static constexpr int64_t kMuteFadeUs = 20000; // Mute and unmute fade, short enough to sound instant
+
+    // Start of a warning or a repeat: ramp from `from` to `to` over `ramp_us`, of which
+    // `elapsed_us` have already passed, unmuted
+    void start(float from, float to, int64_t ramp_us, int64_t elapsed_us, int64_t now_us) {
+        ramp_ = Segment{ from, to, now_us - elapsed_us, ramp_us };
+        mute_ = Segment{ 1.0f, 1.0f, now_us, 0 };
+    }
+
+    void set_muted(bool muted, int64_t now_us) {
+        mute_ = Segment{ mute_.at(now_us), muted ? 0.0f : 1.0f, now_us, kMuteFadeUs };
+    }
+
+    float at(int64_t t_us) const { return ramp_.at(t_us) * mute_.at(t_us); }
+    bool muted() const { return mute_.to == 0.0f; }
+
+private:
+    // Linear move from `from` to `to` starting at start_us
+    struct Segment {
+        float from = 1.0f, to = 1.0f;
+        int64_t start_us = 0, duration_us = 0;
+
+        float at(int64_t t_us) const {
+            if (duration_us <= 0 || t_us >= start_us + duration_us) return to;
+            if (t_us <= start_us) return from;
+            return from + (to - from) * static_cast<float>(t_us - start_us) / static_cast<float>(duration_us);
+        }
+    };
+
+    Segment ramp_, mute_;
+};
+
+// Frames of one alarm clip: a decoded buffer from g_audio_cache, or a long clip decoded
+// from its memory-mapped file through a small window as it plays. Access moves forward only, apart from
+// rewinding to the start.
+class ClipSource {
+public:
+    static constexpr size_t kWindowFrames = 4096;
+
+    void set_buffer(const sf::SoundBuffer& buffer) {
+        samples_ = buffer.getSamples();
+        channels_ = buffer.getChannelCount();
+        sample_rate_ = buffer.getSampleRate();
+        frames_ = channels_ ? buffer.getSampleCount() / channels_ : 0;
+    }
+
+    bool open_stream(const std::string& path) {
+        auto mapped = std::make_unique<MappedFileStream>();
+        auto file = std::make_unique<sf::InputSoundFile>();
+        try {
+            if (!mapped->open(path)) throw std::runtime_error("cannot map file");
+            if (!file->openFromStream(*mapped)) throw std::runtime_error("unsupported format");
+        } catch (const std::exception& e) {
+            std::cerr << "[ERROR] Could not open streamed audio file " << path << ": " << e.what() << std::endl;
+            return false;
+        }
+        channels_ = file->getChannelCount();
+        sample_rate_ = file->getSampleRate();
+        frames_ = channels_ ? file->getSampleCount() / channels_ : 0;
+        window_.assign(kWindowFrames * channels_, 0);
+        mapped_ = std::move(mapped);
+        file_ = std::move(file);
+        return true;
+    }
+
+    bool valid() const { return frames_ > 0 && channels_ > 0; }
+    unsigned int sample_rate() const { return sample_rate_; }
+
+    void rewind() {
+        if (!file_) return;
+        file_->seek(std::uint64_t{ 0 });
+        window_start_ = window_frames_ = 0;
+    }
+
+    // Left/right of frame `f` (mono plays on both sides, channels past two are dropped);
+    // false once past the end
+    bool frame(uint64_t f, float& left, float& right) {
+        if (f >= frames_) return false;
+        const std::int16_t* s;
+        if (!file_) {
+            s = samples_ + f * channels_;
+        } else {
+            if (f < window_start_ || f >= window_start_ + window_frames_) refill(f);
+            if (f >= window_start_ + window_frames_) return false;
+            s = window_.data() + (f - window_start_) * channels_;
+        }
+        left = s[0] * (1.0f / 32768.0f);
+        right = channels_ > 1 ? s[1] * (1.0f / 32768.0f) : left;
+        return true;
+    }
+
+private:
+    // Reading on from the window's end keeps its last frame, which interpolation still needs
+    void refill(uint64_t f) {
+        size_t kept = 0;
+        if (window_frames_ > 0 && f == window_start_ + window_frames_) {
+            std::copy_n(window_.data() + (window_frames_ - 1) * channels_, channels_, window_.data());
+            window_start_ = f - 1;
+            kept = 1;
+        } else {
+            file_->seek(f * channels_);
+            window_start_ = f;
+        }
+        uint64_t read = file_->read(window_.data() + kept * channels_, (kWindowFrames - kept) * channels_);
+        window_frames_ = kept + read / channels_;
+    }
+
+    const std::int16_t* samples_ = nullptr;
+    std::unique_ptr<MappedFileStream> mapped_; // Declared first: outlives the decoder reading it
+    std::unique_ptr<sf::InputSoundFile> file_;
+    std::vector<std::int16_t> window_;
+    uint64_t window_start_ = 0, window_frames_ = 0;
+    uint64_t frames_ = 0;
+    unsigned int channels_ = 0, sample_rate_ = 0;
+};
+
+// All alarm audio goes through this one sf::SoundStream: one OpenAL source and one
+// audio thread however many alarms there are, and a fixed cost per 10 ms block. Each
+// block it applies the queued commands, then sums the playing alarm voices, resampled
+// to the output rate and shaped by their gain envelopes. While a wider alarm is
+// audible, narrower ones are ducked so the most demanding reminder stays on top.
+class AlarmMixer : public sf::SoundStream {
+public:
+    static constexpr unsigned int kSampleRate = 48000;
+    static constexpr unsigned int kChannels = 2;
+    static constexpr size_t kBlockFrames = 480;
+    static constexpr size_t kQueueCapacity = 256;
+    static constexpr float kDuckStepPerBlock = 0.1f; // Duck and unduck over ~100 ms
+
+    AlarmMixer() {
+        initialize(kChannels, kSampleRate, { sf::SoundChannel::FrontLeft, sf::SoundChannel::FrontRight });
+        mix_.resize(kBlockFrames * kChannels);
+        out_.resize(kBlockFrames * kChannels);
+        held_.reserve(kQueueCapacity);
+    }
+
+    ~AlarmMixer() override { stop(); }
+
+    // Audio worker, before the first play(). Returns which alarms have a playable clip.
+    std::vector<bool> create(const std::vector<LookoutAlarmConfig>& alarms, const AudioConfig& config) {
+        duck_gain_ = config.duck_volume / 100.0f;
+        voices_ = build_voices(alarms);
+        return ready_voices(voices_);
+    }
+
+    // Audio worker, settings reload: build the voices for the reloaded alarms while the
+    // current ones keep playing. The stream thread swaps them in when it reaches the
+    // RELOAD command with this generation, so commands queued after the reload always
+    // address the new alarm indices. Only one set can wait at a time.
+    // With `clips` false the voices are silent placeholders (memory budget, no flight).
+    std::vector<bool> stage(const std::vector<LookoutAlarmConfig>& alarms, const AudioConfig& config, uint32_t generation,
+                            bool clips = true) {
+        staged_ = clips ? build_voices(alarms) : std::vector<Voice>(alarms.size());
+        std::vector<bool> ready = ready_voices(staged_);
+        staged_duck_gain_ = config.duck_volume / 100.0f;
+        staged_generation_ = generation;
+        staged_ready_.store(true, std::memory_order_release);
+        return ready;
+    }
+
+    bool staged_pending() const { return staged_ready_.load(std::memory_order_acquire); }
+
+    // Tracking thread only (single producer)
+    bool post(const AudioCommand& command) {
+        if (!commands_.try_push(command)) return false;
+        posted_.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+
+    // Audio worker: nothing queued, nothing playing, since `since_us` (monotonic)
+    bool idle_since(int64_t& since_us) const {
+        if (applied_.load(std::memory_order_acquire) != posted_.load(std::memory_order_acquire)) return false;
+        if (voices_active_.load(std::memory_order_acquire)) return false;
+        since_us = idle_since_us_.load(std::memory_order_relaxed);
+        return true;
+    }
+
+    bool has_pending() const { return applied_.load(std::memory_order_acquire) != posted_.load(std::memory_order_acquire); }
+
+    // Tracking thread only (single consumer)
+    size_t pop_latency(AudioLatencySample* out, size_t max_samples) { return latency_.pop_batch(out, max_samples); }
+
+protected:
+    bool onGetData(Chunk& data) override {
+        int64_t block_start_us = mix_us();
+        apply_commands(block_start_us);
+        frames_rendered_ += kBlockFrames;
+        int64_t block_end_us = mix_us();
+
+        float top_priority = -1.0f;
+        for (const Voice& voice : voices_) {
+            if (voice.playing && !voice.envelope.muted()) top_priority = (std::max)(top_priority, voice.priority);
+        }
+
+        std::fill(mix_.begin(), mix_.end(), 0.0f);
+        bool any_playing = false;
+        int64_t latency_now_us = 0;
+        for (Voice& voice : voices_) {
+            if (!voice.playing) continue;
+            float duck_target = voice.priority < top_priority ? duck_gain_ : 1.0f;
+            float duck_from = voice.duck;
+            voice.duck += (std::max)(-kDuckStepPerBlock, (std::min)(kDuckStepPerBlock, duck_target - voice.duck));
+            mix_voice(voice, voice.envelope.at(block_start_us) * duck_from, voice.envelope.at(block_end_us) * voice.duck);
+            any_playing |= voice.playing;
+            if (voice.decided_us != 0) {
+                if (latency_now_us == 0) latency_now_us = monotonic_now_us();
+                AudioLatencySample sample;
+                sample.alarm = static_cast<uint16_t>(&voice - voices_.data());
+                sample.mixer_us = voice.started_us - voice.decided_us;
+                sample.output_us = latency_now_us - voice.decided_us;
+                latency_.try_push(sample); // Stats only: a full ring just loses the sample
+                voice.decided_us = 0;
+            }
+            if (voice.mute_decided_us != 0) {
+                if (latency_now_us == 0) latency_now_us = monotonic_now_us();
+                AudioLatencySample sample;
+                sample.alarm = static_cast<uint16_t>(&voice - voices_.data());
+                sample.mute = true;
+                sample.mixer_us = voice.muted_us - voice.mute_decided_us;
+                sample.output_us = latency_now_us - voice.mute_decided_us;
+                latency_.try_push(sample);
+                voice.mute_decided_us = 0;
+            }
+        }
+
+        for (size_t n = 0; n < mix_.size(); ++n) {
+            float sample = (std::max)(-1.0f, (std::min)(1.0f, mix_[n]));
+            out_[n] = static_cast<std::int16_t>(sample * 32767.0f);
+        }
+        if (!any_playing && voices_active_.load(std::memory_order_relaxed)) {
+            idle_since_us_.store(monotonic_now_us(), std::memory_order_relaxed);
+        }
+        voices_active_.store(any_playing, std::memory_order_release);
+
+        data.samples = out_.data();
+        data.sampleCount = out_.size();
+        return true; // The audio worker stops the stream once it has been idle for a while
+    }
+
+    void onSeek(sf::Time) override {}
+
+private:
+    struct Voice {
+        ClipSource clip;
+        GainEnvelope envelope;
+        float priority = 0.0f; // min_horizontal_angle: wider alarms duck narrower ones
+        double position = 0.0; // Clip frames
+        double step = 1.0;     // Clip frames per output frame
+        float duck = 1.0f;
+        bool playing = false;
+        int64_t decided_us = 0, started_us = 0; // Latency of a new warning, until its first block is out
+        int64_t mute_decided_us = 0, muted_us = 0; // Same for a timed mute, until its fade starts going out
+    };
+
+    int64_t mix_us() const { return static_cast<int64_t>(frames_rendered_ * 1000000 / kSampleRate); }
+
+    static std::vector<bool> ready_voices(const std::vector<Voice>& voices) {
+        std::vector<bool> ready(voices.size());
+        for (size_t i = 0; i < voices.size(); ++i) ready[i] = voices[i].clip.valid();
+        return ready;
+    }
+
+    std::vector<Voice> build_voices(const std::vector<LookoutAlarmConfig>& alarms) const {
+        std::vector<Voice> voices(alarms.size());
+        size_t ready = 0, streamed = 0;
+        for (size_t i = 0; i < alarms.size(); ++i) {
+            if (!alarms[i].enabled()) continue;
+            Voice& voice = voices[i];
+            voice.priority = alarms[i].min_horizontal_angle;
+            const std::string& file = alarms[i].audio_file;
+            if (g_audio_cache.is_streamed(file) && voice.clip.open_stream(file)) {
+                ++streamed;
+            } else if (const sf::SoundBuffer* buffer = g_audio_cache.find(file)) {
+                voice.clip.set_buffer(*buffer);
+            } else {
+                std::cerr << "[ERROR] No decoded audio for: " << (file.empty() ? "beep.wav" : file) << std::endl;
+            }
+            if (voice.clip.valid()) {
+                voice.step = static_cast<double>(voice.clip.sample_rate()) / kSampleRate;
+                ++ready;
+            }
+        }
+        std::cout << "[INFO] Audio mixer ready: " << ready << " alarm clip(s), " << streamed << " streamed" << std::endl;
+        return voices;
+    }
+
+
+    // Commands behind a RELOAD whose voices aren't staged yet are held, in order, until
+    // they are; everything was stopped just before the reload, so the wait is silent
+    void apply_commands(int64_t now_us) {
+        if (held_.empty()) {
+            std::array<AudioCommand, kQueueCapacity> batch;
+            size_t count = commands_.pop_batch(batch.data(), batch.size());
+            held_.assign(batch.begin(), batch.begin() + count);
+        }
+        size_t n = 0;
+        for (; n < held_.size(); ++n) {
+            const AudioCommand& command = held_[n];
+            if (command.type == AudioCommand::RELOAD) {
+                if (installed_generation_ >= command.generation) continue; // A newer set is already in
+                if (!staged_ready_.load(std::memory_order_acquire)) break;
+                voices_ = std::move(staged_); // Old voices (and their streams) close here
+                duck_gain_ = staged_duck_gain_;
+                installed_generation_ = staged_generation_;
+                staged_ready_.store(false, std::memory_order_release);
+                continue;
+            }
+            if (command.type == AudioCommand::STOP_ALL) {
+                for (Voice& voice : voices_) voice.playing = false;
+                continue;
+            }
+            if (command.alarm >= voices_.size() || !voices_[command.alarm].clip.valid()) continue;
+            Voice& voice = voices_[command.alarm];
+            switch (command.type) {
+            case AudioCommand::PLAY:
+                voice.clip.rewind();
+                voice.position = 0.0;
+                voice.envelope.start(command.from, command.to, ms_to_us(command.ramp_ms), ms_to_us(command.elapsed_ms), now_us);
+                voice.playing = true;
+                voice.decided_us = command.decided_us;
+                if (command.decided_us != 0) voice.started_us = monotonic_now_us();
+                break;
+            case AudioCommand::MUTE:
+            case AudioCommand::UNMUTE:
+                voice.envelope.set_muted(command.type == AudioCommand::MUTE, now_us);
+                if (command.type == AudioCommand::MUTE && command.decided_us != 0 && voice.playing) {
+                    voice.mute_decided_us = command.decided_us;
+                    voice.muted_us = monotonic_now_us();
+                }
+                break;
+            case AudioCommand::STOP:
+                voice.playing = false;
+                break;
+            default:
+                break;
+            }
+        }
+        held_.erase(held_.begin(), held_.begin() + n);
+        applied_.fetch_add(n, std::memory_order_release);
+    }
+
+    // Add one block of the voice, linearly resampled, with its gain moving from
+    // start_gain to end_gain across the block
+    void mix_voice(Voice& voice, float start_gain, float end_gain) {
+        float gain_step = (end_gain - start_gain) / static_cast<float>(kBlockFrames);
+        float gain = start_gain;
+        for (size_t f = 0; f < kBlockFrames; ++f) {
+            gain += gain_step;
+            uint64_t index = static_cast<uint64_t>(voice.position);
+            float fraction = static_cast<float>(voice.position - static_cast<double>(index));
+            float l0, r0, l1, r1;
+            if (!voice.clip.frame(index, l0, r0)) {
+                voice.playing = false;
+                return;
+            }
+            if (!voice.clip.frame(index + 1, l1, r1)) { l1 = l0; r1 = r0; }
+            mix_[f * kChannels] += (l0 + (l1 - l0) * fraction) * gain;
+            mix_[f * kChannels + 1] += (r0 + (r1 - r0) * fraction) * gain;
+            voice.position += voice.step;
+        }
+    }
+
+    std::vector<Voice> voices_;         // Sized by create(), then stream thread only
+    std::vector<Voice> staged_;         // Audio worker until staged_ready_, then stream thread
+    float staged_duck_gain_ = 1.0f;
+    uint32_t staged_generation_ = 0, installed_generation_ = 0;
+    std::atomic<bool> staged_ready_{false};
+    std::vector<AudioCommand> held_;    // Stream thread only
+    std::vector<float> mix_;
+    std::vector<std::int16_t> out_;
+    float duck_gain_ = 1.0f;
+    uint64_t frames_rendered_ = 0;      // Stream thread only: the mixer clock
+    SpscRing<AudioCommand, kQueueCapacity> commands_;
+    SpscRing<AudioLatencySample, 64> latency_;
+    std::atomic<uint64_t> posted_{0}, applied_{0};
+    std::atomic<bool> voices_active_{false};
+    std::atomic<int64_t> idle_since_us_{0};
+};
+
+// Default audio output changes (switching between Link audio and desktop speakers, the
+// Quest reconnecting). The notifications arrive on a system thread, which only raises a
+// flag and wakes the audio worker; the worker then moves the mixer to the new default
+// device with sf::PlaybackDevice::setDevice(), so playing alarms carry on and nothing
+// is re-decoded or reopened. Owned by AudioEngine, so the reference count is nominal.
+class AudioEndpointWatcher : public IMMNotificationClient {
+public:
+    explicit AudioEndpointWatcher(HANDLE wake_event) : wake_event_(wake_event) {}
+
+    // Audio worker, COM initialised
+    bool start() {
+        HRESULT hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL, __uuidof(IMMDeviceEnumerator),
+                                      reinterpret_cast<void**>(&enumerator_));
+        if (FAILED(hr) || !enumerator_) {
+            enumerator_ = nullptr;
+            return false;
+        }
+        if (FAILED(enumerator_->RegisterEndpointNotificationCallback(this))) {
+            enumerator_->Release();
+            enumerator_ = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    void stop() {
+        if (!enumerator_) return;
+        enumerator_->UnregisterEndpointNotificationCallback(this);
+        enumerator_->Release();
+        enumerator_ = nullptr;
+    }
+
+    bool take_change() { return changed_.exchange(false); }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void** object) override {
+        if (iid == __uuidof(IUnknown) || iid == __uuidof(IMMNotificationClient)) {
+            *object = static_cast<IMMNotificationClient*>(this);
+            AddRef();
+            return S_OK;
+        }
+        *object = nullptr;
+        return E_NOINTERFACE;
+    }
+    ULONG STDMETHODCALLTYPE AddRef() override { return ++references_; }
+    ULONG STDMETHODCALLTYPE Release() override { return --references_; }
+
+    HRESULT STDMETHODCALLTYPE OnDefaultDeviceChanged(EDataFlow flow, ERole role, LPCWSTR) override {
+        if (flow == eRender && role == eConsole) notify();
+        return S_OK;
+    }
+    HRESULT STDMETHODCALLTYPE OnDeviceStateChanged(LPCWSTR, DWORD) override {
+        notify(); // The current device may have gone; the worker only acts if the default differs
+        return S_OK;
+    }
+    HRESULT STDMETHODCALLTYPE OnDeviceAdded(LPCWSTR) override { return S_OK; }
+    HRESULT STDMETHODCALLTYPE OnDeviceRemoved(LPCWSTR) override { return S_OK; }
+    HRESULT STDMETHODCALLTYPE OnPropertyValueChanged(LPCWSTR, const PROPERTYKEY) override { return S_OK; }
+
+private:
+    void notify() {
+        changed_.store(true);
+        SetEvent(wake_event_);
+    }
+
+    HANDLE wake_event_;
+    IMMDeviceEnumerator* enumerator_ = nullptr;
+    std::atomic<bool> changed_{false};
+    std::atomic<ULONG> references_{1};
+};
+
+// Owns the alarm mixer and makes the SFML calls that can block (creating, starting and
+// stopping the stream) on its own thread. The tracking thread only queues commands, so
+// a stall in the audio driver can't hold up lookout detection. A full queue drops the
+// command instead of blocking; the next repeat restates the alarm's ramp anyway.
+// Runs only during flights: start() brings the worker and the mixer up (sfml-audio is
+// delay-loaded, so that is also when the DLL and the audio device are first touched),
+// stop() takes them down again; the decoded clips stay in g_audio_cache.
+class AudioEngine {
+public:
+    static constexpr int64_t kIdleStopUs = 2000000; // Stop the stream after 2 s of silence
+
+    AudioEngine(const std::vector<LookoutAlarmConfig>& alarms, const AudioConfig& config)
+        : alarms_(alarms), config_(config), voice_status_(std::make_shared<VoiceStatusTable>(alarms.size())),
+          initial_status_(voice_status_) {}
+    ~AudioEngine() { stop(); }
+    AudioEngine(const AudioEngine&) = delete;
+    AudioEngine& operator=(const AudioEngine&) = delete;
+
+    void start() {
+        if (thread_.joinable()) return;
+        stop_requested_.store(false);
+        wake_event_ = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+        thread_ = std::thread(&AudioEngine::run, this);
+    }
+
+    // Lets the queued commands play out, stops the stream and joins the worker. A reload
+    // the worker hadn't picked up becomes the configuration for the next start().
+    void stop() {
+        if (!thread_.joinable()) return;
+        stop_requested_.store(true);
+        SetEvent(wake_event_);
+        thread_.join();
+        CloseHandle(wake_event_);
+        wake_event_ = nullptr;
+        reload_unposted_ = false;
+        early_.clear(); // Worker gone before the mixer was built
+        if (std::shared_ptr<const ReloadRequest> reload = std::atomic_exchange(&reload_, std::shared_ptr<const ReloadRequest>())) {
+            configure_stopped(reload->alarms, reload->config, reload->unload_clips);
+        }
+        if (dropped_.load() > 0) {
+            std::cerr << "[WARNING] Audio command queue dropped " << dropped_.exchange(0) << " command(s)" << std::endl;
+        }
+    }
+
+    bool running() const { return thread_.joinable(); }
+
+    // True once the worker has built the mixer; commands before that wait for it
+    bool ready() const { return mixer_ready_.load(std::memory_order_acquire); }
+
+    // Restart the alarm's clip from the beginning, ramping from start_volume to end_volume
+    // (0-100) over ramp_ms, of which elapsed_ms have already passed, unmuted. A new
+    // warning passes the monotonic time it was decided, to have its latency measured.
+    void play(size_t alarm, int start_volume, int end_volume, int64_t ramp_ms, int64_t elapsed_ms,
+              int64_t decided_us = 0) {
+        AudioCommand command{ AudioCommand::PLAY, static_cast<uint16_t>(alarm) };
+        command.decided_us = decided_us;
+        command.from = start_volume / 100.0f;
+        command.to = end_volume / 100.0f;
+        command.ramp_ms = static_cast<int32_t>(ramp_ms);
+        command.elapsed_ms = static_cast<int32_t>(elapsed_ms);
+        push(command);
+    }
+    // A mute with `decided_us` comes back from pop_latency() as a mute sample
+    void set_muted(size_t alarm, bool muted, int64_t decided_us = 0) {
+        AudioCommand command{ muted ? AudioCommand::MUTE : AudioCommand::UNMUTE, static_cast<uint16_t>(alarm) };
+        command.decided_us = muted ? decided_us : 0;
+        push(command);
+    }
+    void stop_alarm(size_t alarm) { push(AudioCommand{ AudioCommand::STOP, static_cast<uint16_t>(alarm) }); }
+    void stop_all() { push(AudioCommand{ AudioCommand::STOP_ALL, 0 }); }
+
+    // Settings reload: switch to a new alarm list. Everything playing stops; commands
+    // queued after this call address the new indices and play once the worker has the
+    // new clips ready (files that didn't change keep their decoded buffers). With
+    // `unload_clips` every decoded clip is freed instead, until the next reconfigure().
+    void reconfigure(const std::vector<LookoutAlarmConfig>& alarms, const AudioConfig& config, bool unload_clips = false) {
+        if (!thread_.joinable()) {
+            configure_stopped(alarms, config, unload_clips);
+            return;
+        }
+        stop_all();
+        auto request = std::make_shared<ReloadRequest>();
+        request->alarms = alarms;
+        request->config = config;
+        request->unload_clips = unload_clips;
+        request->generation = ++generation_;
+        request->status = std::make_shared<VoiceStatusTable>(alarms.size());
+        voice_status_ = request->status;
+        std::atomic_store(&reload_, std::shared_ptr<const ReloadRequest>(request));
+        reload_unposted_ = true;
+        post_reload();
+        if (wake_event_) SetEvent(wake_event_);
+    }
+
+    size_t pop_latency(AudioLatencySample* out, size_t max_samples) { return ready() ? mixer_->pop_latency(out, max_samples) : 0; }
+
+    // False once the worker has found the alarm has no playable clip. Until the mixer
+    // is created this answers true, so a first warning is still queued.
+    bool has_audio(size_t alarm) const {
+        return alarm < voice_status_->size() && (*voice_status_)[alarm].load(std::memory_order_relaxed) != VOICE_NONE;
+    }
+
+private:
+    enum VoiceStatus : uint8_t { VOICE_UNKNOWN = 0, VOICE_READY, VOICE_NONE };
+    using VoiceStatusTable = std::vector<std::atomic<uint8_t>>;
+
+    struct ReloadRequest {
+        std::vector<LookoutAlarmConfig> alarms;
+        AudioConfig config;
+        uint32_t generation = 0;
+        bool unload_clips = false;
+        std::shared_ptr<VoiceStatusTable> status; // Filled in by the worker
+    };
+
+    static void store_status(VoiceStatusTable& table, const std::vector<bool>& ready) {
+        for (size_t i = 0; i < table.size() && i < ready.size(); ++i) {
+            table[i].store(ready[i] ? VOICE_READY : VOICE_NONE, std::memory_order_relaxed);
+        }
+    }
+
+    // Worker stopped, so nothing else touches g_audio_cache: the next start() builds the
+    // mixer from these, decoding whatever the cache doesn't hold
+    void configure_stopped(const std::vector<LookoutAlarmConfig>& alarms, const AudioConfig& config, bool unload_clips) {
+        alarms_ = alarms;
+        config_ = config;
+        voice_status_ = initial_status_ = std::make_shared<VoiceStatusTable>(alarms.size());
+        if (unload_clips) {
+            wait_for_audio_warmup();
+            g_audio_cache.unload_all();
+            g_audio_cache.release_retired();
+            std::cout << "[INFO] Alarm audio unloaded until the next flight" << std::endl;
+        }
+    }
+
+    // Nothing may overtake the RELOAD, or it would play on the old alarm indices; if the
+    // queue is full it's retried ahead of the next command
+    void post_reload() {
+        if (!ready()) return;
+        AudioCommand reload{ AudioCommand::RELOAD, 0 };
+        reload.generation = generation_;
+        if (mixer_->post(reload)) reload_unposted_ = false;
+    }
+
+    void push(const AudioCommand& command) {
+        TraceLoggingWrite(g_trace_provider, "AudioCommand", TraceLoggingUInt8(command.type, "Type"),
+                          TraceLoggingUInt16(command.alarm, "Alarm"));
+        if (!ready()) {
+            // The worker posts these once the mixer exists; checked again under the lock
+            // so none is left behind when it turns ready meanwhile
+            std::lock_guard<std::mutex> lock(early_mutex_);
+            if (!ready()) {
+                if (!thread_.joinable()) return;
+                if (command.type == AudioCommand::STOP_ALL) early_.clear();
+                if (early_.size() < kMaxEarly) early_.push_back(command);
+                else dropped_.fetch_add(1);
+                SetEvent(wake_event_); // Stays set, so the worker's first wait plays them
+                return;
+            }
+        }
+        if (reload_unposted_) post_reload();
+        if (reload_unposted_ || !mixer_->post(command)) {
+            if (dropped_.fetch_add(1) == 0) {
+                std::cerr << "[WARNING] Audio command queue full; dropping commands until the audio mixer catches up" << std::endl;
+            }
+            return;
+        }
+        SetEvent(wake_event_);
+    }
+
+    // Move the mixer onto the current default output device, if it isn't there already
+    void follow_default_device() {
+        std::optional<std::string> target = sf::PlaybackDevice::getDefaultDevice();
+        if (!target || target == sf::PlaybackDevice::getDevice()) return;
+        if (sf::PlaybackDevice::setDevice(*target)) {
+            std::cout << "[INFO] Alarm audio moved to the default output device: " << *target << std::endl;
+        } else {
+            std::cerr << "[WARNING] Could not switch alarm audio to output device: " << *target << std::endl;
+        }
+    }
+
+    void run() {
+        ThreadCpuScope cpu_scope(CPU_AUDIO);
+        HRESULT com = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        AudioEndpointWatcher endpoints(wake_event_);
+        if (!endpoints.start()) {
+            std::cerr << "[WARNING] Audio device change notifications unavailable; alarms stay on the startup device" << std::endl;
+        }
+
+        wait_for_audio_warmup();
+        g_audio_cache.forget_changed(); // Files edited since the last flight
+        g_audio_cache.release_retired();
+        g_audio_cache.preload(alarms_, config_);
+        mixer_.emplace();
+        store_status(*initial_status_, mixer_->create(alarms_, config_));
+        {
+            // Commands queued while the mixer was built. After a reload they address alarm
+            // indices this mixer doesn't have yet (the reload stops everything anyway).
+            std::lock_guard<std::mutex> lock(early_mutex_);
+            if (!std::atomic_load(&reload_)) {
+                for (const AudioCommand& command : early_) {
+                    if (!mixer_->post(command)) dropped_.fetch_add(1);
+                }
+            }
+            early_.clear();
+            mixer_ready_.store(true, std::memory_order_release);
+        }
+
+        bool playing = false;
+        while (true) {
+            WaitForSingleObject(wake_event_, playing ? 500 : INFINITE);
+            bool stopping = stop_requested_.load();
+            try {
+                if (endpoints.take_change()) follow_default_device();
+                // A reload waiting for the stream to install the last staged set retries
+                // on the next wake-up
+                if (!mixer_->staged_pending()) {
+                    g_audio_cache.release_retired(); // The stream has installed the last staged set
+                    if (std::shared_ptr<const ReloadRequest> reload = std::atomic_exchange(&reload_, std::shared_ptr<const ReloadRequest>())) {
+                        if (reload->unload_clips) {
+                            // Status stays unknown, so a warning is still queued if one comes
+                            g_audio_cache.unload_all();
+                            mixer_->stage(reload->alarms, reload->config, reload->generation, false);
+                            std::cout << "[INFO] Alarm audio unloaded until the next flight" << std::endl;
+                        } else {
+                            g_audio_cache.forget_changed();
+                            g_audio_cache.preload(reload->alarms, reload->config);
+                            store_status(*reload->status, mixer_->stage(reload->alarms, reload->config, reload->generation));
+                        }
+                    }
+                }
+                int64_t idle_since_us = 0;
+                if (!playing && mixer_->has_pending()) {
+                    mixer_->play();
+                    playing = true;
+                } else if (playing && mixer_->idle_since(idle_since_us) &&
+                           (stopping || monotonic_now_us() - idle_since_us >= kIdleStopUs)) {
+                    mixer_->stop();
+                    playing = false;
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "[ERROR] Exception in audio: " << e.what() << std::endl;
+            }
+            if (stopping && (!playing || !mixer_->has_pending())) break;
+        }
+        mixer_->stop();
+        mixer_ready_.store(false, std::memory_order_release);
+        mixer_.reset();
+        g_audio_cache.release_retired(); // No voice left to play them
+        endpoints.stop();
+        if (SUCCEEDED(com)) CoUninitialize();
+    }
+
+    std::vector<LookoutAlarmConfig> alarms_; // As at start(); reloads while running arrive through reload_
+    AudioConfig config_;
+    std::shared_ptr<VoiceStatusTable> voice_status_;   // Tracking thread; replaced on reload
+    std::shared_ptr<VoiceStatusTable> initial_status_; // Filled by the worker at start()
+    std::shared_ptr<const ReloadRequest> reload_;      // Only through std::atomic_store/exchange
+    uint32_t generation_ = 0;                          // Tracking thread only
+    bool reload_unposted_ = false;                     // Tracking thread only
+    std::optional<AlarmMixer> mixer_;                  // Built and destroyed by the worker
+    std::atomic<bool> mixer_ready_{false};
+    static constexpr size_t kMaxEarly = 64;
+    std::mutex early_mutex_;
+    std::vector<AudioCommand> early_; // Pushed before mixer_ready_, under early_mutex_
+    std::atomic<bool> stop_requested_{false};
+    std::atomic<uint64_t> dropped_{0};
+    HANDLE wake_event_ = nullptr;
+    std::thread thread_;
+};
+
+// Per-alarm latency of new warnings, to tell a late alarm caused by the engine from one
+// caused by the audio path: engine (the alarm's deadline to the tick that decided it),
+// mixer (decision to the mixer starting the clip, including starting the stream) and
+// output (decision to the first block with the clip handed to the audio device;
+// buffering inside the device isn't visible from here). Histograms cover the flight
+// and are printed with the [TIMING] summaries and once more when the flight ends.
+class AlarmLatencyStats {
+public:
+    explicit AlarmLatencyStats(size_t alarm_count) : alarms_(alarm_count) {}
+
+    void record_engine(size_t alarm, int64_t lag_us) {
+        if (alarm < alarms_.size()) alarms_[alarm].engine.record(lag_us);
+    }
+
+    void collect(AudioEngine& audio) {
+        std::array<AudioLatencySample, 64> samples;
+        size_t count = audio.pop_latency(samples.data(), samples.size());
+        for (size_t n = 0; n < count; ++n) {
+            const AudioLatencySample& sample = samples[n];
+            if (sample.alarm >= alarms_.size() || sample.mute) continue;
+            alarms_[sample.alarm].mixer.record(sample.mixer_us);
+            alarms_[sample.alarm].output.record(sample.output_us);
+            fresh_ = true;
+            LOOKOUT_STREAM(LEVEL_DEBUG, "[DEBUG] Alarm " << sample.alarm << ": Warning audible " << format_ms(sample.output_us)
+                                        << " after the decision (mixer start " << format_ms(sample.mixer_us) << ")");
+        }
+    }
+
+    // With the periodic [TIMING] summaries, when there's something new
+    void report_if_due(int64_t now_us, double interval_s) {
+        if (last_report_us_ < 0) last_report_us_ = now_us;
+        if (now_us - last_report_us_ < static_cast<int64_t>(interval_s * 1e6)) return;
+        last_report_us_ = now_us;
+        if (fresh_) print("Alarm latency");
+        fresh_ = false;
+    }
+
+    // Settings reload: alarm indices mean something else from here on
+    void resize(size_t alarm_count) { alarms_.resize(alarm_count); }
+
+    // Flight summary when a flight was on, then start over for the next one
+    void end_flight(bool flight_active = true) {
+        if (flight_active) print("Flight alarm latency");
+        for (auto& stats : alarms_) {
+            stats.engine.reset();
+            stats.mixer.reset();
+            stats.output.reset();
+        }
+        fresh_ = false;
+    }
+
+private:
+    struct PerAlarm {
+        LatencyHistogram engine, mixer, output;
+    };
+
+    static std::string format_ms(int64_t us) {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(1) << us / 1000.0 << "ms";
+        return out.str();
+    }
+
+    static std::string summary(const LatencyHistogram& h) {
+        return format_ms(h.percentile(0.5)) + "/" + format_ms(h.percentile(0.99)) + "/" + format_ms(h.max_us());
+    }
+
+    void print(const char* heading) const {
+        if (!log_level_enabled(LEVEL_INFO)) return;
+        for (size_t i = 0; i < alarms_.size(); ++i) {
+            const PerAlarm& a = alarms_[i];
+            if (a.engine.count() == 0 && a.output.count() == 0) continue;
+            std::cout << "[TIMING] " << heading << " (alarm " << i << ", " << a.engine.count()
+                      << " warning(s)) p50/p99/max: engine " << summary(a.engine) << " | mixer " << summary(a.mixer)
+                      << " | output " << summary(a.output) << std::endl;
+        }
+    }
+
+    std::vector<PerAlarm> alarms_;
+    int64_t last_report_us_ = -1;
+    bool fresh_ = false;
+};
+
+// Alarm audio measured outside a flight (--perf-selftest, lookout_bench): the warm-up's
+// decode and test of every clip, then `triggers` warnings of the first alarm played at
+// volume 0, 100 ms apart, with their latency read back from the mixer as the core does
+// for a real warning. The first trigger also starts the stream and is kept apart.
+struct AudioTriggerLatency {
+    int64_t warmup_us = 0;
+    int64_t cold_mixer_us = -1, cold_output_us = -1; // -1: no clip reached the mixer
+    LatencyHistogram mixer, output;                   // The rest, with the stream running
+};
+
+AudioTriggerLatency measure_audio_triggers(const std::vector<LookoutAlarmConfig>& alarms, const AudioConfig& config,
+                                           int triggers) {
+    AudioTriggerLatency result;
+    if (alarms.empty()) return result;
+    const int64_t warmup_start_us = monotonic_now_us();
+    start_audio_warmup(alarms, config);
+    wait_for_audio_warmup();
+    result.warmup_us = monotonic_now_us() - warmup_start_us;
+    AudioEngine audio(alarms, config);
+    audio.start();
+    while (!audio.ready()) Sleep(1);
+    for (int i = 0; i < triggers; ++i) {
+        audio.play(0, 0, 0, 0, 0, monotonic_now_us());
+        AudioLatencySample sample;
+        const int64_t deadline_us = monotonic_now_us() + 2000000;
+        bool received = false;
+        while (!(received = audio.pop_latency(&sample, 1) == 1) && monotonic_now_us() < deadline_us) Sleep(1);
+        if (!received) break; // No playable clip
+        if (result.cold_mixer_us < 0) {
+            result.cold_mixer_us = sample.mixer_us;
+            result.cold_output_us = sample.output_us;
+        } else {
+            result.mixer.record(sample.mixer_us);
+            result.output.record(sample.output_us);
+        }
+        audio.stop_alarm(0);
+        Sleep(100);
+    }
+    audio.stop();
+    return result;
+}
+
+// Streaming mean, spread and extremes (Welford's method): O(1) per value, no history
+class RunningStats {
+public:
+    void add(double x) {
+        ++count_;
+        double delta = x - mean_;
+        mean_ += delta / count_;
+        m2_ += delta * (x - mean_);
+        min_ = count_ == 1 ? x : (std::min)(min_, x);
+        max_ = count_ == 1 ? x : (std::max)(max_, x);
+    }
+    uint64_t count() const { return count_; }
+    double mean() const { return mean_; }
+    double stddev() const { return count_ > 1 ? std::sqrt(m2_ / (count_ - 1)) : 0.0; }
+    double min() const { return min_; }
+    double max() const { return max_; }
+    void reset() { *this = RunningStats(); }
+
+private:
+    uint64_t count_ = 0;
+    double mean_ = 0.0, m2_ = 0.0, min_ = 0.0, max_ = 0.0;
+};
+
+// Per-alarm scan statistics for one flight, on engine time (so pauses don't count):
+// time between lookouts, time from a warning to the lookout that ended it, and
+// warnings per hour. Fed from the engine's events and summarized when the flight ends.
+class FlightScanStats {
+public:
+    explicit FlightScanStats(size_t alarm_count) : alarms_(alarm_count) {}
+
+    // Alarms start a fresh no-look period: the next interval is measured from here
+    void restart(int64_t engine_us) {
+        for (PerAlarm& a : alarms_) {
+            a.last_lookout_us = engine_us;
+            a.warning_since_us = -1;
+        }
+    }
+
+    void begin_flight(int64_t engine_us) {
+        for (PerAlarm& a : alarms_) a = PerAlarm();
+        flight_start_us_ = engine_us;
+        restart(engine_us);
+    }
+
+    void on_warning(size_t alarm, int64_t engine_us) {
+        if (alarm >= alarms_.size()) return;
+        ++alarms_[alarm].warnings;
+        alarms_[alarm].warning_since_us = engine_us;
+    }
+
+    void on_lookout(size_t alarm, int64_t engine_us) {
+        if (alarm >= alarms_.size()) return;
+        PerAlarm& a = alarms_[alarm];
+        if (a.last_lookout_us >= 0) a.interval_s.add((engine_us - a.last_lookout_us) / 1e6);
+        if (a.warning_since_us >= 0) a.response_s.add((engine_us - a.warning_since_us) / 1e6);
+        a.last_lookout_us = engine_us;
+        a.warning_since_us = -1;
+    }
+
+    // Settings reload: alarm indices mean something else from here on
+    void resize(size_t alarm_count, int64_t engine_us) {
+        alarms_.resize(alarm_count);
+        restart(engine_us);
+    }
+
+    // Flight summary, then start over for the next flight
+    void end_flight(int64_t engine_us) {
+        double hours = (engine_us - flight_start_us_) / 3.6e9;
+        for (size_t i = 0; i < alarms_.size(); ++i) {
+            const PerAlarm& a = alarms_[i];
+            if (a.interval_s.count() == 0 && a.warnings == 0) continue;
+            std::cout << std::fixed << std::setprecision(1) << "[INFO] Flight scan stats (alarm " << i << "): "
+                      << a.interval_s.count() << " lookout(s), interval mean/sd/max " << a.interval_s.mean() << "/"
+                      << a.interval_s.stddev() << "/" << a.interval_s.max() << " s | " << a.warnings << " warning(s)";
+            if (hours > 0.0) std::cout << " (" << a.warnings / hours << "/h)";
+            if (a.response_s.count() > 0) {
+                std::cout << ", response mean/sd/max " << a.response_s.mean() << "/" << a.response_s.stddev()
+                          << "/" << a.response_s.max() << " s";
+            }
+            std::cout << std::endl;
+        }
+        begin_flight(engine_us);
+    }
+
+private:
+    struct PerAlarm {
+        RunningStats interval_s, response_s;
+        uint64_t warnings = 0;
+        int64_t last_lookout_us = -1, warning_since_us = -1;
+    };
+
+    std::vector<PerAlarm> alarms_;
+    int64_t flight_start_us_ = 0;
+};
+
+// One timestamped head pose handed from the sampler thread to the alarm evaluator
+struct PoseSample {
+    int64_t t_us = 0;               // Capture time on the core clock
+    LookVector look;                // Relative to the reference transform
+    LeanOffset lean;                // Head position relative to the recenter position
+    double angular_speed_deg_s = 0.0;
+    double yaw_rate_deg_s = 0.0;    // Positive turning left
+    double pitch_rate_deg_s = 0.0;  // Positive tilting up
+    uint32_t flags = 0;
+};
+
+// Flying, as told by the head alone: a mounted headset that keeps moving a little, as a
+// pilot's head does in the cockpit, rather than lying still on a desk or being turned
+// over in the hands. Fed the samples the sampler takes anyway and summarized in 10 s
+// windows: a window qualifies when the headset was ready nearly all of it and the mean
+// angular speed was in range. Flying starts after a run of qualifying windows reaching
+// activity_s and stops after 30 s of windows that don't, so a still moment in a thermal
+// doesn't end it. No allocation, no OS queries.
+class FlightActivityDetector {
+public:
+    explicit FlightActivityDetector(const FlightInferenceConfig& config) : config_(config) {}
+
+    void add(const PoseSample& sample) {
+        if (window_start_us_ < 0) window_start_us_ = last_us_ = sample.t_us;
+        const int64_t dt_us = (std::max<int64_t>)(0, (std::min<int64_t>)(sample.t_us - last_us_, kMaxGapUs));
+        last_us_ = sample.t_us;
+        if (sample.flags & POSE_HMD_OK) {
+            ready_us_ += dt_us;
+            speed_time_ += sample.angular_speed_deg_s * dt_us;
+        }
+        if (sample.t_us - window_start_us_ >= kWindowUs) close_window(sample.t_us);
+    }
+
+    bool flying() const { return flying_; }
+
+    void reset() {
+        window_start_us_ = last_us_ = -1;
+        ready_us_ = streak_us_ = idle_us_ = 0;
+        speed_time_ = 0.0;
+        flying_ = false;
+    }
+
+private:
+    static constexpr int64_t kWindowUs = 10000000;
+    static constexpr int64_t kStopUs = 30000000;
+    static constexpr int64_t kMaxGapUs = 1000000; // Longer gaps (a paused sampler) count as this
+
+    void close_window(int64_t now_us) {
+        const int64_t span_us = now_us - window_start_us_;
+        const double mean_speed = ready_us_ > 0 ? speed_time_ / ready_us_ : 0.0;
+        const bool active = ready_us_ * 10 >= span_us * 9 && mean_speed >= config_.min_speed_deg_s &&
+                            mean_speed <= config_.max_speed_deg_s;
+        if (active) {
+            streak_us_ += span_us;
+            idle_us_ = 0;
+            if (streak_us_ >= seconds_to_us(config_.activity_s)) flying_ = true;
+        } else {
+            streak_us_ = 0;
+            idle_us_ += span_us;
+            if (idle_us_ >= kStopUs) flying_ = false;
+        }
+        window_start_us_ = now_us;
+        ready_us_ = 0;
+        speed_time_ = 0.0;
+    }
+
+    const FlightInferenceConfig config_;
+    int64_t window_start_us_ = -1, last_us_ = -1;
+    int64_t ready_us_ = 0, streak_us_ = 0, idle_us_ = 0;
+    double speed_time_ = 0.0; // deg/s x us while ready
+    bool flying_ = false;
+};
+
+// Rolling head-motion history: a ring of compact samples sized once at startup, saved
+// as a pose replay CSV (so it can be fed back through pose_source "replay") from the
+// tray menu or when a warning starts. Recording is a store into the ring and never
+// allocates. A save copies the ring into a second preallocated buffer and a writer
+// thread writes it out, so the core never waits on the disk.
+class PoseHistory {
+public:
+    explicit PoseHistory(const PoseHistoryConfig& config)
+        : config_(config), period_us_(static_cast<int64_t>(1e6 / config.rate_hz)) {
+        if (!config_.enabled) return;
+        size_t capacity = static_cast<size_t>(config_.seconds * config_.rate_hz);
+        ring_.resize(capacity);
+        snapshot_.resize(capacity);
+        std::cout << "[INFO] Head motion history: last " << config_.seconds << " s at up to " << config_.rate_hz
+                  << " Hz (" << capacity * sizeof(Compact) * 2 / 1024 << " KiB)" << std::endl;
+    }
+    ~PoseHistory() { stop(); }
+    PoseHistory(const PoseHistory&) = delete;
+    PoseHistory& operator=(const PoseHistory&) = delete;
+
+    void start() {
+        if (!config_.enabled) return;
+        wake_event_ = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+        thread_ = std::thread(&PoseHistory::write_loop, this);
+    }
+
+    void stop() {
+        if (!thread_.joinable()) return;
+        stop_requested_ = true;
+        SetEvent(wake_event_);
+        thread_.join();
+        CloseHandle(wake_event_);
+        wake_event_ = nullptr;
+    }
+
+    const PoseHistoryConfig& config() const { return config_; }
+
+    // Core thread, for every sample: kept when at least 1/rate_hz after the last one
+    void record(const PoseSample& sample) {
+        if (ring_.empty() || sample.t_us < next_record_us_) return;
+        next_record_us_ = sample.t_us + period_us_;
+        double yaw_deg = 0.0, pitch_deg = 0.0;
+        look_vector_to_yaw_pitch(sample.look, yaw_deg, pitch_deg);
+        Compact& c = ring_[(head_ + size_) % ring_.size()];
+        if (size_ < ring_.size()) ++size_; else head_ = (head_ + 1) % ring_.size();
+        c.t_us = sample.t_us;
+        c.yaw_cdeg = to_int16(yaw_deg * 100.0);
+        c.pitch_cdeg = to_int16(pitch_deg * 100.0);
+        c.yaw_rate_ddeg_s = to_int16(sample.yaw_rate_deg_s * 10.0);
+        c.pitch_rate_ddeg_s = to_int16(sample.pitch_rate_deg_s * 10.0);
+        c.lean_lateral_mm = to_int16(sample.lean.lateral_m * 1000.0);
+        c.lean_vertical_mm = to_int16(sample.lean.vertical_m * 1000.0);
+        c.flags = static_cast<uint16_t>((sample.flags & 0x7FFF) | (sample.lean.valid ? kLeanValid : 0));
+    }
+
+    // Core thread: hand the history so far to the writer. False when it's disabled,
+    // empty, or the previous save is still being written.
+    bool dump(const std::string& reason) {
+        if (ring_.empty() || size_ == 0 || writing_.load()) return false;
+        for (size_t n = 0; n < size_; ++n) snapshot_[n] = ring_[(head_ + n) % ring_.size()];
+        snapshot_size_ = size_;
+        snapshot_reason_ = reason;
+        writing_ = true;
+        SetEvent(wake_event_);
+        return true;
+    }
+
+private:
+    // PoseSample fields at the precision the replay reader needs: centidegrees,
+    // decidegrees/s and millimeters, plus the sample flags
+    struct Compact {
+        int64_t t_us = 0;
+        int16_t yaw_cdeg = 0, pitch_cdeg = 0;
+        int16_t yaw_rate_ddeg_s = 0, pitch_rate_ddeg_s = 0;
+        int16_t lean_lateral_mm = 0, lean_vertical_mm = 0;
+        uint16_t flags = 0;
+    };
+    static constexpr uint16_t kLeanValid = 0x8000;
+
+    static int16_t to_int16(double v) {
+        return static_cast<int16_t>(std::lround((std::max)(-32767.0, (std::min)(32767.0, v))));
+    }
+
+    void write_loop() {
+        place_background_thread();
+        ThreadCpuScope cpu_scope(CPU_RECORDING);
+        while (true) {
+            WaitForSingleObject(wake_event_, INFINITE);
+            if (stop_requested_.load()) break;
+            if (writing_.load()) {
+                write_snapshot();
+                writing_ = false;
+            }
+        }
+    }
+
+    void write_snapshot() {
+        CreateDirectoryA(config_.directory.c_str(), nullptr); // Fails harmlessly when it exists
+        std::time_t now = std::time(nullptr);
+        std::tm local = {};
+        localtime_s(&local, &now);
+        char stamp[32];
+        std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", &local);
+        std::string path = config_.directory + "\\pose_history_" + stamp + "_" + snapshot_reason_ + ".csv";
+        std::ofstream out(path);
+        if (!out) {
+            std::cerr << "[WARNING] Could not write head motion history to " << path << std::endl;
+            return;
+        }
+        out << "t_us,yaw_deg,pitch_deg,yaw_rate_deg_s,pitch_rate_deg_s,lean_lateral_cm,lean_vertical_cm,flags\n";
+        out << std::fixed;
+        for (size_t n = 0; n < snapshot_size_; ++n) {
+            const Compact& c = snapshot_[n];
+            out << c.t_us << std::setprecision(2) << ',' << c.yaw_cdeg / 100.0 << ',' << c.pitch_cdeg / 100.0
+                << std::setprecision(1) << ',' << c.yaw_rate_ddeg_s / 10.0 << ',' << c.pitch_rate_ddeg_s / 10.0 << ',';
+            if (c.flags & kLeanValid) out << c.lean_lateral_mm / 10.0 << ',' << c.lean_vertical_mm / 10.0;
+            else out << ',';
+            out << ',' << (c.flags & ~kLeanValid) << '\n';
+        }
+        std::cout << "[INFO] Saved " << snapshot_size_ << " head motion samples ("
+                  << (snapshot_[snapshot_size_ - 1].t_us - snapshot_[0].t_us) / 1e6 << " s) to " << path << std::endl;
+        out.close();
+        trim_directory(config_.directory, "pose_history_*.csv", static_cast<uint64_t>(config_.budget_mb) * 1024 * 1024);
+    }
+
+    const PoseHistoryConfig config_;
+    const int64_t period_us_;
+    std::vector<Compact> ring_;                 // Core thread only
+    size_t head_ = 0, size_ = 0;
+    int64_t next_record_us_ = INT64_MIN;
+    std::vector<Compact> snapshot_;             // Writer thread while writing_ is set
+    size_t snapshot_size_ = 0;
+    std::string snapshot_reason_;
+    std::atomic<bool> writing_{false};
+    std::atomic<bool> stop_requested_{false};
+    HANDLE wake_event_ = nullptr;
+    std::thread thread_;
+};
+
+// Scan heatmap: dwell time per yaw x pitch bin over a flight, in a grid sized once at
+// startup, so a long flight costs no more memory than a short one and each sample is a
+// single add. Saved at the flight end and on the "dump_heatmap" command; as with
+// PoseHistory, a save copies the grid and a writer thread writes the files. A flight
+// ending while the writer is busy is held until poll() finds it free. Saves past
+// budget_mb are deleted, oldest first.
+class ScanHeatmap {
+public:
+    explicit ScanHeatmap(const ScanHeatmapConfig& config)
+        : config_(config), yaw_bins_(static_cast<int>(std::lround(360.0 / config.bin_deg))),
+          pitch_bins_(static_cast<int>(std::lround(180.0 / config.bin_deg))),
+          yaw_bin_deg_(360.0 / yaw_bins_), pitch_bin_deg_(180.0 / pitch_bins_) {
+        if (!config_.enabled) return;
+        dwell_us_.assign(static_cast<size_t>(yaw_bins_) * pitch_bins_, 0);
+        snapshot_.assign(dwell_us_.size(), 0);
+        std::cout << "[INFO] Scan heatmap: " << yaw_bins_ << " x " << pitch_bins_ << " bins of " << config_.bin_deg
+                  << " deg (" << dwell_us_.size() * sizeof(uint64_t) * 2 / 1024 << " KiB)" << std::endl;
+    }
+    ~ScanHeatmap() { stop(); }
+    ScanHeatmap(const ScanHeatmap&) = delete;
+    ScanHeatmap& operator=(const ScanHeatmap&) = delete;
+
+    void start() {
+        if (!config_.enabled) return;
+        wake_event_ = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+        thread_ = std::thread(&ScanHeatmap::write_loop, this);
+    }
+
+    // Finishes a save in progress, and one held for it, first
+    void stop() {
+        if (!thread_.joinable()) return;
+        while (held_ && writing_.load()) Sleep(1);
+        poll();
+        stop_requested_ = true;
+        SetEvent(wake_event_);
+        thread_.join();
+        CloseHandle(wake_event_);
+        wake_event_ = nullptr;
+    }
+
+    bool enabled() const { return !dwell_us_.empty(); }
+
+    // Core thread, for every evaluated sample: the time since the previous one is
+    // credited to where the head points now. Gaps over a second count as one second.
+    void add(const LookVector& look, int64_t dt_us) {
+        if (dwell_us_.empty() || dt_us <= 0) return;
+        double yaw_deg = 0.0, pitch_deg = 0.0;
+        look_vector_to_yaw_pitch(look, yaw_deg, pitch_deg);
+        // Column 0 is the far left (yaw is positive to the left), row 0 straight up
+        const int x = (std::max)(0, (std::min)(yaw_bins_ - 1, static_cast<int>((180.0 - yaw_deg) / yaw_bin_deg_)));
+        const int y = (std::max)(0, (std::min)(pitch_bins_ - 1, static_cast<int>((90.0 - pitch_deg) / pitch_bin_deg_)));
+        const int64_t step_us = (std::min<int64_t>)(dt_us, kMaxStepUs);
+        dwell_us_[static_cast<size_t>(y) * yaw_bins_ + x] += step_us;
+        total_us_ += step_us;
+    }
+
+    void clear() {
+        std::fill(dwell_us_.begin(), dwell_us_.end(), 0);
+        total_us_ = 0;
+    }
+
+    // Core thread: hand the grid so far to the writer. False when it's disabled, empty,
+    // or the previous save is still being written; with `hold`, a busy writer gets it
+    // later from poll() instead (one held at a time).
+    bool dump(const std::string& reason, bool hold = false) {
+        if (dwell_us_.empty() || total_us_ == 0) return false;
+        if (writing_.load()) {
+            if (!hold) return false;
+            if (held_) {
+                std::cerr << "[WARNING] Scan heatmap writer still busy; this " << reason << " heatmap wasn't saved" << std::endl;
+                return false;
+            }
+            held_dwell_us_ = dwell_us_;
+            held_total_us_ = total_us_;
+            held_reason_ = reason;
+            held_ = true;
+            return true;
+        }
+        hand_over(dwell_us_, total_us_, reason);
+        return true;
+    }
+
+    // Core loop: starts a held save once the writer is free
+    void poll() {
+        if (!held_ || writing_.load()) return;
+        held_ = false;
+        hand_over(held_dwell_us_, held_total_us_, held_reason_);
+    }
+
+private:
+    static constexpr int64_t kMaxStepUs = 1000000;
+
+    void hand_over(const std::vector<uint64_t>& dwell_us, uint64_t total_us, const std::string& reason) {
+        snapshot_ = dwell_us; // Same size: no allocation
+        snapshot_total_us_ = total_us;
+        snapshot_reason_ = reason;
+        writing_ = true;
+        SetEvent(wake_event_);
+    }
+
+    void write_loop() {
+        place_background_thread();
+        ThreadCpuScope cpu_scope(CPU_RECORDING);
+        while (true) {
+            WaitForSingleObject(wake_event_, INFINITE);
+            if (writing_.load()) {
+                write_snapshot();
+                writing_ = false;
+            }
+            if (stop_requested_.load()) break;
+        }
+    }
+
+    void write_snapshot() {
+        CreateDirectoryA(config_.directory.c_str(), nullptr); // Fails harmlessly when it exists
+        std::time_t now = std::time(nullptr);
+        std::tm local = {};
+        localtime_s(&local, &now);
+        char stamp[32];
+        std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", &local);
+        const std::string base = config_.directory + "\\scan_heatmap_" + stamp + "_" + snapshot_reason_;
+        if (config_.csv) write_csv(base + ".csv");
+        if (config_.image) write_image(base + ".bmp");
+        std::cout << "[INFO] Saved a scan heatmap of " << std::fixed << std::setprecision(1) << snapshot_total_us_ / 6e7
+                  << " min to " << base << (config_.csv && config_.image ? ".csv/.bmp" : config_.csv ? ".csv" : ".bmp") << std::endl;
+        trim_directory(config_.directory, "scan_heatmap_*", static_cast<uint64_t>(config_.budget_mb) * 1024 * 1024);
+    }
+
+    // Header row of yaw bin centers (positive left), then a row per pitch bin from straight up
+    void write_csv(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out) {
+            std::cerr << "[WARNING] Could not write scan heatmap to " << path << std::endl;
+            return;
+        }
+        out << std::fixed << std::setprecision(1) << "pitch_deg";
+        for (int x = 0; x < yaw_bins_; ++x) out << ',' << 180.0 - (x + 0.5) * yaw_bin_deg_;
+        out << '\n';
+        for (int y = 0; y < pitch_bins_; ++y) {
+            out << std::setprecision(1) << 90.0 - (y + 0.5) * pitch_bin_deg_ << std::setprecision(3);
+            for (int x = 0; x < yaw_bins_; ++x) out << ',' << snapshot_[static_cast<size_t>(y) * yaw_bins_ + x] / 1e6;
+            out << '\n';
+        }
+    }
+
+    // 24-bit BMP, each bin a square of pixels about 720 wide in all; brightness follows
+    // the square root of the dwell, so short glances still show next to the forward view.
+    // Empty bins on the forward axes are grey.
+    void write_image(const std::string& path) const {
+        const int scale = (std::max)(1, 720 / yaw_bins_);
+        const int width = yaw_bins_ * scale, height = pitch_bins_ * scale;
+        const int stride = (width * 3 + 3) & ~3;
+        std::vector<uint8_t> pixels(static_cast<size_t>(stride) * height, 0);
+        const double peak_us = static_cast<double>(*std::max_element(snapshot_.begin(), snapshot_.end()));
+        for (int py = 0; py < height; ++py) {
+            uint8_t* row = &pixels[static_cast<size_t>(height - 1 - py) * stride]; // Bottom-up rows
+            for (int px = 0; px < width; ++px) {
+                const uint64_t dwell = snapshot_[static_cast<size_t>(py / scale) * yaw_bins_ + px / scale];
+                uint8_t* bgr = row + px * 3;
+                if (dwell > 0) {
+                    heat_color(std::sqrt(dwell / peak_us), bgr);
+                } else if (px == width / 2 || py == height / 2) {
+                    bgr[0] = bgr[1] = bgr[2] = 64;
+                }
+            }
+        }
+        BITMAPINFOHEADER info = {};
+        info.biSize = sizeof(info);
+        info.biWidth = width;
+        info.biHeight = height;
+        info.biPlanes = 1;
+        info.biBitCount = 24;
+        info.biCompression = BI_RGB;
+        info.biSizeImage = static_cast<DWORD>(pixels.size());
+        BITMAPFILEHEADER file = {};
+        file.bfType = 0x4D42; // "BM"
+        file.bfOffBits = sizeof(file) + sizeof(info);
+        file.bfSize = static_cast<DWORD>(file.bfOffBits + pixels.size());
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(&file), sizeof(file));
+        out.write(reinterpret_cast<const char*>(&info), sizeof(info));
+        out.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+        if (!out) std::cerr << "[WARNING] Could not write scan heatmap to " << path << std::endl;
+    }
+
+    // Black through blue, red and yellow to white as t goes from 0 to 1
+    static void heat_color(double t, uint8_t* bgr) {
+        static const uint8_t stops[5][3] = { {0, 0, 0}, {0, 0, 160}, {200, 0, 0}, {255, 210, 0}, {255, 255, 255} }; // RGB
+        const double s = (std::max)(0.0, (std::min)(1.0, t)) * 4.0;
+        const int k = (std::min)(3, static_cast<int>(s));
+        const double f = s - k;
+        for (int c = 0; c < 3; ++c) {
+            bgr[2 - c] = static_cast<uint8_t>(std::lround(stops[k][c] + (stops[k + 1][c] - stops[k][c]) * f));
+        }
+    }
+
+    const ScanHeatmapConfig config_;
+    const int yaw_bins_, pitch_bins_;
+    const double yaw_bin_deg_, pitch_bin_deg_;
+    std::vector<uint64_t> dwell_us_;            // Core thread only
+    uint64_t total_us_ = 0;
+    std::vector<uint64_t> snapshot_;            // Writer thread while writing_ is set
+    uint64_t snapshot_total_us_ = 0;
+    std::string snapshot_reason_;
+    std::vector<uint64_t> held_dwell_us_;       // Core thread: a save waiting for the writer
+    uint64_t held_total_us_ = 0;
+    std::string held_reason_;
+    bool held_ = false;
+    std::atomic<bool> writing_{false};
+    std::atomic<bool> stop_requested_{false};
+    HANDLE wake_event_ = nullptr;
+    std::thread thread_;
+};
+
+// Plugin DLLs (lookout_plugin.h) and the worker thread that runs them. The core only
+// copies each pose into a bounded ring and signals once per tick; the worker loads the
+// DLLs, converts the poses into one batch that every plugin gets as the same span, and
+// hands on the event bus traffic. Plugin code never runs on the core or sampler
+// threads, so a slow one only delays the others; a full ring drops poses instead of
+// waiting. A plugin whose callbacks keep overrunning the budget is no longer called.
+class PluginHost {
+public:
+    static constexpr size_t kRingCapacity = 2048;
+    static constexpr int kMaxOverruns = 20;
+
+    PluginHost(const PluginsConfig& config, EventBus& bus) : config_(config), bus_(bus) {}
+    ~PluginHost() { stop(); }
+    PluginHost(const PluginHost&) = delete;
+    PluginHost& operator=(const PluginHost&) = delete;
+
+    // Core thread, before the main loop: subscribes to the bus and starts the worker,
+    // which loads the DLLs
+    void start(int64_t clock_epoch_us) {
+        if (!config_.enabled) return;
+        subscription_ = bus_.subscribe("plugins");
+        if (!subscription_) {
+            std::cerr << "[WARNING] Plugins disabled: no event bus subscription left" << std::endl;
+            return;
+        }
+        clock_epoch_us_ = clock_epoch_us;
+        ring_ = std::make_unique<SpscRing<PoseSample, kRingCapacity>>();
+        wake_event_ = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+        thread_ = std::thread(&PluginHost::run, this);
+    }
+
+    // Every plugin's shutdown runs, and its DLL is unloaded, before this returns
+    void stop() {
+        if (!thread_.joinable()) return;
+        stop_requested_ = true;
+        SetEvent(wake_event_);
+        thread_.join();
+        CloseHandle(wake_event_);
+        wake_event_ = nullptr;
+    }
+
+    bool active() const { return ring_ != nullptr; }
+
+    // Core thread, for every sample: `look` replaces the sample's own after filtering
+    void add_pose(const PoseSample& sample, const LookVector& look, int64_t engine_us) {
+        if (!ring_) return;
+        PoseSample pose = sample;
+        pose.look = look;
+        if (ring_->try_push(pose)) {
+            pending_ = true;
+        } else if (dropped_++ == 0) {
+            std::cerr << "[WARNING] Plugins are falling behind; dropping poses" << std::endl;
+        }
+        engine_us_.store(engine_us, std::memory_order_relaxed);
+    }
+
+    // Core thread, once per tick: wake the worker if poses came in
+    void notify() {
+        if (!pending_) return;
+        pending_ = false;
+        SetEvent(wake_event_);
+    }
+
+private:
+    struct Plugin {
+        PluginHost* owner = nullptr;
+        HMODULE module = nullptr;
+        std::string name;
+        LookoutPluginHost host = {};
+        LookoutPluginApi api = {};
+        int overruns = 0;
+        bool enabled = true;
+    };
+
+    static void emit_thunk(void* context, uint32_t code, int64_t value) {
+        Plugin& plugin = *static_cast<Plugin*>(context);
+        BusEvent event;
+        event.type = BusEvent::PLUGIN;
+        event.alarm = code;
+        event.value = value;
+        event.engine_us = plugin.owner->engine_us_.load(std::memory_order_relaxed);
+        event.t_us = monotonic_now_us() - plugin.owner->clock_epoch_us_;
+        plugin.owner->bus_.publish(event);
+    }
+
+    static void log_thunk(void* context, const char* message) {
+        std::cout << "[INFO] Plugin " << static_cast<Plugin*>(context)->name << ": " << (message ? message : "") << std::endl;
+    }
+
+    void load_plugins() {
+        WIN32_FIND_DATAA found;
+        HANDLE find = FindFirstFileA((config_.directory + "\\*.dll").c_str(), &found);
+        if (find == INVALID_HANDLE_VALUE) {
+            std::cout << "[INFO] No plugins in " << config_.directory << std::endl;
+            return;
+        }
+        do {
+            const std::string path = config_.directory + "\\" + found.cFileName;
+            HMODULE module = LoadLibraryA(path.c_str());
+            if (!module) {
+                std::cerr << "[WARNING] Could not load plugin " << path << " (error " << GetLastError() << ")" << std::endl;
+                continue;
+            }
+            auto init = reinterpret_cast<LookoutPluginInitFn>(GetProcAddress(module, "lookout_plugin_init"));
+            if (!init) {
+                std::cerr << "[WARNING] " << path << " is not a Quest Lookout plugin (no lookout_plugin_init)" << std::endl;
+                FreeLibrary(module);
+                continue;
+            }
+            // Stable addresses: the host struct and its context outlive every callback
+            plugins_.push_back(std::make_unique<Plugin>());
+            Plugin& plugin = *plugins_.back();
+            plugin.owner = this;
+            plugin.module = module;
+            plugin.name = found.cFileName;
+            plugin.host = { LOOKOUT_PLUGIN_ABI_VERSION, sizeof(LookoutPluginHost), &plugin, &PluginHost::emit_thunk,
+                            &PluginHost::log_thunk };
+            plugin.api.size = sizeof(LookoutPluginApi);
+            const int32_t result = init(&plugin.host, &plugin.api);
+            if (result != 0) {
+                std::cerr << "[WARNING] Plugin " << plugin.name << " declined to load (" << result << ")" << std::endl;
+                FreeLibrary(module);
+                plugins_.pop_back();
+                continue;
+            }
+            if (plugin.api.name) plugin.name = plugin.api.name;
+            std::cout << "[INFO] Loaded plugin " << plugin.name << " from " << path << std::endl;
+        } while (FindNextFileA(find, &found));
+        FindClose(find);
+    }
+
+    // Times one callback against the budget; the plugin is dropped after repeated overruns
+    template <typename Call>
+    void call(Plugin& plugin, Call&& callback) {
+        const int64_t start_us = monotonic_now_us();
+        callback();
+        const double elapsed_ms = (monotonic_now_us() - start_us) / 1000.0;
+        if (elapsed_ms <= config_.budget_ms) return;
+        if (++plugin.overruns == 1 || plugin.overruns == kMaxOverruns) {
+            std::cerr << "[WARNING] Plugin " << plugin.name << " took " << std::fixed << std::setprecision(1) << elapsed_ms
+                      << " ms (budget " << config_.budget_ms << " ms)"
+                      << (plugin.overruns == kMaxOverruns ? "; no longer calling it" : "") << std::endl;
+        }
+        if (plugin.overruns >= kMaxOverruns) plugin.enabled = false;
+    }
+
+    static LookoutPluginPose to_plugin_pose(const PoseSample& sample) {
+        LookoutPluginPose pose = {};
+        double yaw_deg = 0.0, pitch_deg = 0.0;
+        look_vector_to_yaw_pitch(sample.look, yaw_deg, pitch_deg);
+        pose.t_us = sample.t_us;
+        pose.yaw_deg = static_cast<float>(yaw_deg);
+        pose.pitch_deg = static_cast<float>(pitch_deg);
+        if (sample.lean.valid) {
+            pose.lean_lateral_cm = static_cast<float>(sample.lean.lateral_m * 100.0);
+            pose.lean_vertical_cm = static_cast<float>(sample.lean.vertical_m * 100.0);
+        }
+        pose.angular_speed_deg_s = static_cast<float>(sample.angular_speed_deg_s);
+        pose.flags = ((sample.flags & POSE_HMD_OK) ? LOOKOUT_POSE_HMD_OK : 0u) |
+                     ((sample.flags & POSE_RECENTERED) ? LOOKOUT_POSE_RECENTERED : 0u) |
+                     (sample.lean.valid ? LOOKOUT_POSE_LEAN_VALID : 0u);
+        return pose;
+    }
+
+    void run() {
+        place_background_thread();
+        ThreadCpuScope cpu_scope(CPU_PLUGINS);
+        load_plugins();
+        std::vector<PoseSample> samples(256);
+        std::vector<LookoutPluginPose> poses(samples.size());
+        const HANDLE waits[] = { wake_event_, subscription_->wake_event() };
+        while (true) {
+            WaitForMultipleObjects(2, waits, FALSE, INFINITE);
+            const bool stopping = stop_requested_.load(); // What came before stop() is still delivered
+            size_t count;
+            while ((count = ring_->pop_batch(samples.data(), samples.size())) > 0) {
+                for (size_t n = 0; n < count; ++n) poses[n] = to_plugin_pose(samples[n]);
+                for (auto& plugin : plugins_) {
+                    if (!plugin->enabled || !plugin->api.on_poses) continue;
+                    call(*plugin, [&]() { plugin->api.on_poses(plugin->api.instance, poses.data(), count); });
+                }
+            }
+            // Bounded per pass, so plugins answering each other's events can't spin here
+            BusEvent event;
+            for (size_t n = 0; n < EventBus::kQueueCapacity && subscription_->pop(event); ++n) {
+                const LookoutPluginEvent plugin_event = { static_cast<uint32_t>(event.type), event.alarm, event.value,
+                                                          event.engine_us, event.t_us };
+                for (auto& plugin : plugins_) {
+                    if (!plugin->enabled || !plugin->api.on_event) continue;
+                    call(*plugin, [&]() { plugin->api.on_event(plugin->api.instance, &plugin_event); });
+                }
+            }
+            if (stopping) break;
+        }
+        for (auto& plugin : plugins_) {
+            if (plugin->api.shutdown) plugin->api.shutdown(plugin->api.instance);
+            FreeLibrary(plugin->module);
+        }
+        plugins_.clear();
+    }
+
+    PluginsConfig config_;
+    EventBus& bus_;
+    EventBus::Subscription* subscription_ = nullptr;
+    int64_t clock_epoch_us_ = 0;
+    std::unique_ptr<SpscRing<PoseSample, kRingCapacity>> ring_;
+    bool pending_ = false;                    // Core only
+    uint64_t dropped_ = 0;                    // Core only
+    std::atomic<int64_t> engine_us_{0};       // Latest engine time, for plugin events
+    std::vector<std::unique_ptr<Plugin>> plugins_; // Worker only
+    std::atomic<bool> stop_requested_{false};
+    HANDLE wake_event_ = nullptr;
+    std::thread thread_;
+};
+
+// Flight history writer: the core fills in a flight's summary and events as it flies,
+// into buffers sized once at startup, and at the flight end hands them to a writer
+// thread that appends them to the history files, events first and the record last (see
+// lookout_history.hpp), so the core never waits on the disk.
+class FlightHistory {
+public:
+    explicit FlightHistory(const FlightHistoryConfig& config) : config_(config) {
+        if (!config_.enabled) return;
+        events_.reserve(static_cast<size_t>(config_.max_events));
+        pending_events_.reserve(static_cast<size_t>(config_.max_events));
+    }
+    ~FlightHistory() { stop(); }
+    FlightHistory(const FlightHistory&) = delete;
+    FlightHistory& operator=(const FlightHistory&) = delete;
+
+    void start() {
+        if (!config_.enabled) return;
+        wake_event_ = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+        thread_ = std::thread(&FlightHistory::write_loop, this);
+    }
+
+    // Writes a flight handed over just before, then joins the writer
+    void stop() {
+        if (!thread_.joinable()) return;
+        stop_requested_ = true;
+        SetEvent(wake_event_);
+        thread_.join();
+        CloseHandle(wake_event_);
+        wake_event_ = nullptr;
+    }
+
+    // Core thread, at flight start (pilot from the settings in force then)
+    void begin_flight(int64_t engine_us, const std::string& pilot, const std::string& profile, const std::string& sim,
+                      size_t alarm_count) {
+        if (!thread_.joinable()) return;
+        record_ = FlightHistoryRecord();
+        record_.start_unix_s = static_cast<int64_t>(std::time(nullptr));
+        flight_history_set_name(record_.pilot, sizeof(record_.pilot), pilot);
+        flight_history_set_name(record_.profile, sizeof(record_.profile), profile);
+        flight_history_set_name(record_.sim, sizeof(record_.sim), sim);
+        record_.alarm_count = static_cast<uint32_t>(alarm_count);
+        events_.clear();
+        last_lookout_us_.clear();
+        warning_since_us_.clear();
+        interval_sum_s_ = response_sum_s_ = 0.0;
+        responses_ = 0;
+        flight_start_us_ = engine_us;
+        flying_ = true;
+    }
+
+    void on_warning(uint32_t alarm_id, int64_t engine_us) {
+        if (!flying_) return;
+        ++record_.warnings;
+        warning_since_us_[alarm_id] = engine_us;
+        add_event(FLIGHT_HISTORY_WARNING, alarm_id, engine_us, 0);
+    }
+
+    void on_lookout(uint32_t alarm_id, int64_t engine_us) {
+        if (!flying_) return;
+        auto last = last_lookout_us_.find(alarm_id);
+        const double interval_s = ((std::max<int64_t>)(0, engine_us - (last != last_lookout_us_.end() ? last->second : flight_start_us_))) / 1e6;
+        last_lookout_us_[alarm_id] = engine_us;
+        ++record_.lookouts;
+        interval_sum_s_ += interval_s;
+        record_.max_interval_s = (std::max)(record_.max_interval_s, static_cast<float>(interval_s));
+        auto warning = warning_since_us_.find(alarm_id);
+        if (warning != warning_since_us_.end()) {
+            response_sum_s_ += (engine_us - warning->second) / 1e6;
+            ++responses_;
+            warning_since_us_.erase(warning);
+        }
+        add_event(FLIGHT_HISTORY_LOOKOUT, alarm_id, engine_us, static_cast<uint32_t>(interval_s * 1000.0));
+    }
+
+    // Core thread, at flight end: hand the flight to the writer. A flight that ends
+    // while the last one is still being written (seconds apart) isn't kept.
+    void end_flight(int64_t engine_us) {
+        if (!flying_) return;
+        flying_ = false;
+        record_.flight_s = static_cast<uint32_t>((std::max<int64_t>)(0, engine_us - flight_start_us_) / 1000000);
+        record_.event_count = static_cast<uint32_t>(events_.size());
+        record_.mean_interval_s = record_.lookouts ? static_cast<float>(interval_sum_s_ / record_.lookouts) : 0.0f;
+        record_.mean_response_s = responses_ ? static_cast<float>(response_sum_s_ / responses_) : 0.0f;
+        if (writing_.load()) {
+            std::cerr << "[WARNING] Flight history still writing the previous flight; this one isn't kept" << std::endl;
+            return;
+        }
+        pending_ = record_;
+        pending_events_.swap(events_);
+        writing_ = true;
+        SetEvent(wake_event_);
+    }
+
+private:
+    void add_event(uint8_t type, uint32_t alarm_id, int64_t engine_us, uint32_t value_ms) {
+        if (events_.size() >= events_.capacity()) return; // Counted in the record, not kept
+        FlightHistoryEvent e = {};
+        e.t_ms = static_cast<uint32_t>((engine_us - flight_start_us_) / 1000);
+        e.alarm = static_cast<uint16_t>(alarm_id);
+        e.type = type;
+        e.value_ms = value_ms;
+        events_.push_back(e);
+    }
+
+    void write_loop() {
+        place_background_thread();
+        ThreadCpuScope cpu_scope(CPU_RECORDING);
+        while (true) {
+            WaitForSingleObject(wake_event_, INFINITE);
+            if (writing_.load()) {
+                write_flight();
+                writing_ = false;
+            }
+            if (stop_requested_.load()) break;
+        }
+    }
+
+    // Opens a history file for appending, writing its header when it's new or empty;
+    // returns the number of whole records already in it
+    static bool open_for_append(std::fstream& f, const std::string& path, uint32_t magic, uint16_t record_size, uint64_t& count) {
+        f.open(path, std::ios::binary | std::ios::in | std::ios::out);
+        if (!f.is_open()) f.open(path, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+        if (!f.is_open()) return false;
+        f.seekg(0, std::ios::end);
+        const uint64_t size = static_cast<uint64_t>(f.tellg());
+        FlightHistoryHeader header = {};
+        if (size < sizeof(header)) {
+            header.magic = magic;
+            header.version = FLIGHT_HISTORY_VERSION;
+            header.record_size = record_size;
+            f.seekp(0);
+            f.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            count = 0;
+            return static_cast<bool>(f);
+        }
+        f.seekg(0);
+        f.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!f || header.magic != magic || header.version != FLIGHT_HISTORY_VERSION || header.record_size != record_size) return false;
+        count = (size - sizeof(header)) / record_size;
+        // A record cut short by a crash is overwritten
+        f.seekp(static_cast<std::streamoff>(sizeof(header) + count * record_size));
+        return true;
+    }
+
+    void write_flight() {
+        const std::string events_path = config_.file + ".events";
+        std::fstream records, events;
+        uint64_t record_count = 0, event_count = 0;
+        if (!open_for_append(events, events_path, FLIGHT_HISTORY_EVENTS_MAGIC, sizeof(FlightHistoryEvent), event_count) ||
+            !open_for_append(records, config_.file, FLIGHT_HISTORY_MAGIC, sizeof(FlightHistoryRecord), record_count)) {
+            std::cerr << "[WARNING] Could not open the flight history " << config_.file << std::endl;
+            return;
+        }
+        pending_.events_offset = event_count;
+        events.write(reinterpret_cast<const char*>(pending_events_.data()),
+                     static_cast<std::streamsize>(pending_events_.size() * sizeof(FlightHistoryEvent)));
+        events.flush();
+        if (!events) {
+            std::cerr << "[WARNING] Could not write the flight's events to " << events_path << std::endl;
+            return;
+        }
+        records.write(reinterpret_cast<const char*>(&pending_), sizeof(pending_));
+        records.flush();
+        if (!records) {
+            std::cerr << "[WARNING] Could not write the flight to " << config_.file << std::endl;
+            return;
+        }
+        std::cout << "[INFO] Saved flight " << record_count + 1 << " (" << pending_.flight_s / 60 << " min, "
+                  << pending_.warnings << " warning(s), " << pending_.lookouts << " lookout(s)) to " << config_.file << std::endl;
+    }
+
+    const FlightHistoryConfig config_;
+    // Core thread only
+    bool flying_ = false;
+    int64_t flight_start_us_ = 0;
+    FlightHistoryRecord record_ = {};
+    std::vector<FlightHistoryEvent> events_;
+    std::unordered_map<uint32_t, int64_t> last_lookout_us_, warning_since_us_; // Per alarm id
+    double interval_sum_s_ = 0.0, response_sum_s_ = 0.0;
+    uint32_t responses_ = 0;
+    // Writer thread while writing_ is set
+    FlightHistoryRecord pending_ = {};
+    std::vector<FlightHistoryEvent> pending_events_;
+    std::atomic<bool> writing_{false};
+    std::atomic<bool> stop_requested_{false};
+    HANDLE wake_event_ = nullptr;
+    std::thread thread_;
+};
+
+// State file of "resume": {"persist": true}: a header and the engine's AlarmSnapshots,
+// rewritten every few seconds of a flight by a writer thread (written aside and renamed
+// over the last copy, so a crash leaves a whole one) and removed at the flight end. The
+// next lookout.exe restores it at its first flight start, if it's recent enough.
+constexpr uint32_t ENGINE_STATE_MAGIC = 0x53454C51; // "QLES"
+constexpr uint16_t ENGINE_STATE_VERSION = 1;
+constexpr double ENGINE_STATE_SAVE_INTERVAL = 5.0;  // Seconds of flight between saves
+
+struct EngineStateHeader {
+    uint32_t magic;               // ENGINE_STATE_MAGIC
+    uint16_t version;             // ENGINE_STATE_VERSION
+    uint16_t record_size;         // sizeof(AlarmSnapshot)
+    uint32_t count;
+    uint32_t reserved;
+    int64_t saved_unix_s;         // Wall clock, since engine time doesn't carry over
+};
+static_assert(sizeof(EngineStateHeader) == 24, "EngineStateHeader layout is part of the version");
+
+class EngineStateStore {
+public:
+    explicit EngineStateStore(const ResumeConfig& config) : config_(config) {}
+    ~EngineStateStore() { stop(); }
+    EngineStateStore(const EngineStateStore&) = delete;
+    EngineStateStore& operator=(const EngineStateStore&) = delete;
+
+    void start() {
+        if (!config_.persist) return;
+        wake_event_ = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+        thread_ = std::thread(&EngineStateStore::write_loop, this);
+    }
+
+    // Writes a state handed over just before, then joins the writer
+    void stop() {
+        if (!thread_.joinable()) return;
+        stop_requested_ = true;
+        SetEvent(wake_event_);
+        thread_.join();
+        CloseHandle(wake_event_);
+        wake_event_ = nullptr;
+    }
+
+    bool enabled() const { return thread_.joinable(); }
+
+    // Core thread: the state to keep. Skipped while the last one is still being written;
+    // the next save is seconds away.
+    void save(std::vector<AlarmSnapshot> alarms) {
+        if (!enabled() || writing_.load()) return;
+        pending_ = std::move(alarms);
+        writing_ = true;
+        SetEvent(wake_event_);
+    }
+
+    // Core thread, at the flight end: nothing left to resume
+    void discard() {
+        if (!enabled()) return;
+        discard_requested_ = true;
+        SetEvent(wake_event_);
+    }
+
+    // The state a previous run left, if there is one no older than restart_grace_s;
+    // taken, so it's restored at most once
+    static bool take(const ResumeConfig& config, std::vector<AlarmSnapshot>& alarms, int64_t& age_s) {
+        if (!config.persist) return false;
+        EngineStateHeader header = {};
+        {
+            std::ifstream f(config.file, std::ios::binary);
+            if (!f.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != ENGINE_STATE_MAGIC ||
+                header.version != ENGINE_STATE_VERSION || header.record_size != sizeof(AlarmSnapshot)) {
+                return false;
+            }
+            alarms.resize(header.count);
+            if (!f.read(reinterpret_cast<char*>(alarms.data()), static_cast<std::streamsize>(alarms.size() * sizeof(AlarmSnapshot)))) {
+                alarms.clear();
+            }
+        }
+        DeleteFileA(config.file.c_str());
+        age_s = static_cast<int64_t>(std::time(nullptr)) - header.saved_unix_s;
+        if (alarms.empty() || age_s < 0 || age_s > config.restart_grace_s) {
+            alarms.clear();
+            return false;
+        }
+        return true;
+    }
+
+private:
+    void write_loop() {
+        place_background_thread();
+        ThreadCpuScope cpu_scope(CPU_RECORDING);
+        while (true) {
+            WaitForSingleObject(wake_event_, INFINITE);
+            if (writing_.load()) {
+                write_state();
+                writing_ = false;
+            }
+            if (discard_requested_.exchange(false)) DeleteFileA(config_.file.c_str());
+            if (stop_requested_.load()) break;
+        }
+    }
+
+    void write_state() {
+        EngineStateHeader header = {};
+        header.magic = ENGINE_STATE_MAGIC;
+        header.version = ENGINE_STATE_VERSION;
+        header.record_size = sizeof(AlarmSnapshot);
+        header.count = static_cast<uint32_t>(pending_.size());
+        header.saved_unix_s = static_cast<int64_t>(std::time(nullptr));
+        const std::string temp = config_.file + ".tmp";
+        {
+            std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(pending_.data()), static_cast<std::streamsize>(pending_.size() * sizeof(AlarmSnapshot)));
+            if (!out) {
+                std::cerr << "[WARNING] Could not write the alarm state to " << temp << std::endl;
+                return;
+            }
+        }
+        if (!MoveFileExA(temp.c_str(), config_.file.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+            std::cerr << "[WARNING] Could not replace " << config_.file << " (error " << GetLastError() << ")" << std::endl;
+        }
+    }
+
+    const ResumeConfig config_;
+    std::vector<AlarmSnapshot> pending_; // Writer thread while writing_ is set
+    std::atomic<bool> writing_{false};
+    std::atomic<bool> discard_requested_{false};
+    std::atomic<bool> stop_requested_{false};
+    HANDLE wake_event_ = nullptr;
+    std::thread thread_;
+};
+
+// Session log files for the async log sink: lines are copied into a memory-mapped
+// segment file of fixed size (logging.segment_kb), so an append is a memcpy and the
+// OS writes the pages back on its own schedule; even a crash loses nothing already
+// appended. A segment is closed (trimmed to what was written) and the next one opened
+// when it fills or after rotate_minutes, and the oldest lookout_*.log files in the
+// directory are deleted to keep them all within budget_mb. Sink thread only.
+class SessionLog {
+public:
+    explicit SessionLog(const LoggingConfig& config)
+        : config_(config), capacity_(static_cast<size_t>(config.segment_kb) * 1024) {}
+    ~SessionLog() { close_segment(); }
+    SessionLog(const SessionLog&) = delete;
+    SessionLog& operator=(const SessionLog&) = delete;
+
+    bool open() {
+        if (config_.directory.empty()) return false;
+        CreateDirectoryA(config_.directory.c_str(), nullptr); // Fails harmlessly when it exists
+        std::time_t now = std::time(nullptr);
+        std::tm local = {};
+        localtime_s(&local, &now);
+        char stamp[32];
+        std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", &local);
+        session_stamp_ = stamp;
+        if (!open_segment()) return false;
+        std::cout << "[INFO] Logging to " << path_ << " (segments of " << config_.segment_kb << " KiB, "
+                  << config_.budget_mb << " MiB kept)" << std::endl;
+        return true;
+    }
+
+    bool is_open() const { return view_ != nullptr; }
+
+    void append(const char* data, size_t size) {
+        if (!view_) return;
+        if (used_ + size > capacity_ || monotonic_now_us() >= rotate_at_us_) {
+            close_segment();
+            if (!open_segment()) return;
+        }
+        size = (std::min)(size, capacity_ - used_); // A line longer than a whole segment is cut
+        std::memcpy(view_ + used_, data, size);
+        used_ += size;
+    }
+
+    // Write the dirty pages back now; for a clean copy on disk even if power goes
+    void flush() {
+        if (view_ && used_ > flushed_) {
+            FlushViewOfFile(view_, used_);
+            flushed_ = used_;
+        }
+    }
+
+private:
+    bool open_segment() {
+        enforce_budget();
+        char segment[16];
+        std::snprintf(segment, sizeof(segment), "_%03d.log", ++segment_); // Zero-padded, so names sort in order
+        path_ = config_.directory + "\\lookout_" + session_stamp_ + segment;
+        file_ = CreateFileA(path_.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ != INVALID_HANDLE_VALUE) {
+            mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READWRITE, 0, static_cast<DWORD>(capacity_), nullptr);
+        }
+        if (mapping_) view_ = static_cast<char*>(MapViewOfFile(mapping_, FILE_MAP_WRITE, 0, 0, capacity_));
+        if (!view_) {
+            std::cerr << "[WARNING] Could not create log file " << path_ << " (error " << GetLastError() << ")" << std::endl;
+            close_segment();
+            return false;
+        }
+        used_ = flushed_ = 0;
+        rotate_at_us_ = monotonic_now_us() + static_cast<int64_t>(config_.rotate_minutes * 60e6);
+        return true;
+    }
+
+    // Unmapped and trimmed, so the file holds only what was written
+    void close_segment() {
+        if (view_) {
+            FlushViewOfFile(view_, used_);
+            UnmapViewOfFile(view_);
+            view_ = nullptr;
+        }
+        if (mapping_) {
+            CloseHandle(mapping_);
+            mapping_ = nullptr;
+        }
+        if (file_ != INVALID_HANDLE_VALUE) {
+            LARGE_INTEGER end;
+            end.QuadPart = static_cast<LONGLONG>(used_);
+            SetFilePointerEx(file_, end, nullptr, FILE_BEGIN);
+            SetEndOfFile(file_);
+            CloseHandle(file_);
+            file_ = INVALID_HANDLE_VALUE;
+        }
+    }
+
+    // Delete the oldest logs, by write time, until a new segment fits the budget
+    void enforce_budget() {
+        trim_directory(config_.directory, "lookout_*.log", static_cast<uint64_t>(config_.budget_mb) * 1024 * 1024, capacity_);
+    }
+
+    const LoggingConfig config_;
+    const size_t capacity_;
+    std::string session_stamp_;
+    std::string path_;
+    int segment_ = 0;
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+    char* view_ = nullptr;
+    size_t used_ = 0, flushed_ = 0;
+    int64_t rotate_at_us_ = 0;
+};
+
+// Copies every line written to std::cout and std::cerr, from any thread, into the
+// session log as well: each thread builds its lines in thread-local buffers, and complete
+// lines are handed over under a short spin lock for the sink to collect. The sink thread
+// itself isn't captured (it writes its own lines to the log directly). Installed by
+// WinMain before the first thread starts and removed after the last is joined, since
+// swapping a stream's buffer isn't safe while another thread prints; lines are only
+// kept while a sink is collecting them.
+class ConsoleCapture : public std::streambuf {
+public:
+    enum Stream { STDOUT, STDERR };
+    ConsoleCapture(std::ostream& stream, Stream which) : stream_(stream), which_(which), original_(stream.rdbuf(this)) {}
+    ~ConsoleCapture() { stream_.rdbuf(original_); }
+    ConsoleCapture(const ConsoleCapture&) = delete;
+    ConsoleCapture& operator=(const ConsoleCapture&) = delete;
+
+    static void exclude_this_thread() { excluded_ = true; }
+    static void set_collecting(bool collecting) { collecting_.store(collecting, std::memory_order_relaxed); }
+
+    // Sink thread: the lines captured since the last call, each already stamped
+    static void take(std::string& out) {
+        out.clear();
+        lock();
+        out.swap(pending_);
+        unlock();
+    }
+
+protected:
+    int_type overflow(int_type c) override {
+        if (traits_type::eq_int_type(c, traits_type::eof())) return original_->pubsync() == 0 ? traits_type::not_eof(c) : c;
+        capture(traits_type::to_char_type(c));
+        return original_->sputc(traits_type::to_char_type(c));
+    }
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        for (std::streamsize i = 0; i < n; ++i) capture(s[i]);
+        return original_->sputn(s, n);
+    }
+    int sync() override { return original_->pubsync(); }
+
+private:
+    void capture(char c) {
+        if (excluded_ || !collecting_.load(std::memory_order_relaxed)) return;
+        thread_local std::string lines[2];
+        std::string& line = lines[which_];
+        if (line.empty()) {
+            char stamp[32];
+            std::snprintf(stamp, sizeof(stamp), "%.6f ", monotonic_now_us() / 1e6);
+            line = stamp;
+        }
+        line.push_back(c);
+        if (c != '\n') return;
+        lock();
+        if (pending_.size() < kMaxPending) pending_ += line;
+        unlock();
+        line.clear();
+    }
+
+    static void lock() { while (lock_.test_and_set(std::memory_order_acquire)) YieldProcessor(); }
+    static void unlock() { lock_.clear(std::memory_order_release); }
+
+    static constexpr size_t kMaxPending = 1 << 20; // Past this (sink stalled) lines are dropped
+    static inline thread_local bool excluded_ = false;
+    static inline std::atomic<bool> collecting_{false};
+    static inline std::atomic_flag lock_ = ATOMIC_FLAG_INIT;
+    static inline std::string pending_;
+
+    std::ostream& stream_;
+    const Stream which_;
+    std::streambuf* const original_;
+};
+
+std::unique_ptr<ConsoleCapture> g_stdout_capture, g_stderr_capture; // Held by ConsoleCaptureScope
+
+ConsoleCaptureScope::ConsoleCaptureScope() {
+    g_stdout_capture = std::make_unique<ConsoleCapture>(std::cout, ConsoleCapture::STDOUT);
+    g_stderr_capture = std::make_unique<ConsoleCapture>(std::cerr, ConsoleCapture::STDERR);
+}
+
+ConsoleCaptureScope::~ConsoleCaptureScope() {
+    g_stdout_capture.reset();
+    g_stderr_capture.reset();
+}
+
+// Log lines from the core thread's hot path. The core only stores a fixed-size record
+// (timestamp, static format string, a few numeric or static-string arguments) into a
+// lock-free single-producer ring; a sink thread formats the records and writes them to
+// the console and the session log, flushing once per batch rather than per line. The
+// sink also moves every other thread's console output, captured by ConsoleCapture, into
+// the session log, so it's never written from the thread that printed it. With the
+// console hidden and no session log the sink doesn't format records at all. It keeps
+// the last logging.backlog_lines lines, queued records still unformatted and captured
+// console lines as printed, and writes them out when the status window opens, so what
+// led up to a problem can be read afterwards. A full ring drops the record and counts
+// it instead of blocking the core.
+class AsyncLog {
+public:
+    static constexpr size_t kCapacity = 2048; // Records; a power of two
+    static constexpr size_t kMaxArgs = 6;
+
+    explicit AsyncLog(const LoggingConfig& config)
+        : config_(config), ring_(kCapacity), session_(config), backlog_(static_cast<size_t>(config.backlog_lines)) {}
+    ~AsyncLog() { stop(); }
+    AsyncLog(const AsyncLog&) = delete;
+    AsyncLog& operator=(const AsyncLog&) = delete;
+
+    void start() {
+        ConsoleCapture::set_collecting(true);
+        if (session_.open()) g_log_sinks.fetch_or(LOG_SINK_SESSION_FILE);
+        if (!backlog_.empty()) g_log_sinks.fetch_or(LOG_SINK_BACKLOG);
+        stop_event_ = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        thread_ = std::thread(&AsyncLog::sink_loop, this);
+    }
+
+    // Writes whatever is still queued before returning
+    void stop() {
+        if (!thread_.joinable()) return;
+        SetEvent(stop_event_);
+        thread_.join();
+        CloseHandle(stop_event_);
+        stop_event_ = nullptr;
+        g_log_sinks.fetch_and(~static_cast<uint32_t>(LOG_SINK_SESSION_FILE | LOG_SINK_BACKLOG));
+        ConsoleCapture::set_collecting(false);
+    }
+
+    // Core thread only. Each "{}" in the format takes the next argument; "{.N}" prints a
+    // floating-point argument with N decimals. The format and any string arguments must
+    // be string literals or otherwise outlive the sink. Lines starting "[ERROR]" go to
+    // stderr.
+    template <typename... Args>
+    void write(const char* format, Args... args) { push(format, false, args...); }
+
+    // Same, without ending the line: the next record continues it. For lines with more
+    // than kMaxArgs arguments.
+    template <typename... Args>
+    void write_part(const char* format, Args... args) { push(format, true, args...); }
+
+private:
+    union Arg {
+        int64_t i;
+        double d;
+        const char* s;
+    };
+    enum ArgKind : uint8_t { ARG_INT, ARG_DOUBLE, ARG_TEXT };
+
+    struct Record {
+        int64_t t_us;
+        const char* format;
+        Arg args[kMaxArgs];
+        ArgKind kinds[kMaxArgs];
+        uint8_t argc;
+        bool continues;
+    };
+
+    template <typename T>
+    static void set_arg(Record& r, size_t n, T value) {
+        if constexpr (std::is_same_v<T, const char*> || std::is_same_v<T, char*>) {
+            r.kinds[n] = ARG_TEXT;
+            r.args[n].s = value;
+        } else if constexpr (std::is_floating_point_v<T>) {
+            r.kinds[n] = ARG_DOUBLE;
+            r.args[n].d = value;
+        } else {
+            static_assert(std::is_integral_v<T> || std::is_enum_v<T>, "AsyncLog takes numbers and static strings");
+            r.kinds[n] = ARG_INT;
+            r.args[n].i = static_cast<int64_t>(value);
+        }
+    }
+
+    template <typename... Args>
+    void push(const char* format, bool continues, Args... args) {
+        static_assert(sizeof...(Args) <= kMaxArgs, "Split the line with write_part");
+        const uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= kCapacity) {
+            dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+        Record& r = ring_[head & (kCapacity - 1)];
+        r.t_us = monotonic_now_us();
+        r.format = format;
+        r.argc = static_cast<uint8_t>(sizeof...(Args));
+        r.continues = continues;
+        size_t n = 0;
+        (set_arg(r, n++, args), ...);
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    static void format_record(const Record& r, std::string& out) {
+        char buffer[64];
+        size_t arg = 0;
+        for (const char* f = r.format; *f; ++f) {
+            const char* close = *f == '{' ? std::strchr(f, '}') : nullptr;
+            if (!close) {
+                out.push_back(*f);
+                continue;
+            }
+            int decimals = f[1] == '.' ? std::atoi(f + 2) : -1;
+            f = close;
+            if (arg >= r.argc) continue;
+            const Arg& a = r.args[arg];
+            switch (r.kinds[arg++]) {
+            case ARG_INT: std::snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(a.i)); break;
+            case ARG_DOUBLE:
+                if (decimals >= 0) std::snprintf(buffer, sizeof(buffer), "%.*f", decimals, a.d);
+                else std::snprintf(buffer, sizeof(buffer), "%g", a.d);
+                break;
+            case ARG_TEXT: out += a.s ? a.s : "(null)"; continue;
+            }
+            out += buffer;
+        }
+    }
+
+    void sink_loop() {
+        place_background_thread();
+        ThreadCpuScope cpu_scope(CPU_RECORDING);
+        constexpr DWORD kFlushIntervalMs = 20;
+        constexpr int64_t kFileFlushIntervalUs = 2000000;
+        ConsoleCapture::exclude_this_thread();
+        int64_t next_file_flush_us = 0;
+        while (true) {
+            const bool stopping = WaitForSingleObject(stop_event_, kFlushIntervalMs) == WAIT_OBJECT_0;
+            drain();
+            if (stopping || monotonic_now_us() >= next_file_flush_us) {
+                session_.flush();
+                next_file_flush_us = monotonic_now_us() + kFileFlushIntervalUs;
+            }
+            if (stopping) break;
+        }
+    }
+
+    // One backlog line: a queued record (or a part of one, line_start false for the
+    // parts after the first) or a captured console line with its stamp
+    struct BacklogEntry {
+        bool is_text = false;
+        bool line_start = true;
+        Record record{};
+        std::string text;
+    };
+
+    BacklogEntry& next_backlog_entry() {
+        BacklogEntry& e = backlog_[backlog_next_];
+        backlog_next_ = (backlog_next_ + 1) % backlog_.size();
+        backlog_size_ = (std::min)(backlog_size_ + 1, backlog_.size());
+        return e;
+    }
+
+    void backlog_captured(const std::string& captured) {
+        if (backlog_.empty()) return;
+        for (size_t begin = 0; begin < captured.size();) {
+            size_t end = captured.find('\n', begin);
+            if (end == std::string::npos) end = captured.size();
+            BacklogEntry& e = next_backlog_entry();
+            e.is_text = true;
+            e.line_start = true;
+            e.text.assign(captured, begin, end - begin);
+            begin = end + 1;
+        }
+    }
+
+    // The status window just opened: format and write out the backlog, oldest first,
+    // skipping a line whose start has been overwritten
+    void replay_backlog() {
+        if (backlog_size_ == 0) return;
+        const size_t first = (backlog_next_ + backlog_.size() - backlog_size_) % backlog_.size();
+        std::string text = "[INFO] Earlier log lines (engine clock seconds):\n";
+        std::string line;
+        bool in_line = false;
+        int64_t line_us = 0;
+        for (size_t n = 0; n < backlog_size_; ++n) {
+            const BacklogEntry& e = backlog_[(first + n) % backlog_.size()];
+            if (e.is_text) {
+                text += e.text + '\n';
+                continue;
+            }
+            if (e.line_start) {
+                in_line = true;
+                line.clear();
+                line_us = e.record.t_us;
+            }
+            if (!in_line) continue;
+            format_record(e.record, line);
+            if (e.record.continues) continue;
+            char stamp[32];
+            std::snprintf(stamp, sizeof(stamp), "%.6f ", line_us / 1e6);
+            text += stamp + line + '\n';
+            in_line = false;
+        }
+        text += "[INFO] End of earlier log lines";
+        std::cout << text << std::endl;
+    }
+
+    void write_session_line(int64_t t_us, const std::string& line) {
+        char stamp[32];
+        int n = std::snprintf(stamp, sizeof(stamp), "%.6f ", t_us / 1e6);
+        session_.append(stamp, static_cast<size_t>(n));
+        session_.append(line.data(), line.size());
+        session_.append("\n", 1);
+    }
+
+    void drain() {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        const uint64_t head = head_.load(std::memory_order_acquire);
+        const bool to_console = g_is_console_visible.load();
+        const bool to_file = session_.is_open();
+        if (to_console && !console_was_visible_) replay_backlog();
+        console_was_visible_ = to_console;
+        bool wrote_out = false, wrote_err = false;
+        for (; tail != head; ++tail) {
+            const Record& r = ring_[tail & (kCapacity - 1)];
+            if (!backlog_.empty()) {
+                BacklogEntry& e = next_backlog_entry();
+                e.is_text = false;
+                e.line_start = !backlog_continues_;
+                e.record = r;
+                backlog_continues_ = r.continues;
+            }
+            if (!to_console && !to_file) continue; // Nobody would see it now: skip the formatting
+            if (line_.empty()) line_start_us_ = r.t_us;
+            format_record(r, line_);
+            if (r.continues) continue;
+            if (to_console) {
+                const bool error = line_.compare(0, 7, "[ERROR]") == 0;
+                (error ? std::cerr : std::cout) << line_ << '\n';
+                (error ? wrote_err : wrote_out) = true;
+            }
+            if (to_file) write_session_line(line_start_us_, line_);
+            line_.clear();
+        }
+        tail_.store(head, std::memory_order_release);
+        if (wrote_out) std::cout.flush();
+        if (wrote_err) std::cerr.flush();
+        ConsoleCapture::take(captured_);
+        if (to_file) session_.append(captured_.data(), captured_.size());
+        backlog_captured(captured_);
+
+        const uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+        if (dropped != reported_dropped_) {
+            std::string warning = "[WARNING] Log queue full: " + std::to_string(dropped - reported_dropped_) + " line(s) dropped";
+            std::cerr << warning << std::endl;
+            if (to_file) write_session_line(monotonic_now_us(), warning);
+            reported_dropped_ = dropped;
+        }
+    }
+
+    const LoggingConfig config_;
+    std::vector<Record> ring_;                     // kCapacity records
+    alignas(64) std::atomic<uint64_t> head_{0};    // Written by the core thread
+    alignas(64) std::atomic<uint64_t> tail_{0};    // Written by the sink
+    std::atomic<uint64_t> dropped_{0};             // Written by the core thread
+    uint64_t reported_dropped_ = 0;                // Sink only, as are the rest
+    std::string line_;
+    int64_t line_start_us_ = 0;
+    SessionLog session_;
+    std::string captured_;
+    std::vector<BacklogEntry> backlog_;            // logging.backlog_lines entries, a ring
+    size_t backlog_next_ = 0, backlog_size_ = 0;
+    bool backlog_continues_ = false;               // The last record queued was a write_part
+    bool console_was_visible_ = false;
+    HANDLE stop_event_ = nullptr;
+    std::thread thread_;
+};
+
+// Named counters, gauges and histograms, registered once and then updated in place by
+// the core thread with plain atomic stores (it is the only writer, so no read-modify-
+// write is needed). Sinks read them from their own threads at their own rate through
+// visit(); an update never waits on a sink. Registration is on the core thread too: the
+// slot table is reserved up front, so registering more (new alarms on a settings reload)
+// never moves a metric a sink may be reading, and a release counter publishes it.
+class MetricsRegistry {
+public:
+    enum Kind : uint8_t { COUNTER, GAUGE, HISTOGRAM };
+
+    struct Metric {
+        Metric(std::string n, Kind k, std::vector<double> b)
+            : name(std::move(n)), kind(k), bounds(std::move(b)), buckets(new std::atomic<uint64_t>[bounds.size() + 1]) {
+            for (size_t i = 0; i <= bounds.size(); ++i) buckets[i] = 0;
+        }
+        const std::string name;
+        const Kind kind;
+        const std::vector<double> bounds;               // HISTOGRAM: bucket upper bounds, ascending
+        std::unique_ptr<std::atomic<uint64_t>[]> buckets; // bounds.size() + 1, the last unbounded
+        std::atomic<uint64_t> count{0};                 // COUNTER value; HISTOGRAM observations
+        std::atomic<double> value{0.0};                 // GAUGE value; HISTOGRAM sum
+    };
+
+    size_t counter(const std::string& name) { return add(name, COUNTER, {}); }
+    size_t gauge(const std::string& name) { return add(name, GAUGE, {}); }
+    size_t histogram(const std::string& name, std::vector<double> bounds) { return add(name, HISTOGRAM, std::move(bounds)); }
+
+    // Core thread only
+    void increment(size_t id, uint64_t n = 1) {
+        std::atomic<uint64_t>& c = at(id).count;
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+    void set(size_t id, double v) { at(id).value.store(v, std::memory_order_relaxed); }
+    uint64_t count(size_t id) const { return id < kMaxMetrics ? metrics_[id]->count.load(std::memory_order_relaxed) : 0; }
+    void observe(size_t id, double v) {
+        Metric& m = at(id);
+        size_t b = 0;
+        while (b < m.bounds.size() && v > m.bounds[b]) ++b;
+        m.buckets[b].store(m.buckets[b].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m.count.store(m.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m.value.store(m.value.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+    }
+
+    // Any thread: fn(const Metric&) for each metric in registration order
+    template <typename Fn>
+    void visit(Fn&& fn) const {
+        const size_t published = published_.load(std::memory_order_acquire);
+        for (size_t i = 0; i < published; ++i) fn(*metrics_[i]);
+    }
+
+private:
+    static constexpr size_t kMaxMetrics = 1024;
+
+    // Registering a name again returns the existing metric. Past kMaxMetrics, further
+    // registrations share a discarded slot.
+    size_t add(const std::string& name, Kind kind, std::vector<double> bounds) {
+        for (size_t i = 0; i < metrics_.size(); ++i) {
+            if (metrics_[i]->name == name) return i;
+        }
+        if (metrics_.size() == kMaxMetrics) {
+            if (!overflow_) {
+                std::cerr << "[WARNING] More than " << kMaxMetrics << " metrics; " << name << " and later ones aren't reported" << std::endl;
+                overflow_ = std::make_unique<Metric>("overflow", kind, std::vector<double>());
+            }
+            return kMaxMetrics;
+        }
+        metrics_.push_back(std::make_unique<Metric>(name, kind, std::move(bounds)));
+        published_.store(metrics_.size(), std::memory_order_release);
+        return metrics_.size() - 1;
+    }
+
+    Metric& at(size_t id) { return id < kMaxMetrics ? *metrics_[id] : *overflow_; }
+
+    std::vector<std::unique_ptr<Metric>> metrics_ = reserved();
+    std::unique_ptr<Metric> overflow_;
+    std::atomic<size_t> published_{0};
+
+    static std::vector<std::unique_ptr<Metric>> reserved() {
+        std::vector<std::unique_ptr<Metric>> v;
+        v.reserve(kMaxMetrics);
+        return v;
+    }
+};
+
+// Writes MetricsRegistry snapshots every metrics.interval_ms: to the status window as
+// one [METRICS] line per group ("alarm.3", "head", ...: the name up to its last dot)
+// of name=value pairs, and as one JSON object per line to metrics.file.
+class MetricsSink {
+public:
+    MetricsSink(const MetricsRegistry& registry, const MetricsConfig& config) : registry_(registry), config_(config) {}
+    ~MetricsSink() { stop(); }
+    MetricsSink(const MetricsSink&) = delete;
+    MetricsSink& operator=(const MetricsSink&) = delete;
+
+    void start() {
+        if (!config_.file.empty()) {
+            file_.open(config_.file, std::ios::app);
+            if (!file_) std::cerr << "[WARNING] Could not open metrics file " << config_.file << std::endl;
+        }
+        if (!config_.console && !file_.is_open()) return;
+        stop_event_ = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        thread_ = std::thread(&MetricsSink::run, this);
+    }
+
+    void stop() {
+        if (!thread_.joinable()) return;
+        SetEvent(stop_event_);
+        thread_.join();
+        CloseHandle(stop_event_);
+        stop_event_ = nullptr;
+    }
+
+private:
+    void run() {
+        place_background_thread();
+        ThreadCpuScope cpu_scope(CPU_RECORDING);
+        while (WaitForSingleObject(stop_event_, config_.interval_ms) == WAIT_TIMEOUT) {
+            if (config_.console && g_is_console_visible.load() && log_level_enabled(LEVEL_INFO)) write_console();
+            if (file_.is_open()) write_file();
+        }
+    }
+
+    static void append_number(std::string& out, double v) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.6g", std::isfinite(v) ? v : 0.0);
+        out += buffer;
+    }
+
+    void write_console() {
+        std::string text, group;
+        registry_.visit([&](const MetricsRegistry::Metric& m) {
+            size_t dot = m.name.rfind('.');
+            std::string next_group = dot == std::string::npos ? std::string() : m.name.substr(0, dot);
+            if (text.empty() || next_group != group) {
+                if (!text.empty()) text += '\n';
+                text += "[METRICS] " + next_group + ":";
+                group = next_group;
+            }
+            text += ' ' + m.name.substr(dot == std::string::npos ? 0 : dot + 1) + '=';
+            const uint64_t count = m.count.load(std::memory_order_relaxed);
+            switch (m.kind) {
+            case MetricsRegistry::COUNTER: text += std::to_string(count); break;
+            case MetricsRegistry::GAUGE: append_number(text, m.value.load(std::memory_order_relaxed)); break;
+            case MetricsRegistry::HISTOGRAM:
+                text += std::to_string(count);
+                if (count) {
+                    text += "(mean ";
+                    append_number(text, m.value.load(std::memory_order_relaxed) / count);
+                    text += ')';
+                }
+                break;
+            }
+        });
+        if (!text.empty()) std::cout << text << std::endl;
+    }
+
+    void write_file() {
+        nlohmann::json line = {{"t_us", monotonic_now_us()}};
+        nlohmann::json& values = line["metrics"];
+        registry_.visit([&](const MetricsRegistry::Metric& m) {
+            switch (m.kind) {
+            case MetricsRegistry::COUNTER: values[m.name] = m.count.load(std::memory_order_relaxed); break;
+            case MetricsRegistry::GAUGE: {
+                double v = m.value.load(std::memory_order_relaxed);
+                values[m.name] = std::isfinite(v) ? v : 0.0;
+                break;
+            }
+            case MetricsRegistry::HISTOGRAM: {
+                nlohmann::json counts = nlohmann::json::array();
+                for (size_t b = 0; b <= m.bounds.size(); ++b) counts.push_back(m.buckets[b].load(std::memory_order_relaxed));
+                values[m.name] = {{"count", m.count.load(std::memory_order_relaxed)},
+                                  {"sum", m.value.load(std::memory_order_relaxed)},
+                                  {"bounds", m.bounds}, {"buckets", counts}};
+                break;
+            }
+            }
+        });
+        file_ << line.dump() << '\n';
+        file_.flush();
+    }
+
+    const MetricsRegistry& registry_;
+    const MetricsConfig config_;
+    std::ofstream file_;
+    HANDLE stop_event_ = nullptr;
+    std::thread thread_;
+};
+
+// Publishes the LookoutTelemetry block (lookout_telemetry.hpp) in a named file mapping.
+// The core fills local() and publish() copies it in under the seqlock: a memcpy per
+// tick whether or not anyone reads it, and readers never hold anything up.
+class TelemetryPublisher {
+public:
+    explicit TelemetryPublisher(const TelemetryConfig& config) {
+        std::memset(&local_, 0, sizeof(local_));
+        local_.magic = LOOKOUT_TELEMETRY_MAGIC;
+        local_.version = LOOKOUT_TELEMETRY_VERSION;
+        local_.size = sizeof(LookoutTelemetry);
+        if (!config.shared_memory) return;
+        mapping_ = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(LookoutTelemetry), config.name.c_str());
+        if (mapping_) view_ = static_cast<LookoutTelemetry*>(MapViewOfFile(mapping_, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, sizeof(LookoutTelemetry)));
+        if (!view_) {
+            std::cerr << "[WARNING] Could not create telemetry shared memory \"" << config.name << "\" (error " << GetLastError() << ")" << std::endl;
+            return;
+        }
+        std::cout << "[INFO] Publishing scan state in shared memory \"" << config.name << "\"" << std::endl;
+    }
+    ~TelemetryPublisher() {
+        if (view_) UnmapViewOfFile(view_);
+        if (mapping_) CloseHandle(mapping_);
+    }
+    TelemetryPublisher(const TelemetryPublisher&) = delete;
+    TelemetryPublisher& operator=(const TelemetryPublisher&) = delete;
+
+    bool active() const { return view_ != nullptr; }
+    LookoutTelemetry& local() { return local_; }
+
+    // Everything but the sequence word is copied between the odd and even stores
+    void publish() {
+        if (!view_) return;
+        auto* sequence = reinterpret_cast<std::atomic<uint32_t>*>(&view_->sequence);
+        const uint32_t s = sequence->load(std::memory_order_relaxed);
+        sequence->store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        constexpr size_t kBefore = offsetof(LookoutTelemetry, sequence);
+        constexpr size_t kAfter = offsetof(LookoutTelemetry, flags);
+        std::memcpy(view_, &local_, kBefore);
+        std::memcpy(reinterpret_cast<char*>(view_) + kAfter, reinterpret_cast<const char*>(&local_) + kAfter,
+                    sizeof(LookoutTelemetry) - kAfter);
+        sequence->store(s + 2, std::memory_order_release);
+    }
+
+private:
+    LookoutTelemetry local_;
+    HANDLE mapping_ = nullptr;
+    LookoutTelemetry* view_ = nullptr;
+};
+
+// Outbound UDP stream of the scan state (lookout_telemetry.hpp datagram layout), so
+// another PC can watch it live. Samples are kept at rate_hz and sent
+// samples_per_datagram at a time with the alarms' state. The socket is non-blocking:
+// a datagram the network stack can't take right away is dropped, not waited on.
+class UdpStream {
+public:
+    explicit UdpStream(const UdpStreamConfig& config)
+        : config_(config), period_us_(static_cast<int64_t>(1e6 / config.rate_hz)) {}
+
+    bool start() {
+        if (!config_.enabled) return false;
+        std::optional<sf::IpAddress> address = sf::IpAddress::resolve(config_.host);
+        if (!address) {
+            std::cerr << "[WARNING] UDP stream: cannot resolve " << config_.host << std::endl;
+            return false;
+        }
+        address_ = *address;
+        socket_.setBlocking(false);
+        active_ = true;
+        std::cout << "[INFO] Streaming scan state to " << address_.toString() << ":" << config_.port << " over UDP" << std::endl;
+        return true;
+    }
+
+    bool active() const { return active_; }
+
+    // Core thread, every sample
+    void record(const LookoutTelemetry& t) {
+        if (!active_ || t.engine_us < next_sample_us_) return;
+        next_sample_us_ = t.engine_us + period_us_;
+        LookoutStreamSample& s = samples_[sample_count_++];
+        s.engine_us = t.engine_us;
+        s.yaw_cdeg = to_int16(t.yaw_deg * 100.0);
+        s.pitch_cdeg = to_int16(t.pitch_deg * 100.0);
+        s.lean_lateral_mm = to_int16(t.lean_lateral_cm * 10.0);
+        s.lean_vertical_mm = to_int16(t.lean_vertical_cm * 10.0);
+        if (sample_count_ >= static_cast<size_t>(config_.samples_per_datagram)) send(t);
+    }
+
+    ~UdpStream() {
+        if (dropped_ > 0) std::cerr << "[WARNING] UDP stream dropped " << dropped_ << " datagram(s)" << std::endl;
+    }
+
+private:
+    static constexpr size_t kMaxSamples = 32;
+
+    static int16_t to_int16(double v) {
+        return static_cast<int16_t>(std::lround((std::max)(-32767.0, (std::min)(32767.0, v))));
+    }
+    static uint16_t to_deciseconds(float seconds) {
+        return static_cast<uint16_t>((std::max)(0.0f, (std::min)(65535.0f, seconds * 10.0f)));
+    }
+
+    void send(const LookoutTelemetry& t) {
+        LookoutStreamHeader header = {};
+        header.magic = LOOKOUT_STREAM_MAGIC;
+        header.version = LOOKOUT_STREAM_VERSION;
+        header.sample_count = static_cast<uint8_t>(sample_count_);
+        header.alarm_count = static_cast<uint8_t>(t.alarm_count);
+        header.sequence = sequence_++;
+        header.flags = t.flags;
+        uint8_t* out = datagram_.data();
+        std::memcpy(out, &header, sizeof(header));
+        out += sizeof(header);
+        std::memcpy(out, samples_.data(), sample_count_ * sizeof(LookoutStreamSample));
+        out += sample_count_ * sizeof(LookoutStreamSample);
+        for (uint32_t i = 0; i < t.alarm_count; ++i) {
+            const LookoutTelemetryAlarm& a = t.alarms[i];
+            LookoutStreamAlarm alarm = {};
+            alarm.id = static_cast<uint16_t>(a.id);
+            alarm.seen = a.seen;
+            alarm.state = static_cast<uint8_t>(a.warning | (a.silenced << 1));
+            alarm.no_look_ds = to_deciseconds(a.no_look_s);
+            alarm.until_due_ds = to_deciseconds(a.until_due_s);
+            std::memcpy(out, &alarm, sizeof(alarm));
+            out += sizeof(alarm);
+        }
+        if (socket_.send(datagram_.data(), out - datagram_.data(), address_, static_cast<unsigned short>(config_.port)) != sf::Socket::Status::Done) {
+            ++dropped_;
+        }
+        sample_count_ = 0;
+    }
+
+    const UdpStreamConfig config_;
+    const int64_t period_us_;
+    sf::UdpSocket socket_;
+    sf::IpAddress address_ = sf::IpAddress::LocalHost;
+    bool active_ = false;
+    int64_t next_sample_us_ = INT64_MIN;
+    std::array<LookoutStreamSample, kMaxSamples> samples_{};
+    size_t sample_count_ = 0;
+    uint32_t sequence_ = 0;
+    uint64_t dropped_ = 0;
+    std::array<uint8_t, sizeof(LookoutStreamHeader) + kMaxSamples * sizeof(LookoutStreamSample) +
+                             LOOKOUT_TELEMETRY_MAX_ALARMS * sizeof(LookoutStreamAlarm)> datagram_{};
+};
+
+// Station side of the fleet protocol (lookout_telemetry.hpp). Listens on the discovery
+// port for a lookout_hub's announcements and, once it has heard one, sends that hub the
+// alarm events batch_s at a time, a summary of each minute and pose_rate_hz poses.
+// Core thread only: the socket is non-blocking and polled from the core loop. A hub
+// that hasn't announced itself for 10 s is dropped until one is heard again.
+// With fleet.accept_settings the hub may push a settings snapshot in chunks. Once all of
+// it is in, a task off the core thread validates it and saves it as settings.json;
+// take_settings() then hands it to the core's hot-reload, and the hub gets an ack with
+// the station's new config hash. A snapshot that changes a block only the station may
+// set (FLEET_LOCAL_SETTINGS) is rejected whole.
+class FleetLink {
+public:
+    static constexpr int64_t kHubTimeoutUs = 10000000;
+    static constexpr int64_t kMinuteUs = 60000000;
+    static constexpr size_t kMaxBatch = 64;
+
+    explicit FleetLink(const FleetConfig& config)
+        : config_(config), pose_period_us_(config.pose_rate_hz > 0.0 ? static_cast<int64_t>(1e6 / config.pose_rate_hz) : 0) {}
+
+    bool start() {
+        if (!config_.enabled) return false;
+        socket_.setBlocking(false);
+        if (socket_.bind(static_cast<unsigned short>(config_.discovery_port)) != sf::Socket::Status::Done) {
+            std::cerr << "[WARNING] Fleet: cannot listen for lookout_hub on UDP port " << config_.discovery_port << std::endl;
+            return false;
+        }
+        name_ = config_.name;
+        if (name_.empty()) {
+            char computer[MAX_COMPUTERNAME_LENGTH + 1] = {};
+            DWORD size = sizeof(computer);
+            name_ = GetComputerName(computer, &size) ? computer : "station";
+        }
+        sender_id_ = std::random_device()();
+        refresh_config_hash();
+        active_ = true;
+        std::cout << "[INFO] Fleet: station \"" << name_ << "\" listening for lookout_hub on UDP port " << config_.discovery_port << std::endl;
+        return true;
+    }
+
+    bool active() const { return active_; }
+
+    // After settings.json is (re)loaded, so the hub sees what the station is running
+    void refresh_config_hash() {
+        std::ifstream in("settings.json", std::ios::binary);
+        const std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        hello_.config_hash = lookout_fleet_hash(bytes.data(), bytes.size());
+    }
+
+    // A snapshot from the hub, validated and saved, if one finished since the last call
+    std::shared_ptr<const Settings> take_settings() { return std::move(pushed_settings_); }
+
+    bool pose_due(int64_t engine_us) const { return hub_ && pose_period_us_ > 0 && engine_us >= next_pose_us_; }
+
+    // Every sample the core takes, evaluated or not
+    void on_sample(bool hmd_ok, bool warning) {
+        ++stats_.samples;
+        if (hmd_ok) ++stats_.hmd_ok_samples;
+        if (warning) ++stats_.warning_samples;
+    }
+
+    void on_pose(int64_t engine_us, double yaw_deg, double pitch_deg, const LeanOffset& lean) {
+        next_pose_us_ = engine_us + pose_period_us_;
+        if (poses_.size() >= kMaxBatch) return;
+        LookoutStreamSample s = {};
+        s.engine_us = engine_us;
+        s.yaw_cdeg = to_int16(yaw_deg * 100.0);
+        s.pitch_cdeg = to_int16(pitch_deg * 100.0);
+        s.lean_lateral_mm = lean.valid ? to_int16(lean.lateral_m * 1000.0) : 0;
+        s.lean_vertical_mm = lean.valid ? to_int16(lean.vertical_m * 1000.0) : 0;
+        poses_.push_back(s);
+    }
+
+    void on_warning(uint32_t alarm_id, int64_t engine_us) {
+        ++stats_.warnings;
+        add_event(FLEET_EVENT_WARNING, alarm_id, engine_us, 0);
+    }
+
+    void on_lookout(uint32_t alarm_id, int64_t engine_us) {
+        auto last = last_lookout_us_.find(alarm_id);
+        const int64_t since_us = engine_us - (last != last_lookout_us_.end() ? last->second : flight_start_us_);
+        last_lookout_us_[alarm_id] = engine_us;
+        const uint32_t interval_ms = static_cast<uint32_t>((std::max<int64_t>)(0, since_us) / 1000);
+        ++stats_.lookouts;
+        stats_.scan_interval_ms += interval_ms;
+        add_event(FLEET_EVENT_LOOKOUT, alarm_id, engine_us, interval_ms);
+    }
+
+    void on_flight(bool started, int64_t engine_us) {
+        if (started) {
+            flight_start_us_ = engine_us;
+            last_lookout_us_.clear();
+        }
+        add_event(started ? FLEET_EVENT_FLIGHT_START : FLEET_EVENT_FLIGHT_END, 0, engine_us, 0);
+    }
+
+    // Core loop, every iteration: hub announcements in, batches and summaries out
+    void poll(int64_t now_us, uint32_t flags, size_t alarm_count, size_t active_profile) {
+        hello_.flags = flags;
+        hello_.alarm_count = static_cast<uint16_t>(alarm_count);
+        hello_.active_profile = static_cast<uint16_t>(active_profile);
+        receive(now_us);
+        if (push_task_.valid() && push_task_.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            finish_push();
+        }
+        if (hub_ && now_us - last_announce_us_ > kHubTimeoutUs) {
+            std::cout << "[INFO] Fleet: lookout_hub at " << hub_->toString() << " stopped announcing itself" << std::endl;
+            hub_.reset();
+        }
+        if (now_us >= next_stats_us_) {
+            if (next_stats_us_ > 0 && hub_) {
+                send_hello();
+                stats_.minute = minute_;
+                send(FLEET_STATS, &stats_, 1, sizeof(stats_));
+            }
+            if (next_stats_us_ > 0) ++minute_;
+            stats_ = LookoutFleetStats();
+            next_stats_us_ = (now_us / kMinuteUs + 1) * kMinuteUs;
+        }
+        if (now_us >= next_flush_us_ || events_.size() >= kMaxBatch || poses_.size() >= kMaxBatch) {
+            next_flush_us_ = now_us + static_cast<int64_t>(config_.batch_s * 1e6);
+            if (hub_) {
+                if (!events_.empty()) send(FLEET_EVENTS, events_.data(), events_.size(), sizeof(LookoutFleetEvent));
+                if (!poses_.empty()) send(FLEET_POSE, poses_.data(), poses_.size(), sizeof(LookoutStreamSample));
+            }
+            events_.clear();
+            poses_.clear();
+        }
+    }
+
+    ~FleetLink() {
+        if (push_task_.valid()) push_task_.wait();
+        if (dropped_ > 0) std::cerr << "[WARNING] Fleet: dropped " << dropped_ << " datagram(s)" << std::endl;
+    }
+
+private:
+    static int16_t to_int16(double v) {
+        return static_cast<int16_t>(std::lround((std::max)(-32767.0, (std::min)(32767.0, v))));
+    }
+
+    void add_event(uint8_t type, uint32_t alarm_id, int64_t engine_us, uint32_t value_ms) {
+        if (events_.size() >= kMaxBatch) return; // Flushed on the next poll
+        LookoutFleetEvent e = {};
+        e.t_ms = static_cast<uint32_t>(engine_us / 1000);
+        e.alarm = static_cast<uint16_t>(alarm_id);
+        e.type = type;
+        e.value_ms = value_ms;
+        events_.push_back(e);
+    }
+
+    // Hub announcements, and settings chunks from the hub already reported to
+    void receive(int64_t now_us) {
+        std::array<uint8_t, sizeof(LookoutFleetHeader) + sizeof(LookoutFleetSettingsChunk) + LOOKOUT_FLEET_CHUNK_BYTES> data;
+        size_t received = 0;
+        std::optional<sf::IpAddress> sender;
+        unsigned short port = 0;
+        while (socket_.receive(data.data(), data.size(), received, sender, port) == sf::Socket::Status::Done) {
+            LookoutFleetHeader header;
+            if (!sender || received < sizeof(header)) continue;
+            std::memcpy(&header, data.data(), sizeof(header));
+            if (header.magic != LOOKOUT_FLEET_MAGIC || header.version != LOOKOUT_FLEET_VERSION || header.count < 1) continue;
+            if (header.type == FLEET_SETTINGS && hub_ && *hub_ == *sender) {
+                receive_settings_chunk(data.data() + sizeof(header), received - sizeof(header));
+                continue;
+            }
+            LookoutFleetAnnounce announce;
+            if (header.type != FLEET_ANNOUNCE || received < sizeof(header) + sizeof(announce)) continue;
+            std::memcpy(&announce, data.data() + sizeof(header), sizeof(announce));
+            last_announce_us_ = now_us;
+            if (hub_ && *hub_ == *sender && hub_port_ == announce.port) continue;
+            hub_ = *sender;
+            hub_port_ = announce.port;
+            std::cout << "[INFO] Fleet: reporting to lookout_hub at " << hub_->toString() << ":" << hub_port_ << std::endl;
+            send_hello();
+        }
+    }
+
+    void receive_settings_chunk(const uint8_t* payload, size_t size) {
+        LookoutFleetSettingsChunk chunk;
+        if (size < sizeof(chunk)) return;
+        std::memcpy(&chunk, payload, sizeof(chunk));
+        if (chunk.bytes > LOOKOUT_FLEET_CHUNK_BYTES || size < sizeof(chunk) + chunk.bytes ||
+            chunk.total_bytes == 0 || chunk.total_bytes > LOOKOUT_FLEET_MAX_SETTINGS_BYTES ||
+            chunk.offset % LOOKOUT_FLEET_CHUNK_BYTES != 0 || chunk.offset + chunk.bytes > chunk.total_bytes) {
+            return;
+        }
+        if (chunk.hash == hello_.config_hash) {
+            // Already running it; the hub resends until it hears so
+            if (!push_task_.valid() && chunk.offset == 0) send_settings_ack(chunk.version, FLEET_SETTINGS_APPLIED);
+            return;
+        }
+        if (!config_.accept_settings) {
+            // Refused once per version; the hub doesn't resend a rejected one
+            if (chunk.version != refused_version_) {
+                refused_version_ = chunk.version;
+                std::cout << "[INFO] Fleet: refusing settings snapshot " << chunk.version
+                          << " from lookout_hub (fleet.accept_settings is off)" << std::endl;
+                send_settings_ack(chunk.version, FLEET_SETTINGS_REJECTED);
+            }
+            return;
+        }
+        if (push_task_.valid()) return; // Still saving the last one; the hub will resend
+        if (chunk.version != push_version_ || chunk.hash != push_hash_ || chunk.total_bytes != push_bytes_.size()) {
+            push_version_ = chunk.version;
+            push_hash_ = chunk.hash;
+            push_bytes_.assign(chunk.total_bytes, '\0');
+            push_have_.assign((chunk.total_bytes + LOOKOUT_FLEET_CHUNK_BYTES - 1) / LOOKOUT_FLEET_CHUNK_BYTES, false);
+            push_missing_ = push_have_.size();
+        }
+        const size_t index = chunk.offset / LOOKOUT_FLEET_CHUNK_BYTES;
+        if (push_have_[index]) return;
+        std::memcpy(&push_bytes_[chunk.offset], payload + sizeof(chunk), chunk.bytes);
+        push_have_[index] = true;
+        if (--push_missing_ > 0) return;
+        if (lookout_fleet_hash(push_bytes_.data(), push_bytes_.size()) != push_hash_) {
+            std::cerr << "[WARNING] Fleet: settings snapshot " << push_version_ << " from lookout_hub failed its hash check" << std::endl;
+            push_version_ = 0;
+            return;
+        }
+        push_task_ = std::async(std::launch::async, save_pushed_settings, std::move(push_bytes_));
+        push_bytes_.clear();
+    }
+
+    struct PushResult {
+        std::shared_ptr<const Settings> settings; // Null when rejected
+        std::string error;
+    };
+
+    // Off the core thread: validate the snapshot like a settings_gui push, then replace
+    // settings.json in one rename so the file watch never sees it half written
+    static PushResult save_pushed_settings(std::string bytes) {
+        PushResult result;
+        nlohmann::json document;
+        std::istringstream in(bytes);
+        if (!parse_settings_document(in, document, result.error)) return result;
+        std::vector<std::string> errors = validate_settings_document(document);
+        if (!errors.empty()) {
+            result.error = std::to_string(errors.size()) + " problem(s): " + errors.front();
+            return result;
+        }
+        const nlohmann::json local = read_settings_json("settings.json");
+        auto changes = [&](const char* key) {
+            return json_fingerprint(document.value(key, nlohmann::json())) != json_fingerprint(local.value(key, nlohmann::json()));
+        };
+        const char* changed = nullptr;
+        for (const char* key : RESTART_ONLY_SETTINGS) {
+            if (!changed && changes(key)) changed = key;
+        }
+        for (const char* key : FLEET_LOCAL_SETTINGS) {
+            if (!changed && changes(key)) changed = key;
+        }
+        if (changed) {
+            result.error = "it changes \"" + std::string(changed) + "\", which only this station's own settings.json may set";
+            return result;
+        }
+        {
+            std::ofstream out("settings.json.fleet", std::ios::binary | std::ios::trunc);
+            out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            if (!out) {
+                result.error = "could not write settings.json.fleet";
+                return result;
+            }
+        }
+        if (!MoveFileExA("settings.json.fleet", "settings.json", MOVEFILE_REPLACE_EXISTING)) {
+            result.error = "could not replace settings.json (error " + std::to_string(GetLastError()) + ")";
+            return result;
+        }
+        result.settings = settings_from_document(document);
+        return result;
+    }
+
+    void finish_push() {
+        PushResult result = push_task_.get();
+        if (result.settings) {
+            std::cout << "[INFO] Fleet: saved settings snapshot " << push_version_ << " from lookout_hub" << std::endl;
+            hello_.config_version = push_version_;
+            hello_.config_hash = push_hash_;
+            pushed_settings_ = std::move(result.settings);
+        } else {
+            std::cerr << "[WARNING] Fleet: rejected settings snapshot " << push_version_ << " from lookout_hub: " << result.error << std::endl;
+        }
+        if (hub_) send_settings_ack(push_version_, result.settings ? FLEET_SETTINGS_APPLIED : FLEET_SETTINGS_REJECTED);
+        push_version_ = 0;
+    }
+
+    void send_settings_ack(uint32_t version, uint8_t status) {
+        LookoutFleetSettingsAck ack = {};
+        ack.version = version;
+        ack.hash = hello_.config_hash;
+        ack.status = status;
+        send(FLEET_SETTINGS_ACK, &ack, 1, sizeof(ack));
+    }
+
+    void send_hello() {
+        std::memset(hello_.name, 0, sizeof(hello_.name));
+        std::memcpy(hello_.name, name_.data(), (std::min)(name_.size(), sizeof(hello_.name) - 1));
+        send(FLEET_HELLO, &hello_, 1, sizeof(hello_));
+    }
+
+    void send(uint8_t type, const void* entries, size_t count, size_t entry_size) {
+        LookoutFleetHeader header = {};
+        header.magic = LOOKOUT_FLEET_MAGIC;
+        header.version = LOOKOUT_FLEET_VERSION;
+        header.type = type;
+        header.count = static_cast<uint8_t>(count);
+        header.sender_id = sender_id_;
+        header.sequence = sequence_++;
+        if (count > kMaxBatch || count * entry_size > datagram_.size() - sizeof(header)) {
+            ++dropped_; // Callers batch at most kMaxBatch of one entry type
+            return;
+        }
+        std::memcpy(datagram_.data(), &header, sizeof(header));
+        std::memcpy(datagram_.data() + sizeof(header), entries, count * entry_size);
+        if (socket_.send(datagram_.data(), sizeof(header) + count * entry_size, *hub_, hub_port_) != sf::Socket::Status::Done) {
+            ++dropped_;
+        }
+    }
+
+    const FleetConfig config_;
+    const int64_t pose_period_us_;
+    sf::UdpSocket socket_;
+    bool active_ = false;
+    std::string name_;
+    uint32_t sender_id_ = 0;
+    uint32_t sequence_ = 0;
+    std::optional<sf::IpAddress> hub_;
+    unsigned short hub_port_ = 0;
+    int64_t last_announce_us_ = 0;
+    int64_t next_stats_us_ = 0, next_flush_us_ = 0, next_pose_us_ = 0;
+    uint32_t minute_ = 0;
+    int64_t flight_start_us_ = 0;
+    std::unordered_map<uint32_t, int64_t> last_lookout_us_; // Per alarm id, this flight
+    LookoutFleetHello hello_ = {};
+    LookoutFleetStats stats_ = {};
+    std::vector<LookoutFleetEvent> events_;
+    std::vector<LookoutStreamSample> poses_;
+    uint32_t push_version_ = 0, push_hash_ = 0;  // Snapshot being reassembled
+    uint32_t refused_version_ = 0;               // Last one refused without accept_settings
+    std::string push_bytes_;
+    std::vector<bool> push_have_;                // Per chunk
+    size_t push_missing_ = 0;
+    std::future<PushResult> push_task_;
+    std::shared_ptr<const Settings> pushed_settings_;
+    uint64_t dropped_ = 0;
+    // Room for a full batch of the largest entry type sent
+    static constexpr size_t kMaxEntryBytes = (std::max)({ sizeof(LookoutFleetEvent), sizeof(LookoutStreamSample),
+                                                          sizeof(LookoutFleetStats), sizeof(LookoutFleetHello),
+                                                          sizeof(LookoutFleetSettingsAck) });
+    std::array<uint8_t, sizeof(LookoutFleetHeader) + kMaxBatch * kMaxEntryBytes> datagram_{};
+};
+
+// Records every headset sample to a pose trace file (lookout_trace.hpp layout). The
+// sampler writes each record straight into a mapped view of the file, one chunk at a
+// time; the core thread grows the file and maps the next chunk well before the current
+// one fills, and unmaps the ones left behind, so recording costs the sampler a 64-byte
+// store. If the core hasn't caught up when a chunk fills, samples are dropped and
+// counted rather than waited for. The core's markers (warnings, lookouts, flight start
+// and end) are kept in memory, up to kMaxMarkers (later ones are counted), and written
+// after the last record when the trace closes.
+class PoseTraceRecorder {
+public:
+    static constexpr size_t kMaxMarkers = 1 << 18; // 4 MiB; days of warnings and lookouts
+
+    explicit PoseTraceRecorder(const PoseTraceConfig& config)
+        : config_(config), chunk_bytes_(static_cast<uint64_t>(config.chunk_mb) * 1024 * 1024),
+          chunk_records_(static_cast<size_t>(chunk_bytes_ / sizeof(PoseTraceRecord))) {}
+    ~PoseTraceRecorder() { close(); }
+    PoseTraceRecorder(const PoseTraceRecorder&) = delete;
+    PoseTraceRecorder& operator=(const PoseTraceRecorder&) = delete;
+
+    // Before the pose source starts: creates the file with its first chunk and a spare
+    bool open(int64_t core_now_us) {
+        if (!config_.enabled) return false;
+        CreateDirectoryA(config_.directory.c_str(), nullptr); // Fails harmlessly when it exists
+        std::time_t now = std::time(nullptr);
+        std::tm local = {};
+        localtime_s(&local, &now);
+        char stamp[32];
+        std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", &local);
+        path_ = config_.directory + "\\pose_trace_" + stamp + ".qlpt";
+        file_ = CreateFileA(path_.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+        PoseTraceRecord* first = file_ != INVALID_HANDLE_VALUE ? map_chunk(0) : nullptr;
+        if (!first) {
+            std::cerr << "[WARNING] Could not create pose trace " << path_ << " (error " << GetLastError() << ")" << std::endl;
+            close();
+            return false;
+        }
+        // The header takes the first record slot, so records never straddle two chunks
+        static_assert(sizeof(PoseTraceHeader) == sizeof(PoseTraceRecord), "The header fills one record slot");
+        auto* header = reinterpret_cast<PoseTraceHeader*>(first);
+        header->magic = POSE_TRACE_MAGIC;
+        header->version = POSE_TRACE_VERSION;
+        header->record_size = sizeof(PoseTraceRecord);
+        header->start_unix_s = static_cast<int64_t>(now);
+        header->start_us = core_now_us;
+        current_ = first;
+        current_used_ = 1;
+        chunks_mapped_ = 1;
+        maintain();
+        std::cout << "[INFO] Recording pose trace to " << path_ << std::endl;
+        return true;
+    }
+
+    bool active() const { return current_ != nullptr; }
+
+    // Core thread, t_us on the records' clock
+    void mark(int64_t t_us, PoseTraceMarkerType type, uint32_t value = 0) {
+        if (!current_) return;
+        PoseTraceMarker m = {};
+        m.t_us = t_us;
+        m.type = type;
+        m.value = value;
+        if (markers_.size() < kMaxMarkers) markers_.push_back(m);
+        else ++markers_dropped_;
+    }
+
+    // Sampler thread
+    void record(const PoseTraceRecord& record) {
+        if (current_used_ == chunk_records_) {
+            PoseTraceRecord* next = spare_.exchange(nullptr, std::memory_order_acquire);
+            if (!next) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            // The core unmaps the full one; one still waiting there (a core stalled for
+            // a whole chunk) is released here instead
+            if (PoseTraceRecord* stale = retired_.exchange(current_, std::memory_order_acq_rel)) UnmapViewOfFile(stale);
+            current_ = next;
+            current_used_ = 0;
+        }
+        current_[current_used_++] = record;
+        recorded_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Core thread, every loop pass: keep the next chunk mapped ahead of the sampler
+    void maintain() {
+        if (file_ == INVALID_HANDLE_VALUE || map_failed_) return;
+        if (PoseTraceRecord* full = retired_.exchange(nullptr, std::memory_order_acquire)) UnmapViewOfFile(full);
+        if (spare_.load(std::memory_order_acquire)) return;
+        PoseTraceRecord* next = map_chunk(chunks_mapped_);
+        if (!next) {
+            // Disk full, most likely: keep what fits and drop the rest
+            std::cerr << "[WARNING] Could not extend pose trace " << path_ << " (error " << GetLastError()
+                      << "); recording stops when the current chunk fills" << std::endl;
+            map_failed_ = true;
+            return;
+        }
+        ++chunks_mapped_;
+        spare_.store(next, std::memory_order_release);
+    }
+
+    // After the pose source stopped: trims the file to the records written and fills in the count
+    void close() {
+        if (file_ == INVALID_HANDLE_VALUE) return;
+        for (PoseTraceRecord* view : { current_, spare_.exchange(nullptr), retired_.exchange(nullptr) }) {
+            if (view) UnmapViewOfFile(view);
+        }
+        current_ = nullptr;
+        const uint64_t records = recorded_.load();
+        LARGE_INTEGER end;
+        end.QuadPart = static_cast<LONGLONG>((records + 1) * sizeof(PoseTraceRecord));
+        SetFilePointerEx(file_, end, nullptr, FILE_BEGIN);
+        SetEndOfFile(file_);
+        DWORD written = 0;
+        WriteFile(file_, markers_.data(), static_cast<DWORD>(markers_.size() * sizeof(PoseTraceMarker)), &written, nullptr);
+        LARGE_INTEGER count_at;
+        count_at.QuadPart = offsetof(PoseTraceHeader, record_count);
+        SetFilePointerEx(file_, count_at, nullptr, FILE_BEGIN);
+        WriteFile(file_, &records, sizeof(records), &written, nullptr);
+        const uint64_t marker_count = markers_.size();
+        count_at.QuadPart = offsetof(PoseTraceHeader, marker_count);
+        SetFilePointerEx(file_, count_at, nullptr, FILE_BEGIN);
+        WriteFile(file_, &marker_count, sizeof(marker_count), &written, nullptr);
+        CloseHandle(file_);
+        file_ = INVALID_HANDLE_VALUE;
+        std::cout << "[INFO] Pose trace " << path_ << ": " << records << " samples, " << markers_.size() << " markers";
+        const uint64_t dropped = dropped_.load();
+        if (dropped) std::cout << ", " << dropped << " dropped while the file was extended";
+        if (markers_dropped_) std::cout << ", " << markers_dropped_ << " markers past the first " << kMaxMarkers << " not kept";
+        std::cout << std::endl;
+        if (config_.archive && records) archive();
+    }
+
+private:
+    // Streams the raw trace into a pose archive next to it and deletes it once that's complete
+    void archive() {
+        std::ifstream raw(path_, std::ios::binary);
+        PoseTraceHeader header = {};
+        raw.read(reinterpret_cast<char*>(&header), sizeof(header));
+        const std::string archive_path = path_.substr(0, path_.size() - 5) + ".qlpz";
+        PoseArchiveWriter writer;
+        if (!raw || !writer.open(archive_path, header.start_unix_s, header.start_us)) {
+            std::cerr << "[WARNING] Could not create pose archive " << archive_path << "; the raw trace is kept" << std::endl;
+            return;
+        }
+        writer.add_markers(markers_.data(), markers_.size());
+        std::vector<PoseTraceRecord> records(POSE_ARCHIVE_BLOCK_RECORDS);
+        for (uint64_t left = header.record_count; left > 0;) {
+            const size_t want = static_cast<size_t>((std::min<uint64_t>)(left, records.size()));
+            if (!raw.read(reinterpret_cast<char*>(records.data()), want * sizeof(PoseTraceRecord))) break;
+            for (size_t i = 0; i < want; ++i) writer.add(records[i]);
+            left -= want;
+        }
+        raw.close();
+        if (!writer.finish() || writer.records() != header.record_count) {
+            std::cerr << "[WARNING] Could not write pose archive " << archive_path << "; the raw trace is kept" << std::endl;
+            DeleteFileA(archive_path.c_str());
+            return;
+        }
+        DeleteFileA(path_.c_str());
+        std::cout << std::fixed << std::setprecision(2) << "[INFO] Pose trace archived to " << archive_path << " ("
+                  << writer.bytes() / (1024.0 * 1024.0) << " MiB, "
+                  << static_cast<double>(writer.bytes()) / writer.records() << " bytes per sample)" << std::endl;
+    }
+
+    // Sets the file size to cover the chunk and maps it; the mapping handle can go at
+    // once, the view keeps the section alive
+    PoseTraceRecord* map_chunk(uint64_t index) {
+        const uint64_t size = (index + 1) * chunk_bytes_;
+        HANDLE mapping = CreateFileMappingA(file_, nullptr, PAGE_READWRITE, static_cast<DWORD>(size >> 32),
+                                            static_cast<DWORD>(size), nullptr);
+        if (!mapping) return nullptr;
+        const uint64_t offset = index * chunk_bytes_;
+        void* view = MapViewOfFile(mapping, FILE_MAP_WRITE, static_cast<DWORD>(offset >> 32), static_cast<DWORD>(offset),
+                                   static_cast<size_t>(chunk_bytes_));
+        CloseHandle(mapping);
+        return static_cast<PoseTraceRecord*>(view);
+    }
+
+    const PoseTraceConfig config_;
+    const uint64_t chunk_bytes_;
+    const size_t chunk_records_;
+    std::string path_;
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    uint64_t chunks_mapped_ = 0;       // Core thread
+    bool map_failed_ = false;
+    PoseTraceRecord* current_ = nullptr; // Sampler thread once open
+    size_t current_used_ = 0;
+    std::atomic<PoseTraceRecord*> spare_{nullptr};   // Next chunk, mapped by the core
+    std::atomic<PoseTraceRecord*> retired_{nullptr}; // Full chunk, for the core to unmap
+    std::atomic<uint64_t> recorded_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::vector<PoseTraceMarker> markers_; // Core thread
+    uint64_t markers_dropped_ = 0;
+};
+
+// Set while a trace is recording; the pose sources' sampler threads record into it
+std::atomic<PoseTraceRecorder*> g_pose_trace{nullptr};
+
+void trace_pose(int64_t t_us, const ovrPosef& pose, const ovrVector3f& angular_velocity, uint32_t status_flags,
+                uint32_t session_flags, uint32_t pose_flags) {
+    PoseTraceRecorder* trace = g_pose_trace.load(std::memory_order_acquire);
+    if (!trace) return;
+    PoseTraceRecord r = {};
+    r.t_us = t_us;
+    r.orientation[0] = pose.Orientation.x;
+    r.orientation[1] = pose.Orientation.y;
+    r.orientation[2] = pose.Orientation.z;
+    r.orientation[3] = pose.Orientation.w;
+    r.position[0] = pose.Position.x;
+    r.position[1] = pose.Position.y;
+    r.position[2] = pose.Position.z;
+    r.angular_velocity[0] = angular_velocity.x;
+    r.angular_velocity[1] = angular_velocity.y;
+    r.angular_velocity[2] = angular_velocity.z;
+    r.status_flags = status_flags;
+    r.session_flags = session_flags;
+    r.pose_flags = pose_flags;
+    trace->record(r);
+}
+
+// Act on pending RecenterRequest bits using the current head pose, clearing the ones
+// applied. Called by whichever thread samples the headset, with the requests taken from
+// g_pending_recenter; true when the reference transform changed.
+bool apply_pending_recenter(uint32_t& requests, const ovrPosef& pose, bool orientation_tracked, bool position_tracked) {
+    if (!orientation_tracked || requests == 0) return false;
+    bool changed = false;
+
+    // Handle baseline reference reset request
+    if (requests & RECENTER_BASELINE_RESET) {
+        g_baseline_reference = pose.Orientation;
+        g_has_baseline_reference = true;
+        if (position_tracked) {
+            g_baseline_position = pose.Position;
+            g_baseline_position_orientation = pose.Orientation;
+            g_has_baseline_position = true;
+        }
+        requests &= ~RECENTER_BASELINE_RESET;
+        rebuild_reference_transform();
+        changed = true;
+        std::cout << "[INFO] Baseline reference captured - new forward direction set" << std::endl;
+    }
+    
+    // Handle software recenter request
+    if (requests & RECENTER_SOFTWARE) {
+        // Calculate current yaw (rotation around Y axis)
+        ovrQuatf currentOrientation = pose.Orientation;
+        
+        // Extract yaw from quaternion (simplified for Y-axis rotation)
+        float currentYaw = atan2(2.0f * (currentOrientation.w * currentOrientation.y + currentOrientation.x * currentOrientation.z),
+                               1.0f - 2.0f * (currentOrientation.y * currentOrientation.y + currentOrientation.z * currentOrientation.z));
+        
+        // Create offset quaternion to counter current yaw
+        g_recenter_offset.x = 0;
+        g_recenter_offset.y = sin(-currentYaw / 2.0f);
+        g_recenter_offset.z = 0;
+        g_recenter_offset.w = cos(-currentYaw / 2.0f);
+        
+        std::cout << "[INFO] Manual software recenter applied - yaw offset: " << (-currentYaw * 180.0f / M_PI) << " degrees" << std::endl;
+        g_has_manual_recenter_offset = true;
+        requests &= ~RECENTER_SOFTWARE;
+        if (position_tracked) {
+            g_baseline_position = pose.Position;
+            g_baseline_position_orientation = pose.Orientation;
+            g_has_baseline_position = true;
+        }
+        rebuild_reference_transform();
+        changed = true;
+    }
+    return changed;
+}
+
+// Streaming quantile estimate in constant memory: the P-square algorithm (Jain and
+// Chlamtac, 1985). Five markers track the minimum, p/2, p, (1+p)/2 and the maximum;
+// each sample moves the markers' positions, and a marker that drifts from where it
+// should be is nudged by piecewise-parabolic interpolation of its neighbours.
+class P2Quantile {
+public:
+    explicit P2Quantile(double p = 0.5) : p_(p) { reset(); }
+
+    void reset() {
+        count_ = 0;
+        const double increments[5] = { 0.0, p_ / 2.0, p_, (1.0 + p_) / 2.0, 1.0 };
+        for (int i = 0; i < 5; ++i) {
+            position_[i] = i + 1;
+            desired_[i] = 1.0 + 4.0 * increments[i];
+            increment_[i] = increments[i];
+        }
+    }
+
+    void add(double x) {
+        if (count_ < 5) {
+            height_[count_++] = x;
+            if (count_ == 5) std::sort(height_, height_ + 5);
+            return;
+        }
+        ++count_;
+        int k;
+        if (x < height_[0]) {
+            height_[0] = x;
+            k = 0;
+        } else if (x >= height_[4]) {
+            height_[4] = x;
+            k = 3;
+        } else {
+            k = 0;
+            while (x >= height_[k + 1]) ++k;
+        }
+        for (int i = k + 1; i < 5; ++i) ++position_[i];
+        for (int i = 0; i < 5; ++i) desired_[i] += increment_[i];
+        for (int i = 1; i < 4; ++i) {
+            const double d = desired_[i] - position_[i];
+            if ((d >= 1.0 && position_[i + 1] - position_[i] > 1) || (d <= -1.0 && position_[i - 1] - position_[i] < -1)) {
+                const int s = d > 0.0 ? 1 : -1;
+                const double parabolic = height_[i] + static_cast<double>(s) / (position_[i + 1] - position_[i - 1]) *
+                    ((position_[i] - position_[i - 1] + s) * (height_[i + 1] - height_[i]) / (position_[i + 1] - position_[i]) +
+                     (position_[i + 1] - position_[i] - s) * (height_[i] - height_[i - 1]) / (position_[i] - position_[i - 1]));
+                if (height_[i - 1] < parabolic && parabolic < height_[i + 1]) {
+                    height_[i] = parabolic;
+                } else {
+                    height_[i] += s * (height_[i + s] - height_[i]) / (position_[i + s] - position_[i]);
+                }
+                position_[i] += s;
+            }
+        }
+    }
+
+    uint64_t count() const { return count_; }
+
+    // The estimate; exact (nearest rank) over the first five samples, 0 with none
+    double value() const {
+        if (count_ >= 5) return height_[2];
+        if (count_ == 0) return 0.0;
+        double first[5];
+        std::copy(height_, height_ + count_, first);
+        std::sort(first, first + count_);
+        return first[static_cast<size_t>(p_ * (count_ - 1) + 0.5)];
+    }
+
+private:
+    double p_;
+    uint64_t count_ = 0;
+    double height_[5] = {};
+    int64_t position_[5] = {};
+    double desired_[5] = {}, increment_[5] = {};
+};
+
+// sampling.drift_correction: over a long flight the headset's yaw drifts, or the pilot
+// settles differently in the seat, and yaw 0 stops being where they look when not scanning,
+// which skews the left/right thresholds until someone recenters. This estimates the
+// neutral forward yaw as the median of slow samples near forward, one drift_estimate_s
+// period at a time, and turns the reference transform toward it by at most
+// drift_max_rate_deg_per_min, never more than drift_max_deg in all. A recenter starts
+// over from no correction. Sampling thread only.
+class YawDriftCorrector {
+public:
+    static constexpr double kNeutralSpeedDegS = 30.0; // Faster samples are part of a scan
+    static constexpr uint64_t kMinSamples = 200;      // Per estimate, else it's discarded
+    static constexpr double kDeadbandDeg = 0.5;       // Offsets this small are left alone
+    static constexpr int64_t kApplyIntervalUs = 1000000;
+
+    explicit YawDriftCorrector(const SamplingConfig& sampling) : sampling_(sampling) {}
+
+    // Back to no correction and a fresh estimate, as after a recenter
+    void restart() {
+        median_.reset();
+        estimate_start_us_ = last_apply_us_ = 0;
+        target_deg_ = 0.0;
+        if (g_drift_correction_deg != 0.0) {
+            g_drift_correction_deg = 0.0;
+            rebuild_reference_transform();
+        }
+    }
+
+    // A tracked sample, its look already through the reference transform
+    void add(const PoseSample& sample) {
+        if (!sampling_.drift_correction) return;
+        if (estimate_start_us_ == 0) estimate_start_us_ = last_apply_us_ = sample.t_us;
+        double yaw_deg = 0.0, pitch_deg = 0.0;
+        look_vector_to_yaw_pitch(sample.look, yaw_deg, pitch_deg);
+        if (std::abs(yaw_deg) <= sampling_.drift_window_deg && sample.angular_speed_deg_s <= kNeutralSpeedDegS) {
+            median_.add(yaw_deg - g_drift_correction_deg); // Without the correction, so it doesn't chase itself
+        }
+        if (sample.t_us - estimate_start_us_ >= static_cast<int64_t>(sampling_.drift_estimate_s * 1e6)) {
+            finish_estimate();
+            estimate_start_us_ = sample.t_us;
+        }
+        if (sample.t_us - last_apply_us_ >= kApplyIntervalUs) {
+            // Capped, so resuming after an idle sampler doesn't turn a gap into one big step
+            step_toward_target((std::min)((sample.t_us - last_apply_us_) / 1e6, 2.0 * kApplyIntervalUs / 1e6));
+            last_apply_us_ = sample.t_us;
+        }
+    }
+
+private:
+    void finish_estimate() {
+        if (median_.count() >= kMinSamples) {
+            const double next = (std::max)(-sampling_.drift_max_deg, (std::min)(sampling_.drift_max_deg, -median_.value()));
+            if (std::abs(next - target_deg_) >= kDeadbandDeg) {
+                std::cout << "[INFO] Neutral forward yaw at " << std::fixed << std::setprecision(1) << median_.value()
+                          << " deg; correcting to " << next << " deg" << std::defaultfloat << std::endl;
+                target_deg_ = next;
+            }
+        }
+        median_.reset();
+    }
+
+    void step_toward_target(double elapsed_s) {
+        const double remaining = target_deg_ - g_drift_correction_deg;
+        if (remaining == 0.0) return;
+        const double limit = sampling_.drift_max_rate_deg_per_min * elapsed_s / 60.0;
+        g_drift_correction_deg += (std::max)(-limit, (std::min)(limit, remaining));
+        rebuild_reference_transform();
+    }
+
+    const SamplingConfig& sampling_;
+    P2Quantile median_;
+    int64_t estimate_start_us_ = 0, last_apply_us_ = 0;
+    double target_deg_ = 0.0;
+};
+
+// The compositor's view of rendering (ovr_GetPerfStats), so missed lookouts can be set
+// against the sim dropping frames or ASW kicking in. Frame counters are cumulative since
+// the sampler connected. The app-side fields (app latency, app dropped frames) aren't
+// kept: the runtime only fills them in for the calling process, which never renders.
+struct RenderPerf {
+    int64_t t_us = 0;                     // Core clock of the poll; 0 before the first
+    uint32_t compositor_dropped_frames = 0;
+    uint32_t asw_presented_frames = 0;    // Frames ASW synthesized
+    uint32_t asw_toggles = 0;
+    float compositor_latency_ms = 0.0f;   // Compositor start to scan-out, latest frame
+    float gpu_scale = 1.0f;               // AdaptiveGpuPerformanceScale: below 1, the GPU can't keep up
+    uint8_t asw_active = 0;
+    uint8_t asw_available = 0;
+};
+
+// Something else submitting to the Oculus session (the scan overlay). Told, on whichever
+// thread does it, before the session is destroyed and once a new one is created, so it
+// never outlives the session it was given.
+class OvrSessionUser {
+public:
+    virtual ~OvrSessionUser() = default;
+    virtual void session_ready(ovrSession session) = 0;
+    virtual void session_ending() = 0;
+};
+
+// Owns all per-sample OVR work (session status, tracking state, recenter handling and
+// session recovery) on a dedicated thread, so slow logging or audio calls on the
+// evaluator can't leave holes in the tracking data. The session is only touched
+// from this thread while it runs, apart from an OvrSessionUser it's handed to.
+class PoseSampler {
+public:
+    static constexpr size_t kRingCapacity = 1024;
+
+    PoseSampler(std::atomic<ovrSession>& session, std::atomic<OvrSessionUser*>& session_user, const SamplingConfig& sampling,
+                const WatchdogConfig& watchdog_config, int64_t clock_epoch_us)
+        : session_(session), session_user_(session_user), sampling_(sampling), watchdog_("sampler", watchdog_config), clock_epoch_us_(clock_epoch_us) {}
+
+    ~PoseSampler() { stop(); }
+
+    void start() { thread_ = std::thread(&PoseSampler::run, this); }
+
+    void stop() {
+        stop_requested_.store(true);
+        if (g_sampler_wake_event) SetEvent(g_sampler_wake_event);
+        if (thread_.joinable()) thread_.join();
+    }
+
+    // Sampling only runs while a flight is active; otherwise the thread makes no OVR calls
+    void set_active(bool active) {
+        active_.store(active);
+        if (g_sampler_wake_event) SetEvent(g_sampler_wake_event);
+    }
+
+    size_t drain(PoseSample* out, size_t max_samples) { return ring_.pop_batch(out, max_samples); }
+
+    // Samples lost because the evaluator fell a full ring behind
+    uint64_t dropped_samples() const { return dropped_.load(std::memory_order_relaxed); }
+    // Polls that returned the pose already published, so the runtime had nothing new
+    uint64_t duplicate_samples() const { return duplicates_.load(std::memory_order_relaxed); }
+
+    // Latest perf stats poll, from any thread
+    RenderPerf render_perf() const { return perf_.load(); }
+
+private:
+    // At sampling.perf_stats_hz while the headset is worn. The runtime counts frames from
+    // its last ovr_ResetPerfStats, so the counters are reset once per session and kept here.
+    void poll_perf_stats(int64_t now_us) {
+        ovrPerfStats stats;
+        if (OVR_FAILURE(ovr_GetPerfStats(session_, &stats)) || stats.FrameStatsCount <= 0) return;
+        RenderPerf perf = perf_.load();
+        perf.t_us = now_us;
+        // FrameStats[0] is the newest frame; the counters in it cover every frame before
+        const ovrPerfStatsPerCompositorFrame& frame = stats.FrameStats[0];
+        perf.compositor_dropped_frames = static_cast<uint32_t>((std::max)(0, frame.CompositorDroppedFrameCount));
+        perf.asw_presented_frames = static_cast<uint32_t>((std::max)(0, frame.AswPresentedFrameCount));
+        perf.asw_toggles = static_cast<uint32_t>((std::max)(0, frame.AswActivatedToggleCount));
+        perf.compositor_latency_ms = frame.CompositorLatency * 1000.0f;
+        perf.gpu_scale = stats.AdaptiveGpuPerformanceScale;
+        perf.asw_active = frame.AswIsActive ? 1 : 0;
+        perf.asw_available = stats.AswIsAvailable ? 1 : 0;
+        perf_.store(perf);
+    }
+
+    void publish(const PoseSample& sample) {
+        if (!ring_.try_push(sample)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (g_core_wake_event) SetEvent(g_core_wake_event); // Evaluator only, not our own idle waits
+    }
+
+    static void trace(const PoseSample& sample, const ovrTrackingState& ts, const ovrSessionStatus& status) {
+        uint32_t session_flags = (status.HmdPresent ? TRACE_HMD_PRESENT : 0u) | (status.HmdMounted ? TRACE_HMD_MOUNTED : 0u) |
+                                 (status.DisplayLost ? TRACE_DISPLAY_LOST : 0u) |
+                                 (status.ShouldRecenter ? TRACE_SHOULD_RECENTER : 0u);
+        trace_pose(sample.t_us, ts.HeadPose.ThePose, ts.HeadPose.AngularVelocity, ts.StatusFlags, session_flags, sample.flags);
+    }
+
+    void run() {
+        ThreadCpuScope cpu_scope(CPU_SAMPLER);
+        HighResolutionTimer timer;
+        TickScheduler scheduler(timer, sampling_.adaptive ? 1.0 / sampling_.max_rate_hz : POLL_INTERVAL);
+        bool last_should_recenter = false;
+        uint32_t recenter_requests = 0; // RecenterRequest bits waiting for a tracked pose
+        bool reference_changed = false; // Flagged on the next published sample
+        YawDriftCorrector drift(sampling_);
+        bool in_burst = false;
+        int64_t burst_release_us = 0;
+        double burst_peak_left_deg = 0.0, burst_peak_right_deg = 0.0;
+        int64_t last_sample_t_us = 0;
+        double last_pose_time_s = 0.0; // HeadPose.TimeInSeconds of the last published tracked pose
+        // Session recovery is a state stepped once per loop pass rather than a blocking
+        // retry: while reconnecting, the thread only waits (interruptibly) for the next
+        // attempt, so stop and set_active take effect at once, and sampling resumes on
+        // the pass whose ovr_Create succeeds.
+        bool reconnecting = false;
+        int64_t next_reconnect_us = 0;
+        int64_t disconnected_since_us = 0;
+        RetryBackoff reconnect_backoff(ms_to_us(100), ms_to_us(2000));
+        // Mount, display-lost and recenter flags change at human speed, so the session
+        // status is polled on its own slower cadence and tracking ticks in between reuse
+        // it; at a 200-1000 Hz tracking rate that drops most of the OVR calls per tick.
+        // A status that is stale (after activation, reconnect or off-head) is read at once.
+        ovrSessionStatus sessionStatus = {};
+        ovrResult session_status_result = ovrSuccess;
+        bool session_status_valid = false;
+        int64_t next_status_us = 0;
+        const int64_t status_period_us = static_cast<int64_t>(1e6 / sampling_.session_status_hz);
+        ovrSession perf_session = nullptr; // Session whose perf counters were reset
+        int64_t next_perf_us = 0;
+        const int64_t perf_period_us = sampling_.perf_stats_hz > 0.0 ? static_cast<int64_t>(1e6 / sampling_.perf_stats_hz) : 0;
+        MmcssRegistration mmcss(sampling_.mmcss_task, sampling_.mmcss_priority);
+
+        while (!stop_requested_.load() && !shutdown_requested()) {
+            if (!active_.load()) {
+                session_status_valid = false;
+                scheduler.idle_wait(LOG_CHECK_INTERVAL, g_sampler_wake_event);
+                continue;
+            }
+
+            int64_t now_us = monotonic_now_us() - clock_epoch_us_;
+            watchdog_.begin_tick(now_us);
+
+            if (reconnecting) {
+                if (now_us >= next_reconnect_us) {
+                    ovrGraphicsLuid luid;
+                    ovrSession session = nullptr;
+                    if (OVR_SUCCESS(ovr_Create(&session, &luid))) {
+                        session_ = session;
+                        reconnecting = false;
+                        session_status_valid = false;
+                        std::cout << "[INFO] HMD session restored successfully! (" << reconnect_backoff.attempts() + 1
+                                  << " attempts, " << (now_us - disconnected_since_us) / 1000 << " ms)" << std::endl;
+                        reconnect_backoff.reset();
+                        if (OvrSessionUser* user = session_user_.load()) user->session_ready(session);
+                    } else {
+                        if (reconnect_backoff.attempts() == 0) {
+                            // Not a momentary blip: pause the alarms until the runtime is back
+                            std::cout << "[INFO] HMD disconnected. Waiting for reconnection..." << std::endl;
+                            PoseSample lost;
+                            lost.t_us = now_us;
+                            lost.flags = POSE_SESSION_LOST;
+                            publish(lost);
+                        }
+                        next_reconnect_us = now_us + reconnect_backoff.next_delay_us();
+                    }
+                }
+                if (reconnecting) {
+                    timer.wait_until(HighResolutionTimer::Clock::now() + std::chrono::microseconds(next_reconnect_us - now_us),
+                                     g_sampler_wake_event);
+                    scheduler.resync();
+                    continue;
+                }
+            }
+
+            if (!session_status_valid || now_us >= next_status_us) {
+                session_status_result = ovr_GetSessionStatus(session_, &sessionStatus);
+                next_status_us = now_us + status_period_us;
+                session_status_valid = true;
+            }
+            // While the headset is off-head only the cheap session status is polled
+            bool hmd_off_head = OVR_SUCCESS(session_status_result) &&
+                                (!sessionStatus.HmdMounted || sessionStatus.DisplayLost);
+            if (perf_period_us && !hmd_off_head && OVR_SUCCESS(session_status_result) && now_us >= next_perf_us) {
+                if (perf_session != session_) {
+                    ovr_ResetPerfStats(session_);
+                    perf_session = session_;
+                }
+                poll_perf_stats(now_us);
+                next_perf_us = now_us + perf_period_us;
+            }
+            double displayTime = 0.0;
+            ovrTrackingState ts = {};
+            if (!hmd_off_head) {
+                // An invisible app never submits frames, so a display-time prediction only
+                // extrapolates noise (and undershoots the extreme of a fast flick). absTime 0
+                // returns the latest measured pose instead.
+                displayTime = (sampling_.measured_pose || in_burst) ? 0.0 : ovr_GetPredictedDisplayTime(session_, 0);
+                const int64_t query_start_us = trace_enabled() ? monotonic_now_us() : 0;
+                ts = ovr_GetTrackingState(session_, displayTime, ovrTrue);
+                if (query_start_us) {
+                    TraceLoggingWrite(g_trace_provider, "TrackingQuery", TraceLoggingInt64(monotonic_now_us() - query_start_us, "DurationUs"),
+                                      TraceLoggingBool(in_burst, "Burst"));
+                }
+            }
+            
+            // Check for Oculus recenter trigger through ShouldRecenter flag
+            if (sessionStatus.ShouldRecenter && !last_should_recenter) {
+                std::cout << "[INFO] Oculus recenter detected - triggering software recenter" << std::endl;
+                recenter_requests |= RECENTER_BASELINE_RESET;
+            }
+            last_should_recenter = sessionStatus.ShouldRecenter;
+
+            recenter_requests |= g_pending_recenter.exchange(0, std::memory_order_acquire);
+            if ((recenter_requests & RECENTER_HARDWARE) && OVR_SUCCESS(session_status_result)) {
+                // On this thread the session can't be destroyed under the call. The software
+                // part waits for the next pose, which is in the new origin.
+                recenter_requests &= ~RECENTER_HARDWARE;
+                if (OVR_SUCCESS(ovr_RecenterTrackingOrigin(session_))) {
+                    std::cout << "[INFO] Hardware recenter attempted" << std::endl;
+                }
+            } else if (apply_pending_recenter(recenter_requests, ts.HeadPose.ThePose, (ts.StatusFlags & ovrStatus_OrientationTracked) != 0,
+                                              (ts.StatusFlags & ovrStatus_PositionTracked) != 0)) {
+                reference_changed = true;
+                drift.restart();
+            }
+            
+            // Check if session became invalid (actual API failure)
+            if (OVR_FAILURE(session_status_result)) {
+                std::cout << "[WARNING] HMD session lost. Attempting to reconnect..." << std::endl;
+                if (OvrSessionUser* user = session_user_.load()) user->session_ending();
+                ovr_Destroy(session_);
+                session_ = nullptr;
+                // First attempt right away on the next pass, then back off
+                reconnecting = true;
+                next_reconnect_us = now_us;
+                disconnected_since_us = now_us;
+                continue;
+            }
+
+            PoseSample sample;
+            sample.t_us = now_us;
+            if (sampling_.measured_pose && ts.HeadPose.TimeInSeconds > 0.0) {
+                // Map the sensor timestamp onto the core clock; keep samples in order and
+                // never ahead of the time we read them
+                int64_t ovr_to_core_us = now_us - static_cast<int64_t>(ovr_GetTimeInSeconds() * 1e6);
+                int64_t sensor_t_us = static_cast<int64_t>(ts.HeadPose.TimeInSeconds * 1e6) + ovr_to_core_us;
+                sample.t_us = (std::max)(last_sample_t_us, (std::min)(sensor_t_us, now_us));
+            }
+            last_sample_t_us = sample.t_us;
+            bool hmd_currently_ok = (ts.StatusFlags & ovrStatus_OrientationTracked) &&
+                                    sessionStatus.HmdMounted &&
+                                    !sessionStatus.DisplayLost;
+            if (!hmd_currently_ok) {
+                if (!hmd_off_head) trace(sample, ts, sessionStatus);
+                publish(sample);
+                if (hmd_off_head) {
+                    // Headset on the desk: slow backstop poll until it's mounted again
+                    session_status_valid = false;
+                    scheduler.idle_wait(HMD_IDLE_POLL_INTERVAL, g_sampler_wake_event);
+                } else {
+                    scheduler.wait_after_seconds(POLL_INTERVAL);
+                }
+                continue;
+            }
+            // Polled faster than the tracker produces poses: the same pose again would only
+            // be evaluated twice, its time counted as if the head had held still
+            if (ts.HeadPose.TimeInSeconds > 0.0 && ts.HeadPose.TimeInSeconds == last_pose_time_s && !reference_changed) {
+                duplicates_.fetch_add(1, std::memory_order_relaxed);
+                int64_t done_us = monotonic_now_us() - clock_epoch_us_;
+                watchdog_.end_phase(TickWatchdog::PHASE_TRACKING, done_us);
+                watchdog_.end_tick(done_us, scheduler.period_seconds());
+                scheduler.wait_next_tick();
+                continue;
+            }
+            last_pose_time_s = ts.HeadPose.TimeInSeconds;
+
+            const ovrVector3f& w = ts.HeadPose.AngularVelocity; // rad/s
+            sample.angular_speed_deg_s = rad2deg(std::sqrt(w.x * w.x + w.y * w.y + w.z * w.z));
+            sample.look = quat_to_look_vector(ts.HeadPose.ThePose.Orientation);
+            if (ts.StatusFlags & ovrStatus_PositionTracked) {
+                sample.lean = position_to_lean(ts.HeadPose.ThePose.Position);
+            }
+            drift.add(sample);
             {
-                case WM_RBUTTONUP: 
-                {
-                    POINT curPoint;
-                    GetCursorPos(&curPoint);
-                    HMENU hPopupMenu = CreatePopupMenu();
-                    InsertMenu(hPopupMenu, 0xFFFFFFFF, MF_BYPOSITION | MF_STRING, ID_TRAY_SETTINGS_ITEM, "Settings");
-                    InsertMenu(hPopupMenu, 0xFFFFFFFF, MF_SEPARATOR, 0, NULL); 
-                    InsertMenu(hPopupMenu, 0xFFFFFFFF, MF_BYPOSITION | MF_STRING, 
-                               ID_TRAY_TOGGLE_CONSOLE_ITEM, 
-                               g_is_console_visible ? "Hide Status Window" : "Show Status Window"); 
-                    InsertMenu(hPopupMenu, 0xFFFFFFFF, MF_SEPARATOR, 0, NULL); 
-                    InsertMenu(hPopupMenu, 0xFFFFFFFF, MF_BYPOSITION | MF_STRING, ID_TRAY_EXIT_CONTEXT_MENU_ITEM, "Exit");
-                    
-                    SetForegroundWindow(hwnd); 
+                // Angular velocity is in tracking space: yaw turns about +Y, pitch about the head's right axis
+                const ovrQuatf& o = ts.HeadPose.ThePose.Orientation;
+                double right_x = 1.0 - 2.0 * (o.y * o.y + o.z * o.z);
+                double right_y = 2.0 * (o.x * o.y + o.w * o.z);
+                double right_z = 2.0 * (o.x * o.z - o.w * o.y);
+                sample.yaw_rate_deg_s = rad2deg(w.y);
+                sample.pitch_rate_deg_s = rad2deg(w.x * right_x + w.y * right_y + w.z * right_z);
+            }
+
+            if (sampling_.burst) {
+                // Every burst sample goes to the evaluator, so the true peak of the look
+                // is what registers left/right
+                double yaw_speed_deg_s = rad2deg(std::abs(w.y));
+                double yaw_deg = 0.0, pitch_deg = 0.0;
+                look_vector_to_yaw_pitch(sample.look, yaw_deg, pitch_deg);
+                if (yaw_speed_deg_s >= sampling_.burst_trigger_yaw_deg_s) {
+                    if (!in_burst) {
+                        in_burst = true;
+                        burst_peak_left_deg = burst_peak_right_deg = yaw_deg;
+                    }
+                    burst_release_us = now_us + static_cast<int64_t>(sampling_.burst_hold_ms * 1000.0);
+                } else if (in_burst && now_us >= burst_release_us) {
+                    in_burst = false;
+                    LOOKOUT_STREAM(LEVEL_DEBUG, std::fixed << std::setprecision(1) << "[DEBUG] Burst sampling ended. Peak yaw L "
+                                                << burst_peak_left_deg << " / R " << burst_peak_right_deg << " deg");
+                }
+                if (in_burst) {
+                    burst_peak_left_deg = (std::max)(burst_peak_left_deg, yaw_deg);
+                    burst_peak_right_deg = (std::min)(burst_peak_right_deg, yaw_deg);
+                }
+            }
+            double period = sampling_.poll_period(sample.angular_speed_deg_s);
+            if (in_burst) period = (std::min)(period, 1.0 / sampling_.burst_rate_hz);
+            scheduler.set_period(period);
+            sample.flags = POSE_HMD_OK | (reference_changed ? POSE_RECENTERED : 0u);
+            reference_changed = false;
+            trace(sample, ts, sessionStatus);
+            publish(sample);
+
+            int64_t done_us = monotonic_now_us() - clock_epoch_us_;
+            watchdog_.end_phase(TickWatchdog::PHASE_TRACKING, done_us);
+            watchdog_.end_tick(done_us, scheduler.period_seconds());
+            watchdog_.report_if_due(done_us);
+            scheduler.wait_next_tick();
+        }
+    }
+
+    std::atomic<ovrSession>& session_;          // The source's, so it sees a recreated one
+    std::atomic<OvrSessionUser*>& session_user_;
+    SamplingConfig sampling_;
+    TickWatchdog watchdog_;
+    int64_t clock_epoch_us_;
+    SpscRing<PoseSample, kRingCapacity> ring_;
+    std::atomic<bool> active_{false};
+    std::atomic<bool> stop_requested_{false};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> duplicates_{0};
+    SeqLock<RenderPerf> perf_;
+    std::thread thread_;
+};
+
+// Supplies timestamped pose samples to the evaluator in batches. The evaluator opens the
+// source once, starts it, tells it when a flight is active, and drains whatever samples
+// are ready each time it wakes. Live samples are stamped on the core clock; offline
+// sources (realtime() == false) carry their own timeline and are drained as fast as
+// the evaluator can go until finished().
+class PoseSource {
+public:
+    virtual ~PoseSource() = default;
+
+    virtual const char* name() const = 0;
+    // Connect to the data; false means give up (e.g. the app closed while waiting)
+    virtual bool open() = 0;
+    virtual void start(const SamplingConfig& sampling, const WatchdogConfig& watchdog_config, int64_t clock_epoch_us) = 0;
+    virtual void stop() {}
+    // Stop and release the runtime/device; open() and start() may be called again later
+    virtual void close() { stop(); }
+    virtual void set_active(bool active) { (void)active; }
+    virtual size_t drain(PoseSample* out, size_t max_samples) = 0;
+    virtual uint64_t dropped_samples() const { return 0; }
+    // Polls with no new pose from the runtime, which weren't published
+    virtual uint64_t duplicate_samples() const { return 0; }
+    virtual bool realtime() const { return true; }
+    virtual bool finished() const { return false; }
+    // Oculus session while open, from any thread; null for sources without one
+    virtual ovrSession ovr_session() const { return nullptr; }
+    // Hands `user` each session this source creates, and takes it back before the
+    // session is destroyed; null detaches. False for sources without a session.
+    virtual bool set_session_user(OvrSessionUser* user) { (void)user; return false; }
+    // Compositor frame timing; t_us stays 0 for sources without it
+    virtual RenderPerf render_perf() const { return RenderPerf(); }
+};
+
+// The headset via LibOVR: initialization and session creation (retried until the
+// Oculus service and HMD are available), then a PoseSampler thread per run.
+class LivePoseSource : public PoseSource {
+public:
+    // visible: the session may submit frames (the scan overlay); tracking-only otherwise
+    explicit LivePoseSource(bool visible = false) : visible_(visible) {}
+    ~LivePoseSource() override {
+        stop();
+        end_session();
+        if (ovr_initialized_) ovr_Shutdown();
+    }
+
+    const char* name() const override { return "live"; }
+
+    bool open() override {
+        // Probe quickly first (the runtime is usually up, or about to be, on a normal
+        // launch) and back off towards 5 s on a cold boot. Waits end early if the app closes.
+        RetryBackoff init_backoff(ms_to_us(150), ms_to_us(5000));
+        RetryBackoff create_backoff(ms_to_us(150), ms_to_us(5000));
+        HighResolutionTimer wait_timer;
+        int64_t phase_start_us = monotonic_now_us();
+        int64_t last_waiting_log_us = phase_start_us;
+        auto wait_before_retry = [&](RetryBackoff& backoff, const char* first_message, const char* still_message) {
+            int64_t now_us = monotonic_now_us();
+            if (backoff.attempts() == 0) {
+                std::cout << first_message << std::endl;
+            } else if (now_us - last_waiting_log_us >= seconds_to_us(30.0)) {
+                std::cout << still_message << " (" << (now_us - phase_start_us) / 1000000 << " s, attempt "
+                          << backoff.attempts() + 1 << ")..." << std::endl;
+                last_waiting_log_us = now_us;
+            }
+            wait_timer.wait_until(HighResolutionTimer::Clock::now() + std::chrono::microseconds(backoff.next_delay_us()),
+                                  g_core_wake_event);
+        };
+
+        // Keep trying to initialize until successful or the app exits
+        while (!shutdown_requested()) {
+            if (!ovr_initialized_) {
+                ovrInitParams initParams = {0};
+                initParams.Flags = visible_ ? 0 : ovrInit_Invisible;
+                initParams.RequestedMinorVersion = OVR_MINOR_VERSION; 
+
+                ovrResult result = ovr_Initialize(&initParams);
+                if (OVR_FAILURE(result)) {
+                    ovrErrorInfo errorInfo;
+                    ovr_GetLastErrorInfo(&errorInfo);
+                    wait_before_retry(init_backoff, "[INFO] Waiting for Oculus service to start...",
+                                      "[INFO] Still waiting for Oculus HMD");
+                    continue;
+                }
+                
+                ovr_initialized_ = true;
+                int64_t now_us = monotonic_now_us();
+                std::cout << (visible_ ? "[INFO] OVR Initialized (visible, for the scan overlay)." : "[INFO] OVR Initialized with ovrInit_Invisible flag.") << std::endl;
+                std::cout << "[TIMING] ovr_Initialize: " << (now_us - phase_start_us) / 1000 << " ms, "
+                          << init_backoff.attempts() + 1 << " attempt(s)" << std::endl;
+                record_startup_phase(STARTUP_RUNTIME_INIT, phase_start_us);
+                phase_start_us = last_waiting_log_us = now_us;
+            }
+            
+            // Try to create session
+            ovrGraphicsLuid luid;
+            ovrSession session = nullptr;
+            ovrResult result = ovr_Create(&session, &luid);
+            if (OVR_FAILURE(result)) {
+                ovrErrorInfo errorInfo;
+                ovr_GetLastErrorInfo(&errorInfo);
+                wait_before_retry(create_backoff, "[INFO] Waiting for Oculus HMD to be connected and ready...",
+                                  "[INFO] Still waiting for HMD connection");
+                continue;
+            }
+            
+            // Success!
+            session_ = session;
+            std::cout << "[INFO] OVR Session Created - HMD connected and ready!" << std::endl;
+            std::cout << "[TIMING] ovr_Create: " << (monotonic_now_us() - phase_start_us) / 1000 << " ms, "
+                      << create_backoff.attempts() + 1 << " attempt(s)" << std::endl;
+            record_startup_phase(STARTUP_SESSION_CREATE, phase_start_us);
+            return true;
+        }
+        return false;
+    }
 
-                    TrackPopupMenu(hPopupMenu, TPM_RIGHTALIGN | TPM_BOTTOMALIGN | TPM_LEFTBUTTON, curPoint.x, curPoint.y, 0, hwnd, NULL);
-                    DestroyMenu(hPopupMenu);
+    // The session user starts here, before the sampler thread can replace the session
+    void start(const SamplingConfig& sampling, const WatchdogConfig& watchdog_config, int64_t clock_epoch_us) override {
+        if (OvrSessionUser* user = session_user_.load(); user && session_.load()) user->session_ready(session_);
+        sampler_.reset(new PoseSampler(session_, session_user_, sampling, watchdog_config, clock_epoch_us));
+        sampler_->set_active(active_);
+        sampler_->start();
+    }
 
-                    PostMessage(hwnd, WM_NULL, 0, 0); 
+    void stop() override {
+        if (sampler_) sampler_->stop();
+    }
+
+    void close() override {
+        stop();
+        sampler_.reset();
+        end_session();
+        if (ovr_initialized_) {
+            ovr_Shutdown();
+            ovr_initialized_ = false;
+        }
+        std::cout << "[INFO] Oculus session closed" << std::endl;
+    }
+
+    void set_active(bool active) override {
+        active_ = active;
+        if (sampler_) sampler_->set_active(active);
+    }
+
+    size_t drain(PoseSample* out, size_t max_samples) override {
+        return sampler_ ? sampler_->drain(out, max_samples) : 0;
+    }
+
+    uint64_t dropped_samples() const override { return sampler_ ? sampler_->dropped_samples() : 0; }
+    uint64_t duplicate_samples() const override { return sampler_ ? sampler_->duplicate_samples() : 0; }
+    ovrSession ovr_session() const override { return session_.load(); }
+    bool set_session_user(OvrSessionUser* user) override {
+        session_user_.store(user);
+        return true;
+    }
+    RenderPerf render_perf() const override { return sampler_ ? sampler_->render_perf() : RenderPerf(); }
+
+private:
+    // Sampler stopped: nothing else can replace the session meanwhile
+    void end_session() {
+        if (!session_.load()) return;
+        if (OvrSessionUser* user = session_user_.load()) user->session_ending();
+        ovr_Destroy(session_);
+        session_ = nullptr;
+    }
+
+    const bool visible_;
+    std::atomic<ovrSession> session_{nullptr};         // Replaced by the sampler on a reconnect
+    std::atomic<OvrSessionUser*> session_user_{nullptr};
+    bool ovr_initialized_ = false;
+    bool active_ = false;
+    std::unique_ptr<PoseSampler> sampler_;
+};
+
+// Scan overlay: one quad layer submitted to the Oculus compositor from its own thread
+// with an OpenGL context on a hidden window. The core publishes the overlay state (the
+// directions still unscanned and whether the alarm sounds) as one word; the texture is
+// redrawn and committed only when that word changes, and every other frame resubmits
+// the committed one, so the GPU does nothing new. While the compositor reports the
+// session not visible the thread only polls, ten times a second. The pose source
+// starts it with each session it creates and stops it before destroying one, from the
+// core or the sampler thread, so start and stop are serialized.
+class ScanOverlay : public OvrSessionUser {
+public:
+    static constexpr uint32_t kSounding = 1u << 8; // Low 8 bits: LookoutDirection bits unscanned
+
+    explicit ScanOverlay(const ScanOverlayConfig& config) : config_(config), pixels_(kSize * kSize, 0) {}
+    ~ScanOverlay() override { stop(); }
+    ScanOverlay(const ScanOverlay&) = delete;
+    ScanOverlay& operator=(const ScanOverlay&) = delete;
+
+    bool enabled() const { return config_.enabled; }
+
+    // A no-op when running, disabled, or without a session
+    void start(ovrSession session) {
+        std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+        if (!config_.enabled || !session || thread_.joinable()) return;
+        session_ = session;
+        stop_requested_ = false;
+        thread_ = std::thread(&ScanOverlay::run, this);
+    }
+
+    // The session must outlive the swap chain
+    void stop() {
+        std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+        if (!thread_.joinable()) return;
+        stop_requested_ = true;
+        thread_.join();
+        session_ = nullptr;
+    }
+
+    void session_ready(ovrSession session) override { start(session); }
+    void session_ending() override { stop(); }
+
+    // Core thread, once a tick; 0 shows nothing
+    void set_state(uint32_t state) { state_.store(state, std::memory_order_relaxed); }
+
+private:
+    static constexpr int kSize = 128;
+
+    void run() {
+        place_background_thread();
+        ThreadCpuScope cpu_scope(CPU_OVERLAY);
+        if (!create_context()) {
+            destroy_context();
+            return;
+        }
+        ovrTextureSwapChainDesc desc = {};
+        desc.Type = ovrTexture_2D;
+        desc.Format = OVR_FORMAT_R8G8B8A8_UNORM_SRGB;
+        desc.ArraySize = 1;
+        desc.Width = desc.Height = kSize;
+        desc.MipLevels = 1;
+        desc.SampleCount = 1;
+        desc.StaticImage = ovrFalse;
+        ovrTextureSwapChain chain = nullptr;
+        if (OVR_FAILURE(ovr_CreateTextureSwapChainGL(session_, &desc, &chain))) {
+            std::cerr << "[WARNING] Could not create the scan overlay texture; no overlay" << std::endl;
+            destroy_context();
+            return;
+        }
+        ovrLayerQuad quad = {};
+        quad.Header.Type = ovrLayerType_Quad;
+        quad.Header.Flags = ovrLayerFlag_HighQuality | (config_.head_locked ? ovrLayerFlag_HeadLocked : 0);
+        quad.ColorTexture = chain;
+        quad.Viewport.Size.w = quad.Viewport.Size.h = kSize;
+        quad.QuadPoseCenter.Orientation.w = 1.0f;
+        quad.QuadPoseCenter.Position.x = static_cast<float>(config_.offset_x_m);
+        quad.QuadPoseCenter.Position.y = static_cast<float>(config_.offset_y_m);
+        quad.QuadPoseCenter.Position.z = static_cast<float>(-config_.distance_m);
+        quad.QuadSize.x = quad.QuadSize.y = static_cast<float>(config_.size_m);
+        const ovrLayerHeader* layers = &quad.Header;
+        std::cout << "[INFO] Scan overlay on (" << (config_.head_locked ? "head" : "world") << "-locked quad)" << std::endl;
+
+        uint32_t drawn = UINT32_MAX;
+        long long frame = 0;
+        while (!stop_requested_.load()) {
+            const uint32_t state = state_.load(std::memory_order_relaxed);
+            if (state != drawn && upload(chain, state)) drawn = state;
+            // Paced by the compositor: returns at the next frame when visible
+            const ovrResult result = ovr_SubmitFrame(session_, frame++, nullptr, &layers, 1);
+            if (OVR_FAILURE(result) || result == ovrSuccess_NotVisible) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        ovr_DestroyTextureSwapChain(session_, chain);
+        destroy_context();
+    }
+
+    // A bar at each edge for a direction still unscanned, inner marks for lean, the
+    // center for coverage; amber, or red while the alarm sounds. Premultiplied alpha,
+    // rows top-down (GL textures without ovrLayerFlag_TextureOriginAtBottomLeft).
+    bool upload(ovrTextureSwapChain chain, uint32_t state) {
+        std::fill(pixels_.begin(), pixels_.end(), 0u);
+        const double a = config_.opacity;
+        const bool sounding = (state & kSounding) != 0;
+        const int r = static_cast<int>(255 * a), g = static_cast<int>((sounding ? 40 : 170) * a), b = static_cast<int>((sounding ? 40 : 0) * a);
+        const uint32_t color = static_cast<uint32_t>(r) | static_cast<uint32_t>(g) << 8 | static_cast<uint32_t>(b) << 16 |
+                               static_cast<uint32_t>(std::lround(255 * a)) << 24;
+        auto fill = [&](int x0, int y0, int x1, int y1) {
+            for (int y = y0; y < y1; ++y) std::fill(&pixels_[y * kSize + x0], &pixels_[y * kSize + x1], color);
+        };
+        if (state & direction_bit(DIR_LEFT)) fill(0, 44, 20, 84);
+        if (state & direction_bit(DIR_RIGHT)) fill(108, 44, 128, 84);
+        if (state & direction_bit(DIR_UP)) fill(44, 0, 84, 20);
+        if (state & direction_bit(DIR_DOWN)) fill(44, 108, 84, 128);
+        if (state & direction_bit(DIR_LEAN_LEFT)) fill(28, 54, 38, 74);
+        if (state & direction_bit(DIR_LEAN_RIGHT)) fill(90, 54, 100, 74);
+        if (state & direction_bit(DIR_LEAN_VERTICAL)) fill(54, 28, 74, 38);
+        if (state & direction_bit(DIR_COVERAGE)) fill(56, 56, 72, 72);
+
+        int index = 0;
+        unsigned int texture = 0;
+        if (OVR_FAILURE(ovr_GetTextureSwapChainCurrentIndex(session_, chain, &index)) ||
+            OVR_FAILURE(ovr_GetTextureSwapChainBufferGL(session_, chain, index, &texture))) {
+            return false;
+        }
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, kSize, kSize, GL_RGBA, GL_UNSIGNED_BYTE, pixels_.data());
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return OVR_SUCCESS(ovr_CommitTextureSwapChain(session_, chain));
+    }
+
+    // OpenGL 1.1 is enough: the texture is written with glTexSubImage2D, never rendered to
+    bool create_context() {
+        WNDCLASSEX wc = {0};
+        wc.cbSize = sizeof(WNDCLASSEX);
+        wc.lpfnWndProc = DefWindowProc;
+        wc.hInstance = GetModuleHandle(NULL);
+        wc.lpszClassName = "QuestLookoutOverlayWindow";
+        RegisterClassEx(&wc); // Fails harmlessly after the first start
+        hwnd_ = CreateWindowEx(0, wc.lpszClassName, "", 0, 0, 0, 1, 1, NULL, NULL, wc.hInstance, NULL); // Never shown
+        if (!hwnd_) {
+            std::cerr << "[WARNING] Could not create the scan overlay window (error=" << GetLastError() << "); no overlay" << std::endl;
+            return false;
+        }
+        dc_ = GetDC(hwnd_);
+        PIXELFORMATDESCRIPTOR pfd = {};
+        pfd.nSize = sizeof(pfd);
+        pfd.nVersion = 1;
+        pfd.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL;
+        pfd.iPixelType = PFD_TYPE_RGBA;
+        pfd.cColorBits = 32;
+        pfd.iLayerType = PFD_MAIN_PLANE;
+        const int format = ChoosePixelFormat(dc_, &pfd);
+        if (!format || !SetPixelFormat(dc_, format, &pfd) || !(gl_ = wglCreateContext(dc_)) || !wglMakeCurrent(dc_, gl_)) {
+            std::cerr << "[WARNING] Could not create an OpenGL context for the scan overlay; no overlay" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    void destroy_context() {
+        if (gl_) {
+            wglMakeCurrent(NULL, NULL);
+            wglDeleteContext(gl_);
+            gl_ = nullptr;
+        }
+        if (dc_) ReleaseDC(hwnd_, dc_);
+        dc_ = nullptr;
+        if (hwnd_) DestroyWindow(hwnd_);
+        hwnd_ = nullptr;
+    }
+
+    const ScanOverlayConfig config_;
+    ovrSession session_ = nullptr;
+    std::vector<uint32_t> pixels_;            // Overlay thread only
+    HWND hwnd_ = nullptr;
+    HDC dc_ = nullptr;
+    HGLRC gl_ = nullptr;
+    std::atomic<uint32_t> state_{0};
+    std::atomic<bool> stop_requested_{false};
+    std::mutex lifecycle_mutex_;              // start() and stop()
+    std::thread thread_;
+};
+
+// Samples recorded as CSV, one per line after a header:
+//   t_us,yaw_deg,pitch_deg,yaw_rate_deg_s,pitch_rate_deg_s,lean_lateral_cm,lean_vertical_cm,flags
+// The lean columns are optional; an empty one means no positional data. flags uses the
+// PoseSampleFlags bits (1 = HMD ready).
+class ReplayPoseSource : public PoseSource {
+public:
+    explicit ReplayPoseSource(const std::string& path) : path_(path) {}
+
+    const char* name() const override { return "replay"; }
+
+    bool open() override {
+        std::ifstream f(path_);
+        if (!f) {
+            std::cerr << "[ERROR] Could not open pose replay file " << path_ << std::endl;
+            return false;
+        }
+        std::string line;
+        size_t line_number = 0;
+        while (std::getline(f, line)) {
+            ++line_number;
+            if (line.empty() || !(std::isdigit(static_cast<unsigned char>(line[0])) || line[0] == '-')) continue; // Header
+            std::array<std::string, 8> fields;
+            std::stringstream ss(line);
+            size_t n = 0;
+            while (n < fields.size() && std::getline(ss, fields[n], ',')) ++n;
+            if (n < 5) {
+                std::cerr << "[WARNING] Skipping malformed replay line " << line_number << std::endl;
+                continue;
+            }
+            try {
+                PoseSample sample;
+                sample.t_us = std::stoll(fields[0]);
+                sample.look = yaw_pitch_to_look_vector(std::stod(fields[1]), std::stod(fields[2]));
+                sample.yaw_rate_deg_s = std::stod(fields[3]);
+                sample.pitch_rate_deg_s = std::stod(fields[4]);
+                sample.angular_speed_deg_s = std::hypot(sample.yaw_rate_deg_s, sample.pitch_rate_deg_s);
+                if (n > 6 && !fields[5].empty() && !fields[6].empty()) {
+                    sample.lean.lateral_m = std::stod(fields[5]) / 100.0;
+                    sample.lean.vertical_m = std::stod(fields[6]) / 100.0;
+                    sample.lean.valid = true;
                 }
-                return 0;
+                sample.flags = n > 7 ? static_cast<uint32_t>(std::stoul(fields[7])) : POSE_HMD_OK;
+                samples_.push_back(sample);
+            } catch (const std::exception&) {
+                std::cerr << "[WARNING] Skipping malformed replay line " << line_number << std::endl;
             }
-            break;
+        }
+        std::cout << "[INFO] Loaded " << samples_.size() << " pose samples from " << path_ << std::endl;
+        return true;
+    }
 
-        case WM_COMMAND: 
-            switch (LOWORD(wParam))
-            {
-                case ID_TRAY_EXIT_CONTEXT_MENU_ITEM:
-                    std::cout << "[INFO] Exit requested from tray menu. Shutting down." << std::endl;
-                    DestroyWindow(hwnd); 
-                    break;
-                case ID_TRAY_SETTINGS_ITEM:
-                    std::cout << "[INFO] Opening settings from tray menu." << std::endl;
-                    ShellExecute(NULL, "open", "settings_gui.exe", NULL, NULL, SW_SHOWNORMAL);
-                    break;
-                case ID_TRAY_TOGGLE_CONSOLE_ITEM:
-                    if (g_is_console_visible)
-                    {
-                        HideConsoleWindow();
-                    }
-                    else
-                    {
-                        ShowConsoleWindow();
-                    }
-                    break;
+    void start(const SamplingConfig&, const WatchdogConfig&, int64_t) override {}
+
+    size_t drain(PoseSample* out, size_t max_samples) override {
+        size_t count = (std::min)(max_samples, samples_.size() - next_);
+        std::copy(samples_.begin() + next_, samples_.begin() + next_ + count, out);
+        next_ += count;
+        return count;
+    }
+
+    bool realtime() const override { return false; }
+    bool finished() const override { return next_ >= samples_.size(); }
+
+private:
+    std::string path_;
+    std::vector<PoseSample> samples_;
+    size_t next_ = 0;
+};
+
+// A deterministic pilot: every scan period the head sweeps left and right through
+// +/-yaw amplitude and looks up twice, plus a little tracking jitter. Samples are
+// generated on demand, so an hour at a high rate costs no memory.
+class SyntheticPoseSource : public PoseSource {
+public:
+    explicit SyntheticPoseSource(const PoseSourceConfig& config) : motion_(config.synthetic) {}
+
+    const char* name() const override { return "synthetic"; }
+
+    bool open() override {
+        const SyntheticMotionConfig& c = motion_.config();
+        std::cout << "[INFO] Synthetic pose source: " << synthetic_pattern_name(c.pattern) << " at " << c.rate_hz << " Hz for "
+                  << c.duration_s << " s (" << motion_.nominal_samples() << " samples)";
+        if (c.drift_deg_per_min > 0.0) std::cout << ", drift " << c.drift_deg_per_min << " deg/min";
+        if (c.dropouts_per_hour > 0.0) std::cout << ", " << c.dropouts_per_hour << " dropouts/h";
+        if (c.unmounts_per_hour > 0.0) std::cout << ", " << c.unmounts_per_hour << " unmounts/h";
+        std::cout << std::endl;
+        return true;
+    }
+
+    void start(const SamplingConfig&, const WatchdogConfig&, int64_t) override {}
+
+    size_t drain(PoseSample* out, size_t max_samples) override {
+        size_t count = 0;
+        SyntheticPose pose;
+        while (count < max_samples && !finished_) {
+            if (!motion_.next(pose)) {
+                finished_ = true;
+                break;
             }
-            break;
+            PoseSample& sample = out[count++];
+            sample = PoseSample();
+            sample.t_us = pose.t_us;
+            sample.look = yaw_pitch_to_look_vector(pose.yaw_deg, pose.pitch_deg);
+            sample.yaw_rate_deg_s = pose.yaw_rate_deg_s;
+            sample.pitch_rate_deg_s = pose.pitch_rate_deg_s;
+            sample.angular_speed_deg_s = std::hypot(sample.yaw_rate_deg_s, sample.pitch_rate_deg_s);
+            sample.flags = pose.tracked ? POSE_HMD_OK : 0u;
+        }
+        return count;
+    }
 
+    bool realtime() const override { return false; }
+    bool finished() const override { return finished_; }
 
-        case WM_DESTROY:
-            if (g_is_console_visible) HideConsoleWindow(); 
-            unregister_recenter_hotkey(hwnd);
-            Shell_NotifyIcon(NIM_DELETE, &nidApp); 
-            PostQuitMessage(0); 
-            break;
+private:
+    SyntheticHeadMotion motion_;
+    bool finished_ = false;
+};
 
-        default:
-            return DefWindowProc(hwnd, uMsg, wParam, lParam);
+#ifdef LOOKOUT_WITH_OPENXR
+// SteamVR and other OpenXR runtimes (Pico, Index, ...) that LibOVR can't see. The
+// session is headless (XR_MND_headless): no graphics binding, no swapchain and no frame
+// loop, just the view space located against the local space at the poll rate, so it
+// costs about as little as the ovrInit_Invisible path. Burst sampling and measured
+// poses are LibOVR-only; the sample time is always the time of the query.
+class OpenXrPoseSource : public PoseSource {
+public:
+    static constexpr size_t kRingCapacity = PoseSampler::kRingCapacity;
+
+    explicit OpenXrPoseSource(bool eye_gaze = false) : eye_gaze_(eye_gaze) {}
+    ~OpenXrPoseSource() override { release(); }
+
+    const char* name() const override { return "openxr"; }
+
+    bool open() override {
+        uint32_t extension_count = 0;
+        xrEnumerateInstanceExtensionProperties(nullptr, 0, &extension_count, nullptr);
+        std::vector<XrExtensionProperties> extensions(extension_count, { XR_TYPE_EXTENSION_PROPERTIES });
+        xrEnumerateInstanceExtensionProperties(nullptr, extension_count, &extension_count, extensions.data());
+        bool has_headless = false, has_qpc_time = false, has_eye_gaze = false;
+        for (const XrExtensionProperties& e : extensions) {
+            if (std::strcmp(e.extensionName, XR_MND_HEADLESS_EXTENSION_NAME) == 0) has_headless = true;
+            if (std::strcmp(e.extensionName, XR_KHR_WIN32_CONVERT_PERFORMANCE_COUNTER_TIME_EXTENSION_NAME) == 0) has_qpc_time = true;
+            if (std::strcmp(e.extensionName, XR_EXT_EYE_GAZE_INTERACTION_EXTENSION_NAME) == 0) has_eye_gaze = true;
+        }
+        if (!has_headless || !has_qpc_time) {
+            std::cerr << "[ERROR] OpenXR runtime lacks " << (has_headless ? XR_KHR_WIN32_CONVERT_PERFORMANCE_COUNTER_TIME_EXTENSION_NAME : XR_MND_HEADLESS_EXTENSION_NAME)
+                      << "; a headless pose session isn't possible with this runtime" << std::endl;
+            return false;
+        }
+
+        const char* enabled_extensions[3] = { XR_MND_HEADLESS_EXTENSION_NAME, XR_KHR_WIN32_CONVERT_PERFORMANCE_COUNTER_TIME_EXTENSION_NAME,
+                                              XR_EXT_EYE_GAZE_INTERACTION_EXTENSION_NAME };
+        if (eye_gaze_ && !has_eye_gaze) {
+            std::cerr << "[WARNING] OpenXR runtime lacks " << XR_EXT_EYE_GAZE_INTERACTION_EXTENSION_NAME << "; head pose only" << std::endl;
+        }
+        const bool use_eye_gaze = eye_gaze_ && has_eye_gaze;
+        XrInstanceCreateInfo instance_info = { XR_TYPE_INSTANCE_CREATE_INFO };
+        std::strncpy(instance_info.applicationInfo.applicationName, "Quest Lookout", XR_MAX_APPLICATION_NAME_SIZE - 1);
+        instance_info.applicationInfo.apiVersion = XR_CURRENT_API_VERSION;
+        instance_info.enabledExtensionCount = use_eye_gaze ? 3 : 2;
+        instance_info.enabledExtensionNames = enabled_extensions;
+        XrResult result = xrCreateInstance(&instance_info, &instance_);
+        if (XR_FAILED(result)) {
+            std::cerr << "[ERROR] xrCreateInstance failed (" << result << ")" << std::endl;
+            return false;
+        }
+        xrGetInstanceProcAddr(instance_, "xrConvertWin32PerformanceCounterToTimeKHR",
+                              reinterpret_cast<PFN_xrVoidFunction*>(&convert_qpc_time_));
+
+        // The headset may not be plugged in yet: keep asking for it while the app runs
+        XrSystemGetInfo system_info = { XR_TYPE_SYSTEM_GET_INFO };
+        system_info.formFactor = XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY;
+        XrSystemId system_id = XR_NULL_SYSTEM_ID;
+        HighResolutionTimer wait_timer;
+        RetryBackoff system_backoff(ms_to_us(150), ms_to_us(5000));
+        int64_t phase_start_us = monotonic_now_us();
+        while (XR_FAILED(xrGetSystem(instance_, &system_info, &system_id))) {
+            if (shutdown_requested()) return false;
+            if (system_backoff.attempts() == 0) {
+                std::cout << "[INFO] Waiting for an OpenXR headset to be connected..." << std::endl;
+            }
+            wait_timer.wait_until(HighResolutionTimer::Clock::now() + std::chrono::microseconds(system_backoff.next_delay_us()),
+                                  g_core_wake_event);
+        }
+        std::cout << "[TIMING] xrGetSystem: " << (monotonic_now_us() - phase_start_us) / 1000 << " ms, "
+                  << system_backoff.attempts() + 1 << " attempt(s)" << std::endl;
+        phase_start_us = record_startup_phase(STARTUP_RUNTIME_INIT, phase_start_us);
+
+        XrSessionCreateInfo session_info = { XR_TYPE_SESSION_CREATE_INFO };
+        session_info.systemId = system_id; // No graphics binding: headless
+        result = xrCreateSession(instance_, &session_info, &session_);
+        if (XR_FAILED(result)) {
+            std::cerr << "[ERROR] xrCreateSession (headless) failed (" << result << ")" << std::endl;
+            return false;
+        }
+        XrReferenceSpaceCreateInfo space_info = { XR_TYPE_REFERENCE_SPACE_CREATE_INFO };
+        space_info.poseInReferenceSpace.orientation.w = 1.0f;
+        space_info.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_VIEW;
+        xrCreateReferenceSpace(session_, &space_info, &view_space_);
+        space_info.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_LOCAL;
+        xrCreateReferenceSpace(session_, &space_info, &local_space_);
+        std::cout << "[INFO] OpenXR headless session created" << std::endl;
+        if (use_eye_gaze) {
+            XrSystemEyeGazeInteractionPropertiesEXT gaze_properties = { XR_TYPE_SYSTEM_EYE_GAZE_INTERACTION_PROPERTIES_EXT };
+            XrSystemProperties properties = { XR_TYPE_SYSTEM_PROPERTIES };
+            properties.next = &gaze_properties;
+            xrGetSystemProperties(instance_, system_id, &properties);
+            if (!gaze_properties.supportsEyeGazeInteraction) {
+                std::cerr << "[WARNING] This headset has no eye tracking; head pose only" << std::endl;
+            } else if (!(gaze_ = create_gaze_action())) {
+                std::cerr << "[WARNING] Could not set up the eye gaze action; head pose only" << std::endl;
+            } else {
+                std::cout << "[INFO] Eye gaze enabled: look direction is head x eye while the eyes are tracked" << std::endl;
+            }
+        }
+        record_startup_phase(STARTUP_SESSION_CREATE, phase_start_us);
+        return true;
     }
-    return 0;
-}
 
-int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow)
-{
-    UNREFERENCED_PARAMETER(hPrevInstance); 
-    UNREFERENCED_PARAMETER(lpCmdLine); 
-    UNREFERENCED_PARAMETER(nCmdShow);
+    void start(const SamplingConfig& sampling, const WatchdogConfig& watchdog_config, int64_t clock_epoch_us) override {
+        sampling_ = sampling;
+        clock_epoch_us_ = clock_epoch_us;
+        watchdog_.reset(new TickWatchdog("sampler", watchdog_config));
+        stop_requested_.store(false);
+        thread_ = std::thread(&OpenXrPoseSource::run, this);
+    }
 
-    WNDCLASSEX wc = {0};
-    wc.cbSize        = sizeof(WNDCLASSEX);
-    wc.lpfnWndProc   = WndProc;
-    wc.hInstance     = hInstance;
-    wc.lpszClassName = WINDOW_CLASS_NAME;
-    wc.hIcon         = LoadIcon(NULL, IDI_APPLICATION); 
-    wc.hCursor       = LoadCursor(NULL, IDC_ARROW);
+    void stop() override {
+        stop_requested_.store(true);
+        if (g_sampler_wake_event) SetEvent(g_sampler_wake_event);
+        if (thread_.joinable()) thread_.join();
+    }
 
-    if (!RegisterClassEx(&wc))
-    {
-        MessageBox(NULL, "Window Registration Failed!", "Error!", MB_ICONEXCLAMATION | MB_OK);
-        return 0;
+    void close() override {
+        release();
+        std::cout << "[INFO] OpenXR session closed" << std::endl;
     }
 
-    g_hwnd = CreateWindowEx(
-        0,                              
-        WINDOW_CLASS_NAME,              
-        "Quest Lookout Hidden Window",  
-        0,                              
-        CW_USEDEFAULT, CW_USEDEFAULT, CW_USEDEFAULT, CW_USEDEFAULT, 
-        NULL,       
-        NULL,       
-        hInstance,  
-        NULL        
-    );
+    void set_active(bool active) override {
+        active_.store(active);
+        if (g_sampler_wake_event) SetEvent(g_sampler_wake_event);
+    }
 
-    if (g_hwnd == NULL)
-    {
-        MessageBox(NULL, "Window Creation Failed!", "Error!", MB_ICONEXCLAMATION | MB_OK);
-        return 0;
+    size_t drain(PoseSample* out, size_t max_samples) override { return ring_.pop_batch(out, max_samples); }
+    uint64_t dropped_samples() const override { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    void release() {
+        stop();
+        if (gaze_space_ != XR_NULL_HANDLE) xrDestroySpace(gaze_space_);
+        if (gaze_action_set_ != XR_NULL_HANDLE) xrDestroyActionSet(gaze_action_set_); // And its action
+        gaze_space_ = XR_NULL_HANDLE;
+        gaze_action_set_ = XR_NULL_HANDLE;
+        gaze_action_ = XR_NULL_HANDLE;
+        gaze_ = false;
+        if (view_space_ != XR_NULL_HANDLE) xrDestroySpace(view_space_);
+        if (local_space_ != XR_NULL_HANDLE) xrDestroySpace(local_space_);
+        if (session_ != XR_NULL_HANDLE) xrDestroySession(session_);
+        if (instance_ != XR_NULL_HANDLE) xrDestroyInstance(instance_);
+        view_space_ = local_space_ = XR_NULL_HANDLE;
+        session_ = XR_NULL_HANDLE;
+        instance_ = XR_NULL_HANDLE;
+        running_ = lost_ = focused_ = false;
     }
 
-    nidApp.cbSize = sizeof(NOTIFYICONDATA);
-    nidApp.hWnd = g_hwnd;
-    nidApp.uID = ID_TRAY_APP_ICON;
-    nidApp.uFlags = NIF_ICON | NIF_MESSAGE | NIF_TIP;
-    nidApp.uCallbackMessage = WM_APP_TRAYMSG;
-    nidApp.hIcon = LoadIcon(NULL, IDI_APPLICATION); 
-    strncpy_s(nidApp.szTip, "Quest Lookout", _TRUNCATE); 
+    // Eye gaze pose action (XR_EXT_eye_gaze_interaction), bound and attached to the session
+    bool create_gaze_action() {
+        XrActionSetCreateInfo set_info = { XR_TYPE_ACTION_SET_CREATE_INFO };
+        std::strncpy(set_info.actionSetName, "gaze", XR_MAX_ACTION_SET_NAME_SIZE - 1);
+        std::strncpy(set_info.localizedActionSetName, "Gaze", XR_MAX_LOCALIZED_ACTION_SET_NAME_SIZE - 1);
+        if (XR_FAILED(xrCreateActionSet(instance_, &set_info, &gaze_action_set_))) return false;
+        XrActionCreateInfo action_info = { XR_TYPE_ACTION_CREATE_INFO };
+        action_info.actionType = XR_ACTION_TYPE_POSE_INPUT;
+        std::strncpy(action_info.actionName, "gaze_pose", XR_MAX_ACTION_NAME_SIZE - 1);
+        std::strncpy(action_info.localizedActionName, "Gaze pose", XR_MAX_LOCALIZED_ACTION_NAME_SIZE - 1);
+        if (XR_FAILED(xrCreateAction(gaze_action_set_, &action_info, &gaze_action_))) return false;
+        XrPath profile = XR_NULL_PATH, gaze_path = XR_NULL_PATH;
+        xrStringToPath(instance_, "/interaction_profiles/ext/eye_gaze_interaction", &profile);
+        xrStringToPath(instance_, "/user/eyes_ext/input/gaze_ext/pose", &gaze_path);
+        XrActionSuggestedBinding binding = { gaze_action_, gaze_path };
+        XrInteractionProfileSuggestedBinding suggested = { XR_TYPE_INTERACTION_PROFILE_SUGGESTED_BINDING };
+        suggested.interactionProfile = profile;
+        suggested.countSuggestedBindings = 1;
+        suggested.suggestedBindings = &binding;
+        if (XR_FAILED(xrSuggestInteractionProfileBindings(instance_, &suggested))) return false;
+        XrSessionActionSetsAttachInfo attach_info = { XR_TYPE_SESSION_ACTION_SETS_ATTACH_INFO };
+        attach_info.countActionSets = 1;
+        attach_info.actionSets = &gaze_action_set_;
+        if (XR_FAILED(xrAttachSessionActionSets(session_, &attach_info))) return false;
+        XrActionSpaceCreateInfo space_info = { XR_TYPE_ACTION_SPACE_CREATE_INFO };
+        space_info.action = gaze_action_;
+        space_info.poseInActionSpace.orientation.w = 1.0f;
+        return XR_SUCCEEDED(xrCreateActionSpace(session_, &space_info, &gaze_space_));
+    }
 
+    // Whether the gaze action is active now; false while the runtime isn't tracking the
+    // eyes (eyes closed, calibration lost, or no input focus for this session). Synced at
+    // the session status rate: the action space is located every tick regardless.
+    bool sync_gaze() {
+        XrActiveActionSet active = { gaze_action_set_, XR_NULL_PATH };
+        XrActionsSyncInfo sync_info = { XR_TYPE_ACTIONS_SYNC_INFO };
+        sync_info.countActiveActionSets = 1;
+        sync_info.activeActionSets = &active;
+        if (xrSyncActions(session_, &sync_info) != XR_SUCCESS) return false; // XR_SESSION_NOT_FOCUSED: no input
+        XrActionStateGetInfo get_info = { XR_TYPE_ACTION_STATE_GET_INFO };
+        get_info.action = gaze_action_;
+        XrActionStatePose state = { XR_TYPE_ACTION_STATE_POSE };
+        return XR_SUCCEEDED(xrGetActionStatePose(session_, &get_info, &state)) && state.isActive;
+    }
 
-    if (!Shell_NotifyIcon(NIM_ADD, &nidApp)) {
-        MessageBox(NULL, "Failed to add tray icon!", "Error!", MB_ICONEXCLAMATION | MB_OK);
+    // The eyes' rotation within the head at xr_time; false when not tracked
+    bool locate_gaze(XrTime xr_time, ovrQuatf& eye) {
+        XrSpaceLocation location = { XR_TYPE_SPACE_LOCATION };
+        if (XR_FAILED(xrLocateSpace(gaze_space_, view_space_, xr_time, &location)) ||
+            !(location.locationFlags & XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT)) {
+            return false;
+        }
+        eye = { location.pose.orientation.x, location.pose.orientation.y, location.pose.orientation.z, location.pose.orientation.w };
+        return true;
     }
-    
-    // Load and register hotkey for recentering (must be in main thread)
-    load_hotkey_from_settings();
-    register_recenter_hotkey(g_hwnd);
-    
-    std::thread core_logic_thread(app_core_logic);
-    
-    MSG msg;
-    while (GetMessage(&msg, NULL, 0, 0) > 0) 
-    {
-        TranslateMessage(&msg);
-        DispatchMessage(&msg);
+
+    void publish(const PoseSample& sample) {
+        if (!ring_.try_push(sample)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (g_core_wake_event) SetEvent(g_core_wake_event);
     }
 
-    if (core_logic_thread.joinable()) {
-        core_logic_thread.join(); 
+    // Follow the session lifecycle; the session only reports poses between begin and end
+    void poll_events() {
+        XrEventDataBuffer event = { XR_TYPE_EVENT_DATA_BUFFER };
+        while (xrPollEvent(instance_, &event) == XR_SUCCESS) {
+            if (event.type == XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED) {
+                const XrEventDataSessionStateChanged& changed = *reinterpret_cast<const XrEventDataSessionStateChanged*>(&event);
+                if (changed.state == XR_SESSION_STATE_READY) {
+                    XrSessionBeginInfo begin_info = { XR_TYPE_SESSION_BEGIN_INFO };
+                    begin_info.primaryViewConfigurationType = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
+                    running_ = XR_SUCCEEDED(xrBeginSession(session_, &begin_info));
+                    std::cout << "[INFO] OpenXR session " << (running_ ? "running" : "failed to begin") << std::endl;
+                } else if (changed.state == XR_SESSION_STATE_FOCUSED || changed.state == XR_SESSION_STATE_VISIBLE) {
+                    focused_ = changed.state == XR_SESSION_STATE_FOCUSED; // Input (eye gaze) only with focus
+                } else if (changed.state == XR_SESSION_STATE_STOPPING) {
+                    xrEndSession(session_);
+                    running_ = false;
+                } else if (changed.state == XR_SESSION_STATE_EXITING || changed.state == XR_SESSION_STATE_LOSS_PENDING) {
+                    running_ = false;
+                    lost_ = true;
+                }
+            } else if (event.type == XR_TYPE_EVENT_DATA_INSTANCE_LOSS_PENDING) {
+                running_ = false;
+                lost_ = true;
+            }
+            event = { XR_TYPE_EVENT_DATA_BUFFER };
+        }
     }
 
-    return (int)msg.wParam;
-}
+    void run() {
+        ThreadCpuScope cpu_scope(CPU_SAMPLER);
+        HighResolutionTimer timer;
+        TickScheduler scheduler(timer, sampling_.adaptive ? 1.0 / sampling_.max_rate_hz : POLL_INTERVAL);
+        uint32_t recenter_requests = 0;
+        bool reference_changed = false;
+        bool lost_reported = false;
+        YawDriftCorrector drift(sampling_);
+        MmcssRegistration mmcss(sampling_.mmcss_task, sampling_.mmcss_priority);
+        const int64_t sync_period_us = static_cast<int64_t>(1e6 / sampling_.session_status_hz);
+        int64_t next_sync_us = 0;
+        bool gaze_active = false;
+        // Eye gaze asked for but not delivered for kGazeWarnUs of tracked sampling is
+        // reported once, until it shows up again
+        int64_t gaze_seen_us = 0; // 0: restart the wait on the next tracked pass
+        bool gaze_warned = false;
 
-int app_core_logic() 
-{
-    std::cout << "[INFO] Quest Lookout starting - waiting for Oculus HMD connection..." << std::endl;
-    
-    ovrSession session = nullptr;
-    bool ovr_initialized = false;
-    int retry_count = 0;
-    const int max_retries = -1; // Infinite retries
-    const int retry_delay_ms = 3000; // 3 seconds between retries
-    
-    // Keep trying to initialize until successful or window closed
-    while (IsWindow(g_hwnd)) {
-        if (!ovr_initialized) {
-            ovrInitParams initParams = {0};
-            initParams.Flags = ovrInit_Invisible; 
-            initParams.RequestedMinorVersion = OVR_MINOR_VERSION; 
-
-            ovrResult result = ovr_Initialize(&initParams);
-            if (OVR_FAILURE(result)) {
-                retry_count++;
-                ovrErrorInfo errorInfo;
-                ovr_GetLastErrorInfo(&errorInfo);
-                if (retry_count == 1) {
-                    std::cout << "[INFO] Waiting for Oculus service to start..." << std::endl;
-                } else if (retry_count % 10 == 0) { // Every 30 seconds
-                    std::cout << "[INFO] Still waiting for Oculus HMD (attempt " << retry_count << ")..." << std::endl;
+        while (!stop_requested_.load() && !shutdown_requested()) {
+            poll_events();
+            if (!active_.load()) {
+                gaze_seen_us = 0;
+                scheduler.idle_wait(LOG_CHECK_INTERVAL, g_sampler_wake_event);
+                continue;
+            }
+
+            int64_t now_us = monotonic_now_us() - clock_epoch_us_;
+            watchdog_->begin_tick(now_us);
+            PoseSample sample;
+            sample.t_us = now_us;
+            if (lost_) {
+                // The runtime went away; the instance can't be reused, so stop sampling
+                if (!lost_reported) {
+                    std::cerr << "[WARNING] OpenXR session lost. Restart Quest Lookout once the runtime is back." << std::endl;
+                    sample.flags = POSE_SESSION_LOST;
+                    publish(sample);
+                    lost_reported = true;
                 }
-                std::this_thread::sleep_for(std::chrono::milliseconds(retry_delay_ms));
+                scheduler.idle_wait(LOG_CHECK_INTERVAL, g_sampler_wake_event);
                 continue;
             }
-            
-            ovr_initialized = true;
-            std::cout << "[INFO] OVR Initialized with ovrInit_Invisible flag." << std::endl;
+            if (!running_) {
+                gaze_seen_us = 0;
+                publish(sample); // Not HMD_OK: alarms pause until the session runs
+                scheduler.idle_wait(HMD_IDLE_POLL_INTERVAL, g_sampler_wake_event);
+                continue;
+            }
+
+            LARGE_INTEGER counter;
+            QueryPerformanceCounter(&counter);
+            XrTime xr_time = 0;
+            convert_qpc_time_(instance_, &counter, &xr_time);
+            XrSpaceVelocity velocity = { XR_TYPE_SPACE_VELOCITY };
+            XrSpaceLocation location = { XR_TYPE_SPACE_LOCATION };
+            location.next = &velocity;
+            const int64_t query_start_us = trace_enabled() ? monotonic_now_us() : 0;
+            bool located = XR_SUCCEEDED(xrLocateSpace(view_space_, local_space_, xr_time, &location));
+            if (query_start_us) {
+                TraceLoggingWrite(g_trace_provider, "TrackingQuery", TraceLoggingInt64(monotonic_now_us() - query_start_us, "DurationUs"),
+                                  TraceLoggingBool(false, "Burst"));
+            }
+            bool orientation_tracked = located && (location.locationFlags & XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT);
+            bool position_tracked = located && (location.locationFlags & XR_SPACE_LOCATION_POSITION_TRACKED_BIT);
+
+            // OpenXR and LibOVR share conventions (right-handed, +Y up, -Z forward)
+            ovrPosef pose;
+            pose.Orientation = { location.pose.orientation.x, location.pose.orientation.y,
+                                 location.pose.orientation.z, location.pose.orientation.w };
+            pose.Position = { location.pose.position.x, location.pose.position.y, location.pose.position.z };
+            // OpenXR has no runtime recenter; the software one does the same job here
+            recenter_requests |= g_pending_recenter.exchange(0, std::memory_order_acquire) & ~RECENTER_HARDWARE;
+            if (apply_pending_recenter(recenter_requests, pose, orientation_tracked, position_tracked)) {
+                reference_changed = true;
+                drift.restart();
+            }
+            ovrVector3f angular_velocity = {};
+            if (velocity.velocityFlags & XR_SPACE_VELOCITY_ANGULAR_VALID_BIT) {
+                angular_velocity = { velocity.angularVelocity.x, velocity.angularVelocity.y, velocity.angularVelocity.z };
+            }
+            if (!orientation_tracked) {
+                gaze_seen_us = 0;
+                trace_pose(sample.t_us, pose, angular_velocity, static_cast<uint32_t>(location.locationFlags), TRACE_OPENXR,
+                           sample.flags);
+                publish(sample);
+                scheduler.wait_after_seconds(POLL_INTERVAL);
+                continue;
+            }
+
+            // Eye gaze, where tracked, turns the look direction further within the head.
+            // Lean and the rates below stay the head's.
+            ovrQuatf eye;
+            if (gaze_ && now_us >= next_sync_us) {
+                next_sync_us = now_us + sync_period_us;
+                gaze_active = sync_gaze();
+            }
+            const bool gazed = gaze_active && locate_gaze(xr_time, eye);
+            if (gaze_) {
+                if (gazed || gaze_seen_us == 0) {
+                    if (gazed && gaze_warned) std::cout << "[INFO] Eye gaze tracked again" << std::endl;
+                    if (gazed) gaze_warned = false;
+                    gaze_seen_us = now_us;
+                } else if (!gaze_warned && now_us - gaze_seen_us >= kGazeWarnUs) {
+                    std::cerr << (focused_ ? "[WARNING] No eye gaze from the runtime for 10 s (eye tracking off or not calibrated?); head pose only"
+                                           : "[WARNING] The OpenXR session hasn't been given input focus, so the runtime sends no eye gaze; head pose only")
+                              << std::endl;
+                    gaze_warned = true;
+                }
+            }
+            sample.look = quat_to_look_vector(gazed ? quat_multiply(pose.Orientation, eye) : pose.Orientation);
+            if (position_tracked) sample.lean = position_to_lean(pose.Position);
+            if (velocity.velocityFlags & XR_SPACE_VELOCITY_ANGULAR_VALID_BIT) {
+                const XrVector3f& w = velocity.angularVelocity; // rad/s, local space
+                const ovrQuatf& o = pose.Orientation;
+                double right_x = 1.0 - 2.0 * (o.y * o.y + o.z * o.z);
+                double right_y = 2.0 * (o.x * o.y + o.w * o.z);
+                double right_z = 2.0 * (o.x * o.z - o.w * o.y);
+                sample.angular_speed_deg_s = rad2deg(std::sqrt(w.x * w.x + w.y * w.y + w.z * w.z));
+                sample.yaw_rate_deg_s = rad2deg(w.y);
+                sample.pitch_rate_deg_s = rad2deg(w.x * right_x + w.y * right_y + w.z * right_z);
+            }
+            drift.add(sample);
+            scheduler.set_period(sampling_.poll_period(sample.angular_speed_deg_s));
+            sample.flags = POSE_HMD_OK | (reference_changed ? POSE_RECENTERED : 0u) | (gazed ? POSE_EYE_GAZE : 0u);
+            reference_changed = false;
+            trace_pose(sample.t_us, pose, angular_velocity, static_cast<uint32_t>(location.locationFlags), TRACE_OPENXR,
+                       sample.flags);
+            publish(sample);
+
+            int64_t done_us = monotonic_now_us() - clock_epoch_us_;
+            watchdog_->end_phase(TickWatchdog::PHASE_TRACKING, done_us);
+            watchdog_->end_tick(done_us, scheduler.period_seconds());
+            watchdog_->report_if_due(done_us);
+            scheduler.wait_next_tick();
         }
-        
-        // Try to create session
-        ovrGraphicsLuid luid;
-        ovrResult result = ovr_Create(&session, &luid);
-        if (OVR_FAILURE(result)) {
-            retry_count++;
-            ovrErrorInfo errorInfo;
-            ovr_GetLastErrorInfo(&errorInfo);
-            
-            if (retry_count == 1) {
-                std::cout << "[INFO] Waiting for Oculus HMD to be connected and ready..." << std::endl;
-            } else if (retry_count % 10 == 0) { // Every 30 seconds
-                std::cout << "[INFO] Still waiting for HMD connection (attempt " << retry_count << ")..." << std::endl;
+    }
+
+    XrInstance instance_ = XR_NULL_HANDLE;
+    XrSession session_ = XR_NULL_HANDLE;
+    XrSpace view_space_ = XR_NULL_HANDLE, local_space_ = XR_NULL_HANDLE;
+    const bool eye_gaze_;                                  // Asked for in settings
+    bool gaze_ = false;                                    // Runtime and headset support it, action attached
+    XrActionSet gaze_action_set_ = XR_NULL_HANDLE;
+    XrAction gaze_action_ = XR_NULL_HANDLE;
+    XrSpace gaze_space_ = XR_NULL_HANDLE;
+    PFN_xrConvertWin32PerformanceCounterToTimeKHR convert_qpc_time_ = nullptr;
+    static constexpr int64_t kGazeWarnUs = 10000000;
+    bool running_ = false, lost_ = false; // Sampler thread only
+    bool focused_ = false;
+    SamplingConfig sampling_;
+    int64_t clock_epoch_us_ = 0;
+    std::unique_ptr<TickWatchdog> watchdog_;
+    SpscRing<PoseSample, kRingCapacity> ring_;
+    std::atomic<bool> active_{false};
+    std::atomic<bool> stop_requested_{false};
+    std::atomic<uint64_t> dropped_{0};
+    std::thread thread_;
+};
+#endif // LOOKOUT_WITH_OPENXR
+
+std::unique_ptr<PoseSource> make_pose_source(const PoseSourceConfig& config, bool overlay) {
+    switch (config.type) {
+    case POSE_SOURCE_OPENXR:
+#ifdef LOOKOUT_WITH_OPENXR
+        return std::unique_ptr<PoseSource>(new OpenXrPoseSource(config.eye_gaze));
+#else
+        std::cerr << "[WARNING] This build has no OpenXR support (LOOKOUT_WITH_OPENXR); using the Oculus runtime" << std::endl;
+        return std::unique_ptr<PoseSource>(new LivePoseSource(overlay));
+#endif
+    case POSE_SOURCE_REPLAY:
+        return std::unique_ptr<PoseSource>(new ReplayPoseSource(config.replay_file));
+    case POSE_SOURCE_SYNTHETIC:
+        return std::unique_ptr<PoseSource>(new SyntheticPoseSource(config));
+    case POSE_SOURCE_LIVE:
+    default:
+        if (config.eye_gaze) std::cerr << "[WARNING] pose_source.eye_gaze needs type 'openxr' (LibOVR has no eye tracking); head pose only" << std::endl;
+        return std::unique_ptr<PoseSource>(new LivePoseSource(overlay));
+    }
+}
+
+// lookout.exe --perf-selftest: a short run of the paths a slow or late alarm would come
+// from, on the machine at hand, printed as a report (and saved to perf_selftest.txt) for
+// a support ticket. Nothing is monitored meanwhile; the tray app doesn't start.
+int run_perf_selftest() {
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(1);
+    auto ms = [](int64_t us) { return us / 1000.0; };
+    auto progress = [](const char* what) { std::cout << "[INFO] Self-test: " << what << "..." << std::endl; };
+    // The loaders' [INFO] lines are left out of the timed runs
+    auto quietly = [](auto&& work) {
+        std::streambuf* out = std::cout.rdbuf(nullptr);
+        std::streambuf* err = std::cerr.rdbuf(nullptr);
+        work();
+        std::cout.rdbuf(out);
+        std::cerr.rdbuf(err);
+    };
+    SYSTEM_INFO system_info;
+    GetNativeSystemInfo(&system_info);
+    std::time_t started = std::time(nullptr);
+    char stamp[32];
+    std::tm local = {};
+    localtime_s(&local, &started);
+    std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &local);
+    report << "Quest Lookout performance self-test, " << stamp << ", " << system_info.dwNumberOfProcessors
+           << " logical processors\n";
+
+    // Settings parse: every consumer reads the one document, so this is the whole cost of a load or reload
+    progress("settings parse");
+    const char* settings_path = GetFileAttributesA("settings.json") != INVALID_FILE_ATTRIBUTES ? "settings.json" : "settings_default.json";
+    bool settings_ok = false;
+    std::shared_ptr<const Settings> settings;
+    quietly([&]() { settings = load_settings(settings_path, &settings_ok); });
+    LatencyHistogram parse_us, load_us;
+    quietly([&]() {
+        for (int i = 0; i < 20; ++i) {
+            int64_t start_us = monotonic_now_us();
+            nlohmann::json document = read_settings_json(settings_path);
+            int64_t parsed_us = monotonic_now_us();
+            settings_from_document(document);
+            parse_us.record(parsed_us - start_us);
+            load_us.record(monotonic_now_us() - parsed_us);
+        }
+    });
+    report << "\nSettings (" << settings_path << (settings_ok ? "" : ", unreadable: defaults") << ")\n"
+           << "  parse p50/max " << ms(parse_us.percentile(0.5)) << "/" << ms(parse_us.max_us()) << " ms, blocks p50/max "
+           << ms(load_us.percentile(0.5)) << "/" << ms(load_us.max_us()) << " ms\n";
+
+    // Timers: what a 1 ms sleep really takes, and the sampler's tick at its budget
+    progress("timer resolution and tick jitter");
+    HighResolutionTimer timer;
+    LatencyHistogram sleep_us;
+    for (int i = 0; i < 50; ++i) {
+        int64_t start_us = monotonic_now_us();
+        Sleep(1);
+        sleep_us.record(monotonic_now_us() - start_us);
+    }
+    const double budget_s = settings->sampling.adaptive ? 1.0 / settings->sampling.max_rate_hz : POLL_INTERVAL;
+    const int64_t budget_us = seconds_to_us(budget_s);
+    LatencyHistogram period_us, jitter_us;
+    {
+        TickScheduler scheduler(timer, budget_s);
+        int64_t last_us = monotonic_now_us();
+        for (int64_t end_us = last_us + 2000000; last_us < end_us;) {
+            scheduler.wait_next_tick();
+            int64_t now_us = monotonic_now_us();
+            period_us.record(now_us - last_us);
+            jitter_us.record(std::llabs(now_us - last_us - budget_us));
+            last_us = now_us;
+        }
+    }
+    report << "\nTimers\n"
+           << "  high-resolution waitable timer: " << (timer.is_high_resolution() ? "yes" : "no (standard sleep)") << "\n"
+           << "  Sleep(1) p50/max " << ms(sleep_us.percentile(0.5)) << "/" << ms(sleep_us.max_us()) << " ms\n"
+           << "  ticks at " << ms(budget_us) << " ms for 2 s: period p50/p99/max " << ms(period_us.percentile(0.5)) << "/"
+           << ms(period_us.percentile(0.99)) << "/" << ms(period_us.max_us()) << " ms, jitter p99/max "
+           << ms(jitter_us.percentile(0.99)) << "/" << ms(jitter_us.max_us()) << " ms\n";
+
+    // Headset runtime: one attempt, no waiting for the service or the headset
+    progress("headset runtime");
+    report << "\nHeadset runtime\n";
+    ovrInitParams init_params = {0};
+    init_params.Flags = ovrInit_Invisible;
+    init_params.RequestedMinorVersion = OVR_MINOR_VERSION;
+    int64_t ovr_start_us = monotonic_now_us();
+    ovrSession session = nullptr;
+    ovrGraphicsLuid luid;
+    ovrErrorInfo error_info = {};
+    if (OVR_FAILURE(ovr_Initialize(&init_params))) {
+        ovr_GetLastErrorInfo(&error_info);
+        report << "  ovr_Initialize failed: " << error_info.ErrorString << "\n";
+    } else {
+        int64_t initialized_us = monotonic_now_us();
+        if (OVR_FAILURE(ovr_Create(&session, &luid))) {
+            ovr_GetLastErrorInfo(&error_info);
+            report << "  ovr_Initialize " << ms(initialized_us - ovr_start_us) << " ms; ovr_Create failed: "
+                   << error_info.ErrorString << "\n";
+            session = nullptr;
+        } else {
+            report << "  ovr_Initialize " << ms(initialized_us - ovr_start_us) << " ms, ovr_Create "
+                   << ms(monotonic_now_us() - initialized_us) << " ms\n";
+            LatencyHistogram tracking_us, status_us;
+            ovrSessionStatus status = {};
+            for (int i = 0; i < 1000; ++i) {
+                int64_t start_us = monotonic_now_us();
+                ovrTrackingState ts = ovr_GetTrackingState(session, 0.0, ovrTrue);
+                int64_t tracked_us = monotonic_now_us();
+                ovr_GetSessionStatus(session, &status);
+                tracking_us.record(tracked_us - start_us);
+                status_us.record(monotonic_now_us() - tracked_us);
+                (void)ts;
             }
-            
-            std::this_thread::sleep_for(std::chrono::milliseconds(retry_delay_ms));
-            continue;
+            report << std::setprecision(0) << "  ovr_GetTrackingState p50/p99/max " << tracking_us.percentile(0.5) << "/"
+                   << tracking_us.percentile(0.99) << "/" << tracking_us.max_us() << " us, ovr_GetSessionStatus p50/p99/max "
+                   << status_us.percentile(0.5) << "/" << status_us.percentile(0.99) << "/" << status_us.max_us()
+                   << " us (1000 calls, headset " << (status.HmdMounted ? "on" : "off") << " head)\n" << std::setprecision(1);
+            ovr_Destroy(session);
         }
-        
-        // Success!
-        std::cout << "[INFO] OVR Session Created - HMD connected and ready!" << std::endl;
-        g_ovr_session = session;  // Store in global for hotkey access
-        break;
+        ovr_Shutdown();
+    }
+
+    // Flight detection: a full sweep of this desktop, as done at startup and every reconcile,
+    // with the sim profiles from the settings (the built-in ones as settings.json changes them)
+    progress("window detection");
+    g_sim_profiles = settings->sim_profiles;
+    int windows = 0;
+    EnumWindows([](HWND, LPARAM count) -> BOOL { ++*reinterpret_cast<int*>(count); return TRUE; },
+                reinterpret_cast<LPARAM>(&windows));
+    LatencyHistogram sweep_us;
+    SimWindowMatch found;
+    for (int i = 0; i < 11; ++i) {
+        int64_t start_us = monotonic_now_us();
+        found = find_sim_window();
+        sweep_us.record(monotonic_now_us() - start_us);
+        if (i == 0) report << "\nWindow detection (" << windows << " top-level windows, " << g_sim_profiles.size()
+                           << " sim profiles)\n  first sweep "
+                           << std::setprecision(0) << sweep_us.max_us() << " us";
+    }
+    report << ", then p50/max " << sweep_us.percentile(0.5) << "/" << sweep_us.max_us() << " us; sim window "
+           << (found.hwnd ? "found (" + g_sim_profiles[found.profile].name + ")" : std::string("not found")) << "\n"
+           << std::setprecision(1);
+
+    // Alarm audio: decoding every clip, starting the stream, and each warning reaching the device
+    progress("alarm audio");
+    AudioTriggerLatency audio;
+    quietly([&]() { audio = measure_audio_triggers(settings->alarms, settings->audio, 20); });
+    report << "\nAlarm audio\n  open (decode and test every clip) " << ms(audio.warmup_us) << " ms\n";
+    if (audio.cold_mixer_us < 0) {
+        report << "  no alarm clip could be played\n";
+    } else {
+        report << "  first trigger, stream stopped: " << ms(audio.cold_mixer_us) << " ms to mixer, "
+               << ms(audio.cold_output_us) << " ms to device\n"
+               << "  trigger, stream running: mixer p50/max " << ms(audio.mixer.percentile(0.5)) << "/"
+               << ms(audio.mixer.max_us()) << " ms, device p50/p95/max " << ms(audio.output.percentile(0.5)) << "/"
+               << ms(audio.output.percentile(0.95)) << "/" << ms(audio.output.max_us()) << " ms ("
+               << audio.output.count() << " triggers)\n";
+    }
+
+    std::cout << "\n" << report.str() << std::flush;
+    std::ofstream file("perf_selftest.txt");
+    if (file << report.str()) std::cout << "\n[INFO] Report saved to perf_selftest.txt" << std::endl;
+    return 0;
+}
+
+int app_core_logic(std::shared_ptr<const Settings> settings)
+{
+    ThreadCpuScope cpu_scope(CPU_CORE);
+    const PoseSourceConfig& pose_source_config = settings->pose_source;
+    std::unique_ptr<PoseSource> pose_source = make_pose_source(pose_source_config, settings->scan_overlay.enabled);
+    ScanOverlay scan_overlay(settings->scan_overlay); // Started and stopped with each session by the pose source
+    if (scan_overlay.enabled() && !pose_source->set_session_user(&scan_overlay)) {
+        std::cerr << "[WARNING] scan_overlay needs the live pose source; no overlay" << std::endl;
     }
+    const bool realtime_source = pose_source->realtime();
+    // Lazily opened sources connect at the first flight start and close again once the
+    // pilot hasn't flown for release_after_flight_s
+    const bool lazy_source = pose_source_config.lazy_init && realtime_source;
+    bool source_open = false;
+    HighResolutionTimer wait_timer; // Backs every wait on this thread
+    std::future<bool> source_connect;
     
-    // Check if we exited because window was closed
-    if (!IsWindow(g_hwnd)) {
-        std::cout << "[INFO] Application closing during HMD initialization." << std::endl;
-        if (ovr_initialized) {
-            ovr_Shutdown();
+    if (lazy_source) {
+        std::cout << "[INFO] Quest Lookout starting - headset connection deferred until a Condor flight starts" << std::endl;
+    } else {
+        if (pose_source_config.type == POSE_SOURCE_LIVE || pose_source_config.type == POSE_SOURCE_OPENXR) {
+            std::cout << "[INFO] Quest Lookout starting - waiting for Oculus HMD connection..." << std::endl;
+        } else {
+            std::cout << "[INFO] Quest Lookout starting with the " << pose_source->name() << " pose source" << std::endl;
         }
-        return 0;
+        // Connect on a startup task; the Run key sync, alarm tables, audio warm-up and
+        // flight detectors below get going meanwhile, and it's joined before monitoring
+        // starts. Destroyed (so waited for) before pose_source on any early return.
+        source_connect = std::async(std::launch::async, [source = pose_source.get()]() { return source->open(); });
     }
 
 
-    std::vector<LookoutAlarmConfig> alarms = load_configs("settings.json");
+    std::vector<LookoutAlarmConfig> alarm_configs = settings->alarms; // Replaced by settings reloads
     
-    // Sync Windows startup setting with settings.json
-    sync_startup_setting_from_json();
+    // Sync Windows startup setting with settings.json. Not from the defaults a missing or
+    // broken file leaves: their start_with_windows false would remove the user's autostart.
+    const int64_t registry_start_us = monotonic_now_us();
+    if (settings->loaded) {
+        sync_startup_setting(settings->start_with_windows, settings->startup);
+    } else {
+        std::cerr << "[WARNING] settings.json wasn't loaded; leaving Windows startup as it is" << std::endl;
+    }
+    record_startup_phase(STARTUP_REGISTRY, registry_start_us);
     
-    if (alarms.empty()) { 
+    if (alarm_configs.empty()) { 
         std::cerr << "[ERROR] No Alarms Loaded from settings.json. Exiting." << std::endl; 
         if (IsWindow(g_hwnd)) PostMessage(g_hwnd, WM_COMMAND, ID_TRAY_EXIT_CONTEXT_MENU_ITEM, 0); // Try to exit cleanly
-        ovr_Destroy(session); 
-        ovr_Shutdown(); 
         return 1; 
     }
+    const AudioConfig& audio_config = settings->audio;
+    AudioEngine audio(alarm_configs, audio_config); // Started with the first flight
+    AlarmLatencyStats alarm_latency(alarm_configs.size());
+    FlightScanStats scan_stats(alarm_configs.size());
+    g_log_level = settings->logging.level;
+    AsyncLog async_log(settings->logging);
+    async_log.start();
+    PoseHistory pose_history(settings->pose_history);
+    pose_history.start();
+    FlightHistory flight_history(settings->flight_history);
+    flight_history.start();
+    EngineStateStore engine_state(settings->resume);
+    engine_state.start();
+    // Left by a run that stopped mid-flight; restored at the first flight start, if that's
+    // still within restart_grace_s of the save
+    std::vector<AlarmSnapshot> saved_state;
+    int64_t saved_state_age_s = 0;
+    bool saved_state_pending = EngineStateStore::take(settings->resume, saved_state, saved_state_age_s);
+    const int64_t saved_state_taken_us = monotonic_now_us();
+    ScanHeatmap scan_heatmap(settings->scan_heatmap);
+    scan_heatmap.start();
+    EventBus event_bus; // Subscribed before the main loop; outlives every subscriber thread
+    PluginHost plugin_host(settings->plugins, event_bus);
+    MetricsRegistry metrics;
+    MetricsSink metrics_sink(metrics, settings->metrics);
+    metrics_sink.start();
+    TelemetryPublisher scan_telemetry(settings->telemetry);
+    UdpStream udp_stream(settings->udp_stream);
+    udp_stream.start();
+    FleetLink fleet(settings->fleet);
+    fleet.start();
+    PoseTraceRecorder pose_trace(settings->pose_trace); // Opened once the core clock starts
+    SettingsWatcher settings_watcher("settings.json");
+    settings_watcher.start();
+    SettingsPipeServer settings_pipe;
+    settings_pipe.start();
+    ControlPipeServer control_pipe;
+    control_pipe.start();
+    std::shared_ptr<const Settings> active_settings = settings;
+    settings_pipe.set_active(active_settings);
+    std::atomic_store(&g_active_settings, active_settings);
 
     std::cout << "[INFO] Monitoring Condor simulation windows for flight detection" << std::endl;
     
-    // Check initial Condor flight status using window detection only
-    bool condor_flight_active = is_condor_simulation_window_active();
+    // Window checks only run while a Condor process is alive
+    CondorProcessMonitor condor_process_monitor;
+    if (realtime_source) condor_process_monitor.start();
+    // Exact flight start/end/pause/replay events on top of the windows, when configured
+    CondorLogWatcher condor_log_watcher(settings->condor_log);
+    if (realtime_source) condor_log_watcher.start();
+    // Condor's UDP flight data, when enabled: suspends the alarms on the ground and
+    // picks alarm profiles by height
+    CondorUdpListener condor_udp(settings->condor_udp);
+    if (realtime_source) condor_udp.start();
+    CondorTelemetry telemetry;
+    bool telemetry_fresh = false;
+    bool flight_paused = false;
+    bool on_ground = false; // Suspended by telemetry rather than by the log
+    bool condor_process_was_alive = realtime_source && condor_process_monitor.running();
+    bool condor_sim_window_was_active = false;
+    // flight_inference: while Condor runs and its windows haven't shown a flight yet, the
+    // headset is sampled (not evaluated) between flights to see whether the pilot flies
+    const FlightInferenceConfig& inference = settings->flight_inference;
+    FlightActivityDetector activity(inference);
+    bool probing = false, window_flight_seen = false, inference_reported = false;
+
+    // Check initial Condor flight status using window detection only. Offline pose
+    // sources are one long flight.
+    bool condor_flight_active = realtime_source ? condor_process_was_alive && is_condor_simulation_window_active() : true;
     
     if (condor_flight_active) {
         std::cout << "[INFO] Condor simulation window detected - flight active." << std::endl;
@@ -888,454 +10673,1235 @@ int app_core_logic()
         std::cout << "[INFO] No Condor simulation window detected - flight inactive." << std::endl;
     }
     std::cout << "[INFO] Initial Condor flight status: " << (condor_flight_active ? "Active." : "Inactive.") << std::endl;
+
+    // The audio stack (sfml-audio and the output device) is up only during flights; the
+    // first bring-up also decodes and tests every alarm clip, well before a warning is due
+    bool audio_warmed_up = false;
+    auto bring_up_audio = [&]() {
+        if (audio.running()) return;
+        if (!audio_warmed_up) {
+            start_audio_warmup(alarm_configs, active_settings->audio);
+            audio_warmed_up = true;
+        }
+        audio.start();
+    };
+    if (condor_flight_active) bring_up_audio();
     
     std::cout << "Oculus Lookout Utility core logic started." << std::endl;
-    for (size_t i = 0; i < alarms.size(); ++i) { 
-        if (alarms[i].repeat_interval_ms < 100) alarms[i].repeat_interval_ms = 5000; 
-        if (alarms[i].min_horizontal_angle <= 0 || (alarms[i].min_vertical_angle_up <= 0 && alarms[i].min_vertical_angle_down <= 0)) {
-            std::cout << "[INFO] Alarm " << i << " is disabled (min_horizontal_angle <= 0 or both min_vertical_angle_up/down <= 0)." << std::endl;
-            alarms[i].min_horizontal_angle = -1; // Mark as disabled for later checks
-        }
-        if (alarms[i].min_horizontal_angle > 0) { 
-            std::cout << "[INFO] Alarm " << i << ": HAngle=" << alarms[i].min_horizontal_angle 
-                    << ", VAngleUp=" << alarms[i].min_vertical_angle_up 
-                    << ", VAngleDown=" << alarms[i].min_vertical_angle_down 
-                    << ", MaxTime=" << alarms[i].max_time_ms/1000.0 << "s"
-                    << ", Repeat=" << alarms[i].repeat_interval_ms/1000.0 << "s"
-                    << ", MinLookout=" << alarms[i].min_lookout_time_ms/1000.0 << "s (Min L/R diff)" 
-                    << ", SilenceAfterLook=" << alarms[i].silence_after_look_ms/1000.0 << "s"
-                    << std::endl;
-        }
+    // Only enabled alarms, indexed densely: alarm states and timers follow this indexing,
+    // while logs, audio and latency stats use each alarm's id (its settings.json index).
+    // A reload assigns a new table, so `alarms` keeps referring to the current one.
+    // Each alarm profile is compiled up front; the active one is swapped into the
+    // engine (leaving its slot empty), so a switch is two swaps and no parsing.
+    std::vector<AlarmTable> profile_tables;
+    size_t largest_profile = 0;
+    for (const AlarmProfile& profile : settings->profiles) {
+        profile_tables.push_back(compile_alarm_table(alarm_configs, profile.alarm_ids));
+        largest_profile = (std::max)(largest_profile, profile_tables.back().alarms.size());
     }
-    
-    size_t widest_alarm_idx = 0;
-    bool widest_alarm_valid = false;
-    if (!alarms.empty()) {
-        double widest_angle = 0.0; 
-        for (size_t i = 0; i < alarms.size(); ++i) {
-            if (alarms[i].min_horizontal_angle > 0) { 
-                if (!widest_alarm_valid || alarms[i].min_horizontal_angle > widest_angle) {
-                    widest_angle = alarms[i].min_horizontal_angle;
-                    widest_alarm_idx = i;
-                    widest_alarm_valid = true;
-                }
-            }
-        }
-        if (!widest_alarm_valid) { 
-            std::cerr << "[WARNING] No valid (enabled) alarms configured for widest_alarm_idx logic." << std::endl;
-        }
+    int initial_profile = find_alarm_profile(settings->profiles, settings->active_profile);
+    if (initial_profile < 0) {
+        std::cerr << "[WARNING] Unknown active_profile \"" << settings->active_profile << "\"; using \"default\"" << std::endl;
+        initial_profile = 0;
+    }
+    size_t active_profile = static_cast<size_t>(initial_profile);
+    AlarmTable initial_table;
+    std::swap(initial_table, profile_tables[active_profile]);
+    // Lookout detection and alarm timing; the core feeds it poses and carries out the
+    // audio and log events it returns
+    LookoutEngine engine(std::move(initial_table));
+    engine.reserve(largest_profile); // Profile switches reuse the storage
+    engine.set_fixed_step(static_cast<int64_t>(settings->sampling.fixed_step_ms * 1000.0));
+    engine.set_peak_sample_rate(settings->sampling.peak_rate_hz());
+    const std::vector<CompiledAlarm>& alarms = engine.alarms();
+    if (settings->profiles.size() > 1) {
+        std::cout << "[INFO] " << settings->profiles.size() << " alarm profiles; active: "
+                  << settings->profiles[active_profile].name << std::endl;
     }
 
-    double elapsed_time_ms = 0.0;
-    double log_check_timer_ms = 0.0; // Timer for checking Condor log file
+    // All engine timers run on one measured monotonic time base (int64 microseconds)
+    const int64_t clock_epoch_us = monotonic_now_us();
+    plugin_host.start(clock_epoch_us);
+    // Live sessions only: traces of replay or synthetic sources would just copy their input
+    if (realtime_source && pose_trace.open(0)) g_pose_trace.store(&pose_trace, std::memory_order_release);
+    int64_t now_us = 0;                 // Measured time since core start
+    int64_t last_loop_us = 0;           // Timestamp of the previous loop iteration
+    bool previous_tick_evaluated = false; // Paused iterations don't accrue into alarm timers
+    bool session_lost = false;          // Headset session gone; lost_state is the alarms as they were
+    int64_t session_lost_us = 0;
+    std::vector<AlarmSnapshot> lost_state;
+    int64_t next_state_save_us = 0;     // resume.persist
+    int64_t last_flight_check_us = 0;   // Last Condor flight status check
+    int64_t last_window_sweep_us = 0;   // Last full window sweep (event-driven detection)
+    bool force_flight_check = false;    // Set when an idle wait was cut short by the wake event
 
-    double center_reset_window_degrees = 20.0; 
-    double center_reset_hold_time_seconds = 3.0; 
-    double center_hold_timer_seconds = 0.0; 
-    bool center_reset_active = false; 
+    double center_reset_window_degrees = settings->center_reset.window_degrees;
+    double center_reset_hold_time_seconds = settings->center_reset.hold_time_seconds;
+    engine.set_center_reset(center_reset_window_degrees, center_reset_hold_time_seconds);
     {
-        std::ifstream f("settings.json");
-        if (f) {
-            nlohmann::json j;
-             try { 
-                f >> j; 
-                if (j.contains("center_reset")) {
-                    if (j["center_reset"].contains("window_degrees") && j["center_reset"]["window_degrees"].is_number())
-                        center_reset_window_degrees = j["center_reset"]["window_degrees"].get<double>();
-                    if (j["center_reset"].contains("hold_time_seconds") && j["center_reset"]["hold_time_seconds"].is_number())
-                        center_reset_hold_time_seconds = j["center_reset"]["hold_time_seconds"].get<double>();
-                }
-            } catch (const nlohmann::json::parse_error& e) {
-                std::cerr << "[WARNING] Could not parse center_reset from settings.json: " << e.what() << std::endl;
-            } catch (const nlohmann::json::type_error& e) {
-                std::cerr << "[WARNING] Type error for center_reset in settings.json: " << e.what() << std::endl;
-            }
-        }
         std::cout << "[INFO] Center reset: window " << center_reset_window_degrees 
                   << " deg, hold time " << center_reset_hold_time_seconds << "s (relative to Oculus origin)" << std::endl;
     }
+    // Optional record of every engine event, for comparing runs of the same trace
+    std::ofstream events_out;
+    if (!settings->pose_source.events_file.empty()) {
+        events_out.open(settings->pose_source.events_file);
+        if (events_out) {
+            events_out << "engine_us,event,alarm,value,volume\n";
+        } else {
+            std::cerr << "[WARNING] Could not write engine events to " << settings->pose_source.events_file << std::endl;
+        }
+    }
 
-    struct AlarmState {
-        bool warning_triggered = false;
-        double noLookTime_ms = 0.0, repeat_timer_ms = 0.0, warning_start_time_ms = 0.0;
-        bool looked_left_ever = false, looked_right_ever = false, looked_up_ever = false, looked_down_ever = false;
-        double left_ever_time_ms = -1.0, right_ever_time_ms = -1.0;
-        double alarm_silence_until_ms = 0.0; 
-        sf::Music* sound_player = nullptr; 
-        bool silence_message_printed_this_period = false; 
+    auto publish_event = [&](BusEvent::Type type, uint32_t alarm = 0, int64_t value = 0) {
+        if (!event_bus.has_subscribers()) return;
+        BusEvent event;
+        event.type = type;
+        event.alarm = alarm;
+        event.value = value;
+        event.engine_us = engine.engine_us();
+        event.t_us = now_us;
+        event_bus.publish(event);
     };
-    std::vector<AlarmState> alarm_states(alarms.size());
 
-    while (IsWindow(g_hwnd)) {
-        // Only check Condor log every LOG_CHECK_INTERVAL seconds
-        log_check_timer_ms += POLL_INTERVAL * 1000.0;
-        bool check_log_this_iteration = (log_check_timer_ms >= LOG_CHECK_INTERVAL * 1000.0);
-        
-        if (check_log_this_iteration) {
-            log_check_timer_ms = 0.0; // Reset the flight check timer
-            
-            // --- Monitor Condor simulation window for flight status ---
-            bool previous_iteration_flight_status = condor_flight_active;
-            bool condor_sim_window_active = is_condor_simulation_window_active();
-            
-            // Simple window-based flight detection
-            condor_flight_active = condor_sim_window_active;
+    // Carry out what the engine decided: audio by alarm id, then the log lines
+    // Per alarm id, so an alarm keeps its metrics across profile switches
+    struct AlarmMetrics {
+        size_t no_look_s, max_time_s, warning, seen, coverage_bins, silence_remaining_s;
+        size_t warnings, repeats, lookouts, narrower_resets, lr_diff_ms;
+    };
+    std::vector<AlarmMetrics> alarm_metrics;
+    std::vector<size_t> alarm_cycle_metrics; // LOOKOUT_KERNEL_CYCLES builds only
+    auto register_alarm_metrics = [&]() {
+        for (size_t id = alarm_metrics.size(); id < alarm_configs.size(); ++id) {
+            const std::string p = "alarm." + std::to_string(id) + ".";
+            if (LOOKOUT_KERNEL_CYCLES) alarm_cycle_metrics.push_back(metrics.gauge(p + "cycles_per_tick"));
+            alarm_metrics.push_back({metrics.gauge(p + "no_look_s"), metrics.gauge(p + "max_time_s"), metrics.gauge(p + "warning"),
+                                     metrics.gauge(p + "seen"), metrics.gauge(p + "coverage_bins"), metrics.gauge(p + "silence_remaining_s"),
+                                     metrics.counter(p + "warnings"), metrics.counter(p + "repeats"), metrics.counter(p + "lookouts"),
+                                     metrics.counter(p + "narrower_resets"),
+                                     metrics.histogram(p + "lr_diff_ms", {250, 500, 1000, 2000, 4000, 8000})});
+        }
+    };
+    register_alarm_metrics();
+    const size_t head_yaw_metric = metrics.gauge("head.yaw_deg");
+    const size_t head_pitch_metric = metrics.gauge("head.pitch_deg");
+    const size_t lean_lateral_metric = metrics.gauge("head.lean_lateral_cm");
+    const size_t lean_vertical_metric = metrics.gauge("head.lean_vertical_cm");
+    const size_t engine_events_metric = metrics.counter("engine.events");
+    const size_t tracking_samples_metric = metrics.counter("tracking.samples");
+    const size_t duplicate_samples_metric = metrics.counter("tracking.duplicate_samples");
+    const size_t dropped_frames_metric = metrics.counter("render.compositor_dropped_frames");
+    const size_t asw_frames_metric = metrics.counter("render.asw_frames");
+    const size_t asw_active_metric = metrics.gauge("render.asw_active");
+    const size_t compositor_latency_metric = metrics.gauge("render.compositor_latency_ms");
+    const size_t gpu_scale_metric = metrics.gauge("render.gpu_scale");
+    const size_t reconnect_restored_metric = metrics.counter("resume.reconnect_restored");
+    const size_t reconnect_reset_metric = metrics.counter("resume.reconnect_reset");
+    const size_t restart_restored_metric = metrics.counter("resume.restart_restored");
+    size_t cpu_metrics[CPU_SUBSYSTEM_COUNT];
+    for (int s = 0; s < CPU_SUBSYSTEM_COUNT; ++s) {
+        cpu_metrics[s] = metrics.gauge(std::string("cpu.") + CPU_SUBSYSTEM_NAMES[s] + ".cycles_per_tick");
+    }
+    size_t kernel_metrics[LookoutEngine::KERNEL_COUNT] = {};
+    if (LOOKOUT_KERNEL_CYCLES) {
+        for (int k = 0; k < LookoutEngine::KERNEL_COUNT; ++k) {
+            kernel_metrics[k] = metrics.gauge(std::string("engine.") + LookoutEngine::kernel_name(k) + ".cycles_per_step");
+        }
+    }
+    CpuGovernor governor(settings->cpu_budget);
+    const size_t governor_level_metric = metrics.gauge("cpu.governor.level");
+    const size_t governor_used_metric = metrics.gauge("cpu.governor.used_percent");
+    const size_t governor_tokens_metric = metrics.gauge("cpu.governor.tokens_ms");
+    const size_t governor_restored_metric = metrics.counter("cpu.governor.restored");
+    size_t governor_step_metrics[CpuGovernor::kSteps];
+    for (int s = 0; s < CpuGovernor::kSteps; ++s) {
+        governor_step_metrics[s] = metrics.counter(std::string("cpu.governor.") + CPU_GOVERNOR_STEP_NAMES[s]);
+    }
+    bool debug_before_governor = true;
+    int64_t telemetry_period_us = 0; // Governor step 2
+    int64_t next_telemetry_us = 0;
+    // Governor steps, taken one at a time in either direction
+    auto apply_governor_level = [&](int level, bool down) {
+        const int step = down ? level : level + 1; // 1-based step taken or undone
+        if (step == 1) {
+            if (down) debug_before_governor = g_debug_logging.exchange(false);
+            else g_debug_logging = debug_before_governor;
+        } else if (step == 2) {
+            telemetry_period_us = down ? static_cast<int64_t>(1e6 / settings->cpu_budget.telemetry_hz) : 0;
+        } else if (step == 3) {
+            g_sampling_floor_hz = down ? settings->cpu_budget.sampling_floor_hz : 0.0;
+        }
+        metrics.increment(down ? governor_step_metrics[step - 1] : governor_restored_metric);
+        if (down) {
+            LOOKOUT_LOG(async_log, LEVEL_WARNING, "[WARNING] CPU budget exceeded ({.2}% of one core): {}", governor.used_percent(),
+                        CPU_GOVERNOR_STEP_NAMES[step - 1]);
+        } else {
+            LOOKOUT_LOG(async_log, LEVEL_INFO, "[INFO] Back under the CPU budget: {} undone", CPU_GOVERNOR_STEP_NAMES[step - 1]);
+        }
+    };
 
-        if (condor_flight_active != previous_iteration_flight_status) {
-            if (condor_flight_active) {
-                std::cout << "[INFO] Detected Condor flight start." << std::endl;
-                // Automatically apply software recenter on flight start (capture current head position as forward)
-                g_request_baseline_reset = true;
-                std::cout << "[INFO] Auto-recentering to current head position for flight start" << std::endl;
-            } else {
-                std::cout << "[INFO] Detected Condor flight end. Resetting alarms." << std::endl;
-                for (AlarmState& s : alarm_states) {
-                    if (s.sound_player && s.sound_player->getStatus() == sf::SoundSource::Status::Playing) {
-                        s.sound_player->stop();
-                    }
-                    s.warning_triggered = false;
-                    s.noLookTime_ms = 0.0;
-                    s.repeat_timer_ms = 0.0;
-                    s.warning_start_time_ms = 0.0;
-                    s.looked_left_ever = false; s.looked_right_ever = false; s.looked_up_ever = false; s.looked_down_ever = false;
-                    s.left_ever_time_ms = -1.0; s.right_ever_time_ms = -1.0;
-                    s.alarm_silence_until_ms = 0.0;
-                    s.silence_message_printed_this_period = false;
+    // Once a second: each subsystem's thread cycles over the core ticks since the last
+    // report and, in kernel-cycle builds, the engine's cycles per step by kernel and alarm.
+    // Their total is what the CPU governor charges against the budget.
+    uint64_t cpu_ticks = 0;
+    int64_t next_cpu_report_us = 0;
+    int64_t last_cpu_report_us = 0;
+    auto report_cpu = [&](int64_t now_us) {
+        uint64_t cycles[CPU_SUBSYSTEM_COUNT] = {};
+        g_cpu_accounting.collect(cycles);
+        const double ticks = static_cast<double>((std::max<uint64_t>)(cpu_ticks, 1));
+        uint64_t total_cycles = 0;
+        for (int s = 0; s < CPU_SUBSYSTEM_COUNT; ++s) {
+            metrics.set(cpu_metrics[s], cycles[s] / ticks);
+            total_cycles += cycles[s];
+        }
+        cpu_ticks = 0;
+        if (governor.enabled() && last_cpu_report_us > 0) {
+            const int before = governor.level();
+            const int level = governor.update(total_cycles, (now_us - last_cpu_report_us) / 1e6);
+            if (level >= 0) apply_governor_level(level, level > before);
+            metrics.set(governor_level_metric, governor.level());
+            metrics.set(governor_used_metric, governor.used_percent());
+            metrics.set(governor_tokens_metric, governor.tokens_s() * 1000.0);
+        }
+        last_cpu_report_us = now_us;
+        if (!LOOKOUT_KERNEL_CYCLES) return;
+        const LookoutEngine::KernelCycles& kernel = engine.kernel_cycles();
+        const double steps = static_cast<double>((std::max<uint64_t>)(kernel.steps, 1));
+        for (int k = 0; k < LookoutEngine::KERNEL_COUNT; ++k) metrics.set(kernel_metrics[k], kernel.kernel[k] / steps);
+        for (size_t i = 0; i < kernel.alarm.size() && i < alarms.size(); ++i) {
+            if (alarms[i].id < alarm_cycle_metrics.size()) metrics.set(alarm_cycle_metrics[alarms[i].id], kernel.alarm[i] / steps);
+        }
+        engine.reset_kernel_cycles();
+    };
+
+    auto handle_events = [&](const std::vector<LookoutEvent>& events) {
+        if (!events.empty()) metrics.increment(engine_events_metric, events.size());
+        for (const LookoutEvent& event : events) {
+            TraceLoggingWrite(g_trace_provider, "AlarmEvent", TraceLoggingString(LookoutEvent::name(event.type), "Event"),
+                              TraceLoggingUInt32(event.alarm, "Alarm"), TraceLoggingInt64(event.value, "Value"));
+            if (events_out.is_open()) {
+                events_out << engine.engine_us() << ',' << LookoutEvent::name(event.type) << ',' << event.alarm << ','
+                           << event.value << ',' << event.volume << '\n';
+            }
+            const CompiledAlarm* alarm = event.index < alarms.size() ? &alarms[event.index] : nullptr;
+            switch (event.type) {
+            case LookoutEvent::WARNING_START:
+                LOOKOUT_LOG(async_log, LEVEL_DEBUG, "[DEBUG] Alarm {}: Lookout direction flags reset as warning triggers.", event.alarm);
+                alarm_latency.record_engine(event.alarm, event.value);
+                publish_event(BusEvent::WARNING_STARTED, event.alarm, event.value);
+                scan_stats.on_warning(event.alarm, engine.engine_us());
+                flight_history.on_warning(event.alarm, engine.engine_us());
+                pose_trace.mark(now_us, TRACE_MARK_WARNING, event.alarm);
+                if (fleet.active()) fleet.on_warning(event.alarm, engine.engine_us());
+                metrics.increment(alarm_metrics[event.alarm].warnings);
+                if (pose_history.config().dump_on_warning) pose_history.dump("alarm" + std::to_string(event.alarm));
+                if (audio.has_audio(event.alarm)) {
+                    audio.play(event.alarm, alarm->start_volume, alarm->end_volume, alarm->volume_ramp_ms, 0, monotonic_now_us());
+                    LOOKOUT_LOG(async_log, LEVEL_WARNING, "[WARNING] Alarm {}: Please perform a visual lookout! Vol: {}", event.alarm, event.volume);
+                } else {
+                    LOOKOUT_LOG(async_log, LEVEL_ERROR, "[ERROR] Alarm {}: Failed to create sound player for warning.", event.alarm);
+                }
+                break;
+            case LookoutEvent::WARNING_REPEAT:
+                metrics.increment(alarm_metrics[event.alarm].repeats);
+                publish_event(BusEvent::WARNING_REPEAT, event.alarm, event.value);
+                // The audio worker applies the ramp itself; it's told where the ramp stands
+                // whenever the clip (re)starts, measured on engine time
+                if (audio.has_audio(event.alarm)) {
+                    audio.play(event.alarm, alarm->start_volume, alarm->end_volume, alarm->volume_ramp_ms, event.value);
+                    LOOKOUT_LOG(async_log, LEVEL_WARNING, "[WARNING] Alarm {}: Please perform a visual lookout! (Repeat sound) Vol: {}", event.alarm, event.volume);
+                } else {
+                    LOOKOUT_LOG(async_log, LEVEL_WARNING, "[WARNING] Alarm {}: Please perform a visual lookout! (Repeat reminder - NO SOUND PLAYER)", event.alarm);
                 }
+                break;
+            case LookoutEvent::WARNING_RESUME:
+                // A reload stopped it; pick the ramp up where it was
+                audio.play(event.alarm, alarm->start_volume, alarm->end_volume, alarm->volume_ramp_ms, event.value);
+                break;
+            case LookoutEvent::MUTE:
+                if (!audio.has_audio(event.alarm)) break;
+                audio.set_muted(event.alarm, true);
+                if (event.value) LOOKOUT_LOG(async_log, LEVEL_DEBUG, "[DEBUG] Alarm {}: Warning active, volume immediately silenced due to new L/R look.", event.alarm);
+                break;
+            case LookoutEvent::UNMUTE:
+                if (!audio.has_audio(event.alarm)) break;
+                if (event.value) LOOKOUT_LOG(async_log, LEVEL_DEBUG, "[DEBUG] Alarm {}: Silence period ended for active warning. Restoring volume.", event.alarm);
+                audio.set_muted(event.alarm, false);
+                break;
+            case LookoutEvent::STOP:
+                audio.stop_alarm(event.alarm);
+                break;
+            case LookoutEvent::LOOKOUT_SUCCESS:
+                publish_event(BusEvent::LOOKOUT_SUCCESS, event.alarm, event.value);
+                scan_stats.on_lookout(event.alarm, engine.engine_us());
+                flight_history.on_lookout(event.alarm, engine.engine_us());
+                pose_trace.mark(now_us, TRACE_MARK_LOOKOUT, event.alarm);
+                if (fleet.active()) fleet.on_lookout(event.alarm, engine.engine_us());
+                metrics.increment(alarm_metrics[event.alarm].lookouts);
+                metrics.observe(alarm_metrics[event.alarm].lr_diff_ms, event.value / 1000.0);
+                LOOKOUT_LOG(async_log, LEVEL_INFO, "[INFO] Alarm {}: Lookout successful. L/R diff: {} ms. Reset.", event.alarm, event.value / 1000);
+                break;
+            case LookoutEvent::NARROWER_RESET:
+                scan_stats.on_lookout(event.alarm, engine.engine_us());
+                metrics.increment(alarm_metrics[event.alarm].narrower_resets);
+                LOOKOUT_LOG(async_log, LEVEL_INFO, "[INFO] Alarm {} success: Resetting narrower alarm {}.", event.value, event.alarm);
+                break;
+            case LookoutEvent::LOOKOUT_TOO_QUICK:
+                LOOKOUT_LOG(async_log, LEVEL_DEBUG, "[DEBUG] Alarm {}: All dirs seen, but L/R diff {} ms < {} ms. Resetting L/R flags only.",
+                            event.alarm, event.value / 1000, alarm->min_lookout_us / 1000);
+                break;
+            case LookoutEvent::DIRECTION_SEEN: {
+                static const char* const kDirectionNames[] = {"L", "R", "U", "D", "Lean L", "Lean R", "Lean V", "Coverage"};
+                publish_event(BusEvent::DIRECTION_REGISTERED, event.alarm, event.value);
+                LOOKOUT_LOG(async_log, LEVEL_DEBUG, "[DEBUG] Alarm {}: {} registered.", event.alarm, kDirectionNames[event.value]);
+                break;
+            }
+            case LookoutEvent::LOOK_SILENCED:
+                LOOKOUT_LOG(async_log, LEVEL_DEBUG, "[DEBUG] Alarm {}: New L/R look. Silencing warnings for {} ms.", event.alarm, event.value / 1000);
+                break;
+            case LookoutEvent::DUE_WHILE_SILENCED:
+                LOOKOUT_LOG(async_log, LEVEL_DEBUG, "[DEBUG] Alarm {}: Max no-look time reached, but alarm is silenced. Skipping warning.", event.alarm);
+                break;
+            case LookoutEvent::CENTER_RESET:
+                publish_event(BusEvent::CENTER_RESET);
+                LOOKOUT_LOG(async_log, LEVEL_INFO, "[INFO] Center Reset Triggered: All lookout direction flags reset (due to looking forward).");
+                break;
             }
         }
-        } // End of log check block
+    };
 
+    const SamplingConfig& sampling = settings->sampling;
+    const WatchdogConfig& watchdog_config = settings->watchdog;
+    FilterConfig filter_config = settings->filter; // Replaced by settings reloads
+    TickWatchdog watchdog("evaluator", watchdog_config, false);
+    const double evaluator_budget_seconds = sampling.adaptive ? 1.0 / sampling.max_rate_hz : POLL_INTERVAL;
 
-        if (!condor_flight_active) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(POLL_INTERVAL * 1000 * 5))); 
-            elapsed_time_ms += POLL_INTERVAL * 1000.0 * 5; 
-            continue;
+    // Shared-memory and UDP scan state, every evaluated sample (at telemetry_hz on governor
+    // step 2) and whenever the HMD drops out
+    auto publish_telemetry = [&](const LookVector& look, const LeanOffset& lean, bool hmd_ok, int64_t tick_dt_us) {
+        if (!scan_telemetry.active() && !udp_stream.active() && !control_pipe.has_clients()) return;
+        LookoutTelemetry& t = scan_telemetry.local();
+        const int64_t engine_us = engine.engine_us();
+        if (hmd_ok) {
+            ++t.ticks;
+            if (tick_dt_us > 0) {
+                float rate_hz = static_cast<float>(1e6 / tick_dt_us);
+                t.sample_rate_hz = t.sample_rate_hz > 0.0f ? t.sample_rate_hz + 0.1f * (rate_hz - t.sample_rate_hz) : rate_hz;
+            }
+            if (telemetry_period_us > 0) {
+                const int64_t now_us = monotonic_now_us();
+                if (now_us < next_telemetry_us) return;
+                next_telemetry_us = now_us + telemetry_period_us;
+            }
         }
-
-        double displayTime = ovr_GetPredictedDisplayTime(session, 0);
-        ovrTrackingState ts = ovr_GetTrackingState(session, displayTime, ovrTrue);
-        ovrSessionStatus sessionStatus;
-        ovrResult session_status_result = ovr_GetSessionStatus(session, &sessionStatus);
-        
-        // Check for Oculus recenter trigger through ShouldRecenter flag
-        static bool last_should_recenter = false;
-        if (sessionStatus.ShouldRecenter && !last_should_recenter) {
-            std::cout << "[INFO] Oculus recenter detected - triggering software recenter" << std::endl;
-            g_request_baseline_reset = true;
+        t.flags = (hmd_ok ? TELEMETRY_HMD_OK : 0) | (condor_flight_active ? TELEMETRY_FLIGHT_ACTIVE : 0);
+        t.engine_us = engine_us;
+        if (hmd_ok) {
+            double yaw_deg = 0.0, pitch_deg = 0.0;
+            look_vector_to_yaw_pitch(look, yaw_deg, pitch_deg);
+            t.yaw_deg = static_cast<float>(yaw_deg);
+            t.pitch_deg = static_cast<float>(pitch_deg);
+            t.lean_lateral_cm = lean.valid ? static_cast<float>(lean.lateral_m * 100.0) : 0.0f;
+            t.lean_vertical_cm = lean.valid ? static_cast<float>(lean.vertical_m * 100.0) : 0.0f;
+        }
+        t.active_profile = static_cast<uint32_t>(active_profile);
+        t.alarm_count = static_cast<uint32_t>((std::min)(alarms.size(), static_cast<size_t>(LOOKOUT_TELEMETRY_MAX_ALARMS)));
+        for (uint32_t i = 0; i < t.alarm_count; ++i) {
+            const LookoutEngine::AlarmState& state = engine.state(i);
+            const CompiledAlarm& alarm = alarms[i];
+            LookoutTelemetryAlarm& a = t.alarms[i];
+            const int64_t no_look_us = engine_us - state.no_look_start_us;
+            a.id = alarm.id;
+            a.seen = engine.seen(i);
+            a.required = alarm.required;
+            a.warning = state.warning_triggered ? 1 : 0;
+            a.silenced = state.alarm_silence_until_us > engine_us ? 1 : 0;
+            a.no_look_s = static_cast<float>(no_look_us / 1e6);
+            a.until_due_s = state.warning_triggered ? 0.0f : static_cast<float>((std::max<int64_t>)(0, alarm.max_time_us - no_look_us) / 1e6);
+            a.max_time_s = static_cast<float>(alarm.max_time_us / 1e6);
+            a.warnings = static_cast<uint32_t>(metrics.count(alarm_metrics[alarm.id].warnings));
+            a.lookouts = static_cast<uint32_t>(metrics.count(alarm_metrics[alarm.id].lookouts));
         }
-        last_should_recenter = sessionStatus.ShouldRecenter;
+        scan_telemetry.publish();
+        udp_stream.record(t);
+    };
 
-        // Handle baseline reference reset request
-        if (g_request_baseline_reset && (ts.StatusFlags & ovrStatus_OrientationTracked)) {
-            g_baseline_reference = ts.HeadPose.ThePose.Orientation;
-            g_has_baseline_reference = true;
-            g_request_baseline_reset = false;
-            std::cout << "[INFO] Baseline reference captured - new forward direction set" << std::endl;
+    // Metrics gauges, refreshed at 10 Hz; counters are updated as the events happen
+    int64_t next_gauge_update_us = 0;
+    auto update_gauges = [&](const LookVector& look, const LeanOffset& lean) {
+        const int64_t engine_us = engine.engine_us();
+        double yaw_deg = 0.0, pitch_deg = 0.0;
+        look_vector_to_yaw_pitch(look, yaw_deg, pitch_deg);
+        metrics.set(head_yaw_metric, yaw_deg);
+        metrics.set(head_pitch_metric, pitch_deg);
+        metrics.set(lean_lateral_metric, lean.valid ? lean.lateral_m * 100.0 : 0.0);
+        metrics.set(lean_vertical_metric, lean.valid ? lean.vertical_m * 100.0 : 0.0);
+        for (size_t i = 0; i < alarms.size(); ++i) {
+            const LookoutEngine::AlarmState& state = engine.state(i);
+            const CompiledAlarm& alarm = alarms[i];
+            const AlarmMetrics& m = alarm_metrics[alarm.id];
+            metrics.set(m.no_look_s, (engine_us - state.no_look_start_us) / 1e6);
+            metrics.set(m.max_time_s, alarm.max_time_us / 1e6);
+            metrics.set(m.warning, state.warning_triggered ? 1.0 : 0.0);
+            metrics.set(m.seen, engine.seen(i));
+            metrics.set(m.coverage_bins, engine.coverage_bins(i));
+            metrics.set(m.silence_remaining_s, (std::max)(0.0, (state.alarm_silence_until_us - engine_us) / 1e6));
         }
-        
-        // Handle software recenter request
-        if (g_request_software_recenter && (ts.StatusFlags & ovrStatus_OrientationTracked)) {
-            // Calculate current yaw (rotation around Y axis)
-            ovrQuatf currentOrientation = ts.HeadPose.ThePose.Orientation;
-            
-            // Extract yaw from quaternion (simplified for Y-axis rotation)
-            float currentYaw = atan2(2.0f * (currentOrientation.w * currentOrientation.y + currentOrientation.x * currentOrientation.z),
-                                   1.0f - 2.0f * (currentOrientation.y * currentOrientation.y + currentOrientation.z * currentOrientation.z));
-            
-            // Create offset quaternion to counter current yaw
-            g_recenter_offset.x = 0;
-            g_recenter_offset.y = sin(-currentYaw / 2.0f);
-            g_recenter_offset.z = 0;
-            g_recenter_offset.w = cos(-currentYaw / 2.0f);
-            
-            std::cout << "[INFO] Manual software recenter applied - yaw offset: " << (-currentYaw * 180.0f / M_PI) << " degrees" << std::endl;
-            g_has_manual_recenter_offset = true;
-            g_request_software_recenter = false;
+    };
+    // The sampler's latest perf stats poll, into the metrics and (dropped frames, ASW
+    // switching) as trace markers. At most once per poll.
+    RenderPerf render_perf_seen;
+    auto update_render_perf = [&]() {
+        const RenderPerf perf = pose_source->render_perf();
+        if (perf.t_us == 0 || perf.t_us == render_perf_seen.t_us) return;
+        // A new session starts its counters over
+        auto since_seen = [](uint32_t now, uint32_t seen) { return now >= seen ? now - seen : now; };
+        const uint32_t dropped = since_seen(perf.compositor_dropped_frames, render_perf_seen.compositor_dropped_frames);
+        const uint32_t asw_frames = since_seen(perf.asw_presented_frames, render_perf_seen.asw_presented_frames);
+        if (dropped) {
+            metrics.increment(dropped_frames_metric, dropped);
+            pose_trace.mark(perf.t_us, TRACE_MARK_DROPPED_FRAMES, dropped);
         }
-        
-        
-        // Check if session became invalid (actual API failure)
-        if (OVR_FAILURE(session_status_result)) {
-            std::cout << "[WARNING] HMD session lost. Attempting to reconnect..." << std::endl;
-            
-            // Try to recreate the session
-            ovr_Destroy(session);
-            g_ovr_session = nullptr;  // Clear global since session is destroyed
-            ovrGraphicsLuid luid;
-            ovrResult recreate_result = ovr_Create(&session, &luid);
-            
-            if (OVR_FAILURE(recreate_result)) {
-                std::cout << "[INFO] HMD disconnected. Waiting for reconnection..." << std::endl;
-                // Reset state and wait for HMD to come back
-                for (AlarmState& s : alarm_states) {
-                    if (s.sound_player && s.sound_player->getStatus() == sf::SoundSource::Status::Playing) {
-                        s.sound_player->stop();
-                    }
-                    s.warning_triggered = false;
-                    s.noLookTime_ms = 0.0;
-                    s.repeat_timer_ms = 0.0;
-                }
-                
-                // Wait and retry session creation
-                std::this_thread::sleep_for(std::chrono::milliseconds(3000));
-                continue;
-            } else {
-                std::cout << "[INFO] HMD session restored successfully!" << std::endl;
-                g_ovr_session = session;  // Update global for hotkey access
-                // Re-get the tracking data with new session
-                displayTime = ovr_GetPredictedDisplayTime(session, 0);
-                ts = ovr_GetTrackingState(session, displayTime, ovrTrue);
-                ovr_GetSessionStatus(session, &sessionStatus);
+        if (asw_frames) metrics.increment(asw_frames_metric, asw_frames);
+        if (perf.asw_active != render_perf_seen.asw_active) pose_trace.mark(perf.t_us, TRACE_MARK_ASW, perf.asw_active);
+        metrics.set(asw_active_metric, perf.asw_active);
+        metrics.set(compositor_latency_metric, perf.compositor_latency_ms);
+        metrics.set(gpu_scale_metric, perf.gpu_scale);
+        render_perf_seen = perf;
+    };
+    bool hmd_status_ok_previously = true; 
+    bool first_sample_logged = false;
+    PoseSample previous_sample;
+    double previous_yaw_deg = 0.0, previous_pitch_deg = 0.0; // Only kept up to date with peak interpolation
+    // Yaw is filtered unwrapped so a turn through +/-180 deg isn't smoothed the long way round
+    OneEuroFilter yaw_filter(filter_config.min_cutoff_hz, filter_config.beta, filter_config.derivative_cutoff_hz);
+    OneEuroFilter pitch_filter(filter_config.min_cutoff_hz, filter_config.beta, filter_config.derivative_cutoff_hz);
+    double unwrapped_yaw_deg = 0.0;
+    auto process_sample = [&](const PoseSample& sample) {
+        TraceLoggingWrite(g_trace_provider, "TickBegin", TraceLoggingInt64(sample.t_us, "SampleUs"));
+        struct TickEnd {
+            ~TickEnd() { TraceLoggingWrite(g_trace_provider, "TickEnd"); }
+        } tick_end; // Also on the early returns
+        now_us = sample.t_us;
+        pose_history.record(sample);
+        if (inference.enabled) activity.add(sample); // Ends an inferred flight once the head stops looking like flying
+        if (sample.flags & POSE_SESSION_LOST) {
+            // Warnings stop while the headset is gone and engine time stands still. A
+            // session back within resume.reconnect_grace_s carries every alarm on from
+            // the snapshot; after longer, the no-look periods start over.
+            if (!session_lost) {
+                session_lost = true;
+                session_lost_us = now_us;
+                lost_state = engine.snapshot(now_us);
             }
+            handle_events(engine.restart_all());
+            previous_tick_evaluated = false;
+            return;
         }
-
-        static bool hmd_status_ok_previously = true; 
-        bool hmd_currently_ok = (ts.StatusFlags & ovrStatus_OrientationTracked) &&
-                                sessionStatus.HmdMounted &&
-                                !sessionStatus.DisplayLost;
-
-        if (!hmd_currently_ok) {
+        if (!(sample.flags & POSE_HMD_OK)) {
             if (hmd_status_ok_previously) { 
                 std::cerr << "[WARNING] HMD not ready (Not tracked, not mounted, or display lost). Pausing alarms." << std::endl;
             }
             hmd_status_ok_previously = false;
-            std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(POLL_INTERVAL * 1000)));
-            elapsed_time_ms += POLL_INTERVAL * 1000.0;
-            continue;
+            previous_tick_evaluated = false;
+            publish_telemetry(sample.look, sample.lean, false, 0);
+            if (fleet.active()) fleet.on_sample(false, false);
+            plugin_host.add_pose(sample, sample.look, engine.engine_us());
+            return;
         }
         if (!hmd_status_ok_previously) { 
              std::cout << "[INFO] HMD is now ready. Resuming alarms." << std::endl;
         }
+        if (session_lost) {
+            session_lost = false;
+            const int64_t lost_us = now_us - session_lost_us;
+            if (lost_us <= seconds_to_us(settings->resume.reconnect_grace_s)) {
+                size_t restored = 0;
+                handle_events(engine.restore(lost_state, now_us, &restored));
+                metrics.increment(reconnect_restored_metric);
+                std::cout << "[INFO] Headset back after " << lost_us / 1000 << " ms; " << restored
+                          << " alarm(s) carry on where they were" << std::endl;
+            } else {
+                metrics.increment(reconnect_reset_metric);
+                std::cout << "[INFO] Headset back after " << lost_us / 1000000 << " s; every alarm starts a new no-look period" << std::endl;
+            }
+        }
+        if (!first_sample_logged) {
+            record_startup_phase(STARTUP_FIRST_SAMPLE, g_launch_us);
+            std::cout << "[TIMING] Startup: " << startup_breakdown() << std::endl;
+            for (int phase = 0; phase < STARTUP_PHASE_COUNT; ++phase) {
+                const int64_t us = g_startup_phase_us[phase].load();
+                if (us) metrics.set(metrics.gauge(std::string("startup.") + STARTUP_PHASE_NAMES[phase] + "_ms"), us / 1000.0);
+            }
+            first_sample_logged = true;
+        }
         hmd_status_ok_previously = true; 
 
-        ovrPosef pose = ts.HeadPose.ThePose;
-        ovrQuatf q = pose.Orientation;
-        double current_yaw_deg, current_pitch_deg;
-        quat_to_yaw_pitch(q, current_yaw_deg, current_pitch_deg);
-
-        double dyaw = current_yaw_deg;   
-        double dpitch = current_pitch_deg;
-
-        if (std::abs(dyaw) < center_reset_window_degrees && std::abs(dpitch) < center_reset_window_degrees) {
-            center_hold_timer_seconds += POLL_INTERVAL;
-            if (!center_reset_active && center_hold_timer_seconds >= center_reset_hold_time_seconds) {
-                for (size_t i_reset = 0; i_reset < alarms.size(); ++i_reset) { 
-                    if (alarms[i_reset].min_horizontal_angle <=0) continue; 
-                    alarm_states[i_reset].looked_left_ever = false; alarm_states[i_reset].left_ever_time_ms = -1.0;
-                    alarm_states[i_reset].looked_right_ever = false; alarm_states[i_reset].right_ever_time_ms = -1.0;
-                    alarm_states[i_reset].looked_up_ever = false;
-                    alarm_states[i_reset].looked_down_ever = false;
+        int64_t tick_dt_us = previous_tick_evaluated ? (std::max<int64_t>)(now_us - last_loop_us, 0) : 0;
+        LookVector look = sample.look;
+        double yaw_deg = 0.0, pitch_deg = 0.0;
+        if (filter_config.enabled || sampling.interpolate_peaks) {
+            look_vector_to_yaw_pitch(look, yaw_deg, pitch_deg);
+        }
+        if (filter_config.enabled) {
+            // Start over after a pause or a recenter rather than smoothing across the jump
+            if (!previous_tick_evaluated || (sample.flags & POSE_RECENTERED)) {
+                yaw_filter.reset();
+                pitch_filter.reset();
+                unwrapped_yaw_deg = yaw_deg;
+            } else {
+                double step = std::remainder(yaw_deg - std::remainder(unwrapped_yaw_deg, 360.0), 360.0);
+                unwrapped_yaw_deg += step;
+            }
+            double dt_s = tick_dt_us / 1e6;
+            yaw_deg = std::remainder(yaw_filter.filter(unwrapped_yaw_deg, dt_s), 360.0);
+            pitch_deg = pitch_filter.filter(pitch_deg, dt_s);
+            look = yaw_pitch_to_look_vector(yaw_deg, pitch_deg);
+        }
+        LookInput input;
+        input.look = look;
+        input.lean = sample.lean;
+        input.dt_us = tick_dt_us;
+        LookExtent& peaks = input.peaks;
+        if (sampling.interpolate_peaks) {
+            // A rate sign change means the head turned around between the two samples;
+            // its estimated turning point counts as a look even if neither sample saw it.
+            // Gaps longer than half a second aren't interpolated.
+            double dt_s = (sample.t_us - previous_sample.t_us) / 1e6;
+            double peak = 0.0;
+            if (previous_tick_evaluated && dt_s <= 0.5) {
+                if (interpolate_turning_point(previous_yaw_deg, previous_sample.yaw_rate_deg_s,
+                                              yaw_deg, sample.yaw_rate_deg_s, dt_s, peak)) {
+                    peaks.yaw_max = peaks.yaw_min = peak;
+                }
+                if (interpolate_turning_point(previous_pitch_deg, previous_sample.pitch_rate_deg_s,
+                                              pitch_deg, sample.pitch_rate_deg_s, dt_s, peak)) {
+                    peaks.pitch_max = peaks.pitch_min = peak;
                 }
-                center_reset_active = true; 
-                std::cout << "[INFO] Center Reset Triggered: All lookout direction flags reset (due to looking forward)." << std::endl;
             }
-        } else {
-            center_hold_timer_seconds = 0.0;
-            center_reset_active = false; 
+            previous_yaw_deg = yaw_deg;
+            previous_pitch_deg = pitch_deg;
         }
-        
-        for (size_t i = 0; i < alarms.size(); ++i) {
-            AlarmState& state = alarm_states[i];
-            const LookoutAlarmConfig& config = alarms[i];
-            if (config.min_horizontal_angle <= 0) continue; 
+        last_loop_us = now_us;
+        previous_tick_evaluated = true;
+        previous_sample = sample;
+        scan_heatmap.add(look, tick_dt_us);
+        plugin_host.add_pose(sample, look, engine.engine_us());
+        handle_events(engine.step(input, now_us));
+
+        if (now_us >= next_gauge_update_us) {
+            next_gauge_update_us = now_us + ms_to_us(100);
+            update_gauges(look, sample.lean);
+            update_render_perf();
+        }
+        publish_telemetry(look, sample.lean, true, tick_dt_us);
+        if (fleet.active()) {
+            bool warning = false;
+            for (size_t i = 0; i < alarms.size() && !warning; ++i) warning = engine.state(i).warning_triggered;
+            fleet.on_sample(true, warning);
+            if (fleet.pose_due(engine.engine_us())) {
+                double fleet_yaw_deg = 0.0, fleet_pitch_deg = 0.0;
+                look_vector_to_yaw_pitch(look, fleet_yaw_deg, fleet_pitch_deg);
+                fleet.on_pose(engine.engine_us(), fleet_yaw_deg, fleet_pitch_deg, sample.lean);
+            }
+        }
+    };
+
+    // Make another alarm profile the active one. Its alarms start a fresh no-look
+    // period; the old profile's warnings stop.
+    auto switch_alarm_profile = [&](size_t next, const char* trigger) {
+        if (next >= profile_tables.size() || next == active_profile) return;
+        handle_events(engine.swap_table(profile_tables[next]));
+        scan_stats.restart(engine.engine_us());
+        std::swap(profile_tables[active_profile], profile_tables[next]);
+        active_profile = next;
+        std::cout << "[INFO] Alarm profile \"" << active_settings->profiles[next].name << "\" selected by " << trigger
+                  << " (" << alarms.size() << " enabled alarm(s))" << std::endl;
+    };
+
+    // Telemetry profile selection: the profile with the highest above_height_m at or
+    // below the glider's height AGL, else the one chosen at flight start. It only acts
+    // when a band boundary is crossed, so a manual switch holds until the next one, and
+    // dropping back through a boundary needs kBandHysteresisM so hovering there doesn't
+    // flip profiles.
+    constexpr double kBandHysteresisM = 50.0;
+    int height_band = -1;      // Profile selected by height, -1 below every band
+    size_t base_profile = active_profile;
+    auto band_for_height = [&](double height_m) {
+        int best = -1;
+        for (size_t k = 0; k < active_settings->profiles.size(); ++k) {
+            double floor_m = active_settings->profiles[k].above_height_m;
+            if (floor_m < 0.0 || height_m < floor_m) continue;
+            if (best < 0 || floor_m > active_settings->profiles[best].above_height_m) best = static_cast<int>(k);
+        }
+        return best;
+    };
+    auto follow_height = [&](double height_m) {
+        int band = band_for_height(height_m);
+        if (band == height_band) return;
+        auto floor_of = [&](int k) { return k < 0 ? -1.0 : active_settings->profiles[k].above_height_m; };
+        if (floor_of(band) < floor_of(height_band) && band_for_height(height_m + kBandHysteresisM) == height_band) return;
+        height_band = band;
+        switch_alarm_profile(band >= 0 ? static_cast<size_t>(band) : base_profile, "telemetry");
+    };
+
+    // Memory budget between flights: the decoded clips are dropped first, then a second
+    // later (the audio worker has let go of them by then) the working set is trimmed and
+    // the footprint reported. Reported once after startup as well, with or without it.
+    bool clips_unloaded = false;
+    int64_t memory_due_us = seconds_to_us(5.0);
+
+    // A settings.json saved while running, swapped in between ticks. Alarms keep their
+    // state when one with the same identity (look and lean thresholds) is still there,
+    // under the new timings: a pilot halfway through a lookout stays halfway, and a
+    // sounding warning carries on at its ramp. Other alarms start a fresh no-look
+    // period. Blocks the running threads were built from report a restart instead.
+    auto apply_settings = [&](const std::shared_ptr<const Settings>& next, const char* source) {
+        // settings_gui pushes, then saves the same settings, and the file watch sees the save
+        if (next->document == active_settings->document) {
+            LOOKOUT_STREAM(LEVEL_DEBUG, "[DEBUG] Settings from " << source << " unchanged; nothing to apply");
+            return;
+        }
+        std::cout << "[INFO] New settings from " << source << "; applying them" << std::endl;
+        g_log_level = next->logging.level;
+        for (size_t k = 0; k < next->restart_only.size(); ++k) {
+            if (next->restart_only[k] != settings->restart_only[k]) {
+                std::cout << "[INFO] Change to \"" << RESTART_ONLY_SETTINGS[k] << "\" takes effect after restarting lookout" << std::endl;
+            }
+        }
+        if (!active_settings->loaded || next->start_with_windows != active_settings->start_with_windows ||
+            next->startup != active_settings->startup) {
+            sync_startup_setting(next->start_with_windows, next->startup, next->startup != active_settings->startup);
+        }
+
+        if (next->center_reset.window_degrees != center_reset_window_degrees ||
+            next->center_reset.hold_time_seconds != center_reset_hold_time_seconds) {
+            center_reset_window_degrees = next->center_reset.window_degrees;
+            center_reset_hold_time_seconds = next->center_reset.hold_time_seconds;
+            engine.set_center_reset(center_reset_window_degrees, center_reset_hold_time_seconds);
+            std::cout << "[INFO] Center reset: window " << center_reset_window_degrees
+                      << " deg, hold time " << center_reset_hold_time_seconds << "s" << std::endl;
+        }
+
+        const FilterConfig& next_filter = next->filter;
+        if (next_filter.enabled != filter_config.enabled || next_filter.min_cutoff_hz != filter_config.min_cutoff_hz ||
+            next_filter.beta != filter_config.beta || next_filter.derivative_cutoff_hz != filter_config.derivative_cutoff_hz) {
+            filter_config = next_filter;
+            yaw_filter = OneEuroFilter(filter_config.min_cutoff_hz, filter_config.beta, filter_config.derivative_cutoff_hz);
+            pitch_filter = OneEuroFilter(filter_config.min_cutoff_hz, filter_config.beta, filter_config.derivative_cutoff_hz);
+            previous_tick_evaluated = false; // Restart the filters on the next sample
+        }
+
+        const AudioConfig& next_audio = next->audio;
+        bool audio_changed = next_audio.stream_above_seconds != active_settings->audio.stream_above_seconds ||
+                             next_audio.duck_volume != active_settings->audio.duck_volume;
+        if (next->alarms.empty()) {
+            std::cerr << "[WARNING] No alarms in the new settings.json; keeping the current alarms" << std::endl;
+        } else if (audio_changed || nlohmann::json(next->alarms) != nlohmann::json(alarm_configs) ||
+                   next->profiles != active_settings->profiles) {
+            std::vector<AlarmTable> next_tables;
+            size_t next_largest = 0;
+            for (const AlarmProfile& profile : next->profiles) {
+                next_tables.push_back(compile_alarm_table(next->alarms, profile.alarm_ids));
+                next_largest = (std::max)(next_largest, next_tables.back().alarms.size());
+            }
+            // Stay on the same profile while it still exists
+            int next_active = find_alarm_profile(next->profiles, active_settings->profiles[active_profile].name);
+            if (next_active < 0) next_active = (std::max)(0, find_alarm_profile(next->profiles, next->active_profile));
+            AlarmTable next_table;
+            std::swap(next_table, next_tables[next_active]);
+
+            // Match each new alarm to an unclaimed old one with the same identity
+            std::vector<int> carried_from(next_table.alarms.size(), -1);
+            std::vector<bool> claimed(alarms.size(), false);
+            for (size_t n = 0; n < next_table.alarms.size(); ++n) {
+                const LookoutAlarmConfig& config = next->alarms[next_table.alarms[n].id];
+                for (size_t o = 0; o < alarms.size(); ++o) {
+                    if (claimed[o] || !alarm_configs[alarms[o].id].same_identity(config)) continue;
+                    claimed[o] = true;
+                    carried_from[n] = static_cast<int>(o);
+                    break;
+                }
+            }
 
-            bool currently_looking_left = dyaw > (config.min_horizontal_angle / 2.0);
-            bool currently_looking_right = dyaw < -(config.min_horizontal_angle / 2.0);
-            bool currently_looking_up = dpitch > config.min_vertical_angle_up;
-            bool currently_looking_down = dpitch < -config.min_vertical_angle_down;
+            alarm_configs = next->alarms;
+            profile_tables = std::move(next_tables);
+            active_profile = static_cast<size_t>(next_active);
+            height_band = -1;
+            base_profile = active_profile;
+            audio.reconfigure(alarm_configs, next_audio);
+            if (clips_unloaded) {
+                clips_unloaded = false; // Decoded again; drop them once more while idle
+                memory_due_us = monotonic_now_us() - clock_epoch_us;
+            }
+            alarm_latency.end_flight(condor_flight_active);
+            alarm_latency.resize(alarm_configs.size());
+            scan_stats.resize(alarm_configs.size(), engine.engine_us());
+            register_alarm_metrics();
+            // Carried alarms keep their state under the new timings; sounding ones resume
+            engine.reserve(next_largest);
+            handle_events(engine.replace_table(std::move(next_table), carried_from));
+            size_t carried = std::count_if(carried_from.begin(), carried_from.end(), [](int o) { return o >= 0; });
+            std::cout << "[INFO] Alarms reloaded: " << alarms.size() << " enabled alarm(s) in profile \""
+                      << next->profiles[active_profile].name << "\", state kept for " << carried << std::endl;
+        }
+        active_settings = next;
+        settings_pipe.set_active(active_settings);
+        std::atomic_store(&g_active_settings, active_settings);
+    };
+
+    bool user_paused = false; // PAUSE command: no evaluation until RESUME, as in a paused flight
+    auto start_pose_source = [&]() {
+        pose_source->set_active(condor_flight_active && !flight_paused && !user_paused);
+        pose_source->start(sampling, watchdog_config, clock_epoch_us);
+    };
+    // open() runs on the connect task with the source to itself; start_pose_source
+    // applies the state current when it's done
+    auto set_source_active = [&](bool active) {
+        if (!source_connect.valid()) pose_source->set_active(active);
+    };
 
-            bool new_lr_look_this_tick = false;
-            if (currently_looking_left && !state.looked_left_ever) { 
-                state.looked_left_ever = true; state.left_ever_time_ms = elapsed_time_ms; new_lr_look_this_tick = true;
-                std::cout << "[DEBUG] Alarm " << i << ": L registered." << std::endl;
+    // A command from g_core_commands. Recenters go on to the sampling thread, which
+    // applies them to its next tracked pose.
+    auto run_core_command = [&](CoreCommand::Type type) {
+        switch (type) {
+        case CoreCommand::RECENTER:
+            if (!source_open) {
+                std::cout << "[WARNING] Cannot recenter: headset not connected" << std::endl;
+                break;
+            }
+            g_pending_recenter.fetch_or(RECENTER_HARDWARE | RECENTER_SOFTWARE, std::memory_order_release);
+            std::cout << "[INFO] Quest Lookout tracking reference reset requested" << std::endl;
+            break;
+        case CoreCommand::BASELINE_RESET:
+            g_pending_recenter.fetch_or(RECENTER_BASELINE_RESET, std::memory_order_release);
+            break;
+        case CoreCommand::RELOAD_SETTINGS: {
+            bool ok = false;
+            std::shared_ptr<const Settings> next = load_settings("settings.json", &ok);
+            if (ok) {
+                apply_settings(next, "settings.json");
+            } else {
+                std::cerr << "[WARNING] settings.json could not be read; keeping the current settings" << std::endl;
+            }
+            break;
+        }
+        case CoreCommand::PAUSE:
+        case CoreCommand::RESUME: {
+            const bool pause = type == CoreCommand::PAUSE;
+            if (pause == user_paused) break;
+            user_paused = pause;
+            g_alarms_paused = pause;
+            const bool flying = condor_flight_active && !flight_paused;
+            if (pause) {
+                std::cout << "[INFO] Alarms paused" << std::endl;
+                if (flying) {
+                    set_source_active(false);
+                    handle_events(engine.reset_all()); // Silences a sounding warning
+                }
+            } else {
+                std::cout << "[INFO] Alarms resumed" << std::endl;
+                if (flying) {
+                    scan_stats.restart(engine.engine_us());
+                    set_source_active(true);
+                }
             }
-            if (currently_looking_right && !state.looked_right_ever) {
-                state.looked_right_ever = true; state.right_ever_time_ms = elapsed_time_ms; new_lr_look_this_tick = true;
-                std::cout << "[DEBUG] Alarm " << i << ": R registered." << std::endl;
+            break;
+        }
+        case CoreCommand::SNOOZE:
+            if (condor_flight_active) {
+                handle_events(engine.snooze(seconds_to_us(g_snooze_seconds)));
+                std::cout << "[INFO] Alarms snoozed for " << g_snooze_seconds << " s" << std::endl;
+            }
+            break;
+        case CoreCommand::NEXT_PROFILE:
+            if (profile_tables.size() < 2) std::cout << "[INFO] Only one alarm profile configured" << std::endl;
+            switch_alarm_profile((active_profile + 1) % profile_tables.size(), "hotkey");
+            break;
+        case CoreCommand::SHOW_STATUS:
+            if (g_headless) {
+                // No status window to open: the line the tray tooltip would show goes to the log
+                std::shared_ptr<const std::string> tip = std::atomic_load(&g_tray_tip);
+                std::cout << "[INFO] " << (tip ? *tip : std::string("Quest Lookout")) << std::endl;
+            } else {
+                PostMessage(g_hwnd, WM_APP_SHOW_STATUS, 0, 0);
+            }
+            break;
+        case CoreCommand::EXIT:
+            std::cout << "[INFO] Exit requested" << std::endl;
+            request_shutdown();
+            // The tray's Exit: the window's teardown removes the icon and ends the message loop
+            if (!g_headless && IsWindow(g_hwnd)) PostMessage(g_hwnd, WM_COMMAND, ID_TRAY_EXIT_CONTEXT_MENU_ITEM, 0);
+            break;
+        case CoreCommand::TYPE_COUNT:
+            break;
+        case CoreCommand::DUMP_POSE_HISTORY:
+            if (!pose_history.dump("manual")) {
+                std::cout << "[INFO] No head motion history to save" << (pose_history.config().enabled ? " yet" : " (pose_history disabled)") << std::endl;
             }
-            if (currently_looking_up && !state.looked_up_ever) { 
-                state.looked_up_ever = true;
-                 std::cout << "[DEBUG] Alarm " << i << ": U registered." << std::endl;
+            break;
+        case CoreCommand::DUMP_HEATMAP:
+            if (!scan_heatmap.dump("manual")) {
+                std::cout << "[INFO] No scan heatmap to save" << (scan_heatmap.enabled() ? " yet" : " (scan_heatmap disabled)") << std::endl;
             }
-            if (currently_looking_down && !state.looked_down_ever) { 
-                state.looked_down_ever = true;
-                std::cout << "[DEBUG] Alarm " << i << ": D registered." << std::endl;
+            break;
+        }
+    };
+    // Scan overlay word: the unscanned directions of the alarm closest to sounding
+    auto overlay_state = [&]() -> uint32_t {
+        int64_t soonest_us = INT64_MAX;
+        uint32_t state = 0;
+        const int64_t engine_us = engine.engine_us();
+        for (size_t i = 0; i < alarms.size(); ++i) {
+            const LookoutEngine::AlarmState& s = engine.state(i);
+            const int64_t remaining_us = s.warning_triggered ? 0 : alarms[i].max_time_us - (engine_us - s.no_look_start_us);
+            if (remaining_us >= soonest_us) continue;
+            soonest_us = remaining_us;
+            state = (alarms[i].required & ~engine.seen(i) & 0xFFu) | (s.warning_triggered ? ScanOverlay::kSounding : 0);
+        }
+        return state;
+    };
+    // Tray tooltip: what the monitor is doing, checked once a second and sent to the
+    // shell only when the text changes
+    std::string tray_tip;
+    int64_t next_tray_tip_us = 0;
+    auto update_tray_tip = [&]() {
+        if (now_us < next_tray_tip_us) return;
+        next_tray_tip_us = now_us + seconds_to_us(TRAY_TIP_INTERVAL);
+        std::string status;
+        if (user_paused) status = "alarms paused";
+        else if (!condor_flight_active) status = "no flight";
+        else if (flight_paused) status = on_ground ? "flying, on the ground" : "flight paused";
+        else if (!source_open || !hmd_status_ok_previously) status = "flying, HMD not ready";
+        else {
+            int64_t until_due_us = INT64_MAX;
+            const int64_t engine_us = engine.engine_us();
+            for (size_t i = 0; i < alarms.size(); ++i) {
+                const LookoutEngine::AlarmState& state = engine.state(i);
+                const int64_t remaining_us = state.warning_triggered ? 0 : alarms[i].max_time_us - (engine_us - state.no_look_start_us);
+                until_due_us = (std::min)(until_due_us, (std::max<int64_t>)(0, remaining_us));
             }
+            status = "flying, HMD OK, ";
+            if (until_due_us == INT64_MAX) status += "no alarms";
+            else if (until_due_us == 0) status += "alarm sounding";
+            else status += "next alarm in " + std::to_string((until_due_us + 999999) / 1000000) + " s";
+        }
+        std::string tip = "Quest Lookout - " + status;
+        if (tip == tray_tip) return;
+        tray_tip = tip;
+        set_tray_tip(tip);
+    };
+
+    if (source_connect.valid()) {
+        source_open = source_connect.get();
+        if (!source_open) {
+            // Window closed while waiting for the HMD, or the replay file is missing
+            std::cout << "[INFO] Application closing during HMD initialization." << std::endl;
+            return 0;
+        }
+    }
+    record_startup_phase(STARTUP_ARMED, g_launch_us);
+    // The startup task launched lookout at background priority, out of the logon rush;
+    // monitoring runs at normal CPU priority. The low I/O priority stays: lookout's own
+    // disk writes (logs, recordings, history) are background work anyway.
+    if (g_started_by_task) SetPriorityClass(GetCurrentProcess(), NORMAL_PRIORITY_CLASS);
+
+    // The pilot and profile the flight is filed under
+    auto begin_flight_history = [&]() {
+        const int sim = g_sim_profile_index.load();
+        flight_history.begin_flight(engine.engine_us(), active_settings->flight_history.pilot,
+                                    active_settings->profiles[active_profile].name,
+                                    sim >= 0 ? g_sim_profiles[sim].name : std::string("Condor"), alarms.size());
+    };
+    // lookout.exe restarted mid-flight: the alarms pick up where the last run left them
+    auto restore_saved_state = [&](int64_t at_us) {
+        if (!saved_state_pending) return;
+        saved_state_pending = false;
+        const int64_t age_s = saved_state_age_s + (monotonic_now_us() - saved_state_taken_us) / 1000000;
+        if (age_s > settings->resume.restart_grace_s) {
+            std::cout << "[INFO] Not restoring the last run's alarms: saved " << age_s << " s ago" << std::endl;
+            return;
+        }
+        size_t restored = 0;
+        handle_events(engine.restore(saved_state, at_us, &restored));
+        metrics.increment(restart_restored_metric);
+        std::cout << "[INFO] Restored " << restored << " alarm(s) as the last run left them " << age_s
+                  << " s ago" << std::endl;
+    };
+    if (condor_flight_active) { // Flying at launch
+        restore_saved_state(monotonic_now_us() - clock_epoch_us);
+        begin_flight_history();
+        publish_event(BusEvent::FLIGHT_START);
+    }
+
+    // Lazy connects run on a task like the startup one, so a slow headset runtime never
+    // holds up the loop: commands, flight checks and the pipes keep being served, and the
+    // task wakes the loop when it's done.
+    auto begin_source_connect = [&]() {
+        if (source_connect.valid()) return;
+        source_connect = std::async(std::launch::async, [source = pose_source.get()]() {
+            const bool open = source->open();
+            wake_core_thread();
+            return open;
+        });
+    };
+    auto poll_source_connect = [&]() {
+        if (!source_connect.valid() ||
+            source_connect.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return;
+        }
+        source_open = source_connect.get();
+        if (source_open) {
+            start_pose_source();
+        } else if (!shutdown_requested()) {
+            std::cerr << "[WARNING] Could not connect to the headset; alarms inactive for this flight" << std::endl;
+        }
+    };
+
+    int64_t flight_end_us = 0;
+    if (lazy_source && condor_flight_active) {
+        // Already flying at launch: connect now rather than waiting for the next flight start
+        begin_source_connect();
+    }
+    if (source_open) start_pose_source();
+    std::vector<PoseSample> sample_batch(PoseSampler::kRingCapacity);
+    uint64_t dropped_samples_reported = 0;
+    uint64_t duplicate_samples_reported = 0;
+    uint64_t total_evaluated = 0;
+
+    while (!shutdown_requested() && (g_headless || IsWindow(g_hwnd))) {
+        if (std::shared_ptr<const Settings> next = settings_watcher.take()) {
+            apply_settings(next, "settings.json");
+            if (fleet.active()) fleet.refresh_config_hash();
+        }
+        if (std::shared_ptr<const Settings> next = settings_pipe.take()) apply_settings(next, "settings_gui");
+        if (std::shared_ptr<const Settings> next = fleet.take_settings()) apply_settings(next, "lookout_hub");
+        if (std::shared_ptr<const std::string> name = settings_pipe.take_profile()) {
+            int k = find_alarm_profile(active_settings->profiles, *name);
+            if (k >= 0) switch_alarm_profile(static_cast<size_t>(k), "settings_gui");
+        }
+        CoreCommand command;
+        while (g_core_commands.try_pop(command)) run_core_command(command.type);
+        now_us = monotonic_now_us() - clock_epoch_us;
+        watchdog.begin_tick(now_us);
+        if (condor_udp.listening()) {
+            condor_udp.poll(now_us);
+            telemetry = condor_udp.latest();
+            telemetry_fresh = telemetry.fresh(now_us, condor_udp.config());
+            if (telemetry_fresh && condor_flight_active && !std::isnan(telemetry.height_m)) follow_height(telemetry.height_m);
+        }
+        if (fleet.active()) {
+            const uint32_t flags = (source_open && hmd_status_ok_previously ? TELEMETRY_HMD_OK : 0) |
+                                   (condor_flight_active ? TELEMETRY_FLIGHT_ACTIVE : 0);
+            fleet.poll(now_us, flags, alarms.size(), active_profile);
+        }
+
+        // With window event hooks the flight status is just a flag, so read it every tick;
+        // otherwise sweep the windows every LOG_CHECK_INTERVAL seconds (or right away after
+        // an idle wake-up)
+        bool window_events = g_condor_window_hooks_installed.load();
+        bool check_log_this_iteration = realtime_source && (window_events || force_flight_check ||
+                                        (now_us - last_flight_check_us >= seconds_to_us(LOG_CHECK_INTERVAL)));
+        force_flight_check = false;
+        
+        if (check_log_this_iteration) {
+            last_flight_check_us = now_us; // Reset the flight check timer
             
-            static double last_periodic_state_dump_time_ms = 0.0; 
-            if (elapsed_time_ms - last_periodic_state_dump_time_ms >= 5000.0) { 
-                 std::cout << std::fixed << std::setprecision(1) 
-                           << "[STATE] Alarm " << i 
-                           << ": HMD_Yaw: " << dyaw << ", HMD_Pitch: " << dpitch
-                           << " | L:" << state.looked_left_ever << "(" << state.left_ever_time_ms/1000.0 << "s)" 
-                           << " R:" << state.looked_right_ever << "(" << state.right_ever_time_ms/1000.0 << "s)"
-                           << " U:" << state.looked_up_ever << " D:" << state.looked_down_ever
-                           << " | noLook: " << state.noLookTime_ms / 1000.0 << "s / " << config.max_time_ms / 1000.0 << "s"
-                           << " | warn: " << state.warning_triggered
-                           << " | rptTmr: " << state.repeat_timer_ms/1000.0 << "s/" << config.repeat_interval_ms/1000.0 << "s"
-                           << " | silenceRem: " << std::max(0.0, (state.alarm_silence_until_ms - elapsed_time_ms)/1000.0) << "s"
-                           << std::endl;
-                if (i == alarms.size() - 1) last_periodic_state_dump_time_ms = elapsed_time_ms; 
-            }
-
-            state.noLookTime_ms += POLL_INTERVAL * 1000.0;
-            if(state.warning_triggered) {
-                state.repeat_timer_ms += POLL_INTERVAL * 1000.0;
+            // --- Monitor Condor simulation window for flight status ---
+            bool previous_iteration_flight_status = condor_flight_active;
+            bool condor_sim_window_active;
+            bool condor_process_alive = condor_process_monitor.running();
+            if (!condor_process_alive) {
+                set_condor_sim_window(nullptr); // No Condor, no window to look for
+                condor_sim_window_active = false;
+            } else if (!window_events) {
+                condor_sim_window_active = is_condor_simulation_window_active();
+            } else if (!condor_process_was_alive ||
+                       now_us - last_window_sweep_us >= seconds_to_us(CONDOR_WINDOW_RECONCILE_INTERVAL)) {
+                // Just started (events were ignored until now), or catch any missed event
+                last_window_sweep_us = now_us;
+                condor_sim_window_active = is_condor_simulation_window_active();
+            } else {
+                condor_sim_window_active = g_condor_sim_hwnd.load() != nullptr;
             }
+            condor_process_was_alive = condor_process_alive;
             
-            if (state.looked_left_ever && state.looked_right_ever && state.looked_up_ever && state.looked_down_ever) {
-                double lr_time_diff_ms = std::abs(state.left_ever_time_ms - state.right_ever_time_ms); 
-                if (lr_time_diff_ms >= config.min_lookout_time_ms) { 
-                    state.noLookTime_ms = 0.0; state.warning_triggered = false; state.repeat_timer_ms = 0.0;
-                    state.looked_left_ever = false; state.left_ever_time_ms = -1.0;
-                    state.looked_right_ever = false; state.right_ever_time_ms = -1.0;
-                    state.looked_up_ever = false; state.looked_down_ever = false;
-                    state.silence_message_printed_this_period = false; state.alarm_silence_until_ms = 0; 
-                    if (state.sound_player) { state.sound_player->stop(); }
-                    std::cout << "[INFO] Alarm " << i << ": Lookout successful. L/R diff: " << lr_time_diff_ms << " ms. Reset." << std::endl;
-                    
-                    if (widest_alarm_valid && i == widest_alarm_idx) { 
-                        for (size_t j = 0; j < alarms.size(); ++j) {
-                             if (alarms[j].min_horizontal_angle <= 0) continue; 
-                            if (j != i && alarms[j].min_horizontal_angle < config.min_horizontal_angle) { 
-                                alarm_states[j].noLookTime_ms = 0.0; alarm_states[j].warning_triggered = false; alarm_states[j].repeat_timer_ms = 0.0;
-                                alarm_states[j].looked_left_ever = false; alarm_states[j].left_ever_time_ms = -1.0;
-                                alarm_states[j].looked_right_ever = false; alarm_states[j].right_ever_time_ms = -1.0;
-                                alarm_states[j].looked_up_ever = false; alarm_states[j].looked_down_ever = false;
-                                alarm_states[j].silence_message_printed_this_period = false; alarm_states[j].alarm_silence_until_ms = 0;
-                                if (alarm_states[j].sound_player) { alarm_states[j].sound_player->stop(); }
-                                std::cout << "[INFO] Alarm " << i << " (widest) success: Resetting narrower alarm " << j << "." << std::endl;
-                            }
-                        }
-                    }
-                    continue; 
-                } else { 
-                    std::cout << "[DEBUG] Alarm " << i << ": All dirs seen, but L/R diff " << lr_time_diff_ms 
-                              << " ms < " << config.min_lookout_time_ms << " ms. Resetting L/R flags only." << std::endl;
-                    state.looked_left_ever = false; state.left_ever_time_ms = -1.0;
-                    state.looked_right_ever = false; state.right_ever_time_ms = -1.0;
+            // Window-based flight detection, narrowed down by the Condor log when it knows
+            // better: a sim window in replay or after the flight ended isn't a flight
+            condor_flight_active = condor_sim_window_active;
+            CondorLogWatcher::State log_state = condor_log_watcher.state();
+            if (!condor_sim_window_active) {
+                // Also after a flight the log had already ended, or a replay: an ENDED or
+                // REPLAY read between flights mustn't carry into the next one
+                if (condor_sim_window_was_active || previous_iteration_flight_status) condor_log_watcher.reset_state();
+            } else if (log_state == CondorLogWatcher::STATE_ENDED || log_state == CondorLogWatcher::STATE_REPLAY) {
+                condor_flight_active = false;
+            }
+            condor_sim_window_was_active = condor_sim_window_active;
+            // No flight window, but the head says flying: the window heuristics may no
+            // longer recognize the sim. Only until they find a flight this Condor session,
+            // so the pilot sitting on in the headset after a flight isn't taken for one.
+            if (condor_flight_active) window_flight_seen = true;
+            if (!condor_process_alive) window_flight_seen = inference_reported = false;
+            if (!condor_flight_active && condor_process_alive && !window_flight_seen && inference.enabled &&
+                activity.flying() && log_state != CondorLogWatcher::STATE_ENDED && log_state != CondorLogWatcher::STATE_REPLAY) {
+                if (!inference_reported) {
+                    std::cerr << "[WARNING] Head motion looks like flying, but no flight window was found - check sim_profiles. "
+                              << (inference.fallback ? "Running the alarms on the inferred flight." : "Alarms stay off (flight_inference.fallback).")
+                              << std::endl;
+                    inference_reported = true;
                 }
+                if (inference.fallback) condor_flight_active = true;
             }
-            
-            if (new_lr_look_this_tick) { 
-                state.alarm_silence_until_ms = elapsed_time_ms + config.silence_after_look_ms;
-                std::cout << "[DEBUG] Alarm " << i << ": New L/R look. Silencing warnings for " << config.silence_after_look_ms << " ms." << std::endl;
-                if (state.warning_triggered && state.sound_player) { 
-                     state.sound_player->setVolume(0);
-                     if (!state.silence_message_printed_this_period) {
-                        std::cout << "[DEBUG] Alarm " << i << ": Warning active, volume immediately silenced due to new L/R look." << std::endl;
-                        state.silence_message_printed_this_period = true;
-                     }
+            on_ground = condor_flight_active && telemetry_fresh && condor_udp.config().suspend_on_ground &&
+                        telemetry.on_ground(condor_udp.config());
+            bool log_paused = condor_flight_active && (log_state == CondorLogWatcher::STATE_PAUSED || on_ground);
+
+        if (condor_flight_active != previous_iteration_flight_status) {
+            if (condor_flight_active) {
+                int profile = g_sim_profile_index.load();
+                std::cout << "[INFO] Detected " << (profile >= 0 ? g_sim_profiles[profile].name : std::string("Condor"))
+                          << " flight start." << std::endl;
+                const std::string sim_name = to_lower_ascii(profile >= 0 ? g_sim_profiles[profile].name : std::string("Condor"));
+                for (size_t k = 0; k < active_settings->profiles.size(); ++k) {
+                    if (to_lower_ascii(active_settings->profiles[k].sim) != sim_name) continue;
+                    switch_alarm_profile(k, "flight start");
+                    break;
                 }
+                base_profile = active_profile;
+                height_band = -1;
+                // Automatically apply software recenter on flight start (capture current head position as forward)
+                g_pending_recenter.fetch_or(RECENTER_BASELINE_RESET, std::memory_order_release);
+                std::cout << "[INFO] Auto-recentering to current head position for flight start" << std::endl;
+                scan_stats.begin_flight(engine.engine_us());
+                begin_flight_history();
+                restore_saved_state(now_us);
+                next_state_save_us = now_us;
+                publish_event(BusEvent::FLIGHT_START);
+                scan_heatmap.clear();
+                pose_trace.mark(now_us, TRACE_MARK_FLIGHT_START);
+                if (fleet.active()) fleet.on_flight(true, engine.engine_us());
+                if (clips_unloaded) {
+                    // Decoded well before the first warning can be due
+                    audio.reconfigure(alarm_configs, active_settings->audio);
+                    clips_unloaded = false;
+                }
+                bring_up_audio();
+                if (!source_open) {
+                    // Started once the headset runtime answers; see poll_source_connect
+                    begin_source_connect();
+                }
+                set_source_active(!user_paused);
+            } else {
+                std::cout << "[INFO] Detected Condor flight end. Resetting alarms." << std::endl;
+                set_source_active(false);
+                alarm_latency.collect(audio);
+                audio.stop(); // Until the next flight start
+                alarm_latency.end_flight();
+                scan_stats.end_flight(engine.engine_us());
+                flight_history.end_flight(engine.engine_us());
+                publish_event(BusEvent::FLIGHT_END);
+                scan_heatmap.dump("flight", true);
+                scan_heatmap.clear();
+                pose_trace.mark(now_us, TRACE_MARK_FLIGHT_END);
+                if (fleet.active()) fleet.on_flight(false, engine.engine_us());
+                flight_end_us = now_us;
+                handle_events(engine.reset_all());
+                session_lost = false; // A session back in the next flight starts it fresh
+                engine_state.discard();
+                memory_due_us = now_us;
             }
-            
-            if (!state.warning_triggered && state.noLookTime_ms >= config.max_time_ms) {
-                if (elapsed_time_ms < state.alarm_silence_until_ms) { 
-                    if (!state.silence_message_printed_this_period) { 
-                        std::cout << "[DEBUG] Alarm " << i << ": Max no-look time reached, but alarm is silenced. Skipping warning." << std::endl;
-                        state.silence_message_printed_this_period = true; 
-                    }
-                    continue; 
-                } else { 
-                    state.silence_message_printed_this_period = false; 
-                    state.warning_triggered = true;
-                    state.repeat_timer_ms = 0.0; 
-                    state.warning_start_time_ms = elapsed_time_ms;
-
-                    state.looked_left_ever = false; state.left_ever_time_ms = -1.0; 
-                    state.looked_right_ever = false; state.right_ever_time_ms = -1.0;
-                    state.looked_up_ever = false; state.looked_down_ever = false;
-                    std::cout << "[DEBUG] Alarm " << i << ": Lookout direction flags reset as warning triggers." << std::endl;
-                    
-                    if(state.sound_player) { 
-                        try {
-                            state.sound_player->stop();
-                        } catch (...) {
-                            std::cerr << "[WARNING] Exception stopping previous sound player" << std::endl;
-                        }
-                        delete state.sound_player; 
-                        state.sound_player = nullptr;
-                    }
-                    
-                    state.sound_player = get_or_create_sound_player(config.audio_file);
-
-                    if (state.sound_player) {
-                        try {
-                            int cur_volume = config.start_volume;
-                            state.sound_player->setVolume(static_cast<float>(cur_volume));
-                            state.sound_player->play();
-                            std::cout << "[WARNING] Alarm " << i << ": Please perform a visual lookout! Vol: " << cur_volume << std::endl;
-                        } catch (const std::exception& e) {
-                            std::cerr << "[ERROR] Alarm " << i << ": Exception playing audio: " << e.what() << std::endl;
-                            delete state.sound_player;
-                            state.sound_player = nullptr;
-                        } catch (...) {
-                            std::cerr << "[ERROR] Alarm " << i << ": Unknown exception playing audio" << std::endl;
-                            delete state.sound_player;
-                            state.sound_player = nullptr;
-                        }
-                    } else {
-                        std::cerr << "[ERROR] Alarm " << i << ": Failed to create sound player for warning." << std::endl;
-                    }
+        }
+
+        // Paused: no evaluation, and the time spent paused mustn't count against the pilot
+        if (log_paused != flight_paused) {
+            if (log_paused) {
+                std::cout << (on_ground ? "[INFO] On the ground (Condor telemetry). Alarms suspended."
+                                        : "[INFO] Condor flight paused. Alarms suspended.") << std::endl;
+                set_source_active(false);
+            } else if (condor_flight_active && !user_paused) {
+                std::cout << "[INFO] Condor flight resumed. Resetting alarms." << std::endl;
+                handle_events(engine.reset_all());
+                scan_stats.restart(engine.engine_us());
+                set_source_active(true);
+            }
+            flight_paused = log_paused;
+        }
+
+        // Sample between flights for flight_inference. A flight starting from here keeps
+        // the source active and the detector's history.
+        const bool probe = inference.enabled && source_open && condor_process_alive && !window_flight_seen &&
+                           !condor_flight_active && !user_paused;
+        if (probe != probing) {
+            probing = probe;
+            if (probe) activity.reset();
+            if (probe || !condor_flight_active) set_source_active(probe);
+        }
+        } // End of log check block
+        poll_source_connect();
+        watchdog.end_phase(TickWatchdog::PHASE_FLIGHT_CHECK, monotonic_now_us() - clock_epoch_us);
+        update_tray_tip();
+        control_pipe.set_flight(condor_flight_active);
+        ++cpu_ticks;
+        if (now_us >= next_cpu_report_us) {
+            next_cpu_report_us = now_us + seconds_to_us(1.0);
+            report_cpu(now_us);
+        }
+        if (engine_state.enabled() && condor_flight_active && now_us >= next_state_save_us) {
+            next_state_save_us = now_us + seconds_to_us(ENGINE_STATE_SAVE_INTERVAL);
+            // Headset gone: the engine was restarted, so the state worth keeping is the lost one
+            engine_state.save(session_lost ? lost_state : engine.snapshot(now_us));
+        }
+
+        if (!condor_flight_active || flight_paused || user_paused || source_connect.valid()) {
+            // Idle: the sampler makes no OVR queries either. Sleep until the next flight
+            // check is due, or until something signals the wake event (the connect task
+            // does when it's done).
+            previous_tick_evaluated = false;
+            scan_overlay.set_state(0);
+            if (probing) {
+                size_t probed = 0;
+                while ((probed = pose_source->drain(sample_batch.data(), sample_batch.size())) > 0) {
+                    for (size_t n = 0; n < probed; ++n) activity.add(sample_batch[n]);
                 }
-            } 
-            else if (state.warning_triggered) { 
-                double ramp_elapsed_ms = elapsed_time_ms - state.warning_start_time_ms;
-                int target_volume = config.start_volume;
-                if (config.volume_ramp_time_ms > 0 && config.end_volume != config.start_volume) {
-                    double ramp_progress = std::min(1.0, ramp_elapsed_ms / static_cast<double>(config.volume_ramp_time_ms));
-                    target_volume = static_cast<int>(config.start_volume + ramp_progress * (config.end_volume - config.start_volume));
+            }
+            if (lazy_source && source_open && !condor_flight_active && now_us - flight_end_us >= seconds_to_us(pose_source_config.release_after_flight_s)) {
+                std::cout << "[INFO] No flight for " << pose_source_config.release_after_flight_s
+                          << " s - releasing the headset runtime until the next flight" << std::endl;
+                pose_source->close(); // Stops the scan overlay before it destroys the session
+                source_open = false;
+            }
+            const bool budget_mode = active_settings->memory.budget_mode;
+            if (memory_due_us && now_us >= memory_due_us) {
+                if (budget_mode && !condor_flight_active && !clips_unloaded) {
+                    audio.reconfigure(alarm_configs, active_settings->audio, true);
+                    clips_unloaded = true;
+                    memory_due_us = now_us + seconds_to_us(1.0);
                 } else {
-                    target_volume = config.end_volume; 
+                    if (budget_mode) trim_working_set();
+                    report_memory_footprint(condor_flight_active ? "while paused" : "between flights");
+                    memory_due_us = 0;
                 }
-
-                if (state.sound_player) {
-                    if (elapsed_time_ms < state.alarm_silence_until_ms) { 
-                        state.sound_player->setVolume(0);
-                        if (!state.silence_message_printed_this_period) {
-                            std::cout << "[DEBUG] Alarm " << i << ": Warning active. Volume silenced due to recent look." << std::endl;
-                            state.silence_message_printed_this_period = true;
-                        }
-                    } else { 
-                        if (state.silence_message_printed_this_period) { 
-                            std::cout << "[DEBUG] Alarm " << i << ": Silence period ended for active warning. Restoring volume." << std::endl;
-                            state.silence_message_printed_this_period = false; 
-                        }
-                        state.sound_player->setVolume(static_cast<float>(target_volume));
-                        
-                        if (state.repeat_timer_ms >= config.repeat_interval_ms) {
-                            state.sound_player->stop(); 
-                            state.sound_player->play(); 
-                            std::cout << "[WARNING] Alarm " << i << ": Please perform a visual lookout! (Repeat sound) Vol: " << target_volume << std::endl;
-                            state.repeat_timer_ms = 0.0; 
-                        }
-                    }
-                } else { 
-                    if (state.repeat_timer_ms >= config.repeat_interval_ms) { 
-                        std::cout << "[WARNING] Alarm " << i << ": Please perform a visual lookout! (Repeat reminder - NO SOUND PLAYER)" << std::endl;
-                        state.repeat_timer_ms = 0.0;
-                    }
+            }
+            int64_t until_next_check_us = seconds_to_us(LOG_CHECK_INTERVAL) - (now_us - last_flight_check_us);
+            if (window_events) {
+                // Window and process events wake us on flight start; only the sweep, the
+                // Toolhelp fallback and the runtime release are timed
+                until_next_check_us = seconds_to_us(CONDOR_WINDOW_RECONCILE_INTERVAL) - (now_us - last_window_sweep_us);
+                if (!condor_process_monitor.event_driven()) {
+                    until_next_check_us = (std::min)(until_next_check_us, seconds_to_us(CONDOR_PROCESS_POLL_INTERVAL));
                 }
-            } 
-        } 
+                if (lazy_source && source_open && !condor_flight_active) {
+                    until_next_check_us = (std::min)(until_next_check_us,
+                        seconds_to_us(pose_source_config.release_after_flight_s) - (now_us - flight_end_us));
+                }
+            }
+            if (on_ground) {
+                // No event marks the takeoff; keep reading the telemetry
+                until_next_check_us = (std::min)(until_next_check_us, ms_to_us(250));
+            }
+            if (memory_due_us) until_next_check_us = (std::min)(until_next_check_us, memory_due_us - now_us);
+            const bool woken = wait_timer.wait_until(
+                HighResolutionTimer::Clock::now() + std::chrono::microseconds((std::max<int64_t>)(until_next_check_us, 0)),
+                g_core_wake_event);
+            force_flight_check = woken && !probing; // The sampler's wake-ups while probing aren't a reason for one
+            continue;
+        }
+
+        // Drain everything the sampler has captured since the last wake-up
+        size_t evaluated = 0, drained = 0;
+        size_t count = 0;
+        while ((count = pose_source->drain(sample_batch.data(), sample_batch.size())) > 0) {
+            drained += count;
+            for (size_t n = 0; n < count; ++n) {
+                process_sample(sample_batch[n]);
+                if (sample_batch[n].flags & POSE_HMD_OK) ++evaluated;
+            }
+        }
+        total_evaluated += evaluated;
+        if (evaluated) metrics.increment(tracking_samples_metric, evaluated);
+        plugin_host.notify();
+        if (drained && control_pipe.has_clients()) control_pipe.set_status(scan_telemetry.local()); // One snapshot per tick
+        if (scan_overlay.enabled()) scan_overlay.set_state(overlay_state());
+        if (!realtime_source && pose_source->finished()) {
+            std::cout << "[INFO] " << pose_source->name() << " pose source finished: " << total_evaluated
+                      << " samples evaluated over " << engine.engine_us() / 1e6 << " s of engine time" << std::endl;
+            break;
+        }
+
+        uint64_t dropped_samples = pose_source->dropped_samples();
+        if (dropped_samples != dropped_samples_reported) {
+            std::cerr << "[WARNING] Evaluator fell behind: " << (dropped_samples - dropped_samples_reported)
+                      << " pose samples dropped" << std::endl;
+            dropped_samples_reported = dropped_samples;
+        }
+        // Next to tracking.samples: the share of polls that found no new pose, to match
+        // the poll rate to the tracker's
+        const uint64_t duplicate_samples = pose_source->duplicate_samples();
+        if (duplicate_samples < duplicate_samples_reported) duplicate_samples_reported = 0; // Source reopened
+        if (duplicate_samples != duplicate_samples_reported) {
+            metrics.increment(duplicate_samples_metric, duplicate_samples - duplicate_samples_reported);
+            duplicate_samples_reported = duplicate_samples;
+        }
+
+        int64_t wake_until_us = last_flight_check_us + seconds_to_us(LOG_CHECK_INTERVAL);
+        if (sampling.deadline_scheduling && previous_tick_evaluated && realtime_source && sampling.fixed_step_ms <= 0.0) {
+            // Alarm timers keep running between samples: advance engine time to the
+            // present and wake again exactly when the next one is due
+            int64_t wall_us = monotonic_now_us() - clock_epoch_us;
+            if (wall_us > last_loop_us) {
+                handle_events(engine.advance(wall_us - last_loop_us));
+                last_loop_us = wall_us;
+            }
+            int64_t next_timer_us = engine.next_timer_us();
+            if (next_timer_us != INT64_MAX) {
+                wake_until_us = (std::min)(wake_until_us, wall_us + (next_timer_us - engine.engine_us()));
+            }
+        }
+
+        int64_t work_done_us = monotonic_now_us() - clock_epoch_us;
+        watchdog.end_phase(TickWatchdog::PHASE_ALARMS, work_done_us);
+        if (evaluated > 0) {
+            watchdog.end_tick(work_done_us, evaluator_budget_seconds);
+        }
+        watchdog.report_if_due(work_done_us);
+        alarm_latency.collect(audio);
+        pose_trace.maintain();
+        scan_heatmap.poll();
+        if (watchdog_config.enabled) alarm_latency.report_if_due(work_done_us, watchdog_config.report_interval_s);
 
-        elapsed_time_ms += POLL_INTERVAL * 1000.0; 
-        std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(POLL_INTERVAL * 1000)));
+        // Woken by the sampler for each new sample, or by the flight check/timer deadline
+        wait_timer.wait_until(
+            HighResolutionTimer::Clock::now() + std::chrono::microseconds((std::max<int64_t>)(wake_until_us - work_done_us, 0)),
+            g_core_wake_event);
     } 
 
+    if (source_connect.valid()) source_connect.wait(); // open() gives up once shutdown is requested
+    pose_source->stop();
+    pose_source->set_session_user(nullptr); // The overlay goes first; the session is destroyed with the source
+    scan_overlay.stop();
+    g_pose_trace.store(nullptr);
+    pose_trace.close();
+
     std::cout << "[INFO] Main loop in app_core_logic exited (window closed)." << std::endl;
 
-    for(auto& state : alarm_states) {
-        if(state.sound_player) {
-            state.sound_player->stop();
-            delete state.sound_player;
-            state.sound_player = nullptr;
-        }
+    audio.stop_all();
+    alarm_latency.collect(audio);
+    audio.stop();
+    alarm_latency.end_flight(condor_flight_active);
+    if (condor_flight_active) scan_stats.end_flight(engine.engine_us());
+    flight_history.end_flight(engine.engine_us()); // Written before the writer is joined
+    if (condor_flight_active) engine_state.save(session_lost ? lost_state : engine.snapshot(now_us)); // For the next run, if it's back soon
+    engine_state.stop();
+    if (condor_flight_active) {
+        scan_heatmap.dump("flight", true);
+        publish_event(BusEvent::FLIGHT_END);
     }
+    plugin_host.stop(); // Plugins see the flight end before they shut down
 
-    ovr_Destroy(session);
-    ovr_Shutdown();
-    std::cout << "[INFO] Oculus SDK shutdown. app_core_logic finished." << std::endl;
+    pose_source.reset(); // Shuts the Oculus SDK down for the live source
+    std::cout << "[INFO] Pose source closed. app_core_logic finished." << std::endl;
     return 0;
 }
\ No newline at end of file
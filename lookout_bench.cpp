@@ -0,0 +1,732 @@
+// lookout_bench.cpp
+// Microbenchmarks of lookout.exe's hot paths, the baseline to measure an optimization
+// against. Builds lookout.cpp into the same translation unit (its WinMain is unused in
+// this console program), so every benchmark runs the code lookout.exe runs:
+//
+//   quat_to_look_vector + look_vector_to_yaw_pitch, and batch_quat_to_yaw_pitch
+//   LookoutEngine::step with 1, 8, 64 and 1024 alarms, and 64 with the head held still
+//   parse_hotkey
+//   engine state save and restore (resume.persist) through the file, checked to round-trip
+//   pose archives (.qlpz): a synthetic trace checked to round-trip within the quantization
+//   step, and damaged archives checked to be refused
+//   settings load from settings_default.json (parse alone, and parse + every block)
+//   one find_sim_window() sweep of the live desktop
+//   audio trigger latency from cached buffers (AudioEngine::play to the mixer and device)
+//
+//   lookout_bench [--quick] [--skip-audio]
+//   lookout_bench --windows [N[,N...]]
+//   lookout_bench --look-to-mute [N] [--target-ms MS]
+//
+// --windows instead adds dummy top-level windows to the desktop, N at a time (default
+// 10 to 2000), and prints how a full sweep, the cached-handle check and one window
+// event of the event-hook detector scale with them.
+//
+// --look-to-mute instead times the silence-after-look path end to end, in real time:
+// N looks (default 40, 10 with --quick; three seconds each) from the synthetic pose
+// source into a sounding warning, each from the moment the head crosses the threshold
+// to the first audio block with the mute handed to the device. It exits with 1 if the
+// p99 is over the target (default 100 ms).
+//
+// Run from the folder with settings_default.json and the alarm sounds. Each timing is
+// the fastest of five runs of at least 0.2 s (0.05 s with --quick), with the median
+// beside it; a large gap between the two means the machine was busy.
+
+#include "lookout.cpp"
+
+namespace {
+
+double g_bench_min_run_s = 0.2;
+volatile double g_bench_sink = 0.0; // Results land here so the optimizer can't drop the work
+
+// Discards std::cout/std::cerr while a benchmark runs, so the loaders' [INFO] lines
+// aren't timed or printed thousands of times
+class QuietOutput {
+public:
+    QuietOutput() : out_(std::cout.rdbuf(&null_)), err_(std::cerr.rdbuf(&null_)) {}
+    ~QuietOutput() {
+        std::cout.rdbuf(out_);
+        std::cerr.rdbuf(err_);
+    }
+
+private:
+    struct NullBuffer : std::streambuf {
+        int overflow(int c) override { return traits_type::not_eof(c); }
+    } null_;
+    std::streambuf* out_;
+    std::streambuf* err_;
+};
+
+struct BenchTiming {
+    double best_ns = 0.0, median_ns = 0.0; // Per operation
+    uint64_t ops = 0;                      // Per run
+};
+
+// Calls op() `ops_per_call` operations at a time: doubles the batch until it lasts a
+// tenth of a run, then times five runs
+template <typename Op>
+BenchTiming measure(Op&& op, uint64_t ops_per_call = 1) {
+    QuietOutput quiet;
+    uint64_t calls = 1;
+    while (true) {
+        int64_t start_us = monotonic_now_us();
+        for (uint64_t i = 0; i < calls; ++i) op();
+        if (monotonic_now_us() - start_us >= seconds_to_us(g_bench_min_run_s / 10.0) || calls >= (1ull << 40)) break;
+        calls *= 2;
+    }
+    calls *= 10;
+    std::array<double, 5> ns_per_op;
+    for (double& ns : ns_per_op) {
+        int64_t start_us = monotonic_now_us();
+        for (uint64_t i = 0; i < calls; ++i) op();
+        ns = (monotonic_now_us() - start_us) * 1000.0 / static_cast<double>(calls * ops_per_call);
+    }
+    std::sort(ns_per_op.begin(), ns_per_op.end());
+    BenchTiming timing;
+    timing.best_ns = ns_per_op[0];
+    timing.median_ns = ns_per_op[2];
+    timing.ops = calls * ops_per_call;
+    return timing;
+}
+
+template <typename Op>
+void bench(const char* name, Op&& op, uint64_t ops_per_call = 1) {
+    BenchTiming timing = measure(op, ops_per_call);
+    std::printf("%-44s %12.1f ns  (median %.1f, %llu ops per run)\n", name, timing.best_ns, timing.median_ns,
+                static_cast<unsigned long long>(timing.ops));
+    std::fflush(stdout);
+}
+
+// A minute of generated head motion at 100 Hz, the poses both hot paths below see
+std::vector<SyntheticPose> bench_motion() {
+    SyntheticMotionConfig config;
+    config.duration_s = 60.0;
+    config.scan_period_s = 10.0;
+    SyntheticHeadMotion motion(config);
+    std::vector<SyntheticPose> poses;
+    SyntheticPose pose;
+    while (motion.next(pose)) poses.push_back(pose);
+    return poses;
+}
+
+ovrQuatf yaw_pitch_to_quat(double yaw_deg, double pitch_deg) {
+    double cy = std::cos(deg2rad(yaw_deg) / 2), sy = std::sin(deg2rad(yaw_deg) / 2);
+    double cp = std::cos(deg2rad(pitch_deg) / 2), sp = std::sin(deg2rad(pitch_deg) / 2);
+    // Yaw about +Y, then pitch about +X
+    return ovrQuatf{ static_cast<float>(cy * sp), static_cast<float>(sy * cp), static_cast<float>(-sy * sp),
+                     static_cast<float>(cy * cp) };
+}
+
+void bench_pose_conversion(const std::vector<SyntheticPose>& motion) {
+    std::vector<ovrQuatf> quats;
+    for (const SyntheticPose& pose : motion) quats.push_back(yaw_pitch_to_quat(pose.yaw_deg, pose.pitch_deg));
+    size_t next = 0;
+    bench("quat_to_look_vector + yaw/pitch", [&]() {
+        double yaw, pitch;
+        look_vector_to_yaw_pitch(quat_to_look_vector(quats[next]), yaw, pitch);
+        g_bench_sink = g_bench_sink + yaw + pitch;
+        if (++next == quats.size()) next = 0;
+    });
+
+    constexpr size_t kBatch = 4096;
+    std::vector<float> x(kBatch), y(kBatch), z(kBatch), w(kBatch), yaw(kBatch), pitch(kBatch);
+    for (size_t i = 0; i < kBatch; ++i) {
+        const ovrQuatf& q = quats[i % quats.size()];
+        x[i] = q.x;
+        y[i] = q.y;
+        z[i] = q.z;
+        w[i] = q.w;
+    }
+    QuatArrays arrays{ x.data(), y.data(), z.data(), w.data() };
+    bench("batch_quat_to_yaw_pitch (per pose)", [&]() {
+        batch_quat_to_yaw_pitch(arrays, kBatch, yaw.data(), pitch.data());
+        g_bench_sink = g_bench_sink + yaw[kBatch - 1];
+    }, kBatch);
+}
+
+// The default settings' enabled alarms repeated to `count`, horizontal angles spread so
+// the copies don't all trip on the same sample
+AlarmTable bench_alarm_table(const std::vector<LookoutAlarmConfig>& configs, size_t count) {
+    std::vector<LookoutAlarmConfig> enabled;
+    for (const auto& config : configs) {
+        if (config.enabled()) enabled.push_back(config);
+    }
+    AlarmTable table;
+    if (enabled.empty()) enabled.push_back(LookoutAlarmConfig());
+    for (size_t k = 0; k < count; ++k) {
+        LookoutAlarmConfig config = enabled[k % enabled.size()];
+        config.min_horizontal_angle *= 0.85 + 0.3 * static_cast<double>(k % 16) / 15.0;
+        table.alarms.push_back(compile_alarm(config, static_cast<uint32_t>(k)));
+    }
+    order_alarm_table(table);
+    return table;
+}
+
+void bench_engine(const std::vector<SyntheticPose>& motion, const Settings& settings) {
+    std::vector<LookInput> inputs;
+    for (const SyntheticPose& pose : motion) {
+        LookInput input;
+        input.look = yaw_pitch_to_look_vector(pose.yaw_deg, pose.pitch_deg);
+        input.dt_us = 10000;
+        inputs.push_back(input);
+    }
+    for (size_t count : { 1, 8, 64, 1024 }) {
+        LookoutEngine engine(bench_alarm_table(settings.alarms, count));
+        engine.set_center_reset(settings.center_reset.window_degrees, settings.center_reset.hold_time_seconds);
+        size_t next = 0;
+        int64_t now_us = 0;
+        const std::string name = "LookoutEngine::step, " + std::to_string(count) + (count == 1 ? " alarm" : " alarms");
+        bench(name.c_str(), [&]() {
+            now_us += 10000;
+            g_bench_sink = g_bench_sink + static_cast<double>(engine.step(inputs[next], now_us).size());
+            if (++next == inputs.size()) next = 0;
+        });
+    }
+    // Eyes on the panel: the same pose every sample, which skips the direction tests
+    LookoutEngine engine(bench_alarm_table(settings.alarms, 64));
+    engine.set_center_reset(settings.center_reset.window_degrees, settings.center_reset.hold_time_seconds);
+    LookInput still;
+    still.look = yaw_pitch_to_look_vector(5.0, -15.0);
+    still.dt_us = 10000;
+    int64_t now_us = 0;
+    bench("LookoutEngine::step, 64 alarms, head still", [&]() {
+        now_us += 10000;
+        g_bench_sink = g_bench_sink + static_cast<double>(engine.step(still, now_us).size());
+    });
+}
+
+// A snapshot written by EngineStateStore, taken back and restored into a fresh engine
+// must snapshot the same again (coverage progress aside, which restore starts over)
+bool check_engine_state_round_trip(const std::vector<SyntheticPose>& motion, const Settings& settings) {
+    LookoutEngine engine(bench_alarm_table(settings.alarms, 64));
+    engine.set_center_reset(settings.center_reset.window_degrees, settings.center_reset.hold_time_seconds);
+    LookInput input;
+    input.dt_us = 10000;
+    int64_t now_us = 0;
+    for (const SyntheticPose& pose : motion) {
+        now_us += input.dt_us;
+        input.look = yaw_pitch_to_look_vector(pose.yaw_deg, pose.pitch_deg);
+        engine.step(input, now_us);
+    }
+    // Then eyes on the panel long enough for some of the alarms to be warning
+    input.look = yaw_pitch_to_look_vector(5.0, -15.0);
+    for (int k = 0; k < 4000; ++k) {
+        now_us += input.dt_us;
+        engine.step(input, now_us);
+    }
+    const std::vector<AlarmSnapshot> saved = engine.snapshot(now_us);
+
+    ResumeConfig config;
+    config.persist = true;
+    config.file = "lookout_bench_state.qles";
+    {
+        EngineStateStore store(config);
+        store.start();
+        store.save(saved);
+    } // Written before the writer is joined
+    std::vector<AlarmSnapshot> loaded;
+    int64_t age_s = 0;
+    size_t restored = 0;
+    bool intact = EngineStateStore::take(config, loaded, age_s) && loaded.size() == saved.size();
+    if (intact) {
+        LookoutEngine fresh(bench_alarm_table(settings.alarms, 64));
+        fresh.set_center_reset(settings.center_reset.window_degrees, settings.center_reset.hold_time_seconds);
+        fresh.restore(loaded, now_us, &restored);
+        const std::vector<AlarmSnapshot> again = fresh.snapshot(now_us);
+        intact = restored == saved.size();
+        for (size_t i = 0; intact && i < saved.size(); ++i) {
+            const AlarmSnapshot& a = saved[i];
+            const AlarmSnapshot& b = again[i];
+            const uint8_t seen = a.seen & ~direction_bit(DIR_COVERAGE) & engine.alarms()[i].required;
+            intact = a.alarm == b.alarm && a.identity == b.identity && a.no_look_us == b.no_look_us &&
+                     a.warning_us == b.warning_us && a.since_repeat_us == b.since_repeat_us &&
+                     a.silence_left_us == b.silence_left_us && a.left_ago_us == b.left_ago_us &&
+                     a.right_ago_us == b.right_ago_us && seen == b.seen && a.warning == b.warning &&
+                     a.repeat_pending == b.repeat_pending && a.silence_message == b.silence_message;
+        }
+    }
+    size_t warnings = 0;
+    for (const AlarmSnapshot& s : saved) warnings += s.warning;
+    std::printf("%-44s %s (%zu of %zu alarms, %zu warning)\n", "Engine state save + restore",
+                intact ? "round trip intact" : "MISMATCH", restored, saved.size(), warnings);
+    std::fflush(stdout);
+    return intact;
+}
+
+// The bench motion as a pose trace, both tracking-space angles turning
+std::vector<PoseTraceRecord> bench_trace(const std::vector<SyntheticPose>& motion) {
+    std::vector<PoseTraceRecord> records;
+    for (const SyntheticPose& pose : motion) {
+        PoseTraceRecord r = {};
+        r.t_us = 1000000 + pose.t_us;
+        const ovrQuatf q = yaw_pitch_to_quat(pose.yaw_deg, pose.pitch_deg);
+        r.orientation[0] = q.x;
+        r.orientation[1] = q.y;
+        r.orientation[2] = q.z;
+        r.orientation[3] = q.w;
+        r.position[0] = static_cast<float>(0.05 * std::sin(deg2rad(pose.yaw_deg)));
+        r.position[1] = static_cast<float>(0.02 * std::sin(deg2rad(pose.pitch_deg)));
+        r.position[2] = -0.01f;
+        r.angular_velocity[0] = static_cast<float>(deg2rad(pose.pitch_rate_deg_s));
+        r.angular_velocity[1] = static_cast<float>(deg2rad(pose.yaw_rate_deg_s));
+        r.status_flags = 3;
+        r.session_flags = TRACE_HMD_PRESENT | TRACE_HMD_MOUNTED;
+        r.pose_flags = pose.tracked ? POSE_HMD_OK : 0;
+        records.push_back(r);
+    }
+    return records;
+}
+
+bool write_bench_archive(const char* path, const std::vector<PoseTraceRecord>& records) {
+    PoseArchiveWriter writer;
+    if (!writer.open(path, 0, records.front().t_us)) return false;
+    for (const PoseTraceRecord& r : records) writer.add(r);
+    const PoseTraceMarker marker = { records[records.size() / 2].t_us, TRACE_MARK_WARNING, 0, 7 };
+    writer.add_markers(&marker, 1);
+    return writer.finish();
+}
+
+// Every record back within half a quantization step (orientation: of the smallest three,
+// with the largest rebuilt from them), times and flags exact
+bool check_pose_archive_round_trip(const std::vector<SyntheticPose>& motion) {
+    const char* const path = "lookout_bench_trace.qlpz";
+    const std::vector<PoseTraceRecord> records = bench_trace(motion);
+    std::vector<PoseTraceRecord> decoded, block;
+    PoseArchiveReader reader;
+    bool intact = write_bench_archive(path, records) && reader.open(path) && reader.header().record_count == records.size() &&
+                  reader.markers().size() == 1 && reader.markers()[0].value == 7;
+    for (size_t b = 0; intact && b < reader.index().size(); ++b) {
+        intact = reader.read_block(b, block);
+        decoded.insert(decoded.end(), block.begin(), block.end());
+    }
+    intact = intact && decoded.size() == records.size();
+    const double position_step = 0.5 / POSE_ARCHIVE_POSITION_SCALE + 1e-6, velocity_step = 0.5 / POSE_ARCHIVE_VELOCITY_SCALE + 1e-6;
+    double worst_orientation = 0.0;
+    for (size_t i = 0; intact && i < records.size(); ++i) {
+        const PoseTraceRecord& a = records[i];
+        const PoseTraceRecord& b = decoded[i];
+        intact = a.t_us == b.t_us && a.status_flags == b.status_flags && a.session_flags == b.session_flags &&
+                 a.pose_flags == b.pose_flags;
+        double dot = 0.0;
+        for (int k = 0; k < 4; ++k) dot += double(a.orientation[k]) * b.orientation[k];
+        const double sign = dot < 0.0 ? -1.0 : 1.0; // q and -q are the same rotation
+        for (int k = 0; k < 4; ++k) worst_orientation = (std::max)(worst_orientation, std::abs(a.orientation[k] - sign * b.orientation[k]));
+        for (int k = 0; intact && k < 3; ++k) {
+            intact = std::abs(a.position[k] - b.position[k]) <= position_step &&
+                     std::abs(a.angular_velocity[k] - b.angular_velocity[k]) <= velocity_step;
+        }
+    }
+    intact = intact && worst_orientation <= 1e-3;
+    DeleteFileA(path);
+    std::printf("%-44s %s (%zu records, orientation within %.1e)\n", "Pose archive write + read",
+                intact ? "round trip intact" : "MISMATCH", decoded.size(), worst_orientation);
+    std::fflush(stdout);
+    return intact;
+}
+
+// Archives with a damaged header, index or block: open() or read_block() must refuse each
+bool check_pose_archive_corruption(const std::vector<SyntheticPose>& motion) {
+    const char* const path = "lookout_bench_trace.qlpz";
+    const char* const damaged_path = "lookout_bench_damaged.qlpz";
+    std::vector<char> good;
+    if (write_bench_archive(path, bench_trace(motion))) {
+        std::ifstream in(path, std::ios::binary);
+        good.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    DeleteFileA(path);
+    PoseArchiveHeader header = {};
+    if (good.size() < sizeof(header)) {
+        std::printf("%-44s %s\n", "Pose archive damage", "could not write the archive");
+        return false;
+    }
+    std::memcpy(&header, good.data(), sizeof(header));
+    const size_t block_at = sizeof(PoseArchiveHeader);
+    const size_t index_at = static_cast<size_t>(header.index_offset);
+    struct Damage {
+        const char* what;
+        size_t at;        // Into the file; the value written, or with flip, the bits XORed in
+        uint64_t value;
+        size_t bytes;
+        bool flip;
+    };
+    const Damage damages[] = {
+        { "magic", offsetof(PoseArchiveHeader, magic), 0x01, 1, true },
+        { "version", offsetof(PoseArchiveHeader, version), 0x80, 1, true },
+        { "block_records", offsetof(PoseArchiveHeader, block_records), 0x7FFFFFFF, 4, false },
+        { "block_count", offsetof(PoseArchiveHeader, block_count), 0xFFFFFFFF, 4, false },
+        { "record_count", offsetof(PoseArchiveHeader, record_count), uint64_t(1) << 40, 8, false },
+        { "index_offset", offsetof(PoseArchiveHeader, index_offset), UINT64_MAX - 8, 8, false },
+        { "index_offset past the end", offsetof(PoseArchiveHeader, index_offset), good.size() + 1, 8, false },
+        { "block offset wrapping", index_at + offsetof(PoseArchiveIndexEntry, offset), UINT64_MAX - 8, 8, false },
+        { "block offset in the index", index_at + offsetof(PoseArchiveIndexEntry, offset), index_at, 8, false },
+        { "block compressed_size", block_at + offsetof(PoseArchiveBlock, compressed_size), 0xFFFFFFF0, 4, false },
+        { "block raw_size", block_at + offsetof(PoseArchiveBlock, raw_size), 0xFFFFFFF0, 4, false },
+        { "block record_count", block_at + offsetof(PoseArchiveBlock, record_count), 0x00100000, 4, false },
+        { "block record_count 0", block_at + offsetof(PoseArchiveBlock, record_count), 0, 4, false },
+        { "truncated", good.size() / 2, 0, 0, false },
+    };
+    size_t refused = 0;
+    std::string accepted;
+    for (const Damage& damage : damages) {
+        std::vector<char> bytes = good;
+        if (damage.bytes == 0) {
+            bytes.resize(damage.at);
+        } else if (damage.flip) {
+            bytes[damage.at] ^= static_cast<char>(damage.value);
+        } else {
+            std::memcpy(bytes.data() + damage.at, &damage.value, damage.bytes); // Little-endian
+        }
+        {
+            std::ofstream out(damaged_path, std::ios::binary | std::ios::trunc);
+            out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        }
+        PoseArchiveReader reader;
+        bool read = reader.open(damaged_path);
+        std::vector<PoseTraceRecord> block;
+        for (size_t b = 0; read && b < reader.index().size(); ++b) read = reader.read_block(b, block);
+        if (!read) {
+            ++refused;
+        } else {
+            accepted += std::string(accepted.empty() ? " accepted: " : ", ") + damage.what;
+        }
+    }
+    DeleteFileA(damaged_path);
+    const size_t count = sizeof(damages) / sizeof(damages[0]);
+    std::printf("%-44s %zu of %zu refused%s\n", "Pose archive damage", refused, count, accepted.c_str());
+    std::fflush(stdout);
+    return refused == count;
+}
+
+void bench_hotkeys() {
+    const char* const bindings[] = { "Num5", "Ctrl+Shift+F9", "Alt+R", "Ctrl+Alt+Shift+Space" };
+    size_t next = 0;
+    bench("parse_hotkey", [&]() {
+        UINT modifiers = 0, vk_code = 0;
+        parse_hotkey(bindings[next], modifiers, vk_code);
+        g_bench_sink = g_bench_sink + vk_code;
+        if (++next == sizeof(bindings) / sizeof(bindings[0])) next = 0;
+    });
+}
+
+void bench_settings(const char* path) {
+    bench("read_settings_json (parse only)", [&]() {
+        g_bench_sink = g_bench_sink + static_cast<double>(read_settings_json(path).size());
+    });
+    bench("load_settings (parse + every block)", [&]() {
+        g_bench_sink = g_bench_sink + static_cast<double>(load_settings(path)->alarms.size());
+    });
+}
+
+int count_top_level_windows() {
+    int windows = 0;
+    EnumWindows([](HWND, LPARAM count) -> BOOL { ++*reinterpret_cast<int*>(count); return TRUE; },
+                reinterpret_cast<LPARAM>(&windows));
+    return windows;
+}
+
+void bench_window_sweep() {
+    const std::string name = "find_sim_window, " + std::to_string(count_top_level_windows()) + " top-level windows";
+    bench(name.c_str(), []() { g_bench_sink = g_bench_sink + (find_sim_window().hwnd != nullptr); });
+}
+
+// --windows. The dummies are visible popups off-screen and 200x200, so each one gets
+// past the visibility and size checks and has its title read, the expensive case of a
+// desktop full of overlays and browser windows. They belong to this thread, whose
+// WM_GETTEXT is answered in place; another process's title is read from the window
+// itself, also without a message, so the per-window cost is comparable. A Condor-like
+// window is shown only for the cached-handle and event measurements, so the sweep
+// always walks every window.
+void bench_window_scaling(const std::vector<size_t>& counts) {
+    HINSTANCE instance = GetModuleHandle(nullptr);
+    WNDCLASSEX wc = {0};
+    wc.cbSize = sizeof(WNDCLASSEX);
+    wc.lpfnWndProc = DefWindowProc;
+    wc.hInstance = instance;
+    wc.lpszClassName = "LookoutBenchDummy";
+    if (!RegisterClassEx(&wc)) {
+        std::cerr << "[ERROR] Could not register the dummy window class (error " << GetLastError() << ")" << std::endl;
+        return;
+    }
+    auto create = [&](const char* title, int width, int height) {
+        return CreateWindowEx(WS_EX_TOOLWINDOW | WS_EX_NOACTIVATE, wc.lpszClassName, title, WS_POPUP, -20000, -20000,
+                               width, height, nullptr, nullptr, instance, nullptr);
+    };
+    HWND sim = create("Condor Version 3.0", 800, 600);
+    std::vector<HWND> dummies;
+    const int desktop_windows = count_top_level_windows() - 1;
+    std::printf("Window detection against desktop size (%d top-level windows before the dummies)\n", desktop_windows);
+    std::printf("%8s %8s %16s %16s %18s %18s\n", "dummies", "windows", "full sweep us", "per window ns",
+                "cached check ns", "window event ns");
+    for (size_t count : counts) {
+        char title[64];
+        while (dummies.size() < count) {
+            std::snprintf(title, sizeof(title), "Stream overlay %zu", dummies.size());
+            HWND hwnd = create(title, 200, 200);
+            if (!hwnd) break;
+            ShowWindow(hwnd, SW_SHOWNOACTIVATE);
+            dummies.push_back(hwnd);
+        }
+        if (dummies.size() < count) {
+            std::cerr << "[WARNING] Stopped at " << dummies.size() << " dummy windows (error " << GetLastError() << ")" << std::endl;
+            break;
+        }
+        const int windows = count_top_level_windows();
+        set_condor_sim_window(nullptr);
+        BenchTiming sweep = measure([]() { g_bench_sink = g_bench_sink + (find_sim_window().hwnd != nullptr); });
+
+        ShowWindow(sim, SW_SHOWNOACTIVATE);
+        set_condor_sim_window(sim, 0);
+        BenchTiming cached = measure([]() { g_bench_sink = g_bench_sink + cached_condor_sim_window_valid(); });
+        // A title change on an unrelated window: the hook checks that window alone
+        size_t next = 0;
+        BenchTiming event = measure([&]() {
+            CondorWinEventProc(nullptr, EVENT_OBJECT_NAMECHANGE, dummies[next], OBJID_WINDOW, CHILDID_SELF, 0, 0);
+            if (++next == dummies.size()) next = 0;
+        });
+        ShowWindow(sim, SW_HIDE);
+        std::printf("%8zu %8d %16.1f %16.1f %18.1f %18.1f\n", dummies.size(), windows, sweep.best_ns / 1000.0,
+                    sweep.best_ns / windows, cached.best_ns, event.best_ns);
+        std::fflush(stdout);
+    }
+    set_condor_sim_window(nullptr);
+    for (HWND hwnd : dummies) DestroyWindow(hwnd);
+    DestroyWindow(sim);
+    UnregisterClass(wc.lpszClassName, instance);
+}
+
+// measure_audio_triggers(), as lookout.exe --perf-selftest runs it, with more triggers
+void bench_audio(const Settings& settings) {
+    AudioTriggerLatency audio;
+    {
+        QuietOutput quiet;
+        audio = measure_audio_triggers(settings.alarms, settings.audio, 100);
+    }
+    std::printf("%-44s %12.1f ms\n", "Audio warm-up (decode and test every clip)", audio.warmup_us / 1000.0);
+    if (audio.cold_mixer_us < 0) {
+        std::printf("%-44s no clip reached the mixer; is the alarm sound next to lookout_bench?\n", "Audio trigger");
+        return;
+    }
+    std::printf("%-44s %9lld us to mixer, %lld us to device\n", "Audio trigger, stream stopped",
+                static_cast<long long>(audio.cold_mixer_us), static_cast<long long>(audio.cold_output_us));
+    for (const auto& [name, histogram] : { std::make_pair("Audio trigger to mixer, stream running", &audio.mixer),
+                                           std::make_pair("Audio trigger to device, stream running", &audio.output) }) {
+        std::printf("%-44s p50 %lld us, p95 %lld us, max %lld us (%llu triggers)\n", name,
+                    static_cast<long long>(histogram->percentile(0.5)), static_cast<long long>(histogram->percentile(0.95)),
+                    static_cast<long long>(histogram->max_us()), static_cast<unsigned long long>(histogram->count()));
+    }
+}
+
+// --look-to-mute. One alarm over the flicks pattern: a left flick, a right one a second
+// later and an up one a second after that complete the lookout, the warning is due half
+// a second on, and the next period's left flick is the look that has to mute it. Poses
+// are paced on the core clock at the rate a moving head is sampled at, and go through
+// the engine, the audio calls and the log lines as the core makes them (no log sink
+// attached, as with the status window closed); the clip plays at volume 0.
+bool bench_look_to_mute(const Settings& settings, int looks, double target_ms) {
+    LookoutAlarmConfig config;
+    if (!settings.alarms.empty()) config.audio_file = settings.alarms[0].audio_file;
+    config.min_horizontal_angle = 90.0;
+    config.min_vertical_angle_up = 10.0;
+    config.min_vertical_angle_down = 0.0;
+    config.max_time_ms = 500;
+    config.start_volume = config.end_volume = 0;
+    config.repeat_interval_ms = 60000;
+    config.min_lookout_time_ms = 500;
+    config.silence_after_look_ms = 1000;
+    const std::vector<LookoutAlarmConfig> configs = { config };
+    AlarmTable table;
+    table.alarms.push_back(compile_alarm(config, 0));
+    const double threshold_deg = table.alarms[0].thresholds.half_horizontal_deg;
+    LookoutEngine engine(std::move(table));
+
+    const double rate_hz = settings.sampling.adaptive ? settings.sampling.max_rate_hz : 1.0 / POLL_INTERVAL;
+    PoseSourceConfig source_config;
+    SyntheticMotionConfig& motion = source_config.synthetic;
+    motion.pattern = SYNTHETIC_FLICKS;
+    motion.rate_hz = rate_hz;
+    motion.scan_period_s = 3.0;
+    motion.flick_s = 0.3;
+    motion.duration_s = motion.scan_period_s * (looks + 2);
+    clamp_synthetic_motion_config(motion);
+    SyntheticPoseSource source(source_config);
+
+    AudioEngine audio(configs, settings.audio);
+    AsyncLog async_log(settings.logging);
+    std::unique_ptr<HighResolutionTimer> timer;
+    {
+        QuietOutput quiet;
+        source.open();
+        start_audio_warmup(configs, settings.audio);
+        wait_for_audio_warmup();
+        audio.start();
+        while (!audio.ready()) Sleep(1);
+        timer = std::make_unique<HighResolutionTimer>();
+    }
+    if (!audio.has_audio(0)) {
+        std::printf("%-44s no playable clip; is the alarm sound next to lookout_bench?\n", "Look to mute");
+        return false;
+    }
+
+    LatencyHistogram detect, mixer, output, total;
+    int lost = 0;
+    bool sounding = false;
+    int64_t crossed_us = -1, decided_us = 0; // Monotonic; decided_us != 0 while a mute is in flight
+    PoseSample sample, previous;
+    bool have_previous = false;
+    TickScheduler scheduler(*timer, 1.0 / rate_hz);
+    const int64_t epoch_us = monotonic_now_us();
+    std::printf("%-44s %d looks at %.0f Hz, about %d s...\n", "Look to mute", looks, rate_hz,
+                static_cast<int>(motion.scan_period_s * (looks + 1)));
+    std::fflush(stdout);
+    while (static_cast<int>(total.count()) + lost < looks && source.drain(&sample, 1) == 1) {
+        scheduler.wait_next_tick();
+        double yaw_deg = 0.0, pitch_deg = 0.0;
+        look_vector_to_yaw_pitch(sample.look, yaw_deg, pitch_deg);
+        if (sounding && crossed_us < 0 && have_previous && std::abs(yaw_deg) >= threshold_deg) {
+            // Where between the two samples the head passed the threshold
+            double previous_yaw_deg = 0.0, previous_pitch_deg = 0.0;
+            look_vector_to_yaw_pitch(previous.look, previous_yaw_deg, previous_pitch_deg);
+            const double span = std::abs(yaw_deg) - std::abs(previous_yaw_deg);
+            const double f = span > 0.0 ? (threshold_deg - std::abs(previous_yaw_deg)) / span : 1.0;
+            crossed_us = epoch_us + previous.t_us +
+                         static_cast<int64_t>((std::max)(0.0, (std::min)(1.0, f)) * (sample.t_us - previous.t_us));
+        }
+        LookInput input;
+        input.look = sample.look;
+        input.dt_us = have_previous ? sample.t_us - previous.t_us : 0;
+        for (const LookoutEvent& event : engine.step(input, sample.t_us)) {
+            switch (event.type) {
+            case LookoutEvent::WARNING_START:
+                audio.play(event.alarm, config.start_volume, config.end_volume, config.volume_ramp_time_ms, 0, monotonic_now_us());
+                LOOKOUT_LOG(async_log, LEVEL_WARNING, "[WARNING] Alarm {}: Please perform a visual lookout! Vol: {}", event.alarm, event.volume);
+                sounding = true;
+                crossed_us = -1;
+                break;
+            case LookoutEvent::MUTE:
+                if (sounding && crossed_us >= 0 && decided_us == 0) {
+                    decided_us = monotonic_now_us();
+                    audio.set_muted(event.alarm, true, decided_us);
+                } else {
+                    audio.set_muted(event.alarm, true);
+                }
+                if (event.value) LOOKOUT_LOG(async_log, LEVEL_DEBUG, "[DEBUG] Alarm {}: Warning active, volume immediately silenced due to new L/R look.", event.alarm);
+                break;
+            case LookoutEvent::UNMUTE:
+                audio.set_muted(event.alarm, false);
+                break;
+            case LookoutEvent::STOP:
+                audio.stop_alarm(event.alarm);
+                sounding = false;
+                break;
+            case LookoutEvent::LOOK_SILENCED:
+                LOOKOUT_LOG(async_log, LEVEL_DEBUG, "[DEBUG] Alarm {}: New L/R look. Silencing warnings for {} ms.", event.alarm, event.value / 1000);
+                break;
+            default:
+                break;
+            }
+        }
+        previous = sample;
+        have_previous = true;
+
+        AudioLatencySample latency;
+        while (audio.pop_latency(&latency, 1) == 1) {
+            if (!latency.mute || decided_us == 0) continue;
+            detect.record(decided_us - crossed_us);
+            mixer.record(latency.mixer_us);
+            output.record(latency.output_us);
+            total.record(decided_us + latency.output_us - crossed_us);
+            decided_us = 0;
+            crossed_us = -1;
+        }
+        if (decided_us != 0 && monotonic_now_us() - decided_us > seconds_to_us(1.0)) {
+            ++lost; // The mute never reached the device
+            decided_us = 0;
+            crossed_us = -1;
+        }
+    }
+    audio.stop();
+
+    auto print = [](const char* name, const LatencyHistogram& h) {
+        std::printf("%-44s p50 %.1f ms, p95 %.1f ms, p99 %.1f ms, max %.1f ms\n", name, h.percentile(0.5) / 1000.0,
+                    h.percentile(0.95) / 1000.0, h.percentile(0.99) / 1000.0, h.max_us() / 1000.0);
+    };
+    print("Look to mute: crossing to decision", detect);
+    print("Look to mute: decision to mixer", mixer);
+    print("Look to mute: decision to device", output);
+    print("Look to mute: crossing to device", total);
+    const bool pass = total.count() > 0 && lost == 0 && total.percentile(0.99) <= static_cast<int64_t>(target_ms * 1000.0);
+    std::printf("%-44s %llu timed, %d lost; p99 %s the %.0f ms target\n", "Look to mute", static_cast<unsigned long long>(total.count()),
+                lost, pass ? "within" : "OVER", target_ms);
+    return pass;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool skip_audio = false, window_scaling = false, look_to_mute = false, usage = false;
+    std::vector<size_t> window_counts;
+    int looks = 0;
+    double target_ms = 100.0;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--quick") {
+            g_bench_min_run_s = 0.05;
+        } else if (arg == "--skip-audio") {
+            skip_audio = true;
+        } else if (arg == "--windows") {
+            window_scaling = true;
+            if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+                std::stringstream list(argv[++i]);
+                std::string count;
+                while (std::getline(list, count, ',')) {
+                    const long n = std::atol(count.c_str());
+                    usage |= n <= 0;
+                    if (n > 0) window_counts.push_back(static_cast<size_t>(n));
+                }
+            }
+        } else if (arg == "--look-to-mute") {
+            look_to_mute = true;
+            if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+                looks = std::atoi(argv[++i]);
+                usage |= looks <= 0;
+            }
+        } else if (arg == "--target-ms" && i + 1 < argc) {
+            target_ms = std::atof(argv[++i]);
+            usage |= target_ms <= 0.0;
+        } else {
+            usage = true;
+        }
+    }
+    if (usage) {
+        std::cerr << "Usage: lookout_bench [--quick] [--skip-audio]\n"
+                     "       lookout_bench --windows [N[,N...]]\n"
+                     "       lookout_bench --look-to-mute [N] [--target-ms MS]" << std::endl;
+        return 2;
+    }
+    const char* const settings_path = "settings_default.json";
+    bool ok = false;
+    std::shared_ptr<const Settings> settings = load_settings(settings_path, &ok);
+    if (!ok) return 1;
+    if (window_scaling) {
+        if (window_counts.empty()) window_counts = { 10, 50, 100, 250, 500, 1000, 2000 };
+        std::sort(window_counts.begin(), window_counts.end());
+        g_sim_profiles = settings->sim_profiles;
+        bench_window_scaling(window_counts);
+        return 0;
+    }
+    if (look_to_mute) {
+        if (looks == 0) looks = g_bench_min_run_s < 0.2 ? 10 : 40;
+        return bench_look_to_mute(*settings, looks, target_ms) ? 0 : 1;
+    }
+
+    const std::vector<SyntheticPose> motion = bench_motion();
+    bench_pose_conversion(motion);
+    bench_engine(motion, *settings);
+    const bool state_intact = check_engine_state_round_trip(motion, *settings);
+    const bool archive_intact = check_pose_archive_round_trip(motion);
+    const bool archive_guarded = check_pose_archive_corruption(motion);
+    bench_hotkeys();
+    bench_settings(settings_path);
+    bench_window_sweep();
+    if (!skip_audio) bench_audio(*settings);
+    return state_intact && archive_intact && archive_guarded ? 0 : 1;
+}
@@ -0,0 +1,1551 @@
+// lookout_engine.hpp
+// The alarm engine: lookout detection and alarm timing, with no I/O and nothing
+// Windows- or headset-specific, so it builds and runs anywhere (replays, benchmarks,
+// tests) exactly as it runs inside lookout.exe.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+#include "json.hpp"
+
+// Cycle counts per engine kernel and per alarm, to pin a cost regression on one part of
+// step() (on by default with _DEBUG, or build with -DLOOKOUT_KERNEL_CYCLES=1). Off, the
+// KernelClock scopes below compile to nothing; on, each costs two counter reads, more
+// than the cheapest kernels, so release builds leave it off.
+#ifndef LOOKOUT_KERNEL_CYCLES
+#ifdef _DEBUG
+#define LOOKOUT_KERNEL_CYCLES 1
+#else
+#define LOOKOUT_KERNEL_CYCLES 0
+#endif
+#endif
+#if LOOKOUT_KERNEL_CYCLES
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+#endif
+
+inline int64_t ms_to_us(int64_t ms) { return ms * 1000; }
+inline int64_t seconds_to_us(double seconds) { return static_cast<int64_t>(seconds * 1000000.0); }
+inline double rad2deg(double rad) { return rad * 180.0 / 3.14159265358979323846; }
+inline double deg2rad(double deg) { return deg * 3.14159265358979323846 / 180.0; }
+
+#if LOOKOUT_KERNEL_CYCLES
+// TSC cycles where there is one, else nanoseconds
+inline uint64_t kernel_cycles_now() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+#endif
+
+// Adds the cycles spent in its scope to `total` when LOOKOUT_KERNEL_CYCLES is on
+struct KernelClock {
+#if LOOKOUT_KERNEL_CYCLES
+    explicit KernelClock(uint64_t& total) : total_(total), start_(kernel_cycles_now()) {}
+    ~KernelClock() { total_ += kernel_cycles_now() - start_; }
+    uint64_t& total_;
+    uint64_t start_;
+#else
+    explicit KernelClock(uint64_t&) {}
+#endif
+    KernelClock(const KernelClock&) = delete;
+    KernelClock& operator=(const KernelClock&) = delete;
+};
+
+// One entry of "alarms" in settings.json
+struct LookoutAlarmConfig {
+    double min_horizontal_angle = 120.0; 
+    double min_vertical_angle_up = 20.0;   
+    double min_vertical_angle_down = 5.0; 
+    int max_time_ms = 60000;             
+    std::string audio_file;             
+    int start_volume = 5;              
+    int end_volume = 100;               
+    int volume_ramp_time_ms = 30000;     
+    int repeat_interval_ms = 5000;      
+    int min_lookout_time_ms = 2000;     
+    int silence_after_look_ms = 5000;   
+    double min_lean_lateral_cm = 0.0;   // Head must move this far left AND right of the recenter position
+    double min_lean_vertical_cm = 0.0;  // Head must move this far up or down from the recenter position
+    double min_coverage_percent = 0.0;  // Share of the scan box's direction bins the head must point into
+    int min_dwell_ms = 0;               // Time a direction must be held to count, rather than a flick past it
+    double hysteresis_deg = 0.0;        // Opt-in: a look ends this far back inside an angle threshold, not at it
+    double hysteresis_cm = 0.0;         // Same for the lean distances
+
+    // Both a horizontal angle and at least one vertical angle; otherwise the alarm is off
+    bool enabled() const {
+        return min_horizontal_angle > 0 && (min_vertical_angle_up > 0 || min_vertical_angle_down > 0);
+    }
+
+    // Same look and lean thresholds: the same alarm across a settings reload, whatever
+    // its timings, volumes or sound file
+    bool same_identity(const LookoutAlarmConfig& other) const {
+        return min_horizontal_angle == other.min_horizontal_angle && min_vertical_angle_up == other.min_vertical_angle_up &&
+               min_vertical_angle_down == other.min_vertical_angle_down && min_lean_lateral_cm == other.min_lean_lateral_cm &&
+               min_lean_vertical_cm == other.min_lean_vertical_cm && min_coverage_percent == other.min_coverage_percent;
+    }
+
+    // Fields missing from settings.json keep the defaults above, so older files still load
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(LookoutAlarmConfig,
+        min_horizontal_angle, min_vertical_angle_up, min_vertical_angle_down, max_time_ms, audio_file,
+        start_volume, end_volume, volume_ramp_time_ms, repeat_interval_ms, min_lookout_time_ms,
+        silence_after_look_ms, min_lean_lateral_cm, min_lean_vertical_cm, min_coverage_percent, min_dwell_ms,
+        hysteresis_deg, hysteresis_cm)
+};
+
+// Head direction relative to the reference, before any trig: yaw = atan2(yaw_sin, yaw_cos)
+// and pitch = asin(pitch_sin). yaw_sin/yaw_cos share a positive scale (cos of pitch),
+// which the threshold tests don't care about.
+struct LookVector {
+    double yaw_sin = 0.0, yaw_cos = 1.0, pitch_sin = 0.0;
+};
+
+inline void look_vector_to_yaw_pitch(const LookVector& v, double& yaw_deg, double& pitch_deg) {
+    yaw_deg = rad2deg(std::atan2(v.yaw_sin, v.yaw_cos)); // Output is [-180, 180]
+    pitch_deg = rad2deg(std::asin(v.pitch_sin));        // Output is [-90, 90]
+}
+
+inline LookVector yaw_pitch_to_look_vector(double yaw_deg, double pitch_deg) {
+    double pitch_cos = std::cos(deg2rad(pitch_deg));
+    LookVector v;
+    v.yaw_sin = std::sin(deg2rad(yaw_deg)) * pitch_cos;
+    v.yaw_cos = std::cos(deg2rad(yaw_deg)) * pitch_cos;
+    v.pitch_sin = std::sin(deg2rad(pitch_deg));
+    return v;
+}
+
+// Head displacement from the recenter position: lateral positive to the left, vertical
+// positive up (meters). Only valid once a baseline position has been captured.
+struct LeanOffset {
+    double lateral_m = 0.0, vertical_m = 0.0;
+    bool valid = false;
+};
+
+// An alarm's direction thresholds, precomputed as sine/cosine bounds so the per-sample
+// tests on a LookVector are a few multiply-adds and compares with no trig. The degree
+// values are kept for interpolated peaks, which are estimated in angle space. Each
+// direction has an exit bound the hysteresis band inside its entry bound: a look
+// starts past the entry bound and lasts until the head comes back past the exit one.
+struct LookThresholds {
+    double half_cos = 1.0, half_sin = 0.0; // Half the horizontal angle (each side)
+    double up_sin = 0.0, down_sin = 0.0;   // sin(up) and sin(-down)
+    double half_horizontal_deg = 0.0, up_deg = 0.0, down_deg = 0.0;
+    double lean_lateral_m = 0.0, lean_vertical_m = 0.0; // 0 when not required
+    double exit_half_cos = 1.0, exit_half_sin = 0.0, exit_up_sin = 0.0, exit_down_sin = 0.0;
+    double exit_lean_lateral_m = 0.0, exit_lean_vertical_m = 0.0;
+
+    // yaw > half: the (yaw_cos, yaw_sin) direction lies past +half, on the left side
+    bool looking_left(const LookVector& v) const {
+        return v.yaw_sin >= 0.0 && v.yaw_sin * half_cos - v.yaw_cos * half_sin > 0.0;
+    }
+    bool looking_right(const LookVector& v) const {
+        return v.yaw_sin < 0.0 && -v.yaw_sin * half_cos - v.yaw_cos * half_sin > 0.0;
+    }
+    bool looking_up(const LookVector& v) const { return v.pitch_sin > up_sin; }
+    bool looking_down(const LookVector& v) const { return v.pitch_sin < down_sin; }
+    bool leaning_left(const LeanOffset& l) const { return l.valid && l.lateral_m >= lean_lateral_m; }
+    bool leaning_right(const LeanOffset& l) const { return l.valid && -l.lateral_m >= lean_lateral_m; }
+    bool leaning_vertical(const LeanOffset& l) const { return l.valid && std::abs(l.vertical_m) >= lean_vertical_m; }
+};
+
+// Lookout directions, as bit positions in an alarm's required and seen masks
+enum LookoutDirection : uint8_t {
+    DIR_LEFT = 0, DIR_RIGHT, DIR_UP, DIR_DOWN, DIR_LEAN_LEFT, DIR_LEAN_RIGHT, DIR_LEAN_VERTICAL,
+    DIR_COVERAGE, // Enough of the scan box's direction bins visited
+    DIR_COUNT
+};
+constexpr uint8_t direction_bit(LookoutDirection d) { return static_cast<uint8_t>(1u << d); }
+constexpr uint8_t LOOK_LEFT_RIGHT = direction_bit(DIR_LEFT) | direction_bit(DIR_RIGHT);
+constexpr uint8_t LOOK_ALL_ANGLES = LOOK_LEFT_RIGHT | direction_bit(DIR_UP) | direction_bit(DIR_DOWN) | direction_bit(DIR_COVERAGE);
+
+// Head-direction bins for coverage lookouts: 64 yaw bins of 5.625 deg round the
+// horizon by 8 pitch rows of 22.5 deg, one 64-bit word per row. A sample marks its
+// bin with one OR; a popcount against the alarm's region says how much was scanned.
+constexpr int kCoverageYawBins = 64;
+constexpr int kCoverageRows = 8;
+using CoverageMap = std::array<uint64_t, kCoverageRows>;
+
+inline int popcount64(uint64_t x) {
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<int>((x * 0x0101010101010101ULL) >> 56);
+}
+
+inline int coverage_count(const CoverageMap& map, const CoverageMap& region) {
+    int count = 0;
+    for (int row = 0; row < kCoverageRows; ++row) count += popcount64(map[row] & region[row]);
+    return count;
+}
+
+// Bin of a head direction in degrees (yaw -180..180, pitch -90..90)
+inline void coverage_bin(double yaw_deg, double pitch_deg, int& row, uint64_t& yaw_bit) {
+    int yaw_bin = static_cast<int>(std::floor((yaw_deg + 180.0) * (kCoverageYawBins / 360.0)));
+    row = static_cast<int>(std::floor((pitch_deg + 90.0) * (kCoverageRows / 180.0)));
+    yaw_bin = (std::max)(0, (std::min)(kCoverageYawBins - 1, yaw_bin));
+    row = (std::max)(0, (std::min)(kCoverageRows - 1, row));
+    yaw_bit = 1ULL << yaw_bin;
+}
+
+// Bins overlapping an alarm's scan box: yaw within +/-half_deg, pitch from -down_deg to up_deg
+inline CoverageMap coverage_region(double half_deg, double up_deg, double down_deg) {
+    CoverageMap region{};
+    const double yaw_step = 360.0 / kCoverageYawBins, pitch_step = 180.0 / kCoverageRows;
+    const double pitch_lo = -(std::max)(0.0, down_deg), pitch_hi = (std::max)(0.0, up_deg);
+    for (int row = 0; row < kCoverageRows; ++row) {
+        double lo = -90.0 + row * pitch_step;
+        if (lo + pitch_step <= pitch_lo || lo >= pitch_hi) continue;
+        for (int bin = 0; bin < kCoverageYawBins; ++bin) {
+            double yaw_lo = -180.0 + bin * yaw_step;
+            if (yaw_lo + yaw_step > -half_deg && yaw_lo < half_deg) region[row] |= 1ULL << bin;
+        }
+    }
+    return region;
+}
+
+// An enabled alarm as the evaluator uses it: look thresholds and engine-time durations
+// worked out once per settings load rather than from the raw config on every sample.
+struct CompiledAlarm {
+    uint32_t id = 0;                // Index in settings.json "alarms": logs, audio voice, latency stats
+    uint8_t required = 0;           // LookoutDirection bits a lookout needs: left, right, and any of up, down, lean
+    LookThresholds thresholds;
+    double horizontal_angle = 0.0;  // min_horizontal_angle: a lookout also covers every narrower alarm
+    uint32_t dominated_end = 0;     // Positions [0, dominated_end) are narrower and reset with this one
+    int64_t max_time_us = 0, repeat_interval_us = 0, min_lookout_us = 0, silence_after_look_us = 0;
+    int start_volume = 0, end_volume = 0;
+    int volume_ramp_ms = 0;
+    CoverageMap coverage_region{};  // Bins a coverage lookout counts
+    int coverage_needed = 0;        // Bins of the region to visit; 0 when not required
+    int64_t min_dwell_us = 0;       // 0: a single sample past a threshold counts
+};
+
+// The alarms the evaluator iterates: enabled ones only, densely packed and sorted by
+// horizontal angle, narrowest first. Disabled alarms get no entry, so the hot loop
+// never tests for them.
+struct AlarmTable {
+    std::vector<CompiledAlarm> alarms;
+};
+
+inline LookThresholds make_look_thresholds(const LookoutAlarmConfig& config) {
+    LookThresholds t;
+    t.half_horizontal_deg = config.min_horizontal_angle / 2.0;
+    t.up_deg = config.min_vertical_angle_up;
+    t.down_deg = config.min_vertical_angle_down;
+    double half_rad = deg2rad(t.half_horizontal_deg);
+    t.half_cos = std::cos(half_rad);
+    t.half_sin = std::sin(half_rad);
+    // Past +/-90 deg the pitch tests can never (or always) pass; clamping keeps that
+    t.up_sin = std::sin(deg2rad((std::max)(-90.0, (std::min)(90.0, t.up_deg))));
+    t.down_sin = std::sin(deg2rad((std::max)(-90.0, (std::min)(90.0, -t.down_deg))));
+    t.lean_lateral_m = (std::max)(0.0, config.min_lean_lateral_cm) / 100.0;
+    t.lean_vertical_m = (std::max)(0.0, config.min_lean_vertical_cm) / 100.0;
+    const double band_deg = (std::max)(0.0, config.hysteresis_deg), band_m = (std::max)(0.0, config.hysteresis_cm) / 100.0;
+    double exit_half_rad = deg2rad((std::max)(0.0, t.half_horizontal_deg - band_deg));
+    t.exit_half_cos = std::cos(exit_half_rad);
+    t.exit_half_sin = std::sin(exit_half_rad);
+    t.exit_up_sin = std::sin(deg2rad((std::max)(-90.0, (std::min)(90.0, t.up_deg - band_deg))));
+    t.exit_down_sin = std::sin(deg2rad((std::max)(-90.0, (std::min)(90.0, band_deg - t.down_deg))));
+    t.exit_lean_lateral_m = (std::max)(0.0, t.lean_lateral_m - band_m);
+    t.exit_lean_vertical_m = (std::max)(0.0, t.lean_vertical_m - band_m);
+    return t;
+}
+
+// One enabled alarm of settings.json (`id` is its index there) in the evaluator's form
+inline CompiledAlarm compile_alarm(const LookoutAlarmConfig& config, uint32_t id) {
+    CompiledAlarm alarm;
+    alarm.id = id;
+    alarm.thresholds = make_look_thresholds(config);
+    alarm.horizontal_angle = config.min_horizontal_angle;
+    alarm.max_time_us = ms_to_us(config.max_time_ms);
+    alarm.repeat_interval_us = ms_to_us(config.repeat_interval_ms < 100 ? 5000 : config.repeat_interval_ms);
+    alarm.min_lookout_us = ms_to_us(config.min_lookout_time_ms);
+    alarm.silence_after_look_us = ms_to_us(config.silence_after_look_ms);
+    alarm.start_volume = config.start_volume;
+    alarm.end_volume = config.end_volume;
+    alarm.volume_ramp_ms = config.volume_ramp_time_ms;
+    alarm.min_dwell_us = ms_to_us((std::max)(0, config.min_dwell_ms));
+    if (config.min_coverage_percent > 0.0) {
+        alarm.coverage_region = coverage_region(alarm.thresholds.half_horizontal_deg, config.min_vertical_angle_up, config.min_vertical_angle_down);
+        int region_bins = coverage_count(alarm.coverage_region, alarm.coverage_region);
+        alarm.coverage_needed = (std::max)(1, static_cast<int>(std::ceil(region_bins * (std::min)(100.0, config.min_coverage_percent) / 100.0)));
+    }
+    alarm.required = LOOK_LEFT_RIGHT;
+    if (config.min_vertical_angle_up > 0) alarm.required |= direction_bit(DIR_UP);
+    if (config.min_vertical_angle_down > 0) alarm.required |= direction_bit(DIR_DOWN);
+    if (alarm.thresholds.lean_lateral_m > 0.0) alarm.required |= direction_bit(DIR_LEAN_LEFT) | direction_bit(DIR_LEAN_RIGHT);
+    if (alarm.thresholds.lean_vertical_m > 0.0) alarm.required |= direction_bit(DIR_LEAN_VERTICAL);
+    if (alarm.coverage_needed > 0) alarm.required |= direction_bit(DIR_COVERAGE);
+    return alarm;
+}
+
+// Narrowest first (settings order among equals), so the alarms any one alarm's
+// lookout covers are the run before its equals
+inline void order_alarm_table(AlarmTable& table) {
+    std::stable_sort(table.alarms.begin(), table.alarms.end(),
+                     [](const CompiledAlarm& a, const CompiledAlarm& b) { return a.horizontal_angle < b.horizontal_angle; });
+    uint32_t run_begin = 0;
+    for (size_t k = 0; k < table.alarms.size(); ++k) {
+        if (table.alarms[k].horizontal_angle != table.alarms[run_begin].horizontal_angle) run_begin = static_cast<uint32_t>(k);
+        table.alarms[k].dominated_end = run_begin;
+    }
+}
+
+// Position of the lowest set bit of a nonzero word, for walking a bitmask
+inline int lowest_bit(uint64_t x) { return popcount64((x & (~x + 1)) - 1); }
+
+// One bound of every alarm of a table (say the up angle), sorted, with the alarms in
+// that order kept as prefix bitmasks: mask(k) has the bits of the k alarms with the
+// lowest bounds. The alarms a pose is past are the ones whose bound is below its
+// value, so one binary search gives their mask however many alarms there are. Bits
+// are table positions, 64 to a word.
+class SortedBounds {
+public:
+    void assign(const std::vector<double>& bounds, size_t words) {
+        const size_t n = bounds.size();
+        order_.resize(n);
+        for (size_t i = 0; i < n; ++i) order_[i] = static_cast<uint32_t>(i);
+        std::stable_sort(order_.begin(), order_.end(), [&](uint32_t a, uint32_t b) { return bounds[a] < bounds[b]; });
+        words_ = words;
+        bounds_.resize(n);
+        prefix_.assign((n + 1) * words, 0);
+        for (size_t k = 0; k < n; ++k) {
+            bounds_[k] = bounds[order_[k]];
+            uint64_t* next = prefix_.data() + (k + 1) * words;
+            std::copy_n(next - words, words, next);
+            next[order_[k] / 64] |= 1ULL << (order_[k] % 64);
+        }
+    }
+
+    // How many alarms have a bound below x, or at most x (none when x is NaN, as the
+    // comparisons they replace would say)
+    size_t below(double x) const {
+        return std::partition_point(bounds_.begin(), bounds_.end(), [x](double b) { return b < x; }) - bounds_.begin();
+    }
+    size_t at_or_below(double x) const {
+        return std::partition_point(bounds_.begin(), bounds_.end(), [x](double b) { return b <= x; }) - bounds_.begin();
+    }
+    // How many of the first `limit` alarms in bound order `passes(position)` holds for;
+    // it has to hold for a prefix of them
+    template <typename Passes>
+    size_t passing(size_t limit, Passes&& passes) const {
+        return std::partition_point(order_.begin(), order_.begin() + limit, passes) - order_.begin();
+    }
+    const uint64_t* mask(size_t k) const { return prefix_.data() + k * words_; }
+    uint32_t position(size_t k) const { return order_[k]; }
+
+private:
+    size_t words_ = 0;
+    std::vector<uint32_t> order_;   // Table positions by bound
+    std::vector<double> bounds_;    // Sorted
+    std::vector<uint64_t> prefix_;  // n + 1 masks of words_ words
+};
+
+// The per-sample direction tests of every alarm of a table as threshold searches.
+// Each test is "past a bound" on one axis, so the alarms passing it are the ones
+// below some rank of that bound: a binary search per bound instead of a test per
+// alarm. Down bounds are negated so "past" is "below" for them too, and pitch is
+// indexed both as the sines the pose is tested against and as the angles the peaks
+// are, since the two don't have to sort alike. The horizontal pose test stays in
+// (cos, sin) form: past_half falls as the half angle grows, so it is searched in the
+// order of atan2(sin, cos) as it is, and gives the same answers bit for bit. Half
+// angles past 180 deg (horizontal angles over 360) wrap round and aren't monotone;
+// those alarms, normally none, are tested one by one.
+struct ThresholdIndex {
+    size_t words = 0; // Per mask
+    SortedBounds half_deg, half, exit_half;
+    size_t half_sorted = 0, exit_half_sorted = 0; // Alarms in the monotone part of half, exit_half
+    std::vector<double> half_cos, half_sin, exit_half_cos, exit_half_sin; // By table position
+    SortedBounds up_sin, up_deg, exit_up_sin;
+    SortedBounds down_sin, down_deg, exit_down_sin; // -sin(-down), down, -exit_down_sin
+    SortedBounds lean_lateral, exit_lean_lateral, lean_vertical, exit_lean_vertical;
+    std::array<std::vector<uint64_t>, DIR_COVERAGE> required; // Alarms needing each direction
+
+    void reserve(size_t n) {
+        for (std::vector<double>* lane : { &half_cos, &half_sin, &exit_half_cos, &exit_half_sin }) lane->reserve(n);
+        for (std::vector<uint64_t>& mask : required) mask.reserve((n + 63) / 64);
+    }
+
+    void assign(const std::vector<CompiledAlarm>& alarms) {
+        const size_t n = alarms.size();
+        words = (n + 63) / 64;
+        auto lane = [&](auto&& of) {
+            std::vector<double> values(n);
+            for (size_t i = 0; i < n; ++i) values[i] = of(alarms[i].thresholds);
+            return values;
+        };
+        half_cos = lane([](const LookThresholds& t) { return t.half_cos; });
+        half_sin = lane([](const LookThresholds& t) { return t.half_sin; });
+        exit_half_cos = lane([](const LookThresholds& t) { return t.exit_half_cos; });
+        exit_half_sin = lane([](const LookThresholds& t) { return t.exit_half_sin; });
+        half_sorted = assign_horizontal(half, half_cos, half_sin);
+        exit_half_sorted = assign_horizontal(exit_half, exit_half_cos, exit_half_sin);
+        half_deg.assign(lane([](const LookThresholds& t) { return t.half_horizontal_deg; }), words);
+        up_sin.assign(lane([](const LookThresholds& t) { return t.up_sin; }), words);
+        up_deg.assign(lane([](const LookThresholds& t) { return t.up_deg; }), words);
+        exit_up_sin.assign(lane([](const LookThresholds& t) { return t.exit_up_sin; }), words);
+        down_sin.assign(lane([](const LookThresholds& t) { return -t.down_sin; }), words);
+        down_deg.assign(lane([](const LookThresholds& t) { return t.down_deg; }), words);
+        exit_down_sin.assign(lane([](const LookThresholds& t) { return -t.exit_down_sin; }), words);
+        lean_lateral.assign(lane([](const LookThresholds& t) { return t.lean_lateral_m; }), words);
+        exit_lean_lateral.assign(lane([](const LookThresholds& t) { return t.exit_lean_lateral_m; }), words);
+        lean_vertical.assign(lane([](const LookThresholds& t) { return t.lean_vertical_m; }), words);
+        exit_lean_vertical.assign(lane([](const LookThresholds& t) { return t.exit_lean_vertical_m; }), words);
+        for (int d = 0; d < DIR_COVERAGE; ++d) {
+            required[d].assign(words, 0);
+            for (size_t i = 0; i < n; ++i) {
+                if (alarms[i].required & direction_bit(static_cast<LookoutDirection>(d))) required[d][i / 64] |= 1ULL << (i % 64);
+            }
+        }
+    }
+
+private:
+    // Sorted by half angle as (cos, sin) give it, wrapped ones last; returns how many aren't
+    size_t assign_horizontal(SortedBounds& bounds, const std::vector<double>& cos, const std::vector<double>& sin) {
+        std::vector<double> angles(cos.size());
+        size_t sorted = 0;
+        for (size_t i = 0; i < angles.size(); ++i) {
+            angles[i] = std::atan2(sin[i], cos[i]);
+            if (angles[i] < 0.0) {
+                angles[i] = HUGE_VAL;
+            } else {
+                ++sorted;
+            }
+        }
+        bounds.assign(angles, words);
+        return sorted;
+    }
+};
+
+// Hierarchical timer wheel for the alarm engine's repeat, silence, ramp, max-time and
+// center-hold timers. Four levels of 64 slots at ~1 ms resolution cover ~4.8 h;
+// scheduling and cancelling are O(1), and advancing touches only the slots that
+// come due, so per-tick cost doesn't grow with the number of configured alarms.
+class TimerWheel {
+public:
+    struct TimerId {
+        int32_t node = -1;
+        uint32_t generation = 0;
+    };
+
+    TimerWheel() {
+        for (auto& level : slots_) level.fill(-1);
+    }
+
+    // Schedule a timer to fire once `when_us` has been reached. Timers already due fire
+    // on the next advance().
+    TimerId schedule(int64_t when_us, uint32_t kind, uint32_t index) {
+        int32_t n = allocate_node();
+        Node& node = nodes_[n];
+        node.expiry_tick = (std::max<int64_t>)(when_us >> kTickShift, 0);
+        node.kind = kind;
+        node.index = index;
+        node.active = true;
+        insert(n);
+        return TimerId{ n, node.generation };
+    }
+
+    void cancel(TimerId& id) {
+        if (is_scheduled(id)) {
+            unlink(id.node);
+            release_node(id.node);
+        }
+        id = TimerId{};
+    }
+
+    void reschedule(TimerId& id, int64_t when_us, uint32_t kind, uint32_t index) {
+        cancel(id);
+        id = schedule(when_us, kind, index);
+    }
+
+    bool is_scheduled(const TimerId& id) const {
+        return id.node >= 0 && id.node < static_cast<int32_t>(nodes_.size()) &&
+               nodes_[id.node].active && nodes_[id.node].generation == id.generation;
+    }
+
+    // Advance wheel time to `now_us`, calling on_expire(kind, index) for each due timer.
+    // Callbacks may schedule and cancel timers; anything they make due fires in this call.
+    template <typename Callback>
+    void advance(int64_t now_us, Callback&& on_expire) {
+        int64_t target_tick = now_us >> kTickShift;
+        while (current_tick_ < target_tick) {
+            // Skip straight past ticks where nothing can fire or cascade
+            int64_t skip_to = target_tick;
+            for (int level = 0; level < kLevels; ++level) {
+                if (!occupied_[level]) continue;
+                int64_t span = 1LL << (level * kSlotBits);
+                skip_to = (std::min)(target_tick, ((current_tick_ / span) + 1) * span);
+                break;
+            }
+            current_tick_ = skip_to - 1;
+            ++current_tick_;
+            cascade();
+            move_slot_to_due(0, static_cast<int>(current_tick_ & kSlotMask));
+        }
+        while (due_head_ >= 0) {
+            int32_t n = due_head_;
+            unlink(n);
+            uint32_t kind = nodes_[n].kind;
+            uint32_t index = nodes_[n].index;
+            release_node(n);
+            on_expire(kind, index);
+        }
+    }
+
+    // Lower bound on the next expiry (wheel time, us), or INT64_MAX when idle. Timers in
+    // the coarser levels report the start of their slot, so this may wake a little early.
+    int64_t next_expiry_lower_bound_us() const {
+        if (due_head_ >= 0) return current_tick_ << kTickShift;
+        int64_t best_tick = INT64_MAX;
+        for (int level = 0; level < kLevels; ++level) {
+            if (!occupied_[level]) continue;
+            int shift = level * kSlotBits;
+            int64_t level_position = current_tick_ >> shift;
+            for (int k = 1; k <= kSlots; ++k) {
+                int slot = static_cast<int>((level_position + k) & kSlotMask);
+                if (occupied_[level] & (1ULL << slot)) {
+                    best_tick = (std::min)(best_tick, (level_position + k) << shift);
+                    break;
+                }
+            }
+        }
+        return best_tick == INT64_MAX ? INT64_MAX : (best_tick << kTickShift);
+    }
+
+private:
+    static constexpr int kTickShift = 10;   // 1024 us per wheel tick
+    static constexpr int kSlotBits = 6;
+    static constexpr int kSlots = 1 << kSlotBits;
+    static constexpr int64_t kSlotMask = kSlots - 1;
+    static constexpr int kLevels = 4;
+    static constexpr int64_t kMaxDelta = (1LL << (kSlotBits * kLevels)) - 1;
+
+    struct Node {
+        int64_t expiry_tick = 0;
+        uint32_t kind = 0, index = 0;
+        int32_t prev = -1, next = -1;
+        int32_t* list_head = nullptr; // Owning slot/due list, for O(1) unlink
+        uint64_t* occupancy = nullptr;
+        int occupancy_bit = 0;
+        uint32_t generation = 0;
+        bool active = false;
+    };
+
+    int32_t allocate_node() {
+        if (free_head_ >= 0) {
+            int32_t n = free_head_;
+            free_head_ = nodes_[n].next;
+            return n;
+        }
+        nodes_.emplace_back();
+        return static_cast<int32_t>(nodes_.size() - 1);
+    }
+
+    void release_node(int32_t n) {
+        Node& node = nodes_[n];
+        node.active = false;
+        ++node.generation;
+        node.list_head = nullptr;
+        node.occupancy = nullptr;
+        node.prev = -1;
+        node.next = free_head_;
+        free_head_ = n;
+    }
+
+    void push(int32_t n, int32_t* head, uint64_t* occupancy, int bit) {
+        Node& node = nodes_[n];
+        node.prev = -1;
+        node.next = *head;
+        if (*head >= 0) nodes_[*head].prev = n;
+        *head = n;
+        node.list_head = head;
+        node.occupancy = occupancy;
+        node.occupancy_bit = bit;
+        if (occupancy) *occupancy |= (1ULL << bit);
+    }
+
+    void unlink(int32_t n) {
+        Node& node = nodes_[n];
+        if (node.prev >= 0) nodes_[node.prev].next = node.next;
+        else if (node.list_head) *node.list_head = node.next;
+        if (node.next >= 0) nodes_[node.next].prev = node.prev;
+        if (node.occupancy && node.list_head && *node.list_head < 0) {
+            *node.occupancy &= ~(1ULL << node.occupancy_bit);
+        }
+        node.prev = node.next = -1;
+        node.list_head = nullptr;
+        node.occupancy = nullptr;
+    }
+
+    void insert(int32_t n) {
+        int64_t delta = nodes_[n].expiry_tick - current_tick_;
+        if (delta <= 0) {
+            push(n, &due_head_, nullptr, 0);
+            return;
+        }
+        // Expiries past the wheel's range park in the last level and re-cascade until due
+        int64_t slot_tick = current_tick_ + (std::min)(delta, kMaxDelta);
+        int level = 0;
+        while (level < kLevels - 1 && delta >= (1LL << (kSlotBits * (level + 1)))) ++level;
+        int slot = static_cast<int>((slot_tick >> (level * kSlotBits)) & kSlotMask);
+        push(n, &slots_[level][slot], &occupied_[level], slot);
+    }
+
+    // When a lower level wraps, redistribute the matching slot of each coarser level,
+    // coarsest first so entries can fall all the way down in one pass.
+    void cascade() {
+        int top = 0;
+        while (top < kLevels - 1 && (current_tick_ & ((1LL << (kSlotBits * (top + 1))) - 1)) == 0) ++top;
+        for (int level = top; level >= 1; --level) {
+            int slot = static_cast<int>((current_tick_ >> (level * kSlotBits)) & kSlotMask);
+            int32_t n = slots_[level][slot];
+            slots_[level][slot] = -1;
+            occupied_[level] &= ~(1ULL << slot);
+            while (n >= 0) {
+                int32_t next = nodes_[n].next;
+                nodes_[n].prev = nodes_[n].next = -1;
+                nodes_[n].list_head = nullptr;
+                nodes_[n].occupancy = nullptr;
+                insert(n);
+                n = next;
+            }
+        }
+    }
+
+    void move_slot_to_due(int level, int slot) {
+        int32_t n = slots_[level][slot];
+        slots_[level][slot] = -1;
+        occupied_[level] &= ~(1ULL << slot);
+        while (n >= 0) {
+            int32_t next = nodes_[n].next;
+            push(n, &due_head_, nullptr, 0);
+            n = next;
+        }
+    }
+
+    std::vector<Node> nodes_;
+    std::array<std::array<int32_t, kSlots>, kLevels> slots_;
+    uint64_t occupied_[kLevels] = {};
+    int32_t due_head_ = -1;
+    int32_t free_head_ = -1;
+    int64_t current_tick_ = 0;
+};
+
+// Interpolated turning points (degrees) between the previous sample and this one.
+// The defaults never pass a threshold test.
+struct LookExtent {
+    double yaw_max = -1000.0, yaw_min = 1000.0, pitch_max = -1000.0, pitch_min = 1000.0;
+};
+
+// One evaluated pose as the engine takes it: already filtered and relative to the
+// pilot's reference, with any interpolated peaks since the previous one
+struct LookInput {
+    LookVector look;
+    LeanOffset lean;
+    LookExtent peaks;
+    int64_t dt_us = 0; // Engine time since the previous evaluated pose; 0 after a pause
+};
+
+// What the engine decided on a call, for the caller to play and log. `index` is the
+// alarm's table position, `alarm` its id.
+struct LookoutEvent {
+    enum Type : uint8_t {
+        WARNING_START,     // Start the warning clip; value: us past the alarm's deadline
+        WARNING_REPEAT,    // Replay the clip at its ramp position; value: ms into the warning
+        WARNING_RESUME,    // Same for a warning carried across a table change, not a new reminder
+        MUTE,              // Silence a sounding warning after a new look; value: 1 to log it
+        UNMUTE,            // Silence window over; value: 1 to log it
+        STOP,              // Stop the clip
+        LOOKOUT_SUCCESS,   // value: L/R time difference (us)
+        NARROWER_RESET,    // A wider alarm's lookout also reset this one; value: the wider alarm's id
+        LOOKOUT_TOO_QUICK, // All directions seen but L and R too close together; value: L/R difference (us)
+        DIRECTION_SEEN,    // value: the LookoutDirection
+        LOOK_SILENCED,     // New L/R look; value: silence length (us)
+        DUE_WHILE_SILENCED,// Max no-look time reached inside a silence window; sounds when it ends
+        CENTER_RESET       // Looked ahead for the hold time; every alarm's direction flags cleared
+    };
+    static const char* name(Type type) {
+        static const char* const kNames[] = {
+            "warning_start", "warning_repeat", "warning_resume", "mute", "unmute", "stop", "lookout_success",
+            "narrower_reset", "lookout_too_quick", "direction_seen", "look_silenced", "due_while_silenced", "center_reset"
+        };
+        return type < sizeof(kNames) / sizeof(kNames[0]) ? kNames[type] : "?";
+    }
+
+    Type type = STOP;
+    uint32_t index = 0;
+    uint32_t alarm = 0;
+    int volume = 0;    // WARNING_*: the ramp's target volume now
+    int64_t value = 0;
+};
+
+// Recent poses of one alarm with a dwell requirement: how long each direction was held
+// within the last 2 x min_dwell of engine time. A direction counts once it was held for
+// min_dwell of that window, so a flick past the threshold doesn't, while a real look
+// with a sample or two of jitter still does. Sized for the window at the fastest pose
+// rate the caller expects; a faster stream grows it (once) rather than dropping samples
+// still in the window, which would make a long min_dwell unreachable. Each push is
+// amortized O(1).
+class DwellRing {
+public:
+    static constexpr size_t kMinCapacity = 256; // ~2.8 s of samples at 90 Hz
+
+    explicit DwellRing(int64_t min_dwell_us = 0, double peak_rate_hz = 0.0)
+        : min_us_(min_dwell_us), window_us_(2 * min_dwell_us), slots_(capacity_for(window_us_, peak_rate_hz)) {}
+
+    // Slots a window holds at rate_hz, with a spare for the sample that leaves it
+    static size_t capacity_for(int64_t window_us, double rate_hz) {
+        const double samples = std::ceil(static_cast<double>(window_us) * 1e-6 * (std::max)(0.0, rate_hz)) + 2.0;
+        return (std::max)(kMinCapacity, static_cast<size_t>((std::min)(samples, 1e6)));
+    }
+
+    // Account one pose (held for dt_us since the previous one); returns the directions
+    // held long enough
+    uint8_t push(int64_t dt_us, uint8_t hits) {
+        if (size_ == slots_.size()) grow();
+        Slot& slot = slots_[(head_ + size_) % slots_.size()];
+        slot.dt_us = static_cast<int32_t>((std::min<int64_t>)(dt_us, window_us_));
+        slot.hits = hits;
+        ++size_;
+        span_us_ += slot.dt_us;
+        uint8_t held = 0;
+        for (uint8_t d = 0; d < DIR_COUNT; ++d) {
+            if (hits & (1u << d)) held_us_[d] += slot.dt_us;
+        }
+        while (size_ > 1 && span_us_ - slots_[head_].dt_us >= window_us_) pop();
+        for (uint8_t d = 0; d < DIR_COUNT; ++d) {
+            if (held_us_[d] >= min_us_) held |= static_cast<uint8_t>(1u << d);
+        }
+        return held;
+    }
+
+private:
+    struct Slot {
+        int32_t dt_us = 0;
+        uint8_t hits = 0;
+    };
+
+    void pop() {
+        const Slot& slot = slots_[head_];
+        span_us_ -= slot.dt_us;
+        for (uint8_t d = 0; d < DIR_COUNT; ++d) {
+            if (slot.hits & (1u << d)) held_us_[d] -= slot.dt_us;
+        }
+        head_ = (head_ + 1) % slots_.size();
+        --size_;
+    }
+
+    // Unwrapped into twice the room
+    void grow() {
+        std::vector<Slot> slots(slots_.size() * 2);
+        for (size_t k = 0; k < size_; ++k) slots[k] = slots_[(head_ + k) % slots_.size()];
+        slots_.swap(slots);
+        head_ = 0;
+    }
+
+    int64_t min_us_, window_us_;
+    std::vector<Slot> slots_;
+    size_t head_ = 0, size_ = 0;
+    int64_t span_us_ = 0;
+    std::array<int64_t, DIR_COUNT> held_us_{};
+};
+
+// One alarm's state as LookoutEngine::snapshot() takes it. Times are relative to the
+// snapshot, so it restores into an engine at another engine time (the headset came
+// back) or in another process (the next lookout.exe). Fixed-size fields only, written
+// to disk as they are.
+struct AlarmSnapshot {
+    uint32_t alarm;                    // CompiledAlarm::id
+    uint32_t identity;                 // alarm_identity(): only the same thresholds take it back
+    int64_t no_look_us;                // Into the no-look period
+    int64_t warning_us;                // Into the warning (warnings only)
+    int64_t since_repeat_us;           // Since the last repeat (warnings only)
+    int64_t silence_left_us;           // Silence after look still to run
+    int64_t left_ago_us, right_ago_us; // Since left/right were seen (caller's clock); -1 if not
+    uint8_t seen;                      // LookoutDirection bits seen this lookout
+    uint8_t warning;                   // warning_triggered
+    uint8_t repeat_pending;
+    uint8_t silence_message;           // silence_message_printed_this_period
+    uint32_t reserved;
+};
+static_assert(sizeof(AlarmSnapshot) == 64, "AlarmSnapshot is written to disk as is");
+
+// Hash of what makes an alarm the same alarm to its pilot (LookoutAlarmConfig::same_identity):
+// its look, lean and coverage requirements
+inline uint32_t alarm_identity(const CompiledAlarm& alarm) {
+    const double fields[] = { alarm.thresholds.half_horizontal_deg, alarm.thresholds.up_deg, alarm.thresholds.down_deg,
+                              alarm.thresholds.lean_lateral_m, alarm.thresholds.lean_vertical_m,
+                              static_cast<double>(alarm.coverage_needed), static_cast<double>(alarm.required) };
+    uint32_t hash = 2166136261u; // FNV-1a
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(fields);
+    for (size_t k = 0; k < sizeof(fields); ++k) hash = (hash ^ bytes[k]) * 16777619u;
+    return hash;
+}
+
+// Lookout detection and alarm timing for one alarm table: direction flags, L/R timing,
+// silence windows, max-time warnings and repeats, the narrower-alarm reset and the center
+// reset. A pure state machine on engine time, which only advances by what the caller
+// passes in, so the same inputs always give the same events. Each call returns the
+// events it produced; the list is reused by the next call.
+//
+// Per-alarm state is split by how often it's touched: the seen-direction masks and
+// the thresholds (AlarmLanes) are arrays scanned for every pose, while AlarmState holds
+// what only changes when a direction is first seen or a timer fires.
+class LookoutEngine {
+public:
+    struct AlarmState {
+        bool warning_triggered = false;
+        int64_t no_look_start_us = 0, last_repeat_us = 0, warning_start_us = 0; // Engine time
+        int64_t left_ever_us = -1, right_ever_us = -1; // Caller's clock (step's now_us)
+        int64_t alarm_silence_until_us = 0; // Engine time
+        bool repeat_pending = false;        // Repeat came due while the warning was silenced
+        TimerWheel::TimerId max_time_timer, silence_timer, repeat_timer;
+        bool silence_message_printed_this_period = false;
+    };
+
+    explicit LookoutEngine(AlarmTable table = AlarmTable()) : table_(std::move(table)) {
+        states_.resize(table_.alarms.size());
+        seen_.resize(table_.alarms.size());
+        adopt_table_layout();
+        coverage_.assign(table_.alarms.size(), CoverageMap{});
+        for (size_t i = 0; i < table_.alarms.size(); ++i) schedule_max_time(i, table_.alarms[i].max_time_us);
+    }
+
+    // |yaw| < window  <=>  cos(yaw) > cos(window);  |pitch| < window  <=>  |sin(pitch)| < sin(window)
+    void set_center_reset(double window_degrees, double hold_time_seconds) {
+        const double window_rad = window_degrees * 3.14159265358979323846 / 180.0;
+        center_yaw_cos_ = std::cos(window_rad);
+        center_pitch_sin_ = window_degrees >= 90.0 ? 2.0 : std::sin(window_rad);
+        center_hold_us_ = seconds_to_us(hold_time_seconds);
+        anchor_valid_ = false;
+    }
+
+    // Fixed-step mode (step_us > 0): engine time only moves in whole steps, and due
+    // timers fire at the step they fall in, with poses evaluated at the last step
+    // boundary they reached. Time short of a step carries over to the next call, so
+    // a sample trace gives the same events however its timestamps split up, and no
+    // rounding accumulates. 0 goes back to continuous time.
+    void set_fixed_step(int64_t step_us) {
+        fixed_step_us_ = (std::max<int64_t>)(0, step_us);
+        step_carry_us_ = 0;
+    }
+
+    // Fastest pose rate step() will see (burst sampling), so dwell rings hold their whole
+    // window without growing mid-flight. Restarts any dwell in progress.
+    void set_peak_sample_rate(double rate_hz) {
+        peak_rate_hz_ = rate_hz;
+        for (size_t k = 0; k < dwell_alarms_.size(); ++k) {
+            dwell_rings_[k] = DwellRing(table_.alarms[dwell_alarms_[k]].min_dwell_us, peak_rate_hz_);
+        }
+    }
+
+    // Room for this many alarms, so table changes up to that size don't allocate
+    void reserve(size_t alarms) {
+        states_.reserve(alarms);
+        seen_.reserve(alarms);
+        hits_.reserve(alarms);
+        const size_t words = (alarms + 63) / 64;
+        for (std::vector<uint64_t>* mask : { &touched_, &crossed_, &exit_crossed_, &inside_mask_ }) mask->reserve(words);
+        for (int d = 0; d < DIR_COVERAGE; ++d) {
+            enter_[d].reserve(words);
+            stay_[d].reserve(words);
+        }
+        inside_.reserve(alarms);
+        coverage_.reserve(alarms);
+        coverage_alarms_.reserve(alarms);
+        index_.reserve(alarms);
+        events_.reserve(alarms * 4);
+    }
+
+    // Evaluate one pose taken at `now_us` (the caller's clock, kept for the L/R timing):
+    // center reset, each alarm's lookout progress, then the timers due by this pose
+    const std::vector<LookoutEvent>& step(const LookInput& input, int64_t now_us) {
+        events_.clear();
+        advance_time(input.dt_us);
+        if (fixed_step_us_ > 0) now_us -= now_us % fixed_step_us_;
+
+        // A head held still (within kStationaryEpsilon of the last evaluated pose, the
+        // usual state while flying on the instruments) passes exactly the tests it passed
+        // then, so their results are reused instead of recomputed for every alarm
+        const LookVector& look = input.look;
+        const bool stationary = is_stationary(input);
+        if (!stationary) {
+            anchor_ = input;
+            anchor_valid_ = true;
+            anchor_centered_ = look.yaw_cos > center_yaw_cos_ * std::sqrt(look.yaw_sin * look.yaw_sin + look.yaw_cos * look.yaw_cos) &&
+                               std::abs(look.pitch_sin) < center_pitch_sin_;
+        } else {
+            ++stationary_steps_;
+        }
+        if (anchor_centered_) {
+            if (!center_reset_active_ && !timers_.is_scheduled(center_hold_timer_)) {
+                center_hold_timer_ = timers_.schedule(engine_us_ + center_hold_us_, TIMER_CENTER_HOLD, 0);
+            }
+        } else {
+            timers_.cancel(center_hold_timer_);
+            center_reset_active_ = false;
+        }
+
+        // Every alarm's direction tests as searches of the threshold index; only alarms
+        // touched by them are visited after that, and only those with a direction seen
+        // for the first time go on to the per-alarm bookkeeping, in table order. Read
+        // against seen_ as it is now, since a lookout can reset other alarms.
+        ++kernel_cycles_.steps;
+        if (!stationary) {
+            KernelClock clock(kernel_cycles_.kernel[KERNEL_DETECT]);
+            detect_looks(input);
+        }
+        {
+            KernelClock clock(kernel_cycles_.kernel[KERNEL_HYSTERESIS]);
+            apply_hysteresis();
+        }
+        for (size_t k = 0; k < dwell_alarms_.size(); ++k) {
+            uint32_t i = dwell_alarms_[k];
+            KernelClock clock(kernel_cycles_.alarm[i]);
+            hits_[i] &= dwell_rings_[k].push(input.dt_us, hits_[i]);
+        }
+        if (!coverage_alarms_.empty()) {
+            KernelClock clock(kernel_cycles_.kernel[KERNEL_COVERAGE]);
+            update_coverage(look, stationary);
+        }
+        for (size_t w = 0; w < touched_.size(); ++w) {
+            for (uint64_t bits = touched_[w]; bits; bits &= bits - 1) {
+                const size_t i = w * 64 + lowest_bit(bits);
+                uint8_t fresh = static_cast<uint8_t>(hits_[i] & ~seen_[i]);
+                if (fresh) {
+                    KernelClock clock(kernel_cycles_.alarm[i]);
+                    register_looks(i, fresh, now_us);
+                }
+            }
+        }
+
+        // Max-time expiry, silence end, ramp steps, repeats and the center-reset hold
+        // all fire from the timer wheel rather than being polled per alarm
+        KernelClock clock(kernel_cycles_.kernel[KERNEL_TIMERS]);
+        run_due_timers();
+        return events_;
+    }
+
+    // Let engine time run on without a pose (timers only)
+    const std::vector<LookoutEvent>& advance(int64_t dt_us) {
+        events_.clear();
+        advance_time(dt_us);
+        run_due_timers();
+        return events_;
+    }
+
+    // Full reset of every alarm: a flight ended or resumed
+    const std::vector<LookoutEvent>& reset_all() {
+        events_.clear();
+        for (size_t i = 0; i < states_.size(); ++i) reset_alarm(i);
+        return events_;
+    }
+
+    // Stop every warning and restart the no-look periods, keeping lookout progress:
+    // the headset session was lost
+    const std::vector<LookoutEvent>& restart_all() {
+        events_.clear();
+        for (size_t i = 0; i < states_.size(); ++i) {
+            emit(LookoutEvent::STOP, i);
+            restart_no_look(i);
+        }
+        return events_;
+    }
+
+    // Stop any warning and keep every alarm silent for a while. Progress towards the
+    // lookout is kept, and an overdue alarm sounds once the snooze is over.
+    const std::vector<LookoutEvent>& snooze(int64_t snooze_us) {
+        events_.clear();
+        for (size_t i = 0; i < states_.size(); ++i) {
+            AlarmState& state = states_[i];
+            restart_no_look(i);
+            emit(LookoutEvent::STOP, i);
+            state.alarm_silence_until_us = engine_us_ + snooze_us;
+            timers_.reschedule(state.silence_timer, state.alarm_silence_until_us, TIMER_SILENCE_END, static_cast<uint32_t>(i));
+        }
+        return events_;
+    }
+
+    // Exchange the alarm table for `other` (an alarm profile switch): the outgoing
+    // alarms stop, the incoming ones start a fresh no-look period
+    const std::vector<LookoutEvent>& swap_table(AlarmTable& other) {
+        events_.clear();
+        for (size_t i = 0; i < states_.size(); ++i) {
+            cancel_timers(states_[i]);
+            emit(LookoutEvent::STOP, i);
+        }
+        std::swap(table_, other);
+        states_.assign(table_.alarms.size(), AlarmState());
+        seen_.assign(table_.alarms.size(), 0);
+        coverage_.assign(table_.alarms.size(), CoverageMap{});
+        adopt_table_layout();
+        for (size_t i = 0; i < states_.size(); ++i) start_fresh(i);
+        return events_;
+    }
+
+    // Replace the table after a settings reload. New alarm n takes over old alarm
+    // carried_from[n]'s state under its new timings (-1: start fresh); a carried
+    // warning resumes at its ramp position. Timers are keyed by table position, so
+    // every one is rescheduled.
+    const std::vector<LookoutEvent>& replace_table(AlarmTable next, const std::vector<int>& carried_from) {
+        events_.clear();
+        std::vector<AlarmState> next_states(next.alarms.size());
+        std::vector<uint8_t> next_seen(next.alarms.size(), 0);
+        std::vector<CoverageMap> next_coverage(next.alarms.size(), CoverageMap{});
+        for (AlarmState& state : states_) cancel_timers(state);
+        for (size_t n = 0; n < next_states.size(); ++n) {
+            if (n < carried_from.size() && carried_from[n] >= 0) {
+                next_states[n] = states_[carried_from[n]];
+                next_seen[n] = seen_[carried_from[n]];
+                next_coverage[n] = coverage_[carried_from[n]];
+            }
+        }
+        table_ = std::move(next);
+        size_t capacity = states_.capacity();
+        states_ = std::move(next_states);
+        states_.reserve(capacity);
+        seen_ = std::move(next_seen);
+        seen_.reserve(capacity);
+        coverage_ = std::move(next_coverage);
+        coverage_.reserve(capacity);
+        adopt_table_layout();
+
+        for (size_t i = 0; i < states_.size(); ++i) {
+            if (i >= carried_from.size() || carried_from[i] < 0) start_fresh(i);
+            else resume_state(i);
+        }
+        return events_;
+    }
+
+    // Every alarm's state now, for restore()
+    std::vector<AlarmSnapshot> snapshot(int64_t now_us) const {
+        std::vector<AlarmSnapshot> alarms(states_.size());
+        for (size_t i = 0; i < states_.size(); ++i) {
+            const AlarmState& state = states_[i];
+            AlarmSnapshot& s = alarms[i];
+            s = AlarmSnapshot();
+            s.alarm = table_.alarms[i].id;
+            s.identity = alarm_identity(table_.alarms[i]);
+            s.no_look_us = engine_us_ - state.no_look_start_us;
+            s.warning_us = state.warning_triggered ? engine_us_ - state.warning_start_us : 0;
+            s.since_repeat_us = state.warning_triggered ? engine_us_ - state.last_repeat_us : 0;
+            s.silence_left_us = (std::max<int64_t>)(0, state.alarm_silence_until_us - engine_us_);
+            s.left_ago_us = state.left_ever_us >= 0 ? now_us - state.left_ever_us : -1;
+            s.right_ago_us = state.right_ever_us >= 0 ? now_us - state.right_ever_us : -1;
+            s.seen = seen_[i];
+            s.warning = state.warning_triggered;
+            s.repeat_pending = state.repeat_pending;
+            s.silence_message = state.silence_message_printed_this_period;
+        }
+        return alarms;
+    }
+
+    // Put back the state a snapshot() took, as if no time had passed since: each alarm
+    // with the same id and thresholds as a snapshot entry takes it over (a warning
+    // resumes at its ramp position), the others keep theirs. Coverage progress and
+    // dwell start over. `restored` gets the number of alarms that matched.
+    const std::vector<LookoutEvent>& restore(const std::vector<AlarmSnapshot>& snapshot, int64_t now_us, size_t* restored = nullptr) {
+        events_.clear();
+        size_t matched = 0;
+        for (size_t i = 0; i < states_.size(); ++i) {
+            const uint32_t id = table_.alarms[i].id, identity = alarm_identity(table_.alarms[i]);
+            auto s = std::find_if(snapshot.begin(), snapshot.end(),
+                                  [&](const AlarmSnapshot& a) { return a.alarm == id && a.identity == identity; });
+            if (s == snapshot.end()) continue;
+            AlarmState& state = states_[i];
+            cancel_timers(state);
+            if (state.warning_triggered && !s->warning) emit(LookoutEvent::STOP, i);
+            state.no_look_start_us = engine_us_ - (std::max<int64_t>)(0, s->no_look_us);
+            state.warning_triggered = s->warning != 0;
+            state.warning_start_us = engine_us_ - s->warning_us;
+            state.last_repeat_us = engine_us_ - s->since_repeat_us;
+            state.alarm_silence_until_us = s->silence_left_us > 0 ? engine_us_ + s->silence_left_us : 0;
+            state.left_ever_us = s->left_ago_us >= 0 ? now_us - s->left_ago_us : -1;
+            state.right_ever_us = s->right_ago_us >= 0 ? now_us - s->right_ago_us : -1;
+            state.repeat_pending = s->repeat_pending != 0;
+            state.silence_message_printed_this_period = s->silence_message != 0;
+            seen_[i] = static_cast<uint8_t>(s->seen & ~direction_bit(DIR_COVERAGE) & table_.alarms[i].required);
+            coverage_[i] = CoverageMap{};
+            inside_[i] = 0;
+            resume_state(i);
+            ++matched;
+        }
+        if (restored) *restored = matched;
+        return events_;
+    }
+
+    const AlarmTable& table() const { return table_; }
+    const std::vector<CompiledAlarm>& alarms() const { return table_.alarms; }
+    const AlarmState& state(size_t i) const { return states_[i]; }
+    uint8_t seen(size_t i) const { return seen_[i]; } // LookoutDirection bits seen this lookout
+    int coverage_bins(size_t i) const { return coverage_count(coverage_[i], table_.alarms[i].coverage_region); }
+    int64_t engine_us() const { return engine_us_; }
+    uint64_t stationary_steps() const { return stationary_steps_; } // Poses that reused the last direction tests
+
+    // step() cost by kernel, and by alarm for the per-alarm work (dwell, registering a
+    // look); the lane passes serve every alarm at once and count only under their
+    // kernel. All zero unless LOOKOUT_KERNEL_CYCLES is on. Since the last take.
+    enum Kernel { KERNEL_DETECT, KERNEL_HYSTERESIS, KERNEL_COVERAGE, KERNEL_TIMERS, KERNEL_COUNT };
+    static const char* kernel_name(int kernel) {
+        static const char* const names[KERNEL_COUNT] = { "detect", "hysteresis", "coverage", "timers" };
+        return names[kernel];
+    }
+    struct KernelCycles {
+        uint64_t steps = 0;
+        std::array<uint64_t, KERNEL_COUNT> kernel{};
+        std::vector<uint64_t> alarm; // By table position
+    };
+    const KernelCycles& kernel_cycles() const { return kernel_cycles_; }
+    void reset_kernel_cycles() {
+        kernel_cycles_.steps = 0;
+        kernel_cycles_.kernel.fill(0);
+        std::fill(kernel_cycles_.alarm.begin(), kernel_cycles_.alarm.end(), 0);
+    }
+
+    // Engine time of the next timer (a lower bound), or INT64_MAX when none is set
+    int64_t next_timer_us() const { return timers_.next_expiry_lower_bound_us(); }
+
+private:
+    // Timer kinds registered with the timer wheel; the index is the alarm's position
+    enum AlarmTimerKind : uint32_t {
+        TIMER_MAX_TIME = 0,   // No-look time reached max_time_ms
+        TIMER_SILENCE_END,    // Silence-after-look window ended
+        TIMER_REPEAT,         // Repeat interval of an active warning elapsed
+        TIMER_CENTER_HOLD     // Center-reset hold time reached (not tied to an alarm)
+    };
+
+    // Largest change of a look vector component (~0.006 deg) or of a lean (0.1 mm) that
+    // still counts as the same pose. Below tracking noise on a moving head, so only a
+    // head really held still is short-circuited, and a threshold crossing it hides is
+    // seen as soon as the head drifts past it.
+    static constexpr double kStationaryEpsilon = 1e-4;
+
+    // Same pose as the anchor (the last one evaluated in full). Interpolated peaks
+    // always mean motion.
+    bool is_stationary(const LookInput& input) const {
+        if (!anchor_valid_ || input.peaks.yaw_max > -1000.0 || input.peaks.pitch_max > -1000.0 ||
+            input.lean.valid != anchor_.lean.valid) {
+            return false;
+        }
+        const LookVector& look = input.look;
+        return std::abs(look.yaw_sin - anchor_.look.yaw_sin) < kStationaryEpsilon &&
+               std::abs(look.yaw_cos - anchor_.look.yaw_cos) < kStationaryEpsilon &&
+               std::abs(look.pitch_sin - anchor_.look.pitch_sin) < kStationaryEpsilon &&
+               std::abs(input.lean.lateral_m - anchor_.lean.lateral_m) < kStationaryEpsilon &&
+               std::abs(input.lean.vertical_m - anchor_.lean.vertical_m) < kStationaryEpsilon;
+    }
+
+    // Per-table copies the hot loops read: the threshold index, and which alarms keep
+    // coverage or dwell. Dwell rings start empty: the head has to hold a direction anew.
+    void adopt_table_layout() {
+        anchor_valid_ = false; // Cached tests were against the old thresholds
+        index_.assign(table_.alarms);
+        inside_.assign(table_.alarms.size(), 0); // Every look starts over
+        hits_.assign(table_.alarms.size(), 0);
+        for (std::vector<uint64_t>* mask : { &touched_, &inside_mask_ }) mask->assign(index_.words, 0);
+        for (int d = 0; d < DIR_COVERAGE; ++d) {
+            enter_[d].assign(index_.words, 0);
+            stay_[d].assign(index_.words, 0);
+        }
+        kernel_cycles_.alarm.assign(table_.alarms.size(), 0);
+        coverage_alarms_.clear();
+        dwell_alarms_.clear();
+        dwell_rings_.clear();
+        for (size_t i = 0; i < table_.alarms.size(); ++i) {
+            const CompiledAlarm& alarm = table_.alarms[i];
+            if (alarm.coverage_needed > 0) coverage_alarms_.push_back(static_cast<uint32_t>(i));
+            if (alarm.min_dwell_us > 0) {
+                dwell_alarms_.push_back(static_cast<uint32_t>(i));
+                dwell_rings_.emplace_back(alarm.min_dwell_us, peak_rate_hz_);
+            }
+        }
+    }
+
+    // Move engine time on by dt_us (fixed-step mode: by the whole steps it completes,
+    // firing the timers due at every step but the last, which the caller runs)
+    void advance_time(int64_t dt_us) {
+        if (fixed_step_us_ <= 0) {
+            engine_us_ += dt_us;
+            return;
+        }
+        step_carry_us_ += dt_us;
+        int64_t steps = step_carry_us_ / fixed_step_us_;
+        step_carry_us_ -= steps * fixed_step_us_;
+        for (int64_t k = 1; k < steps; ++k) {
+            engine_us_ += fixed_step_us_;
+            run_due_timers();
+        }
+        if (steps > 0) engine_us_ += fixed_step_us_;
+    }
+
+    void emit(LookoutEvent::Type type, size_t i, int64_t value = 0) {
+        LookoutEvent event;
+        event.type = type;
+        event.index = static_cast<uint32_t>(i);
+        event.alarm = i < table_.alarms.size() ? table_.alarms[i].id : 0;
+        event.value = value;
+        events_.push_back(event);
+    }
+
+    void emit_warning(LookoutEvent::Type type, size_t i, int64_t value) {
+        emit(type, i, value);
+        events_.back().volume = ramp_target_volume(i);
+    }
+
+    int ramp_target_volume(size_t i) const {
+        const CompiledAlarm& alarm = table_.alarms[i];
+        if (alarm.volume_ramp_ms > 0 && alarm.end_volume != alarm.start_volume) {
+            double ramp_progress = (std::min)(1.0, (engine_us_ - states_[i].warning_start_us) / static_cast<double>(ms_to_us(alarm.volume_ramp_ms)));
+            return static_cast<int>(alarm.start_volume + ramp_progress * (alarm.end_volume - alarm.start_volume));
+        }
+        return alarm.end_volume;
+    }
+
+    void schedule_max_time(size_t i, int64_t when_us) {
+        states_[i].max_time_timer = timers_.schedule(when_us, TIMER_MAX_TIME, static_cast<uint32_t>(i));
+    }
+
+    void start_fresh(size_t i) {
+        states_[i].no_look_start_us = engine_us_;
+        schedule_max_time(i, engine_us_ + table_.alarms[i].max_time_us);
+    }
+
+    // Timers, and the warning if there is one, for a state taken over as it was (a
+    // settings reload, a restored snapshot)
+    void resume_state(size_t i) {
+        AlarmState& state = states_[i];
+        const CompiledAlarm& alarm = table_.alarms[i];
+        const uint32_t index = static_cast<uint32_t>(i);
+        if (state.alarm_silence_until_us > engine_us_) {
+            state.silence_timer = timers_.schedule(state.alarm_silence_until_us, TIMER_SILENCE_END, index);
+        }
+        if (!state.warning_triggered) {
+            // Already overdue under a shorter max_time: fires on the next advance
+            state.max_time_timer = timers_.schedule(state.no_look_start_us + alarm.max_time_us, TIMER_MAX_TIME, index);
+            return;
+        }
+        state.repeat_timer = timers_.schedule(state.last_repeat_us + alarm.repeat_interval_us, TIMER_REPEAT, index);
+        emit_warning(LookoutEvent::WARNING_RESUME, i, (engine_us_ - state.warning_start_us) / 1000);
+        if (engine_us_ < state.alarm_silence_until_us) emit(LookoutEvent::MUTE, i);
+    }
+
+    void cancel_timers(AlarmState& state) {
+        timers_.cancel(state.max_time_timer);
+        timers_.cancel(state.silence_timer);
+        timers_.cancel(state.repeat_timer);
+    }
+
+    // Stop the warning and restart the no-look period
+    void restart_no_look(size_t i) {
+        AlarmState& state = states_[i];
+        state.warning_triggered = false;
+        state.no_look_start_us = engine_us_;
+        state.repeat_pending = false;
+        timers_.cancel(state.repeat_timer);
+        timers_.reschedule(state.max_time_timer, engine_us_ + table_.alarms[i].max_time_us,
+                           TIMER_MAX_TIME, static_cast<uint32_t>(i));
+    }
+
+    // Full reset after a successful lookout or the end of a flight
+    void reset_alarm(size_t i) {
+        AlarmState& state = states_[i];
+        restart_no_look(i);
+        state.warning_start_us = 0;
+        seen_[i] = 0;
+        coverage_[i] = CoverageMap{};
+        state.left_ever_us = state.right_ever_us = -1;
+        state.silence_message_printed_this_period = false;
+        state.alarm_silence_until_us = 0;
+        timers_.cancel(state.silence_timer);
+        emit(LookoutEvent::STOP, i);
+    }
+
+    void start_warning(size_t i) {
+        AlarmState& state = states_[i];
+        const CompiledAlarm& alarm = table_.alarms[i];
+        state.silence_message_printed_this_period = false;
+        state.warning_triggered = true;
+        state.warning_start_us = engine_us_;
+        state.last_repeat_us = engine_us_;
+        state.repeat_pending = false;
+        seen_[i] &= static_cast<uint8_t>(~LOOK_ALL_ANGLES); // Leans stay counted
+        coverage_[i] = CoverageMap{};
+        state.left_ever_us = state.right_ever_us = -1;
+
+        // How late the pose that decided this warning was, against the alarm's deadline
+        int64_t due_us = (std::max)(state.no_look_start_us + alarm.max_time_us, state.alarm_silence_until_us);
+        emit_warning(LookoutEvent::WARNING_START, i, engine_us_ - due_us);
+        timers_.reschedule(state.repeat_timer, engine_us_ + alarm.repeat_interval_us, TIMER_REPEAT, static_cast<uint32_t>(i));
+    }
+
+    void repeat_warning(size_t i) {
+        AlarmState& state = states_[i];
+        state.repeat_pending = false;
+        state.last_repeat_us = engine_us_;
+        emit_warning(LookoutEvent::WARNING_REPEAT, i, (engine_us_ - state.warning_start_us) / 1000);
+        timers_.reschedule(state.repeat_timer, engine_us_ + table_.alarms[i].repeat_interval_us,
+                           TIMER_REPEAT, static_cast<uint32_t>(i));
+    }
+
+    void run_due_timers() {
+        timers_.advance(engine_us_, [this](uint32_t kind, uint32_t index) { on_timer(kind, index); });
+    }
+
+    void on_timer(uint32_t kind, uint32_t index) {
+        if (kind == TIMER_CENTER_HOLD) {
+            std::fill(seen_.begin(), seen_.end(), uint8_t(0));
+            std::fill(coverage_.begin(), coverage_.end(), CoverageMap{});
+            for (AlarmState& state : states_) state.left_ever_us = state.right_ever_us = -1;
+            center_reset_active_ = true;
+            emit(LookoutEvent::CENTER_RESET, 0);
+            return;
+        }
+
+        size_t i = index;
+        AlarmState& state = states_[i];
+        const CompiledAlarm& alarm = table_.alarms[i];
+        bool silenced = engine_us_ < state.alarm_silence_until_us;
+        switch (kind) {
+        case TIMER_MAX_TIME:
+            if (state.warning_triggered) break;
+            if (silenced) {
+                // TIMER_SILENCE_END starts the warning once the silence window is over
+                if (!state.silence_message_printed_this_period) {
+                    emit(LookoutEvent::DUE_WHILE_SILENCED, i);
+                    state.silence_message_printed_this_period = true;
+                }
+                break;
+            }
+            start_warning(i);
+            break;
+        case TIMER_SILENCE_END:
+            if (!state.warning_triggered) {
+                if (engine_us_ - state.no_look_start_us >= alarm.max_time_us) {
+                    start_warning(i);
+                }
+                break;
+            }
+            emit(LookoutEvent::UNMUTE, i, state.silence_message_printed_this_period ? 1 : 0);
+            state.silence_message_printed_this_period = false;
+            if (state.repeat_pending) {
+                repeat_warning(i);
+            }
+            break;
+        case TIMER_REPEAT:
+            if (!state.warning_triggered) break;
+            if (silenced) {
+                state.repeat_pending = true; // Replayed when the silence window ends
+                break;
+            }
+            repeat_warning(i);
+            break;
+        }
+    }
+
+    // enter_[d] = the alarms that need direction d and see past its entry bound in this
+    // pose (or its interpolated peaks), stay_[d] those past its exit bound. A binary
+    // search per bound in the threshold index, then a few word ORs per direction, so
+    // the cost grows with the log of the table and its word count rather than with
+    // every alarm's tests. Both only depend on the pose, so a stationary one keeps them.
+    void detect_looks(const LookInput& input) {
+        const ThresholdIndex& x = index_;
+        const size_t n = x.half_cos.size(), words = x.words;
+        const double yaw_sin = input.look.yaw_sin, yaw_cos = input.look.yaw_cos, pitch_sin = input.look.pitch_sin;
+        const double yaw_max = input.peaks.yaw_max, yaw_min = input.peaks.yaw_min;
+        const double pitch_max = input.peaks.pitch_max, pitch_min = input.peaks.pitch_min;
+        const bool lean_valid = input.lean.valid;
+        const double lateral_m = input.lean.lateral_m, vertical_abs_m = std::abs(input.lean.vertical_m);
+        const bool yaw_left_half = yaw_sin >= 0.0;
+        const double abs_yaw_sin = std::abs(yaw_sin);
+
+        // The alarms whose half angle the yaw is past, on whichever side it is: same
+        // test as LookThresholds::looking_left() and looking_right()
+        auto horizontal = [&](const SortedBounds& bounds, size_t sorted, const std::vector<double>& cos,
+                              const std::vector<double>& sin, std::vector<uint64_t>& out) {
+            auto past = [&](uint32_t i) { return abs_yaw_sin * cos[i] - yaw_cos * sin[i] > 0.0; };
+            size_t first = 0, last = bounds.passing(sorted, past);
+            if (abs_yaw_sin == 0.0 && yaw_cos < 0.0) {
+                // Straight behind is past every half angle but 0 (the one exception to the order)
+                first = bounds.passing(sorted, [&](uint32_t i) { return !(sin[i] > 0.0); });
+                last = sorted;
+            }
+            const uint64_t *to = bounds.mask(last), *from = bounds.mask(first);
+            out.resize(words);
+            for (size_t w = 0; w < words; ++w) out[w] = to[w] & ~from[w];
+            for (size_t k = sorted; k < n; ++k) {
+                const uint32_t i = bounds.position(k);
+                if (past(i)) out[i / 64] |= 1ULL << (i % 64);
+            }
+        };
+        horizontal(x.half, x.half_sorted, x.half_cos, x.half_sin, crossed_);
+        horizontal(x.exit_half, x.exit_half_sorted, x.exit_half_cos, x.exit_half_sin, exit_crossed_);
+
+        // Each direction is the union of a pose test and a peak test, over the alarms
+        // that need it. mask(0) of any bound is empty.
+        const uint64_t* none = x.half_deg.mask(0);
+        auto merge = [&](std::vector<uint64_t>& out, LookoutDirection d, const uint64_t* a, const uint64_t* b) {
+            const uint64_t* required = x.required[d].data();
+            out.resize(words);
+            for (size_t w = 0; w < words; ++w) out[w] = (a[w] | b[w]) & required[w];
+        };
+        const uint64_t* crossed = crossed_.data();
+        merge(enter_[DIR_LEFT], DIR_LEFT, yaw_left_half ? crossed : none, x.half_deg.mask(x.half_deg.below(yaw_max)));
+        merge(enter_[DIR_RIGHT], DIR_RIGHT, yaw_left_half ? none : crossed, x.half_deg.mask(x.half_deg.below(-yaw_min)));
+        merge(enter_[DIR_UP], DIR_UP, x.up_sin.mask(x.up_sin.below(pitch_sin)), x.up_deg.mask(x.up_deg.below(pitch_max)));
+        merge(enter_[DIR_DOWN], DIR_DOWN, x.down_sin.mask(x.down_sin.below(-pitch_sin)),
+              x.down_deg.mask(x.down_deg.below(-pitch_min)));
+        merge(enter_[DIR_LEAN_LEFT], DIR_LEAN_LEFT, lean_valid ? x.lean_lateral.mask(x.lean_lateral.at_or_below(lateral_m)) : none, none);
+        merge(enter_[DIR_LEAN_RIGHT], DIR_LEAN_RIGHT, lean_valid ? x.lean_lateral.mask(x.lean_lateral.at_or_below(-lateral_m)) : none, none);
+        merge(enter_[DIR_LEAN_VERTICAL], DIR_LEAN_VERTICAL,
+              lean_valid ? x.lean_vertical.mask(x.lean_vertical.at_or_below(vertical_abs_m)) : none, none);
+
+        // Peaks are a single instant, so they can start a look but don't prolong one
+        const uint64_t* exit_crossed = exit_crossed_.data();
+        merge(stay_[DIR_LEFT], DIR_LEFT, yaw_left_half ? exit_crossed : none, none);
+        merge(stay_[DIR_RIGHT], DIR_RIGHT, yaw_left_half ? none : exit_crossed, none);
+        merge(stay_[DIR_UP], DIR_UP, x.exit_up_sin.mask(x.exit_up_sin.below(pitch_sin)), none);
+        merge(stay_[DIR_DOWN], DIR_DOWN, x.exit_down_sin.mask(x.exit_down_sin.below(-pitch_sin)), none);
+        merge(stay_[DIR_LEAN_LEFT], DIR_LEAN_LEFT,
+              lean_valid ? x.exit_lean_lateral.mask(x.exit_lean_lateral.at_or_below(lateral_m)) : none, none);
+        merge(stay_[DIR_LEAN_RIGHT], DIR_LEAN_RIGHT,
+              lean_valid ? x.exit_lean_lateral.mask(x.exit_lean_lateral.at_or_below(-lateral_m)) : none, none);
+        merge(stay_[DIR_LEAN_VERTICAL], DIR_LEAN_VERTICAL,
+              lean_valid ? x.exit_lean_vertical.mask(x.exit_lean_vertical.at_or_below(vertical_abs_m)) : none, none);
+    }
+
+    // hits_[i] = the directions alarm i is looking in: entered in this pose, or entered
+    // earlier and not yet back past the exit bound. Head jitter at a threshold then
+    // makes one long look instead of a string of short ones: a direction cleared while
+    // its look goes on (a too-quick lookout) registers again once, not at every crossing.
+    // Only alarms entering a direction or already inside one (touched_) can have hits,
+    // so the rest of hits_ stays zero and isn't visited.
+    void apply_hysteresis() {
+        for (size_t w = 0; w < touched_.size(); ++w) {
+            for (uint64_t bits = touched_[w]; bits; bits &= bits - 1) hits_[w * 64 + lowest_bit(bits)] = 0;
+            uint64_t touched = inside_mask_[w];
+            for (int d = 0; d < DIR_COVERAGE; ++d) touched |= enter_[d][w];
+            uint64_t inside = 0;
+            for (uint64_t bits = touched; bits; bits &= bits - 1) {
+                const int b = lowest_bit(bits);
+                const size_t i = w * 64 + b;
+                unsigned enter = 0, stay = 0;
+                for (int d = 0; d < DIR_COVERAGE; ++d) {
+                    enter |= static_cast<unsigned>(enter_[d][w] >> b & 1) << d;
+                    stay |= static_cast<unsigned>(stay_[d][w] >> b & 1) << d;
+                }
+                hits_[i] = static_cast<uint8_t>(enter | (inside_[i] & stay));
+                inside_[i] = hits_[i];
+                if (hits_[i]) inside |= 1ULL << b;
+            }
+            touched_[w] = touched;
+            inside_mask_[w] = inside;
+        }
+    }
+
+    // Mark this pose's bin for every alarm with a coverage target; an alarm reaching its
+    // target counts DIR_COVERAGE as seen. The bin is worked out once per pose, and the
+    // popcount only runs when a bin is new to the alarm. A stationary pose reuses the
+    // anchor's bin.
+    void update_coverage(const LookVector& look, bool stationary) {
+        if (!stationary) {
+            const double yaw_deg = std::atan2(look.yaw_sin, look.yaw_cos) * (180.0 / 3.14159265358979323846);
+            const double pitch_deg = std::asin((std::max)(-1.0, (std::min)(1.0, look.pitch_sin))) * (180.0 / 3.14159265358979323846);
+            coverage_bin(yaw_deg, pitch_deg, anchor_row_, anchor_yaw_bit_);
+        }
+        const int row = anchor_row_;
+        const uint64_t yaw_bit = anchor_yaw_bit_;
+        for (uint32_t i : coverage_alarms_) {
+            uint64_t& word = coverage_[i][row];
+            if (word & yaw_bit) continue;
+            word |= yaw_bit;
+            const CompiledAlarm& alarm = table_.alarms[i];
+            if (coverage_count(coverage_[i], alarm.coverage_region) >= alarm.coverage_needed) {
+                hits_[i] |= direction_bit(DIR_COVERAGE);
+                touched_[i / 64] |= 1ULL << (i % 64);
+            }
+        }
+    }
+
+    // Bookkeeping for the directions alarm i saw for the first time: L/R times, a
+    // completed lookout, and the silence window a new L/R look opens
+    void register_looks(size_t i, uint8_t fresh, int64_t now_us) {
+        AlarmState& state = states_[i];
+        const CompiledAlarm& alarm = table_.alarms[i];
+        seen_[i] |= fresh;
+        if (fresh & direction_bit(DIR_LEFT)) state.left_ever_us = now_us;
+        if (fresh & direction_bit(DIR_RIGHT)) state.right_ever_us = now_us;
+        for (uint8_t d = 0; d < DIR_COUNT; ++d) {
+            if (fresh & direction_bit(static_cast<LookoutDirection>(d))) emit(LookoutEvent::DIRECTION_SEEN, i, d);
+        }
+
+        if ((seen_[i] & alarm.required) == alarm.required) {
+            int64_t lr_time_diff_us = std::llabs(state.left_ever_us - state.right_ever_us);
+            if (lr_time_diff_us >= alarm.min_lookout_us) {
+                reset_alarm(i);
+                emit(LookoutEvent::LOOKOUT_SUCCESS, i, lr_time_diff_us);
+                // A lookout wide enough for this alarm is wide enough for every narrower one
+                for (uint32_t j = 0; j < alarm.dominated_end; ++j) {
+                    reset_alarm(j);
+                    emit(LookoutEvent::NARROWER_RESET, j, alarm.id);
+                }
+                return;
+            }
+            emit(LookoutEvent::LOOKOUT_TOO_QUICK, i, lr_time_diff_us);
+            seen_[i] &= static_cast<uint8_t>(~LOOK_LEFT_RIGHT);
+            state.left_ever_us = state.right_ever_us = -1;
+        }
+
+        if (fresh & LOOK_LEFT_RIGHT) {
+            state.alarm_silence_until_us = engine_us_ + alarm.silence_after_look_us;
+            timers_.reschedule(state.silence_timer, state.alarm_silence_until_us, TIMER_SILENCE_END, static_cast<uint32_t>(i));
+            emit(LookoutEvent::LOOK_SILENCED, i, alarm.silence_after_look_us);
+            if (state.warning_triggered) {
+                emit(LookoutEvent::MUTE, i, state.silence_message_printed_this_period ? 0 : 1);
+                state.silence_message_printed_this_period = true;
+            }
+        }
+    }
+
+    AlarmTable table_;
+    ThresholdIndex index_;
+    std::vector<uint8_t> seen_;  // LookoutDirection bits per alarm
+    std::vector<uint8_t> hits_;  // Scratch for step(): required directions seen in this pose, zero outside touched_
+    std::vector<uint64_t> touched_; // Alarms that may have hits in this step (bitmask)
+    std::array<std::vector<uint64_t>, DIR_COVERAGE> enter_, stay_; // detect_looks() results for the anchor pose, per direction
+    std::vector<uint64_t> crossed_, exit_crossed_; // detect_looks() scratch: past the half angle, either side
+    std::vector<uint8_t> inside_;       // Directions whose look is in progress (hysteresis state)
+    std::vector<uint64_t> inside_mask_; // Alarms that may have a look in progress (a superset of inside_ nonzero)
+    LookInput anchor_;
+    bool anchor_valid_ = false, anchor_centered_ = false;
+    int anchor_row_ = 0;
+    uint64_t anchor_yaw_bit_ = 0;
+    uint64_t stationary_steps_ = 0;
+    KernelCycles kernel_cycles_;
+    std::vector<CoverageMap> coverage_;      // Bins visited this lookout, per alarm
+    std::vector<uint32_t> coverage_alarms_;  // Positions with a coverage target
+    std::vector<uint32_t> dwell_alarms_;     // Positions with a dwell requirement
+    std::vector<DwellRing> dwell_rings_;     // One per dwell_alarms_ entry
+    double peak_rate_hz_ = 0.0;              // set_peak_sample_rate(); 0 sizes the rings at their minimum
+    std::vector<AlarmState> states_;
+    std::vector<LookoutEvent> events_;
+    TimerWheel timers_;
+    TimerWheel::TimerId center_hold_timer_;
+    int64_t engine_us_ = 0;
+    int64_t fixed_step_us_ = 0, step_carry_us_ = 0;
+    double center_yaw_cos_ = 1.0, center_pitch_sin_ = 0.0;
+    int64_t center_hold_us_ = 0;
+    bool center_reset_active_ = false;
+};
@@ -0,0 +1,127 @@
+// lookout_history.cpp
+// Queries the flight history lookout.exe keeps (lookout_history.hpp): lists the
+// matching flights and their scan statistics, newest last, with totals such as
+// warnings per hour over them. The whole history is read into memory and the date
+// range found by binary search, so a query over thousands of flights takes a
+// millisecond or two.
+//
+//   lookout_history [flight_history.qlfh] [--pilot NAME] [--profile NAME]
+//                   [--since YYYY-MM-DD] [--until YYYY-MM-DD] [--last N] [--events]
+//
+// --last keeps the newest N matching flights; --events also lists each one's alarm
+// events. Names match exactly, as settings.json gave them.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "lookout_history.hpp"
+
+// Local midnight starting YYYY-MM-DD, or -1 if it isn't a date
+int64_t parse_date(const std::string& text) {
+    std::tm date = {};
+    if (std::sscanf(text.c_str(), "%d-%d-%d", &date.tm_year, &date.tm_mon, &date.tm_mday) != 3) return -1;
+    date.tm_year -= 1900;
+    date.tm_mon -= 1;
+    date.tm_isdst = -1;
+    const std::time_t t = std::mktime(&date);
+    return t == static_cast<std::time_t>(-1) ? -1 : static_cast<int64_t>(t);
+}
+
+std::string format_start(int64_t unix_s) {
+    const std::time_t t = static_cast<std::time_t>(unix_s);
+    char text[32];
+    std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M", std::localtime(&t));
+    return text;
+}
+
+int main(int argc, char** argv) {
+    std::string path = "flight_history.qlfh", pilot, profile;
+    int64_t since = INT64_MIN, until = INT64_MAX;
+    size_t last = 0;
+    bool events = false, usage = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--pilot" && has_value) {
+            pilot = argv[++i];
+        } else if (arg == "--profile" && has_value) {
+            profile = argv[++i];
+        } else if (arg == "--since" && has_value) {
+            since = parse_date(argv[++i]);
+            usage |= since < 0;
+        } else if (arg == "--until" && has_value) {
+            until = parse_date(argv[++i]);
+            usage |= until < 0;
+            if (until >= 0) until += 86400; // Through the end of that day
+        } else if (arg == "--last" && has_value) {
+            const long n = std::atol(argv[++i]);
+            usage |= n <= 0;
+            last = n > 0 ? static_cast<size_t>(n) : 0;
+        } else if (arg == "--events") {
+            events = true;
+        } else if (arg.compare(0, 2, "--") == 0) {
+            usage = true;
+        } else {
+            path = arg;
+        }
+    }
+    if (usage) {
+        std::cerr << "Usage: lookout_history [flight_history.qlfh] [--pilot NAME] [--profile NAME]\n"
+                     "                       [--since YYYY-MM-DD] [--until YYYY-MM-DD] [--last N] [--events]" << std::endl;
+        return 2;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    FlightHistoryReader history;
+    if (!history.open(path)) {
+        std::cerr << "[ERROR] " << path << " is not a readable flight history" << std::endl;
+        return 1;
+    }
+    const std::vector<FlightHistoryRecord>& records = history.records();
+    const size_t begin = since == INT64_MIN ? 0 : history.lower_bound(since);
+    const size_t end = until == INT64_MAX ? records.size() : history.lower_bound(until);
+    std::vector<size_t> matches;
+    for (size_t i = end; i > begin && (last == 0 || matches.size() < last); --i) {
+        const FlightHistoryRecord& r = records[i - 1];
+        if (!pilot.empty() && flight_history_name(r.pilot, sizeof(r.pilot)) != pilot) continue;
+        if (!profile.empty() && flight_history_name(r.profile, sizeof(r.profile)) != profile) continue;
+        matches.push_back(i - 1);
+    }
+    const double query_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%-16s %-14s %-12s %-8s %7s %5s %5s %7s %9s %9s\n", "start", "pilot", "profile", "sim", "min", "warn",
+                "look", "warn/h", "scan (s)", "resp (s)");
+    uint64_t warnings = 0, lookouts = 0;
+    double flight_s = 0.0, interval_sum_s = 0.0;
+    std::vector<FlightHistoryEvent> flight_events;
+    for (auto it = matches.rbegin(); it != matches.rend(); ++it) {
+        const FlightHistoryRecord& r = records[*it];
+        const double hours = r.flight_s / 3600.0;
+        std::printf("%-16s %-14s %-12s %-8s %7.1f %5u %5u %7.1f %9.1f %9.1f\n", format_start(r.start_unix_s).c_str(),
+                    flight_history_name(r.pilot, sizeof(r.pilot)).substr(0, 14).c_str(),
+                    flight_history_name(r.profile, sizeof(r.profile)).substr(0, 12).c_str(),
+                    flight_history_name(r.sim, sizeof(r.sim)).substr(0, 8).c_str(), r.flight_s / 60.0, r.warnings, r.lookouts,
+                    hours > 0.0 ? r.warnings / hours : 0.0, r.mean_interval_s, r.mean_response_s);
+        warnings += r.warnings;
+        lookouts += r.lookouts;
+        flight_s += r.flight_s;
+        interval_sum_s += static_cast<double>(r.mean_interval_s) * r.lookouts;
+        if (events && history.read_events(r, flight_events)) {
+            for (const FlightHistoryEvent& e : flight_events) {
+                std::printf("    %10.1f  %-8s alarm %u", e.t_ms / 1000.0, e.type == FLIGHT_HISTORY_WARNING ? "warning" : "lookout", e.alarm);
+                if (e.type == FLIGHT_HISTORY_LOOKOUT) std::printf("  after %.1f s", e.value_ms / 1000.0);
+                std::printf("\n");
+            }
+        }
+    }
+    std::printf("\n%zu of %zu flight(s), %.1f h: %llu warning(s) (%.1f/h), %llu lookout(s), mean scan interval %.1f s\n",
+                matches.size(), records.size(), flight_s / 3600.0, static_cast<unsigned long long>(warnings),
+                flight_s > 0.0 ? warnings / (flight_s / 3600.0) : 0.0, static_cast<unsigned long long>(lookouts),
+                lookouts ? interval_sum_s / lookouts : 0.0);
+    std::printf("Query %.2f ms\n", query_ms);
+    return 0;
+}
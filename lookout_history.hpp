@@ -0,0 +1,115 @@
+// lookout_history.hpp
+// On-disk layout of the flight history ("flight_history" in settings.json): a summary
+// of every flight lookout.exe saw, with its alarm events, kept across sessions so a
+// pilot's scanning can be followed over hundreds of flights. Two append-only files of
+// fixed-size little-endian records:
+//
+//   flight_history.qlfh          FlightHistoryHeader | FlightHistoryRecord ...
+//   flight_history.qlfh.events   FlightHistoryHeader | FlightHistoryEvent ...
+//
+// A flight's events are appended first and its record last, so the record is what
+// commits it: a record whose events were cut short by a crash is never written, and
+// events with no record are ignored. Records are in flight order, which makes the start
+// time an index (binary search); pilot and profile are filtered over the records, a
+// few hundred kilobytes for thousands of flights. lookout_history.cpp queries it.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+constexpr uint32_t FLIGHT_HISTORY_MAGIC = 0x48464C51;        // "QLFH"
+constexpr uint32_t FLIGHT_HISTORY_EVENTS_MAGIC = 0x45464C51; // "QLFE"
+constexpr uint16_t FLIGHT_HISTORY_VERSION = 1;
+
+struct FlightHistoryHeader {
+    uint32_t magic;               // FLIGHT_HISTORY_MAGIC or FLIGHT_HISTORY_EVENTS_MAGIC
+    uint16_t version;             // FLIGHT_HISTORY_VERSION
+    uint16_t record_size;         // sizeof(FlightHistoryRecord) or sizeof(FlightHistoryEvent)
+    uint8_t reserved[56];
+};
+static_assert(sizeof(FlightHistoryHeader) == 64, "FlightHistoryHeader layout is part of the version");
+
+struct FlightHistoryRecord {
+    int64_t start_unix_s;         // Wall clock at flight start
+    uint32_t flight_s;            // Engine time in the flight, so pauses don't count
+    uint32_t event_count;
+    uint64_t events_offset;       // Index of the flight's first event in the events file
+    char pilot[32];               // NUL-terminated, truncated to fit
+    char profile[32];             // Alarm profile at flight start
+    char sim[16];                 // Sim profile the flight was detected in
+    uint32_t warnings;
+    uint32_t lookouts;
+    float mean_interval_s;        // Between lookouts, over all alarms
+    float max_interval_s;
+    float mean_response_s;        // From a warning to the lookout that ended it; 0 if none
+    uint32_t alarm_count;         // Alarms in the profile at flight start
+};
+static_assert(sizeof(FlightHistoryRecord) == 128, "FlightHistoryRecord layout is part of the version");
+
+enum FlightHistoryEventType : uint8_t {
+    FLIGHT_HISTORY_WARNING = 1,   // value_ms: 0
+    FLIGHT_HISTORY_LOOKOUT,       // value_ms: time since the alarm's previous lookout (or the flight start)
+};
+
+struct FlightHistoryEvent {
+    uint32_t t_ms;                // Engine time since the flight start
+    uint16_t alarm;               // Alarm id
+    uint8_t type;                 // FlightHistoryEventType
+    uint8_t reserved;
+    uint32_t value_ms;
+    uint32_t reserved2;
+};
+static_assert(sizeof(FlightHistoryEvent) == 16, "FlightHistoryEvent layout is part of the version");
+
+// Copies a name into a fixed field, always terminated
+inline void flight_history_set_name(char* field, size_t size, const std::string& name) {
+    std::memset(field, 0, size);
+    std::memcpy(field, name.data(), (std::min)(name.size(), size - 1));
+}
+
+inline std::string flight_history_name(const char* field, size_t size) {
+    return std::string(field, strnlen(field, size));
+}
+
+// Whole history read into memory (it's small), records checked against the header
+class FlightHistoryReader {
+public:
+    bool open(const std::string& path) {
+        path_ = path;
+        std::ifstream f(path, std::ios::binary);
+        FlightHistoryHeader header;
+        if (!f.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != FLIGHT_HISTORY_MAGIC ||
+            header.version != FLIGHT_HISTORY_VERSION || header.record_size != sizeof(FlightHistoryRecord)) {
+            return false;
+        }
+        FlightHistoryRecord record;
+        while (f.read(reinterpret_cast<char*>(&record), sizeof(record))) records_.push_back(record);
+        return true;
+    }
+
+    const std::vector<FlightHistoryRecord>& records() const { return records_; }
+
+    // First record starting at or after unix_s
+    size_t lower_bound(int64_t unix_s) const {
+        return std::lower_bound(records_.begin(), records_.end(), unix_s,
+                                [](const FlightHistoryRecord& r, int64_t t) { return r.start_unix_s < t; }) - records_.begin();
+    }
+
+    // One flight's events, read from the events file
+    bool read_events(const FlightHistoryRecord& record, std::vector<FlightHistoryEvent>& events) const {
+        events.resize(record.event_count);
+        if (events.empty()) return true;
+        std::ifstream f(path_ + ".events", std::ios::binary);
+        f.seekg(static_cast<std::streamoff>(sizeof(FlightHistoryHeader) + record.events_offset * sizeof(FlightHistoryEvent)));
+        return static_cast<bool>(f.read(reinterpret_cast<char*>(events.data()), events.size() * sizeof(FlightHistoryEvent)));
+    }
+
+private:
+    std::string path_;
+    std::vector<FlightHistoryRecord> records_;
+};
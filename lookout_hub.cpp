@@ -0,0 +1,639 @@
+// lookout_hub.cpp
+// Instructor station for group sessions: receives the scan state of every lookout.exe
+// in the room (layouts in lookout_telemetry.hpp), keeps each station's latest state and
+// rolling statistics of the last ten minutes, and serves them as one JSON document over
+// HTTP (http://<hub>:55302/) besides printing a line per station to the console. One
+// thread waits on every socket with an sf::SocketSelector, so dozens of stations cost
+// one wake-up per datagram.
+//
+//   lookout_hub [--port UDP_PORT] [--http TCP_PORT] [--print SECONDS] [--discovery UDP_PORT]
+//               [--push SETTINGS_JSON]
+//
+// Stations with "fleet" enabled find the hub by themselves: it broadcasts an
+// announcement to the discovery port (default 55300, 0 for none) every 2 s, and they
+// answer with batched alarm events and per-minute statistics. Stations can also send
+// the full-rate udp_stream to --port (default 55301). Stations are told apart by their
+// address and source port; one that sends nothing for 5 s (70 s for fleet stations,
+// which report once a minute) is shown offline, and forgotten after an hour.
+// With --push, the hub keeps every fleet station that has fleet.accept_settings on the
+// given settings.json: each online station whose config hash differs is sent the
+// snapshot every 5 s until its hash matches, and a station that rejects a version (or
+// doesn't accept pushes) isn't sent it again. The file is reread every 2 s; an edit
+// becomes the next version, hot-reloaded by every station.
+
+#include <SFML/Network.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+#include "json.hpp"
+#include "lookout_telemetry.hpp"
+
+int64_t hub_now_us() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Counts of one minute of a station's stream
+struct MinuteStats {
+    int64_t minute = -1;            // hub_now_us() / 60 s; -1 while unused
+    uint32_t datagrams = 0;
+    uint32_t lost = 0;              // Sequence gaps
+    uint32_t samples = 0;
+    uint32_t hmd_ok_samples = 0;
+    uint32_t warning_samples = 0;   // With at least one alarm warning
+    uint32_t warnings = 0;          // Warnings started
+    uint32_t lookouts = 0;          // No-look timers restarted
+    double scan_interval_s = 0.0;   // Sum of the no-look times those lookouts ended
+};
+
+// Everything the hub knows about one lookout.exe
+struct Station {
+    static constexpr size_t kMinutes = 10;
+
+    std::string name;               // "address:port"
+    std::string label;              // Name the station reported (fleet), else empty
+    bool fleet = false;             // Reports with the fleet protocol, not the stream
+    uint32_t sender_id = 0;
+    std::optional<sf::IpAddress> address; // Where pushed settings go
+    unsigned short port = 0;
+    uint32_t config_version = 0, config_hash = 0; // As the station last reported
+    uint32_t rejected_version = 0;  // Snapshot the station refused; not resent
+    int64_t next_push_us = 0;
+    int64_t first_us = 0, last_us = 0;
+    uint32_t next_sequence = 0;
+    uint64_t datagrams = 0, lost = 0;
+    LookoutStreamHeader header = {};
+    LookoutStreamSample sample = {}; // Newest
+    std::vector<LookoutStreamAlarm> alarms;
+    std::array<MinuteStats, kMinutes> minutes;
+    std::deque<LookoutFleetEvent> events; // Newest last, fleet stations only
+
+    MinuteStats& minute(int64_t now_us) {
+        const int64_t m = now_us / 60000000;
+        MinuteStats& slot = minutes[static_cast<size_t>(m % kMinutes)];
+        if (slot.minute != m) {
+            slot = MinuteStats();
+            slot.minute = m;
+        }
+        return slot;
+    }
+
+    // Sum of the minutes still inside the window
+    MinuteStats window(int64_t now_us) const {
+        const int64_t m = now_us / 60000000;
+        MinuteStats total;
+        for (const MinuteStats& slot : minutes) {
+            if (slot.minute < 0 || m - slot.minute >= static_cast<int64_t>(kMinutes)) continue;
+            total.datagrams += slot.datagrams;
+            total.lost += slot.lost;
+            total.samples += slot.samples;
+            total.hmd_ok_samples += slot.hmd_ok_samples;
+            total.warning_samples += slot.warning_samples;
+            total.warnings += slot.warnings;
+            total.lookouts += slot.lookouts;
+            total.scan_interval_s += slot.scan_interval_s;
+        }
+        return total;
+    }
+};
+
+// False if the datagram isn't a stream datagram of a version this hub reads
+bool parse_stream_datagram(const uint8_t* data, size_t size, LookoutStreamHeader& header,
+                           std::vector<LookoutStreamSample>& samples, std::vector<LookoutStreamAlarm>& alarms) {
+    if (size < sizeof(header)) return false;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != LOOKOUT_STREAM_MAGIC || header.version != LOOKOUT_STREAM_VERSION) return false;
+    const size_t expected = sizeof(header) + header.sample_count * sizeof(LookoutStreamSample) +
+                            header.alarm_count * sizeof(LookoutStreamAlarm);
+    if (size < expected) return false;
+    samples.resize(header.sample_count);
+    alarms.resize(header.alarm_count);
+    std::memcpy(samples.data(), data + sizeof(header), samples.size() * sizeof(LookoutStreamSample));
+    std::memcpy(alarms.data(), data + sizeof(header) + samples.size() * sizeof(LookoutStreamSample),
+                alarms.size() * sizeof(LookoutStreamAlarm));
+    return true;
+}
+
+class LookoutHub {
+public:
+    static constexpr int64_t kOfflineUs = 5000000;
+    static constexpr int64_t kFleetOfflineUs = 70000000;
+    static constexpr int64_t kAnnounceUs = 2000000;
+    static constexpr size_t kRecentEvents = 20;
+    static constexpr int64_t kForgetUs = 3600000000LL;
+    static constexpr int64_t kClientTimeoutUs = 5000000;
+    static constexpr int64_t kPushUs = 5000000;
+
+    // Before start(): keep fleet stations on this settings.json
+    bool push_settings(const std::string& path) {
+        push_path_ = path;
+        push_version_ = static_cast<uint32_t>(std::time(nullptr)); // A restarted hub still counts up
+        if (!reload_push_settings()) {
+            std::cerr << "[ERROR] Cannot read " << path << " to push to stations" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool start(unsigned short udp_port, unsigned short http_port, unsigned short discovery_port) {
+        udp_port_ = udp_port;
+        discovery_port_ = discovery_port;
+        if (stream_.bind(udp_port) != sf::Socket::Status::Done) {
+            std::cerr << "[ERROR] Cannot listen for the stream on UDP port " << udp_port << std::endl;
+            return false;
+        }
+        selector_.add(stream_);
+        if (http_port) {
+            if (listener_.listen(http_port) != sf::Socket::Status::Done) {
+                std::cerr << "[ERROR] Cannot serve the station view on TCP port " << http_port << std::endl;
+                return false;
+            }
+            selector_.add(listener_);
+        }
+        std::cout << "[INFO] Listening for lookout.exe streams on UDP port " << udp_port;
+        if (http_port) std::cout << ", station view on http://<this PC>:" << http_port << "/";
+        std::cout << std::endl;
+        if (discovery_port) std::cout << "[INFO] Announcing this hub on UDP port " << discovery_port << std::endl;
+        return true;
+    }
+
+    // Serves until the process is stopped; prints the station table every print_s
+    void run(double print_s) {
+        int64_t next_print_us = hub_now_us();
+        while (true) {
+            // Replies still going out are retried soon; they don't wake the selector
+            const bool sending = std::any_of(clients_.begin(), clients_.end(),
+                                             [](const HttpClient& client) { return !client.done && !client.response.empty(); });
+            if (selector_.wait(sf::milliseconds(sending ? 10 : 250))) {
+                const int64_t now_us = hub_now_us();
+                if (selector_.isReady(stream_)) receive_datagrams(now_us);
+                if (listener_.getLocalPort() && selector_.isReady(listener_)) accept_client(now_us);
+                for (HttpClient& client : clients_) {
+                    if (selector_.isReady(client.socket)) serve_client(client, now_us);
+                }
+            }
+            const int64_t now_us = hub_now_us();
+            for (HttpClient& client : clients_) {
+                if (!client.done && !client.response.empty()) send_response(client);
+            }
+            drop_finished_clients(now_us);
+            if (discovery_port_ && now_us >= next_announce_us_) {
+                next_announce_us_ = now_us + kAnnounceUs;
+                announce();
+                if (!push_path_.empty()) reload_push_settings();
+            }
+            if (!push_bytes_.empty()) push_to_stations(now_us);
+            if (print_s > 0.0 && now_us >= next_print_us) {
+                next_print_us = now_us + static_cast<int64_t>(print_s * 1e6);
+                forget_stale_stations(now_us);
+                print_stations(now_us);
+            }
+        }
+    }
+
+    nlohmann::json view(int64_t now_us) const {
+        nlohmann::json stations = nlohmann::json::array();
+        for (const auto& [name, station] : stations_) {
+            const MinuteStats w = station.window(now_us);
+            nlohmann::json alarms = nlohmann::json::array();
+            for (const LookoutStreamAlarm& a : station.alarms) {
+                alarms.push_back({ { "id", a.id }, { "seen", a.seen }, { "warning", (a.state & 1) != 0 },
+                                   { "silenced", (a.state & 2) != 0 }, { "no_look_s", a.no_look_ds / 10.0 },
+                                   { "until_due_s", a.until_due_ds / 10.0 } });
+            }
+            nlohmann::json events = nlohmann::json::array();
+            for (const LookoutFleetEvent& e : station.events) {
+                static const char* const kTypes[] = { "", "warning", "lookout", "flight_start", "flight_end" };
+                events.push_back({ { "t_s", e.t_ms / 1000.0 }, { "type", e.type <= FLEET_EVENT_FLIGHT_END ? kTypes[e.type] : "" },
+                                   { "alarm", e.alarm }, { "value_s", e.value_ms / 1000.0 } });
+            }
+            stations.push_back({
+                { "station", name },
+                { "name", station.label },
+                { "protocol", station.fleet ? "fleet" : "stream" },
+                { "recent_events", events },
+                { "config_version", station.config_version },
+                { "config_hash", hex(station.config_hash) },
+                { "config", config_state(station) },
+                { "online", online(station, now_us) },
+                { "last_seen_s", (now_us - station.last_us) / 1e6 },
+                { "connected_s", (station.last_us - station.first_us) / 1e6 },
+                { "hmd_ok", (station.header.flags & TELEMETRY_HMD_OK) != 0 },
+                { "flight_active", (station.header.flags & TELEMETRY_FLIGHT_ACTIVE) != 0 },
+                { "yaw_deg", station.sample.yaw_cdeg / 100.0 },
+                { "pitch_deg", station.sample.pitch_cdeg / 100.0 },
+                { "alarms", alarms },
+                { "datagrams", station.datagrams },
+                { "lost", station.lost },
+                { "last_10_min", {
+                    { "warnings", w.warnings },
+                    { "lookouts", w.lookouts },
+                    { "mean_scan_interval_s", w.lookouts ? w.scan_interval_s / w.lookouts : 0.0 },
+                    { "warning_share", w.samples ? static_cast<double>(w.warning_samples) / w.samples : 0.0 },
+                    { "hmd_ok_share", w.samples ? static_cast<double>(w.hmd_ok_samples) / w.samples : 0.0 },
+                    { "loss_share", w.datagrams + w.lost ? static_cast<double>(w.lost) / (w.datagrams + w.lost) : 0.0 },
+                } },
+            });
+        }
+        nlohmann::json view = { { "stations", stations } };
+        if (!push_bytes_.empty()) {
+            view["settings"] = { { "path", push_path_ }, { "version", push_version_ }, { "hash", hex(push_hash_) },
+                                 { "bytes", push_bytes_.size() } };
+        }
+        return view;
+    }
+
+private:
+    struct HttpClient {
+        sf::TcpSocket socket;
+        std::string request;
+        std::string response; // Still to send
+        size_t sent = 0;
+        int64_t connected_us = 0;
+        bool done = false;
+    };
+
+    static bool online(const Station& station, int64_t now_us) {
+        return now_us - station.last_us < (station.fleet ? kFleetOfflineUs : kOfflineUs);
+    }
+
+    static std::string hex(uint32_t value) {
+        char text[9];
+        std::snprintf(text, sizeof(text), "%08x", value);
+        return text;
+    }
+
+    // "current", "pending" (being pushed), "rejected", or "unmanaged" without --push
+    const char* config_state(const Station& station) const {
+        if (push_bytes_.empty() || !station.fleet) return "unmanaged";
+        if (station.config_hash == push_hash_) return "current";
+        return station.rejected_version == push_version_ ? "rejected" : "pending";
+    }
+
+    // A changed file becomes the next version; false if it can't be read
+    bool reload_push_settings() {
+        std::ifstream in(push_path_, std::ios::binary);
+        if (!in) return false;
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (bytes.empty() || bytes.size() > LOOKOUT_FLEET_MAX_SETTINGS_BYTES) {
+            std::cerr << "[WARNING] " << push_path_ << " is empty or over " << LOOKOUT_FLEET_MAX_SETTINGS_BYTES << " bytes; not pushing it" << std::endl;
+            return !push_bytes_.empty();
+        }
+        const uint32_t hash = lookout_fleet_hash(bytes.data(), bytes.size());
+        if (hash == push_hash_ && !push_bytes_.empty()) return true;
+        if (!push_bytes_.empty()) ++push_version_;
+        push_bytes_ = std::move(bytes);
+        push_hash_ = hash;
+        for (auto& [name, station] : stations_) station.next_push_us = 0;
+        std::cout << "[INFO] Pushing " << push_path_ << " as settings version " << push_version_ << " (hash " << hex(push_hash_)
+                  << ", " << push_bytes_.size() << " bytes)" << std::endl;
+        return true;
+    }
+
+    // The whole snapshot, a chunk per datagram, to each station not yet running it
+    void push_to_stations(int64_t now_us) {
+        for (auto& [name, station] : stations_) {
+            if (!station.fleet || !station.address || !online(station, now_us) || station.config_hash == push_hash_ ||
+                station.rejected_version == push_version_ || now_us < station.next_push_us) {
+                continue;
+            }
+            station.next_push_us = now_us + kPushUs;
+            LookoutFleetHeader header = {};
+            header.magic = LOOKOUT_FLEET_MAGIC;
+            header.version = LOOKOUT_FLEET_VERSION;
+            header.type = FLEET_SETTINGS;
+            header.count = 1;
+            std::array<uint8_t, sizeof(LookoutFleetHeader) + sizeof(LookoutFleetSettingsChunk) + LOOKOUT_FLEET_CHUNK_BYTES> datagram;
+            for (uint32_t offset = 0; offset < push_bytes_.size(); offset += LOOKOUT_FLEET_CHUNK_BYTES) {
+                LookoutFleetSettingsChunk chunk = {};
+                chunk.version = push_version_;
+                chunk.hash = push_hash_;
+                chunk.total_bytes = static_cast<uint32_t>(push_bytes_.size());
+                chunk.offset = offset;
+                chunk.bytes = static_cast<uint16_t>((std::min<size_t>)(LOOKOUT_FLEET_CHUNK_BYTES, push_bytes_.size() - offset));
+                header.sequence = push_sequence_++;
+                std::memcpy(datagram.data(), &header, sizeof(header));
+                std::memcpy(datagram.data() + sizeof(header), &chunk, sizeof(chunk));
+                std::memcpy(datagram.data() + sizeof(header) + sizeof(chunk), push_bytes_.data() + offset, chunk.bytes);
+                (void)stream_.send(datagram.data(), sizeof(header) + sizeof(chunk) + chunk.bytes, *station.address, station.port);
+            }
+        }
+    }
+
+    void announce() {
+        LookoutFleetHeader header = {};
+        header.magic = LOOKOUT_FLEET_MAGIC;
+        header.version = LOOKOUT_FLEET_VERSION;
+        header.type = FLEET_ANNOUNCE;
+        header.count = 1;
+        header.sequence = announce_sequence_++;
+        LookoutFleetAnnounce body = {};
+        body.port = udp_port_;
+        body.interval_ds = static_cast<uint16_t>(kAnnounceUs / 100000);
+        std::array<uint8_t, sizeof(header) + sizeof(body)> datagram;
+        std::memcpy(datagram.data(), &header, sizeof(header));
+        std::memcpy(datagram.data() + sizeof(header), &body, sizeof(body));
+        (void)stream_.send(datagram.data(), datagram.size(), sf::IpAddress::Broadcast, discovery_port_);
+    }
+
+    Station& station_for(const sf::IpAddress& address, unsigned short port, uint32_t sequence, int64_t now_us) {
+        const std::string name = address.toString() + ":" + std::to_string(port);
+        auto it = stations_.find(name);
+        if (it == stations_.end()) {
+            it = stations_.emplace(name, Station()).first;
+            it->second.name = name;
+            it->second.address = address;
+            it->second.port = port;
+            it->second.first_us = now_us;
+            it->second.next_sequence = sequence;
+            std::cout << "[INFO] New station: " << name << std::endl;
+        }
+        return it->second;
+    }
+
+    void receive_datagrams(int64_t now_us) {
+        std::array<uint8_t, 2048> data;
+        size_t received = 0;
+        std::optional<sf::IpAddress> sender;
+        unsigned short port = 0;
+        if (stream_.receive(data.data(), data.size(), received, sender, port) != sf::Socket::Status::Done || !sender) return;
+        uint32_t magic = 0;
+        if (received >= sizeof(magic)) std::memcpy(&magic, data.data(), sizeof(magic));
+        if (magic == LOOKOUT_FLEET_MAGIC) {
+            receive_fleet(data.data(), received, *sender, port, now_us);
+            return;
+        }
+        LookoutStreamHeader header;
+        if (!parse_stream_datagram(data.data(), received, header, samples_, alarms_)) return;
+        update_station(station_for(*sender, port, header.sequence, now_us), header, now_us);
+    }
+
+    // Fleet datagrams: sizes are checked against the count before anything is read
+    void receive_fleet(const uint8_t* data, size_t size, const sf::IpAddress& sender, unsigned short port, int64_t now_us) {
+        LookoutFleetHeader header;
+        if (size < sizeof(header)) return;
+        std::memcpy(&header, data, sizeof(header));
+        if (header.version != LOOKOUT_FLEET_VERSION || header.type == FLEET_ANNOUNCE || header.type == FLEET_SETTINGS) return;
+        static const size_t kEntrySize[] = { 0, sizeof(LookoutFleetAnnounce), sizeof(LookoutFleetHello), sizeof(LookoutFleetEvent),
+                                             sizeof(LookoutFleetStats), sizeof(LookoutStreamSample),
+                                             sizeof(LookoutFleetSettingsChunk), sizeof(LookoutFleetSettingsAck) };
+        if (header.type >= sizeof(kEntrySize) / sizeof(kEntrySize[0]) || size < sizeof(header) + header.count * kEntrySize[header.type]) return;
+        const uint8_t* entries = data + sizeof(header);
+
+        Station& station = station_for(sender, port, header.sequence, now_us);
+        if (!station.fleet || station.sender_id != header.sender_id) {
+            station.fleet = true;
+            station.sender_id = header.sender_id; // New process: its sequence starts over
+            station.next_sequence = header.sequence;
+        }
+        MinuteStats& minute = station.minute(now_us);
+        if (header.sequence > station.next_sequence) {
+            station.lost += header.sequence - station.next_sequence;
+            minute.lost += header.sequence - station.next_sequence;
+        }
+        station.next_sequence = header.sequence + 1;
+        ++station.datagrams;
+        ++minute.datagrams;
+        station.last_us = now_us;
+
+        for (size_t n = 0; n < header.count; ++n) {
+            const uint8_t* entry = entries + n * kEntrySize[header.type];
+            if (header.type == FLEET_HELLO) {
+                LookoutFleetHello hello;
+                std::memcpy(&hello, entry, sizeof(hello));
+                hello.name[sizeof(hello.name) - 1] = 0;
+                if (station.label != hello.name) std::cout << "[INFO] Station " << station.name << " is \"" << hello.name << "\"" << std::endl;
+                station.label = hello.name;
+                station.header.flags = hello.flags;
+                station.config_version = hello.config_version;
+                station.config_hash = hello.config_hash;
+            } else if (header.type == FLEET_SETTINGS_ACK) {
+                LookoutFleetSettingsAck ack;
+                std::memcpy(&ack, entry, sizeof(ack));
+                station.config_hash = ack.hash;
+                if (ack.status == FLEET_SETTINGS_APPLIED) {
+                    if (station.config_version != ack.version) {
+                        std::cout << "[INFO] Station " << (station.label.empty() ? station.name : station.label)
+                                  << " applied settings version " << ack.version << std::endl;
+                    }
+                    station.config_version = ack.version;
+                } else if (station.rejected_version != ack.version) {
+                    station.rejected_version = ack.version;
+                    std::cerr << "[WARNING] Station " << (station.label.empty() ? station.name : station.label)
+                              << " rejected settings version " << ack.version << "; see its console" << std::endl;
+                }
+            } else if (header.type == FLEET_EVENTS) {
+                LookoutFleetEvent event;
+                std::memcpy(&event, entry, sizeof(event));
+                station.events.push_back(event);
+                if (station.events.size() > kRecentEvents) station.events.pop_front();
+            } else if (header.type == FLEET_STATS) {
+                // The station's own counts are the statistics; events are only the timeline
+                LookoutFleetStats stats;
+                std::memcpy(&stats, entry, sizeof(stats));
+                minute.samples += stats.samples;
+                minute.hmd_ok_samples += stats.hmd_ok_samples;
+                minute.warning_samples += stats.warning_samples;
+                minute.warnings += stats.warnings;
+                minute.lookouts += stats.lookouts;
+                minute.scan_interval_s += stats.scan_interval_ms / 1000.0;
+            } else if (header.type == FLEET_POSE) {
+                std::memcpy(&station.sample, entry, sizeof(station.sample));
+            }
+        }
+    }
+
+    void update_station(Station& station, const LookoutStreamHeader& header, int64_t now_us) {
+        MinuteStats& minute = station.minute(now_us);
+        if (header.sequence > station.next_sequence) {
+            const uint32_t gap = header.sequence - station.next_sequence;
+            station.lost += gap;
+            minute.lost += gap;
+        }
+        station.next_sequence = header.sequence + 1; // Also after a restarted lookout.exe
+        ++station.datagrams;
+        ++minute.datagrams;
+        station.last_us = now_us;
+
+        bool warning = false;
+        for (const LookoutStreamAlarm& a : alarms_) {
+            warning |= (a.state & 1) != 0;
+            auto previous = std::find_if(station.alarms.begin(), station.alarms.end(),
+                                         [&](const LookoutStreamAlarm& p) { return p.id == a.id; });
+            if (previous == station.alarms.end()) continue;
+            if ((a.state & 1) && !(previous->state & 1)) ++minute.warnings;
+            if (a.no_look_ds + 10 < previous->no_look_ds) {
+                ++minute.lookouts;
+                minute.scan_interval_s += previous->no_look_ds / 10.0;
+            }
+        }
+        minute.samples += header.sample_count;
+        if (header.flags & TELEMETRY_HMD_OK) minute.hmd_ok_samples += header.sample_count;
+        if (warning) minute.warning_samples += header.sample_count;
+        station.header = header;
+        if (!samples_.empty()) station.sample = samples_.back();
+        station.alarms = alarms_;
+    }
+
+    void accept_client(int64_t now_us) {
+        clients_.emplace_back();
+        HttpClient& client = clients_.back();
+        if (listener_.accept(client.socket) != sf::Socket::Status::Done) {
+            clients_.pop_back();
+            return;
+        }
+        client.connected_us = now_us;
+        client.socket.setBlocking(false); // A slow reader mustn't hold up the datagrams
+        selector_.add(client.socket);
+    }
+
+    // Any GET gets the whole view; the request is only read up to its blank line. The
+    // reply goes out as the client takes it, within kClientTimeoutUs.
+    void serve_client(HttpClient& client, int64_t now_us) {
+        if (!client.response.empty()) return;
+        std::array<char, 1024> data;
+        size_t received = 0;
+        const sf::Socket::Status status = client.socket.receive(data.data(), data.size(), received);
+        if (status == sf::Socket::Status::NotReady) return;
+        if (status != sf::Socket::Status::Done) {
+            client.done = true;
+            return;
+        }
+        client.request.append(data.data(), received);
+        if (client.request.find("\r\n\r\n") == std::string::npos && client.request.size() < 8192) return;
+        const std::string body = view(now_us).dump(2);
+        client.response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nAccess-Control-Allow-Origin: *\r\n"
+                          "Connection: close\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+        send_response(client);
+    }
+
+    void send_response(HttpClient& client) {
+        size_t sent = 0;
+        const sf::Socket::Status status =
+            client.socket.send(client.response.data() + client.sent, client.response.size() - client.sent, sent);
+        client.sent += sent;
+        if (client.sent >= client.response.size() || (status != sf::Socket::Status::Done &&
+                                                       status != sf::Socket::Status::Partial &&
+                                                       status != sf::Socket::Status::NotReady)) {
+            client.done = true;
+        }
+    }
+
+    void drop_finished_clients(int64_t now_us) {
+        for (auto it = clients_.begin(); it != clients_.end();) {
+            if (it->done || now_us - it->connected_us > kClientTimeoutUs) {
+                selector_.remove(it->socket);
+                it->socket.disconnect();
+                it = clients_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void forget_stale_stations(int64_t now_us) {
+        for (auto it = stations_.begin(); it != stations_.end();) {
+            if (now_us - it->second.last_us > kForgetUs) {
+                std::cout << "[INFO] Forgetting station " << it->first << " (silent for an hour)" << std::endl;
+                it = stations_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void print_stations(int64_t now_us) const {
+        if (stations_.empty()) return;
+        std::printf("%-22s %-8s %7s %7s %5s %5s %9s %8s %6s\n", "station", "state", "yaw", "pitch", "warn", "look",
+                    "scan (s)", "warning", "lost");
+        for (const auto& [name, station] : stations_) {
+            const MinuteStats w = station.window(now_us);
+            const char* state = !online(station, now_us) ? "offline"
+                              : !(station.header.flags & TELEMETRY_FLIGHT_ACTIVE) ? "idle"
+                              : !(station.header.flags & TELEMETRY_HMD_OK) ? "no hmd" : "flying";
+            std::printf("%-22s %-8s %7.1f %7.1f %5u %5u %9.1f %7.1f%% %6llu\n",
+                        (station.label.empty() ? name : station.label).substr(0, 22).c_str(), state,
+                        station.sample.yaw_cdeg / 100.0, station.sample.pitch_cdeg / 100.0, w.warnings, w.lookouts,
+                        w.lookouts ? w.scan_interval_s / w.lookouts : 0.0,
+                        w.samples ? 100.0 * w.warning_samples / w.samples : 0.0,
+                        static_cast<unsigned long long>(station.lost));
+        }
+        std::printf("(warn, look, scan and warning share over the last %zu minutes)\n", Station::kMinutes);
+        if (!push_bytes_.empty()) {
+            size_t fleet = 0, current = 0;
+            for (const auto& [name, station] : stations_) {
+                if (!station.fleet || !online(station, now_us)) continue;
+                ++fleet;
+                if (station.config_hash == push_hash_) ++current;
+            }
+            std::printf("settings version %u: %zu of %zu online fleet station(s) current\n", push_version_, current, fleet);
+        }
+        std::printf("\n");
+        std::fflush(stdout);
+    }
+
+    sf::UdpSocket stream_;          // Stream and fleet datagrams in, announcements out
+    unsigned short udp_port_ = 0, discovery_port_ = 0;
+    int64_t next_announce_us_ = 0;
+    uint32_t announce_sequence_ = 0;
+    std::string push_path_;         // --push; empty for none
+    std::string push_bytes_;
+    uint32_t push_version_ = 0, push_hash_ = 0;
+    uint32_t push_sequence_ = 0;
+    sf::TcpListener listener_;
+    sf::SocketSelector selector_;
+    std::map<std::string, Station> stations_;
+    std::list<HttpClient> clients_; // Stable addresses: the selector holds references
+    std::vector<LookoutStreamSample> samples_; // Scratch for the datagram being parsed
+    std::vector<LookoutStreamAlarm> alarms_;
+};
+
+int main(int argc, char** argv) {
+    unsigned short udp_port = 55301;
+    unsigned short http_port = 55302;
+    double print_s = 5.0;
+    unsigned short discovery_port = LOOKOUT_FLEET_DISCOVERY_PORT;
+    std::string push_path;
+    bool usage = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--port" && i + 1 < argc) {
+            udp_port = static_cast<unsigned short>(std::atoi(argv[++i]));
+            usage |= udp_port == 0;
+        } else if (arg == "--http" && i + 1 < argc) {
+            http_port = static_cast<unsigned short>(std::atoi(argv[++i])); // 0: no HTTP view
+        } else if (arg == "--print" && i + 1 < argc) {
+            print_s = std::atof(argv[++i]); // 0: no console table
+        } else if (arg == "--discovery" && i + 1 < argc) {
+            discovery_port = static_cast<unsigned short>(std::atoi(argv[++i])); // 0: don't announce
+        } else if (arg == "--push" && i + 1 < argc) {
+            push_path = argv[++i];
+        } else {
+            usage = true;
+        }
+    }
+    if (usage) {
+        std::cerr << "usage: lookout_hub [--port UDP_PORT] [--http TCP_PORT] [--print SECONDS] [--discovery UDP_PORT]"
+                     " [--push SETTINGS_JSON]" << std::endl;
+        return 2;
+    }
+
+    LookoutHub hub;
+    if (!push_path.empty() && !hub.push_settings(push_path)) return 1;
+    if (!hub.start(udp_port, http_port, discovery_port)) return 1;
+    hub.run(print_s);
+    return 0;
+}
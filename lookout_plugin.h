@@ -0,0 +1,98 @@
+/* lookout_plugin.h
+ * The C interface of Quest Lookout plugins ("plugins" in settings.json): DLLs in the
+ * plugins folder that see the head poses and engine events and can report events of
+ * their own, for scan rules the alarm table doesn't cover. Plain C with fixed-size
+ * types, so a plugin built by any compiler against this header keeps loading as long
+ * as LOOKOUT_PLUGIN_ABI_VERSION is the same.
+ *
+ * A plugin exports one function:
+ *
+ *   LOOKOUT_PLUGIN_EXPORT int32_t lookout_plugin_init(const LookoutPluginHost* host,
+ *                                                     LookoutPluginApi* api);
+ *
+ * It checks host->abi_version, fills in `api` (any callback may be NULL) and returns
+ * 0, or non-zero to decline loading. Every callback runs on the plugin worker thread,
+ * never on the tracking or alarm threads, one at a time across all plugins. Pose
+ * batches are spans into the worker's buffer, valid only for the duration of the call.
+ * A callback that overruns the time budget is reported, and a plugin that keeps
+ * overrunning is no longer called; samples that arrive while the worker is busy are
+ * dropped rather than queued without bound.
+ */
+
+#ifndef LOOKOUT_PLUGIN_H
+#define LOOKOUT_PLUGIN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LOOKOUT_PLUGIN_ABI_VERSION 1
+#define LOOKOUT_PLUGIN_EXPORT __declspec(dllexport)
+
+/* LookoutPluginPose.flags */
+#define LOOKOUT_POSE_HMD_OK      0x1u /* Tracked, mounted and displaying; otherwise the angles are stale */
+#define LOOKOUT_POSE_RECENTERED  0x2u /* First pose after a recenter */
+#define LOOKOUT_POSE_LEAN_VALID  0x4u /* lean_* are measured */
+
+/* One head pose, relative to the pilot's forward direction, as the alarm engine saw it */
+typedef struct LookoutPluginPose {
+    int64_t t_us;             /* Core clock (microseconds since the monitor started) */
+    float yaw_deg;            /* -180..180, positive left */
+    float pitch_deg;          /* -90..90, positive up */
+    float lean_lateral_cm;    /* Positive left of the recenter position */
+    float lean_vertical_cm;   /* Positive above it */
+    float angular_speed_deg_s;
+    uint32_t flags;           /* LOOKOUT_POSE_* */
+} LookoutPluginPose;
+
+/* LookoutPluginEvent.type: the values of the monitor's event bus */
+enum {
+    LOOKOUT_EVENT_DIRECTION_REGISTERED = 0, /* value: direction (0 L, 1 R, 2 up, 3 down, 4-6 leans, 7 coverage) */
+    LOOKOUT_EVENT_LOOKOUT_SUCCESS = 1,      /* value: L/R time difference (us) */
+    LOOKOUT_EVENT_WARNING_STARTED = 2,      /* value: us past the alarm's deadline */
+    LOOKOUT_EVENT_WARNING_REPEAT = 3,       /* value: ms into the warning */
+    LOOKOUT_EVENT_CENTER_RESET = 4,
+    LOOKOUT_EVENT_FLIGHT_START = 5,
+    LOOKOUT_EVENT_FLIGHT_END = 6,
+    LOOKOUT_EVENT_PLUGIN = 7                /* Reported by a plugin; alarm: the plugin's own rule code */
+};
+
+typedef struct LookoutPluginEvent {
+    uint32_t type;            /* LOOKOUT_EVENT_* */
+    uint32_t alarm;           /* Alarm id (settings.json "alarms" index), or the rule code */
+    int64_t value;
+    int64_t engine_us;        /* Alarm engine time; pauses don't count */
+    int64_t t_us;             /* Core clock */
+} LookoutPluginEvent;
+
+/* What the monitor offers a plugin. Valid until the plugin's shutdown returns. */
+typedef struct LookoutPluginHost {
+    uint32_t abi_version;     /* LOOKOUT_PLUGIN_ABI_VERSION of the monitor */
+    uint32_t size;            /* sizeof(LookoutPluginHost) of the monitor */
+    void* context;
+    /* Publish a LOOKOUT_EVENT_PLUGIN event with this rule code and value on the event bus */
+    void (*emit)(void* context, uint32_t code, int64_t value);
+    /* One line in the monitor's log, prefixed with the plugin name */
+    void (*log)(void* context, const char* message);
+} LookoutPluginHost;
+
+/* What a plugin offers the monitor, filled in by lookout_plugin_init */
+typedef struct LookoutPluginApi {
+    uint32_t size;            /* sizeof(LookoutPluginApi) as the monitor passed it; don't write past it */
+    const char* name;         /* Shown in the log; the DLL name if NULL */
+    void* instance;           /* Passed back to every callback */
+    void (*on_poses)(void* instance, const LookoutPluginPose* poses, size_t count);
+    void (*on_event)(void* instance, const LookoutPluginEvent* event);
+    void (*shutdown)(void* instance);
+} LookoutPluginApi;
+
+typedef int32_t (*LookoutPluginInitFn)(const LookoutPluginHost* host, LookoutPluginApi* api);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOOKOUT_PLUGIN_H */
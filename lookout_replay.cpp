@@ -0,0 +1,864 @@
+// lookout_replay.cpp
+// Runs a recorded pose trace (.qlpt or .qlpz, see lookout_trace.hpp) through the alarm
+// engine with the alarms of a settings.json, as fast as the CPU goes: no headset, audio
+// or window, only the engine. Prints the alarm events on the trace's timeline and the
+// evaluation throughput, for regression checks and threshold tuning.
+//
+//   lookout_replay <trace> [settings.json] [--verbose] [--alarms N[,N...]] [--export DIR]
+//                  [--window FROM_S:TO_S] [--markers]
+//   lookout_replay --synthetic <hours> [settings.json] [--rate HZ] [--pattern sweep|flicks|mixed]
+//                  [--drift DEG_PER_MIN] [--dropouts PER_HOUR] [--unmounts PER_HOUR] [--alarms N[,N...]]
+//   lookout_replay --sweep <grid.json> [settings.json] <trace>... [--jobs N]
+//
+// --synthetic generates the head motion instead (lookout_synthetic.hpp). --alarms runs
+// that many alarms, the settings' enabled ones repeated with their horizontal angles
+// spread, once per count given, and prints how the cost scales. --export writes the
+// samples and the alarm events as NumPy columns for pandas (see ColumnExport).
+//
+// --markers lists the trace's event markers; --window replays (or exports) only the
+// samples between two times, in seconds from the first sample, found through the
+// trace's index without reading the rest (PoseTraceSeeker).
+//
+// --sweep replays every trace against every combination of the grid's alarm fields,
+// e.g. {"max_time_ms": [15000, 30000], "min_horizontal_angle": [60, 90, 120]}, each
+// applied to all of the settings' enabled alarms, and prints warnings and lookouts
+// per hour for each combination over the whole archive (see run_sweep).
+//
+// The reference is taken like a recenter at the first tracked sample and at every
+// sample the sampler flagged POSE_RECENTERED; the look filter and peak interpolation
+// of lookout.exe aren't applied.
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "json.hpp"
+#include "lookout_engine.hpp"
+#include "lookout_synthetic.hpp"
+#include "lookout_trace.hpp"
+
+// A trace's records a batch at a time: an archive block, or POSE_ARCHIVE_BLOCK_RECORDS
+// of a raw trace, complete or cut short (record_count 0: up to the first empty record)
+class TraceReader {
+public:
+    bool open(const std::string& path) {
+        uint32_t magic = 0;
+        {
+            std::ifstream f(path, std::ios::binary);
+            if (!f.read(reinterpret_cast<char*>(&magic), sizeof(magic))) return false;
+        }
+        if (magic == POSE_ARCHIVE_MAGIC) {
+            archived_ = true;
+            return archive_.open(path);
+        }
+        if (magic != POSE_TRACE_MAGIC) return false;
+        std::error_code error;
+        const uintmax_t bytes = std::filesystem::file_size(path, error);
+        raw_capacity_ = !error && bytes > sizeof(header_) ? (bytes - sizeof(header_)) / sizeof(PoseTraceRecord) : 0;
+        raw_.open(path, std::ios::binary);
+        return raw_.read(reinterpret_cast<char*>(&header_), sizeof(header_)) && header_.version == POSE_TRACE_VERSION &&
+               header_.record_size == sizeof(PoseTraceRecord);
+    }
+
+    // 0 when a raw trace was never closed; no more than the file holds
+    uint64_t record_count() const {
+        return archived_ ? archive_.header().record_count : (std::min<uint64_t>)(header_.record_count, raw_capacity_);
+    }
+
+    // The next batch into out; false at the end, or on a damaged archive block (failed())
+    bool next(std::vector<PoseTraceRecord>& out) {
+        if (archived_) {
+            if (next_block_ >= archive_.index().size()) return false;
+            failed_ = !archive_.read_block(next_block_++, out);
+            return !failed_;
+        }
+        out.resize(POSE_ARCHIVE_BLOCK_RECORDS);
+        size_t n = 0;
+        while (n < out.size() && !raw_done_ && (header_.record_count == 0 || read_ < header_.record_count) &&
+               raw_.read(reinterpret_cast<char*>(&out[n]), sizeof(PoseTraceRecord))) {
+            if (header_.record_count == 0 && out[n].t_us == 0 && read_ > 0) {
+                raw_done_ = true;
+                break;
+            }
+            ++n;
+            ++read_;
+        }
+        out.resize(n);
+        return n > 0;
+    }
+
+    bool failed() const { return failed_; }
+
+private:
+    bool archived_ = false;
+    PoseArchiveReader archive_;
+    size_t next_block_ = 0;
+    std::ifstream raw_;
+    PoseTraceHeader header_ = {};
+    uint64_t raw_capacity_ = 0; // Records the raw file has room for
+    uint64_t read_ = 0;
+    bool raw_done_ = false;
+    bool failed_ = false;
+};
+
+bool read_trace(const std::string& path, std::vector<PoseTraceRecord>& records) {
+    TraceReader reader;
+    if (!reader.open(path)) return false;
+    records.reserve(static_cast<size_t>(reader.record_count()));
+    std::vector<PoseTraceRecord> batch;
+    while (reader.next(batch)) records.insert(records.end(), batch.begin(), batch.end());
+    return !reader.failed();
+}
+
+// The baseline part of lookout.cpp's ReferenceTransform: the pose at the last recenter
+struct Reference {
+    float inverse[4] = { 0.0f, 0.0f, 0.0f, 1.0f }; // x, y, z, w
+    double position[3] = {};
+    double left_x = -1.0, left_z = 0.0;
+    bool has_position = false;
+
+    void capture(const PoseTraceRecord& r) {
+        const float* q = r.orientation;
+        inverse[0] = -q[0];
+        inverse[1] = -q[1];
+        inverse[2] = -q[2];
+        inverse[3] = q[3];
+        for (int k = 0; k < 3; ++k) position[k] = r.position[k];
+        // ovrStatus_PositionTracked, or XR_SPACE_LOCATION_POSITION_TRACKED_BIT from OpenXR
+        has_position = (r.status_flags & ((r.session_flags & TRACE_OPENXR) ? 0x8u : 0x2u)) != 0;
+        double lx = -(1.0 - 2.0 * (q[1] * q[1] + q[2] * q[2]));
+        double lz = -(2.0 * (q[0] * q[2] - q[3] * q[1]));
+        double length = std::sqrt(lx * lx + lz * lz);
+        if (length > 1e-6) {
+            left_x = lx / length;
+            left_z = lz / length;
+        }
+    }
+
+    // As quat_to_look_vector() with no manual offset
+    LookVector look(const PoseTraceRecord& r) const {
+        const float* b = inverse;
+        const float* q = r.orientation;
+        double w = b[3] * q[3] - b[0] * q[0] - b[1] * q[1] - b[2] * q[2];
+        double x = b[3] * q[0] + b[0] * q[3] + b[1] * q[2] - b[2] * q[1];
+        double y = b[3] * q[1] - b[0] * q[2] + b[1] * q[3] + b[2] * q[0];
+        double z = b[3] * q[2] + b[0] * q[1] - b[1] * q[0] + b[2] * q[3];
+        LookVector v;
+        v.yaw_sin = 2.0 * (w * y + x * z);
+        v.yaw_cos = 1.0 - 2.0 * (y * y + z * z);
+        v.pitch_sin = (std::max)(-1.0, (std::min)(1.0, -2.0 * (y * z - w * x)));
+        return v;
+    }
+
+    LeanOffset lean(const PoseTraceRecord& r) const {
+        LeanOffset l;
+        if (!has_position) return l;
+        double dx = r.position[0] - position[0], dz = r.position[2] - position[2];
+        l.lateral_m = dx * left_x + dz * left_z;
+        l.vertical_m = r.position[1] - position[1];
+        l.valid = true;
+        return l;
+    }
+};
+
+// One pose as the replay loop hands it to the engine (dt_us is filled in there)
+struct ReplayInput {
+    int64_t t_us = 0;
+    uint32_t flags = 0; // PoseSampleFlags
+    LookInput input;
+};
+
+// Trace records as engine inputs, against the reference at the last recenter
+class TraceConverter {
+public:
+    void convert(const PoseTraceRecord& r, ReplayInput& in) {
+        in = ReplayInput();
+        in.t_us = r.t_us;
+        in.flags = r.pose_flags;
+        if (!(r.pose_flags & POSE_HMD_OK)) return;
+        if (!have_reference_ || (r.pose_flags & POSE_RECENTERED)) {
+            reference_.capture(r);
+            have_reference_ = true;
+        }
+        in.input.look = reference_.look(r);
+        in.input.lean = reference_.lean(r);
+    }
+
+private:
+    Reference reference_;
+    bool have_reference_ = false;
+};
+
+class TraceFeed {
+public:
+    explicit TraceFeed(const std::vector<PoseTraceRecord>& records) : records_(records) {}
+
+    size_t fill(ReplayInput* out, size_t max_inputs) {
+        size_t count = 0;
+        for (; count < max_inputs && next_ < records_.size(); ++count) converter_.convert(records_[next_++], out[count]);
+        return count;
+    }
+
+private:
+    const std::vector<PoseTraceRecord>& records_;
+    size_t next_ = 0;
+    TraceConverter converter_;
+};
+
+// As TraceFeed, reading the trace as it goes instead of holding all of it
+class StreamingTraceFeed {
+public:
+    explicit StreamingTraceFeed(TraceReader& reader) : reader_(reader) {}
+
+    size_t fill(ReplayInput* out, size_t max_inputs) {
+        size_t count = 0;
+        while (count < max_inputs) {
+            if (next_ == batch_.size()) {
+                next_ = 0;
+                if (!reader_.next(batch_)) break;
+            }
+            converter_.convert(batch_[next_++], out[count++]);
+        }
+        return count;
+    }
+
+private:
+    TraceReader& reader_;
+    std::vector<PoseTraceRecord> batch_;
+    size_t next_ = 0;
+    TraceConverter converter_;
+};
+
+class SyntheticFeed {
+public:
+    explicit SyntheticFeed(const SyntheticMotionConfig& config) : motion_(config) {}
+
+    size_t fill(ReplayInput* out, size_t max_inputs) {
+        size_t count = 0;
+        SyntheticPose pose;
+        for (; count < max_inputs && motion_.next(pose); ++count) {
+            ReplayInput& in = out[count];
+            in = ReplayInput();
+            in.t_us = pose.t_us;
+            in.flags = pose.tracked ? POSE_HMD_OK : 0u;
+            in.input.look = yaw_pitch_to_look_vector(pose.yaw_deg, pose.pitch_deg);
+        }
+        return count;
+    }
+
+private:
+    SyntheticHeadMotion motion_;
+};
+
+// One column as a NumPy .npy file (format 1.0), written as values arrive: the shape in
+// the header is a fixed-width placeholder rewritten when the column is closed, so a
+// column of any length costs a 64 KiB buffer
+class NpyColumn {
+public:
+    bool open(const std::string& path, const char* descr) {
+        descr_ = descr;
+        file_.open(path, std::ios::binary | std::ios::trunc);
+        write_header();
+        return static_cast<bool>(file_);
+    }
+
+    template <typename T>
+    void add(T value) {
+        const size_t at = buffer_.size();
+        buffer_.resize(at + sizeof(T));
+        std::memcpy(buffer_.data() + at, &value, sizeof(T));
+        ++count_;
+        if (buffer_.size() >= (64u << 10)) flush();
+    }
+
+    bool close() {
+        flush();
+        file_.seekp(0);
+        write_header();
+        file_.close();
+        return !file_.fail();
+    }
+
+private:
+    static constexpr size_t kHeaderBytes = 128; // Magic, version, length and the padded dict
+
+    void write_header() {
+        char dict[kHeaderBytes];
+        std::snprintf(dict, sizeof(dict), "{'descr': '%s', 'fortran_order': False, 'shape': (%20llu,), }", descr_.c_str(),
+                      static_cast<unsigned long long>(count_));
+        std::string header("\x93NUMPY\x01\x00", 8);
+        const uint16_t length = static_cast<uint16_t>(kHeaderBytes - 10);
+        header.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        header += dict;
+        header.resize(kHeaderBytes - 1, ' ');
+        header += '\n';
+        file_.write(header.data(), static_cast<std::streamsize>(header.size()));
+    }
+
+    void flush() {
+        file_.write(reinterpret_cast<const char*>(buffer_.data()), static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
+    }
+
+    std::ofstream file_;
+    std::string descr_;
+    std::vector<uint8_t> buffer_;
+    uint64_t count_ = 0;
+};
+
+// --export: a directory of columns, samples.<name>.npy and events.<name>.npy, with a
+// manifest.json naming them and the event types. In pandas:
+//
+//   d = pathlib.Path("export")
+//   samples = pd.DataFrame({p.stem.split(".", 1)[1]: np.load(p) for p in d.glob("samples.*.npy")})
+//
+// Angles and lean are NaN while the headset wasn't tracked.
+class ColumnExport {
+public:
+    bool open(const std::string& directory) {
+        directory_ = directory;
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        bool ok = true;
+        for (size_t i = 0; i < kSampleColumns; ++i) ok &= samples_[i].open(path("samples", kSampleNames[i]), kSampleTypes[i]);
+        for (size_t i = 0; i < kEventColumns; ++i) ok &= events_[i].open(path("events", kEventNames[i]), kEventTypes[i]);
+        return ok;
+    }
+
+    // Before the engine sees them, so the columns are the trace as replayed
+    void add_samples(const ReplayInput* inputs, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            const ReplayInput& in = inputs[i];
+            const bool tracked = (in.flags & POSE_HMD_OK) != 0;
+            double yaw_deg = NAN, pitch_deg = NAN;
+            if (tracked) look_vector_to_yaw_pitch(in.input.look, yaw_deg, pitch_deg);
+            const bool lean = tracked && in.input.lean.valid;
+            samples_[0].add(in.t_us / 1e6);
+            samples_[1].add(static_cast<float>(yaw_deg));
+            samples_[2].add(static_cast<float>(pitch_deg));
+            samples_[3].add(lean ? static_cast<float>(in.input.lean.lateral_m * 100.0) : NAN);
+            samples_[4].add(lean ? static_cast<float>(in.input.lean.vertical_m * 100.0) : NAN);
+            samples_[5].add(static_cast<uint8_t>(tracked));
+            samples_[6].add(in.flags);
+        }
+    }
+
+    void add_event(int64_t t_us, const LookoutEvent& e) {
+        events_[0].add(t_us / 1e6);
+        events_[1].add(static_cast<uint8_t>(e.type));
+        events_[2].add(e.alarm);
+        events_[3].add(static_cast<int64_t>(e.value));
+    }
+
+    bool close() {
+        bool ok = true;
+        for (NpyColumn& c : samples_) ok &= c.close();
+        for (NpyColumn& c : events_) ok &= c.close();
+        nlohmann::json manifest = { { "samples", nlohmann::json::array() }, { "events", nlohmann::json::array() },
+                                    { "event_types", nlohmann::json::array() } };
+        for (const char* name : kSampleNames) manifest["samples"].push_back(name);
+        for (const char* name : kEventNames) manifest["events"].push_back(name);
+        for (int type = 0; type <= LookoutEvent::CENTER_RESET; ++type) {
+            manifest["event_types"].push_back(LookoutEvent::name(static_cast<LookoutEvent::Type>(type)));
+        }
+        std::ofstream out(directory_ + "/manifest.json");
+        out << manifest.dump(2) << '\n';
+        return ok && static_cast<bool>(out);
+    }
+
+private:
+    static constexpr size_t kSampleColumns = 7, kEventColumns = 4;
+    static constexpr const char* kSampleNames[kSampleColumns] = { "t_s", "yaw_deg", "pitch_deg", "lean_lateral_cm",
+                                                                  "lean_vertical_cm", "hmd_ok", "flags" };
+    static constexpr const char* kSampleTypes[kSampleColumns] = { "<f8", "<f4", "<f4", "<f4", "<f4", "|u1", "<u4" };
+    static constexpr const char* kEventNames[kEventColumns] = { "t_s", "type", "alarm", "value" };
+    static constexpr const char* kEventTypes[kEventColumns] = { "<f8", "|u1", "<u4", "<i8" };
+
+    std::string path(const char* table, const char* column) const {
+        return directory_ + "/" + table + "." + column + ".npy";
+    }
+
+    std::string directory_;
+    NpyColumn samples_[kSampleColumns];
+    NpyColumn events_[kEventColumns];
+};
+
+// Passes a feed's inputs through to the engine, exporting them on the way
+template <typename Feed>
+class ExportingFeed {
+public:
+    ExportingFeed(Feed& feed, ColumnExport& out) : feed_(feed), out_(out) {}
+
+    size_t fill(ReplayInput* inputs, size_t max_inputs) {
+        const size_t count = feed_.fill(inputs, max_inputs);
+        out_.add_samples(inputs, count);
+        return count;
+    }
+
+private:
+    Feed& feed_;
+    ColumnExport& out_;
+};
+
+struct TimedEvent {
+    int64_t t_us;
+    LookoutEvent event;
+};
+
+struct ReplayResult {
+    std::vector<TimedEvent> events;   // Only when asked to keep them
+    std::vector<uint64_t> event_counts = std::vector<uint64_t>(LookoutEvent::CENTER_RESET + 1, 0);
+    uint64_t samples = 0, evaluated = 0;
+    double engine_s = 0.0;            // In the engine alone: feeding and bookkeeping aren't timed
+    int64_t first_t_us = 0, last_t_us = 0;
+};
+
+// on_event(t_us, event) sees every event as it happens, kept or not
+template <typename Feed, typename OnEvent>
+ReplayResult run_replay(AlarmTable table, const nlohmann::json& settings, Feed& feed, bool keep_events, OnEvent&& on_event) {
+    LookoutEngine engine(std::move(table));
+    const nlohmann::json center_reset = settings.value("center_reset", nlohmann::json::object());
+    engine.set_center_reset(center_reset.value("window_degrees", 20.0), center_reset.value("hold_time_seconds", 3.0));
+    const nlohmann::json sampling = settings.value("sampling", nlohmann::json::object());
+    engine.set_fixed_step(static_cast<int64_t>(sampling.value("fixed_step_ms", 0.0) * 1000.0));
+    const nlohmann::json resume = settings.value("resume", nlohmann::json::object());
+    const int64_t reconnect_grace_us = seconds_to_us((std::max)(0.0, resume.value("reconnect_grace_s", 120.0)));
+
+    ReplayResult result;
+    auto note = [&](int64_t t_us, const std::vector<LookoutEvent>& events) {
+        for (const LookoutEvent& e : events) {
+            ++result.event_counts[e.type];
+            on_event(t_us, e);
+            if (keep_events) result.events.push_back({ t_us, e });
+        }
+    };
+    std::vector<ReplayInput> chunk(1024);
+    bool previous_evaluated = false;
+    int64_t previous_t_us = 0;
+    bool session_lost = false;
+    int64_t session_lost_us = 0;
+    std::vector<AlarmSnapshot> lost_state;
+    while (size_t count = feed.fill(chunk.data(), chunk.size())) {
+        if (!result.samples) result.first_t_us = chunk[0].t_us;
+        result.samples += count;
+        result.last_t_us = chunk[count - 1].t_us;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; ++i) {
+            ReplayInput& in = chunk[i];
+            if (!(in.flags & POSE_HMD_OK)) {
+                // As the core: the alarms pause, and a lost session stops them; back within
+                // resume.reconnect_grace_s they carry on from where they were
+                if ((in.flags & POSE_SESSION_LOST) && !session_lost) {
+                    session_lost = true;
+                    session_lost_us = in.t_us;
+                    lost_state = engine.snapshot(in.t_us);
+                }
+                if (in.flags & POSE_SESSION_LOST) note(in.t_us, engine.restart_all());
+                previous_evaluated = false;
+                continue;
+            }
+            if (session_lost) {
+                session_lost = false;
+                if (in.t_us - session_lost_us <= reconnect_grace_us) note(in.t_us, engine.restore(lost_state, in.t_us));
+            }
+            in.input.dt_us = previous_evaluated ? (std::max<int64_t>)(in.t_us - previous_t_us, 0) : 0;
+            previous_t_us = in.t_us;
+            previous_evaluated = true;
+            ++result.evaluated;
+            note(in.t_us, engine.step(in.input, in.t_us));
+        }
+        result.engine_s += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return result;
+}
+
+template <typename Feed>
+ReplayResult run_replay(AlarmTable table, const nlohmann::json& settings, Feed& feed, bool keep_events) {
+    return run_replay(std::move(table), settings, feed, keep_events, [](int64_t, const LookoutEvent&) {});
+}
+
+// The settings' enabled alarms, or with copies > 0 that many of them, repeated round
+// robin with horizontal angles spread +/-15% so the copies don't all trip together
+bool build_alarm_table(const nlohmann::json& settings, size_t copies, AlarmTable& table) {
+    std::vector<std::pair<uint32_t, LookoutAlarmConfig>> enabled;
+    const nlohmann::json& alarms = settings.value("alarms", nlohmann::json::array());
+    for (size_t i = 0; i < alarms.size(); ++i) {
+        LookoutAlarmConfig config = alarms[i].get<LookoutAlarmConfig>();
+        if (config.enabled()) enabled.emplace_back(static_cast<uint32_t>(i), config);
+    }
+    if (enabled.empty()) return false;
+    table.alarms.clear();
+    if (copies == 0) {
+        for (const auto& alarm : enabled) table.alarms.push_back(compile_alarm(alarm.second, alarm.first));
+    } else {
+        for (size_t k = 0; k < copies; ++k) {
+            LookoutAlarmConfig config = enabled[k % enabled.size()].second;
+            config.min_horizontal_angle *= 0.85 + 0.3 * static_cast<double>(k % 16) / 15.0;
+            table.alarms.push_back(compile_alarm(config, static_cast<uint32_t>(k)));
+        }
+    }
+    order_alarm_table(table);
+    return true;
+}
+
+// Poses already converted to engine inputs, shared read-only by every job on a trace
+class InputFeed {
+public:
+    explicit InputFeed(const std::vector<ReplayInput>& inputs) : inputs_(inputs) {}
+
+    size_t fill(ReplayInput* out, size_t max_inputs) {
+        const size_t count = (std::min)(max_inputs, inputs_.size() - next_);
+        std::copy(inputs_.begin() + next_, inputs_.begin() + next_ + count, out);
+        next_ += count;
+        return count;
+    }
+
+private:
+    const std::vector<ReplayInput>& inputs_;
+    size_t next_ = 0;
+};
+
+// --sweep: (trace x config) jobs, trace-major, handed out to the worker threads from one
+// atomic counter, so a thread that finishes early just takes the next job. A trace is
+// read and converted once, by the first job to reach it, shared by the rest, and freed
+// by the last, so the traces in memory are the few the threads are on.
+int run_sweep(const nlohmann::json& settings, const nlohmann::json& grid, const std::vector<std::string>& traces, size_t threads) {
+    // The combinations, first key varying slowest
+    const nlohmann::json known = LookoutAlarmConfig();
+    std::vector<std::string> keys;
+    std::vector<nlohmann::json> configs(1, nlohmann::json::object());
+    for (const auto& [key, values] : grid.items()) {
+        if (!known.contains(key) || !values.is_array() || values.empty()) {
+            std::cerr << "[ERROR] Sweep grid: \"" << key << "\" must be an alarm field with a list of values" << std::endl;
+            return 1;
+        }
+        keys.push_back(key);
+        std::vector<nlohmann::json> next;
+        for (const nlohmann::json& config : configs) {
+            for (const nlohmann::json& value : values) {
+                nlohmann::json c = config;
+                c[key] = value;
+                next.push_back(c);
+            }
+        }
+        configs = std::move(next);
+    }
+    std::vector<AlarmTable> tables(configs.size());
+    for (size_t c = 0; c < configs.size(); ++c) {
+        nlohmann::json s = settings;
+        for (nlohmann::json& alarm : s["alarms"]) {
+            for (const auto& [key, value] : configs[c].items()) alarm[key] = value;
+        }
+        try {
+            if (!build_alarm_table(s, 0, tables[c])) {
+                std::cerr << "[ERROR] No enabled alarms with " << configs[c].dump() << std::endl;
+                return 1;
+            }
+        } catch (const nlohmann::json::exception& e) {
+            std::cerr << "[ERROR] Bad alarm with " << configs[c].dump() << ": " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    struct SharedTrace {
+        std::once_flag loaded;
+        std::shared_ptr<const std::vector<ReplayInput>> inputs; // Null if it couldn't be read
+        std::atomic<size_t> remaining{0};
+    };
+    struct Totals {
+        std::atomic<uint64_t> warnings{0}, lookouts{0}, evaluated{0}, span_us{0};
+    };
+    std::vector<SharedTrace> shared(traces.size());
+    std::vector<Totals> totals(configs.size());
+    for (SharedTrace& t : shared) t.remaining = configs.size();
+    std::atomic<size_t> next_job{0}, unreadable{0};
+    const size_t job_count = traces.size() * configs.size();
+    const auto start = std::chrono::steady_clock::now();
+
+    auto worker = [&]() {
+        for (size_t job = next_job++; job < job_count; job = next_job++) {
+            const size_t t = job / configs.size(), c = job % configs.size();
+            SharedTrace& trace = shared[t];
+            std::call_once(trace.loaded, [&]() {
+                std::vector<PoseTraceRecord> records;
+                if (!read_trace(traces[t], records) || records.empty()) {
+                    std::cerr << "[WARNING] Skipping " << traces[t] << ": not a readable pose trace" << std::endl;
+                    ++unreadable;
+                    return;
+                }
+                auto inputs = std::make_shared<std::vector<ReplayInput>>(records.size());
+                TraceFeed feed(records);
+                feed.fill(inputs->data(), inputs->size());
+                trace.inputs = std::move(inputs);
+            });
+            if (std::shared_ptr<const std::vector<ReplayInput>> inputs = trace.inputs) {
+                InputFeed feed(*inputs);
+                const ReplayResult result = run_replay(tables[c], settings, feed, false);
+                totals[c].warnings += result.event_counts[LookoutEvent::WARNING_START];
+                totals[c].lookouts += result.event_counts[LookoutEvent::LOOKOUT_SUCCESS];
+                totals[c].evaluated += result.evaluated;
+                totals[c].span_us += static_cast<uint64_t>(result.last_t_us - result.first_t_us);
+            }
+            if (--trace.remaining == 0) trace.inputs.reset();
+        }
+    };
+    std::vector<std::thread> pool;
+    for (size_t n = 0; n < threads; ++n) pool.emplace_back(worker);
+    for (std::thread& thread : pool) thread.join();
+    const double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (const std::string& key : keys) std::printf("%22s ", key.c_str());
+    std::printf("%12s %12s %12s\n", "warnings/h", "lookouts/h", "s/lookout");
+    for (size_t c = 0; c < configs.size(); ++c) {
+        for (const std::string& key : keys) std::printf("%22s ", configs[c][key].dump().c_str());
+        const double hours = totals[c].span_us.load() / 3.6e9;
+        const uint64_t lookouts = totals[c].lookouts.load();
+        std::printf("%12.2f %12.2f %12.1f\n", hours > 0.0 ? totals[c].warnings.load() / hours : 0.0,
+                    hours > 0.0 ? lookouts / hours : 0.0, lookouts ? hours * 3600.0 / lookouts : 0.0);
+    }
+    uint64_t evaluated = 0;
+    for (const Totals& t : totals) evaluated += t.evaluated.load();
+    std::printf("\n%zu config(s) x %zu trace(s) on %zu thread(s) in %.2f s (%.0f samples/s)\n", configs.size(),
+                traces.size() - unreadable.load(), threads, elapsed_s, evaluated / elapsed_s);
+    return unreadable.load() == traces.size() ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    std::string trace_path, settings_path = "settings.json", export_dir, sweep_path;
+    std::vector<std::string> sweep_traces;
+    size_t jobs = (std::max)(1u, std::thread::hardware_concurrency());
+    bool verbose = false, list_markers = false;
+    double window_from_s = -1.0, window_to_s = -1.0;
+    double synthetic_hours = 0.0;
+    SyntheticMotionConfig synthetic;
+    std::vector<size_t> alarm_counts;
+    bool usage = false;
+    for (int i = 1, positional = 0; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--verbose") {
+            verbose = true;
+        } else if (arg == "--export" && has_value) {
+            export_dir = argv[++i];
+        } else if (arg == "--markers") {
+            list_markers = true;
+        } else if (arg == "--window" && has_value) {
+            usage |= std::sscanf(argv[++i], "%lf:%lf", &window_from_s, &window_to_s) != 2 || window_from_s < 0.0 ||
+                     window_to_s <= window_from_s;
+        } else if (arg == "--sweep" && has_value) {
+            sweep_path = argv[++i];
+        } else if (arg == "--jobs" && has_value) {
+            const long n = std::atol(argv[++i]);
+            usage |= n <= 0;
+            if (n > 0) jobs = static_cast<size_t>(n);
+        } else if (arg == "--synthetic" && has_value) {
+            synthetic_hours = std::atof(argv[++i]);
+            usage |= synthetic_hours <= 0.0;
+        } else if (arg == "--rate" && has_value) {
+            synthetic.rate_hz = std::atof(argv[++i]);
+        } else if (arg == "--pattern" && has_value) {
+            usage |= !parse_synthetic_pattern(argv[++i], synthetic.pattern);
+        } else if (arg == "--drift" && has_value) {
+            synthetic.drift_deg_per_min = std::atof(argv[++i]);
+        } else if (arg == "--dropouts" && has_value) {
+            synthetic.dropouts_per_hour = std::atof(argv[++i]);
+        } else if (arg == "--unmounts" && has_value) {
+            synthetic.unmounts_per_hour = std::atof(argv[++i]);
+        } else if (arg == "--alarms" && has_value) {
+            std::stringstream list(argv[++i]);
+            std::string count;
+            while (std::getline(list, count, ',')) {
+                const long n = std::atol(count.c_str());
+                usage |= n <= 0;
+                if (n > 0) alarm_counts.push_back(static_cast<size_t>(n));
+            }
+        } else if (arg.compare(0, 2, "--") == 0) {
+            usage = true;
+        } else if (!sweep_path.empty()) {
+            // Sweeps take any number of traces; the .json is the settings
+            if (arg.size() > 5 && arg.compare(arg.size() - 5, 5, ".json") == 0) settings_path = arg;
+            else sweep_traces.push_back(arg);
+        } else if (positional++ == 0 && synthetic_hours <= 0.0) {
+            trace_path = arg;
+        } else {
+            settings_path = arg;
+        }
+    }
+    usage |= !export_dir.empty() && alarm_counts.size() > 1;
+    usage |= (list_markers || window_to_s > 0.0) && (trace_path.empty() || synthetic_hours > 0.0);
+    usage |= !sweep_path.empty() && (sweep_traces.empty() || synthetic_hours > 0.0 || !export_dir.empty() || !alarm_counts.empty());
+    if (usage || (trace_path.empty() && synthetic_hours <= 0.0 && sweep_path.empty())) {
+        std::cerr << "Usage: lookout_replay <trace.qlpt|trace.qlpz> [settings.json] [--verbose] [--alarms N[,N...]] [--export DIR]\n"
+                     "                      [--window FROM_S:TO_S] [--markers]\n"
+                     "       lookout_replay --synthetic <hours> [settings.json] [--rate HZ] [--pattern sweep|flicks|mixed]\n"
+                     "                      [--drift DEG_PER_MIN] [--dropouts PER_HOUR] [--unmounts PER_HOUR] [--alarms N[,N...]]\n"
+                     "       lookout_replay --sweep <grid.json> [settings.json] <trace>... [--jobs N]"
+                  << std::endl;
+        return 2;
+    }
+    synthetic.duration_s = synthetic_hours * 3600.0;
+    clamp_synthetic_motion_config(synthetic);
+
+    PoseTraceSeeker seeker;
+    if ((list_markers || window_to_s > 0.0) && !seeker.open(trace_path)) {
+        std::cerr << "[ERROR] " << trace_path << " is not a readable pose trace" << std::endl;
+        return 1;
+    }
+    if (list_markers) {
+        for (const PoseTraceMarker& m : seeker.markers()) {
+            std::printf("%10.3f  %-12s", (m.t_us - seeker.first_t_us()) / 1e6, pose_trace_marker_name(m.type));
+            if (m.type == TRACE_MARK_WARNING || m.type == TRACE_MARK_LOOKOUT) std::printf(" alarm %u", m.value);
+            if (m.type == TRACE_MARK_DROPPED_FRAMES) std::printf(" %u frame(s)", m.value);
+            if (m.type == TRACE_MARK_ASW) std::printf(" %s", m.value ? "on" : "off");
+            std::printf("\n");
+        }
+        std::printf("%zu marker(s)\n", seeker.markers().size());
+        return 0;
+    }
+
+    std::ifstream settings_file(settings_path);
+    nlohmann::json settings = nlohmann::json::parse(settings_file, nullptr, false);
+    if (!settings_file || settings.is_discarded() || !settings.is_object()) {
+        std::cerr << "[ERROR] Could not read " << settings_path << std::endl;
+        return 1;
+    }
+    if (!sweep_path.empty()) {
+        std::ifstream grid_file(sweep_path);
+        nlohmann::json grid = nlohmann::json::parse(grid_file, nullptr, false);
+        if (grid.is_discarded() || !grid.is_object() || grid.empty()) {
+            std::cerr << "[ERROR] " << sweep_path << " must be an object of alarm fields to lists of values" << std::endl;
+            return 1;
+        }
+        return run_sweep(settings, grid, sweep_traces, jobs);
+    }
+
+    std::vector<PoseTraceRecord> records;
+    double read_s = 0.0;
+    if (window_to_s > 0.0) {
+        auto read_start = std::chrono::steady_clock::now();
+        const int64_t first_us = seeker.first_t_us();
+        if (!seeker.read_window(first_us + static_cast<int64_t>(window_from_s * 1e6),
+                                first_us + static_cast<int64_t>(window_to_s * 1e6), records)) {
+            std::cerr << "[ERROR] " << trace_path << " has a damaged block in that window" << std::endl;
+            return 1;
+        }
+        read_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - read_start).count();
+        if (records.empty()) {
+            std::cerr << "[ERROR] " << trace_path << " holds no samples in that window" << std::endl;
+            return 1;
+        }
+    } else if (synthetic_hours <= 0.0 && export_dir.empty()) {
+        auto read_start = std::chrono::steady_clock::now();
+        if (!read_trace(trace_path, records)) {
+            std::cerr << "[ERROR] " << trace_path << " is not a readable pose trace" << std::endl;
+            return 1;
+        }
+        read_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - read_start).count();
+        if (records.empty()) {
+            std::cerr << "[ERROR] " << trace_path << " holds no samples" << std::endl;
+            return 1;
+        }
+    }
+    const bool scaling = alarm_counts.size() > 1;
+    if (alarm_counts.empty()) alarm_counts.push_back(0);
+    if (scaling) std::printf("%8s %14s %10s %16s %12s\n", "alarms", "samples/s", "ns/sample", "ns/sample/alarm", "x real time");
+
+    for (size_t copies : alarm_counts) {
+        AlarmTable table;
+        try {
+            if (!build_alarm_table(settings, copies, table)) {
+                std::cerr << "[ERROR] No enabled alarms in " << settings_path << std::endl;
+                return 1;
+            }
+        } catch (const nlohmann::json::exception& e) {
+            std::cerr << "[ERROR] Bad alarm in " << settings_path << ": " << e.what() << std::endl;
+            return 1;
+        }
+        const size_t alarm_count = table.alarms.size();
+        ReplayResult result;
+        if (!export_dir.empty()) {
+            // Streamed through in one pass: memory stays at a batch of records and the column buffers
+            const auto export_start = std::chrono::steady_clock::now();
+            ColumnExport out;
+            if (!out.open(export_dir)) {
+                std::cerr << "[ERROR] Could not create the export in " << export_dir << std::endl;
+                return 1;
+            }
+            auto export_event = [&](int64_t t_us, const LookoutEvent& e) { out.add_event(t_us, e); };
+            if (synthetic_hours > 0.0) {
+                SyntheticFeed feed(synthetic);
+                ExportingFeed<SyntheticFeed> exporting(feed, out);
+                result = run_replay(std::move(table), settings, exporting, false, export_event);
+            } else if (!records.empty()) {
+                TraceFeed feed(records); // --window
+                ExportingFeed<TraceFeed> exporting(feed, out);
+                result = run_replay(std::move(table), settings, exporting, false, export_event);
+            } else {
+                TraceReader reader;
+                if (!reader.open(trace_path)) {
+                    std::cerr << "[ERROR] " << trace_path << " is not a readable pose trace" << std::endl;
+                    return 1;
+                }
+                StreamingTraceFeed feed(reader);
+                ExportingFeed<StreamingTraceFeed> exporting(feed, out);
+                result = run_replay(std::move(table), settings, exporting, false, export_event);
+                if (reader.failed()) std::cerr << "[WARNING] " << trace_path << " has a damaged block; exported up to it" << std::endl;
+            }
+            uint64_t events = 0;
+            for (uint64_t n : result.event_counts) events += n;
+            if (!out.close()) {
+                std::cerr << "[ERROR] Could not write the export in " << export_dir << std::endl;
+                return 1;
+            }
+            std::printf("Exported %llu samples (%.1f s of flight) and %llu events to %s in %.2f s\n",
+                        static_cast<unsigned long long>(result.samples), (result.last_t_us - result.first_t_us) / 1e6,
+                        static_cast<unsigned long long>(events), export_dir.c_str(),
+                        std::chrono::duration<double>(std::chrono::steady_clock::now() - export_start).count());
+            continue;
+        }
+        if (synthetic_hours > 0.0) {
+            SyntheticFeed feed(synthetic);
+            result = run_replay(std::move(table), settings, feed, !scaling);
+        } else {
+            TraceFeed feed(records);
+            result = run_replay(std::move(table), settings, feed, !scaling);
+        }
+        const double span_s = (result.last_t_us - result.first_t_us) / 1e6;
+        const double ns_per_sample = result.engine_s * 1e9 / (std::max)(result.evaluated, uint64_t(1));
+        if (scaling) {
+            std::printf("%8zu %14.0f %10.1f %16.2f %12.0f\n", alarm_count, result.evaluated / result.engine_s, ns_per_sample,
+                        ns_per_sample / alarm_count, span_s / result.engine_s);
+            continue;
+        }
+
+        for (const TimedEvent& timed : result.events) {
+            const LookoutEvent& e = timed.event;
+            if (e.type == LookoutEvent::DIRECTION_SEEN && !verbose) continue;
+            std::printf("%10.3f  %-18s alarm %u  value %lld\n", (timed.t_us - result.first_t_us) / 1e6,
+                        LookoutEvent::name(e.type), e.alarm, static_cast<long long>(e.value));
+        }
+        std::printf("\n%llu samples (%llu evaluated) over %.1f s of flight, %zu alarms\n",
+                    static_cast<unsigned long long>(result.samples), static_cast<unsigned long long>(result.evaluated),
+                    span_s, alarm_count);
+        for (size_t type = 0; type < result.event_counts.size(); ++type) {
+            if (result.event_counts[type]) {
+                std::printf("  %-18s %llu\n", LookoutEvent::name(static_cast<LookoutEvent::Type>(type)),
+                            static_cast<unsigned long long>(result.event_counts[type]));
+            }
+        }
+        if (synthetic_hours <= 0.0) std::printf("Read %.1f ms; ", read_s * 1e3);
+        std::printf("Evaluated in %.1f ms: %.0f samples/s, %.1f ns/sample, %.0fx real time\n", result.engine_s * 1e3,
+                    result.evaluated / result.engine_s, ns_per_sample, span_s / result.engine_s);
+    }
+    return 0;
+}
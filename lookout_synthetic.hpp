@@ -0,0 +1,181 @@
+// lookout_synthetic.hpp
+// Generated head motion for exercising the alarm engine without a headset: scan
+// patterns (sinusoidal sweeps, quick flicks, or a mix that also skips scans) with yaw
+// drift, tracking jitter, tracking dropouts and the headset taken off, all from a fixed
+// seed so a run is repeatable. Pure arithmetic, so it makes hours of motion a second;
+// lookout.exe's "synthetic" pose source and lookout_replay --synthetic both use it.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+
+enum SyntheticPattern {
+    SYNTHETIC_SWEEP,  // Yaw sweeps left and right once per period; pitch up and down twice
+    SYNTHETIC_FLICKS, // Straight ahead, with a quick flick left, right and up each period
+    SYNTHETIC_MIXED,  // Each period a sweep, flicks or no scan at all, picked from the seed
+};
+
+inline const char* synthetic_pattern_name(SyntheticPattern pattern) {
+    switch (pattern) {
+    case SYNTHETIC_FLICKS: return "flicks";
+    case SYNTHETIC_MIXED: return "mixed";
+    case SYNTHETIC_SWEEP:
+    default: return "sweep";
+    }
+}
+
+inline bool parse_synthetic_pattern(const std::string& name, SyntheticPattern& pattern) {
+    if (name == "sweep") pattern = SYNTHETIC_SWEEP;
+    else if (name == "flicks") pattern = SYNTHETIC_FLICKS;
+    else if (name == "mixed") pattern = SYNTHETIC_MIXED;
+    else return false;
+    return true;
+}
+
+struct SyntheticMotionConfig {
+    SyntheticPattern pattern = SYNTHETIC_SWEEP;
+    double rate_hz = 100.0;
+    double duration_s = 3600.0;
+    double scan_period_s = 20.0;     // One full left-right-up scan
+    double yaw_amplitude_deg = 80.0;
+    double pitch_amplitude_deg = 15.0;
+    double flick_s = 0.6;            // Out and back, for each flick
+    double noise_deg = 0.2;          // Tracking jitter added to every sample
+    double drift_deg_per_min = 0.0;  // Yaw drift of the tracking reference
+    double dropouts_per_hour = 0.0;  // Tracking losses (samples keep coming, not tracked)
+    double dropout_s = 1.0;
+    double unmounts_per_hour = 0.0;  // Headset off: one untracked sample a second
+    double unmount_s = 30.0;
+    uint32_t seed = 12345;
+};
+
+// Keeps a hand-edited config to what the generator can run
+inline void clamp_synthetic_motion_config(SyntheticMotionConfig& c) {
+    c.rate_hz = (std::max)(1.0, (std::min)(10000.0, c.rate_hz));
+    c.duration_s = (std::max)(0.0, c.duration_s);
+    c.scan_period_s = (std::max)(1.0, c.scan_period_s);
+    c.flick_s = (std::max)(0.05, (std::min)(c.scan_period_s / 3.0, c.flick_s));
+    c.noise_deg = (std::max)(0.0, c.noise_deg);
+    c.dropouts_per_hour = (std::max)(0.0, c.dropouts_per_hour);
+    c.dropout_s = (std::max)(0.0, c.dropout_s);
+    c.unmounts_per_hour = (std::max)(0.0, c.unmounts_per_hour);
+    c.unmount_s = (std::max)(0.0, c.unmount_s);
+}
+
+// One generated pose, angles relative to the pilot's reference
+struct SyntheticPose {
+    int64_t t_us = 0;
+    double yaw_deg = 0.0, pitch_deg = 0.0;
+    double yaw_rate_deg_s = 0.0, pitch_rate_deg_s = 0.0;
+    bool tracked = true;             // False inside a dropout or while the headset is off
+};
+
+class SyntheticHeadMotion {
+public:
+    explicit SyntheticHeadMotion(const SyntheticMotionConfig& config)
+        : config_(config), period_us_(static_cast<int64_t>(1e6 / config.rate_hz)),
+          end_us_(static_cast<int64_t>(config.duration_s * 1e6)), rng_(config.seed) {
+        next_dropout_us_ = next_interruption(config_.dropouts_per_hour);
+        next_unmount_us_ = next_interruption(config_.unmounts_per_hour);
+    }
+
+    const SyntheticMotionConfig& config() const { return config_; }
+
+    // Samples in the whole run, not counting the sparser ones while the headset is off
+    uint64_t nominal_samples() const { return static_cast<uint64_t>(end_us_ / period_us_); }
+
+    // False once the duration is used up
+    bool next(SyntheticPose& pose) {
+        if (t_us_ >= end_us_) return false;
+        pose = SyntheticPose();
+        pose.t_us = t_us_;
+        if (t_us_ >= next_unmount_us_) {
+            unmounted_until_us_ = t_us_ + static_cast<int64_t>(config_.unmount_s * 1e6);
+            next_unmount_us_ = unmounted_until_us_ + next_interruption(config_.unmounts_per_hour);
+        }
+        if (t_us_ < unmounted_until_us_) {
+            pose.tracked = false;
+            t_us_ += 1000000; // As the sampler's idle poll while the headset is off
+            return true;
+        }
+        if (t_us_ >= next_dropout_us_) {
+            dropout_until_us_ = t_us_ + static_cast<int64_t>(config_.dropout_s * 1e6);
+            next_dropout_us_ = dropout_until_us_ + next_interruption(config_.dropouts_per_hour);
+        }
+        pose.tracked = t_us_ >= dropout_until_us_;
+
+        const double t = t_us_ / 1e6;
+        constexpr double kRateStep = 1e-3; // Rates by central difference
+        double yaw_before, pitch_before, yaw_after, pitch_after;
+        angles(t, pose.yaw_deg, pose.pitch_deg);
+        angles(t - kRateStep, yaw_before, pitch_before);
+        angles(t + kRateStep, yaw_after, pitch_after);
+        pose.yaw_rate_deg_s = (yaw_after - yaw_before) / (2.0 * kRateStep);
+        pose.pitch_rate_deg_s = (pitch_after - pitch_before) / (2.0 * kRateStep);
+        pose.yaw_deg = std::remainder(pose.yaw_deg + config_.noise_deg * noise_(rng_), 360.0);
+        pose.pitch_deg = (std::max)(-89.0, (std::min)(89.0, pose.pitch_deg + config_.noise_deg * noise_(rng_)));
+        t_us_ += period_us_;
+        return true;
+    }
+
+private:
+    // Deterministic in t (no generator state), so rates can be differenced
+    void angles(double t, double& yaw_deg, double& pitch_deg) const {
+        const double period = config_.scan_period_s;
+        const double phase = std::fmod(t, period) / period; // 0..1 through this period
+        SyntheticPattern pattern = config_.pattern;
+        bool scanning = true;
+        if (pattern == SYNTHETIC_MIXED) {
+            const uint64_t choice = mix(config_.seed + static_cast<uint64_t>(t / period)) % 3;
+            pattern = choice == 1 ? SYNTHETIC_FLICKS : SYNTHETIC_SWEEP;
+            scanning = choice != 2;
+        }
+        yaw_deg = pitch_deg = 0.0;
+        if (scanning && pattern == SYNTHETIC_SWEEP) {
+            const double omega_t = 2.0 * 3.14159265358979323846 * phase;
+            yaw_deg = config_.yaw_amplitude_deg * std::sin(omega_t);
+            pitch_deg = config_.pitch_amplitude_deg * std::sin(2.0 * omega_t);
+        } else if (scanning) {
+            // Left at the start of the period, right a third in, up two thirds in
+            const double flick = config_.flick_s / period;
+            yaw_deg = config_.yaw_amplitude_deg * (bump(phase, 0.0, flick) - bump(phase, 1.0 / 3.0, flick));
+            pitch_deg = config_.pitch_amplitude_deg * bump(phase, 2.0 / 3.0, flick);
+        }
+        yaw_deg += config_.drift_deg_per_min * t / 60.0;
+    }
+
+    // 0 -> 1 -> 0 over [start, start + width): sin^2, smooth at both ends
+    static double bump(double phase, double start, double width) {
+        const double u = (phase - start) / width;
+        if (u <= 0.0 || u >= 1.0) return 0.0;
+        const double s = std::sin(3.14159265358979323846 * u);
+        return s * s;
+    }
+
+    static uint64_t mix(uint64_t x) { // splitmix64
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    // Time to the next interruption, at per_hour on average
+    int64_t next_interruption(double per_hour) {
+        if (per_hour <= 0.0) return INT64_MAX;
+        std::exponential_distribution<double> gap(per_hour / 3600.0);
+        return static_cast<int64_t>(gap(rng_) * 1e6);
+    }
+
+    const SyntheticMotionConfig config_;
+    const int64_t period_us_;
+    const int64_t end_us_;
+    int64_t t_us_ = 0;
+    int64_t next_dropout_us_ = INT64_MAX, dropout_until_us_ = 0;
+    int64_t next_unmount_us_ = INT64_MAX, unmounted_until_us_ = 0;
+    std::mt19937 rng_;
+    std::normal_distribution<double> noise_{0.0, 1.0};
+};
@@ -0,0 +1,224 @@
+// lookout_telemetry.hpp
+// Layout of the scan-state block lookout.exe publishes in shared memory (named file
+// mapping, telemetry.name in settings.json, default "Local\QuestLookoutTelemetry"),
+// for overlays and instructor displays. Fixed-size fields only, so it can be read from
+// any language; readers check magic and version, then copy it out with
+// read_lookout_telemetry() (or the same seqlock steps) to get a consistent snapshot.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+constexpr uint32_t LOOKOUT_TELEMETRY_MAGIC = 0x4D544C51; // "QLTM"
+constexpr uint16_t LOOKOUT_TELEMETRY_VERSION = 1;
+constexpr uint32_t LOOKOUT_TELEMETRY_MAX_ALARMS = 32;
+
+// LookoutTelemetry::flags
+enum LookoutTelemetryFlags : uint32_t {
+    TELEMETRY_HMD_OK = 1u << 0,        // Alarms running on a tracked, mounted headset
+    TELEMETRY_FLIGHT_ACTIVE = 1u << 1, // Sim flight detected (always set for replay/synthetic sources)
+};
+
+// One alarm of the active profile
+struct LookoutTelemetryAlarm {
+    uint32_t id;              // Index into settings.json "alarms"
+    uint8_t seen;             // Directions seen this no-look period, one bit per LookoutDirection
+    uint8_t required;         // Directions a lookout needs, same bits
+    uint8_t warning;          // 1 while the warning is active
+    uint8_t silenced;         // 1 inside a silence window after a look
+    float no_look_s;          // Time since the last lookout
+    float until_due_s;        // Time left before it warns; 0 once warning
+    float max_time_s;
+    uint32_t warnings;        // Since startup
+    uint32_t lookouts;
+    uint32_t reserved;
+};
+static_assert(sizeof(LookoutTelemetryAlarm) == 32, "LookoutTelemetryAlarm layout is part of the version");
+
+struct LookoutTelemetry {
+    uint32_t magic;           // LOOKOUT_TELEMETRY_MAGIC once published
+    uint16_t version;         // LOOKOUT_TELEMETRY_VERSION
+    uint16_t size;            // sizeof(LookoutTelemetry)
+    uint32_t sequence;        // Seqlock: odd while an update is being written
+    uint32_t flags;           // LookoutTelemetryFlags
+    int64_t engine_us;        // Engine clock of this update
+    uint64_t ticks;           // Samples evaluated since startup
+    float sample_rate_hz;     // Smoothed evaluation rate
+    float yaw_deg;            // Positive left of the recenter direction
+    float pitch_deg;          // Positive up
+    float lean_lateral_cm;    // Positive left; 0 without position tracking
+    float lean_vertical_cm;
+    uint32_t active_profile;  // Index into settings.json "alarm_profiles"
+    uint32_t alarm_count;     // Entries of alarms in use
+    uint32_t reserved;
+    LookoutTelemetryAlarm alarms[LOOKOUT_TELEMETRY_MAX_ALARMS];
+};
+static_assert(sizeof(LookoutTelemetry) == 64 + 32 * LOOKOUT_TELEMETRY_MAX_ALARMS, "LookoutTelemetry layout is part of the version");
+
+// Copy a consistent snapshot out of the shared block: retries while the writer is
+// mid-update, false after max_attempts or if the block isn't a known version
+inline bool read_lookout_telemetry(const LookoutTelemetry* shared, LookoutTelemetry& out, int max_attempts = 100) {
+    const auto* sequence = reinterpret_cast<const std::atomic<uint32_t>*>(&shared->sequence);
+    for (int attempt = 0; attempt < max_attempts; ++attempt) {
+        uint32_t before = sequence->load(std::memory_order_acquire);
+        if (before & 1) continue;
+        std::memcpy(&out, shared, sizeof(out));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence->load(std::memory_order_relaxed) != before) continue;
+        return out.magic == LOOKOUT_TELEMETRY_MAGIC && out.version == LOOKOUT_TELEMETRY_VERSION;
+    }
+    return false;
+}
+
+// UDP stream ("udp_stream" in settings.json): each datagram is a LookoutStreamHeader,
+// sample_count LookoutStreamSample (oldest first) and alarm_count LookoutStreamAlarm
+// (state at the newest sample), packed back to back, little-endian.
+constexpr uint32_t LOOKOUT_STREAM_MAGIC = 0x53554C51; // "QLUS"
+constexpr uint16_t LOOKOUT_STREAM_VERSION = 1;
+
+struct LookoutStreamHeader {
+    uint32_t magic;           // LOOKOUT_STREAM_MAGIC
+    uint16_t version;         // LOOKOUT_STREAM_VERSION
+    uint8_t sample_count;
+    uint8_t alarm_count;
+    uint32_t sequence;        // Datagram counter, to spot losses
+    uint32_t flags;           // LookoutTelemetryFlags
+};
+static_assert(sizeof(LookoutStreamHeader) == 16, "LookoutStreamHeader layout is part of the version");
+
+struct LookoutStreamSample {
+    int64_t engine_us;
+    int16_t yaw_cdeg;         // Centidegrees
+    int16_t pitch_cdeg;
+    int16_t lean_lateral_mm;
+    int16_t lean_vertical_mm;
+};
+static_assert(sizeof(LookoutStreamSample) == 16, "LookoutStreamSample layout is part of the version");
+
+struct LookoutStreamAlarm {
+    uint16_t id;
+    uint8_t seen;             // As LookoutTelemetryAlarm::seen
+    uint8_t state;            // Bit 0 warning, bit 1 silenced
+    uint16_t no_look_ds;      // Deciseconds, saturating
+    uint16_t until_due_ds;
+};
+static_assert(sizeof(LookoutStreamAlarm) == 8, "LookoutStreamAlarm layout is part of the version");
+
+// Fleet protocol ("fleet" in settings.json, lookout_hub): a hub broadcasts
+// FLEET_ANNOUNCE to LOOKOUT_FLEET_DISCOVERY_PORT every couple of seconds; a station
+// that hears one answers with FLEET_HELLO and from then on sends that hub its alarm
+// events in batches (FLEET_EVENTS), one FLEET_STATS a minute and, if enabled, a few
+// subsampled poses (FLEET_POSE, LookoutStreamSample entries). Each datagram is a
+// LookoutFleetHeader and `count` entries of its type's payload, little-endian. A
+// station at a pose a second stays well under a kilobit per second.
+// A hub can also push a settings.json snapshot: FLEET_SETTINGS chunks, resent until the
+// station answers FLEET_SETTINGS_ACK or reports the snapshot's hash in its hello.
+constexpr uint32_t LOOKOUT_FLEET_MAGIC = 0x4C464C51; // "QLFL"
+constexpr uint16_t LOOKOUT_FLEET_VERSION = 1;
+constexpr uint16_t LOOKOUT_FLEET_DISCOVERY_PORT = 55300;
+
+enum LookoutFleetType : uint8_t {
+    FLEET_ANNOUNCE = 1, // Hub -> broadcast: one LookoutFleetAnnounce
+    FLEET_HELLO,        // Station -> hub: one LookoutFleetHello, on discovery and with every FLEET_STATS
+    FLEET_EVENTS,       // Station -> hub: LookoutFleetEvent entries, oldest first
+    FLEET_STATS,        // Station -> hub: one LookoutFleetStats per finished minute
+    FLEET_POSE,         // Station -> hub: LookoutStreamSample entries, oldest first
+    FLEET_SETTINGS,     // Hub -> station: one LookoutFleetSettingsChunk, then its bytes
+    FLEET_SETTINGS_ACK, // Station -> hub: one LookoutFleetSettingsAck per complete snapshot
+};
+
+struct LookoutFleetHeader {
+    uint32_t magic;           // LOOKOUT_FLEET_MAGIC
+    uint16_t version;         // LOOKOUT_FLEET_VERSION
+    uint8_t type;             // LookoutFleetType
+    uint8_t count;            // Payload entries
+    uint32_t sender_id;       // Random per process: a new value means the sender restarted
+    uint32_t sequence;        // Per sender, to spot losses
+};
+static_assert(sizeof(LookoutFleetHeader) == 16, "LookoutFleetHeader layout is part of the version");
+
+struct LookoutFleetAnnounce {
+    uint16_t port;            // UDP port on the hub for station traffic
+    uint16_t interval_ds;     // Deciseconds to the next announcement
+    uint32_t reserved;
+};
+static_assert(sizeof(LookoutFleetAnnounce) == 8, "LookoutFleetAnnounce layout is part of the version");
+
+struct LookoutFleetHello {
+    char name[32];            // Station name, NUL-padded
+    uint32_t flags;           // LookoutTelemetryFlags
+    uint16_t alarm_count;     // Alarms in the active profile
+    uint16_t active_profile;  // Index into settings.json "alarm_profiles"
+    uint32_t config_version;  // Last snapshot applied from a hub; 0 for none
+    uint32_t config_hash;     // lookout_fleet_hash() of the station's settings.json
+};
+static_assert(sizeof(LookoutFleetHello) == 48, "LookoutFleetHello layout is part of the version");
+
+enum LookoutFleetEventType : uint8_t {
+    FLEET_EVENT_WARNING = 1,  // An alarm started warning
+    FLEET_EVENT_LOOKOUT,      // An alarm's lookout; value_ms: time since its previous one
+    FLEET_EVENT_FLIGHT_START,
+    FLEET_EVENT_FLIGHT_END,
+};
+
+struct LookoutFleetEvent {
+    uint32_t t_ms;            // Station's engine clock
+    uint16_t alarm;           // settings.json alarm id; 0 for flight events
+    uint8_t type;             // LookoutFleetEventType
+    uint8_t reserved;
+    uint32_t value_ms;
+};
+static_assert(sizeof(LookoutFleetEvent) == 12, "LookoutFleetEvent layout is part of the version");
+
+struct LookoutFleetStats {
+    uint32_t minute;          // Minutes since the station started
+    uint32_t samples;         // Samples evaluated or dropped for the HMD
+    uint32_t hmd_ok_samples;
+    uint32_t warning_samples; // With at least one alarm warning
+    uint16_t warnings;        // Started this minute
+    uint16_t lookouts;
+    uint32_t scan_interval_ms; // Sum of the value_ms of this minute's lookouts
+};
+static_assert(sizeof(LookoutFleetStats) == 24, "LookoutFleetStats layout is part of the version");
+
+// Snapshot chunks are at most this many bytes, to stay inside one Ethernet frame
+constexpr uint32_t LOOKOUT_FLEET_CHUNK_BYTES = 1024;
+constexpr uint32_t LOOKOUT_FLEET_MAX_SETTINGS_BYTES = 1u << 20;
+
+struct LookoutFleetSettingsChunk {
+    uint32_t version;         // Snapshot version, rising with each change on the hub
+    uint32_t hash;            // lookout_fleet_hash() of the whole snapshot
+    uint32_t total_bytes;
+    uint32_t offset;          // Of this chunk's bytes, which follow the struct
+    uint16_t bytes;
+    uint16_t reserved;
+    uint32_t reserved2;
+};
+static_assert(sizeof(LookoutFleetSettingsChunk) == 24, "LookoutFleetSettingsChunk layout is part of the version");
+
+enum LookoutFleetSettingsStatus : uint8_t {
+    FLEET_SETTINGS_APPLIED = 0, // Saved as settings.json and hot-reloaded
+    FLEET_SETTINGS_REJECTED,    // Didn't parse or validate; the station keeps its settings
+};
+
+struct LookoutFleetSettingsAck {
+    uint32_t version;
+    uint32_t hash;            // The station's config hash after handling it
+    uint8_t status;           // LookoutFleetSettingsStatus
+    uint8_t reserved[3];
+    uint32_t reserved2;
+};
+static_assert(sizeof(LookoutFleetSettingsAck) == 16, "LookoutFleetSettingsAck layout is part of the version");
+
+// Config hash of a settings.json: 32-bit FNV-1a of its bytes
+inline uint32_t lookout_fleet_hash(const void* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
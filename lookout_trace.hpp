@@ -0,0 +1,681 @@
+// lookout_trace.hpp
+// On-disk layout of pose traces ("pose_trace" in settings.json): every headset sample
+// the sampler read, as the runtime reported it, for tuning thresholds and reproducing
+// missed lookouts offline. Fixed-size little-endian records after a header, so a
+// reader can map the file and index it directly. Finished traces are archived in the
+// compressed pose archive format further down. Both formats end with event markers
+// (warnings, lookouts, flight start and end), and PoseTraceSeeker at the bottom reads
+// any window of either through a memory map without decoding what comes before.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+constexpr uint32_t POSE_TRACE_MAGIC = 0x54504C51; // "QLPT"
+constexpr uint16_t POSE_TRACE_VERSION = 1;
+
+// PoseSample::flags, recorded in PoseTraceRecord::pose_flags
+enum PoseSampleFlags : uint32_t {
+    POSE_HMD_OK = 1u << 0,       // Tracked, mounted and display present: alarms may accrue
+    POSE_SESSION_LOST = 1u << 1, // Session failed and couldn't be recreated
+    POSE_RECENTERED = 1u << 2,   // First sample against a new reference transform
+    POSE_EYE_GAZE = 1u << 3      // Look direction is head x eye gaze, not the head alone
+};
+
+// PoseTraceRecord::session_flags
+enum PoseTraceSessionFlags : uint32_t {
+    TRACE_HMD_PRESENT = 1u << 0,
+    TRACE_HMD_MOUNTED = 1u << 1,
+    TRACE_DISPLAY_LOST = 1u << 2,
+    TRACE_SHOULD_RECENTER = 1u << 3,
+    TRACE_OPENXR = 1u << 4,       // From the OpenXR pose source: status_flags hold XrSpaceLocationFlags
+};
+
+struct PoseTraceHeader {
+    uint32_t magic;               // POSE_TRACE_MAGIC
+    uint16_t version;             // POSE_TRACE_VERSION
+    uint16_t record_size;         // sizeof(PoseTraceRecord)
+    uint64_t record_count;        // Written when the trace is closed; 0 if it never was (count the records until t_us is 0)
+    int64_t start_unix_s;         // Wall clock when recording started
+    int64_t start_us;             // Core clock at that moment
+    uint64_t marker_count;        // PoseTraceMarkers right after the last record
+    uint8_t reserved[24];
+};
+static_assert(sizeof(PoseTraceHeader) == 64, "PoseTraceHeader layout is part of the version");
+
+struct PoseTraceRecord {
+    int64_t t_us;                 // Core clock (sensor time when sampling.measured_pose)
+    float orientation[4];         // Tracking-space quaternion x, y, z, w, before any recenter
+    float position[3];            // Meters, tracking space
+    float angular_velocity[3];    // rad/s, tracking space
+    uint32_t status_flags;        // ovrStatusBits of the tracking state
+    uint32_t session_flags;       // PoseTraceSessionFlags
+    uint32_t pose_flags;          // PoseSampleFlags the sample was published with
+    uint8_t reserved[4];
+};
+static_assert(sizeof(PoseTraceRecord) == 64, "PoseTraceRecord layout is part of the version");
+
+enum PoseTraceMarkerType : uint16_t {
+    TRACE_MARK_WARNING = 1,       // value: alarm id
+    TRACE_MARK_LOOKOUT,           // value: alarm id
+    TRACE_MARK_FLIGHT_START,
+    TRACE_MARK_FLIGHT_END,
+    TRACE_MARK_DROPPED_FRAMES,    // value: compositor frames dropped since the previous perf poll
+    TRACE_MARK_ASW,               // value: 1 when ASW engaged, 0 when it let go
+};
+
+// Where something happened in the trace, on the records' clock
+struct PoseTraceMarker {
+    int64_t t_us;
+    uint16_t type;                // PoseTraceMarkerType
+    uint16_t reserved;
+    uint32_t value;
+};
+static_assert(sizeof(PoseTraceMarker) == 16, "PoseTraceMarker layout is part of the version");
+
+inline const char* pose_trace_marker_name(uint16_t type) {
+    switch (type) {
+    case TRACE_MARK_WARNING: return "warning";
+    case TRACE_MARK_LOOKOUT: return "lookout";
+    case TRACE_MARK_FLIGHT_START: return "flight_start";
+    case TRACE_MARK_FLIGHT_END: return "flight_end";
+    case TRACE_MARK_DROPPED_FRAMES: return "dropped_frames";
+    case TRACE_MARK_ASW: return "asw";
+    default: return "unknown";
+    }
+}
+
+// Pose archives (.qlpz): the same records quantized and compressed for keeping, at a
+// few bytes per sample. Records are grouped in blocks that decode independently:
+//
+//   PoseArchiveHeader | block 0 | block 1 | ... | PoseArchiveIndexEntry x block_count
+//
+// Each block is a PoseArchiveBlock followed by compressed_size bytes in the LZ4 block
+// format, which expand to raw_size bytes of columns, one value per record each:
+//
+//   t_us           zigzag varint delta from the previous record (the first from first_t_us)
+//   orientation    largest-component index byte, then three columns of the other
+//                  components at 16 bits ("smallest three", sign chosen so the largest
+//                  is positive), each a zigzag varint residual of a linear prediction
+//                  from the two records before
+//   position       three columns in 0.1 mm, residuals predicted the same way
+//   angular_vel    three columns in mrad/s, zigzag varint delta from the record before
+//   status_flags, session_flags, pose_flags   three columns of varints
+//
+// The index at index_offset gives each block's file offset and first timestamp, so a
+// reader can seek to a time without reading what comes before it; the trace's markers
+// follow it. Archives written before markers existed have marker_count 0.
+constexpr uint32_t POSE_ARCHIVE_MAGIC = 0x5A504C51; // "QLPZ"
+constexpr uint16_t POSE_ARCHIVE_VERSION = 1;
+constexpr uint32_t POSE_ARCHIVE_BLOCK_RECORDS = 4096; // About 40 s at 100 Hz
+constexpr uint32_t POSE_ARCHIVE_MAX_BLOCK_RECORDS = 65536; // Larger blocks aren't read
+// Most raw column bytes the encoder writes for one record: a 10-byte time delta, the
+// largest index, three 3-byte orientation residuals, then nine 5-byte columns (position,
+// angular velocity, flags)
+constexpr size_t POSE_ARCHIVE_MAX_RECORD_BYTES = 10 + 1 + 3 * 3 + 9 * 5;
+
+struct PoseArchiveHeader {
+    uint32_t magic;               // POSE_ARCHIVE_MAGIC
+    uint16_t version;             // POSE_ARCHIVE_VERSION
+    uint16_t reserved0;
+    uint32_t block_records;       // Records per block; the last may hold fewer
+    uint32_t block_count;
+    uint64_t record_count;
+    uint64_t index_offset;        // 0 if the archive was never finished
+    int64_t start_unix_s;         // As PoseTraceHeader
+    int64_t start_us;
+    uint64_t marker_offset;       // PoseTraceMarker x marker_count, after the index
+    uint64_t marker_count;
+};
+static_assert(sizeof(PoseArchiveHeader) == 64, "PoseArchiveHeader layout is part of the version");
+
+struct PoseArchiveBlock {
+    uint32_t compressed_size;
+    uint32_t raw_size;
+    uint32_t record_count;
+    uint32_t reserved;
+    int64_t first_t_us;
+};
+static_assert(sizeof(PoseArchiveBlock) == 24, "PoseArchiveBlock layout is part of the version");
+
+struct PoseArchiveIndexEntry {
+    uint64_t offset;              // Of the block's PoseArchiveBlock
+    int64_t first_t_us;
+    uint64_t first_record;
+};
+static_assert(sizeof(PoseArchiveIndexEntry) == 24, "PoseArchiveIndexEntry layout is part of the version");
+
+// LZ4 block format codec: greedy single-probe matching, which is what keeps it fast.
+// Any LZ4 decoder reads its output.
+inline size_t pose_archive_lz_bound(size_t size) { return size + size / 255 + 16; }
+
+inline size_t pose_archive_lz_compress(const uint8_t* src, size_t size, uint8_t* dst) {
+    constexpr int kHashBits = 12;
+    constexpr size_t kMinMatch = 4;
+    std::vector<uint32_t> table(size_t(1) << kHashBits, 0);
+    uint8_t* out = dst;
+    auto read32 = [](const uint8_t* p) { uint32_t v; std::memcpy(&v, p, sizeof(v)); return v; };
+    auto write_length = [&out](size_t length) {
+        for (; length >= 255; length -= 255) *out++ = 255;
+        *out++ = static_cast<uint8_t>(length);
+    };
+    auto emit_literals = [&](uint8_t token_low, const uint8_t* literals, size_t count) {
+        *out++ = static_cast<uint8_t>(((count >= 15 ? 15 : count) << 4) | token_low);
+        if (count >= 15) write_length(count - 15);
+        std::memcpy(out, literals, count);
+        out += count;
+    };
+    // The format wants the last match to start 12 bytes before the end and the last 5 bytes literal
+    const size_t match_limit = size > 12 ? size - 12 : 0;
+    size_t anchor = 0, i = 0;
+    while (i < match_limit) {
+        const uint32_t sequence = read32(src + i);
+        const uint32_t hash = (sequence * 2654435761u) >> (32 - kHashBits);
+        const size_t candidate = table[hash];
+        table[hash] = static_cast<uint32_t>(i);
+        if (candidate >= i || i - candidate > 65535 || read32(src + candidate) != sequence) {
+            ++i;
+            continue;
+        }
+        size_t length = kMinMatch;
+        const size_t max_length = size - 5 - i;
+        while (length < max_length && src[candidate + length] == src[i + length]) ++length;
+        const size_t match_code = length - kMinMatch;
+        emit_literals(static_cast<uint8_t>(match_code >= 15 ? 15 : match_code), src + anchor, i - anchor);
+        const size_t offset = i - candidate;
+        *out++ = static_cast<uint8_t>(offset);
+        *out++ = static_cast<uint8_t>(offset >> 8);
+        if (match_code >= 15) write_length(match_code - 15);
+        i += length;
+        anchor = i;
+    }
+    emit_literals(0, src + anchor, size - anchor);
+    return static_cast<size_t>(out - dst);
+}
+
+// False on input that doesn't expand to exactly raw_size bytes
+inline bool pose_archive_lz_decompress(const uint8_t* src, size_t size, uint8_t* dst, size_t raw_size) {
+    size_t in = 0, out = 0;
+    auto read_length = [&](size_t& length) {
+        uint8_t b;
+        do {
+            if (in >= size) return false;
+            b = src[in++];
+            length += b;
+        } while (b == 255);
+        return true;
+    };
+    while (in < size) {
+        const uint8_t token = src[in++];
+        size_t literals = token >> 4;
+        if (literals == 15 && !read_length(literals)) return false;
+        if (literals > size - in || literals > raw_size - out) return false;
+        std::memcpy(dst + out, src + in, literals);
+        in += literals;
+        out += literals;
+        if (in == size) break; // The last sequence has no match
+        if (size - in < 2) return false;
+        const size_t offset = src[in] | (static_cast<size_t>(src[in + 1]) << 8);
+        in += 2;
+        size_t length = token & 15;
+        if (length == 15 && !read_length(length)) return false;
+        length += 4;
+        if (offset == 0 || offset > out || length > raw_size - out) return false;
+        const uint8_t* match = dst + out - offset;
+        if (offset >= length) {
+            std::memcpy(dst + out, match, length);
+        } else {
+            for (size_t k = 0; k < length; ++k) dst[out + k] = match[k]; // Overlapping: repeats the last offset bytes
+        }
+        out += length;
+    }
+    return out == raw_size;
+}
+
+inline void pose_archive_put_varint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+inline void pose_archive_put_signed(std::vector<uint8_t>& out, int64_t v) {
+    pose_archive_put_varint(out, (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+}
+
+inline bool pose_archive_get_varint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        const uint8_t b = *p++;
+        v |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+inline bool pose_archive_get_signed(const uint8_t*& p, const uint8_t* end, int64_t& v) {
+    uint64_t z;
+    if (!pose_archive_get_varint(p, end, z)) return false;
+    v = static_cast<int64_t>(z >> 1) ^ -static_cast<int64_t>(z & 1);
+    return true;
+}
+
+constexpr double POSE_ARCHIVE_QUAT_SCALE = 32767.0 * 1.41421356237309505; // Smallest three lie within +-1/sqrt(2)
+constexpr double POSE_ARCHIVE_POSITION_SCALE = 10000.0;                // 0.1 mm
+constexpr double POSE_ARCHIVE_VELOCITY_SCALE = 1000.0;                 // mrad/s
+
+// Quantized values of one record, as the columns hold them
+struct PoseArchiveQuantized {
+    uint8_t largest;              // Index of the orientation component left out
+    int32_t orientation[3];
+    int32_t position[3];
+    int32_t angular_velocity[3];
+};
+
+inline int32_t pose_archive_quantize(double v, double scale, double limit) {
+    v = v * scale;
+    if (!(v > -limit)) v = -limit; // NaN too
+    if (v > limit) v = limit;
+    return static_cast<int32_t>(std::lround(v));
+}
+
+inline PoseArchiveQuantized pose_archive_quantize(const PoseTraceRecord& r) {
+    PoseArchiveQuantized q = {};
+    const float* o = r.orientation;
+    for (uint8_t k = 1; k < 4; ++k) {
+        if (std::fabs(o[k]) > std::fabs(o[q.largest])) q.largest = k;
+    }
+    const double norm = std::sqrt(double(o[0]) * o[0] + double(o[1]) * o[1] + double(o[2]) * o[2] + double(o[3]) * o[3]);
+    // q and -q are the same rotation; an untracked (zero) orientation stores as identity
+    const double sign = norm > 0.0 ? (o[q.largest] < 0.0f ? -1.0 : 1.0) / norm : 0.0;
+    for (int k = 0, c = 0; k < 4; ++k) {
+        if (k != q.largest) q.orientation[c++] = pose_archive_quantize(o[k] * sign, POSE_ARCHIVE_QUAT_SCALE, 32767.0);
+    }
+    for (int k = 0; k < 3; ++k) {
+        q.position[k] = pose_archive_quantize(r.position[k], POSE_ARCHIVE_POSITION_SCALE, 2e9);
+        q.angular_velocity[k] = pose_archive_quantize(r.angular_velocity[k], POSE_ARCHIVE_VELOCITY_SCALE, 2e9);
+    }
+    return q;
+}
+
+// Appends a block's raw (uncompressed) columns for records [0, count)
+inline void pose_archive_encode_block(const PoseTraceRecord* records, size_t count, std::vector<uint8_t>& out) {
+    std::vector<PoseArchiveQuantized> q(count);
+    for (size_t i = 0; i < count; ++i) q[i] = pose_archive_quantize(records[i]);
+    for (size_t i = 0; i < count; ++i) pose_archive_put_signed(out, i ? records[i].t_us - records[i - 1].t_us : 0);
+    for (size_t i = 0; i < count; ++i) out.push_back(q[i].largest);
+    // Second-order prediction: p[i] = 2 v[i-1] - v[i-2], so steady turns cost a byte
+    auto predicted_column = [&](auto field, int c) {
+        for (size_t i = 0; i < count; ++i) {
+            int64_t prediction = i >= 2 ? 2 * int64_t(field(q[i - 1])[c]) - field(q[i - 2])[c] : i ? field(q[i - 1])[c] : 0;
+            pose_archive_put_signed(out, field(q[i])[c] - prediction);
+        }
+    };
+    for (int c = 0; c < 3; ++c) predicted_column([](const PoseArchiveQuantized& v) { return v.orientation; }, c);
+    for (int c = 0; c < 3; ++c) predicted_column([](const PoseArchiveQuantized& v) { return v.position; }, c);
+    for (int c = 0; c < 3; ++c) {
+        for (size_t i = 0; i < count; ++i) {
+            pose_archive_put_signed(out, int64_t(q[i].angular_velocity[c]) - (i ? q[i - 1].angular_velocity[c] : 0));
+        }
+    }
+    for (size_t i = 0; i < count; ++i) pose_archive_put_varint(out, records[i].status_flags);
+    for (size_t i = 0; i < count; ++i) pose_archive_put_varint(out, records[i].session_flags);
+    for (size_t i = 0; i < count; ++i) pose_archive_put_varint(out, records[i].pose_flags);
+}
+
+// Inverse of pose_archive_encode_block; false if the columns are short or malformed
+inline bool pose_archive_decode_block(const uint8_t* raw, size_t size, size_t count, int64_t first_t_us, PoseTraceRecord* out) {
+    const uint8_t* p = raw;
+    const uint8_t* end = raw + size;
+    std::memset(out, 0, count * sizeof(PoseTraceRecord));
+    int64_t v = 0, t_us = first_t_us;
+    for (size_t i = 0; i < count; ++i) {
+        if (!pose_archive_get_signed(p, end, v)) return false;
+        t_us += v;
+        out[i].t_us = t_us;
+    }
+    if (static_cast<size_t>(end - p) < count) return false;
+    std::vector<PoseArchiveQuantized> q(count);
+    for (size_t i = 0; i < count; ++i) {
+        q[i].largest = *p++ & 3;
+    }
+    auto predicted_column = [&](auto field, int c) {
+        for (size_t i = 0; i < count; ++i) {
+            int64_t prediction = i >= 2 ? 2 * int64_t(field(q[i - 1])[c]) - field(q[i - 2])[c] : i ? field(q[i - 1])[c] : 0;
+            if (!pose_archive_get_signed(p, end, v)) return false;
+            field(q[i])[c] = static_cast<int32_t>(prediction + v);
+        }
+        return true;
+    };
+    for (int c = 0; c < 3; ++c) {
+        if (!predicted_column([](PoseArchiveQuantized& x) { return x.orientation; }, c)) return false;
+    }
+    for (int c = 0; c < 3; ++c) {
+        if (!predicted_column([](PoseArchiveQuantized& x) { return x.position; }, c)) return false;
+    }
+    for (int c = 0; c < 3; ++c) {
+        for (size_t i = 0; i < count; ++i) {
+            if (!pose_archive_get_signed(p, end, v)) return false;
+            q[i].angular_velocity[c] = static_cast<int32_t>((i ? q[i - 1].angular_velocity[c] : 0) + v);
+        }
+    }
+    uint64_t flags = 0;
+    for (uint32_t PoseTraceRecord::*field : { &PoseTraceRecord::status_flags, &PoseTraceRecord::session_flags, &PoseTraceRecord::pose_flags }) {
+        for (size_t i = 0; i < count; ++i) {
+            if (!pose_archive_get_varint(p, end, flags)) return false;
+            out[i].*field = static_cast<uint32_t>(flags);
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        double sum = 0.0;
+        for (int k = 0, c = 0; k < 4; ++k) {
+            if (k == q[i].largest) continue;
+            const double component = q[i].orientation[c++] / POSE_ARCHIVE_QUAT_SCALE;
+            out[i].orientation[k] = static_cast<float>(component);
+            sum += component * component;
+        }
+        out[i].orientation[q[i].largest] = static_cast<float>(std::sqrt(sum < 1.0 ? 1.0 - sum : 0.0));
+        for (int k = 0; k < 3; ++k) {
+            out[i].position[k] = static_cast<float>(q[i].position[k] / POSE_ARCHIVE_POSITION_SCALE);
+            out[i].angular_velocity[k] = static_cast<float>(q[i].angular_velocity[k] / POSE_ARCHIVE_VELOCITY_SCALE);
+        }
+    }
+    return p == end;
+}
+
+// Writes an archive one record at a time, a block per block_records (at most
+// POSE_ARCHIVE_MAX_BLOCK_RECORDS)
+class PoseArchiveWriter {
+public:
+    bool open(const std::string& path, int64_t start_unix_s, int64_t start_us,
+              uint32_t block_records = POSE_ARCHIVE_BLOCK_RECORDS) {
+        file_.open(path, std::ios::binary | std::ios::trunc);
+        if (!file_ || !block_records || block_records > POSE_ARCHIVE_MAX_BLOCK_RECORDS) return false;
+        std::memset(&header_, 0, sizeof(header_));
+        header_.magic = POSE_ARCHIVE_MAGIC;
+        header_.version = POSE_ARCHIVE_VERSION;
+        header_.block_records = block_records;
+        header_.start_unix_s = start_unix_s;
+        header_.start_us = start_us;
+        file_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+        pending_.reserve(block_records);
+        return static_cast<bool>(file_);
+    }
+
+    void add(const PoseTraceRecord& record) {
+        pending_.push_back(record);
+        if (pending_.size() == header_.block_records) write_block();
+    }
+
+    // Any time before finish(); written after the index
+    void add_markers(const PoseTraceMarker* markers, size_t count) { markers_.insert(markers_.end(), markers, markers + count); }
+
+    // Writes the last block, the index, the markers and the final header; false on any write error
+    bool finish() {
+        if (!file_.is_open()) return false;
+        write_block();
+        header_.index_offset = static_cast<uint64_t>(file_.tellp());
+        file_.write(reinterpret_cast<const char*>(index_.data()), static_cast<std::streamsize>(index_.size() * sizeof(PoseArchiveIndexEntry)));
+        header_.marker_offset = static_cast<uint64_t>(file_.tellp());
+        header_.marker_count = markers_.size();
+        file_.write(reinterpret_cast<const char*>(markers_.data()), static_cast<std::streamsize>(markers_.size() * sizeof(PoseTraceMarker)));
+        bytes_ = static_cast<uint64_t>(file_.tellp());
+        file_.seekp(0);
+        file_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+        file_.close();
+        return !file_.fail();
+    }
+
+    uint64_t bytes() const { return bytes_; }
+    uint64_t records() const { return header_.record_count; }
+
+private:
+    void write_block() {
+        if (pending_.empty()) return;
+        raw_.clear();
+        pose_archive_encode_block(pending_.data(), pending_.size(), raw_);
+        compressed_.resize(pose_archive_lz_bound(raw_.size()));
+        PoseArchiveBlock block = {};
+        block.compressed_size = static_cast<uint32_t>(pose_archive_lz_compress(raw_.data(), raw_.size(), compressed_.data()));
+        block.raw_size = static_cast<uint32_t>(raw_.size());
+        block.record_count = static_cast<uint32_t>(pending_.size());
+        block.first_t_us = pending_.front().t_us;
+        index_.push_back({ static_cast<uint64_t>(file_.tellp()), block.first_t_us, header_.record_count });
+        file_.write(reinterpret_cast<const char*>(&block), sizeof(block));
+        file_.write(reinterpret_cast<const char*>(compressed_.data()), block.compressed_size);
+        header_.record_count += pending_.size();
+        ++header_.block_count;
+        pending_.clear();
+    }
+
+    std::ofstream file_;
+    PoseArchiveHeader header_ = {};
+    std::vector<PoseTraceRecord> pending_;
+    std::vector<uint8_t> raw_, compressed_;
+    std::vector<PoseArchiveIndexEntry> index_;
+    std::vector<PoseTraceMarker> markers_;
+    uint64_t bytes_ = 0;
+};
+
+// A whole file mapped read-only, so seeking in a trace is pointer arithmetic and only
+// the pages touched are read from disk
+class PoseTraceMapping {
+public:
+    PoseTraceMapping() = default;
+    ~PoseTraceMapping() { close(); }
+    PoseTraceMapping(const PoseTraceMapping&) = delete;
+    PoseTraceMapping& operator=(const PoseTraceMapping&) = delete;
+
+    bool open(const std::string& path) {
+        close();
+#ifdef _WIN32
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        LARGE_INTEGER size;
+        if (file_ == INVALID_HANDLE_VALUE || !GetFileSizeEx(file_, &size) || size.QuadPart == 0) return false;
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping_) return false;
+        data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        size_ = static_cast<size_t>(size.QuadPart);
+#else
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd_ < 0 || fstat(fd_, &st) != 0 || st.st_size == 0) return false;
+        void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd_, 0);
+        if (view == MAP_FAILED) return false;
+        data_ = static_cast<const uint8_t*>(view);
+        size_ = static_cast<size_t>(st.st_size);
+#endif
+        return data_ != nullptr;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (data_) UnmapViewOfFile(data_);
+        if (mapping_) CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+        mapping_ = nullptr;
+        file_ = INVALID_HANDLE_VALUE;
+#else
+        if (data_) munmap(const_cast<uint8_t*>(data_), size_);
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Reads an archive block by block, or from the block holding a given time, straight
+// out of a mapping of the file
+class PoseArchiveReader {
+public:
+    // False if it isn't a finished archive of a known version
+    bool open(const std::string& path) {
+        if (!map_.open(path) || map_.size() < sizeof(header_)) return false;
+        std::memcpy(&header_, map_.data(), sizeof(header_));
+        if (header_.magic != POSE_ARCHIVE_MAGIC || header_.version != POSE_ARCHIVE_VERSION || !header_.index_offset) return false;
+        // Every size below comes from the file: compared by subtraction, so none can wrap
+        const uint64_t size = map_.size();
+        if (header_.index_offset < sizeof(header_) || header_.index_offset > size ||
+            header_.block_count > (size - header_.index_offset) / sizeof(PoseArchiveIndexEntry) ||
+            !header_.block_records || header_.block_records > POSE_ARCHIVE_MAX_BLOCK_RECORDS ||
+            header_.record_count > uint64_t(header_.block_count) * header_.block_records) {
+            return false;
+        }
+        const uint64_t index_bytes = static_cast<uint64_t>(header_.block_count) * sizeof(PoseArchiveIndexEntry);
+        index_.resize(header_.block_count);
+        std::memcpy(index_.data(), map_.data() + header_.index_offset, static_cast<size_t>(index_bytes));
+        const uint64_t marker_bytes = header_.marker_count * sizeof(PoseTraceMarker);
+        if (header_.marker_count && header_.marker_offset <= size &&
+            header_.marker_count <= (size - header_.marker_offset) / sizeof(PoseTraceMarker)) {
+            markers_.resize(static_cast<size_t>(header_.marker_count));
+            std::memcpy(markers_.data(), map_.data() + header_.marker_offset, static_cast<size_t>(marker_bytes));
+        }
+        return true;
+    }
+
+    const PoseArchiveHeader& header() const { return header_; }
+    const std::vector<PoseArchiveIndexEntry>& index() const { return index_; }
+    const std::vector<PoseTraceMarker>& markers() const { return markers_; }
+
+    // The block holding t_us: the last one starting at or before it (0 for earlier times)
+    size_t find_block(int64_t t_us) const {
+        size_t lo = 0, hi = index_.size();
+        while (hi - lo > 1) {
+            size_t mid = (lo + hi) / 2;
+            if (index_[mid].first_t_us <= t_us) lo = mid; else hi = mid;
+        }
+        return lo;
+    }
+
+    bool read_block(size_t block_index, std::vector<PoseTraceRecord>& out) {
+        if (block_index >= index_.size()) return false;
+        // Blocks lie between the header and the index
+        const uint64_t offset = index_[block_index].offset;
+        const uint64_t blocks_end = header_.index_offset;
+        PoseArchiveBlock block;
+        if (offset < sizeof(header_) || offset > blocks_end || blocks_end - offset < sizeof(block)) return false;
+        std::memcpy(&block, map_.data() + offset, sizeof(block));
+        if (block.compressed_size > blocks_end - offset - sizeof(block)) return false;
+        // Sized from the file too: no more records than a block holds, nor more columns than they take
+        if (!block.record_count || block.record_count > header_.block_records ||
+            block.raw_size > block.record_count * POSE_ARCHIVE_MAX_RECORD_BYTES) {
+            return false;
+        }
+        raw_.resize(block.raw_size);
+        if (!pose_archive_lz_decompress(map_.data() + offset + sizeof(block), block.compressed_size, raw_.data(), raw_.size())) return false;
+        out.resize(block.record_count);
+        return pose_archive_decode_block(raw_.data(), raw_.size(), out.size(), block.first_t_us, out.data());
+    }
+
+private:
+    PoseTraceMapping map_;
+    PoseArchiveHeader header_ = {};
+    std::vector<PoseArchiveIndexEntry> index_;
+    std::vector<PoseTraceMarker> markers_;
+    std::vector<uint8_t> raw_;
+};
+
+// A window of either trace format without reading the rest: raw traces are binary
+// searched in place on t_us, archives through their block index, O(log n) both ways
+class PoseTraceSeeker {
+public:
+    bool open(const std::string& path) {
+        uint32_t magic = 0;
+        {
+            std::ifstream f(path, std::ios::binary);
+            if (!f.read(reinterpret_cast<char*>(&magic), sizeof(magic))) return false;
+        }
+        if (magic == POSE_ARCHIVE_MAGIC) {
+            archived_ = true;
+            return archive_.open(path);
+        }
+        PoseTraceHeader header;
+        if (magic != POSE_TRACE_MAGIC || !map_.open(path) || map_.size() < sizeof(header)) return false;
+        std::memcpy(&header, map_.data(), sizeof(header));
+        if (header.version != POSE_TRACE_VERSION || header.record_size != sizeof(PoseTraceRecord)) return false;
+        records_ = reinterpret_cast<const PoseTraceRecord*>(map_.data() + sizeof(header));
+        const size_t capacity = (map_.size() - sizeof(header)) / sizeof(PoseTraceRecord);
+        if (header.record_count) {
+            count_ = static_cast<size_t>((std::min<uint64_t>)(header.record_count, capacity));
+            const uint64_t marker_bytes = header.marker_count * sizeof(PoseTraceMarker);
+            const size_t markers_at = sizeof(header) + count_ * sizeof(PoseTraceRecord); // Within the mapping
+            if (header.marker_count && header.marker_count <= (map_.size() - markers_at) / sizeof(PoseTraceMarker)) {
+                markers_.resize(static_cast<size_t>(header.marker_count));
+                std::memcpy(markers_.data(), map_.data() + markers_at, static_cast<size_t>(marker_bytes));
+            }
+        } else {
+            // Never closed: the records end at the first empty one after the first
+            size_t lo = 1, hi = capacity;
+            while (lo < hi) {
+                const size_t mid = lo + (hi - lo) / 2;
+                if (records_[mid].t_us == 0) hi = mid; else lo = mid + 1;
+            }
+            count_ = capacity ? lo : 0;
+        }
+        return true;
+    }
+
+    const std::vector<PoseTraceMarker>& markers() const { return archived_ ? archive_.markers() : markers_; }
+
+    int64_t first_t_us() const {
+        if (archived_) return archive_.index().empty() ? 0 : archive_.index().front().first_t_us;
+        return count_ ? records_[0].t_us : 0;
+    }
+
+    // The records with from_us <= t_us < to_us
+    bool read_window(int64_t from_us, int64_t to_us, std::vector<PoseTraceRecord>& out) {
+        out.clear();
+        if (!archived_) {
+            const PoseTraceRecord* end = records_ + count_;
+            const auto by_time = [](const PoseTraceRecord& r, int64_t t) { return r.t_us < t; };
+            const PoseTraceRecord* first = std::lower_bound(records_, end, from_us, by_time);
+            out.assign(first, std::lower_bound(first, end, to_us, by_time));
+            return true;
+        }
+        std::vector<PoseTraceRecord> block;
+        for (size_t b = archive_.find_block(from_us); b < archive_.index().size() && archive_.index()[b].first_t_us < to_us; ++b) {
+            if (!archive_.read_block(b, block)) return false;
+            for (const PoseTraceRecord& r : block) {
+                if (r.t_us >= from_us && r.t_us < to_us) out.push_back(r);
+            }
+        }
+        return true;
+    }
+
+private:
+    bool archived_ = false;
+    PoseArchiveReader archive_;
+    PoseTraceMapping map_;
+    const PoseTraceRecord* records_ = nullptr;
+    size_t count_ = 0;
+    std::vector<PoseTraceMarker> markers_;
+};
@@ -11,6 +11,26 @@ import os
 import winreg
 import sys
 
+SETTINGS_PIPE = r'\\.\pipe\QuestLookout.settings'
+
+def push_to_monitor(settings):
+    """Send settings to a running Quest Lookout so they apply immediately.
+    Returns None when Quest Lookout isn't running, otherwise its reply:
+    {'ok': True} or {'ok': False, 'errors': [...]}"""
+    try:
+        with open(SETTINGS_PIPE, 'r+b', buffering=0) as pipe:
+            pipe.write(json.dumps(settings).encode('utf-8'))
+            return json.loads(pipe.read(65536).decode('utf-8'))
+    except FileNotFoundError:
+        return None
+    except Exception as e:
+        print(f"[WARNING] Could not push settings to Quest Lookout: {e}")
+        return None
+
+def show_push_errors(reply):
+    messagebox.showerror("Settings Rejected",
+                         "Quest Lookout rejected these settings:\n\n" + "\n".join(reply.get('errors', [])))
+
 class ToolTip:
     """Simple tooltip implementation for tkinter widgets"""
     def __init__(self, widget, text='widget info'):
@@ -613,10 +633,18 @@ class QuestLookoutGUI:
             self.settings['center_reset']['hold_time_seconds'] = float(self.reset_hold_var.get())
             self.settings['recenter_hotkey'] = self.recenter_hotkey_var.get()
             
+            reply = push_to_monitor(self.settings)
+            if reply is not None and not reply.get('ok'):
+                show_push_errors(reply)
+                return
+            
             with open('settings.json', 'w') as f:
                 json.dump(self.settings, f, indent=2)
             
-            messagebox.showinfo("Success", "Settings saved to settings.json!\n\nRestart Quest Lookout to apply changes.")
+            if reply is not None:
+                messagebox.showinfo("Success", "Settings saved to settings.json and applied to the running Quest Lookout.")
+            else:
+                messagebox.showinfo("Success", "Settings saved to settings.json!\n\nThey apply the next time Quest Lookout starts.")
         except Exception as e:
             messagebox.showerror("Error", f"Failed to save settings:\n{e}")
     
@@ -655,6 +683,11 @@ class QuestLookoutGUI:
             self.settings['center_reset']['hold_time_seconds'] = float(self.reset_hold_var.get())
             self.settings['recenter_hotkey'] = self.recenter_hotkey_var.get()
             
+            reply = push_to_monitor(self.settings)
+            if reply is not None and not reply.get('ok'):
+                show_push_errors(reply)
+                return
+            
             with open('settings.json', 'w') as f:
                 json.dump(self.settings, f, indent=2)
             